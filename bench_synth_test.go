@@ -0,0 +1,350 @@
+package canopy
+
+import (
+	"context"
+	"flag"
+	"fmt"
+	"io"
+	"os"
+	"path/filepath"
+	"strconv"
+	"strings"
+	"sync"
+	"testing"
+)
+
+// The BenchmarkSynth* benchmarks index generated repositories (see
+// synthRepo) of every language at the sizes given by -synth.files, so
+// throughput can be tracked at scale:
+//
+//	go test -run '^$' -bench Synth -synth.files 10000,100000 -count 10 > new.txt
+//	benchstat old.txt new.txt
+//
+// Sub-benchmarks are named lang=<language>/files=<count>[/...], and report
+// files/s where it applies. Each repository and its indexed databases are
+// generated once per process and shared by the benchmarks that need them.
+var (
+	synthFilesFlag = flag.String("synth.files", "1000", "comma-separated file counts of the synthetic repos BenchmarkSynth* index")
+	synthLangsFlag = flag.String("synth.langs", strings.Join(synthLanguages, ","), "comma-separated languages BenchmarkSynth* cover")
+)
+
+// synthCache holds the repositories and template databases generated by
+// the benchmarks, under one temp dir removed by TestMain.
+var synthCache struct {
+	sync.Mutex
+	root  string
+	repos map[string]*synthRepo
+	dbs   map[string]string
+}
+
+func TestMain(m *testing.M) {
+	code := m.Run()
+	if synthCache.root != "" {
+		os.RemoveAll(synthCache.root)
+	}
+	os.Exit(code)
+}
+
+// synthCases runs fn as a sub-benchmark of b for every language and size
+// selected by the flags.
+func synthCases(b *testing.B, fn func(b *testing.B, lang string, files int)) {
+	for _, lang := range strings.Split(*synthLangsFlag, ",") {
+		for _, s := range strings.Split(*synthFilesFlag, ",") {
+			files, err := strconv.Atoi(strings.TrimSpace(s))
+			if err != nil || files <= 0 {
+				b.Fatalf("-synth.files: bad count %q", s)
+			}
+			b.Run(fmt.Sprintf("lang=%s/files=%d", lang, files), func(b *testing.B) {
+				fn(b, strings.TrimSpace(lang), files)
+			})
+		}
+	}
+}
+
+// synthRepoFor returns the shared repository of lang with about files
+// files, generating it on first use.
+func synthRepoFor(b *testing.B, lang string, files int) *synthRepo {
+	b.Helper()
+	synthCache.Lock()
+	defer synthCache.Unlock()
+	if synthCache.root == "" {
+		root, err := os.MkdirTemp("", "canopy-synth-")
+		if err != nil {
+			b.Fatal(err)
+		}
+		synthCache.root = root
+		synthCache.repos = make(map[string]*synthRepo)
+		synthCache.dbs = make(map[string]string)
+	}
+	key := fmt.Sprintf("%s-%d", lang, files)
+	if r := synthCache.repos[key]; r != nil {
+		return r
+	}
+	r, err := newSynthRepo(filepath.Join(synthCache.root, key), lang, files)
+	if err != nil {
+		b.Fatal(err)
+	}
+	synthCache.repos[key] = r
+	return r
+}
+
+// newSynthEngine opens an Engine for r's language on dbPath.
+func newSynthEngine(b *testing.B, r *synthRepo, dbPath string, opts ...Option) *Engine {
+	b.Helper()
+	scriptsDir := filepath.Join(findModuleRootB(b), "scripts")
+	e, err := New(dbPath, scriptsDir, append([]Option{WithLanguages(r.lang)}, opts...)...)
+	if err != nil {
+		b.Fatal(err)
+	}
+	return e
+}
+
+// synthDB returns the path of a fresh copy of a database holding r
+// indexed, and resolved if resolved is set. The template it is copied
+// from is built on first use.
+func synthDB(b *testing.B, r *synthRepo, resolved bool) string {
+	b.Helper()
+	key := filepath.Base(r.dir) + "-indexed.db"
+	if resolved {
+		key = filepath.Base(r.dir) + "-resolved.db"
+	}
+	synthCache.Lock()
+	template := synthCache.dbs[key]
+	synthCache.Unlock()
+
+	if template == "" {
+		template = filepath.Join(synthCache.root, key)
+		ctx := context.Background()
+		e := newSynthEngine(b, r, template)
+		if err := e.IndexDirectory(ctx, r.dir); err != nil {
+			e.Close()
+			b.Fatal(err)
+		}
+		if resolved {
+			if err := e.Resolve(ctx); err != nil {
+				e.Close()
+				b.Fatal(err)
+			}
+		}
+		if err := e.Close(); err != nil {
+			b.Fatal(err)
+		}
+		synthCache.Lock()
+		synthCache.dbs[key] = template
+		synthCache.Unlock()
+	}
+
+	dbPath := filepath.Join(b.TempDir(), "bench.db")
+	for _, suffix := range []string{"", "-wal", "-shm"} {
+		if err := copyFile(template+suffix, dbPath+suffix); err != nil && !os.IsNotExist(err) {
+			b.Fatal(err)
+		}
+	}
+	return dbPath
+}
+
+func copyFile(from, to string) error {
+	in, err := os.Open(from)
+	if err != nil {
+		return err
+	}
+	defer in.Close()
+	out, err := os.Create(to)
+	if err != nil {
+		return err
+	}
+	if _, err := io.Copy(out, in); err != nil {
+		out.Close()
+		return err
+	}
+	return out.Close()
+}
+
+func reportFilesPerSec(b *testing.B, files int) {
+	b.ReportMetric(float64(b.N*files)/b.Elapsed().Seconds(), "files/s")
+}
+
+// BenchmarkSynthColdIndex measures extracting a whole repository into a new
+// database.
+func BenchmarkSynthColdIndex(b *testing.B) {
+	synthCases(b, func(b *testing.B, lang string, files int) {
+		r := synthRepoFor(b, lang, files)
+		ctx := context.Background()
+		b.ResetTimer()
+		for i := 0; i < b.N; i++ {
+			b.StopTimer()
+			e := newSynthEngine(b, r, filepath.Join(b.TempDir(), "bench.db"))
+			b.StartTimer()
+
+			if err := e.IndexDirectory(ctx, r.dir); err != nil {
+				e.Close()
+				b.Fatal(err)
+			}
+
+			b.StopTimer()
+			e.Close()
+			b.StartTimer()
+		}
+		reportFilesPerSec(b, r.files())
+	})
+}
+
+// BenchmarkSynthResolve measures resolving a freshly indexed repository.
+func BenchmarkSynthResolve(b *testing.B) {
+	synthCases(b, func(b *testing.B, lang string, files int) {
+		r := synthRepoFor(b, lang, files)
+		ctx := context.Background()
+		b.ResetTimer()
+		for i := 0; i < b.N; i++ {
+			b.StopTimer()
+			e := newSynthEngine(b, r, synthDB(b, r, false))
+			b.StartTimer()
+
+			if err := e.Resolve(ctx); err != nil {
+				e.Close()
+				b.Fatal(err)
+			}
+
+			b.StopTimer()
+			e.Close()
+			b.StartTimer()
+		}
+		reportFilesPerSec(b, r.files())
+	})
+}
+
+// BenchmarkSynthNoopIndex measures re-indexing and resolving a repository
+// in which nothing changed.
+func BenchmarkSynthNoopIndex(b *testing.B) {
+	synthCases(b, func(b *testing.B, lang string, files int) {
+		r := synthRepoFor(b, lang, files)
+		e := newSynthEngine(b, r, synthDB(b, r, true))
+		defer e.Close()
+		ctx := context.Background()
+		b.ResetTimer()
+		for i := 0; i < b.N; i++ {
+			if err := e.IndexDirectory(ctx, r.dir); err != nil {
+				b.Fatal(err)
+			}
+			if err := e.Resolve(ctx); err != nil {
+				b.Fatal(err)
+			}
+		}
+		reportFilesPerSec(b, r.files())
+	})
+}
+
+// BenchmarkSynthIncremental measures re-indexing and resolving a repository
+// after editing the source files of 1 or 100 units, alternately adding and
+// removing a function at their end.
+func BenchmarkSynthIncremental(b *testing.B) {
+	synthCases(b, func(b *testing.B, lang string, files int) {
+		for _, changed := range []int{1, 100} {
+			b.Run(fmt.Sprintf("changed=%d", changed), func(b *testing.B) {
+				r := synthRepoFor(b, lang, files)
+				k := min(changed, r.units)
+				e := newSynthEngine(b, r, synthDB(b, r, true))
+				defer e.Close()
+				b.Cleanup(func() {
+					if _, err := r.touch(k, false); err != nil {
+						b.Error(err)
+					}
+				})
+				ctx := context.Background()
+				b.ResetTimer()
+				for i := 0; i < b.N; i++ {
+					b.StopTimer()
+					if _, err := r.touch(k, i%2 == 0); err != nil {
+						b.Fatal(err)
+					}
+					b.StartTimer()
+
+					if err := e.IndexDirectory(ctx, r.dir); err != nil {
+						b.Fatal(err)
+					}
+					if err := e.Resolve(ctx); err != nil {
+						b.Fatal(err)
+					}
+				}
+			})
+		}
+	})
+}
+
+// BenchmarkSynthBranchSwitch measures re-indexing and resolving a
+// repository after switching between it and a branch that changes a tenth
+// of its units, headers included, and adds and deletes a fiftieth.
+func BenchmarkSynthBranchSwitch(b *testing.B) {
+	synthCases(b, func(b *testing.B, lang string, files int) {
+		r := synthRepoFor(b, lang, files)
+		e := newSynthEngine(b, r, synthDB(b, r, true))
+		defer e.Close()
+		b.Cleanup(func() {
+			if err := r.checkout(false); err != nil {
+				b.Error(err)
+			}
+		})
+		ctx := context.Background()
+		b.ResetTimer()
+		for i := 0; i < b.N; i++ {
+			b.StopTimer()
+			if err := r.checkout(i%2 == 0); err != nil {
+				b.Fatal(err)
+			}
+			b.StartTimer()
+
+			if err := e.IndexDirectory(ctx, r.dir); err != nil {
+				b.Fatal(err)
+			}
+			if err := e.Resolve(ctx); err != nil {
+				b.Fatal(err)
+			}
+		}
+	})
+}
+
+// BenchmarkSynthQuery measures the hot queries on a resolved repository,
+// around the call from its middle unit's successor into it.
+func BenchmarkSynthQuery(b *testing.B) {
+	synthCases(b, func(b *testing.B, lang string, files int) {
+		r := synthRepoFor(b, lang, files)
+		e := newSynthEngine(b, r, synthDB(b, r, true))
+		defer e.Close()
+		q := e.Query()
+
+		path, line, col, target := r.callSite(r.units/2 + 1)
+		found, err := q.SearchSymbols(target, SymbolFilter{}, Sort{}, Pagination{})
+		if err != nil {
+			b.Fatal(err)
+		}
+		if len(found.Items) == 0 {
+			b.Fatalf("symbol %s not indexed", target)
+		}
+		symbolID := found.Items[0].ID
+
+		queries := []struct {
+			name string
+			run  func() error
+		}{
+			{"SymbolAt", func() error { _, err := q.SymbolAt(path, line, col); return err }},
+			{"DefinitionAt", func() error { _, err := q.DefinitionAt(path, line, col); return err }},
+			{"ReferencesTo", func() error { _, err := q.ReferencesTo(symbolID); return err }},
+			{"TransitiveCallers", func() error { _, err := q.TransitiveCallers(symbolID, 5); return err }},
+			{"Hotspots", func() error { _, err := q.Hotspots(10); return err }},
+			{"SearchSymbols", func() error {
+				_, err := q.SearchSymbols("f1*_0", SymbolFilter{}, Sort{}, Pagination{})
+				return err
+			}},
+		}
+		for _, qc := range queries {
+			b.Run("query="+qc.name, func(b *testing.B) {
+				b.ReportAllocs()
+				for i := 0; i < b.N; i++ {
+					if err := qc.run(); err != nil {
+						b.Fatal(err)
+					}
+				}
+			})
+		}
+	})
+}
@@ -2,9 +2,13 @@ package canopy
 
 import (
 	"context"
+	"fmt"
 	"os"
 	"path/filepath"
 	"testing"
+	"time"
+
+	"github.com/jward/canopy/internal/store"
 )
 
 // findModuleRootB is the benchmark equivalent of findModuleRoot.
@@ -186,6 +190,40 @@ func BenchmarkIndexFiles_Go(b *testing.B) {
 	}
 }
 
+// BenchmarkIndexDirectory_Cpp measures an end-to-end index and resolve of
+// the C++ test corpus into a fresh database, the path where parallel
+// extraction reads, the committer and the resolution writers share the
+// store's connections.
+func BenchmarkIndexDirectory_Cpp(b *testing.B) {
+	ctx := context.Background()
+	modRoot := findModuleRootB(b)
+	scriptsDir := filepath.Join(modRoot, "scripts")
+	corpus := filepath.Join(modRoot, "testdata", "cpp")
+
+	b.ResetTimer()
+	for i := 0; i < b.N; i++ {
+		b.StopTimer()
+		e, err := New(filepath.Join(b.TempDir(), "bench.db"), scriptsDir, WithLanguages("cpp"))
+		if err != nil {
+			b.Fatal(err)
+		}
+		b.StartTimer()
+
+		if err := e.IndexDirectory(ctx, corpus); err != nil {
+			e.Close()
+			b.Fatal(err)
+		}
+		if err := e.Resolve(ctx); err != nil {
+			e.Close()
+			b.Fatal(err)
+		}
+
+		b.StopTimer()
+		e.Close()
+		b.StartTimer()
+	}
+}
+
 // BenchmarkResolve_Go measures the time to resolve cross-file references
 // after extraction, using a pre-indexed Go source file.
 func BenchmarkResolve_Go(b *testing.B) {
@@ -240,3 +278,99 @@ func BenchmarkQueryDefinitionAt(b *testing.B) {
 		}
 	}
 }
+
+// benchCommitRows is the row count per committed batch, roughly the number
+// of references in a 5k-line C++ translation unit.
+const benchCommitRows = 5000
+
+// setupBenchStore opens a migrated Store in a temp dir.
+func setupBenchStore(b *testing.B) *store.Store {
+	b.Helper()
+	s, err := store.NewStore(filepath.Join(b.TempDir(), "bench.db"))
+	if err != nil {
+		b.Fatal(err)
+	}
+	if err := s.Migrate(); err != nil {
+		s.Close()
+		b.Fatal(err)
+	}
+	return s
+}
+
+// benchCommit runs CommitBatch over batches built by fill, one fresh file per
+// iteration, and reports committed rows/sec.
+func benchCommit(b *testing.B, fill func(batch *store.BatchedStore, fileID int64)) {
+	s := setupBenchStore(b)
+	defer s.Close()
+
+	var elapsed time.Duration
+	for i := 0; i < b.N; i++ {
+		b.StopTimer()
+		fileID, err := s.InsertFile(&store.File{
+			Path:        fmt.Sprintf("/bench/f%d.cpp", i),
+			Language:    "cpp",
+			LastIndexed: time.Now(),
+		})
+		if err != nil {
+			b.Fatal(err)
+		}
+		batch := store.NewBatchedStore(s)
+		fill(batch, fileID)
+		b.StartTimer()
+
+		start := time.Now()
+		if err := s.CommitBatch(batch); err != nil {
+			b.Fatal(err)
+		}
+		elapsed += time.Since(start)
+	}
+	b.ReportMetric(float64(b.N*benchCommitRows)/elapsed.Seconds(), "rows/s")
+}
+
+// BenchmarkCommitBatch_References measures references_ insert throughput.
+func BenchmarkCommitBatch_References(b *testing.B) {
+	benchCommit(b, func(batch *store.BatchedStore, fileID int64) {
+		scopeID, _ := batch.InsertScope(&store.Scope{FileID: fileID, Kind: "file"})
+		for j := 0; j < benchCommitRows; j++ {
+			batch.InsertReference(&store.Reference{
+				FileID: fileID, ScopeID: &scopeID, Name: "ref",
+				StartLine: j, StartCol: 4, EndLine: j, EndCol: 7, Context: "call",
+			})
+		}
+	})
+}
+
+// BenchmarkCommitBatch_Scopes measures scopes insert throughput, including
+// intra-batch parent_scope_id remapping.
+func BenchmarkCommitBatch_Scopes(b *testing.B) {
+	benchCommit(b, func(batch *store.BatchedStore, fileID int64) {
+		parentID, _ := batch.InsertScope(&store.Scope{FileID: fileID, Kind: "file"})
+		for j := 1; j < benchCommitRows; j++ {
+			batch.InsertScope(&store.Scope{
+				FileID: fileID, Kind: "block", ParentScopeID: &parentID,
+				StartLine: j, EndLine: j + 1,
+			})
+		}
+	})
+}
+
+// BenchmarkBatchedStore_InsertReferences measures buffering references in a
+// worker's batch, before any commit, and its allocations per row.
+func BenchmarkBatchedStore_InsertReferences(b *testing.B) {
+	s := setupBenchStore(b)
+	defer s.Close()
+
+	names := []string{"fmt", "Println", "err", "ctx", "s"}
+	b.ReportAllocs()
+	for i := 0; i < b.N; i++ {
+		batch := store.NewBatchedStore(s)
+		batch.Reserve(benchCommitRows)
+		scopeID, _ := batch.InsertScope(&store.Scope{FileID: 1, Kind: "file"})
+		for j := 0; j < benchCommitRows; j++ {
+			batch.InsertReference(&store.Reference{
+				FileID: 1, ScopeID: &scopeID, Name: names[j%len(names)],
+				StartLine: j, StartCol: 4, EndLine: j, EndCol: 7, Context: "call",
+			})
+		}
+	}
+}
@@ -0,0 +1,139 @@
+package main
+
+import (
+	"fmt"
+	"os"
+	"os/exec"
+	"path/filepath"
+	"strings"
+
+	"github.com/jward/canopy"
+	"github.com/jward/canopy/scripts"
+	"github.com/spf13/cobra"
+)
+
+var flagSnapshotOut string
+
+var exportCmd = &cobra.Command{
+	Use:   "export [path]",
+	Short: "Write a portable snapshot of the index",
+	Long: `Writes a compressed, versioned snapshot of the database of the repository at
+path: a compacted copy of the database plus a manifest recording the indexed
+commit, the scripts hash and the repository root. 'canopy import' restores it
+elsewhere, so a checkout only indexes what differs from the snapshot's commit.`,
+	Args: cobra.MaximumNArgs(1),
+	RunE: runExport,
+}
+
+var importCmd = &cobra.Command{
+	Use:   "import <snapshot> [path]",
+	Short: "Restore an index snapshot, then index what changed since",
+	Long: `Replaces the database of the repository at path with the snapshot written by
+'canopy export', moving its paths from the exporting repository's root to this
+one, then indexes the working tree incrementally: only files whose content
+differs from the snapshot's are extracted again. A snapshot built with other
+scripts is rebuilt from scratch, as 'canopy index' would.`,
+	Args: cobra.RangeArgs(1, 2),
+	RunE: runImport,
+}
+
+func init() {
+	exportCmd.Flags().StringVarP(&flagSnapshotOut, "output", "o", "", "snapshot file to write (default: canopy-<commit>.snapshot)")
+	rootCmd.AddCommand(exportCmd)
+	rootCmd.AddCommand(importCmd)
+}
+
+func runExport(cmd *cobra.Command, args []string) error {
+	targetDir, err := resolveTargetDir(args)
+	if err != nil {
+		return err
+	}
+	repoRoot := findRepoRoot(targetDir)
+	dbPath := resolveDBPath(repoRoot)
+	if _, err := os.Stat(dbPath); os.IsNotExist(err) {
+		return fmt.Errorf("database not found: %s (run 'canopy index' first)", dbPath)
+	}
+
+	engine, err := canopy.New(dbPath, "", canopy.WithScriptsFS(scripts.FS))
+	if err != nil {
+		return fmt.Errorf("opening database: %w", err)
+	}
+	defer engine.Close()
+
+	commit := gitHead(repoRoot)
+	out := flagSnapshotOut
+	if out == "" {
+		out = "canopy.snapshot"
+		if commit != "" {
+			out = fmt.Sprintf("canopy-%.12s.snapshot", commit)
+		}
+	}
+	tmp := out + ".tmp"
+	f, err := os.Create(tmp)
+	if err != nil {
+		return fmt.Errorf("creating %s: %w", tmp, err)
+	}
+	m, err := engine.ExportSnapshot(f, repoRoot, commit)
+	if cerr := f.Close(); err == nil {
+		err = cerr
+	}
+	if err == nil {
+		err = os.Rename(tmp, out)
+	}
+	if err != nil {
+		os.Remove(tmp)
+		return err
+	}
+
+	info, err := os.Stat(out)
+	if err != nil {
+		return err
+	}
+	fmt.Fprintf(os.Stderr, "Exported %s (commit %s) to %s (%d KiB)\n",
+		m.Root, orUnknown(m.Commit), out, info.Size()>>10)
+	return nil
+}
+
+func runImport(cmd *cobra.Command, args []string) error {
+	snapshot := args[0]
+	targetDir, err := resolveTargetDir(args[1:])
+	if err != nil {
+		return err
+	}
+	repoRoot := findRepoRoot(targetDir)
+	dbPath := resolveDBPath(repoRoot)
+	if err := os.MkdirAll(filepath.Dir(dbPath), 0o755); err != nil {
+		return fmt.Errorf("creating %s: %w", filepath.Dir(dbPath), err)
+	}
+
+	f, err := os.Open(snapshot)
+	if err != nil {
+		return fmt.Errorf("opening snapshot: %w", err)
+	}
+	m, err := canopy.ImportSnapshot(f, dbPath, repoRoot)
+	f.Close()
+	if err != nil {
+		return err
+	}
+	fmt.Fprintf(os.Stderr, "Imported snapshot of %s (commit %s) into %s\n", m.Root, orUnknown(m.Commit), dbPath)
+	if head := gitHead(repoRoot); m.Commit != "" && head != "" && head != m.Commit {
+		fmt.Fprintf(os.Stderr, "Working tree is at %.12s; indexing the differences\n", head)
+	}
+	return runIndex(cmd, args[1:])
+}
+
+// gitHead returns the commit checked out in dir, or "" outside a git repo.
+func gitHead(dir string) string {
+	out, err := exec.Command("git", "-C", dir, "rev-parse", "HEAD").Output()
+	if err != nil {
+		return ""
+	}
+	return strings.TrimSpace(string(out))
+}
+
+func orUnknown(s string) string {
+	if s == "" {
+		return "unknown"
+	}
+	return s
+}
@@ -3,7 +3,6 @@ package main
 import (
 	"fmt"
 	"io"
-	"os"
 	"sort"
 	"strings"
 	"text/tabwriter"
@@ -379,9 +378,9 @@ func formatHotspotsText(w io.Writer, hotspots []CLIHotspot) {
 }
 
 // outputResultText dispatches to the appropriate text formatter based on the
-// result type. It writes to os.Stdout.
+// result type. It writes to stdout.
 func outputResultText(result CLIResult) error {
-	w := io.Writer(os.Stdout)
+	w := stdout
 
 	switch v := result.Results.(type) {
 	case []CLILocation:
@@ -432,6 +431,9 @@ func outputResultText(result CLIResult) error {
 			fmt.Fprintf(w, "\nShowing %d of %d results\n", shown, count)
 		}
 	}
+	if result.NextCursor != "" {
+		fmt.Fprintf(w, "Next page: --cursor %s\n", result.NextCursor)
+	}
 
 	return nil
 }
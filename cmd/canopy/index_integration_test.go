@@ -181,6 +181,10 @@ func extra() int { return 42 }
 	db2 := openDB(t, dbPath)
 	assert.Equal(t, 2, fileCount(t, db2), "should have 2 files after force reindex")
 	assert.Greater(t, symbolCount(t, db2), initialSymbols, "should have more symbols with extra file")
+
+	// The rebuild was published over the old DB.
+	_, err = os.Stat(dbPath + ".build")
+	assert.True(t, os.IsNotExist(err), "build database should be renamed into place")
 }
 
 func TestIndex_LanguagesFilter(t *testing.T) {
@@ -324,3 +328,33 @@ func TestIndex_IncrementalSkip(t *testing.T) {
 	assert.Equal(t, firstFileCount, fileCount(t, db2), "file count should be the same after re-index")
 	assert.Equal(t, firstSymbolCount, symbolCount(t, db2), "symbol count should be the same after re-index")
 }
+
+func TestIndex_CompactReferencesPersists(t *testing.T) {
+	if testing.Short() {
+		t.Skip("skipping integration test")
+	}
+	bin := buildBinary(t)
+	fixture := createGoFixture(t)
+	dbPath := filepath.Join(fixture, ".canopy", "index.db")
+	index := func(args ...string) {
+		t.Helper()
+		cmd := exec.Command(bin, append(append([]string{"index"}, args...), fixture)...)
+		cmd.Dir = fixture
+		out, err := cmd.CombinedOutput()
+		require.NoError(t, err, "index failed: %s", string(out))
+	}
+	blockFiles := func() int {
+		t.Helper()
+		var n int
+		require.NoError(t, openDB(t, dbPath).QueryRow("SELECT COUNT(*) FROM reference_blocks").Scan(&n))
+		return n
+	}
+
+	index("--compact-references")
+	assert.Equal(t, 1, blockFiles())
+
+	// A later run without the flag keeps writing blocks.
+	require.NoError(t, os.WriteFile(filepath.Join(fixture, "extra.go"), []byte("package main\n\nfunc extra() string { return helper() }\n"), 0o644))
+	index()
+	assert.Equal(t, 2, blockFiles())
+}
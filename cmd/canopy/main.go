@@ -2,10 +2,14 @@ package main
 
 import (
 	"context"
+	"encoding/json"
 	"fmt"
 	"os"
+	"os/signal"
 	"path/filepath"
+	"runtime/pprof"
 	"strings"
+	"syscall"
 	"time"
 
 	"github.com/jward/canopy"
@@ -55,6 +59,21 @@ var (
 	flagLanguages  string
 	flagScriptsDir string
 	flagParallel   bool
+	flagParanoid   bool
+	flagWatch      bool
+	flagMemLimitMB int
+	flagCompactRef bool
+
+	flagFileTimeout time.Duration
+
+	flagIncludePaths    []string
+	flagCompileCommands string
+
+	flagStats      string
+	flagCPUProfile string
+
+	flagShard   string
+	flagShardBy string
 )
 
 var indexCmd = &cobra.Command{
@@ -66,14 +85,39 @@ var indexCmd = &cobra.Command{
 }
 
 func init() {
-	indexCmd.Flags().BoolVar(&flagForce, "force", false, "delete database and reindex from scratch")
+	indexCmd.Flags().BoolVar(&flagForce, "force", false, "rebuild the database from scratch")
 	indexCmd.Flags().StringVar(&flagLanguages, "languages", "", "comma-separated language filter (e.g. go,typescript)")
 	indexCmd.Flags().StringVar(&flagScriptsDir, "scripts-dir", "", "load scripts from disk path instead of embedded")
 	indexCmd.Flags().BoolVar(&flagParallel, "parallel", false, "enable parallel extraction (worker pool with batched writes)")
+	indexCmd.Flags().BoolVar(&flagParanoid, "paranoid", false, "hash every file instead of skipping files whose size/mtime/inode are unchanged")
+	indexCmd.Flags().BoolVar(&flagWatch, "watch", false, "keep running and re-index changed files as they are saved")
+	indexCmd.Flags().StringSliceVarP(&flagIncludePaths, "include", "I", nil, "C/C++ include search directory, in search order (repeatable)")
+	indexCmd.Flags().StringVar(&flagCompileCommands, "compile-commands", "", "compile_commands.json to read C/C++ include search directories from")
+	indexCmd.Flags().StringVar(&flagStats, "stats", "", "print per-phase, per-language timings to stdout: json")
+	indexCmd.Flags().StringVar(&flagCPUProfile, "cpuprofile", "", "write a CPU profile, labeled by phase and language, to this file")
+	indexCmd.Flags().IntVar(&flagMemLimitMB, "memory-limit", 0, "approximate cap, in MiB, on memory used by files in flight during parallel extraction (0 = unlimited)")
+	indexCmd.Flags().BoolVar(&flagCompactRef, "compact-references", false, "store references as compact per-file blocks; the database keeps this mode on later runs")
+	indexCmd.Flags().DurationVar(&flagFileTimeout, "file-timeout", 0, "give up on files whose extraction or resolution takes longer than this, until they change (0 = no limit)")
+	indexCmd.Flags().StringVar(&flagShard, "shard", "", "index only shard i/n (0-based) of the tree, unresolved, for 'canopy merge'")
+	indexCmd.Flags().StringVar(&flagShardBy, "shard-by", string(canopy.ShardByDir), "how --shard assigns files: dir (by top-level directory) or hash (by path)")
 }
 
 func runIndex(cmd *cobra.Command, args []string) error {
 	start := time.Now()
+	if flagStats != "" && flagStats != "json" {
+		return fmt.Errorf("invalid --stats %q: must be json", flagStats)
+	}
+	var shard *canopy.Shard
+	if flagShard != "" {
+		if flagWatch {
+			return fmt.Errorf("--shard cannot be combined with --watch")
+		}
+		s, err := canopy.ParseShard(flagShard, canopy.ShardBy(flagShardBy))
+		if err != nil {
+			return err
+		}
+		shard = &s
+	}
 
 	// Determine the target directory.
 	targetDir, err := resolveTargetDir(args)
@@ -91,14 +135,6 @@ func runIndex(cmd *cobra.Command, args []string) error {
 		return fmt.Errorf("creating %s: %w", canopyDir, err)
 	}
 
-	// Handle --force: delete the DB file entirely.
-	if flagForce {
-		if err := os.Remove(dbPath); err != nil && !os.IsNotExist(err) {
-			return fmt.Errorf("removing database for --force: %w", err)
-		}
-		fmt.Fprintf(os.Stderr, "Cleared database: %s\n", dbPath)
-	}
-
 	// Build engine options.
 	var opts []canopy.Option
 	if flagLanguages != "" {
@@ -112,6 +148,45 @@ func runIndex(cmd *cobra.Command, args []string) error {
 	if flagParallel {
 		opts = append(opts, canopy.WithParallel(true))
 	}
+	if flagParanoid {
+		opts = append(opts, canopy.WithParanoidHashing(true))
+	}
+	if flagMemLimitMB > 0 {
+		opts = append(opts, canopy.WithMemoryLimit(int64(flagMemLimitMB)<<20))
+	}
+	if flagFileTimeout > 0 {
+		opts = append(opts, canopy.WithFileTimeout(flagFileTimeout))
+	}
+	if flagCompactRef {
+		opts = append(opts, canopy.WithCompactReferences())
+	}
+	includeOpts, err := includePathOptions()
+	if err != nil {
+		return err
+	}
+	opts = append(opts, includeOpts...)
+	if shard != nil {
+		opts = append(opts, canopy.WithShard(*shard))
+	}
+	if flagStats != "" {
+		opts = append(opts, canopy.WithStats())
+	}
+	if flagCPUProfile != "" {
+		f, err := os.Create(flagCPUProfile)
+		if err != nil {
+			return fmt.Errorf("creating CPU profile: %w", err)
+		}
+		defer f.Close()
+		if err := pprof.StartCPUProfile(f); err != nil {
+			return fmt.Errorf("starting CPU profile: %w", err)
+		}
+		defer pprof.StopCPUProfile()
+		opts = append(opts, canopy.WithProfileLabels(true))
+	}
+	if flagWatch {
+		// Watch re-indexes the same hot files over and over.
+		opts = append(opts, canopy.WithIncrementalParse(0))
+	}
 
 	// Script source: --scripts-dir overrides embedded FS.
 	scriptsDir := flagScriptsDir
@@ -119,20 +194,24 @@ func runIndex(cmd *cobra.Command, args []string) error {
 		opts = append(opts, canopy.WithScriptsFS(scripts.FS))
 	}
 
+	// Handle --force: rebuild the DB from scratch as a bulk load, which
+	// replaces the old DB once indexing and resolution complete.
+	if flagForce {
+		fmt.Fprintf(os.Stderr, "Rebuilding database: %s\n", dbPath)
+		opts = append(opts, canopy.WithBulkLoad())
+	}
+
 	engine, err := canopy.New(dbPath, scriptsDir, opts...)
 	if err != nil {
 		return fmt.Errorf("creating engine: %w", err)
 	}
 
 	// Detect script changes: if the embedded scripts differ from what built
-	// the DB, wipe and rebuild from scratch (same as --force).
+	// the DB, rebuild from scratch (same as --force).
 	if !flagForce && engine.ScriptsChanged() {
 		engine.Close()
-		if err := os.Remove(dbPath); err != nil && !os.IsNotExist(err) {
-			return fmt.Errorf("removing database for script change: %w", err)
-		}
 		fmt.Fprintf(os.Stderr, "Scripts changed, rebuilding database\n")
-		engine, err = canopy.New(dbPath, scriptsDir, opts...)
+		engine, err = canopy.New(dbPath, scriptsDir, append(opts, canopy.WithBulkLoad())...)
 		if err != nil {
 			return fmt.Errorf("recreating engine: %w", err)
 		}
@@ -148,6 +227,13 @@ func runIndex(cmd *cobra.Command, args []string) error {
 	}
 	extractDuration := time.Since(extractStart)
 
+	if shard != nil {
+		fmt.Fprintf(os.Stderr, "Indexed shard %d/%d of %s in %s (unresolved; combine shards with 'canopy merge')\n",
+			shard.Index, shard.Count, targetDir, time.Since(start).Round(time.Millisecond))
+		fmt.Fprintf(os.Stderr, "Database: %s\n", dbPath)
+		return nil
+	}
+
 	// Run resolution.
 	resolveStart := time.Now()
 	if err := engine.Resolve(ctx); err != nil {
@@ -164,11 +250,66 @@ func runIndex(cmd *cobra.Command, args []string) error {
 		extractDuration.Round(time.Millisecond),
 		resolveDuration.Round(time.Millisecond),
 	)
+	if n := engine.SharedExtractions(); n > 0 {
+		fmt.Fprintf(os.Stderr, "Shared extractions: %d files with duplicate content copied instead of extracted\n", n)
+	}
+	timedOut, err := engine.TimedOutFiles()
+	if err != nil {
+		return err
+	}
+	if len(timedOut) > 0 {
+		fmt.Fprintf(os.Stderr, "Timed out: %d files skipped until they change\n", len(timedOut))
+		for _, t := range timedOut {
+			fmt.Fprintf(os.Stderr, "  %s (%s)\n", t.Path, t.Phase)
+		}
+	}
 	fmt.Fprintf(os.Stderr, "Database: %s\n", dbPath)
+	if stats := engine.Stats(); stats != nil {
+		enc := json.NewEncoder(stdout)
+		enc.SetIndent("", "  ")
+		if err := enc.Encode(stats); err != nil {
+			return fmt.Errorf("writing stats: %w", err)
+		}
+	}
 
+	if flagWatch {
+		return watchIndex(engine, targetDir)
+	}
 	return nil
 }
 
+// includePathOptions returns the Engine options for the C/C++ include
+// search directories given with -I and --compile-commands.
+func includePathOptions() ([]canopy.Option, error) {
+	includePaths := flagIncludePaths
+	if flagCompileCommands != "" {
+		dirs, err := canopy.CompileCommandsIncludePaths(flagCompileCommands)
+		if err != nil {
+			return nil, err
+		}
+		includePaths = append(includePaths, dirs...)
+	}
+	if len(includePaths) == 0 {
+		return nil, nil
+	}
+	return []canopy.Option{canopy.WithIncludePaths(includePaths...)}, nil
+}
+
+// watchIndex re-indexes targetDir incrementally until interrupted.
+func watchIndex(engine *canopy.Engine, targetDir string) error {
+	ctx, stop := signal.NotifyContext(context.Background(), os.Interrupt, syscall.SIGTERM)
+	defer stop()
+
+	fmt.Fprintf(os.Stderr, "Watching %s for changes (Ctrl-C to stop)\n", targetDir)
+	return engine.Watch(ctx, targetDir, canopy.WithWatchCallback(func(b canopy.WatchBatch) {
+		fmt.Fprintf(os.Stderr, "Re-indexed %d changed, %d removed file(s) in %s (resolved %d)\n",
+			len(b.Changed), len(b.Removed), b.Duration.Round(time.Millisecond), b.Resolved)
+		if b.Err != nil {
+			fmt.Fprintf(os.Stderr, "Warning: %s\n", b.Err)
+		}
+	}))
+}
+
 // resolveTargetDir returns the absolute path of the directory to index.
 func resolveTargetDir(args []string) (string, error) {
 	dir := "."
@@ -0,0 +1,79 @@
+package main
+
+import (
+	"context"
+	"fmt"
+	"os"
+	"path/filepath"
+	"time"
+
+	"github.com/jward/canopy"
+	"github.com/jward/canopy/scripts"
+	"github.com/spf13/cobra"
+)
+
+var mergeCmd = &cobra.Command{
+	Use:   "merge <shard-db>...",
+	Short: "Combine shard databases into one index and resolve it",
+	Long: `Copies the files and extraction data of databases built with
+'canopy index --shard' (or any other index) into the database, replacing files
+already indexed at the same paths, then resolves every file so references
+between shards are found.
+
+The shards must have been indexed with the same scripts.`,
+	Args: cobra.MinimumNArgs(1),
+	RunE: runMerge,
+}
+
+func init() {
+	mergeCmd.Flags().StringVar(&flagScriptsDir, "scripts-dir", "", "load scripts from disk path instead of embedded")
+	mergeCmd.Flags().StringSliceVarP(&flagIncludePaths, "include", "I", nil, "C/C++ include search directory, in search order (repeatable)")
+	mergeCmd.Flags().StringVar(&flagCompileCommands, "compile-commands", "", "compile_commands.json to read C/C++ include search directories from")
+	rootCmd.AddCommand(mergeCmd)
+}
+
+func runMerge(cmd *cobra.Command, args []string) error {
+	start := time.Now()
+	cwd, err := os.Getwd()
+	if err != nil {
+		return err
+	}
+	dbPath := resolveDBPath(findRepoRoot(cwd))
+	if err := os.MkdirAll(filepath.Dir(dbPath), 0o755); err != nil {
+		return fmt.Errorf("creating %s: %w", filepath.Dir(dbPath), err)
+	}
+
+	opts, err := includePathOptions()
+	if err != nil {
+		return err
+	}
+	scriptsDir := flagScriptsDir
+	if scriptsDir == "" {
+		opts = append(opts, canopy.WithScriptsFS(scripts.FS))
+	}
+	engine, err := canopy.New(dbPath, scriptsDir, opts...)
+	if err != nil {
+		return fmt.Errorf("creating engine: %w", err)
+	}
+	defer engine.Close()
+
+	ctx := context.Background()
+	res, err := engine.Merge(ctx, args...)
+	if err != nil {
+		return err
+	}
+	mergeDuration := time.Since(start)
+
+	resolveStart := time.Now()
+	if err := engine.Resolve(ctx); err != nil {
+		return fmt.Errorf("resolving: %w", err)
+	}
+	fmt.Fprintf(os.Stderr, "Merged %d file(s) from %d shard(s), %d replaced, in %s (merge: %s, resolve: %s)\n",
+		res.Files, len(args), res.Replaced,
+		time.Since(start).Round(time.Millisecond),
+		mergeDuration.Round(time.Millisecond),
+		time.Since(resolveStart).Round(time.Millisecond),
+	)
+	fmt.Fprintf(os.Stderr, "Database: %s\n", dbPath)
+	return nil
+}
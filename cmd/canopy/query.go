@@ -1,9 +1,11 @@
 package main
 
 import (
+	"bufio"
 	"database/sql"
 	"encoding/json"
 	"fmt"
+	"io"
 	"log"
 	"os"
 	"path/filepath"
@@ -19,6 +21,8 @@ var (
 	flagOffset int
 	flagSort   string
 	flagOrder  string
+	flagCursor string
+	flagAll    bool
 )
 
 var queryCmd = &cobra.Command{
@@ -32,6 +36,8 @@ func init() {
 	queryCmd.PersistentFlags().IntVar(&flagOffset, "offset", 0, "pagination offset")
 	queryCmd.PersistentFlags().StringVar(&flagSort, "sort", "", "sort field: name|kind|file|ref_count")
 	queryCmd.PersistentFlags().StringVar(&flagOrder, "order", "asc", "sort order: asc|desc")
+	queryCmd.PersistentFlags().StringVar(&flagCursor, "cursor", "", "resume after the page that returned this next_cursor (replaces --offset)")
+	queryCmd.PersistentFlags().BoolVar(&flagAll, "all", false, "stream every result as one JSON line each (symbols, search, files, unused, references)")
 
 	queryCmd.AddCommand(symbolAtCmd)
 	queryCmd.AddCommand(definitionCmd)
@@ -59,12 +65,21 @@ func init() {
 	queryCmd.AddCommand(circularDepsCmd)
 	queryCmd.AddCommand(unusedCmd)
 	queryCmd.AddCommand(hotspotsCmd)
+	queryCmd.AddCommand(batchCmd)
 }
 
 // --- Helpers ---
 
-// openStore opens the Store from the --db flag path (or default).
+// stdout receives command output. `canopy serve` swaps it for a per-request
+// buffer.
+var stdout io.Writer = os.Stdout
+
+// openStore opens the Store from the --db flag path (or default). Under
+// `canopy serve` it returns the daemon's long-lived Store instead.
 func openStore() (*store.Store, error) {
+	if served != nil {
+		return served.store, nil
+	}
 	cwd, err := os.Getwd()
 	if err != nil {
 		return nil, fmt.Errorf("getting cwd: %w", err)
@@ -79,6 +94,24 @@ func openStore() (*store.Store, error) {
 	return store.NewStore(dbPath)
 }
 
+// releaseStore closes a Store returned by openStore, unless it is the
+// daemon's shared Store.
+func releaseStore(s *store.Store) {
+	if served != nil && s == served.store {
+		return
+	}
+	s.Close()
+}
+
+// newQueryBuilder returns a QueryBuilder over s. Under `canopy serve` the
+// daemon's QueryBuilder is reused so its derived caches stay warm.
+func newQueryBuilder(s *store.Store) *canopy.QueryBuilder {
+	if served != nil && s == served.store {
+		return served.qb
+	}
+	return canopy.NewQueryBuilder(s)
+}
+
 // resolveFilePath converts a file argument to an absolute path.
 // If the path is already absolute, it's returned as-is.
 // Otherwise, it's resolved relative to the current working directory.
@@ -145,7 +178,7 @@ func outputResult(result CLIResult) error {
 	if flagFormat == "text" {
 		return outputResultText(result)
 	}
-	enc := json.NewEncoder(os.Stdout)
+	enc := json.NewEncoder(stdout)
 	enc.SetIndent("", "  ")
 	return enc.Encode(result)
 }
@@ -163,7 +196,7 @@ func outputError(command string, err error) error {
 		Command: command,
 		Error:   err.Error(),
 	}
-	enc := json.NewEncoder(os.Stdout)
+	enc := json.NewEncoder(stdout)
 	enc.SetIndent("", "  ")
 	_ = enc.Encode(result)
 	return err
@@ -174,7 +207,47 @@ func buildPagination() canopy.Pagination {
 	return canopy.Pagination{
 		Limit:  &flagLimit,
 		Offset: flagOffset,
+		Cursor: flagCursor,
+	}
+}
+
+// outputPage writes the page of a cursor-paginated listing selected by the
+// pagination flags. With --all it instead streams every item of the
+// listing as one JSON line, fetching page after page, so exporting a whole
+// index holds one page in memory at a time.
+func outputPage[T, C any](command string, fetch func(canopy.Pagination) (*canopy.PagedResult[T], error), toCLI func(T) C) error {
+	if !flagAll {
+		result, err := fetch(buildPagination())
+		if err != nil {
+			return outputError(command, err)
+		}
+		items := make([]C, len(result.Items))
+		for i, item := range result.Items {
+			items[i] = toCLI(item)
+		}
+		return outputResult(CLIResult{
+			Command:    command,
+			Results:    items,
+			TotalCount: &result.TotalCount,
+			NextCursor: result.NextCursor,
+		})
 	}
+
+	if flagFormat == "text" {
+		return outputError(command, fmt.Errorf("--all writes JSON lines only"))
+	}
+	bw := bufio.NewWriter(stdout)
+	enc := json.NewEncoder(bw)
+	for item, err := range canopy.Iterate(fetch) {
+		if err != nil {
+			_ = bw.Flush()
+			return outputError(command, err)
+		}
+		if err := enc.Encode(toCLI(item)); err != nil {
+			return fmt.Errorf("writing %s: %w", command, err)
+		}
+	}
+	return bw.Flush()
 }
 
 // paginateSlice applies CLI --limit and --offset flags to a slice.
@@ -286,7 +359,7 @@ func locationToCLI(loc canopy.Location, symbolID *int64) CLILocation {
 // Returns empty string if not found; logs non-ErrNoRows errors to stderr.
 func lookupSymbolName(s *store.Store, id int64) string {
 	var name string
-	err := s.DB().QueryRow("SELECT name FROM symbols WHERE id = ?", id).Scan(&name)
+	err := s.ReadDB().QueryRow("SELECT name FROM symbols WHERE id = ?", id).Scan(&name)
 	if err != nil && err != sql.ErrNoRows {
 		log.Printf("warning: lookupSymbolName(%d): %v", id, err)
 	}
@@ -300,7 +373,7 @@ func lookupFilePath(s *store.Store, fileID *int64) string {
 		return ""
 	}
 	var path string
-	err := s.DB().QueryRow("SELECT path FROM files WHERE id = ?", *fileID).Scan(&path)
+	err := s.ReadDB().QueryRow("SELECT path FROM files WHERE id = ?", *fileID).Scan(&path)
 	if err != nil && err != sql.ErrNoRows {
 		log.Printf("warning: lookupFilePath(%d): %v", *fileID, err)
 	}
@@ -321,7 +394,7 @@ func runSymbolAt(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("symbol-at", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
 	file, err := resolveFilePath(args[0])
 	if err != nil {
@@ -336,7 +409,7 @@ func runSymbolAt(cmd *cobra.Command, args []string) error {
 		return outputError("symbol-at", err)
 	}
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	sym, err := qb.SymbolAt(file, line, col)
 	if err != nil {
 		return outputError("symbol-at", err)
@@ -372,7 +445,7 @@ func runDefinition(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("definition", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
 	file, err := resolveFilePath(args[0])
 	if err != nil {
@@ -387,7 +460,7 @@ func runDefinition(cmd *cobra.Command, args []string) error {
 		return outputError("definition", err)
 	}
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	locs, err := qb.DefinitionAt(file, line, col)
 	if err != nil {
 		return outputError("definition", err)
@@ -429,29 +502,18 @@ func runReferences(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("references", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	symID, err := resolveSymbolID(cmd, args, qb)
 	if err != nil {
 		return outputError("references", err)
 	}
 
-	locs, err := qb.ReferencesTo(symID)
-	if err != nil {
-		return outputError("references", err)
-	}
-
-	cliLocs := make([]CLILocation, len(locs))
-	for i, loc := range locs {
-		cliLocs[i] = locationToCLI(loc, &symID)
-	}
-
-	paged, totalCount := paginateSlice(cliLocs)
-	return outputResult(CLIResult{
-		Command:    "references",
-		Results:    paged,
-		TotalCount: &totalCount,
+	return outputPage("references", func(p canopy.Pagination) (*canopy.PagedResult[canopy.Location], error) {
+		return qb.ReferencesToPage(symID, p)
+	}, func(loc canopy.Location) CLILocation {
+		return locationToCLI(loc, &symID)
 	})
 }
 
@@ -472,9 +534,9 @@ func runCallers(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("callers", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	symID, err := resolveSymbolID(cmd, args, qb)
 	if err != nil {
 		return outputError("callers", err)
@@ -523,9 +585,9 @@ func runCallees(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("callees", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	symID, err := resolveSymbolID(cmd, args, qb)
 	if err != nil {
 		return outputError("callees", err)
@@ -574,9 +636,9 @@ func runImplementations(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("implementations", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	symID, err := resolveSymbolID(cmd, args, qb)
 	if err != nil {
 		return outputError("implementations", err)
@@ -0,0 +1,167 @@
+package main
+
+import (
+	"bufio"
+	"bytes"
+	"encoding/json"
+	"fmt"
+	"io"
+	"os"
+
+	"github.com/jward/canopy"
+	"github.com/spf13/cobra"
+)
+
+var batchCmd = &cobra.Command{
+	Use:   "batch",
+	Short: "Answer many definition, references and symbol-detail queries from stdin",
+	Long: `Reads newline-delimited JSON requests on stdin and writes one response line per
+request, in the same order, to stdout. Each request is one of
+
+  {"id": <any>, "command": "definition", "file": "<path>", "line": <n>, "col": <n>}
+  {"id": <any>, "command": "references", "symbol": <id>}
+  {"id": <any>, "command": "symbol-detail", "symbol": <id>}
+
+and each response is {"id": ..., "result": <CLIResult>} as the query subcommand
+of the same name would print it (without definition symbol IDs), or
+{"id": ..., "error": "..."} for a request that cannot be answered. All the
+requests of one command are answered by a single batched query.`,
+	Args: cobra.NoArgs,
+	RunE: runBatch,
+}
+
+type batchRequest struct {
+	ID      json.RawMessage `json:"id,omitempty"`
+	Command string          `json:"command"`
+	File    string          `json:"file,omitempty"`
+	Line    int             `json:"line"`
+	Col     int             `json:"col"`
+	Symbol  int64           `json:"symbol"`
+}
+
+func runBatch(cmd *cobra.Command, args []string) error {
+	if served != nil {
+		return outputError("batch", fmt.Errorf("batch reads its requests from stdin; send them to serve one by one"))
+	}
+	if flagFormat == "text" {
+		return outputError("batch", fmt.Errorf("batch writes JSON only"))
+	}
+	s, err := openStore()
+	if err != nil {
+		return outputError("batch", err)
+	}
+	defer releaseStore(s)
+
+	reqs, errs := readBatchRequests(os.Stdin)
+
+	// Gather each command's requests, by index into reqs.
+	var positions []canopy.Position
+	var refIDs, detailIDs []int64
+	var defReqs, refReqs, detailReqs []int
+	for i, req := range reqs {
+		if errs[i] != nil {
+			continue
+		}
+		switch req.Command {
+		case "definition":
+			file, err := resolveFilePath(req.File)
+			if err != nil {
+				errs[i] = err
+				continue
+			}
+			positions = append(positions, canopy.Position{File: file, Line: req.Line, Col: req.Col})
+			defReqs = append(defReqs, i)
+		case "references":
+			refIDs = append(refIDs, req.Symbol)
+			refReqs = append(refReqs, i)
+		case "symbol-detail":
+			detailIDs = append(detailIDs, req.Symbol)
+			detailReqs = append(detailReqs, i)
+		default:
+			errs[i] = fmt.Errorf("unknown batch command %q: want definition, references or symbol-detail", req.Command)
+		}
+	}
+
+	qb := newQueryBuilder(s)
+	results := make([]CLIResult, len(reqs))
+	defs, err := qb.DefinitionsAt(positions)
+	if err != nil {
+		return outputError("batch", err)
+	}
+	for j, i := range defReqs {
+		cliLocs := make([]CLILocation, len(defs[j]))
+		for k, loc := range defs[j] {
+			cliLocs[k] = locationToCLI(loc, nil)
+		}
+		n := len(cliLocs)
+		results[i] = CLIResult{Command: "definition", Results: cliLocs, TotalCount: &n}
+	}
+
+	refs, err := qb.ReferencesToMany(refIDs)
+	if err != nil {
+		return outputError("batch", err)
+	}
+	for j, i := range refReqs {
+		cliLocs := make([]CLILocation, len(refs[j]))
+		for k, loc := range refs[j] {
+			cliLocs[k] = locationToCLI(loc, &refIDs[j])
+		}
+		paged, total := paginateSlice(cliLocs)
+		results[i] = CLIResult{Command: "references", Results: paged, TotalCount: &total}
+	}
+
+	details, err := qb.SymbolDetails(detailIDs)
+	if err != nil {
+		return outputError("batch", err)
+	}
+	for j, i := range detailReqs {
+		results[i] = CLIResult{Command: "symbol-detail"}
+		if d := details[j]; d != nil {
+			one := 1
+			results[i].Results = symbolDetailToCLI(d)
+			results[i].TotalCount = &one
+		}
+	}
+
+	bw := bufio.NewWriter(stdout)
+	enc := json.NewEncoder(bw)
+	for i, req := range reqs {
+		resp := serveResponse{ID: req.ID}
+		if errs[i] != nil {
+			resp.Error = errs[i].Error()
+		} else if resp.Result, err = json.Marshal(results[i]); err != nil {
+			return fmt.Errorf("encoding result: %w", err)
+		}
+		if err := enc.Encode(resp); err != nil {
+			return fmt.Errorf("writing response: %w", err)
+		}
+	}
+	return bw.Flush()
+}
+
+// readBatchRequests parses the non-blank lines of r as batch requests,
+// with the parse error of each line that is not one.
+func readBatchRequests(r io.Reader) ([]batchRequest, []error) {
+	var reqs []batchRequest
+	var errs []error
+	scanner := bufio.NewScanner(r)
+	scanner.Buffer(make([]byte, 64*1024), 16*1024*1024)
+	for scanner.Scan() {
+		line := bytes.TrimSpace(scanner.Bytes())
+		if len(line) == 0 {
+			continue
+		}
+		var req batchRequest
+		err := json.Unmarshal(line, &req)
+		if err != nil {
+			err = fmt.Errorf("invalid request: %w", err)
+		}
+		reqs = append(reqs, req)
+		errs = append(errs, err)
+	}
+	if err := scanner.Err(); err != nil {
+		reqs = append(reqs, batchRequest{})
+		errs = append(errs, fmt.Errorf("reading requests: %w", err))
+	}
+	return reqs, errs
+}
@@ -26,9 +26,9 @@ func runSymbolDetail(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("symbol-detail", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 
 	var detail *canopy.SymbolDetail
 
@@ -87,7 +87,7 @@ func runScopeAt(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("scope-at", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
 	file, err := resolveFilePath(args[0])
 	if err != nil {
@@ -102,7 +102,7 @@ func runScopeAt(cmd *cobra.Command, args []string) error {
 		return outputError("scope-at", err)
 	}
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	scopes, err := qb.ScopeAt(file, line, col)
 	if err != nil {
 		return outputError("scope-at", err)
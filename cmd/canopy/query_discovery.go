@@ -35,6 +35,7 @@ func init() {
 
 	searchCmd.Flags().Int("ref-count-min", 0, "minimum reference count")
 	searchCmd.Flags().Int("ref-count-max", 0, "maximum reference count")
+	searchCmd.Flags().Bool("fuzzy", false, "rank symbols by fuzzy subsequence match instead of glob (ignores --sort and --offset)")
 }
 
 func runSymbols(cmd *cobra.Command, args []string) error {
@@ -42,7 +43,7 @@ func runSymbols(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("symbols", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
 	filter := canopy.SymbolFilter{}
 	if flagKind != "" {
@@ -77,29 +78,17 @@ func runSymbols(cmd *cobra.Command, args []string) error {
 		filter.FileID = &f.ID
 	}
 
-	qb := canopy.NewQueryBuilder(s)
-	result, err := qb.Symbols(filter, buildSort(), buildPagination())
-	if err != nil {
-		return outputError("symbols", err)
-	}
-
-	cliSyms := make([]CLISymbol, len(result.Items))
-	for i, sr := range result.Items {
-		cliSyms[i] = symbolResultToCLI(sr)
-	}
-
-
-	return outputResult(CLIResult{
-		Command:    "symbols",
-		Results:    cliSyms,
-		TotalCount: &result.TotalCount,
-	})
+	qb := newQueryBuilder(s)
+	sort := buildSort()
+	return outputPage("symbols", func(p canopy.Pagination) (*canopy.PagedResult[canopy.SymbolResult], error) {
+		return qb.Symbols(filter, sort, p)
+	}, symbolResultToCLI)
 }
 
 var searchCmd = &cobra.Command{
 	Use:   "search <pattern>",
 	Short: "Search symbols by glob pattern",
-	Long:  "Search for symbols matching a glob pattern. Use * as wildcard (e.g. 'Get*User*').",
+	Long:  "Search for symbols matching a glob pattern. Use * as wildcard (e.g. 'Get*User*').\nWith --fuzzy, rank symbols whose names contain the pattern as a subsequence (e.g. 'hdlreq').",
 	Args:  cobra.ExactArgs(1),
 	RunE:  runSearch,
 }
@@ -109,7 +98,7 @@ func runSearch(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("search", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
 	filter := canopy.SymbolFilter{}
 	if cmd.Flags().Changed("ref-count-min") {
@@ -121,23 +110,26 @@ func runSearch(cmd *cobra.Command, args []string) error {
 		filter.RefCountMax = intPtr(v)
 	}
 
-	qb := canopy.NewQueryBuilder(s)
-	result, err := qb.SearchSymbols(args[0], filter, buildSort(), buildPagination())
-	if err != nil {
-		return outputError("search", err)
-	}
-
-	cliSyms := make([]CLISymbol, len(result.Items))
-	for i, sr := range result.Items {
-		cliSyms[i] = symbolResultToCLI(sr)
+	qb := newQueryBuilder(s)
+	if fuzzy, _ := cmd.Flags().GetBool("fuzzy"); fuzzy {
+		items, err := qb.FuzzySearch(args[0], filter, flagLimit)
+		if err != nil {
+			return outputError("search", err)
+		}
+		cliSyms := make([]CLISymbol, len(items))
+		for i, sr := range items {
+			cliSyms[i] = symbolResultToCLI(sr)
+		}
+		return outputResult(CLIResult{
+			Command: "search",
+			Results: cliSyms,
+		})
 	}
 
-
-	return outputResult(CLIResult{
-		Command:    "search",
-		Results:    cliSyms,
-		TotalCount: &result.TotalCount,
-	})
+	sort := buildSort()
+	return outputPage("search", func(p canopy.Pagination) (*canopy.PagedResult[canopy.SymbolResult], error) {
+		return qb.SearchSymbols(args[0], filter, sort, p)
+	}, symbolResultToCLI)
 }
 
 var filesCmd = &cobra.Command{
@@ -156,29 +148,19 @@ func runFiles(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("files", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
-	qb := canopy.NewQueryBuilder(s)
-	result, err := qb.Files(flagPrefix, flagLanguage, buildSort(), buildPagination())
-	if err != nil {
-		return outputError("files", err)
-	}
-
-	cliFiles := make([]CLIFile, len(result.Items))
-	for i, f := range result.Items {
-		cliFiles[i] = CLIFile{
+	qb := newQueryBuilder(s)
+	sort := buildSort()
+	return outputPage("files", func(p canopy.Pagination) (*canopy.PagedResult[canopy.File], error) {
+		return qb.Files(flagPrefix, flagLanguage, sort, p)
+	}, func(f canopy.File) CLIFile {
+		return CLIFile{
 			ID:        f.ID,
 			Path:      f.Path,
 			Language:  f.Language,
 			LineCount: f.LineCount,
 		}
-	}
-
-
-	return outputResult(CLIResult{
-		Command:    "files",
-		Results:    cliFiles,
-		TotalCount: &result.TotalCount,
 	})
 }
 
@@ -198,11 +180,11 @@ func runPackages(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("packages", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
 	prefix, _ := cmd.Flags().GetString("prefix")
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	result, err := qb.Packages(prefix, buildSort(), buildPagination())
 	if err != nil {
 		return outputError("packages", err)
@@ -232,9 +214,9 @@ func runSummary(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("summary", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	summary, err := qb.ProjectSummary(10)
 	if err != nil {
 		return outputError("summary", err)
@@ -279,9 +261,9 @@ func runPackageSummary(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("package-summary", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 
 	var pkgPath string
 	var pkgID *int64
@@ -330,7 +312,7 @@ func runDeps(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("deps", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
 	filePath, err := resolveFilePath(args[0])
 	if err != nil {
@@ -345,7 +327,7 @@ func runDeps(cmd *cobra.Command, args []string) error {
 		return outputError("deps", fmt.Errorf("file not found: %s", args[0]))
 	}
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	imports, err := qb.Dependencies(f.ID)
 	if err != nil {
 		return outputError("deps", err)
@@ -383,9 +365,9 @@ func runDependents(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("dependents", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	imports, err := qb.Dependents(args[0])
 	if err != nil {
 		return outputError("dependents", err)
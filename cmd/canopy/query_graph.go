@@ -69,9 +69,9 @@ func runTransitiveCallers(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("transitive-callers", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	symID, err := resolveSymbolID(cmd, args, qb)
 	if err != nil {
 		return outputError("transitive-callers", err)
@@ -104,9 +104,9 @@ func runTransitiveCallees(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("transitive-callees", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	symID, err := resolveSymbolID(cmd, args, qb)
 	if err != nil {
 		return outputError("transitive-callees", err)
@@ -139,9 +139,9 @@ func runPackageGraph(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("package-graph", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	graph, err := qb.PackageDependencyGraph()
 	if err != nil {
 		return outputError("package-graph", err)
@@ -161,9 +161,9 @@ func runCircularDeps(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("circular-deps", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	cycles, err := qb.CircularDependencies()
 	if err != nil {
 		return outputError("circular-deps", err)
@@ -187,7 +187,7 @@ func runUnused(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("unused", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
 	filter := canopy.SymbolFilter{}
 	if flagKind != "" {
@@ -200,23 +200,11 @@ func runUnused(cmd *cobra.Command, args []string) error {
 		filter.PathPrefix = &flagPathPrefix
 	}
 
-	qb := canopy.NewQueryBuilder(s)
-	result, err := qb.UnusedSymbols(filter, buildSort(), buildPagination())
-	if err != nil {
-		return outputError("unused", err)
-	}
-
-	cliSyms := make([]CLISymbol, len(result.Items))
-	for i, sr := range result.Items {
-		cliSyms[i] = symbolResultToCLI(sr)
-	}
-
-
-	return outputResult(CLIResult{
-		Command:    "unused",
-		Results:    cliSyms,
-		TotalCount: &result.TotalCount,
-	})
+	qb := newQueryBuilder(s)
+	sort := buildSort()
+	return outputPage("unused", func(p canopy.Pagination) (*canopy.PagedResult[canopy.SymbolResult], error) {
+		return qb.UnusedSymbols(filter, sort, p)
+	}, symbolResultToCLI)
 }
 
 func runHotspots(cmd *cobra.Command, args []string) error {
@@ -224,11 +212,11 @@ func runHotspots(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("hotspots", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
 	topN, _ := cmd.Flags().GetInt("top")
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	hotspots, err := qb.Hotspots(topN)
 	if err != nil {
 		return outputError("hotspots", err)
@@ -52,9 +52,9 @@ func runTypeHierarchy(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("type-hierarchy", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	symID, err := resolveSymbolID(cmd, args, qb)
 	if err != nil {
 		return outputError("type-hierarchy", err)
@@ -86,9 +86,9 @@ func runImplements(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("implements", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	symID, err := resolveSymbolID(cmd, args, qb)
 	if err != nil {
 		return outputError("implements", err)
@@ -121,9 +121,9 @@ func runExtensions(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("extensions", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	symID, err := resolveSymbolID(cmd, args, qb)
 	if err != nil {
 		return outputError("extensions", err)
@@ -152,7 +152,7 @@ func runReexports(cmd *cobra.Command, args []string) error {
 	if err != nil {
 		return outputError("reexports", err)
 	}
-	defer s.Close()
+	defer releaseStore(s)
 
 	file, err := resolveFilePath(args[0])
 	if err != nil {
@@ -167,7 +167,7 @@ func runReexports(cmd *cobra.Command, args []string) error {
 		return outputError("reexports", fmt.Errorf("file not found in index: %s", file))
 	}
 
-	qb := canopy.NewQueryBuilder(s)
+	qb := newQueryBuilder(s)
 	reexports, err := qb.Reexports(f.ID)
 	if err != nil {
 		return outputError("reexports", err)
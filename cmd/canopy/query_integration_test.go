@@ -400,6 +400,48 @@ func TestQuery_Pagination(t *testing.T) {
 	assert.GreaterOrEqual(t, int(tc), 1)
 }
 
+func TestQuery_CursorAndAll(t *testing.T) {
+	if testing.Short() {
+		t.Skip("skipping integration test")
+	}
+	bin, fixtureDir, _ := indexFixture(t)
+
+	full := runQuery(t, bin, fixtureDir, "symbols", "--limit", "500")
+	total := int(full["total_count"].(float64))
+	require.Greater(t, total, 1)
+	var want []any
+	for _, r := range full["results"].([]any) {
+		want = append(want, r.(map[string]any)["id"])
+	}
+
+	// Walking one symbol per page by cursor visits every symbol once.
+	var walked []any
+	args := []string{"symbols", "--limit", "1"}
+	for {
+		page := runQuery(t, bin, fixtureDir, args...)
+		assert.Equal(t, float64(total), page["total_count"])
+		for _, r := range page["results"].([]any) {
+			walked = append(walked, r.(map[string]any)["id"])
+		}
+		cursor, _ := page["next_cursor"].(string)
+		if cursor == "" {
+			break
+		}
+		args = []string{"symbols", "--limit", "1", "--cursor", cursor}
+	}
+	assert.Equal(t, want, walked)
+
+	// --all streams the same symbols, one JSON line each.
+	out, _ := runQueryRaw(t, bin, fixtureDir, "symbols", "--all")
+	var streamed []any
+	for _, line := range strings.Split(strings.TrimSpace(out), "\n") {
+		var sym map[string]any
+		require.NoError(t, json.Unmarshal([]byte(line), &sym), "invalid JSON line: %s", line)
+		streamed = append(streamed, sym["id"])
+	}
+	assert.Equal(t, want, streamed)
+}
+
 func TestQuery_Definition(t *testing.T) {
 	if testing.Short() {
 		t.Skip("skipping integration test")
@@ -0,0 +1,237 @@
+package main
+
+import (
+	"bufio"
+	"bytes"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"io"
+	"net"
+	"os"
+	"os/signal"
+	"sync"
+	"syscall"
+
+	"github.com/jward/canopy"
+	"github.com/jward/canopy/internal/store"
+	"github.com/spf13/cobra"
+	"github.com/spf13/pflag"
+)
+
+var flagSocket string
+
+var serveCmd = &cobra.Command{
+	Use:   "serve",
+	Short: "Answer queries from a long-lived process with warm caches",
+	Long: `Keeps the database, the mapped call graph index and derived structures such
+as the package dependency graph resident, and answers query requests as
+newline-delimited JSON on stdin/stdout (default) or on a Unix socket.
+
+Each request line is {"id": <any>, "command": "<query subcommand>", "args": [...]},
+where args are the same positional arguments and flags accepted by
+'canopy query <command>'. Each response line is {"id": ..., "result": <CLIResult>}
+in JSON format, or {"id": ..., "text": "..."} with --format text; failures that
+happen before a command runs are reported as {"id": ..., "error": "..."}.
+
+Caches are refreshed automatically after every 'canopy index' run against the
+same database.`,
+	Args: cobra.NoArgs,
+	RunE: runServe,
+}
+
+func init() {
+	serveCmd.Flags().StringVar(&flagSocket, "socket", "", "listen on this Unix socket path instead of stdin/stdout")
+	rootCmd.AddCommand(serveCmd)
+}
+
+// served is the daemon's shared state; nil outside `canopy serve`.
+var served *server
+
+// server runs query commands in-process against one Store. Commands share
+// package-level flag variables, so requests are executed one at a time.
+type server struct {
+	store  *store.Store
+	qb     *canopy.QueryBuilder
+	format string // --format given to serve; requests may override it
+	mu     sync.Mutex
+}
+
+type serveRequest struct {
+	ID      json.RawMessage `json:"id,omitempty"`
+	Command string          `json:"command"`
+	Args    []string        `json:"args,omitempty"`
+}
+
+type serveResponse struct {
+	ID     json.RawMessage `json:"id,omitempty"`
+	Result json.RawMessage `json:"result,omitempty"`
+	Text   string          `json:"text,omitempty"`
+	Error  string          `json:"error,omitempty"`
+}
+
+func runServe(cmd *cobra.Command, args []string) error {
+	s, err := openStore()
+	if err != nil {
+		return err
+	}
+	defer s.Close()
+
+	srv := &server{
+		store:  s,
+		qb:     canopy.NewQueryBuilder(s, canopy.WithDerivedCache()),
+		format: flagFormat,
+	}
+	served = srv
+	defer func() { served = nil }()
+
+	// Requests reset every flag, so capture the socket path up front.
+	socket := flagSocket
+	if socket == "" {
+		return srv.serveConn(os.Stdin, os.Stdout)
+	}
+
+	// A stale socket from a crashed daemon would make Listen fail.
+	if err := os.Remove(socket); err != nil && !os.IsNotExist(err) {
+		return fmt.Errorf("removing stale socket %s: %w", socket, err)
+	}
+	ln, err := net.Listen("unix", socket)
+	if err != nil {
+		return fmt.Errorf("listening on %s: %w", socket, err)
+	}
+	defer os.Remove(socket)
+
+	sigCh := make(chan os.Signal, 1)
+	signal.Notify(sigCh, os.Interrupt, syscall.SIGTERM)
+	defer signal.Stop(sigCh)
+	go func() {
+		<-sigCh
+		ln.Close()
+	}()
+
+	fmt.Fprintf(os.Stderr, "Serving %s on %s\n", s.Path(), socket)
+	for {
+		conn, err := ln.Accept()
+		if err != nil {
+			if errors.Is(err, net.ErrClosed) {
+				return nil
+			}
+			return fmt.Errorf("accepting connection: %w", err)
+		}
+		go func() {
+			defer conn.Close()
+			if err := srv.serveConn(conn, conn); err != nil {
+				fmt.Fprintf(os.Stderr, "connection error: %s\n", err)
+			}
+		}()
+	}
+}
+
+// serveConn answers newline-delimited JSON requests from r until EOF.
+func (srv *server) serveConn(r io.Reader, w io.Writer) error {
+	scanner := bufio.NewScanner(r)
+	scanner.Buffer(make([]byte, 64*1024), 16*1024*1024)
+	bw := bufio.NewWriter(w)
+	enc := json.NewEncoder(bw)
+	for scanner.Scan() {
+		line := bytes.TrimSpace(scanner.Bytes())
+		if len(line) == 0 {
+			continue
+		}
+		var req serveRequest
+		var resp serveResponse
+		if err := json.Unmarshal(line, &req); err != nil {
+			resp.Error = fmt.Sprintf("invalid request: %s", err)
+		} else {
+			resp = srv.handle(req)
+		}
+		if err := enc.Encode(resp); err != nil {
+			return err
+		}
+		if err := bw.Flush(); err != nil {
+			return err
+		}
+	}
+	return scanner.Err()
+}
+
+// handle runs one query subcommand and captures its output.
+func (srv *server) handle(req serveRequest) serveResponse {
+	resp := serveResponse{ID: req.ID}
+	if req.Command == "" {
+		resp.Error = "missing command"
+		return resp
+	}
+	sub, _, err := queryCmd.Find([]string{req.Command})
+	if err != nil || sub == queryCmd {
+		resp.Error = fmt.Sprintf("unknown query command %q", req.Command)
+		return resp
+	}
+
+	srv.mu.Lock()
+	defer srv.mu.Unlock()
+
+	// A database renamed over ours by a process that skipped its lock file
+	// would otherwise be served stale until restart.
+	reopened, err := srv.store.ReopenIfReplaced()
+	if err != nil {
+		resp.Error = err.Error()
+		return resp
+	}
+	if reopened {
+		srv.qb = canopy.NewQueryBuilder(srv.store, canopy.WithDerivedCache())
+	}
+
+	// Cobra writes help and usage to its own streams, which would otherwise
+	// land in the response stream of a stdio daemon.
+	var buf bytes.Buffer
+	stdout = &buf
+	rootCmd.SetOut(&buf)
+	rootCmd.SetErr(&buf)
+	silenceUsage, silenceErrors := rootCmd.SilenceUsage, rootCmd.SilenceErrors
+	rootCmd.SilenceUsage, rootCmd.SilenceErrors = true, true
+	defer func() {
+		stdout = os.Stdout
+		rootCmd.SetOut(nil)
+		rootCmd.SetErr(nil)
+		rootCmd.SilenceUsage, rootCmd.SilenceErrors = silenceUsage, silenceErrors
+	}()
+	resetFlags(rootCmd)
+	flagFormat = srv.format
+	errorHandled = false
+
+	rootCmd.SetArgs(append([]string{"query", req.Command}, req.Args...))
+	runErr := rootCmd.Execute()
+
+	out := bytes.TrimSpace(buf.Bytes())
+	switch {
+	case len(out) > 0 && flagFormat != "text" && json.Valid(out):
+		var compact bytes.Buffer
+		_ = json.Compact(&compact, out)
+		resp.Result = compact.Bytes()
+	case len(out) > 0:
+		resp.Text = string(out)
+	}
+	if runErr != nil && resp.Result == nil {
+		resp.Error = runErr.Error()
+	}
+	return resp
+}
+
+// resetFlags restores every flag under cmd to its default so one request's
+// flags don't leak into the next.
+func resetFlags(cmd *cobra.Command) {
+	reset := func(f *pflag.Flag) {
+		if sv, ok := f.Value.(pflag.SliceValue); ok {
+			_ = sv.Replace(nil)
+		} else {
+			_ = f.Value.Set(f.DefValue)
+		}
+		f.Changed = false
+	}
+	cmd.Flags().VisitAll(reset)
+	cmd.PersistentFlags().VisitAll(reset)
+	for _, c := range cmd.Commands() {
+		resetFlags(c)
+	}
+}
@@ -0,0 +1,102 @@
+package main_test
+
+import (
+	"bufio"
+	"encoding/json"
+	"os"
+	"os/exec"
+	"strings"
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+type serveResponse struct {
+	ID     int            `json:"id"`
+	Result map[string]any `json:"result"`
+	Text   string         `json:"text"`
+	Error  string         `json:"error"`
+}
+
+// runServe feeds requests to `canopy serve` over stdin and returns its
+// responses, checking that every stdout line is one JSON response.
+func runServe(t *testing.T, bin, fixtureDir string, requests ...string) []serveResponse {
+	t.Helper()
+	cmd := exec.Command(bin, "serve")
+	cmd.Dir = fixtureDir
+	cmd.Env = append(os.Environ(), "HOME="+t.TempDir())
+	cmd.Stdin = strings.NewReader(strings.Join(requests, "\n") + "\n")
+	out, err := cmd.Output()
+	require.NoError(t, err)
+
+	var resps []serveResponse
+	scanner := bufio.NewScanner(strings.NewReader(string(out)))
+	scanner.Buffer(make([]byte, 64*1024), 16*1024*1024)
+	for scanner.Scan() {
+		var resp serveResponse
+		require.NoError(t, json.Unmarshal(scanner.Bytes(), &resp), "not a JSON response: %s", scanner.Text())
+		resps = append(resps, resp)
+	}
+	require.NoError(t, scanner.Err())
+	require.Len(t, resps, len(requests), "stdout: %s", out)
+	return resps
+}
+
+func TestServe_StdioFraming(t *testing.T) {
+	if testing.Short() {
+		t.Skip("skipping integration test")
+	}
+	bin, fixtureDir, _ := indexFixture(t)
+
+	resps := runServe(t, bin, fixtureDir,
+		`{"id": 1, "command": "files"}`,
+		`not json`,
+		`{"id": 3, "command": "nosuchcommand"}`,
+		`{"id": 4, "command": "symbols", "args": ["--kind", "function"]}`,
+	)
+	assert.Equal(t, 1, resps[0].ID)
+	assert.Equal(t, "files", resps[0].Result["command"])
+	assert.Contains(t, resps[1].Error, "invalid request")
+	assert.Equal(t, 3, resps[2].ID)
+	assert.Contains(t, resps[2].Error, "unknown query command")
+	assert.Equal(t, 4, resps[3].ID)
+	assert.Equal(t, "symbols", resps[3].Result["command"])
+}
+
+func TestServe_HelpAndBadFlagsStayInResponse(t *testing.T) {
+	if testing.Short() {
+		t.Skip("skipping integration test")
+	}
+	bin, fixtureDir, _ := indexFixture(t)
+
+	resps := runServe(t, bin, fixtureDir,
+		`{"id": 1, "command": "files", "args": ["--help"]}`,
+		`{"id": 2, "command": "files", "args": ["--no-such-flag"]}`,
+		`{"id": 3, "command": "files"}`,
+	)
+	assert.Contains(t, resps[0].Text, "Usage:")
+	assert.Empty(t, resps[0].Error)
+	assert.Contains(t, resps[1].Error, "no-such-flag")
+	assert.NotContains(t, resps[1].Text, "Usage:")
+	assert.Equal(t, "files", resps[2].Result["command"])
+}
+
+func TestServe_FlagsDoNotLeakBetweenRequests(t *testing.T) {
+	if testing.Short() {
+		t.Skip("skipping integration test")
+	}
+	bin, fixtureDir, _ := indexFixture(t)
+
+	resps := runServe(t, bin, fixtureDir,
+		`{"id": 1, "command": "files", "args": ["--language", "rust"]}`,
+		`{"id": 2, "command": "files"}`,
+		`{"id": 3, "command": "files", "args": ["--format", "text"]}`,
+		`{"id": 4, "command": "files"}`,
+	)
+	assert.Empty(t, resps[0].Result["results"])
+	assert.Len(t, resps[1].Result["results"], 1, "--language from the previous request must not apply")
+	assert.NotEmpty(t, resps[2].Text)
+	assert.Nil(t, resps[2].Result)
+	assert.Equal(t, "files", resps[3].Result["command"], "--format from the previous request must not apply")
+}
@@ -5,6 +5,7 @@ type CLIResult struct {
 	Command    string `json:"command"`
 	Results    any    `json:"results"`
 	TotalCount *int   `json:"total_count,omitempty"`
+	NextCursor string `json:"next_cursor,omitempty"`
 	Error      string `json:"error,omitempty"`
 }
 
@@ -0,0 +1,135 @@
+package canopy
+
+import (
+	"encoding/json"
+	"fmt"
+	"os"
+	"path/filepath"
+	"strings"
+)
+
+// compileCommand is one entry of a JSON compilation database.
+type compileCommand struct {
+	Directory string   `json:"directory"`
+	Command   string   `json:"command"`
+	Arguments []string `json:"arguments"`
+}
+
+// CompileCommandsIncludePaths reads the compilation database at path (a
+// compile_commands.json, as written by CMake or Bear) and returns the
+// include directories its commands pass with -I, -iquote, -isystem or
+// -idirafter (or /I, for commands run by cl or clang-cl), in order of first
+// appearance. Relative directories are taken relative to the entry's
+// working directory.
+func CompileCommandsIncludePaths(path string) ([]string, error) {
+	data, err := os.ReadFile(path)
+	if err != nil {
+		return nil, fmt.Errorf("compile commands: %w", err)
+	}
+	var cmds []compileCommand
+	if err := json.Unmarshal(data, &cmds); err != nil {
+		return nil, fmt.Errorf("compile commands: %s: %w", path, err)
+	}
+
+	seen := make(map[string]bool)
+	var dirs []string
+	for _, cmd := range cmds {
+		args := cmd.Arguments
+		if len(args) == 0 {
+			args = splitCommand(cmd.Command)
+		}
+		for _, dir := range includeFlags(args) {
+			if !filepath.IsAbs(dir) {
+				dir = filepath.Join(cmd.Directory, dir)
+			}
+			dir = filepath.Clean(dir)
+			if !seen[dir] {
+				seen[dir] = true
+				dirs = append(dirs, dir)
+			}
+		}
+	}
+	return dirs, nil
+}
+
+// includeFlagPrefixes are the compiler flags naming an include directory,
+// either joined to it or followed by it as the next argument.
+// msvcIncludeFlagPrefixes adds the MSVC form, which elsewhere would match
+// absolute paths such as /Include/x.c.
+var (
+	includeFlagPrefixes     = []string{"-iquote", "-isystem", "-idirafter", "-I"}
+	msvcIncludeFlagPrefixes = []string{"-iquote", "-isystem", "-idirafter", "-I", "/I"}
+)
+
+// includeFlags returns the include directories named in args, a compiler
+// invocation starting with the driver.
+func includeFlags(args []string) []string {
+	prefixes := includeFlagPrefixes
+	if len(args) > 0 && msvcDriver(args[0]) {
+		prefixes = msvcIncludeFlagPrefixes
+	}
+	var dirs []string
+	for i := 0; i < len(args); i++ {
+		for _, prefix := range prefixes {
+			if !strings.HasPrefix(args[i], prefix) {
+				continue
+			}
+			if dir := args[i][len(prefix):]; dir != "" {
+				dirs = append(dirs, dir)
+			} else if i+1 < len(args) {
+				i++
+				dirs = append(dirs, args[i])
+			}
+			break
+		}
+	}
+	return dirs
+}
+
+// msvcDriver reports whether driver, a compiler path, is cl or clang-cl,
+// which take MSVC-style flags.
+func msvcDriver(driver string) bool {
+	name := strings.ToLower(driver[strings.LastIndexAny(driver, `/\`)+1:])
+	name = strings.TrimSuffix(name, ".exe")
+	return name == "cl" || name == "clang-cl"
+}
+
+// splitCommand splits a shell command line into arguments, honoring single
+// and double quotes and backslash escapes.
+func splitCommand(command string) []string {
+	var args []string
+	var cur strings.Builder
+	inArg := false
+	var quote rune
+	escaped := false
+	for _, r := range command {
+		switch {
+		case escaped:
+			cur.WriteRune(r)
+			escaped = false
+		case r == '\\' && quote != '\'':
+			escaped, inArg = true, true
+		case quote != 0:
+			if r == quote {
+				quote = 0
+			} else {
+				cur.WriteRune(r)
+			}
+		case r == '"' || r == '\'':
+			quote, inArg = r, true
+		case r == ' ' || r == '\t' || r == '\n':
+			if inArg {
+				args = append(args, cur.String())
+				cur.Reset()
+				inArg = false
+			}
+		default:
+			cur.WriteRune(r)
+			inArg = true
+		}
+	}
+	if inArg {
+		args = append(args, cur.String())
+	}
+	return args
+}
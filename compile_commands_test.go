@@ -0,0 +1,33 @@
+package canopy
+
+import (
+	"os"
+	"path/filepath"
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func TestCompileCommandsIncludePaths(t *testing.T) {
+	t.Parallel()
+	path := filepath.Join(t.TempDir(), "compile_commands.json")
+	require.NoError(t, os.WriteFile(path, []byte(`[
+  {"directory": "/build", "file": "a.c",
+   "command": "cc -Iinclude -I /opt/x/include -isystem \"/usr/local/my inc\" -DX=1 -c a.c"},
+  {"directory": "/build/sub", "file": "b.c",
+   "arguments": ["cc", "-iquote", "../include", "-I/opt/x/include", "-c", "b.c"]}
+]`), 0644))
+
+	dirs, err := CompileCommandsIncludePaths(path)
+	require.NoError(t, err)
+	assert.Equal(t, []string{"/build/include", "/opt/x/include", "/usr/local/my inc"}, dirs)
+}
+
+func TestIncludeFlags_MSVCOnlyForMSVCDrivers(t *testing.T) {
+	t.Parallel()
+	// An absolute Unix path is not an MSVC /I flag.
+	assert.Equal(t, []string{"inc"}, includeFlags([]string{"/usr/bin/cc", "-Iinc", "/Incoming/x.c", "-c"}))
+	assert.Equal(t, []string{"inc", "dir"}, includeFlags([]string{`C:\VC\bin\CL.EXE`, "/Iinc", "/I", "dir", "x.c"}))
+	assert.Equal(t, []string{"inc"}, includeFlags([]string{"clang-cl", "/Iinc", "x.c"}))
+}
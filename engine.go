@@ -6,12 +6,12 @@ import (
 	"crypto/sha256"
 	"fmt"
 	"io/fs"
-	"os"
+	"math"
 	"os/exec"
 	"path/filepath"
 	"sort"
 	"strings"
-	"sync"
+	"sync/atomic"
 	"time"
 
 	"github.com/jward/canopy/internal/runtime"
@@ -31,10 +31,88 @@ type Engine struct {
 	// nil means "resolve everything" (first run or full reindex).
 	blastRadius map[int64]bool
 
+	// blastDepth is how many dependency hops past a changed file the blast
+	// radius reaches (see WithBlastRadiusDepth).
+	blastDepth int
+
 	// useParallel enables the parallel extraction pipeline.
 	useParallel bool
+
+	// commitBatchSize and commitInterval bound how many extracted files the
+	// parallel writer groups into one SQLite transaction.
+	commitBatchSize int
+	commitInterval  time.Duration
+
+	// paranoid disables the stat fast path so every file is read and hashed.
+	paranoid bool
+
+	// resolveWorkers bounds concurrent resolution shards; resolveShardMin is
+	// the smallest file count worth splitting off into its own shard.
+	resolveWorkers  int
+	resolveShardMin int
+
+	// trees holds the previous parse tree of recently indexed files so
+	// re-indexing them parses incrementally; nil disables (see
+	// WithIncrementalParse).
+	trees *runtime.TreeCache
+
+	// patchMinLines is the size from which changed, already indexed files
+	// are patched in place instead of deleted and re-inserted; <= 0
+	// disables (see WithPartialReextraction).
+	patchMinLines int
+
+	// memoryLimit caps the estimated bytes held by files in flight through
+	// the parallel pipeline; <= 0 means unlimited (see WithMemoryLimit).
+	memoryLimit int64
+
+	// bulkLoad opens the store for a cold build (see WithBulkLoad); while
+	// store.Bulk() holds, no blast radius is tracked.
+	bulkLoad bool
+
+	// compactRefs opens the store with compact reference storage (see
+	// WithCompactReferences).
+	compactRefs bool
+
+	// includePaths are the C/C++ include search directories, in order (see
+	// WithIncludePaths).
+	includePaths []string
+
+	// shard limits IndexDirectory to one part of the tree (see WithShard);
+	// resolveAll makes the next Resolve resolve every file, as a Merge
+	// requires, whatever IndexFiles adds to the blast radius meanwhile.
+	shard      *Shard
+	resolveAll bool
+
+	// stats collects timings when set (see WithStats); profileLabels tags
+	// the work of each phase with pprof labels (see WithProfileLabels).
+	stats         *statsRecorder
+	profileLabels bool
+
+	// fileTimeout bounds the extraction of each file and the resolution of
+	// each shard's files; <= 0 means no deadline (see WithFileTimeout).
+	fileTimeout time.Duration
+
+	// resolutionCache skips re-resolving blast-radius files whose resolution
+	// inputs are unchanged (see WithResolutionCache); fingerprints holds the
+	// fingerprints of the files the current Resolve pass resolves.
+	resolutionCache bool
+	fingerprints    map[int64]string
+
+	// sharedExtractions counts files indexed by copying the rows of an
+	// identical file (see SharedExtractions).
+	sharedExtractions atomic.Int64
 }
 
+// Defaults for the parallel writer stage (see WithCommitBatching).
+const (
+	defaultCommitBatchSize = 64
+	defaultCommitInterval  = 250 * time.Millisecond
+)
+
+// defaultBlastDepth re-resolves the direct dependents of changed files only
+// (see WithBlastRadiusDepth).
+const defaultBlastDepth = 1
+
 // Option configures an Engine.
 type Option func(*Engine)
 
@@ -57,6 +135,115 @@ func WithParallel(parallel bool) Option {
 	}
 }
 
+// WithCommitBatching configures the parallel writer stage. Up to maxFiles
+// extracted files are committed in a single transaction, and a partially
+// filled group is flushed once maxDelay has elapsed so workers never wait on
+// a slow trickle of results. Values <= 0 keep the defaults (64 files, 250ms).
+func WithCommitBatching(maxFiles int, maxDelay time.Duration) Option {
+	return func(e *Engine) {
+		if maxFiles > 0 {
+			e.commitBatchSize = maxFiles
+		}
+		if maxDelay > 0 {
+			e.commitInterval = maxDelay
+		}
+	}
+}
+
+// WithParanoidHashing disables the stat-based unchanged-file fast path.
+// By default a file whose size, mtime and inode match the values recorded
+// when it was last indexed is skipped without being read; in paranoid mode
+// every file is read and its SHA-256 compared.
+func WithParanoidHashing(paranoid bool) Option {
+	return func(e *Engine) {
+		e.paranoid = paranoid
+	}
+}
+
+// WithResolveWorkers bounds how many resolution script instances run at
+// once. Each language's files are split into up to n shards resolved
+// concurrently, sharing read-only query caches, with their writes batched
+// through a single writer. n <= 0 keeps the default (runtime.NumCPU()).
+func WithResolveWorkers(n int) Option {
+	return func(e *Engine) {
+		if n > 0 {
+			e.resolveWorkers = n
+		}
+	}
+}
+
+// WithBlastRadiusDepth sets how far the blast radius of a change reaches
+// through the file dependency graph (see store.FileGraph), which Resolve
+// builds from resolved references, re-exports and imports. At depth 1, the
+// default, a change re-resolves the files referencing or re-exporting
+// symbols it removed or changed, the importers of a package whose symbols
+// were added or removed, and every dependent of a file that was deleted
+// and re-inserted. Each further level also re-resolves the dependents of
+// those files, for resolution that looks through more than one file (such
+// as inferred types). depth <= 0 keeps the default.
+func WithBlastRadiusDepth(depth int) Option {
+	return func(e *Engine) {
+		if depth > 0 {
+			e.blastDepth = depth
+		}
+	}
+}
+
+// WithIncrementalParse keeps the parse trees of the last entries indexed
+// files (entries <= 0 uses runtime.DefaultTreeCacheEntries). When one of
+// them is re-indexed, tree-sitter reparses it incrementally from the
+// previous tree instead of from scratch. Worth enabling for long-running
+// processes that re-index the same files repeatedly, such as Watch.
+func WithIncrementalParse(entries int) Option {
+	return func(e *Engine) {
+		e.trees = runtime.NewTreeCache(entries)
+	}
+}
+
+// WithPartialReextraction sets the size, in lines, from which an already
+// indexed file that changed is patched in place rather than deleted and
+// re-inserted: the new extraction is diffed against the stored rows by
+// top-level declaration and only the declarations that changed are
+// rewritten (see store.Store.PatchFile). Untouched symbols keep their IDs,
+// so fewer dependent files land in the blast radius. Patching is off by
+// default; minLines <= 0 disables it. A threshold around 1000 lines keeps
+// it to the files where rewriting every row costs the most.
+func WithPartialReextraction(minLines int) Option {
+	return func(e *Engine) {
+		e.patchMinLines = minLines
+	}
+}
+
+// WithMemoryLimit bounds the memory the parallel pipeline spends on files
+// in flight to roughly bytes. Each file reserves an estimate of its peak
+// footprint (source, parse tree and buffered rows) before it is read,
+// shrinks the reservation to its buffered rows once extracted, and frees it
+// once committed; readers block while the budget is exhausted, and the
+// writer commits early when pending batches hold half of it. Files are
+// scheduled largest-first so the big ones don't straggle at the end. A
+// file larger than the whole budget is extracted on its own. bytes <= 0
+// (the default) disables the limit.
+func WithMemoryLimit(bytes int64) Option {
+	return func(e *Engine) {
+		e.memoryLimit = bytes
+	}
+}
+
+// WithIncludePaths sets the include search directories, in search order,
+// against which C and C++ #include directives are resolved to indexed files
+// (see store.Store.RefreshIncludeGraph); CompileCommandsIncludePaths reads
+// them from a compile_commands.json. Includes are always looked up next to
+// the including file first. A change to a header re-resolves every
+// translation unit including it, directly or through other headers.
+func WithIncludePaths(dirs ...string) Option {
+	return func(e *Engine) {
+		e.includePaths = make([]string, len(dirs))
+		for i, dir := range dirs {
+			e.includePaths[i] = filepath.Clean(dir)
+		}
+	}
+}
+
 // WithScriptsFS configures the Engine to load Risor scripts from the given
 // filesystem instead of from the scriptsDir path on disk. This enables
 // embedding scripts via go:embed. When set, scriptsDir is ignored for
@@ -67,6 +254,48 @@ func WithScriptsFS(fsys fs.FS) Option {
 	}
 }
 
+// WithBulkLoad rebuilds the database from scratch (see store.WithBulkLoad).
+// Extraction writes into a fresh build database next to dbPath, without
+// secondary indexes, fsyncs or foreign key checks; the first Resolve
+// builds the indexes, resolves every file and then publishes the build
+// over dbPath. Until then the previous database stays in place, and
+// closing the Engine before Resolve completes discards the build.
+func WithBulkLoad() Option {
+	return func(e *Engine) {
+		e.bulkLoad = true
+	}
+}
+
+// WithCompactReferences stores references in compact per-file blocks
+// (see store.WithCompactReferences): a fraction of the space of one row per
+// reference, at the cost of decoding a file's block whenever one of its
+// references is read. Queries answer the same either way. The mode is
+// recorded in the database, so later Engines on it, bulk rebuilds
+// included, keep it without the option.
+func WithCompactReferences() Option {
+	return func(e *Engine) {
+		e.compactRefs = true
+	}
+}
+
+// WithStats makes the Engine time every phase of indexing and resolution,
+// per file and per language, and count the host functions scripts call
+// (see Stats). It costs a few clock reads per file and per host call.
+func WithStats() Option {
+	return func(e *Engine) {
+		e.stats = newStatsRecorder()
+	}
+}
+
+// WithProfileLabels tags the goroutines doing each phase with the pprof
+// labels "phase" (extract, commit, resolve) and "language", so a CPU
+// profile taken while indexing can be broken down by them.
+func WithProfileLabels(enabled bool) Option {
+	return func(e *Engine) {
+		e.profileLabels = enabled
+	}
+}
+
 // New creates an Engine backed by a SQLite database at dbPath.
 // Script loading priority:
 //  1. If WithScriptsFS is set, use the provided fs.FS
@@ -74,31 +303,54 @@ func WithScriptsFS(fsys fs.FS) Option {
 //
 // The scriptsDir parameter may be empty when WithScriptsFS is used.
 func New(dbPath string, scriptsDir string, opts ...Option) (*Engine, error) {
-	s, err := store.NewStore(dbPath)
-	if err != nil {
-		return nil, fmt.Errorf("canopy: create store: %w", err)
-	}
-	if err := s.Migrate(); err != nil {
-		s.Close()
-		return nil, fmt.Errorf("canopy: migrate: %w", err)
-	}
-
 	// Apply options to a temporary Engine to collect configuration before
-	// creating the Runtime, since the Runtime needs to know about fs.FS.
+	// creating the Store and Runtime, since they need to know about bulk
+	// loading and fs.FS.
 	e := &Engine{
-		store:       s,
 		scriptsDir:  scriptsDir,
 		useParallel: true, // default to parallel extraction
+
+		commitBatchSize: defaultCommitBatchSize,
+		commitInterval:  defaultCommitInterval,
+
+		resolveWorkers:  defaultResolveWorkers(),
+		resolveShardMin: defaultResolveShardMin,
+
+		blastDepth:      defaultBlastDepth,
+		resolutionCache: true,
 	}
 	for _, opt := range opts {
 		opt(e)
 	}
 
+	var storeOpts []store.StoreOption
+	if e.bulkLoad {
+		storeOpts = append(storeOpts, store.WithBulkLoad())
+	}
+	if e.compactRefs {
+		storeOpts = append(storeOpts, store.WithCompactReferences())
+	}
+	s, err := store.NewStore(dbPath, storeOpts...)
+	if err != nil {
+		return nil, fmt.Errorf("canopy: create store: %w", err)
+	}
+	if err := s.Migrate(); err != nil {
+		s.Close()
+		return nil, fmt.Errorf("canopy: migrate: %w", err)
+	}
+	e.store = s
+
 	// Build Runtime with the appropriate script source.
 	var rtOpts []runtime.RuntimeOption
 	if e.scriptsFS != nil {
 		rtOpts = append(rtOpts, runtime.WithRuntimeFS(e.scriptsFS))
 	}
+	if e.trees != nil {
+		rtOpts = append(rtOpts, runtime.WithTreeCache(e.trees))
+	}
+	if e.stats != nil {
+		rtOpts = append(rtOpts, runtime.WithCallStats(e.stats.calls))
+	}
 	e.runtime = runtime.NewRuntime(s, scriptsDir, rtOpts...)
 
 	return e, nil
@@ -189,8 +441,10 @@ type capturedSymbol struct {
 	SignatureHash string
 }
 
-// captureSymbols captures the current symbols for a file, including their computed
-// signature hashes.
+// captureSymbols captures the current symbols for a file with their
+// signature hashes, as stored when the symbols were committed: one query
+// per file. Rows stored without one (by a serial bulk load, or an older
+// version of canopy) are hashed from their child rows instead.
 func (e *Engine) captureSymbols(fileID int64) ([]capturedSymbol, error) {
 	syms, err := e.store.SymbolsByFile(fileID)
 	if err != nil {
@@ -198,23 +452,17 @@ func (e *Engine) captureSymbols(fileID int64) ([]capturedSymbol, error) {
 	}
 
 	var captured []capturedSymbol
+	var computed map[int64]string
 	for _, sym := range syms {
-		members, err := e.store.TypeMembers(sym.ID)
-		if err != nil {
-			return nil, err
-		}
-		params, err := e.store.FunctionParams(sym.ID)
-		if err != nil {
-			return nil, err
-		}
-		typeParams, err := e.store.TypeParams(sym.ID)
-		if err != nil {
-			return nil, err
+		hash := sym.SignatureHash
+		if hash == "" {
+			if computed == nil {
+				if computed, err = e.store.SignatureHashes(fileID); err != nil {
+					return nil, err
+				}
+			}
+			hash = computed[sym.ID]
 		}
-		hash := store.ComputeSignatureHash(
-			sym.Name, sym.Kind, sym.Visibility, sym.Modifiers,
-			members, params, typeParams,
-		)
 
 		var parentID int64
 		if sym.ParentSymbolID != nil {
@@ -257,15 +505,42 @@ func (e *Engine) IndexFiles(ctx context.Context, paths []string) error {
 
 func (e *Engine) indexFilesSerial(ctx context.Context, paths []string) error {
 	// Initialize blast radius so Resolve() can distinguish "no changes"
-	// (non-nil empty map) from "first run" (nil).
-	if e.blastRadius == nil {
+	// (non-nil empty map) from "first run" (nil). A bulk load is always
+	// resolved in full.
+	if e.blastRadius == nil && !e.store.Bulk() {
 		e.blastRadius = make(map[int64]bool)
 	}
 	var errs []error
+	var changes []blastChange
+	var restats []store.FileStat
 	for _, path := range paths {
-		if err := e.indexFile(ctx, path); err != nil {
+		start := time.Now()
+		chk, skip, err := e.checkFile(path)
+		e.stats.phase("check", start)
+		if err == nil && skip {
+			// Unsupported, filtered out, or unchanged.
+			if chk.restat != nil {
+				restats = append(restats, *chk.restat)
+			}
+			continue
+		}
+		var change *blastChange
+		if err == nil {
+			change, err = e.indexFile(ctx, chk)
+		}
+		if err != nil {
 			errs = append(errs, fmt.Errorf("index %s: %w", path, err))
+			continue
 		}
+		if change != nil {
+			changes = append(changes, *change)
+		}
+	}
+	if err := e.store.UpdateFileStats(restats, time.Now()); err != nil {
+		errs = append(errs, err)
+	}
+	if err := e.expandBlastRadius(changes); err != nil {
+		errs = append(errs, err)
 	}
 	if len(errs) > 0 {
 		return fmt.Errorf("indexing had %d error(s): %w", len(errs), errs[0])
@@ -273,94 +548,139 @@ func (e *Engine) indexFilesSerial(ctx context.Context, paths []string) error {
 	return nil
 }
 
-func (e *Engine) indexFile(ctx context.Context, path string) error {
-	lang, ok := runtime.LanguageForFile(path)
-	if !ok {
-		return nil // unsupported extension
-	}
-	if e.languages != nil && !e.languages[lang] {
-		return nil // filtered out
-	}
-
-	content, err := os.ReadFile(path)
-	if err != nil {
-		return fmt.Errorf("read file: %w", err)
-	}
-	hash := fmt.Sprintf("%x", sha256.Sum256(content))
-
-	existing, err := e.store.FileByPath(path)
-	if err != nil {
-		return fmt.Errorf("lookup file: %w", err)
-	}
-	if existing != nil && existing.Hash == hash {
-		return nil // unchanged
-	}
+// indexFile indexes one changed file, as found by checkFile, and returns
+// the change to fold into the blast radius, or nil when the file was
+// skipped.
+func (e *Engine) indexFile(ctx context.Context, chk fileCheck) (*blastChange, error) {
+	path, existing := chk.path, chk.existing
+	var err error
 
 	// Step 1: Capture old symbols before deletion (for blast radius).
-	var oldSymbols []capturedSymbol
+	change := &blastChange{}
 	if existing != nil {
-		oldSymbols, err = e.captureSymbols(existing.ID)
+		change.oldSymbols, err = e.captureSymbols(existing.ID)
 		if err != nil {
-			return fmt.Errorf("capture old symbols: %w", err)
+			return nil, fmt.Errorf("capture old symbols: %w", err)
 		}
 	}
 
-	// Step 2: Clean up old data if the file was previously indexed.
-	if existing != nil {
-		if err := e.store.DeleteFileData(existing.ID); err != nil {
-			return fmt.Errorf("delete old data: %w", err)
+	if e.patchable(chk) {
+		// Steps 2–3 for large files: extract into a buffer and patch the
+		// stored rows in place, keeping unchanged declarations' IDs.
+		item := e.patchItem(chk)
+		rt := e.newExtractionRuntime()
+		start := time.Now()
+		timedOut, err := e.withDeadline(ctx, 1, func(ctx context.Context) error {
+			return e.extractFile(ctx, rt, item)
+		})
+		e.stats.phase("extract", start)
+		script := time.Since(start) - rt.ParseTime()
+		if timedOut {
+			// The stored rows are untouched.
+			return nil, e.recordTimeout(path, chk.hash, "extract")
 		}
-		if _, err := e.store.DB().Exec("DELETE FROM files WHERE id = ?", existing.ID); err != nil {
-			return fmt.Errorf("delete file record: %w", err)
+		if err != nil {
+			return nil, err
+		}
+		start = time.Now()
+		res, err := e.store.PatchFile(item.patch, item.batch.Rows())
+		e.stats.phase("commit", start)
+		e.stats.file(path, chk.lang, rt.ParseTime(), script, time.Since(start))
+		if err != nil {
+			return nil, err
+		}
+		change.fileID, change.referencing = item.fileID, res.ReferencingFiles
+	} else {
+		// Step 2: Clean up old data and the file record if previously indexed.
+		if existing != nil {
+			if err := e.store.DeleteFiles([]int64{existing.ID}); err != nil {
+				return nil, fmt.Errorf("delete old data: %w", err)
+			}
+			change.replacedID = existing.ID
 		}
-	}
 
-	// Step 3: Insert new file record and run extraction.
-	lineCount := bytes.Count(content, []byte{'\n'}) + 1
-	fileID, err := e.store.InsertFile(&store.File{
-		Path:        path,
-		Language:    lang,
-		Hash:        hash,
-		LineCount:   lineCount,
-		LastIndexed: time.Now(),
-	})
-	if err != nil {
-		return fmt.Errorf("insert file: %w", err)
-	}
+		// Step 3: Insert new file record and run extraction.
+		change.fileID, err = e.store.InsertFile(chk.fileRecord())
+		if err != nil {
+			return nil, fmt.Errorf("insert file: %w", err)
+		}
 
-	scriptPath := runtime.ExtractionScriptPath(lang)
-	extras := map[string]any{
-		"file_path": path,
-		"file_id":   fileID,
-	}
-	if err := e.runtime.RunScript(ctx, scriptPath, extras); err != nil {
-		return fmt.Errorf("extraction script: %w", err)
+		scriptPath := runtime.ExtractionScriptPath(chk.lang)
+		extras := map[string]any{
+			"file_path": path,
+			"file_id":   change.fileID,
+		}
+		// Rows are written as the script runs, so commit time is part of
+		// script time here.
+		start, parsed := time.Now(), e.runtime.ParseTime()
+		timedOut, err := e.withDeadline(ctx, 1, func(ctx context.Context) error {
+			return e.runtime.RunScript(ctx, scriptPath, extras)
+		})
+		e.stats.phase("extract", start)
+		parse := e.runtime.ParseTime() - parsed
+		e.stats.file(path, chk.lang, parse, time.Since(start)-parse, 0)
+		if timedOut {
+			// The old rows are gone, so the change still counts; the rows
+			// written before the deadline stay, as after a script error.
+			if err := e.recordTimeout(path, chk.hash, "extract"); err != nil {
+				return nil, err
+			}
+		} else if err != nil {
+			return nil, fmt.Errorf("extraction script: %w", err)
+		}
+		// The script wrote straight to SQLite, so the signature hashes
+		// CommitBatch would have stored, and the reference blocks it would
+		// have packed, are filled in now. A bulk load leaves the hashes to
+		// captureSymbols, which would otherwise scan the unindexed symbols
+		// table per file, and its references in rows.
+		if !e.store.Bulk() {
+			if err := e.store.UpdateSignatureHashes(change.fileID); err != nil {
+				return nil, err
+			}
+			if err := e.store.CompactReferences([]int64{change.fileID}); err != nil {
+				return nil, err
+			}
+		}
 	}
 
-	// Step 4: Capture new symbols and compute blast radius.
-	newSymbols, err := e.captureSymbols(fileID)
+	// Step 4: Capture new symbols; the blast radius is computed once for
+	// the whole batch.
+	if e.store.Bulk() {
+		return change, nil
+	}
+	change.newSymbols, err = e.captureSymbols(change.fileID)
 	if err != nil {
-		return fmt.Errorf("capture new symbols: %w", err)
+		return nil, fmt.Errorf("capture new symbols: %w", err)
 	}
+	return change, nil
+}
 
-	blastFileIDs := e.computeBlastRadius(fileID, oldSymbols, newSymbols)
-
-	// Add to accumulated blast radius.
-	if e.blastRadius == nil {
-		e.blastRadius = make(map[int64]bool)
-	}
-	for _, fid := range blastFileIDs {
-		e.blastRadius[fid] = true
-	}
+// blastChange is one indexed or removed file, as input to the blast radius.
+type blastChange struct {
+	// fileID is the file's current ID, or its last ID if it was removed.
+	fileID int64
+	// replacedID is the ID of the file's previous version when it was
+	// deleted and re-inserted: resolution data pointing into it is gone, so
+	// its dependents come from the file dependency graph. 0 otherwise.
+	replacedID int64
+
+	oldSymbols, newSymbols []capturedSymbol
+	// referencing holds files found by a patch to reference symbols it
+	// deleted.
+	referencing []int64
+}
 
-	return nil
+// symbolDiff classifies a file's symbols across a change.
+type symbolDiff struct {
+	removed, changed []int64 // old symbol IDs
+	// pkg is the package the file declares when symbols were added or
+	// removed: files importing it need re-resolution too.
+	pkg string
 }
 
-// computeBlastRadius compares old vs new symbols and returns file IDs that need
-// re-resolution.
-func (e *Engine) computeBlastRadius(fileID int64, oldSyms, newSyms []capturedSymbol) []int64 {
-	// Always include the changed file itself.
-	result := map[int64]bool{fileID: true}
+// diffSymbols compares old vs new symbols by key and signature hash.
+func diffSymbols(oldSyms, newSyms []capturedSymbol) symbolDiff {
+	var d symbolDiff
 
 	// Build maps by key.
 	oldByKey := make(map[symbolKey]capturedSymbol, len(oldSyms))
@@ -373,21 +693,17 @@ func (e *Engine) computeBlastRadius(fileID int64, oldSyms, newSyms []capturedSym
 	}
 
 	// Classify symbols.
-	var removedIDs, changedOldIDs []int64
 	hasAdded := false
-	hasRemoved := false
-
 	for key, oldSym := range oldByKey {
 		if newSym, ok := newByKey[key]; ok {
 			if oldSym.SignatureHash != newSym.SignatureHash {
 				// Changed: signature differs.
-				changedOldIDs = append(changedOldIDs, oldSym.ID)
+				d.changed = append(d.changed, oldSym.ID)
 			}
 			// else: unchanged
 		} else {
 			// Removed: no matching new symbol.
-			removedIDs = append(removedIDs, oldSym.ID)
-			hasRemoved = true
+			d.removed = append(d.removed, oldSym.ID)
 		}
 	}
 	for key := range newByKey {
@@ -396,61 +712,119 @@ func (e *Engine) computeBlastRadius(fileID int64, oldSyms, newSyms []capturedSym
 		}
 	}
 
-	// Add files with resolved_references targeting removed/changed symbols.
-	affectedIDs := append(removedIDs, changedOldIDs...)
-	if len(affectedIDs) > 0 {
-		fileIDs, err := e.store.FilesReferencingSymbols(affectedIDs)
-		if err == nil {
-			for _, fid := range fileIDs {
-				result[fid] = true
-			}
-		}
-	}
-
-	// If symbols were added or removed, add files that import this file's module/package.
-	if hasAdded || hasRemoved {
-		// Find all imports that reference this file's package.
-		// We search by both the bare package name (for same-directory imports)
-		// and by import paths ending with the package name (for full paths).
+	if hasAdded || len(d.removed) > 0 {
 		for _, s := range newSyms {
 			if s.Key.Kind == "package" {
-				pkgName := s.Key.Name
-				// Direct match (bare name, e.g., tests or same-dir).
-				importers, err := e.store.FilesImportingSource(pkgName)
-				if err == nil {
-					for _, fid := range importers {
-						result[fid] = true
-					}
-				}
-				// Also match imports whose source ends with /pkgName.
-				rows, err := e.store.DB().Query(
-					`SELECT DISTINCT file_id FROM imports WHERE source LIKE ?`,
-					"%/"+pkgName,
-				)
-				if err == nil {
-					for rows.Next() {
-						var fid int64
-						if err := rows.Scan(&fid); err == nil {
-							result[fid] = true
-						}
-					}
-					rows.Close()
-				}
+				d.pkg = s.Key.Name
 				break
 			}
 		}
 	}
+	return d
+}
 
-	// Delete stale resolution data for removed symbols.
-	if len(removedIDs) > 0 {
-		_ = e.store.DeleteResolutionDataForSymbols(removedIDs)
+// expandBlastRadius adds the files needing re-resolution after changes to
+// the blast radius, with one lookup per kind of dependency for the whole
+// batch:
+//   - the changed files themselves and the files their patches found;
+//   - files referencing or re-exporting removed or changed symbols;
+//   - files importing a package whose symbols were added or removed;
+//   - every dependent of a file that was deleted and re-inserted;
+//   - every file including a changed header, transitively;
+//   - at depths past 1, the dependents of all of these, hop by hop.
+//
+// Stale resolution data for removed symbols is deleted afterwards. A bulk
+// load tracks no blast radius, since it resolves everything.
+func (e *Engine) expandBlastRadius(changes []blastChange) error {
+	if e.store.Bulk() {
+		return nil
+	}
+	defer e.stats.phase("blast_radius", time.Now())
+	if e.blastRadius == nil {
+		e.blastRadius = make(map[int64]bool)
+	}
+	if len(changes) == 0 {
+		return nil
+	}
+
+	direct := make(map[int64]bool)
+	var affectedIDs, removedIDs, replaced []int64
+	var pkgs []string
+	seenPkg := make(map[string]bool)
+	for _, c := range changes {
+		direct[c.fileID] = true
+		for _, fid := range c.referencing {
+			direct[fid] = true
+		}
+		if c.replacedID != 0 {
+			replaced = append(replaced, c.replacedID)
+		}
+		d := diffSymbols(c.oldSymbols, c.newSymbols)
+		affectedIDs = append(append(affectedIDs, d.removed...), d.changed...)
+		removedIDs = append(removedIDs, d.removed...)
+		if d.pkg != "" && !seenPkg[d.pkg] {
+			seenPkg[d.pkg] = true
+			pkgs = append(pkgs, d.pkg)
+		}
+	}
+
+	referencing, err := e.store.FilesReferencingSymbols(affectedIDs)
+	if err != nil {
+		return fmt.Errorf("blast radius: %w", err)
+	}
+	importers, err := e.store.FilesImportingPackages(pkgs)
+	if err != nil {
+		return fmt.Errorf("blast radius: %w", err)
+	}
+	for _, fid := range append(referencing, importers...) {
+		direct[fid] = true
+	}
+
+	// Every file including a changed header, directly or through other
+	// headers, is re-resolved: C and C++ resolution reads the symbols of
+	// everything a translation unit includes. Replaced headers are still
+	// known by their previous IDs.
+	ig, err := e.store.IncludeGraph()
+	if err != nil {
+		return fmt.Errorf("blast radius: %w", err)
+	}
+	headers := append(make([]int64, 0, len(replaced)+len(changes)), replaced...)
+	for _, c := range changes {
+		headers = append(headers, c.fileID)
+	}
+	for _, fid := range ig.Dependents(headers, math.MaxInt) {
+		direct[fid] = true
+	}
+
+	if len(replaced) > 0 || e.blastDepth > 1 {
+		g, err := e.store.FileGraph()
+		if err != nil {
+			return fmt.Errorf("blast radius: %w", err)
+		}
+		for _, fid := range g.Dependents(replaced, 1) {
+			direct[fid] = true
+		}
+		if e.blastDepth > 1 {
+			// Previous IDs of replaced files are still what the graph knows
+			// them by.
+			seeds := replaced
+			for fid := range direct {
+				seeds = append(seeds, fid)
+			}
+			for _, fid := range g.Dependents(seeds, e.blastDepth-1) {
+				direct[fid] = true
+			}
+		}
+	}
+	for fid := range direct {
+		e.blastRadius[fid] = true
 	}
 
-	var fileIDs []int64
-	for fid := range result {
-		fileIDs = append(fileIDs, fid)
+	// Delete stale resolution data for removed symbols.
+	if err := e.store.DeleteResolutionDataForSymbols(removedIDs); err != nil {
+		return fmt.Errorf("blast radius: %w", err)
 	}
-	return fileIDs
+	return nil
 }
 
 // skipDir returns true for directories that should be excluded from indexing.
@@ -469,18 +843,34 @@ var skipDirs = map[string]bool{
 // the files currently on disk under root. Files previously indexed under root
 // that no longer exist are removed along with their extraction/resolution data.
 func (e *Engine) IndexDirectory(ctx context.Context, root string) error {
-	paths, err := e.gitListFiles(root)
+	paths, err := e.listFiles(root)
 	if err != nil {
-		// Not a git repo or git not available — fall back to walk.
-		paths, err = e.walkListFiles(root)
-		if err != nil {
-			return err
-		}
+		return err
 	}
+	paths = e.shardFilter(root, paths)
 	if err := e.removeStaleFiles(root, paths); err != nil {
 		return fmt.Errorf("remove stale files: %w", err)
 	}
-	return e.IndexFiles(ctx, paths)
+	if err := e.IndexFiles(ctx, paths); err != nil {
+		return err
+	}
+	if e.shard != nil {
+		// A shard is merged rather than resolved; record the scripts it
+		// was extracted with for Merge to check.
+		e.storeScriptsHash()
+	}
+	return nil
+}
+
+// listFiles discovers the supported files under root, using git ls-files
+// when possible and a filesystem walk otherwise.
+func (e *Engine) listFiles(root string) ([]string, error) {
+	paths, err := e.gitListFiles(root)
+	if err != nil {
+		// Not a git repo or git not available — fall back to walk.
+		return e.walkListFiles(root)
+	}
+	return paths, nil
 }
 
 // removeStaleFiles removes database records for files that were previously
@@ -498,14 +888,10 @@ func (e *Engine) removeStaleFiles(root string, discoveredPaths []string) error {
 		return fmt.Errorf("list indexed files: %w", err)
 	}
 
-	// Initialize blast radius so Resolve() sees our deletions.
-	if e.blastRadius == nil {
-		e.blastRadius = make(map[int64]bool)
-	}
-
 	// Normalize root with trailing separator for safe prefix matching.
 	prefix := filepath.Clean(root) + string(filepath.Separator)
 
+	var stale []int64
 	for fileID, filePath := range indexed {
 		// Only consider files under this root.
 		if !strings.HasPrefix(filePath, prefix) {
@@ -514,20 +900,31 @@ func (e *Engine) removeStaleFiles(root string, discoveredPaths []string) error {
 		if discovered[filePath] {
 			continue // still exists on disk
 		}
+		stale = append(stale, fileID)
+	}
+	return e.removeFiles(stale)
+}
 
-		// File was indexed but no longer on disk — remove it.
+// removeFiles drops previously indexed files from the database. The blast
+// radius of each file is computed first, while its symbols still exist, so
+// Resolve() re-resolves files that referenced them.
+func (e *Engine) removeFiles(fileIDs []int64) error {
+	// Initialize blast radius so Resolve() sees our deletions.
+	if e.blastRadius == nil && !e.store.Bulk() {
+		e.blastRadius = make(map[int64]bool)
+	}
+	changes := make([]blastChange, 0, len(fileIDs))
+	for _, fileID := range fileIDs {
 		oldSymbols, _ := e.captureSymbols(fileID)
-		blastFileIDs := e.computeBlastRadius(fileID, oldSymbols, nil)
-		for _, fid := range blastFileIDs {
-			e.blastRadius[fid] = true
-		}
+		changes = append(changes, blastChange{fileID: fileID, oldSymbols: oldSymbols})
+	}
+	if err := e.expandBlastRadius(changes); err != nil {
+		return err
+	}
 
-		if err := e.store.DeleteFileData(fileID); err != nil {
-			return fmt.Errorf("delete stale file data %s: %w", filePath, err)
-		}
-		if _, err := e.store.DB().Exec("DELETE FROM files WHERE id = ?", fileID); err != nil {
-			return fmt.Errorf("delete stale file record %s: %w", filePath, err)
-		}
+	// Remove every file in one set-based transaction.
+	if err := e.store.DeleteFiles(fileIDs); err != nil {
+		return fmt.Errorf("delete %d stale file(s): %w", len(fileIDs), err)
 	}
 	return nil
 }
@@ -595,11 +992,22 @@ func (e *Engine) walkListFiles(root string) ([]string, error) {
 // the files needing resolution, while files_by_language continues to return
 // all files (needed for cross-file lookup caches).
 func (e *Engine) Resolve(ctx context.Context) error {
-	defer func() { e.blastRadius = nil }()
+	defer func() { e.blastRadius, e.fingerprints = nil, nil }()
+	if e.resolveAll {
+		e.blastRadius, e.resolveAll = nil, false
+	}
 
 	// Non-nil empty blast radius means no files changed — skip resolution.
+	// Removed files may still have left counts and package edges behind,
+	// which queries read as they are.
 	if e.blastRadius != nil && len(e.blastRadius) == 0 {
-		return nil
+		return e.refreshDerivedTables()
+	}
+
+	// A bulk load built the extraction tables without indexes; resolution
+	// needs them.
+	if err := e.store.BuildIndexes(); err != nil {
+		return err
 	}
 
 	langs, err := e.distinctLanguages()
@@ -608,12 +1016,17 @@ func (e *Engine) Resolve(ctx context.Context) error {
 	}
 
 	// Delete resolution data for affected files before re-running scripts.
+	var blastIDs []int64 // nil on full resolve
 	if e.blastRadius != nil {
 		// Incremental: only delete resolution data for blast radius files.
-		var blastIDs []int64
+		blastIDs = make([]int64, 0, len(e.blastRadius))
 		for fid := range e.blastRadius {
 			blastIDs = append(blastIDs, fid)
 		}
+		// Files whose resolution inputs are unchanged keep their data.
+		if blastIDs, err = e.fingerprintResolveSet(blastIDs, true); err != nil {
+			return fmt.Errorf("resolution fingerprints: %w", err)
+		}
 		if len(blastIDs) > 0 {
 			if err := e.store.DeleteResolutionDataForFiles(blastIDs); err != nil {
 				return fmt.Errorf("delete resolution data: %w", err)
@@ -621,6 +1034,7 @@ func (e *Engine) Resolve(ctx context.Context) error {
 		}
 	} else {
 		// Full resolve: delete all resolution data for every language.
+		var allIDs []int64
 		for _, lang := range langs {
 			langFiles, err := e.store.FilesByLanguage(lang)
 			if err != nil {
@@ -635,48 +1049,83 @@ func (e *Engine) Resolve(ctx context.Context) error {
 					return fmt.Errorf("delete resolution data for %s: %w", lang, err)
 				}
 			}
+			allIDs = append(allIDs, langFileIDs...)
+		}
+		if _, err := e.fingerprintResolveSet(allIDs, false); err != nil {
+			return fmt.Errorf("resolution fingerprints: %w", err)
 		}
 	}
 
-	// Pass files_to_resolve as an extra global. It filters FilesByLanguage
-	// to only files in the blast radius (or returns all files on full resolve).
-	extras := map[string]any{
-		"files_to_resolve": runtime.MakeFilesToResolveFn(e.store, e.blastRadius),
-	}
-
-	// Run resolution scripts in parallel (one per language).
-	var (
-		mu   sync.Mutex
-		wg   sync.WaitGroup
-		errs []error
-	)
-	for _, lang := range langs {
-		wg.Add(1)
-		go func(l string) {
-			defer wg.Done()
-			scriptPath := runtime.ResolutionScriptPath(l)
-			if err := e.runtime.RunScript(ctx, scriptPath, extras); err != nil {
-				mu.Lock()
-				errs = append(errs, fmt.Errorf("resolution script for %s: %w", l, err))
-				mu.Unlock()
-			}
-		}(lang)
-	}
-	wg.Wait()
+	// Run resolution scripts in parallel, sharded by file within each
+	// language. files_to_resolve returns each shard's slice of the blast
+	// radius (or of all files on full resolve).
+	errs := e.runResolution(ctx, langs)
 
 	if len(errs) > 0 {
 		return fmt.Errorf("resolution had %d error(s): %w", len(errs), errs[0])
 	}
 
+	// Bring symbol_stats and the package graph up to date with this pass.
+	refreshStart := time.Now()
+	if err := e.refreshDerivedTables(); err != nil {
+		return err
+	}
+	// The include graph follows the files whose #include lines, or the
+	// headers they name, changed.
+	if err := e.store.RefreshIncludeGraph(e.includePaths); err != nil {
+		return fmt.Errorf("refresh include graph: %w", err)
+	}
+	// And rewrite the file dependency edges of the re-resolved files, which
+	// the next blast radius walks.
+	if err := e.store.RefreshFileDependencies(blastIDs); err != nil {
+		return fmt.Errorf("refresh file dependencies: %w", err)
+	}
+	e.stats.phase("refresh", refreshStart)
+
 	// Store the current scripts hash so future runs can detect changes.
 	e.storeScriptsHash()
 
+	// Rebuild the persisted call graph index if call_graph changed: every
+	// write to it drops the index's stamp.
+	if err := e.store.RefreshCallGraphIndex(); err != nil {
+		return fmt.Errorf("refresh call graph index: %w", err)
+	}
+	if err := e.store.BumpIndexGeneration(); err != nil {
+		return fmt.Errorf("bump index generation: %w", err)
+	}
+
+	// A bulk load extracted sequentially left its references in rows (see
+	// indexFile); pack them now that resolution is done reading them.
+	if e.store.Bulk() {
+		if err := e.store.CompactRowReferences(); err != nil {
+			return err
+		}
+	}
+
+	// A bulk load is complete: move it over the database it replaces.
+	if err := e.store.Publish(); err != nil {
+		return fmt.Errorf("publish database: %w", err)
+	}
+	return nil
+}
+
+// refreshDerivedTables recounts references and call edges for the symbols
+// whose resolution data changed, so count-based queries don't have to, and
+// likewise patches the package graph for the files whose imports or
+// package declarations changed. Both are no-ops when nothing changed.
+func (e *Engine) refreshDerivedTables() error {
+	if err := e.store.RefreshSymbolStats(); err != nil {
+		return fmt.Errorf("refresh symbol stats: %w", err)
+	}
+	if err := e.store.RefreshPackageGraph(); err != nil {
+		return fmt.Errorf("refresh package graph: %w", err)
+	}
 	return nil
 }
 
 // distinctLanguages returns all languages that have at least one file in the Store.
 func (e *Engine) distinctLanguages() ([]string, error) {
-	rows, err := e.store.DB().Query("SELECT DISTINCT language FROM files")
+	rows, err := e.store.ReadDB().Query("SELECT DISTINCT language FROM files")
 	if err != nil {
 		return nil, err
 	}
@@ -2,11 +2,13 @@ package canopy
 
 import (
 	"bytes"
+	"cmp"
 	"context"
 	"crypto/sha256"
 	"fmt"
 	"os"
 	"runtime"
+	"slices"
 	"sync"
 	"time"
 
@@ -18,68 +20,318 @@ import (
 type workItem struct {
 	path   string
 	lang   string
+	hash   string
 	fileID int64
 	batch  *store.BatchedStore
 
-	// Pre-captured old symbols for blast radius computation after commit.
+	// File contents read during change detection, handed to the worker
+	// Runtime so the extraction script's parse() does not re-read the file.
+	// Cleared once extraction finishes.
+	content []byte
+
+	// Pre-captured old symbols for blast radius computation after commit,
+	// and the ID of the deleted previous version (0 if none, or patched).
 	oldSymbols []capturedSymbol
+	replacedID int64
+
+	// patch is the new files row of a file patched in place (see
+	// Engine.patchable); nil for files deleted and re-inserted. referencing
+	// holds the files that referenced symbols the patch deleted.
+	patch       *store.File
+	referencing []int64
+
+	// held is the item's reservation in the memory budget, if any.
+	held int64
+
+	// shared is the extraction of the item's content in this run, if its
+	// language is content-addressed (see sharedLanguages); leads is set on
+	// the item that runs the script, the others copy its rows.
+	shared *sharedExtraction
+	leads  bool
+
+	// parse and script are the time spent parsing the file and running the
+	// rest of its extraction (see WithStats).
+	parse, script time.Duration
+}
+
+// sharedLanguages are the languages whose extraction depends only on file
+// content, not on the path: the C and C++ scripts use the path only to
+// parse. Within a run, files of these languages with the same content are
+// extracted once and the rows copied to the other paths; vendored and
+// generated headers are often duplicated across many directories.
+var sharedLanguages = map[string]bool{"c": true, "cpp": true}
+
+// sharedExtraction is the extraction result for one content hash of a
+// sharedLanguages file. done is closed once the leading item's extraction
+// finished; until its batch is committed, the rows are read from the
+// batch, and from the store afterwards.
+type sharedExtraction struct {
+	done chan struct{}
+
+	mu     sync.Mutex
+	fileID int64
+	batch  *store.BatchedStore
+	rows   *store.FileRows // rows read from the store before the run
+	stored bool            // fileID's rows are committed
+}
+
+// extracted records the leading item's extraction; a nil batch means it
+// failed and followers run the script themselves.
+func (x *sharedExtraction) extracted(b *store.BatchedStore) {
+	x.mu.Lock()
+	x.batch = b
+	x.mu.Unlock()
+	close(x.done)
+}
+
+// committed drops the reference to the leading item's batch once the
+// writer is done with it, so buffered rows are not held for the whole run.
+func (x *sharedExtraction) committed(ok bool) {
+	x.mu.Lock()
+	x.batch, x.stored = nil, ok
+	x.mu.Unlock()
+}
+
+// source waits for the extraction and returns its rows and the file they
+// were extracted for; nil rows if there are none to share.
+func (x *sharedExtraction) source(s *store.Store) (*store.FileRows, int64, error) {
+	<-x.done
+	x.mu.Lock()
+	defer x.mu.Unlock()
+	switch {
+	case x.rows != nil:
+		return x.rows, x.fileID, nil
+	case x.batch != nil:
+		return x.batch.Rows(), x.fileID, nil
+	case x.stored:
+		rows, err := s.Rows(x.fileID)
+		return rows, x.fileID, err
+	}
+	return nil, 0, nil
 }
 
-// IndexFilesParallel indexes files using a three-phase parallel pipeline:
+// sharedKey identifies the content of a sharedLanguages file.
+func sharedKey(lang, hash string) string { return lang + "\x00" + hash }
+
+// fileCheck is the result of Phase A change detection for one path.
+type fileCheck struct {
+	path     string
+	lang     string
+	hash     string
+	lineLens []uint32
+	stat     fileStat
+	content  []byte
+	existing *store.File // nil for files not yet indexed
+	held     int64       // bytes reserved in the memory budget
+
+	// restat is set on a skipped file whose content is unchanged but whose
+	// stat tuple moved: the tuple to record so the next run can skip the
+	// read. The caller writes them in batches (see Store.UpdateFileStats).
+	restat *store.FileStat
+}
+
+// fileRecord returns the files row for a changed file.
+func (c fileCheck) fileRecord() *store.File {
+	return &store.File{
+		Path:        c.path,
+		Language:    c.lang,
+		Hash:        c.hash,
+		LineCount:   len(c.lineLens),
+		LastIndexed: time.Now(),
+		Size:        c.stat.size,
+		ModTime:     c.stat.modTime,
+		Inode:       c.stat.inode,
+		LineLengths: c.lineLens,
+	}
+}
+
+// IndexFilesParallel indexes files using a three-phase parallel pipeline.
+// The phases are streamed, so extraction starts as soon as the first
+// changed file is identified:
 //
-//	Phase A (serial):  Hash check, delete old data, prepare file records.
-//	Phase B (parallel): Parse and extract via worker pool (each with own Runtime).
-//	Phase C (serial):  Commit batches to SQLite, compute blast radius.
+//	Phase A (concurrent): Read and hash files and compare against the store
+//	                      with bounded parallelism; a single preparer then
+//	                      deletes old data and inserts file records in order.
+//	Phase B (parallel):   Parse and extract via worker pool (each with own Runtime).
+//	Phase C (serial):     Commit batches to SQLite in multi-file transactions;
+//	                      blast radius is computed concurrently from committed files.
 func (e *Engine) IndexFilesParallel(ctx context.Context, paths []string) error {
-	if e.blastRadius == nil {
+	// A bulk load tracks no blast radius; it is resolved in full.
+	bulk := e.store.Bulk()
+	if e.blastRadius == nil && !bulk {
 		e.blastRadius = make(map[int64]bool)
 	}
 
-	// ---- Phase A: Serial file preparation ----
-	var items []workItem
-	for _, path := range paths {
-		item, skip, err := e.prepareFile(ctx, path)
-		if err != nil {
-			return fmt.Errorf("prepare %s: %w", path, err)
-		}
-		if skip {
-			continue
-		}
-		items = append(items, item)
-	}
-
-	if len(items) == 0 {
+	paths = dedupePaths(paths)
+	if len(paths) == 0 {
 		return nil
 	}
+	numWorkers := max(1, min(runtime.NumCPU(), len(paths)))
+	// Workers publish each extracted file here, so cross-file lookups see
+	// files still waiting to be committed.
+	symtab := store.NewSymbolTable(e.store)
+	// Extractions of sharedLanguages contents, by sharedKey; only touched
+	// by the preparer.
+	shared := make(map[string]*sharedExtraction)
 
-	// ---- Phase B: Parallel extraction ----
-	numWorkers := min(runtime.NumCPU(), len(items))
-	if numWorkers < 1 {
-		numWorkers = 1
+	// With a memory limit, every file reserves its estimated footprint
+	// before being read (see WithMemoryLimit).
+	budget := newMemBudget(e.memoryLimit)
+	var sizes map[string]int64
+	if budget != nil {
+		paths, sizes = largestFirst(paths)
 	}
 
-	workCh := make(chan workItem, len(items))
-	for _, item := range items {
-		workCh <- item
+	// ---- Phase A: Concurrent change detection ----
+	pathCh := make(chan string, numWorkers)
+	go func() {
+		defer close(pathCh)
+		for _, path := range paths {
+			pathCh <- path
+		}
+	}()
+
+	type checkResult struct {
+		check fileCheck
+		err   error
 	}
-	close(workCh)
+	changedCh := make(chan checkResult, numWorkers)
+	var checkWG sync.WaitGroup
+	for range numWorkers {
+		checkWG.Add(1)
+		go func() {
+			defer checkWG.Done()
+			for path := range pathCh {
+				held := budget.acquire(sizes[path] * footprintPerSourceByte)
+				start := time.Now()
+				chk, skip, err := e.checkFile(path)
+				e.stats.phase("check", start)
+				if err != nil || skip {
+					budget.release(held)
+				}
+				if err != nil {
+					changedCh <- checkResult{check: fileCheck{path: path}, err: err}
+					continue
+				}
+				if !skip {
+					chk.held = held
+				}
+				if !skip || chk.restat != nil {
+					changedCh <- checkResult{check: chk}
+				}
+			}
+		}()
+	}
+	go func() {
+		checkWG.Wait()
+		close(changedCh)
+	}()
+
+	// Serialized preparation: the DB mutations (old data deletion and file
+	// record insertion) run on one goroutine, feeding workers as they go.
+	// Whatever changed files are already waiting are prepared together so
+	// their old data is removed in one set-based transaction. The new stat
+	// tuples of unchanged files are written in one transaction once every
+	// file is checked.
+	// prepErrs is only read after resultCh closes, which happens after
+	// workCh is closed by this goroutine.
+	workCh := make(chan workItem, numWorkers)
+	var prepErrs []error
+	go func() {
+		defer close(workCh)
+		var restats []store.FileStat
+		defer func() {
+			if err := e.store.UpdateFileStats(restats, time.Now()); err != nil {
+				prepErrs = append(prepErrs, err)
+			}
+		}()
+		for res := range changedCh {
+			pending := []checkResult{res}
+		drain:
+			for len(pending) < prepareGroupSize {
+				select {
+				case more, ok := <-changedCh:
+					if !ok {
+						break drain
+					}
+					pending = append(pending, more)
+				default:
+					break drain
+				}
+			}
 
+			var group []fileCheck
+			for _, r := range pending {
+				if r.err != nil {
+					prepErrs = append(prepErrs, fmt.Errorf("prepare %s: %w", r.check.path, r.err))
+					continue
+				}
+				if r.check.restat != nil {
+					restats = append(restats, *r.check.restat)
+					continue
+				}
+				group = append(group, r.check)
+			}
+			if len(group) == 0 {
+				continue
+			}
+			start := time.Now()
+			items, errs := e.prepareFiles(group, symtab, shared)
+			e.stats.phase("prepare", start)
+			prepErrs = append(prepErrs, errs...)
+			// Release the reservations of files that failed preparation.
+			var dropped int64
+			for _, chk := range group {
+				dropped += chk.held
+			}
+			for _, item := range items {
+				dropped -= item.held
+			}
+			budget.release(dropped)
+			for _, item := range items {
+				workCh <- item
+			}
+		}
+	}()
+
+	// ---- Phase B: Parallel extraction ----
 	type result struct {
-		item workItem
-		err  error
+		item     workItem
+		err      error
+		timedOut bool // err is the file timeout (see WithFileTimeout)
 	}
-	resultCh := make(chan result, len(items))
+	resultCh := make(chan result, numWorkers)
 
 	var wg sync.WaitGroup
 	for range numWorkers {
 		wg.Add(1)
 		go func() {
 			defer wg.Done()
-			// Each worker gets its own Runtime with a fresh sourceStore.
-			// The BatchedStore per item handles write isolation.
+			// Each worker keeps one Runtime for its lifetime, rebound to
+			// each item's BatchedStore (which handles write isolation) and
+			// reset between files.
+			rt := e.newExtractionRuntime()
 			for item := range workCh {
-				err := e.extractFile(ctx, item)
-				resultCh <- result{item: item, err: err}
+				start, parsed := time.Now(), rt.ParseTime()
+				var err error
+				var timedOut bool
+				e.labeled(ctx, "extract", item.lang, func(ctx context.Context) {
+					timedOut, err = e.withDeadline(ctx, 1, func(ctx context.Context) error {
+						return e.extractShared(ctx, rt, item)
+					})
+				})
+				item.parse = rt.ParseTime() - parsed
+				item.script = time.Since(start) - item.parse
+				e.stats.phase("extract", start)
+				if err == nil {
+					// The run's symbol table keeps a copy of the
+					// file's symbols until the run ends.
+					budget.pin(symtab.Publish(item.fileID, item.batch))
+				}
+				item.content = nil
+				// Source and tree are gone; only the buffered rows remain.
+				budget.shrink(&item.held, item.batch.SizeEstimate())
+				resultCh <- result{item: item, err: err, timedOut: timedOut}
 			}
 		}()
 	}
@@ -89,114 +341,517 @@ func (e *Engine) IndexFilesParallel(ctx context.Context, paths []string) error {
 		close(resultCh)
 	}()
 
-	// ---- Phase C: Serial commit ----
+	// ---- Phase C: Grouped commit, with blast radius off the critical path ----
+	// The writer groups finished batches into multi-file transactions while
+	// workers keep extracting. Committed items are handed to a separate
+	// goroutine that captures new symbols and computes blast radius, so the
+	// writer never waits on those reads.
+	committedCh := make(chan workItem, len(paths))
+	var blastErrs []error
+	blastDone := make(chan struct{})
+	go func() {
+		defer close(blastDone)
+		// The blast radius is expanded once every item is in, so each kind
+		// of dependency is looked up once for the whole batch.
+		var changes []blastChange
+		for item := range committedCh {
+			if bulk {
+				continue
+			}
+			newSymbols, err := e.captureSymbols(item.fileID)
+			if err != nil {
+				blastErrs = append(blastErrs, fmt.Errorf("capture new symbols %s: %w", item.path, err))
+				continue
+			}
+			changes = append(changes, blastChange{
+				fileID:      item.fileID,
+				replacedID:  item.replacedID,
+				oldSymbols:  item.oldSymbols,
+				newSymbols:  newSymbols,
+				referencing: item.referencing,
+			})
+		}
+		if err := e.expandBlastRadius(changes); err != nil {
+			blastErrs = append(blastErrs, err)
+		}
+	}()
+
 	var errs []error
-	for res := range resultCh {
-		if res.err != nil {
-			errs = append(errs, fmt.Errorf("extract %s: %w", res.item.path, res.err))
-			continue
+	var pending []workItem
+	var pendingHeld int64
+	flush := func() {
+		if len(pending) == 0 {
+			return
 		}
+		e.labeled(ctx, "commit", "", func(context.Context) {
+			errs = append(errs, e.commitGroup(pending, committedCh)...)
+		})
+		budget.release(pendingHeld)
+		pending, pendingHeld = nil, 0
+	}
+
+	ticker := time.NewTicker(e.commitInterval)
+	defer ticker.Stop()
+	for open := true; open; {
+		select {
+		case res, ok := <-resultCh:
+			if !ok {
+				open = false
+				continue
+			}
+			if res.err != nil {
+				e.stats.file(res.item.path, res.item.lang, res.item.parse, res.item.script, 0)
+				budget.release(res.item.held)
+				if !res.timedOut {
+					errs = append(errs, fmt.Errorf("extract %s: %w", res.item.path, res.err))
+					continue
+				}
+				if err := e.recordTimeout(res.item.path, res.item.hash, "extract"); err != nil {
+					errs = append(errs, fmt.Errorf("extract %s: %w", res.item.path, err))
+				}
+				// The file's old rows are gone unless it was to be
+				// patched, so its dependents still need re-resolving.
+				if res.item.patch == nil {
+					committedCh <- res.item
+				}
+				continue
+			}
+			pending = append(pending, res.item)
+			pendingHeld += res.item.held
+			// Commit early rather than let buffered rows starve readers
+			// of the memory budget.
+			if len(pending) >= e.commitBatchSize || (budget != nil && pendingHeld >= budget.limit/2) {
+				flush()
+			}
+		case <-ticker.C:
+			flush()
+		}
+	}
+	flush()
+
+	close(committedCh)
+	<-blastDone
+	errs = append(prepErrs, append(errs, blastErrs...)...)
 
-		if err := e.store.CommitBatch(res.item.batch); err != nil {
-			errs = append(errs, fmt.Errorf("commit %s: %w", res.item.path, err))
+	if len(errs) > 0 {
+		return fmt.Errorf("parallel indexing had %d error(s): %w", len(errs), errs[0])
+	}
+	return nil
+}
+
+// commitGroup commits a group of extracted files in one transaction and
+// sends each committed item to committed. If the group transaction fails,
+// it falls back to per-file commits so a single bad batch only fails itself.
+// Files patched in place get a transaction each.
+func (e *Engine) commitGroup(items []workItem, committed chan<- workItem) []error {
+	if e.stats != nil {
+		start := time.Now()
+		defer func(all []workItem) {
+			e.stats.phase("commit", start)
+			// Each file is charged an equal share of the transaction.
+			share := time.Since(start) / time.Duration(len(all))
+			for _, item := range all {
+				e.stats.file(item.path, item.lang, item.parse, item.script, share)
+			}
+		}(items)
+	}
+	var errs []error
+	inserts := items[:0:0]
+	for _, item := range items {
+		if item.patch == nil {
+			inserts = append(inserts, item)
 			continue
 		}
+		res, err := e.store.PatchFile(item.patch, item.batch.Rows())
+		item.shareCommitted(err == nil)
+		if err != nil {
+			errs = append(errs, fmt.Errorf("commit %s: %w", item.path, err))
+			continue
+		}
+		item.referencing = res.ReferencingFiles
+		committed <- item
+	}
+	items = inserts
+	if len(items) == 0 {
+		return errs
+	}
+
+	batches := make([]*store.BatchedStore, len(items))
+	for i, item := range items {
+		batches[i] = item.batch
+	}
+	if err := e.store.CommitBatches(batches); err == nil {
+		for _, item := range items {
+			item.shareCommitted(true)
+			committed <- item
+		}
+		return errs
+	}
 
-		// Capture new symbols and compute blast radius (now that data is committed).
-		newSymbols, err := e.captureSymbols(res.item.fileID)
+	for _, item := range items {
+		err := e.store.CommitBatch(item.batch)
+		item.shareCommitted(err == nil)
 		if err != nil {
-			errs = append(errs, fmt.Errorf("capture new symbols %s: %w", res.item.path, err))
+			errs = append(errs, fmt.Errorf("commit %s: %w", item.path, err))
 			continue
 		}
+		committed <- item
+	}
+	return errs
+}
+
+// shareCommitted tells the item's shared extraction, if it leads one, that
+// its batch was committed (ok) or failed to.
+func (item workItem) shareCommitted(ok bool) {
+	if item.leads {
+		item.shared.committed(ok)
+	}
+}
 
-		blastFileIDs := e.computeBlastRadius(res.item.fileID, res.item.oldSymbols, newSymbols)
-		for _, fid := range blastFileIDs {
-			e.blastRadius[fid] = true
+// largestFirst orders paths by descending file size, so the most expensive
+// files start first instead of straggling at the end, and returns the sizes
+// it saw. Files that cannot be stat'ed sort last with size 0; checkFile
+// reports their errors.
+func largestFirst(paths []string) ([]string, map[string]int64) {
+	sizes := make(map[string]int64, len(paths))
+	for _, p := range paths {
+		if fi, err := os.Stat(p); err == nil {
+			sizes[p] = fi.Size()
 		}
 	}
+	sorted := slices.Clone(paths)
+	slices.SortStableFunc(sorted, func(a, b string) int {
+		return cmp.Compare(sizes[b], sizes[a])
+	})
+	return sorted, sizes
+}
 
-	if len(errs) > 0 {
-		return fmt.Errorf("parallel indexing had %d error(s): %w", len(errs), errs[0])
+// dedupePaths drops repeated paths, preserving first-seen order. Concurrent
+// change detection would otherwise see the same stale record twice.
+func dedupePaths(paths []string) []string {
+	seen := make(map[string]bool, len(paths))
+	out := make([]string, 0, len(paths))
+	for _, path := range paths {
+		if seen[path] {
+			continue
+		}
+		seen[path] = true
+		out = append(out, path)
+	}
+	return out
+}
+
+// lineLengths returns the byte length of every '\n'-separated line of
+// content, excluding a trailing '\r', so position queries can validate
+// columns without reading the file again.
+func lineLengths(content []byte) []uint32 {
+	lens := make([]uint32, 0, bytes.Count(content, []byte{'\n'})+1)
+	for {
+		i := bytes.IndexByte(content, '\n')
+		line := content
+		if i >= 0 {
+			line = content[:i]
+		}
+		lens = append(lens, uint32(len(bytes.TrimRight(line, "\r"))))
+		if i < 0 {
+			return lens
+		}
+		content = content[i+1:]
 	}
-	return nil
 }
 
-// prepareFile does Phase A work for a single file: hash check, cleanup, file record.
-// Returns (item, skip, error). skip=true means the file is unchanged or unsupported.
-func (e *Engine) prepareFile(_ context.Context, path string) (workItem, bool, error) {
+// checkFile does the change-detection part of Phase A for a single file:
+// language filter, stat fast path, hash, and comparison with the stored
+// record. Safe to call concurrently, and writes nothing. Returns (check,
+// skip, error); skip=true means the file is unchanged or unsupported, and
+// an unchanged file whose stat tuple moved comes with check.restat set.
+func (e *Engine) checkFile(path string) (fileCheck, bool, error) {
 	lang, ok := canopyrt.LanguageForFile(path)
 	if !ok {
-		return workItem{}, true, nil
+		return fileCheck{}, true, nil
 	}
 	if e.languages != nil && !e.languages[lang] {
-		return workItem{}, true, nil
+		return fileCheck{}, true, nil
 	}
 
-	content, err := os.ReadFile(path)
+	// Stat before reading: a write that lands after the stat changes the
+	// mtime, so the next run re-hashes rather than trusting stale data.
+	st, err := statFile(path)
 	if err != nil {
-		return workItem{}, false, fmt.Errorf("read file: %w", err)
+		return fileCheck{}, false, fmt.Errorf("read file: %w", err)
 	}
-	hash := fmt.Sprintf("%x", sha256.Sum256(content))
 
 	existing, err := e.store.FileByPath(path)
 	if err != nil {
-		return workItem{}, false, fmt.Errorf("lookup file: %w", err)
+		return fileCheck{}, false, fmt.Errorf("lookup file: %w", err)
+	}
+	if !e.paranoid && st.unchangedSince(existing) {
+		return fileCheck{}, true, nil // unchanged per stat, not read
+	}
+
+	content, err := os.ReadFile(path)
+	if err != nil {
+		return fileCheck{}, false, fmt.Errorf("read file: %w", err)
 	}
+	hash := fmt.Sprintf("%x", sha256.Sum256(content))
+
 	if existing != nil && existing.Hash == hash {
-		return workItem{}, true, nil // unchanged
+		// Content is unchanged but the stat tuple moved (touch, checkout,
+		// or a row from before stat tracking). Hand it back for recording
+		// so the next run can skip the read.
+		if !st.sameAs(existing) || !st.unchangedSince(existing) {
+			restat := &store.FileStat{FileID: existing.ID, Size: st.size, ModTime: st.modTime, Inode: st.inode}
+			return fileCheck{path: path, restat: restat}, true, nil
+		}
+		return fileCheck{}, true, nil // unchanged
+	}
+	if skip, err := e.timedOutUnchanged(path, hash); err != nil {
+		return fileCheck{}, false, err
+	} else if skip {
+		return fileCheck{}, true, nil // timed out at this content before
 	}
 
+	return fileCheck{
+		path:     path,
+		lang:     lang,
+		hash:     hash,
+		lineLens: lineLengths(content),
+		stat:     st,
+		content:  content,
+		existing: existing,
+	}, false, nil
+}
+
+// prepareGroupSize caps how many changed files the preparer handles in one
+// deletion transaction.
+const prepareGroupSize = 256
+
+// prepareFiles does the mutating part of Phase A for a group of changed
+// files: capture old symbols, clean up old data for all of them at once,
+// and insert the new file records. The items' batches read through symtab,
+// which hides the stored rows of every file they replace. Items of
+// sharedLanguages join or lead the extraction of their content in shared.
+// Must be called from a single goroutine.
+func (e *Engine) prepareFiles(group []fileCheck, symtab *store.SymbolTable, shared map[string]*sharedExtraction) ([]workItem, []error) {
+	var errs []error
+
 	// Capture old symbols before deletion (for blast radius).
-	var oldSymbols []capturedSymbol
-	if existing != nil {
-		oldSymbols, err = e.captureSymbols(existing.ID)
+	oldSymbols := make([][]capturedSymbol, len(group))
+	var staleIDs []int64
+	kept := group[:0:0]
+	for _, chk := range group {
+		if chk.existing != nil {
+			syms, err := e.captureSymbols(chk.existing.ID)
+			if err != nil {
+				errs = append(errs, fmt.Errorf("prepare %s: capture old symbols: %w", chk.path, err))
+				continue
+			}
+			oldSymbols[len(kept)] = syms
+			if !e.patchable(chk) {
+				staleIDs = append(staleIDs, chk.existing.ID)
+			}
+		}
+		kept = append(kept, chk)
+	}
+
+	// Content already indexed under another path is copied from its stored
+	// rows, which are read before this group's deletions can remove them.
+	e.findStoredTwins(kept, shared)
+
+	// Clean up old data and file records. On failure only the previously
+	// indexed files are dropped; new files can still be prepared. Files
+	// patched in place keep their rows until the writer patches them.
+	deleteErr := e.store.DeleteFiles(staleIDs)
+
+	items := make([]workItem, 0, len(kept))
+	for i, chk := range kept {
+		if e.patchable(chk) {
+			item := e.patchItem(chk)
+			item.oldSymbols = oldSymbols[i]
+			item.held = chk.held
+			shareItem(&item, chk, shared)
+			items = append(items, item)
+			continue
+		}
+		if chk.existing != nil && deleteErr != nil {
+			errs = append(errs, fmt.Errorf("prepare %s: delete old data: %w", chk.path, deleteErr))
+			continue
+		}
+		// Insert new file record (real ID assigned by SQLite).
+		fileID, err := e.store.InsertFile(chk.fileRecord())
 		if err != nil {
-			return workItem{}, false, fmt.Errorf("capture old symbols: %w", err)
+			errs = append(errs, fmt.Errorf("prepare %s: insert file: %w", chk.path, err))
+			continue
+		}
+		item := workItem{
+			path:       chk.path,
+			lang:       chk.lang,
+			hash:       chk.hash,
+			fileID:     fileID,
+			batch:      newFileBatch(e.store, chk),
+			content:    chk.content,
+			oldSymbols: oldSymbols[i],
+			held:       chk.held,
+		}
+		// The new record has no stored rows, so the batch need not look
+		// for any.
+		item.batch.ReplaceFile(fileID)
+		if chk.existing != nil {
+			item.replacedID = chk.existing.ID
 		}
+		shareItem(&item, chk, shared)
+		items = append(items, item)
+	}
+	for _, item := range items {
+		symtab.Hide(item.fileID, item.replacedID)
+		item.batch.UseSymbolTable(symtab)
 	}
+	return items, errs
+}
 
-	// Clean up old data.
-	if existing != nil {
-		if err := e.store.DeleteFileData(existing.ID); err != nil {
-			return workItem{}, false, fmt.Errorf("delete old data: %w", err)
+// findStoredTwins adds to shared the stored extraction of every
+// sharedLanguages content in group that is not yet in shared but already
+// indexed under another path. Bulk loads skip the lookup: they start from
+// an empty store.
+func (e *Engine) findStoredTwins(group []fileCheck, shared map[string]*sharedExtraction) {
+	if e.store.Bulk() {
+		return
+	}
+	for _, chk := range group {
+		key := sharedKey(chk.lang, chk.hash)
+		if !sharedLanguages[chk.lang] || shared[key] != nil {
+			continue
 		}
-		if _, err := e.store.DB().Exec("DELETE FROM files WHERE id = ?", existing.ID); err != nil {
-			return workItem{}, false, fmt.Errorf("delete file record: %w", err)
+		ids, err := e.store.FilesByHash(chk.lang, chk.hash)
+		if err != nil {
+			continue // extract it instead
+		}
+		for _, id := range ids {
+			if chk.existing != nil && id == chk.existing.ID {
+				continue
+			}
+			// A file whose extraction failed has a record but no scopes;
+			// every extracted C or C++ file has a file scope.
+			rows, err := e.store.Rows(id)
+			if err != nil || len(rows.Scopes) == 0 {
+				continue
+			}
+			x := &sharedExtraction{done: make(chan struct{}), fileID: id, rows: rows}
+			close(x.done)
+			shared[key] = x
+			break
 		}
 	}
+}
 
-	// Insert new file record (real ID assigned by SQLite).
-	lineCount := bytes.Count(content, []byte{'\n'}) + 1
-	fileID, err := e.store.InsertFile(&store.File{
-		Path:        path,
-		Language:    lang,
-		Hash:        hash,
-		LineCount:   lineCount,
-		LastIndexed: time.Now(),
-	})
-	if err != nil {
-		return workItem{}, false, fmt.Errorf("insert file: %w", err)
+// shareItem attaches item to the shared extraction of its content, making
+// it the leader if there is none yet.
+func shareItem(item *workItem, chk fileCheck, shared map[string]*sharedExtraction) {
+	if !sharedLanguages[chk.lang] {
+		return
 	}
+	key := sharedKey(chk.lang, chk.hash)
+	if x := shared[key]; x != nil {
+		item.shared = x
+		return
+	}
+	item.shared = &sharedExtraction{done: make(chan struct{}), fileID: item.fileID}
+	item.leads = true
+	shared[key] = item.shared
+}
+
+// newFileBatch returns the batch a worker extracts chk into, presized for
+// the file's line count.
+func newFileBatch(s *store.Store, chk fileCheck) *store.BatchedStore {
+	batch := store.NewBatchedStore(s)
+	batch.Reserve(len(chk.lineLens))
+	return batch
+}
+
+// patchable reports whether chk is re-indexed by patching its stored rows
+// in place rather than deleting and re-inserting them.
+func (e *Engine) patchable(chk fileCheck) bool {
+	return chk.existing != nil && e.patchMinLines > 0 &&
+		max(chk.existing.LineCount, len(chk.lineLens)) >= e.patchMinLines
+}
 
-	batch := store.NewBatchedStore(e.store)
+// patchItem returns the work item for a file patched in place: it keeps
+// its file ID, and its batch hides the stored rows being replaced.
+func (e *Engine) patchItem(chk fileCheck) workItem {
+	rec := chk.fileRecord()
+	rec.ID = chk.existing.ID
+	batch := newFileBatch(e.store, chk)
+	batch.ReplaceFile(rec.ID)
 	return workItem{
-		path:       path,
-		lang:       lang,
-		fileID:     fileID,
-		batch:      batch,
-		oldSymbols: oldSymbols,
-	}, false, nil
+		path:    chk.path,
+		lang:    chk.lang,
+		hash:    chk.hash,
+		fileID:  rec.ID,
+		batch:   batch,
+		content: chk.content,
+		patch:   rec,
+	}
 }
 
-// extractFile runs the extraction script for a single file using a BatchedStore.
-// Each call creates its own Runtime so tree-sitter parsing is goroutine-safe.
-func (e *Engine) extractFile(ctx context.Context, item workItem) error {
-	// Create a per-worker Runtime backed by the BatchedStore.
+// newExtractionRuntime creates a Runtime for extraction workers. It is not
+// bound to a store; extractFile binds it to each item's BatchedStore. Each
+// worker needs its own, so tree-sitter parsing stays goroutine-safe.
+func (e *Engine) newExtractionRuntime() *canopyrt.Runtime {
 	var rtOpts []canopyrt.RuntimeOption
 	if e.scriptsFS != nil {
 		rtOpts = append(rtOpts, canopyrt.WithRuntimeFS(e.scriptsFS))
 	}
-	rt := canopyrt.NewRuntime(item.batch, e.scriptsDir, rtOpts...)
+	if e.trees != nil {
+		rtOpts = append(rtOpts, canopyrt.WithTreeCache(e.trees))
+	}
+	if e.stats != nil {
+		rtOpts = append(rtOpts, canopyrt.WithCallStats(e.stats.calls))
+	}
+	return canopyrt.NewRuntime(nil, e.scriptsDir, rtOpts...)
+}
+
+// extractShared extracts item, copying the rows of its shared extraction
+// when another file with the same content was already extracted. Leaders
+// are queued before their followers, so a follower never waits on an item
+// queued behind it.
+func (e *Engine) extractShared(ctx context.Context, rt *canopyrt.Runtime, item workItem) error {
+	if item.shared == nil {
+		return e.extractFile(ctx, rt, item)
+	}
+	if item.leads {
+		err := e.extractFile(ctx, rt, item)
+		if err != nil {
+			item.shared.extracted(nil)
+		} else {
+			item.shared.extracted(item.batch)
+		}
+		return err
+	}
+	rows, from, err := item.shared.source(e.store)
+	if err != nil || rows == nil {
+		return e.extractFile(ctx, rt, item)
+	}
+	item.batch.CopyRows(rows, from, item.fileID)
+	e.sharedExtractions.Add(1)
+	return nil
+}
+
+// SharedExtractions returns how many files the parallel pipeline has
+// indexed by copying the extraction of an identical file rather than
+// running the extraction script (see sharedLanguages).
+func (e *Engine) SharedExtractions() int64 {
+	return e.sharedExtractions.Load()
+}
+
+// extractFile runs the extraction script for a single file on rt, writing
+// into the item's BatchedStore. rt is reset afterwards, dropping the file's
+// source and parse bookkeeping.
+func (e *Engine) extractFile(ctx context.Context, rt *canopyrt.Runtime, item workItem) error {
+	rt.Bind(item.batch)
+	defer rt.Reset()
+	if item.content != nil {
+		rt.PreloadSource(item.path, item.content)
+	}
 
 	scriptPath := canopyrt.ExtractionScriptPath(item.lang)
 	extras := map[string]any{
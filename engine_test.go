@@ -6,6 +6,8 @@ import (
 	"fmt"
 	"os"
 	"path/filepath"
+	"slices"
+	"strings"
 	"testing"
 	"time"
 
@@ -206,6 +208,244 @@ func TestResolve_NoFiles(t *testing.T) {
 	require.NoError(t, err)
 }
 
+func TestResolve_ShardedMatchesSingleShard(t *testing.T) {
+	dir := t.TempDir()
+	var paths []string
+	for i := range 6 {
+		src := fmt.Sprintf("package main\n\nfunc F%d() {\n\tF%d()\n}\n", i, (i+1)%6)
+		p := filepath.Join(dir, fmt.Sprintf("f%d.go", i))
+		require.NoError(t, os.WriteFile(p, []byte(src), 0644))
+		paths = append(paths, p)
+	}
+
+	counts := func(workers int) (refs, edges int) {
+		e, err := New(filepath.Join(t.TempDir(), "test.db"), "",
+			WithScriptsFS(os.DirFS("scripts")), WithResolveWorkers(workers))
+		require.NoError(t, err)
+		defer e.Close()
+		e.resolveShardMin = 1 // one file per shard
+
+		require.NoError(t, e.IndexFiles(context.Background(), paths))
+		require.NoError(t, e.Resolve(context.Background()))
+		require.NoError(t, e.store.DB().QueryRow("SELECT COUNT(*) FROM resolved_references").Scan(&refs))
+		require.NoError(t, e.store.DB().QueryRow("SELECT COUNT(*) FROM call_graph").Scan(&edges))
+		return refs, edges
+	}
+
+	refs1, edges1 := counts(1)
+	refsN, edgesN := counts(4)
+	assert.Positive(t, edges1)
+	assert.Equal(t, refs1, refsN)
+	assert.Equal(t, edges1, edgesN)
+}
+
+func TestResolve_ReresolvesDependentsOfReplacedFile(t *testing.T) {
+	dir := t.TempDir()
+	lib := filepath.Join(dir, "lib.go")
+	require.NoError(t, os.WriteFile(lib, []byte("package main\n\nfunc Helper() {}\n"), 0644))
+	user := filepath.Join(dir, "main.go")
+	require.NoError(t, os.WriteFile(user, []byte("package main\n\nfunc main() {\n\tHelper()\n}\n"), 0644))
+
+	e, err := New(filepath.Join(t.TempDir(), "test.db"), "", WithScriptsFS(os.DirFS("scripts")))
+	require.NoError(t, err)
+	defer e.Close()
+	ctx := context.Background()
+	resolvedToHelper := func() int {
+		var n int
+		require.NoError(t, e.store.DB().QueryRow(`SELECT COUNT(*) FROM resolved_references rr
+			JOIN symbols s ON s.id = rr.target_symbol_id WHERE s.name = 'Helper'`).Scan(&n))
+		return n
+	}
+
+	require.NoError(t, e.IndexFiles(ctx, []string{lib, user}))
+	require.NoError(t, e.Resolve(ctx))
+	require.Positive(t, resolvedToHelper())
+
+	// A body-only edit re-inserts lib.go under new symbol IDs, dropping the
+	// references into it; main.go is found through the file graph.
+	require.NoError(t, os.WriteFile(lib, []byte("package main\n\nfunc Helper() {\n\t_ = 1\n}\n"), 0644))
+	require.NoError(t, e.IndexFiles(ctx, []string{lib}))
+	userFile, err := e.store.FileByPath(user)
+	require.NoError(t, err)
+	assert.True(t, e.blastRadius[userFile.ID])
+	require.NoError(t, e.Resolve(ctx))
+	assert.Positive(t, resolvedToHelper())
+}
+
+func TestWithBlastRadiusDepth(t *testing.T) {
+	// c.go calls b.go, which calls a.go.
+	dir := t.TempDir()
+	var paths []string
+	for _, f := range []struct{ name, src string }{
+		{"a.go", "package main\n\nfunc A() {}\n"},
+		{"b.go", "package main\n\nfunc B() {\n\tA()\n}\n"},
+		{"c.go", "package main\n\nfunc C() {\n\tB()\n}\n"},
+	} {
+		p := filepath.Join(dir, f.name)
+		require.NoError(t, os.WriteFile(p, []byte(f.src), 0644))
+		paths = append(paths, p)
+	}
+
+	blast := func(depth int) map[string]bool {
+		e, err := New(filepath.Join(t.TempDir(), "test.db"), "",
+			WithScriptsFS(os.DirFS("scripts")), WithBlastRadiusDepth(depth))
+		require.NoError(t, err)
+		defer e.Close()
+		ctx := context.Background()
+		require.NoError(t, e.IndexFiles(ctx, paths))
+		require.NoError(t, e.Resolve(ctx))
+
+		// Removing a.go reaches b.go directly and c.go through b.go.
+		f, err := e.store.FileByPath(paths[0])
+		require.NoError(t, err)
+		require.NoError(t, e.removeFiles([]int64{f.ID}))
+		out := make(map[string]bool)
+		for _, p := range paths[1:] {
+			f, err := e.store.FileByPath(p)
+			require.NoError(t, err)
+			out[filepath.Base(p)] = e.blastRadius[f.ID]
+		}
+		return out
+	}
+
+	assert.Equal(t, map[string]bool{"b.go": true, "c.go": false}, blast(1))
+	assert.Equal(t, map[string]bool{"b.go": true, "c.go": true}, blast(2))
+}
+
+func TestResolutionCache_SkipsUnchangedDependents(t *testing.T) {
+	// c.go calls b.go, which calls a.go.
+	dir := t.TempDir()
+	var paths []string
+	for _, f := range []struct{ name, src string }{
+		{"a.go", "package main\n\nfunc A() {}\n"},
+		{"b.go", "package main\n\nfunc B() {\n\tA()\n}\n"},
+		{"c.go", "package main\n\nfunc C() {\n\tB()\n}\n"},
+	} {
+		p := filepath.Join(dir, f.name)
+		require.NoError(t, os.WriteFile(p, []byte(f.src), 0644))
+		paths = append(paths, p)
+	}
+
+	// markerKept reports whether c.go's resolution rows survived a body
+	// edit of a.go, which puts c.go in a depth-2 blast radius.
+	markerKept := func(cache bool) bool {
+		require.NoError(t, os.WriteFile(paths[0], []byte("package main\n\nfunc A() {}\n"), 0644))
+		e, err := New(filepath.Join(t.TempDir(), "test.db"), "",
+			WithScriptsFS(os.DirFS("scripts")), WithBlastRadiusDepth(2), WithResolutionCache(cache))
+		require.NoError(t, err)
+		defer e.Close()
+		ctx := context.Background()
+		require.NoError(t, e.IndexFiles(ctx, paths))
+		require.NoError(t, e.Resolve(ctx))
+
+		c, err := e.store.FileByPath(paths[2])
+		require.NoError(t, err)
+		_, err = e.store.DB().Exec(`UPDATE resolved_references SET confidence = 0.125
+			WHERE reference_id IN (SELECT id FROM references_ WHERE file_id = ?)`, c.ID)
+		require.NoError(t, err)
+
+		require.NoError(t, os.WriteFile(paths[0], []byte("package main\n\nfunc A() {\n\t_ = 1\n}\n"), 0644))
+		require.NoError(t, e.IndexFiles(ctx, paths[:1]))
+		require.True(t, e.blastRadius[c.ID])
+		require.NoError(t, e.Resolve(ctx))
+
+		// b.go lost its references into the old a.go and was resolved again.
+		var toA int
+		require.NoError(t, e.store.DB().QueryRow(`SELECT COUNT(*) FROM resolved_references rr
+			JOIN symbols s ON s.id = rr.target_symbol_id WHERE s.name = 'A'`).Scan(&toA))
+		assert.Positive(t, toA)
+
+		var marked int
+		require.NoError(t, e.store.DB().QueryRow(`SELECT COUNT(*) FROM resolved_references rr
+			JOIN references_ r ON r.id = rr.reference_id WHERE r.file_id = ? AND rr.confidence = 0.125`, c.ID).Scan(&marked))
+		return marked > 0
+	}
+
+	assert.True(t, markerKept(true), "c.go's inputs are unchanged, so it keeps its resolution")
+	assert.False(t, markerKept(false), "without the cache c.go is resolved again")
+}
+
+func TestBlastRadius_FollowsIncludeGraph(t *testing.T) {
+	dir := t.TempDir()
+	files := map[string]string{
+		"include/types.h": "typedef int count_t;\n",
+		"api.h":           "#include \"types.h\"\n\ncount_t total(void);\n",
+		"main.c":          "#include \"api.h\"\n\nint main(void) { return total(); }\n",
+		"other.c":         "int other(void) { return 0; }\n",
+	}
+	paths := make(map[string]string)
+	var all []string
+	for name, src := range files {
+		p := filepath.Join(dir, name)
+		require.NoError(t, os.MkdirAll(filepath.Dir(p), 0755))
+		require.NoError(t, os.WriteFile(p, []byte(src), 0644))
+		paths[name] = p
+		all = append(all, p)
+	}
+
+	e, err := New(filepath.Join(t.TempDir(), "test.db"), "",
+		WithScriptsFS(os.DirFS("scripts")), WithIncludePaths(filepath.Join(dir, "include")))
+	require.NoError(t, err)
+	defer e.Close()
+	ctx := context.Background()
+	require.NoError(t, e.IndexFiles(ctx, all))
+	require.NoError(t, e.Resolve(ctx))
+
+	// types.h is only found through the search path.
+	api, err := e.store.FileByPath(paths["api.h"])
+	require.NoError(t, err)
+	included, err := e.store.IncludedFiles(api.ID)
+	require.NoError(t, err)
+	require.Len(t, included, 1)
+
+	// A change to types.h reaches main.c through api.h, but not other.c.
+	require.NoError(t, os.WriteFile(paths["include/types.h"], []byte("typedef long count_t;\n"), 0644))
+	require.NoError(t, e.IndexFiles(ctx, []string{paths["include/types.h"]}))
+	out := make(map[string]bool)
+	for _, name := range []string{"api.h", "main.c", "other.c"} {
+		f, err := e.store.FileByPath(paths[name])
+		require.NoError(t, err)
+		out[name] = e.blastRadius[f.ID]
+	}
+	assert.Equal(t, map[string]bool{"api.h": true, "main.c": true, "other.c": false}, out)
+}
+
+func TestWithBulkLoad(t *testing.T) {
+	dir := t.TempDir()
+	var paths []string
+	for _, f := range []struct{ name, src string }{
+		{"a.go", "package main\n\nfunc A() {}\n"},
+		{"b.go", "package main\n\nfunc B() {\n\tA()\n}\n"},
+	} {
+		p := filepath.Join(dir, f.name)
+		require.NoError(t, os.WriteFile(p, []byte(f.src), 0644))
+		paths = append(paths, p)
+	}
+
+	dbPath := filepath.Join(t.TempDir(), "test.db")
+	e, err := New(dbPath, "", WithScriptsFS(os.DirFS("scripts")), WithBulkLoad())
+	require.NoError(t, err)
+	defer e.Close()
+	ctx := context.Background()
+	require.NoError(t, e.IndexFiles(ctx, paths))
+	assert.Nil(t, e.blastRadius, "a bulk load is resolved in full")
+	assert.NotEqual(t, dbPath, e.store.Path())
+
+	// Resolve builds the indexes, resolves and publishes the build.
+	require.NoError(t, e.Resolve(ctx))
+	assert.False(t, e.store.Bulk())
+	assert.Equal(t, dbPath, e.store.Path())
+	var resolved int
+	require.NoError(t, e.store.ReadDB().QueryRow("SELECT COUNT(*) FROM resolved_references").Scan(&resolved))
+	assert.Positive(t, resolved)
+
+	// Later runs are incremental against the published database.
+	require.NoError(t, os.WriteFile(paths[0], []byte("package main\n\nfunc A(n int) {}\n"), 0644))
+	require.NoError(t, e.IndexFiles(ctx, paths))
+	require.NotNil(t, e.blastRadius)
+	require.NoError(t, e.Resolve(ctx))
+}
+
 func TestDistinctLanguages(t *testing.T) {
 	e := newTestEngine(t)
 
@@ -317,6 +557,283 @@ var x = 1
 	require.NotNil(t, f)
 }
 
+func TestIndexFilesParallel_GroupedCommits(t *testing.T) {
+	// A group size smaller than the file count forces several multi-file
+	// transactions plus a final partial flush.
+	dbPath := filepath.Join(t.TempDir(), "test.db")
+	e, err := New(dbPath, "", WithScriptsFS(os.DirFS("scripts")), WithCommitBatching(3, 10*time.Millisecond))
+	require.NoError(t, err)
+	defer e.Close()
+
+	dir := t.TempDir()
+	var paths []string
+	for i := range 7 {
+		p := filepath.Join(dir, fmt.Sprintf("f%d.go", i))
+		require.NoError(t, os.WriteFile(p, []byte(fmt.Sprintf("package main\n\nfunc F%d() {}\n", i)), 0644))
+		paths = append(paths, p)
+	}
+
+	require.NoError(t, e.IndexFiles(context.Background(), paths))
+
+	for i, p := range paths {
+		f, err := e.store.FileByPath(p)
+		require.NoError(t, err)
+		require.NotNil(t, f)
+		syms, err := e.store.SymbolsByName(fmt.Sprintf("F%d", i))
+		require.NoError(t, err)
+		require.Len(t, syms, 1)
+		assert.Equal(t, f.ID, *syms[0].FileID)
+	}
+}
+
+func TestIndexFilesParallel_MemoryLimit(t *testing.T) {
+	// A budget smaller than any single file serializes extraction; every
+	// file must still be indexed and every reservation returned, or the
+	// second run would block forever.
+	dbPath := filepath.Join(t.TempDir(), "test.db")
+	e, err := New(dbPath, "", WithScriptsFS(os.DirFS("scripts")), WithMemoryLimit(64), WithCommitBatching(2, 10*time.Millisecond))
+	require.NoError(t, err)
+	defer e.Close()
+
+	dir := t.TempDir()
+	var paths []string
+	for i := range 5 {
+		p := filepath.Join(dir, fmt.Sprintf("f%d.go", i))
+		body := fmt.Sprintf("package main\n\nfunc F%d() {}\n", i) + strings.Repeat("// pad\n", i)
+		require.NoError(t, os.WriteFile(p, []byte(body), 0644))
+		paths = append(paths, p)
+	}
+
+	require.NoError(t, e.IndexFiles(context.Background(), paths))
+	require.NoError(t, os.WriteFile(paths[0], []byte("package main\n\nfunc G() {}\n"), 0644))
+	require.NoError(t, e.IndexFiles(context.Background(), paths))
+
+	for i := 1; i < len(paths); i++ {
+		syms, err := e.store.SymbolsByName(fmt.Sprintf("F%d", i))
+		require.NoError(t, err)
+		assert.Len(t, syms, 1)
+	}
+	syms, err := e.store.SymbolsByName("G")
+	require.NoError(t, err)
+	assert.Len(t, syms, 1)
+}
+
+func TestIndexFilesParallel_SharedHeaderExtraction(t *testing.T) {
+	dbPath := filepath.Join(t.TempDir(), "test.db")
+	e, err := New(dbPath, "", WithScriptsFS(os.DirFS("scripts")))
+	require.NoError(t, err)
+	defer e.Close()
+
+	// The same header vendored under three directories.
+	header := []byte("struct point { int x; int y; };\n\nint dist(struct point p) {\n\tint d = p.x;\n\treturn d;\n}\n")
+	dir := t.TempDir()
+	var paths []string
+	for _, sub := range []string{"a", "b", "c", "d"} {
+		p := filepath.Join(dir, sub, "point.h")
+		require.NoError(t, os.MkdirAll(filepath.Dir(p), 0755))
+		require.NoError(t, os.WriteFile(p, header, 0644))
+		paths = append(paths, p)
+	}
+
+	require.NoError(t, e.IndexFiles(context.Background(), paths[:3]))
+	assert.Equal(t, int64(2), e.SharedExtractions())
+	// A copy indexed later is copied from the stored rows.
+	require.NoError(t, e.IndexFiles(context.Background(), paths[3:]))
+	assert.Equal(t, int64(3), e.SharedExtractions())
+
+	want, err := e.store.Rows(mustFileID(t, e, paths[0]))
+	require.NoError(t, err)
+	require.NotEmpty(t, want.Scopes)
+	syms, err := e.store.SymbolsByName("dist")
+	require.NoError(t, err)
+	assert.Len(t, syms, len(paths), "one symbol per path")
+	for _, p := range paths[1:] {
+		fid := mustFileID(t, e, p)
+		got, err := e.store.Rows(fid)
+		require.NoError(t, err)
+		assert.Len(t, got.Symbols, len(want.Symbols), p)
+		assert.Len(t, got.Scopes, len(want.Scopes), p)
+		assert.Len(t, got.References, len(want.References), p)
+		own := make(map[int64]bool)
+		for _, sc := range got.Scopes {
+			own[sc.ID] = true
+		}
+		for _, ref := range got.References {
+			assert.Equal(t, fid, ref.FileID)
+			if ref.ScopeID != nil {
+				assert.True(t, own[*ref.ScopeID], "references point at the copy's scopes")
+			}
+		}
+	}
+}
+
+func mustFileID(t *testing.T, e *Engine, path string) int64 {
+	t.Helper()
+	f, err := e.store.FileByPath(path)
+	require.NoError(t, err)
+	require.NotNil(t, f)
+	return f.ID
+}
+
+func TestWithStats_RecordsPhasesAndFiles(t *testing.T) {
+	dbPath := filepath.Join(t.TempDir(), "test.db")
+	e, err := New(dbPath, "", WithScriptsFS(os.DirFS("scripts")), WithStats(), WithProfileLabels(true))
+	require.NoError(t, err)
+	defer e.Close()
+
+	dir := t.TempDir()
+	var paths []string
+	for i := range 3 {
+		p := filepath.Join(dir, fmt.Sprintf("f%d.go", i))
+		require.NoError(t, os.WriteFile(p, []byte(fmt.Sprintf("package main\n\nfunc F%d() {}\n", i)), 0644))
+		paths = append(paths, p)
+	}
+	ctx := context.Background()
+	require.NoError(t, e.IndexFiles(ctx, paths))
+	require.NoError(t, e.Resolve(ctx))
+
+	stats := e.Stats()
+	require.NotNil(t, stats)
+	for _, phase := range []string{"check", "prepare", "extract", "commit", "blast_radius", "resolve", "refresh"} {
+		assert.Positive(t, stats.Phases[phase].Count, phase)
+	}
+	assert.Equal(t, int64(3), stats.Phases["extract"].Count)
+	require.Contains(t, stats.Languages, "go")
+	goStats := stats.Languages["go"]
+	assert.Equal(t, 3, goStats.Files)
+	assert.Equal(t, int64(3), goStats.Parse.Count)
+	assert.Positive(t, goStats.Resolve.Count)
+	assert.Len(t, stats.Slowest, 3)
+	var parses int64
+	for _, c := range stats.HostCalls {
+		if c.Name == "parse" {
+			parses = c.Calls
+		}
+	}
+	assert.Equal(t, int64(3), parses)
+
+	plain := newTestEngine(t)
+	assert.Nil(t, plain.Stats())
+}
+
+func TestLargestFirst(t *testing.T) {
+	dir := t.TempDir()
+	small := filepath.Join(dir, "small.go")
+	big := filepath.Join(dir, "big.go")
+	require.NoError(t, os.WriteFile(small, []byte("x"), 0644))
+	require.NoError(t, os.WriteFile(big, []byte("xxxxxxxx"), 0644))
+	missing := filepath.Join(dir, "missing.go")
+
+	paths, sizes := largestFirst([]string{missing, small, big})
+	assert.Equal(t, []string{big, small, missing}, paths)
+	assert.Equal(t, int64(8), sizes[big])
+}
+
+func TestIndexFilesParallel_MixedChangedAndUnchanged(t *testing.T) {
+	dbPath := filepath.Join(t.TempDir(), "test.db")
+	e, err := New(dbPath, "", WithScriptsFS(os.DirFS("scripts")))
+	require.NoError(t, err)
+	defer e.Close()
+
+	dir := t.TempDir()
+	stable := filepath.Join(dir, "stable.go")
+	changing := filepath.Join(dir, "changing.go")
+	require.NoError(t, os.WriteFile(stable, []byte("package main\n\nfunc Stable() {}\n"), 0644))
+	require.NoError(t, os.WriteFile(changing, []byte("package main\n\nfunc Before() {}\n"), 0644))
+	require.NoError(t, e.IndexFiles(context.Background(), []string{stable, changing}))
+
+	before, err := e.store.FileByPath(stable)
+	require.NoError(t, err)
+
+	// Duplicate paths must not cause the changed file to be prepared twice.
+	require.NoError(t, os.WriteFile(changing, []byte("package main\n\nfunc After() {}\n"), 0644))
+	require.NoError(t, e.IndexFiles(context.Background(), []string{stable, changing, changing}))
+
+	after, err := e.store.FileByPath(stable)
+	require.NoError(t, err)
+	assert.Equal(t, before.ID, after.ID, "unchanged file should keep its record")
+
+	syms, err := e.store.SymbolsByName("After")
+	require.NoError(t, err)
+	assert.Len(t, syms, 1)
+	syms, err = e.store.SymbolsByName("Before")
+	require.NoError(t, err)
+	assert.Empty(t, syms)
+}
+
+func TestIndexFiles_StatFastPath(t *testing.T) {
+	for _, parallel := range []bool{false, true} {
+		t.Run(fmt.Sprintf("parallel=%v", parallel), func(t *testing.T) {
+			dbPath := filepath.Join(t.TempDir(), "test.db")
+			e, err := New(dbPath, "", WithScriptsFS(os.DirFS("scripts")), WithParallel(parallel))
+			require.NoError(t, err)
+			defer e.Close()
+
+			path := filepath.Join(t.TempDir(), "main.go")
+			old := time.Now().Add(-time.Hour)
+			require.NoError(t, os.WriteFile(path, []byte("package main\n\nfunc Aaaa() {}\n"), 0644))
+			require.NoError(t, os.Chtimes(path, old, old))
+			require.NoError(t, e.IndexFiles(context.Background(), []string{path}))
+
+			f, err := e.store.FileByPath(path)
+			require.NoError(t, err)
+			assert.Equal(t, old.UnixNano(), f.ModTime)
+			assert.NotZero(t, f.Size)
+
+			// Same size, same mtime, same inode: the content change is
+			// invisible to the stat fast path.
+			require.NoError(t, os.WriteFile(path, []byte("package main\n\nfunc Bbbb() {}\n"), 0644))
+			require.NoError(t, os.Chtimes(path, old, old))
+			require.NoError(t, e.IndexFiles(context.Background(), []string{path}))
+			syms, err := e.store.SymbolsByName("Aaaa")
+			require.NoError(t, err)
+			assert.Len(t, syms, 1, "stat-unchanged file should not be re-read")
+
+			// Paranoid mode always hashes and picks up the change.
+			WithParanoidHashing(true)(e)
+			require.NoError(t, e.IndexFiles(context.Background(), []string{path}))
+			syms, err = e.store.SymbolsByName("Bbbb")
+			require.NoError(t, err)
+			assert.Len(t, syms, 1)
+		})
+	}
+}
+
+func TestIndexFiles_RecordsTouchedFileStats(t *testing.T) {
+	for _, parallel := range []bool{false, true} {
+		t.Run(fmt.Sprintf("parallel=%v", parallel), func(t *testing.T) {
+			dbPath := filepath.Join(t.TempDir(), "test.db")
+			e, err := New(dbPath, "", WithScriptsFS(os.DirFS("scripts")), WithParallel(parallel))
+			require.NoError(t, err)
+			defer e.Close()
+
+			dir := t.TempDir()
+			var paths []string
+			for i := range 3 {
+				p := filepath.Join(dir, fmt.Sprintf("f%d.go", i))
+				require.NoError(t, os.WriteFile(p, []byte(fmt.Sprintf("package main\n\nfunc F%d() {}\n", i)), 0644))
+				paths = append(paths, p)
+			}
+			require.NoError(t, e.IndexFiles(context.Background(), paths))
+			before := mustFileID(t, e, paths[0])
+
+			// A checkout leaves the content alone but moves the mtimes: the
+			// files keep their rows and the new tuples are recorded.
+			touched := time.Now().Add(-time.Hour)
+			for _, p := range paths {
+				require.NoError(t, os.Chtimes(p, touched, touched))
+			}
+			require.NoError(t, e.IndexFiles(context.Background(), paths))
+			for _, p := range paths {
+				f, err := e.store.FileByPath(p)
+				require.NoError(t, err)
+				assert.Equal(t, touched.UnixNano(), f.ModTime, p)
+			}
+			assert.Equal(t, before, mustFileID(t, e, paths[0]))
+		})
+	}
+}
+
 func TestNewQueryBuilder(t *testing.T) {
 	dbPath := filepath.Join(t.TempDir(), "test.db")
 	s, err := store.NewStore(dbPath)
@@ -338,3 +855,143 @@ func TestNewQueryBuilder(t *testing.T) {
 	assert.Equal(t, 0, result.TotalCount)
 	assert.Empty(t, result.Items)
 }
+
+// indexSnapshot describes the index by file, name and position instead of
+// row IDs: every symbol, reference and resolved reference, and every call
+// edge. Two indexes of the same sources compare equal however their rows
+// were written.
+func indexSnapshot(t *testing.T, e *Engine) []string {
+	t.Helper()
+	files, err := e.store.AllFiles()
+	require.NoError(t, err)
+	symbol := func(id int64) string {
+		sym, err := e.store.SymbolByID(id)
+		require.NoError(t, err)
+		require.NotNil(t, sym, "symbol %d", id)
+		var path string
+		if sym.FileID != nil {
+			path = filepath.Base(files[*sym.FileID])
+		}
+		return fmt.Sprintf("%s:%s %s@%d:%d-%d:%d", path, sym.Kind, sym.Name,
+			sym.StartLine, sym.StartCol, sym.EndLine, sym.EndCol)
+	}
+
+	var out []string
+	for fid, path := range files {
+		syms, err := e.store.SymbolsByFile(fid)
+		require.NoError(t, err)
+		for _, sym := range syms {
+			out = append(out, "symbol "+symbol(sym.ID))
+		}
+		refs, err := e.store.ReferencesByFile(fid)
+		require.NoError(t, err)
+		for _, ref := range refs {
+			desc := fmt.Sprintf("%s:%s %s@%d:%d", filepath.Base(path), ref.Context, ref.Name, ref.StartLine, ref.StartCol)
+			out = append(out, "reference "+desc)
+			resolved, err := e.store.ResolvedReferencesByRef(ref.ID)
+			require.NoError(t, err)
+			for _, rr := range resolved {
+				out = append(out, fmt.Sprintf("resolved %s -> %s (%s %.2f)",
+					desc, symbol(rr.TargetSymbolID), rr.ResolutionKind, rr.Confidence))
+			}
+		}
+	}
+	edges, err := e.store.AllCallEdges()
+	require.NoError(t, err)
+	for _, edge := range edges {
+		out = append(out, fmt.Sprintf("call %s -> %s @%d:%d",
+			symbol(edge.CallerSymbolID), symbol(edge.CalleeSymbolID), edge.Line, edge.Col))
+	}
+	slices.Sort(out)
+	return out
+}
+
+func TestPartialReextraction_MatchesFullReextraction(t *testing.T) {
+	for _, parallel := range []bool{false, true} {
+		for _, compact := range []bool{false, true} {
+			for _, cache := range []bool{false, true} {
+				name := fmt.Sprintf("parallel=%v,compact=%v,cache=%v", parallel, compact, cache)
+				t.Run(name, func(t *testing.T) {
+					testPartialReextraction(t, parallel, compact, cache)
+				})
+			}
+		}
+	}
+}
+
+// testPartialReextraction indexes the same sources into an engine that
+// patches changed files and one that re-extracts them, and checks that a
+// body edit keeps the patched file's other symbols, shrinks the blast
+// radius, and leaves both indexes resolved alike.
+func testPartialReextraction(t *testing.T, parallel, compact, cache bool) {
+	dir := t.TempDir()
+	write := func(name, src string) string {
+		p := filepath.Join(dir, name)
+		require.NoError(t, os.WriteFile(p, []byte(src), 0644))
+		return p
+	}
+	lib := write("lib.go", "package main\n\nfunc A() int { return 1 }\n\nfunc B() int {\n\treturn A()\n}\n\nfunc C() int { return 3 }\n\nfunc D() int { return 4 }\n")
+	user := write("main.go", "package main\n\nfunc main() {\n\tA()\n\tB()\n\tC()\n}\n")
+	other := write("other.go", "package main\n\nfunc other() int {\n\treturn D()\n}\n")
+	paths := []string{lib, user, other}
+
+	open := func(patch bool) *Engine {
+		opts := []Option{WithScriptsFS(os.DirFS("scripts")), WithParallel(parallel), WithResolutionCache(cache)}
+		if patch {
+			opts = append(opts, WithPartialReextraction(1))
+		}
+		if compact {
+			opts = append(opts, WithCompactReferences())
+		}
+		e, err := New(filepath.Join(t.TempDir(), "test.db"), "", opts...)
+		require.NoError(t, err)
+		t.Cleanup(func() { e.Close() })
+		return e
+	}
+	patched, full := open(true), open(false)
+	ctx := context.Background()
+	for _, e := range []*Engine{patched, full} {
+		require.NoError(t, e.IndexFiles(ctx, paths))
+		require.NoError(t, e.Resolve(ctx))
+	}
+	require.Equal(t, indexSnapshot(t, full), indexSnapshot(t, patched))
+	libID, before := mustFileID(t, patched, lib), symbolIDsByName(t, patched, lib)
+
+	// B's body grows by a line, which pushes C and D down.
+	write("lib.go", "package main\n\nfunc A() int { return 1 }\n\nfunc B() int {\n\tn := A()\n\treturn n + 1\n}\n\nfunc C() int { return 3 }\n\nfunc D() int { return 4 }\n")
+	blast := func(e *Engine) map[string]bool {
+		require.NoError(t, e.IndexFiles(ctx, []string{lib}))
+		out := make(map[string]bool)
+		for _, p := range paths {
+			out[filepath.Base(p)] = e.blastRadius[mustFileID(t, e, p)]
+		}
+		return out
+	}
+	assert.Equal(t, map[string]bool{"lib.go": true, "main.go": true, "other.go": true}, blast(full))
+	assert.Equal(t, map[string]bool{"lib.go": true, "main.go": true, "other.go": false}, blast(patched),
+		"other.go only calls D, which kept its ID")
+
+	after := symbolIDsByName(t, patched, lib)
+	for _, name := range []string{"A", "C", "D"} {
+		assert.Equal(t, before[name], after[name], name)
+	}
+	assert.NotEqual(t, before["B"], after["B"])
+	assert.Equal(t, libID, mustFileID(t, patched, lib))
+
+	for _, e := range []*Engine{patched, full} {
+		require.NoError(t, e.Resolve(ctx))
+	}
+	assert.Equal(t, indexSnapshot(t, full), indexSnapshot(t, patched))
+}
+
+// symbolIDsByName maps the names of a file's symbols to their IDs.
+func symbolIDsByName(t *testing.T, e *Engine, path string) map[string]int64 {
+	t.Helper()
+	syms, err := e.store.SymbolsByFile(mustFileID(t, e, path))
+	require.NoError(t, err)
+	out := make(map[string]int64, len(syms))
+	for _, sym := range syms {
+		out[sym.Name] = sym.ID
+	}
+	return out
+}
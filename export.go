@@ -0,0 +1,196 @@
+package canopy
+
+import (
+	"archive/tar"
+	"compress/gzip"
+	"encoding/json"
+	"errors"
+	"fmt"
+	"io"
+	"os"
+	"path/filepath"
+	"time"
+
+	"github.com/jward/canopy/internal/store"
+)
+
+// SnapshotVersion is the format version of the index snapshots written by
+// ExportSnapshot. ImportSnapshot rejects snapshots of any other version.
+const SnapshotVersion = 1
+
+// A snapshot is a gzip-compressed tar of these two entries, in order.
+const (
+	snapshotManifestName = "manifest.json"
+	snapshotDBName       = "index.db"
+)
+
+// SnapshotManifest describes an index snapshot.
+type SnapshotManifest struct {
+	Version int `json:"version"`
+
+	// Commit identifies the indexed revision; empty when unknown.
+	Commit string `json:"commit,omitempty"`
+
+	// ScriptsHash is the hash of the scripts the index was built with
+	// (see ScriptsChanged).
+	ScriptsHash string `json:"scripts_hash"`
+
+	// Root is the directory the indexed paths were under; ImportSnapshot
+	// moves them under the directory it is given.
+	Root string `json:"root"`
+
+	Created time.Time `json:"created"`
+}
+
+// ExportSnapshot writes a portable snapshot of the Engine's index to w: a
+// manifest and a compacted copy of the database, compressed. root is the
+// directory the index was built from and commit the revision it was built
+// at (may be empty).
+func (e *Engine) ExportSnapshot(w io.Writer, root, commit string) (*SnapshotManifest, error) {
+	dir, err := os.MkdirTemp(filepath.Dir(e.store.Path()), ".snapshot-")
+	if err != nil {
+		return nil, fmt.Errorf("export snapshot: %w", err)
+	}
+	defer os.RemoveAll(dir)
+	dbCopy := filepath.Join(dir, snapshotDBName)
+	if err := e.store.Snapshot(dbCopy); err != nil {
+		return nil, fmt.Errorf("export snapshot: %w", err)
+	}
+	hash, err := e.store.GetMetadata("scripts_hash")
+	if err != nil {
+		return nil, fmt.Errorf("export snapshot: %w", err)
+	}
+
+	m := &SnapshotManifest{
+		Version:     SnapshotVersion,
+		Commit:      commit,
+		ScriptsHash: hash,
+		Root:        filepath.Clean(root),
+		Created:     time.Now().UTC().Truncate(time.Second),
+	}
+	if err := writeSnapshot(w, m, dbCopy); err != nil {
+		return nil, fmt.Errorf("export snapshot: %w", err)
+	}
+	return m, nil
+}
+
+func writeSnapshot(w io.Writer, m *SnapshotManifest, dbPath string) error {
+	manifest, err := json.MarshalIndent(m, "", "  ")
+	if err != nil {
+		return err
+	}
+	db, err := os.Open(dbPath)
+	if err != nil {
+		return err
+	}
+	defer db.Close()
+	info, err := db.Stat()
+	if err != nil {
+		return err
+	}
+
+	gz := gzip.NewWriter(w)
+	tw := tar.NewWriter(gz)
+	if err := tw.WriteHeader(&tar.Header{Name: snapshotManifestName, Mode: 0o644, Size: int64(len(manifest)), ModTime: m.Created}); err != nil {
+		return err
+	}
+	if _, err := tw.Write(manifest); err != nil {
+		return err
+	}
+	if err := tw.WriteHeader(&tar.Header{Name: snapshotDBName, Mode: 0o644, Size: info.Size(), ModTime: m.Created}); err != nil {
+		return err
+	}
+	if _, err := io.Copy(tw, db); err != nil {
+		return err
+	}
+	if err := tw.Close(); err != nil {
+		return err
+	}
+	return gz.Close()
+}
+
+// ImportSnapshot restores the snapshot read from r as the database at
+// dbPath, replacing any database there, and moves its indexed paths from
+// the snapshot's root to root (unless root is empty). No Engine may have
+// dbPath open.
+//
+// The restored index describes the snapshot's commit: indexing the working
+// tree afterwards re-extracts only the files whose content differs, and
+// resolves only what they affect. An Engine whose scripts differ from the
+// manifest's ScriptsHash reports ScriptsChanged.
+func ImportSnapshot(r io.Reader, dbPath, root string) (*SnapshotManifest, error) {
+	gz, err := gzip.NewReader(r)
+	if err != nil {
+		return nil, fmt.Errorf("import snapshot: %w", err)
+	}
+	tr := tar.NewReader(gz)
+
+	m := &SnapshotManifest{}
+	if err := nextSnapshotEntry(tr, snapshotManifestName); err != nil {
+		return nil, fmt.Errorf("import snapshot: %w", err)
+	}
+	if err := json.NewDecoder(tr).Decode(m); err != nil {
+		return nil, fmt.Errorf("import snapshot: manifest: %w", err)
+	}
+	if m.Version != SnapshotVersion {
+		return nil, fmt.Errorf("import snapshot: unsupported version %d (want %d)", m.Version, SnapshotVersion)
+	}
+
+	if err := nextSnapshotEntry(tr, snapshotDBName); err != nil {
+		return nil, fmt.Errorf("import snapshot: %w", err)
+	}
+	tmp := dbPath + ".import"
+	if err := writeFileFrom(tmp, tr); err != nil {
+		os.Remove(tmp)
+		return nil, fmt.Errorf("import snapshot: %w", err)
+	}
+	if err := store.ReplaceDatabase(tmp, dbPath); err != nil {
+		os.Remove(tmp)
+		return nil, fmt.Errorf("import snapshot: %w", err)
+	}
+
+	s, err := store.NewStore(dbPath)
+	if err != nil {
+		return nil, fmt.Errorf("import snapshot: %w", err)
+	}
+	defer s.Close()
+	if err := s.Migrate(); err != nil {
+		return nil, fmt.Errorf("import snapshot: %w", err)
+	}
+	if root != "" {
+		if _, err := s.RelocatePaths(m.Root, root); err != nil {
+			return nil, fmt.Errorf("import snapshot: %w", err)
+		}
+	}
+	// The memory-mapped call graph index is not part of the snapshot.
+	if err := s.RebuildCallGraphIndex(); err != nil {
+		return nil, fmt.Errorf("import snapshot: %w", err)
+	}
+	return m, nil
+}
+
+func nextSnapshotEntry(tr *tar.Reader, name string) error {
+	hdr, err := tr.Next()
+	if errors.Is(err, io.EOF) {
+		return fmt.Errorf("missing %s", name)
+	}
+	if err != nil {
+		return err
+	}
+	if hdr.Name != name {
+		return fmt.Errorf("unexpected entry %q, want %s", hdr.Name, name)
+	}
+	return nil
+}
+
+func writeFileFrom(path string, r io.Reader) error {
+	f, err := os.Create(path)
+	if err != nil {
+		return err
+	}
+	if _, err := io.Copy(f, r); err != nil {
+		f.Close()
+		return err
+	}
+	return f.Close()
+}
@@ -0,0 +1,72 @@
+package canopy
+
+import (
+	"bytes"
+	"context"
+	"os"
+	"path/filepath"
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func TestSnapshot_ImportRelocatesAndIndexesOnlyChanges(t *testing.T) {
+	t.Parallel()
+	ctx := context.Background()
+	scriptsDir := filepath.Join(findModuleRoot(t), "scripts")
+
+	// Build and export the index of a checkout at one path...
+	built, err := newSynthRepo(t.TempDir(), "go", 40)
+	require.NoError(t, err)
+	src := newIntegrationEngine(t, WithLanguages("go"))
+	require.NoError(t, src.IndexDirectory(ctx, built.dir))
+	require.NoError(t, src.Resolve(ctx))
+	var buf bytes.Buffer
+	m, err := src.ExportSnapshot(&buf, built.dir, "c0ffee")
+	require.NoError(t, err)
+	assert.Equal(t, SnapshotVersion, m.Version)
+	assert.NotEmpty(t, m.ScriptsHash)
+
+	// ...and import it for an identical checkout at another.
+	r, err := newSynthRepo(t.TempDir(), "go", 40)
+	require.NoError(t, err)
+	dbPath := filepath.Join(t.TempDir(), "index.db")
+	got, err := ImportSnapshot(bytes.NewReader(buf.Bytes()), dbPath, r.dir)
+	require.NoError(t, err)
+	assert.Equal(t, "c0ffee", got.Commit)
+	assert.Equal(t, built.dir, got.Root)
+
+	e, err := New(dbPath, scriptsDir, WithLanguages("go"), WithStats())
+	require.NoError(t, err)
+	defer e.Close()
+	assert.False(t, e.ScriptsChanged())
+
+	path, line, col, _ := r.callSite(2)
+	defs, err := e.Query().DefinitionAt(path, line, col)
+	require.NoError(t, err)
+	require.NotEmpty(t, defs, "resolution data is imported")
+	assert.Equal(t, r.path("p0/u1.go"), defs[0].File, "paths are relocated")
+
+	// Nothing needs extracting until a file differs.
+	require.NoError(t, e.IndexDirectory(ctx, r.dir))
+	require.NoError(t, e.Resolve(ctx))
+	assert.Zero(t, e.Stats().Phases["extract"].Count)
+
+	_, err = r.touch(1, true)
+	require.NoError(t, err)
+	require.NoError(t, e.IndexDirectory(ctx, r.dir))
+	require.NoError(t, e.Resolve(ctx))
+	assert.Equal(t, int64(1), e.Stats().Phases["extract"].Count)
+}
+
+func TestImportSnapshot_RejectsOtherVersions(t *testing.T) {
+	t.Parallel()
+	var buf bytes.Buffer
+	db := filepath.Join(t.TempDir(), "empty.db")
+	require.NoError(t, os.WriteFile(db, nil, 0o644))
+	require.NoError(t, writeSnapshot(&buf, &SnapshotManifest{Version: SnapshotVersion + 1}, db))
+
+	_, err := ImportSnapshot(&buf, filepath.Join(t.TempDir(), "index.db"), "")
+	assert.ErrorContains(t, err, "unsupported version")
+}
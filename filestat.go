@@ -0,0 +1,47 @@
+package canopy
+
+import (
+	"os"
+	"time"
+
+	"github.com/jward/canopy/internal/store"
+)
+
+// racyWindow guards the stat fast path against coarse filesystem
+// timestamps: a file modified within this window of being indexed could be
+// rewritten again with the same size and mtime, so it is always re-hashed.
+const racyWindow = 2 * time.Second
+
+// fileStat is the (size, mtime, inode) tuple used to detect unchanged files
+// without reading them.
+type fileStat struct {
+	size    int64
+	modTime int64 // Unix nanoseconds
+	inode   int64
+}
+
+func statFile(path string) (fileStat, error) {
+	fi, err := os.Stat(path)
+	if err != nil {
+		return fileStat{}, err
+	}
+	return fileStat{
+		size:    fi.Size(),
+		modTime: fi.ModTime().UnixNano(),
+		inode:   inodeOf(fi),
+	}, nil
+}
+
+// unchangedSince reports whether st matches the tuple recorded for f and the
+// recorded mtime is safely older than when f was indexed.
+func (st fileStat) unchangedSince(f *store.File) bool {
+	if f == nil || f.ModTime == 0 || !st.sameAs(f) {
+		return false
+	}
+	return time.Unix(0, f.ModTime).Before(f.LastIndexed.Add(-racyWindow))
+}
+
+// sameAs reports whether st equals the tuple recorded for f.
+func (st fileStat) sameAs(f *store.File) bool {
+	return st.size == f.Size && st.modTime == f.ModTime && st.inode == f.Inode
+}
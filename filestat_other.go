@@ -0,0 +1,11 @@
+//go:build !unix
+
+package canopy
+
+import "os"
+
+// inodeOf returns 0 where inode numbers are unavailable; size and mtime
+// still drive the stat fast path.
+func inodeOf(os.FileInfo) int64 {
+	return 0
+}
@@ -0,0 +1,15 @@
+//go:build unix
+
+package canopy
+
+import (
+	"os"
+	"syscall"
+)
+
+func inodeOf(fi os.FileInfo) int64 {
+	if st, ok := fi.Sys().(*syscall.Stat_t); ok {
+		return int64(st.Ino)
+	}
+	return 0
+}
@@ -0,0 +1,116 @@
+package runtime
+
+import (
+	"context"
+	"sort"
+	"sync"
+	"sync/atomic"
+	"time"
+
+	"github.com/risor-io/risor/object"
+)
+
+// CallStats counts the host function calls made by the scripts of every
+// Runtime it is given to (see WithCallStats), and how long they took.
+//
+// Thread safety: safe for concurrent use. Each function's counters are
+// created once, when a Runtime builds its globals, and updated atomically.
+type CallStats struct {
+	mu    sync.Mutex
+	funcs map[string]*callCounter
+}
+
+type callCounter struct {
+	calls, total, max atomic.Int64
+}
+
+// CallStat is the tally of one host function in a CallStats snapshot.
+type CallStat struct {
+	Name  string
+	Calls int64
+	Total time.Duration
+	Max   time.Duration
+}
+
+// NewCallStats returns an empty CallStats.
+func NewCallStats() *CallStats {
+	return &CallStats{funcs: make(map[string]*callCounter)}
+}
+
+func (c *CallStats) counter(name string) *callCounter {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	cc, ok := c.funcs[name]
+	if !ok {
+		cc = &callCounter{}
+		c.funcs[name] = cc
+	}
+	return cc
+}
+
+func (cc *callCounter) add(d time.Duration) {
+	cc.calls.Add(1)
+	cc.total.Add(int64(d))
+	for {
+		m := cc.max.Load()
+		if int64(d) <= m || cc.max.CompareAndSwap(m, int64(d)) {
+			return
+		}
+	}
+}
+
+// Snapshot returns the tally of every function called at least once, by
+// descending total time.
+func (c *CallStats) Snapshot() []CallStat {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	out := make([]CallStat, 0, len(c.funcs))
+	for name, cc := range c.funcs {
+		if n := cc.calls.Load(); n > 0 {
+			out = append(out, CallStat{
+				Name:  name,
+				Calls: n,
+				Total: time.Duration(cc.total.Load()),
+				Max:   time.Duration(cc.max.Load()),
+			})
+		}
+	}
+	sort.Slice(out, func(i, j int) bool {
+		if out[i].Total != out[j].Total {
+			return out[i].Total > out[j].Total
+		}
+		return out[i].Name < out[j].Name
+	})
+	return out
+}
+
+// WithCallStats records every host function call of the Runtime's scripts
+// in c. It also enables ParseTime.
+func WithCallStats(c *CallStats) RuntimeOption {
+	return func(r *Runtime) {
+		r.calls = c
+	}
+}
+
+// ParseTime returns the total time the Runtime's scripts have spent in
+// parse and parse_src; zero unless the Runtime records WithCallStats.
+func (r *Runtime) ParseTime() time.Duration {
+	return r.parseTime
+}
+
+// timed wraps b so each call is recorded in r.calls, and parse time in
+// r.parseTime.
+func (r *Runtime) timed(name string, b *object.Builtin) *object.Builtin {
+	cc := r.calls.counter(name)
+	parse := name == "parse" || name == "parse_src"
+	return object.NewBuiltin(name, func(ctx context.Context, args ...object.Object) object.Object {
+		start := time.Now()
+		res := b.Call(ctx, args...)
+		d := time.Since(start)
+		cc.add(d)
+		if parse {
+			r.parseTime += d
+		}
+		return res
+	})
+}
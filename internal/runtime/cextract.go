@@ -0,0 +1,456 @@
+package runtime
+
+import (
+	"context"
+	"sort"
+	"strconv"
+
+	"github.com/risor-io/risor/object"
+	sitter "github.com/smacker/go-tree-sitter"
+
+	"github.com/jward/canopy/internal/store"
+)
+
+// C and C++ extraction spends most of its time in two passes of the
+// scripts: building the scope tree, which walks every function body, and
+// the reference passes, which visit every call, field access, type name
+// and identifier and look up the innermost scope of each by scanning all
+// scopes. Done in Risor, every node access crosses a proxy boundary.
+// c_scopes_and_refs runs both passes natively, writing into the bound
+// DataStore, and the scripts keep the declaration passes (classes,
+// templates, access specifiers, macros, ...). The scripts fall back to
+// their own implementation when native_extraction is false (see
+// WithNativeExtraction); both produce the same rows in the same order.
+
+// cBlockTypes and cppBlockTypes are the statements that open a block scope.
+var (
+	cBlockTypes   = map[string]bool{"if_statement": true, "for_statement": true, "while_statement": true, "switch_statement": true, "do_statement": true}
+	cppBlockTypes = map[string]bool{"if_statement": true, "for_statement": true, "while_statement": true, "switch_statement": true, "do_statement": true, "for_range_loop": true, "try_statement": true}
+)
+
+// cReadParents are the parents of an identifier in expression position,
+// which the C script records as a read.
+var cReadParents = map[string]bool{
+	"return_statement": true, "binary_expression": true, "assignment_expression": true,
+	"unary_expression": true, "parenthesized_expression": true, "argument_list": true,
+	"subscript_expression": true, "conditional_expression": true, "comma_expression": true,
+	"field_expression": true, "cast_expression": true, "sizeof_expression": true,
+	"expression_statement": true, "initializer_list": true,
+}
+
+// cCheckEvery is how many nodes or matches the native passes visit between
+// checks of the script's context.
+const cCheckEvery = 1024
+
+// cExtraction is the state of one c_scopes_and_refs call.
+type cExtraction struct {
+	// ctx is the script's context: the passes stop when it is done, as
+	// when the file runs past its deadline (see WithFileTimeout). steps
+	// counts the work done since the call began.
+	ctx   context.Context
+	steps int
+
+	s      store.DataStore
+	src    []byte
+	lang   *sitter.Language
+	cpp    bool
+	fileID int64
+
+	// symbolIDs is the script's name → symbol ID map; names missing from
+	// it are looked up among the file's symbols, loaded once.
+	symbolIDs   map[string]object.Object
+	fileSymbols []*store.Symbol
+	loaded      bool
+
+	// scopes are in the order the scripts iterate their scope map: by the
+	// decimal string of the ID.
+	scopes []scopeSpan
+}
+
+type scopeSpan struct {
+	id                                   int64
+	key                                  string
+	startLine, startCol, endLine, endCol int
+}
+
+// makeCScopesAndRefsFn creates the "c_scopes_and_refs" host function.
+//
+// c_scopes_and_refs(language, root, file_id, symbol_ids) → nil
+//
+// language is "c" or "cpp"; symbol_ids maps the names of the symbols the
+// script inserted to their IDs.
+func makeCScopesAndRefsFn(ss *sourceStore, s store.DataStore) *object.Builtin {
+	return object.NewBuiltin("c_scopes_and_refs", func(ctx context.Context, args ...object.Object) object.Object {
+		if len(args) != 4 {
+			return object.NewArgsError("c_scopes_and_refs", 4, len(args))
+		}
+		language, err := toString(args[0])
+		if err != nil {
+			return object.Errorf("c_scopes_and_refs: language: %v", err)
+		}
+		if language != "c" && language != "cpp" {
+			return object.Errorf("c_scopes_and_refs: unsupported language %q", language)
+		}
+		proxy, ok := args[1].(*object.Proxy)
+		if !ok {
+			return object.Errorf("c_scopes_and_refs: expected proxy (Node), got %s", args[1].Type())
+		}
+		root, ok := proxy.Interface().(*sitter.Node)
+		if !ok {
+			return object.Errorf("c_scopes_and_refs: expected *sitter.Node, got %T", proxy.Interface())
+		}
+		fileID, err := toInt64(args[2])
+		if err != nil {
+			return object.Errorf("c_scopes_and_refs: file_id: %v", err)
+		}
+		symbolIDs, err := extractMap(args[3])
+		if err != nil {
+			return object.Errorf("c_scopes_and_refs: symbol_ids: %v", err)
+		}
+		src, found := ss.sourceForNode(root)
+		if !found {
+			return object.Errorf("c_scopes_and_refs: no source found for node's tree")
+		}
+		lang, _ := ss.languageForNode(root)
+
+		x := &cExtraction{ctx: ctx, s: s, src: src, lang: lang, cpp: language == "cpp", fileID: fileID, symbolIDs: symbolIDs}
+		if err := x.scopeTree(root); err != nil {
+			return object.Errorf("c_scopes_and_refs: scopes: %v", err)
+		}
+		sort.Slice(x.scopes, func(i, j int) bool { return x.scopes[i].key < x.scopes[j].key })
+		if err := x.references(root); err != nil {
+			return object.Errorf("c_scopes_and_refs: references: %v", err)
+		}
+		return object.Nil
+	})
+}
+
+func (x *cExtraction) text(n *sitter.Node) string {
+	return n.Content(x.src)
+}
+
+// step counts one node or match and, every cCheckEvery, returns the
+// context's error once it is done.
+func (x *cExtraction) step() error {
+	x.steps++
+	if x.steps%cCheckEvery != 0 {
+		return nil
+	}
+	return x.ctx.Err()
+}
+
+// eachMatch runs pattern over node and calls fn with each match's
+// captures (the last node of each capture name).
+func (x *cExtraction) eachMatch(pattern string, node *sitter.Node, fn func(map[string]*sitter.Node) error) error {
+	q, err := compiledQueries.get(pattern, x.lang)
+	if err != nil {
+		return err
+	}
+	cursor := sitter.NewQueryCursor()
+	defer cursor.Close()
+	cursor.Exec(q, node)
+	captures := make(map[string]*sitter.Node)
+	for {
+		match, ok := cursor.NextMatch()
+		if !ok {
+			return nil
+		}
+		if err := x.step(); err != nil {
+			return err
+		}
+		match = cursor.FilterPredicates(match, x.src)
+		clear(captures)
+		for _, c := range match.Captures {
+			captures[q.CaptureNameForId(c.Index)] = c.Node
+		}
+		if err := fn(captures); err != nil {
+			return err
+		}
+	}
+}
+
+// symbolID is the scripts' find_symbol_id.
+func (x *cExtraction) symbolID(name string) *int64 {
+	if v, ok := x.symbolIDs[name]; ok {
+		if id, err := toInt64(v); err == nil {
+			return &id
+		}
+		return nil
+	}
+	if !x.loaded {
+		x.fileSymbols, _ = x.s.SymbolsByFile(x.fileID)
+		x.loaded = true
+	}
+	for _, sym := range x.fileSymbols {
+		if sym.Name == name {
+			id := sym.ID
+			return &id
+		}
+	}
+	return nil
+}
+
+// declaratorName is the scripts' extract_declarator_name: the leaf
+// identifier of a declarator.
+func (x *cExtraction) declaratorName(n *sitter.Node) string {
+	switch t := n.Type(); t {
+	case "identifier", "type_identifier", "field_identifier":
+		return x.text(n)
+	case "qualified_identifier":
+		if x.cpp {
+			if nn := n.ChildByFieldName("name"); nn != nil {
+				return x.text(nn)
+			}
+		}
+	case "pointer_declarator", "parenthesized_declarator", "array_declarator", "reference_declarator":
+		if t == "reference_declarator" && !x.cpp {
+			break
+		}
+		if inner := n.ChildByFieldName("declarator"); inner != nil {
+			return x.declaratorName(inner)
+		}
+		if t == "parenthesized_declarator" && !x.cpp && n.NamedChildCount() > 0 {
+			return x.declaratorName(n.NamedChild(0))
+		}
+	case "function_declarator":
+		if inner := n.ChildByFieldName("declarator"); inner != nil {
+			return x.declaratorName(inner)
+		}
+	}
+	return x.text(n)
+}
+
+func (x *cExtraction) insertScope(kind string, n *sitter.Node, parent, symbolID *int64) (int64, error) {
+	sc := &store.Scope{
+		FileID:        x.fileID,
+		Kind:          kind,
+		StartLine:     int(n.StartPoint().Row),
+		StartCol:      int(n.StartPoint().Column),
+		EndLine:       int(n.EndPoint().Row),
+		EndCol:        int(n.EndPoint().Column),
+		SymbolID:      symbolID,
+		ParentScopeID: parent,
+	}
+	id, err := x.s.InsertScope(sc)
+	if err != nil {
+		return 0, err
+	}
+	x.scopes = append(x.scopes, scopeSpan{
+		id: id, key: strconv.FormatInt(id, 10),
+		startLine: sc.StartLine, startCol: sc.StartCol, endLine: sc.EndLine, endCol: sc.EndCol,
+	})
+	return id, nil
+}
+
+// scopeTree inserts the file scope, the namespace and class scopes (C++),
+// and the function scopes with their block scopes.
+func (x *cExtraction) scopeTree(root *sitter.Node) error {
+	fileScope, err := x.insertScope("file", root, nil, nil)
+	if err != nil {
+		return err
+	}
+
+	if x.cpp {
+		err = x.eachMatch("(namespace_definition) @ns", root, func(m map[string]*sitter.Node) error {
+			var symID *int64
+			if nn := m["ns"].ChildByFieldName("name"); nn != nil {
+				symID = x.symbolID(x.text(nn))
+			}
+			_, err := x.insertScope("namespace", m["ns"], &fileScope, symID)
+			return err
+		})
+		if err != nil {
+			return err
+		}
+		err = x.eachMatch("(class_specifier name: (type_identifier) @name body: (field_declaration_list) @body) @cls", root, func(m map[string]*sitter.Node) error {
+			var symID *int64
+			if nn := m["name"]; nn != nil {
+				symID = x.symbolID(x.text(nn))
+			}
+			_, err := x.insertScope("class", m["cls"], &fileScope, symID)
+			return err
+		})
+		if err != nil {
+			return err
+		}
+	}
+
+	err = x.eachMatch("(function_definition) @fn", root, func(m map[string]*sitter.Node) error {
+		fn := m["fn"]
+		if x.cpp {
+			// Template-wrapped functions are handled below.
+			if parent := fn.Parent(); parent != nil && parent.Type() == "template_declaration" {
+				return nil
+			}
+		}
+		return x.functionScope(fn, fn, fileScope)
+	})
+	if err != nil || !x.cpp {
+		return err
+	}
+	return x.eachMatch("(template_declaration (function_definition) @fn) @tmpl", root, func(m map[string]*sitter.Node) error {
+		return x.functionScope(m["fn"], m["tmpl"], fileScope)
+	})
+}
+
+// functionScope inserts the scope of function definition fn, spanning
+// span, and its block scopes.
+func (x *cExtraction) functionScope(fn, span *sitter.Node, fileScope int64) error {
+	var symID *int64
+	if fdecl := fn.ChildByFieldName("declarator"); fdecl != nil {
+		if nn := fdecl.ChildByFieldName("declarator"); nn != nil {
+			symID = x.symbolID(x.declaratorName(nn))
+		}
+	}
+	id, err := x.insertScope("function", span, &fileScope, symID)
+	if err != nil {
+		return err
+	}
+	if body := fn.ChildByFieldName("body"); body != nil {
+		return x.blockScopes(body, id)
+	}
+	return nil
+}
+
+func (x *cExtraction) blockScopes(n *sitter.Node, parent int64) error {
+	blockTypes := cBlockTypes
+	if x.cpp {
+		blockTypes = cppBlockTypes
+	}
+	count := int(n.NamedChildCount())
+	for i := 0; i < count; i++ {
+		if err := x.step(); err != nil {
+			return err
+		}
+		child := n.NamedChild(i)
+		scope := parent
+		if blockTypes[child.Type()] {
+			id, err := x.insertScope("block", child, &parent, nil)
+			if err != nil {
+				return err
+			}
+			scope = id
+		}
+		if err := x.blockScopes(child, scope); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// innermostScope is the scripts' find_innermost_scope_id: the smallest
+// scope containing the position, the first in key order on ties.
+func (x *cExtraction) innermostScope(line, col int) *int64 {
+	var best int64
+	bestSize := -1
+	for i := range x.scopes {
+		sc := &x.scopes[i]
+		var inside bool
+		switch {
+		case line > sc.startLine && line < sc.endLine:
+			inside = true
+		case line == sc.startLine && line == sc.endLine:
+			inside = col >= sc.startCol && col <= sc.endCol
+		case line == sc.startLine:
+			inside = col >= sc.startCol
+		case line == sc.endLine:
+			inside = col <= sc.endCol
+		}
+		if !inside {
+			continue
+		}
+		size := (sc.endLine-sc.startLine)*10000 + (sc.endCol - sc.startCol)
+		if bestSize < 0 || size < bestSize {
+			best, bestSize = sc.id, size
+		}
+	}
+	if bestSize < 0 {
+		return nil
+	}
+	return &best
+}
+
+func (x *cExtraction) insertRef(name, context string, n *sitter.Node) error {
+	ref := &store.Reference{
+		FileID:    x.fileID,
+		Name:      name,
+		Context:   context,
+		StartLine: int(n.StartPoint().Row),
+		StartCol:  int(n.StartPoint().Column),
+		EndLine:   int(n.EndPoint().Row),
+		EndCol:    int(n.EndPoint().Column),
+	}
+	ref.ScopeID = x.innermostScope(ref.StartLine, ref.StartCol)
+	_, err := x.s.InsertReference(ref)
+	return err
+}
+
+// references inserts the call, field access, type and (C only) read
+// references.
+func (x *cExtraction) references(root *sitter.Node) error {
+	err := x.eachMatch("(call_expression function: (identifier) @name) @call", root, func(m map[string]*sitter.Node) error {
+		return x.insertRef(x.text(m["name"]), "call", m["name"])
+	})
+	if err != nil {
+		return err
+	}
+	err = x.eachMatch("(call_expression function: (field_expression argument: (_) @obj field: (field_identifier) @field))", root, func(m map[string]*sitter.Node) error {
+		return x.insertRef(x.text(m["field"]), "call", m["field"])
+	})
+	if err != nil {
+		return err
+	}
+	err = x.eachMatch("(field_expression argument: (_) @obj field: (field_identifier) @field) @fexpr", root, func(m map[string]*sitter.Node) error {
+		if parent := m["fexpr"].Parent(); parent != nil && parent.Type() == "call_expression" {
+			return nil // a call, recorded above
+		}
+		return x.insertRef(x.text(m["field"]), "field_access", m["field"])
+	})
+	if err != nil {
+		return err
+	}
+	err = x.eachMatch("(type_identifier) @type_id", root, func(m map[string]*sitter.Node) error {
+		tn := m["type_id"]
+		if x.isTypeDeclName(tn) {
+			return nil
+		}
+		return x.insertRef(x.text(tn), "type_annotation", tn)
+	})
+	if err != nil || x.cpp {
+		return err
+	}
+	return x.eachMatch("(identifier) @id", root, func(m map[string]*sitter.Node) error {
+		id := m["id"]
+		parent := id.Parent()
+		if parent == nil || !cReadParents[parent.Type()] {
+			return nil
+		}
+		return x.insertRef(x.text(id), "read", id)
+	})
+}
+
+// isTypeDeclName reports whether type identifier tn names the type being
+// defined rather than referring to one.
+func (x *cExtraction) isTypeDeclName(tn *sitter.Node) bool {
+	parent := tn.Parent()
+	if parent == nil {
+		return false
+	}
+	name := x.text(tn)
+	switch parent.Type() {
+	case "class_specifier":
+		if !x.cpp {
+			return false
+		}
+		fallthrough
+	case "struct_specifier", "enum_specifier":
+		pn := parent.ChildByFieldName("name")
+		return pn != nil && x.text(pn) == name
+	case "type_definition":
+		pd := parent.ChildByFieldName("declarator")
+		return pd != nil && x.text(pd) == name
+	case "type_parameter_declaration":
+		return x.cpp
+	}
+	return false
+}
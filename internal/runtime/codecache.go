@@ -0,0 +1,156 @@
+package runtime
+
+import (
+	"context"
+	"crypto/sha256"
+	"fmt"
+	"io/fs"
+	"os"
+	"path/filepath"
+	"sort"
+	"strings"
+	"sync"
+	"sync/atomic"
+
+	"github.com/risor-io/risor/compiler"
+	"github.com/risor-io/risor/importer"
+	"github.com/risor-io/risor/object"
+	"github.com/risor-io/risor/parser"
+)
+
+// CacheStats reports hit/miss counters for a process-wide cache.
+type CacheStats struct {
+	Hits    int64
+	Misses  int64
+	Entries int
+}
+
+// codeKey identifies one compilation of a script. The same source compiled
+// against a different set of global names produces different bytecode, so
+// the global name set is part of the key.
+type codeKey struct {
+	label  string
+	source [sha256.Size]byte
+	names  [sha256.Size]byte
+}
+
+// codeCache holds compiled Risor code shared by every Runtime in the process.
+// Compiled code is immutable once built; each VM wraps it with its own
+// globals and frames, so a single *compiler.Code can be executed by many
+// worker Runtimes concurrently.
+type codeCache struct {
+	mu     sync.RWMutex
+	codes  map[codeKey]*compiler.Code
+	hits   atomic.Int64
+	misses atomic.Int64
+}
+
+var scriptCache = &codeCache{codes: make(map[codeKey]*compiler.Code)}
+
+// ScriptCacheStats returns counters for the compiled-script cache.
+func ScriptCacheStats() CacheStats {
+	scriptCache.mu.RLock()
+	n := len(scriptCache.codes)
+	scriptCache.mu.RUnlock()
+	return CacheStats{
+		Hits:    scriptCache.hits.Load(),
+		Misses:  scriptCache.misses.Load(),
+		Entries: n,
+	}
+}
+
+// compile returns compiled code for source, compiling it at most once per
+// (label, source hash, global names) combination. Concurrent misses on the
+// same key may both compile; the first stored result wins.
+func (c *codeCache) compile(ctx context.Context, label, source string, globalNames []string, namesKey [sha256.Size]byte) (*compiler.Code, error) {
+	key := codeKey{label: label, source: sha256.Sum256([]byte(source)), names: namesKey}
+
+	c.mu.RLock()
+	code, ok := c.codes[key]
+	c.mu.RUnlock()
+	if ok {
+		c.hits.Add(1)
+		return code, nil
+	}
+	c.misses.Add(1)
+
+	ast, err := parser.Parse(ctx, source)
+	if err != nil {
+		return nil, err
+	}
+	code, err = compiler.Compile(ast, compiler.WithGlobalNames(globalNames))
+	if err != nil {
+		return nil, err
+	}
+
+	c.mu.Lock()
+	if existing, ok := c.codes[key]; ok {
+		code = existing
+	} else {
+		c.codes[key] = code
+	}
+	c.mu.Unlock()
+	return code, nil
+}
+
+// globalNameList returns the sorted union of the host globals and Risor's
+// default globals (builtins like len, string, print, and modules like
+// strings, math, etc.), along with a digest of the list for use in cache keys.
+func globalNameList(globals map[string]any, defaultNames []string) ([]string, [sha256.Size]byte) {
+	nameSet := make(map[string]bool, len(globals)+len(defaultNames))
+	for name := range globals {
+		nameSet[name] = true
+	}
+	for _, name := range defaultNames {
+		nameSet[name] = true
+	}
+	names := make([]string, 0, len(nameSet))
+	for name := range nameSet {
+		names = append(names, name)
+	}
+	sort.Strings(names)
+	return names, sha256.Sum256([]byte(strings.Join(names, "\x00")))
+}
+
+// cachingImporter resolves Risor import statements against the Runtime's
+// script source (fs.FS or scriptsDir) and compiles modules through the
+// shared code cache, so lib/ modules are compiled once per process rather
+// than once per script run.
+type cachingImporter struct {
+	fsys        fs.FS
+	scriptsDir  string
+	globalNames []string
+	namesKey    [sha256.Size]byte
+}
+
+var _ importer.Importer = (*cachingImporter)(nil)
+
+// Import loads the named module, trying the .risor extension.
+func (i *cachingImporter) Import(ctx context.Context, name string) (*object.Module, error) {
+	source, label, err := i.read(name)
+	if err != nil {
+		return nil, err
+	}
+	code, err := scriptCache.compile(ctx, label, source, i.globalNames, i.namesKey)
+	if err != nil {
+		return nil, fmt.Errorf("runtime: module %s: %w", name, err)
+	}
+	return object.NewModule(name, code), nil
+}
+
+func (i *cachingImporter) read(name string) (source, label string, err error) {
+	if i.fsys != nil {
+		fsPath := strings.TrimPrefix(filepath.ToSlash(name), "/") + ".risor"
+		data, err := fs.ReadFile(i.fsys, fsPath)
+		if err != nil {
+			return "", "", fmt.Errorf("import error: module %q not found", name)
+		}
+		return string(data), "fs:" + fsPath, nil
+	}
+	fullPath := filepath.Join(i.scriptsDir, name+".risor")
+	data, err := os.ReadFile(fullPath)
+	if err != nil {
+		return "", "", fmt.Errorf("import error: module %q not found", name)
+	}
+	return string(data), fullPath, nil
+}
@@ -4,6 +4,8 @@ import (
 	"context"
 	"fmt"
 	"os"
+	"sort"
+	"strings"
 	"sync"
 	"unsafe"
 
@@ -16,10 +18,15 @@ import (
 // smacker/go-tree-sitter doesn't expose Node.Tree(). We store mappings
 // keyed by root node pointer (obtained via tree.RootNode() at parse time
 // and by walking up Parent() at lookup time).
+//
+// It also holds file contents handed over by the caller (see
+// WithPreloadedSource) so that parse can skip re-reading them from disk.
 type sourceStore struct {
-	mu      sync.RWMutex
-	sources map[uintptr][]byte          // root node ptr → source bytes
-	langs   map[uintptr]*sitter.Language // root node ptr → language
+	mu        sync.RWMutex
+	sources   map[uintptr][]byte           // root node ptr → source bytes
+	langs     map[uintptr]*sitter.Language // root node ptr → language
+	preloaded map[string][]byte            // file path → contents already read by the caller
+	trees     *TreeCache                   // previous trees for incremental parse; nil disables
 }
 
 func newSourceStore() *sourceStore {
@@ -29,6 +36,35 @@ func newSourceStore() *sourceStore {
 	}
 }
 
+func (s *sourceStore) preload(path string, src []byte) {
+	s.mu.Lock()
+	if s.preloaded == nil {
+		s.preloaded = make(map[string][]byte)
+	}
+	s.preloaded[path] = src
+	s.mu.Unlock()
+}
+
+// reset forgets every parsed source and preloaded file (see Runtime.Reset).
+func (s *sourceStore) reset() {
+	s.mu.Lock()
+	clear(s.sources)
+	clear(s.langs)
+	s.preloaded = nil
+	s.mu.Unlock()
+}
+
+// readFile returns preloaded contents for path, falling back to disk.
+func (s *sourceStore) readFile(path string) ([]byte, error) {
+	s.mu.RLock()
+	src, ok := s.preloaded[path]
+	s.mu.RUnlock()
+	if ok {
+		return src, nil
+	}
+	return os.ReadFile(path)
+}
+
 func (s *sourceStore) store(tree *sitter.Tree, src []byte, lang *sitter.Language) {
 	root := tree.RootNode()
 	key := uintptr(unsafe.Pointer(root))
@@ -81,12 +117,12 @@ func makeParseFn(ss *sourceStore) *object.Builtin {
 			return object.Errorf("parse: language must be a string, got %s", args[1].Type())
 		}
 
-		src, err := os.ReadFile(pathStr.Value())
+		src, err := ss.readFile(pathStr.Value())
 		if err != nil {
 			return object.Errorf("parse: reading %s: %v", pathStr.Value(), err)
 		}
 
-		return parseSource(ctx, ss, src, langStr.Value())
+		return parseSource(ctx, ss, pathStr.Value(), src, langStr.Value())
 	})
 }
 
@@ -109,12 +145,14 @@ func makeParseSrcFn(ss *sourceStore) *object.Builtin {
 			return object.Errorf("parse_src: language must be a string, got %s", args[1].Type())
 		}
 
-		return parseSource(ctx, ss, []byte(srcStr.Value()), langStr.Value())
+		return parseSource(ctx, ss, "", []byte(srcStr.Value()), langStr.Value())
 	})
 }
 
-// parseSource is the shared implementation for parse and parse_src.
-func parseSource(ctx context.Context, ss *sourceStore, src []byte, langName string) object.Object {
+// parseSource is the shared implementation for parse and parse_src. path
+// is empty for parse_src. When the store has a TreeCache, a file parsed
+// before is reparsed incrementally from its previous tree.
+func parseSource(ctx context.Context, ss *sourceStore, path string, src []byte, langName string) object.Object {
 	lang, found := ParserForLanguage(langName)
 	if !found {
 		return object.Errorf("parse: unsupported language %q", langName)
@@ -124,10 +162,17 @@ func parseSource(ctx context.Context, ss *sourceStore, src []byte, langName stri
 	defer parser.Close()
 	parser.SetLanguage(lang)
 
-	tree, err := parser.ParseCtx(ctx, nil, src)
+	var old *sitter.Tree
+	if ss.trees != nil && path != "" {
+		old = ss.trees.previous(path, lang, src)
+	}
+	tree, err := parser.ParseCtx(ctx, old, src)
 	if err != nil {
 		return object.Errorf("parse: tree-sitter parse failed: %v", err)
 	}
+	if ss.trees != nil && path != "" {
+		ss.trees.put(path, lang, src, tree)
+	}
 
 	ss.store(tree, src, lang)
 
@@ -185,63 +230,160 @@ func makeQueryFn(ss *sourceStore) *object.Builtin {
 			return object.Errorf("query: pattern must be a string, got %s", args[0].Type())
 		}
 
-		nodeProxy, ok := args[1].(*object.Proxy)
-		if !ok {
-			return object.Errorf("query: node must be a proxy (Node), got %s", args[1].Type())
+		node, lang, src, errObj := queryTarget("query", ss, args[1])
+		if errObj != nil {
+			return errObj
 		}
 
-		node, ok := nodeProxy.Interface().(*sitter.Node)
-		if !ok {
-			return object.Errorf("query: expected *sitter.Node, got %T", nodeProxy.Interface())
+		// Compiled queries are cached process-wide and must not be closed here.
+		q, err := compiledQueries.get(patternStr.Value(), lang)
+		if err != nil {
+			return object.Errorf("query: invalid pattern: %v", err)
 		}
 
-		lang, found := ss.languageForNode(node)
-		if !found {
-			return object.Errorf("query: no language found for node's tree")
+		cursor := sitter.NewQueryCursor()
+		defer cursor.Close()
+		cursor.Exec(q, node)
+
+		results := []object.Object{}
+		for {
+			match, ok := cursor.NextMatch()
+			if !ok {
+				break
+			}
+			m, errObj := matchObject("query", q, cursor.FilterPredicates(match, src))
+			if errObj != nil {
+				return errObj
+			}
+			results = append(results, m)
 		}
+		return object.NewList(results)
+	})
+}
 
-		src, found := ss.sourceForNode(node)
-		if !found {
-			return object.Errorf("query: no source found for node's tree")
+// makeQueryMultiFn creates the "query_multi" host function.
+//
+// query_multi({name: pattern, ...}, node) → {name: []map[string]any, ...}
+//
+// Runs all patterns as one query, so the tree under node is traversed once
+// instead of once per query call. Each name gets the matches query would
+// return for its pattern, in the same order.
+func makeQueryMultiFn(ss *sourceStore) *object.Builtin {
+	return object.NewBuiltin("query_multi", func(ctx context.Context, args ...object.Object) object.Object {
+		if len(args) != 2 {
+			return object.NewArgsError("query_multi", 2, len(args))
 		}
 
-		q, err := sitter.NewQuery([]byte(patternStr.Value()), lang)
+		patterns, err := extractMap(args[0])
 		if err != nil {
-			return object.Errorf("query: invalid pattern: %v", err)
+			return object.Errorf("query_multi: patterns: %v", err)
+		}
+
+		node, lang, src, errObj := queryTarget("query_multi", ss, args[1])
+		if errObj != nil {
+			return errObj
+		}
+
+		// Patterns are combined in name order. A pattern string may hold
+		// several patterns, so each name owns the range of pattern indexes
+		// starting at its entry in starts.
+		names := make([]string, 0, len(patterns))
+		for name := range patterns {
+			names = append(names, name)
+		}
+		sort.Strings(names)
+		starts := make([]int, len(names))
+		var combined strings.Builder
+		next := 0
+		for i, name := range names {
+			pattern, err := toString(patterns[name])
+			if err != nil {
+				return object.Errorf("query_multi: pattern %q: %v", name, err)
+			}
+			q, err := compiledQueries.get(pattern, lang)
+			if err != nil {
+				return object.Errorf("query_multi: invalid pattern %q: %v", name, err)
+			}
+			starts[i] = next
+			next += int(q.PatternCount())
+			combined.WriteString(pattern)
+			combined.WriteByte('\n')
+		}
+
+		q, err := compiledQueries.get(combined.String(), lang)
+		if err != nil {
+			return object.Errorf("query_multi: invalid patterns: %v", err)
 		}
-		defer q.Close()
 
 		cursor := sitter.NewQueryCursor()
 		defer cursor.Close()
 		cursor.Exec(q, node)
 
-		var results []object.Object
+		buckets := make([][]object.Object, len(names))
 		for {
 			match, ok := cursor.NextMatch()
 			if !ok {
 				break
 			}
-			match = cursor.FilterPredicates(match, src)
-
-			matchMap := make(map[string]object.Object)
-			for _, capture := range match.Captures {
-				name := q.CaptureNameForId(capture.Index)
-				nodeP, err := object.NewProxy(capture.Node)
-				if err != nil {
-					return object.Errorf("query: proxy error for capture %q: %v", name, err)
-				}
-				matchMap[name] = nodeP
+			i := sort.SearchInts(starts, int(match.PatternIndex)+1) - 1
+			m, errObj := matchObject("query_multi", q, cursor.FilterPredicates(match, src))
+			if errObj != nil {
+				return errObj
 			}
-			results = append(results, object.NewMap(matchMap))
+			buckets[i] = append(buckets[i], m)
 		}
 
-		if results == nil {
-			results = []object.Object{}
+		result := make(map[string]object.Object, len(names))
+		for i, name := range names {
+			if buckets[i] == nil {
+				buckets[i] = []object.Object{}
+			}
+			result[name] = object.NewList(buckets[i])
 		}
-		return object.NewList(results)
+		return object.NewMap(result)
 	})
 }
 
+// queryTarget unwraps the node argument of a query builtin and finds the
+// language and source of its tree.
+func queryTarget(fn string, ss *sourceStore, arg object.Object) (*sitter.Node, *sitter.Language, []byte, *object.Error) {
+	nodeProxy, ok := arg.(*object.Proxy)
+	if !ok {
+		return nil, nil, nil, object.Errorf("%s: node must be a proxy (Node), got %s", fn, arg.Type())
+	}
+
+	node, ok := nodeProxy.Interface().(*sitter.Node)
+	if !ok {
+		return nil, nil, nil, object.Errorf("%s: expected *sitter.Node, got %T", fn, nodeProxy.Interface())
+	}
+
+	lang, found := ss.languageForNode(node)
+	if !found {
+		return nil, nil, nil, object.Errorf("%s: no language found for node's tree", fn)
+	}
+
+	src, found := ss.sourceForNode(node)
+	if !found {
+		return nil, nil, nil, object.Errorf("%s: no source found for node's tree", fn)
+	}
+	return node, lang, src, nil
+}
+
+// matchObject converts a query match to a map of capture names to proxied
+// Nodes.
+func matchObject(fn string, q *sitter.Query, match *sitter.QueryMatch) (object.Object, *object.Error) {
+	matchMap := make(map[string]object.Object, len(match.Captures))
+	for _, capture := range match.Captures {
+		name := q.CaptureNameForId(capture.Index)
+		nodeP, err := object.NewProxy(capture.Node)
+		if err != nil {
+			return nil, object.Errorf("%s: proxy error for capture %q: %v", fn, name, err)
+		}
+		matchMap[name] = nodeP
+	}
+	return object.NewMap(matchMap), nil
+}
+
 // makeNodeChildFn creates "node_child" — safe wrapper for ChildByFieldName
 // that returns Risor nil instead of a proxied Go nil pointer.
 //
@@ -0,0 +1,69 @@
+package runtime
+
+import (
+	"sync"
+	"sync/atomic"
+
+	sitter "github.com/smacker/go-tree-sitter"
+)
+
+// queryKey identifies a compiled tree-sitter query. Grammar pointers are
+// process-wide singletons (see languages.go), so pointer identity is a
+// stable language key.
+type queryKey struct {
+	lang    *sitter.Language
+	pattern string
+}
+
+// queryCache holds compiled tree-sitter queries shared by every Runtime.
+// A compiled TSQuery is immutable and safe to execute from multiple
+// goroutines as long as each uses its own QueryCursor. Cached queries live
+// for the lifetime of the process and are never closed.
+type queryCache struct {
+	mu      sync.RWMutex
+	queries map[queryKey]*sitter.Query
+	hits    atomic.Int64
+	misses  atomic.Int64
+}
+
+var compiledQueries = &queryCache{queries: make(map[queryKey]*sitter.Query)}
+
+// QueryCacheStats returns counters for the compiled tree-sitter query cache.
+func QueryCacheStats() CacheStats {
+	compiledQueries.mu.RLock()
+	n := len(compiledQueries.queries)
+	compiledQueries.mu.RUnlock()
+	return CacheStats{
+		Hits:    compiledQueries.hits.Load(),
+		Misses:  compiledQueries.misses.Load(),
+		Entries: n,
+	}
+}
+
+// get returns the compiled query for pattern in lang, compiling it on first
+// use. Invalid patterns are not cached.
+func (c *queryCache) get(pattern string, lang *sitter.Language) (*sitter.Query, error) {
+	key := queryKey{lang: lang, pattern: pattern}
+
+	c.mu.RLock()
+	q, ok := c.queries[key]
+	c.mu.RUnlock()
+	if ok {
+		c.hits.Add(1)
+		return q, nil
+	}
+
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if q, ok := c.queries[key]; ok {
+		c.hits.Add(1)
+		return q, nil
+	}
+	c.misses.Add(1)
+	q, err := sitter.NewQuery([]byte(pattern), lang)
+	if err != nil {
+		return nil, err
+	}
+	c.queries[key] = q
+	return q, nil
+}
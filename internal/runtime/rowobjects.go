@@ -0,0 +1,142 @@
+package runtime
+
+import (
+	"strconv"
+
+	"github.com/risor-io/risor/object"
+
+	"github.com/jward/canopy/internal/store"
+)
+
+// rowConverter turns store rows into the Risor maps handed to scripts.
+//
+// Scripts treat query results as read-only, so one converter shares
+// everything it can between the rows of a single builtin call: repeated
+// string values (kinds, visibilities, names) are interned as one
+// *object.String each, and a scope converted once is reused wherever it
+// appears again, e.g. in every scope chain that passes through it. This
+// keeps allocations proportional to the number of distinct rows instead of
+// rows times fields, or scopes times chain depth for batch_scope_chains.
+type rowConverter struct {
+	strs   map[string]*object.String
+	scopes map[int64]object.Object
+}
+
+func newRowConverter() *rowConverter {
+	return &rowConverter{strs: make(map[string]*object.String)}
+}
+
+// str returns the shared Risor string for s.
+func (c *rowConverter) str(s string) *object.String {
+	if o, ok := c.strs[s]; ok {
+		return o
+	}
+	o := object.NewString(s)
+	c.strs[s] = o
+	return o
+}
+
+func (c *rowConverter) symbol(sym *store.Symbol) object.Object {
+	m := make(map[string]object.Object, 10)
+	m["id"] = object.NewInt(sym.ID)
+	m["name"] = c.str(sym.Name)
+	m["kind"] = c.str(sym.Kind)
+	m["visibility"] = c.str(sym.Visibility)
+	m["start_line"] = object.NewInt(int64(sym.StartLine))
+	m["start_col"] = object.NewInt(int64(sym.StartCol))
+	m["end_line"] = object.NewInt(int64(sym.EndLine))
+	m["end_col"] = object.NewInt(int64(sym.EndCol))
+	if sym.FileID != nil {
+		m["file_id"] = object.NewInt(*sym.FileID)
+	}
+	if sym.ParentSymbolID != nil {
+		m["parent_symbol_id"] = object.NewInt(*sym.ParentSymbolID)
+	}
+	return object.NewMap(m)
+}
+
+// scope returns the map for sc, converting each scope ID at most once.
+func (c *rowConverter) scope(sc *store.Scope) object.Object {
+	if o, ok := c.scopes[sc.ID]; ok {
+		return o
+	}
+	m := make(map[string]object.Object, 8)
+	m["id"] = object.NewInt(sc.ID)
+	m["kind"] = c.str(sc.Kind)
+	m["start_line"] = object.NewInt(int64(sc.StartLine))
+	m["start_col"] = object.NewInt(int64(sc.StartCol))
+	m["end_line"] = object.NewInt(int64(sc.EndLine))
+	m["end_col"] = object.NewInt(int64(sc.EndCol))
+	if sc.SymbolID != nil {
+		m["symbol_id"] = object.NewInt(*sc.SymbolID)
+	}
+	if sc.ParentScopeID != nil {
+		m["parent_scope_id"] = object.NewInt(*sc.ParentScopeID)
+	}
+	o := object.NewMap(m)
+	if c.scopes == nil {
+		c.scopes = make(map[int64]object.Object)
+	}
+	c.scopes[sc.ID] = o
+	return o
+}
+
+func (c *rowConverter) reference(r *store.Reference) object.Object {
+	m := make(map[string]object.Object, 8)
+	m["id"] = object.NewInt(r.ID)
+	m["name"] = c.str(r.Name)
+	m["context"] = c.str(r.Context)
+	m["start_line"] = object.NewInt(int64(r.StartLine))
+	m["start_col"] = object.NewInt(int64(r.StartCol))
+	m["end_line"] = object.NewInt(int64(r.EndLine))
+	m["end_col"] = object.NewInt(int64(r.EndCol))
+	if r.ScopeID != nil {
+		m["scope_id"] = object.NewInt(*r.ScopeID)
+	}
+	return object.NewMap(m)
+}
+
+func (c *rowConverter) importRow(imp *store.Import) object.Object {
+	m := map[string]object.Object{
+		"id":     object.NewInt(imp.ID),
+		"source": c.str(imp.Source),
+		"kind":   c.str(imp.Kind),
+	}
+	if imp.ImportedName != nil {
+		m["imported_name"] = c.str(*imp.ImportedName)
+	}
+	if imp.LocalAlias != nil {
+		m["local_alias"] = c.str(*imp.LocalAlias)
+	}
+	return object.NewMap(m)
+}
+
+// scopeChains maps each scope ID of one file's scopes to its chain of
+// scopes up to the root, walked in memory. Each scope is converted once
+// and shared by every chain that contains it.
+func (c *rowConverter) scopeChains(scopes []*store.Scope) object.Object {
+	byID := make(map[int64]*store.Scope, len(scopes))
+	for _, sc := range scopes {
+		byID[sc.ID] = sc
+	}
+	result := make(map[string]object.Object, len(scopes))
+	seen := make(map[int64]bool)
+	for _, sc := range scopes {
+		var chain []object.Object
+		cur := sc
+		clear(seen)
+		for cur != nil {
+			if seen[cur.ID] {
+				break // prevent infinite loop on cycles
+			}
+			seen[cur.ID] = true
+			chain = append(chain, c.scope(cur))
+			if cur.ParentScopeID == nil {
+				break
+			}
+			cur = byID[*cur.ParentScopeID]
+		}
+		result[strconv.FormatInt(sc.ID, 10)] = object.NewList(chain)
+	}
+	return object.NewMap(result)
+}
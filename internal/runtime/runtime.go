@@ -2,11 +2,15 @@ package runtime
 
 import (
 	"context"
+	"crypto/sha256"
 	"fmt"
 	"io/fs"
 	"os"
 	"path/filepath"
+	"sort"
 	"strings"
+	"sync"
+	"time"
 
 	"github.com/risor-io/risor"
 	"github.com/risor-io/risor/importer"
@@ -19,11 +23,56 @@ import (
 // and Store access to extraction and resolution scripts.
 type Runtime struct {
 	store      store.DataStore
+	bound      *boundStore // what the extraction builtins write to; see Bind
 	scriptsDir string
 	fsys       fs.FS
 	sources    *sourceStore
+
+	// reads and writes redirect resolution builtins to a shared read cache
+	// and a caller-owned buffered writer (see WithReadCache,
+	// WithResolutionBatch). When writes is nil, each script run against a
+	// *store.Store buffers into its own batch of up to batchLimit rows.
+	reads      *store.ReadCache
+	writes     *store.ResolutionBatch
+	batchLimit int
+
+	// native is exposed to extraction scripts as native_extraction: whether
+	// they use the compiled fast paths (see WithNativeExtraction).
+	native bool
+
+	// calls records host function calls when set (see WithCallStats);
+	// parseTime accumulates the time spent in parse and parse_src.
+	calls     *CallStats
+	parseTime time.Duration
+
+	// state caches the globals, global names and importer derived for the
+	// previous run, so a Runtime reused across many files (see Bind) builds
+	// them once. Rebuilt when the resolution writer or the set of extra
+	// global names changes.
+	state *evalState
 }
 
+// boundStore forwards to the DataStore the Runtime is currently bound to,
+// letting builtins built once follow later Bind calls.
+type boundStore struct {
+	store.DataStore
+}
+
+// evalState is what eval derives from a Runtime's globals.
+type evalState struct {
+	writes      *store.ResolutionBatch
+	extraKeys   string // sorted extra global names, NUL-separated
+	opts        []risor.Option
+	globalNames []string
+	namesKey    [sha256.Size]byte
+}
+
+// defaultGlobalNames are Risor's built-in global names; they are fixed for
+// the process, so they are computed once.
+var defaultGlobalNames = sync.OnceValue(func() []string {
+	return risor.NewConfig().GlobalNames()
+})
+
 // RuntimeOption configures a Runtime.
 type RuntimeOption func(*Runtime)
 
@@ -36,13 +85,70 @@ func WithRuntimeFS(fsys fs.FS) RuntimeOption {
 	}
 }
 
+// WithPreloadedSource hands the Runtime the contents of a file the caller
+// has already read (e.g. to hash it). The parse host function uses these
+// bytes instead of reading path from disk again. The slice is retained and
+// must not be modified afterwards.
+func WithPreloadedSource(path string, src []byte) RuntimeOption {
+	return func(r *Runtime) {
+		r.PreloadSource(path, src)
+	}
+}
+
+// WithTreeCache makes parse start from the previous tree of a file found
+// in c and record the new tree there, so re-parsing a recently parsed file
+// is incremental. c may be shared by many Runtimes.
+func WithTreeCache(c *TreeCache) RuntimeOption {
+	return func(r *Runtime) {
+		r.sources.trees = c
+	}
+}
+
+// WithReadCache routes the resolution query builtins (symbols_by_kind,
+// scopes_by_file, ...) through c, so Runtimes resolving different shards of
+// the same language share one copy of each query result.
+func WithReadCache(c *store.ReadCache) RuntimeOption {
+	return func(r *Runtime) {
+		r.reads = c
+	}
+}
+
+// WithResolutionBatch routes the resolution insert builtins into a
+// caller-owned batch b that may outlive a single script run. db_query
+// flushes b before reading a table with buffered rows. The caller is
+// responsible for the final b.Flush().
+func WithResolutionBatch(b *store.ResolutionBatch) RuntimeOption {
+	return func(r *Runtime) {
+		r.writes = b
+	}
+}
+
+// WithResolutionBatchLimit sets how many resolution rows a script run
+// buffers before flushing (default store.DefaultResolutionBatchLimit).
+func WithResolutionBatchLimit(n int) RuntimeOption {
+	return func(r *Runtime) {
+		r.batchLimit = n
+	}
+}
+
+// WithNativeExtraction controls whether extraction scripts hand their
+// hottest passes to compiled Go (c_scopes_and_refs for C and C++) or run
+// them in Risor. Enabled by default; both produce the same rows.
+func WithNativeExtraction(enabled bool) RuntimeOption {
+	return func(r *Runtime) {
+		r.native = enabled
+	}
+}
+
 // NewRuntime creates a Runtime wired to the given DataStore and scripts directory.
 // Accepts optional RuntimeOptions for configuration such as fs.FS-based script loading.
 func NewRuntime(s store.DataStore, scriptsDir string, opts ...RuntimeOption) *Runtime {
 	r := &Runtime{
 		store:      s,
+		bound:      &boundStore{s},
 		scriptsDir: scriptsDir,
 		sources:    newSourceStore(),
+		native:     true,
 	}
 	for _, opt := range opts {
 		opt(r)
@@ -50,6 +156,35 @@ func NewRuntime(s store.DataStore, scriptsDir string, opts ...RuntimeOption) *Ru
 	return r
 }
 
+// Bind points the Runtime at s for subsequent runs, so one long-lived
+// Runtime can extract many files that each buffer into their own
+// BatchedStore. Must not be called while a script is running.
+func (r *Runtime) Bind(s store.DataStore) {
+	// Resolution builtins are only present for a *store.Store and capture
+	// it directly, so binding to or from one rebuilds the globals.
+	_, wasReal := r.store.(*store.Store)
+	_, isReal := s.(*store.Store)
+	if wasReal || isReal || (r.store == nil) != (s == nil) {
+		r.state = nil
+	}
+	r.store = s
+	r.bound.DataStore = s
+}
+
+// PreloadSource hands the Runtime the contents of a file the caller has
+// already read, like WithPreloadedSource, for a Runtime that is reused.
+func (r *Runtime) PreloadSource(path string, src []byte) {
+	r.sources.preload(path, src)
+}
+
+// Reset drops what previous runs left behind: the sources and languages of
+// parsed trees and any preloaded file contents. A Runtime reused across
+// files should be reset after each one so it does not keep every file it
+// has seen alive.
+func (r *Runtime) Reset() {
+	r.sources.reset()
+}
+
 // RunScript loads and executes a Risor script with all standard globals
 // plus any extra globals provided by the caller.
 func (r *Runtime) RunScript(ctx context.Context, scriptPath string, extraGlobals map[string]any) error {
@@ -66,60 +201,90 @@ func (r *Runtime) RunSource(ctx context.Context, source string, extraGlobals map
 	return r.eval(ctx, source, "<inline>", extraGlobals)
 }
 
-func (r *Runtime) eval(ctx context.Context, source, label string, extraGlobals map[string]any) error {
-	globals := r.buildGlobals(extraGlobals)
-
-	var opts []risor.Option
-	for name, val := range globals {
-		opts = append(opts, risor.WithGlobal(name, val))
+func (r *Runtime) eval(ctx context.Context, source, label string, extraGlobals map[string]any) (err error) {
+	// Resolution inserts are buffered and written in bulk transactions. A
+	// batch owned by this run is flushed when the script finishes, including
+	// on error, so rows written before a failure persist as they would with
+	// direct inserts.
+	writes := r.writes
+	if writes == nil {
+		if realStore, ok := r.store.(*store.Store); ok {
+			owned := store.NewResolutionBatch(realStore, r.batchLimit)
+			writes = owned
+			defer func() {
+				if flushErr := owned.Flush(); flushErr != nil && err == nil {
+					err = fmt.Errorf("runtime: script %s: %w", label, flushErr)
+				}
+			}()
+		}
 	}
 
-	// Wire importer so Risor import statements resolve correctly.
-	if imp := r.buildImporter(globals); imp != nil {
-		opts = append(opts, risor.WithImporter(imp))
+	st := r.evalState(extraGlobals, writes)
+	opts := make([]risor.Option, 0, len(st.opts)+len(extraGlobals))
+	opts = append(opts, st.opts...)
+	for name, val := range extraGlobals {
+		opts = append(opts, risor.WithGlobal(name, val))
 	}
 
-	_, err := risor.Eval(ctx, source, opts...)
+	code, err := scriptCache.compile(ctx, label, source, st.globalNames, st.namesKey)
 	if err != nil {
 		return fmt.Errorf("runtime: script %s: %w", label, err)
 	}
+	if _, err := risor.EvalCode(ctx, code, opts...); err != nil {
+		return fmt.Errorf("runtime: script %s: %w", label, err)
+	}
 	return nil
 }
 
-// buildImporter returns a Risor importer configured for the Runtime's script source.
-// Returns nil if neither fs.FS nor scriptsDir is configured.
-func (r *Runtime) buildImporter(globals map[string]any) importer.Importer {
-	// Combine our custom global names with Risor's default globals (builtins
-	// like len, string, print, and modules like strings, math, etc.) so that
-	// imported modules can reference them without "undefined variable" errors.
-	defaultNames := risor.NewConfig().GlobalNames()
-	nameSet := make(map[string]bool, len(globals)+len(defaultNames))
-	for name := range globals {
-		nameSet[name] = true
+// evalState returns the cached evalState if it still applies to a run with
+// these extra globals and writer, building a new one otherwise.
+func (r *Runtime) evalState(extra map[string]any, writes *store.ResolutionBatch) *evalState {
+	keys := make([]string, 0, len(extra))
+	for k := range extra {
+		keys = append(keys, k)
+	}
+	sort.Strings(keys)
+	extraKeys := strings.Join(keys, "\x00")
+	if st := r.state; st != nil && st.writes == writes && st.extraKeys == extraKeys {
+		return st
 	}
-	for _, name := range defaultNames {
-		nameSet[name] = true
+
+	globals := r.buildGlobals(nil, writes)
+	st := &evalState{writes: writes, extraKeys: extraKeys}
+	for name, val := range globals {
+		if _, ok := extra[name]; !ok {
+			st.opts = append(st.opts, risor.WithGlobal(name, val))
+		}
 	}
-	globalNames := make([]string, 0, len(nameSet))
-	for name := range nameSet {
-		globalNames = append(globalNames, name)
+	for _, k := range keys {
+		globals[k] = nil // only the name matters from here on
 	}
 
-	if r.fsys != nil {
-		return importer.NewFSImporter(importer.FSImporterOptions{
-			GlobalNames: globalNames,
-			SourceFS:    r.fsys,
-			Extensions:  []string{".risor"},
-		})
-	}
-	if r.scriptsDir != "" {
-		return importer.NewLocalImporter(importer.LocalImporterOptions{
-			GlobalNames: globalNames,
-			SourceDir:   r.scriptsDir,
-			Extensions:  []string{".risor"},
-		})
+	// Compile against the host globals plus Risor's defaults so that both
+	// the script and any imported modules can reference them without
+	// "undefined variable" errors. Compiled code is shared process-wide.
+	st.globalNames, st.namesKey = globalNameList(globals, defaultGlobalNames())
+
+	// Wire importer so Risor import statements resolve correctly.
+	if imp := r.buildImporter(st.globalNames, st.namesKey); imp != nil {
+		st.opts = append(st.opts, risor.WithImporter(imp))
+	}
+	r.state = st
+	return st
+}
+
+// buildImporter returns a Risor importer configured for the Runtime's script source.
+// Returns nil if neither fs.FS nor scriptsDir is configured.
+func (r *Runtime) buildImporter(globalNames []string, namesKey [sha256.Size]byte) importer.Importer {
+	if r.fsys == nil && r.scriptsDir == "" {
+		return nil
+	}
+	return &cachingImporter{
+		fsys:        r.fsys,
+		scriptsDir:  r.scriptsDir,
+		globalNames: globalNames,
+		namesKey:    namesKey,
 	}
-	return nil
 }
 
 // LoadScript reads a .risor file and returns its source code.
@@ -162,61 +327,85 @@ func ResolutionScriptPath(language string) string {
 // buildGlobals constructs the full set of globals exposed to Risor scripts.
 // Extraction globals work with any DataStore (including BatchedStore).
 // Resolution globals require *store.Store and are only added when the
-// underlying store is a real Store.
-func (r *Runtime) buildGlobals(extra map[string]any) map[string]any {
+// underlying store is a real Store; their inserts go to writes.
+func (r *Runtime) buildGlobals(extra map[string]any, writes *store.ResolutionBatch) map[string]any {
 	globals := map[string]any{
-		"parse":      makeParseFn(r.sources),
-		"parse_src":  makeParseSrcFn(r.sources),
-		"node_text":  makeNodeTextFn(r.sources),
-		"node_child": makeNodeChildFn(),
-		"query":      makeQueryFn(r.sources),
-		"log":        mustProxy(&logObject{prefix: "canopy"}),
+		"parse":       makeParseFn(r.sources),
+		"parse_src":   makeParseSrcFn(r.sources),
+		"node_text":   makeNodeTextFn(r.sources),
+		"node_child":  makeNodeChildFn(),
+		"query":       makeQueryFn(r.sources),
+		"query_multi": makeQueryMultiFn(r.sources),
+		"log":         mustProxy(&logObject{prefix: "canopy"}),
 	}
 
 	// Expose extraction globals — these work with any DataStore.
 	if r.store != nil {
 		// Extraction insert functions
-		globals["insert_symbol"] = makeInsertSymbolFn(r.store)
-		globals["insert_scope"] = makeInsertScopeFn(r.store)
-		globals["insert_reference"] = makeInsertReferenceFn(r.store)
-		globals["insert_import"] = makeInsertImportFn(r.store)
-		globals["insert_type_member"] = makeInsertTypeMemberFn(r.store)
-		globals["insert_function_param"] = makeInsertFunctionParamFn(r.store)
-		globals["insert_type_param"] = makeInsertTypeParamFn(r.store)
-		globals["insert_annotation"] = makeInsertAnnotationFn(r.store)
+		globals["insert_symbol"] = makeInsertSymbolFn(r.bound)
+		globals["insert_scope"] = makeInsertScopeFn(r.bound)
+		globals["insert_reference"] = makeInsertReferenceFn(r.bound)
+		globals["insert_import"] = makeInsertImportFn(r.bound)
+		globals["insert_type_member"] = makeInsertTypeMemberFn(r.bound)
+		globals["insert_function_param"] = makeInsertFunctionParamFn(r.bound)
+		globals["insert_type_param"] = makeInsertTypeParamFn(r.bound)
+		globals["insert_annotation"] = makeInsertAnnotationFn(r.bound)
 
 		// Extraction query functions
-		globals["symbols_by_name"] = makeSymbolsByNameFn(r.store)
-		globals["symbols_by_file"] = makeSymbolsByFileFn(r.store)
+		globals["symbols_by_name"] = makeSymbolsByNameFn(r.bound)
+		globals["symbols_by_file"] = makeSymbolsByFileFn(r.bound)
+
+		// Native extraction passes
+		globals["native_extraction"] = object.NewBool(r.native)
+		globals["c_scopes_and_refs"] = makeCScopesAndRefsFn(r.sources, r.bound)
 
 		// Resolution globals require *store.Store (DB access, queries, etc.)
 		if realStore, ok := r.store.(*store.Store); ok {
+			var reader store.ResolutionReader = realStore
+			if r.reads != nil {
+				reader = r.reads
+				globals["symbols_by_name"] = makeSymbolsByNameFn(reader)
+				globals["symbols_by_file"] = makeSymbolsByFileFn(reader)
+			}
+			var writer store.ResolutionWriter = realStore
+			if writes != nil {
+				writer = writes
+			}
+
 			globals["db"] = mustProxy(realStore)
 			globals["update_annotation_resolved"] = makeUpdateAnnotationResolvedFn(realStore)
 
 			// Resolution insert functions
-			globals["insert_resolved_reference"] = makeInsertResolvedReferenceFn(realStore)
-			globals["insert_implementation"] = makeInsertImplementationFn(realStore)
-			globals["insert_call_edge"] = makeInsertCallEdgeFn(realStore)
-			globals["insert_extension_binding"] = makeInsertExtensionBindingFn(realStore)
+			globals["insert_resolved_reference"] = makeInsertResolvedReferenceFn(writer)
+			globals["insert_implementation"] = makeInsertImplementationFn(writer)
+			globals["insert_call_edge"] = makeInsertCallEdgeFn(writer)
+			globals["insert_extension_binding"] = makeInsertExtensionBindingFn(writer)
 
 			// Resolution query functions
-			globals["references_by_file"] = makeReferencesByFileFn(realStore)
-			globals["scopes_by_file"] = makeScopesByFileFn(realStore)
-			globals["imports_by_file"] = makeImportsByFileFn(realStore)
-			globals["type_members"] = makeTypeMembersFn(realStore)
-			globals["files_by_language"] = makeFilesByLanguageFn(realStore)
-			globals["symbols_by_kind"] = makeSymbolsByKindFn(realStore)
-			globals["scope_chain"] = makeScopeChainFn(realStore)
-			globals["batch_scope_chains"] = makeBatchScopeChainsFn(realStore)
-			globals["function_params"] = makeFunctionParamsFn(realStore)
-			globals["db_query"] = makeDBQueryFn(realStore)
+			globals["references_by_file"] = makeReferencesByFileFn(reader)
+			globals["scopes_by_file"] = makeScopesByFileFn(reader)
+			globals["imports_by_file"] = makeImportsByFileFn(reader)
+			globals["type_members"] = makeTypeMembersFn(reader)
+			globals["files_by_language"] = makeFilesByLanguageFn(reader)
+			globals["symbols_by_kind"] = makeSymbolsByKindFn(reader)
+			globals["scope_chain"] = makeScopeChainFn(reader)
+			globals["batch_scope_chains"] = makeBatchScopeChainsFn(reader)
+			globals["load_language_snapshot"] = makeLoadLanguageSnapshotFn(reader)
+			globals["function_params"] = makeFunctionParamsFn(reader)
+			globals["db_query"] = makeDBQueryFn(realStore, writes)
 		}
 	}
 
 	for k, v := range extra {
 		globals[k] = v
 	}
+	if r.calls != nil {
+		for name, v := range globals {
+			if b, ok := v.(*object.Builtin); ok {
+				globals[name] = r.timed(name, b)
+			}
+		}
+	}
 	return globals
 }
 
@@ -2,14 +2,20 @@ package runtime
 
 import (
 	"context"
+	"fmt"
 	"os"
 	"path/filepath"
+	"strconv"
+	"strings"
 	"testing"
 	"testing/fstest"
 
+	"github.com/risor-io/risor/object"
 	sitter "github.com/smacker/go-tree-sitter"
 	"github.com/stretchr/testify/assert"
 	"github.com/stretchr/testify/require"
+
+	"github.com/jward/canopy/internal/store"
 )
 
 const goTestSource = `package main
@@ -378,6 +384,55 @@ func TestQuery_FunctionDeclarations(t *testing.T) {
 	}
 }
 
+func TestRunSource_QueryMultiMatchesQuery(t *testing.T) {
+	src := `
+tree := parse_src(source, "go")
+root := tree.RootNode()
+patterns := {
+  "funcs": "(function_declaration name: (identifier) @name)",
+  "fields": "(field_declaration name: (field_identifier) @name)",
+  "calls": "(call_expression function: (selector_expression field: (field_identifier) @name))",
+  "none": "(go_statement) @name",
+}
+multi := query_multi(patterns, root)
+assert(len(multi) == len(patterns), "one bucket per pattern")
+for key, pattern := range patterns {
+  want := query(pattern, root)
+  got := multi[key]
+  assert(len(got) == len(want), key + " count")
+  for i, m := range want {
+    assert(node_text(got[i]["name"]) == node_text(m["name"]), key + " order")
+  }
+}
+assert(len(multi["funcs"]) == 2 && len(multi["none"]) == 0, "matches")
+`
+	rt := NewRuntime(nil, "")
+	require.NoError(t, rt.RunSource(context.Background(), src, map[string]any{"source": goTestSource}))
+}
+
+func TestWithCallStats_CountsHostCalls(t *testing.T) {
+	src := `
+tree := parse_src(source, "go")
+root := tree.RootNode()
+for i := 0; i < 3; i++ {
+  query("(function_declaration name: (identifier) @name)", root)
+}
+`
+	calls := NewCallStats()
+	rt := NewRuntime(nil, "", WithCallStats(calls))
+	require.NoError(t, rt.RunSource(context.Background(), src, map[string]any{"source": goTestSource}))
+
+	byName := make(map[string]CallStat)
+	for _, c := range calls.Snapshot() {
+		byName[c.Name] = c
+	}
+	assert.Equal(t, int64(3), byName["query"].Calls)
+	assert.Equal(t, int64(1), byName["parse_src"].Calls)
+	assert.NotContains(t, byName, "parse", "uncalled functions are left out")
+	assert.Equal(t, byName["parse_src"].Total, rt.ParseTime())
+	assert.Positive(t, rt.ParseTime())
+}
+
 func TestQuery_NoMatches(t *testing.T) {
 	src := `package main
 
@@ -509,6 +564,22 @@ assert(names[1] == "Add", 'expected Add, got {names[1]}')
 	}
 }
 
+func TestRunSource_ParseUsesPreloadedSource(t *testing.T) {
+	// The path does not exist on disk; parse must use the preloaded bytes.
+	path := filepath.Join(t.TempDir(), "missing.go")
+	rt := NewRuntime(nil, "", WithPreloadedSource(path, []byte(goTestSource)))
+
+	script := `
+tree := parse(test_file, "go")
+matches := query("(function_declaration name: (identifier) @name)", tree.RootNode())
+assert(len(matches) == 2, 'expected 2 matches, got {len(matches)}')
+`
+	err := rt.RunSource(context.Background(), script, map[string]any{
+		"test_file": path,
+	})
+	require.NoError(t, err)
+}
+
 func TestRunSource_QueryHostFunction(t *testing.T) {
 	dir := t.TempDir()
 	goFile := filepath.Join(dir, "test.go")
@@ -603,6 +674,38 @@ query("(not_a_real_node_type @x)", root)
 	}
 }
 
+func TestRunSource_QueryCacheReusesCompiledQuery(t *testing.T) {
+	dir := t.TempDir()
+	goFile := filepath.Join(dir, "test.go")
+	if err := os.WriteFile(goFile, []byte(goTestSource), 0644); err != nil {
+		t.Fatalf("writing temp file: %v", err)
+	}
+
+	rt := NewRuntime(nil, "")
+	ctx := context.Background()
+
+	// A pattern unique to this test so concurrent tests cannot satisfy it.
+	script := `
+tree := parse(test_file, "go")
+root := tree.RootNode()
+pattern := "(type_declaration (type_spec name: (type_identifier) @cache_probe))"
+for i := 0; i < 3; i++ {
+	matches := query(pattern, root)
+	assert(len(matches) == 1, 'expected 1 match, got {len(matches)}')
+	assert(node_text(matches[0]["cache_probe"]) == "Server", 'expected Server')
+}
+`
+	before := QueryCacheStats()
+	err := rt.RunSource(ctx, script, map[string]any{
+		"test_file": goFile,
+	})
+	require.NoError(t, err)
+	after := QueryCacheStats()
+
+	assert.GreaterOrEqual(t, after.Hits-before.Hits, int64(2))
+	assert.GreaterOrEqual(t, after.Entries, 1)
+}
+
 func TestRunSource_MethodDeclarationQuery(t *testing.T) {
 	dir := t.TempDir()
 	goFile := filepath.Join(dir, "test.go")
@@ -891,3 +994,274 @@ func TestNewRuntime_BackwardCompatible(t *testing.T) {
 	assert.Nil(t, rt.fsys)
 	assert.Equal(t, "/some/dir", rt.scriptsDir)
 }
+
+// --- Compiled-script cache tests ---
+
+func TestRunScript_ReusesCompiledCode(t *testing.T) {
+	mapFS := fstest.MapFS{
+		"cached.risor":     &fstest.MapFile{Data: []byte("import cached_lib\nresult := cached_lib.triple(14)\nassert(result == 42, 'expected 42')\n")},
+		"cached_lib.risor": &fstest.MapFile{Data: []byte("func triple(x) {\n\treturn x * 3\n}\n")},
+	}
+
+	// Two independent Runtimes, as used by parallel extraction workers.
+	first := NewRuntime(nil, "", WithRuntimeFS(mapFS))
+	require.NoError(t, first.RunScript(context.Background(), "cached.risor", nil))
+	before := ScriptCacheStats()
+
+	second := NewRuntime(nil, "", WithRuntimeFS(mapFS))
+	require.NoError(t, second.RunScript(context.Background(), "cached.risor", nil))
+	after := ScriptCacheStats()
+
+	// Both the script and its imported module are served from the cache.
+	assert.GreaterOrEqual(t, after.Hits-before.Hits, int64(2))
+}
+
+func TestRunScript_RecompilesChangedSource(t *testing.T) {
+	dir := t.TempDir()
+	path := filepath.Join(dir, "changing.risor")
+	require.NoError(t, os.WriteFile(path, []byte(`x := 1`), 0644))
+
+	rt := NewRuntime(nil, dir)
+	require.NoError(t, rt.RunScript(context.Background(), "changing.risor", nil))
+
+	// Same path, new content: the stale compiled code must not be reused.
+	require.NoError(t, os.WriteFile(path, []byte(`assert(false, 'new source ran')`), 0644))
+	err := rt.RunScript(context.Background(), "changing.risor", nil)
+	require.Error(t, err)
+	assert.Contains(t, err.Error(), "new source ran")
+}
+
+func TestRunSource_BuffersResolutionWritesUntilScriptEnds(t *testing.T) {
+	s, err := store.NewStore(filepath.Join(t.TempDir(), "test.db"))
+	require.NoError(t, err)
+	defer s.Close()
+	require.NoError(t, s.Migrate())
+
+	fileID, err := s.InsertFile(&store.File{Path: "/main.go", Language: "go"})
+	require.NoError(t, err)
+	symID, err := s.InsertSymbol(&store.Symbol{FileID: &fileID, Name: "Target", Kind: "function"})
+	require.NoError(t, err)
+	refID, err := s.InsertReference(&store.Reference{FileID: fileID, Name: "Target", Context: "call"})
+	require.NoError(t, err)
+
+	// The script reads its own buffered write back through db_query.
+	src := fmt.Sprintf(`
+insert_resolved_reference({"reference_id": %d, "target_symbol_id": %d, "resolution_kind": "direct"})
+rows := db_query("SELECT target_symbol_id FROM resolved_references WHERE reference_id = ?", %d)
+assert(len(rows) == 1, "buffered row not visible to db_query")
+insert_call_edge({"caller_symbol_id": %d, "callee_symbol_id": %d, "line": 4})
+`, refID, symID, refID, symID, symID)
+
+	rt := NewRuntime(s, "", WithResolutionBatchLimit(1000))
+	require.NoError(t, rt.RunSource(context.Background(), src, nil))
+
+	// The trailing call edge was still buffered when the script returned
+	// and must have been flushed by RunSource.
+	edges, err := s.CallersByCallee(symID)
+	require.NoError(t, err)
+	assert.Len(t, edges, 1)
+}
+
+func TestRunSource_BatchScopeChainsSharesScopes(t *testing.T) {
+	s, err := store.NewStore(filepath.Join(t.TempDir(), "test.db"))
+	require.NoError(t, err)
+	defer s.Close()
+	require.NoError(t, s.Migrate())
+
+	fileID, err := s.InsertFile(&store.File{Path: "/main.go", Language: "go"})
+	require.NoError(t, err)
+	outer, err := s.InsertScope(&store.Scope{FileID: fileID, Kind: "file", EndLine: 20})
+	require.NoError(t, err)
+	mid, err := s.InsertScope(&store.Scope{FileID: fileID, Kind: "function", StartLine: 2, EndLine: 10, ParentScopeID: &outer})
+	require.NoError(t, err)
+	inner, err := s.InsertScope(&store.Scope{FileID: fileID, Kind: "block", StartLine: 3, EndLine: 5, ParentScopeID: &mid})
+	require.NoError(t, err)
+
+	src := fmt.Sprintf(`
+chains := batch_scope_chains(%d)
+inner := chains["%d"]
+assert(len(inner) == 3, "inner chain length")
+assert(inner[0]["kind"] == "block" && inner[1]["kind"] == "function" && inner[2]["kind"] == "file", "inner chain order")
+assert(inner[2]["id"] == %d && inner[1]["parent_scope_id"] == %d, "inner chain ids")
+assert(len(chains["%d"]) == 2, "mid chain length")
+assert(len(chains["%d"]) == 1, "outer chain length")
+`, fileID, inner, outer, outer, mid, outer)
+
+	rt := NewRuntime(s, "")
+	require.NoError(t, rt.RunSource(context.Background(), src, nil))
+
+	// Each scope is converted once: every chain containing it holds the
+	// same object.
+	ctx := context.Background()
+	key := func(id int64) string { return strconv.FormatInt(id, 10) }
+	chainOf := func(chains object.Object, id int64) []object.Object {
+		return chains.(*object.Map).Value()[key(id)].(*object.List).Value()
+	}
+	chains := makeBatchScopeChainsFn(s).Call(ctx, object.NewInt(fileID))
+	assert.Same(t, chainOf(chains, mid)[0], chainOf(chains, inner)[1])
+	assert.Same(t, chainOf(chains, outer)[0], chainOf(chains, inner)[2])
+	assert.Same(t, chainOf(chains, outer)[0], chainOf(chains, mid)[1])
+
+	// A language snapshot converts once for every table: its scopes list
+	// and its chains share their objects too.
+	snap := makeLoadLanguageSnapshotFn(s).Call(ctx, object.NewString("go")).(*object.Map).Value()
+	list := snap["scopes"].(*object.Map).Value()[key(fileID)].(*object.List).Value()
+	snapChains := snap["scope_chains"].(*object.Map).Value()[key(fileID)]
+	require.Len(t, list, 3)
+	for _, sc := range list {
+		id := sc.(*object.Map).Value()["id"].(*object.Int).Value()
+		assert.Same(t, sc, chainOf(snapChains, id)[0])
+	}
+	assert.Same(t, chainOf(snapChains, outer)[0], chainOf(snapChains, inner)[2])
+}
+
+func TestRunSource_LoadLanguageSnapshot(t *testing.T) {
+	s, err := store.NewStore(filepath.Join(t.TempDir(), "test.db"))
+	require.NoError(t, err)
+	defer s.Close()
+	require.NoError(t, s.Migrate())
+
+	fileID, err := s.InsertFile(&store.File{Path: "/main.c", Language: "c"})
+	require.NoError(t, err)
+	empty, err := s.InsertFile(&store.File{Path: "/empty.c", Language: "c"})
+	require.NoError(t, err)
+	_, err = s.InsertFile(&store.File{Path: "/main.go", Language: "go"})
+	require.NoError(t, err)
+	outer, err := s.InsertScope(&store.Scope{FileID: fileID, Kind: "file", EndLine: 20})
+	require.NoError(t, err)
+	inner, err := s.InsertScope(&store.Scope{FileID: fileID, Kind: "function", StartLine: 2, EndLine: 10, ParentScopeID: &outer})
+	require.NoError(t, err)
+	_, err = s.InsertSymbol(&store.Symbol{FileID: &fileID, Name: "main", Kind: "function"})
+	require.NoError(t, err)
+	_, err = s.InsertReference(&store.Reference{FileID: fileID, Name: "printf", Context: "call"})
+	require.NoError(t, err)
+	_, err = s.InsertImport(&store.Import{FileID: fileID, Source: "stdio.h", Kind: "include"})
+	require.NoError(t, err)
+
+	src := fmt.Sprintf(`
+snap := load_language_snapshot("c")
+assert(len(snap["files"]) == 2, "only c files")
+fid := "%d"
+assert(snap["symbols"][fid][0]["name"] == "main", "symbols")
+assert(snap["scopes"][fid][1]["parent_scope_id"] == %d, "scopes")
+assert(snap["references"][fid][0]["name"] == "printf", "references")
+assert(snap["imports"][fid][0]["source"] == "stdio.h", "imports")
+assert(len(snap["scope_chains"][fid]["%d"]) == 2, "scope chains")
+assert(len(snap["symbols"]["%d"]) == 0, "files without rows")
+`, fileID, outer, inner, empty)
+
+	rt := NewRuntime(s, "")
+	require.NoError(t, rt.RunSource(context.Background(), src, nil))
+}
+
+func TestRuntime_BindAndResetReuseOneRuntime(t *testing.T) {
+	s, err := store.NewStore(filepath.Join(t.TempDir(), "test.db"))
+	require.NoError(t, err)
+	defer s.Close()
+	require.NoError(t, s.Migrate())
+
+	rt := NewRuntime(nil, "")
+	script := `
+tree := parse(test_file, "go")
+insert_symbol({file_id: 1, name: node_text(tree.RootNode().NamedChild(0).NamedChild(0)), kind: "package"})
+`
+	path := filepath.Join(t.TempDir(), "missing.go")
+
+	var batches []*store.BatchedStore
+	var state *evalState
+	for _, src := range []string{"package a\n", "package b\n"} {
+		b := store.NewBatchedStore(s)
+		batches = append(batches, b)
+		rt.Bind(b)
+		rt.PreloadSource(path, []byte(src))
+		require.NoError(t, rt.RunSource(context.Background(), script, map[string]any{"test_file": path}))
+
+		// Globals and importer are built once and reused by later runs.
+		if state == nil {
+			state = rt.state
+		}
+		assert.Same(t, state, rt.state)
+
+		rt.Reset()
+		assert.Empty(t, rt.sources.sources)
+		assert.Empty(t, rt.sources.preloaded)
+	}
+
+	// Each run wrote to the store bound at the time.
+	rows0, rows1 := batches[0].Rows(), batches[1].Rows()
+	require.Len(t, rows0.Symbols, 1)
+	require.Len(t, rows1.Symbols, 1)
+	assert.Equal(t, "a", rows0.Symbols[0].Name)
+	assert.Equal(t, "b", rows1.Symbols[0].Name)
+}
+
+func TestEditBetween(t *testing.T) {
+	edit := editBetween([]byte("a\nbc\nd"), []byte("a\nbXYc\nd"))
+	assert.Equal(t, uint32(3), edit.StartIndex)
+	assert.Equal(t, uint32(3), edit.OldEndIndex)
+	assert.Equal(t, uint32(5), edit.NewEndIndex)
+	assert.Equal(t, sitter.Point{Row: 1, Column: 1}, edit.StartPoint)
+	assert.Equal(t, sitter.Point{Row: 1, Column: 1}, edit.OldEndPoint)
+	assert.Equal(t, sitter.Point{Row: 1, Column: 3}, edit.NewEndPoint)
+
+	edit = editBetween([]byte("abc\n"), []byte("a\n\nc\n"))
+	assert.Equal(t, uint32(1), edit.StartIndex)
+	assert.Equal(t, uint32(2), edit.OldEndIndex)
+	assert.Equal(t, uint32(3), edit.NewEndIndex)
+	assert.Equal(t, sitter.Point{Row: 2, Column: 0}, edit.NewEndPoint)
+}
+
+func TestParse_IncrementalMatchesFreshParse(t *testing.T) {
+	ctx := context.Background()
+	tree := func(ss *sourceStore, src string) *sitter.Tree {
+		t.Helper()
+		obj := parseSource(ctx, ss, "/main.go", []byte(src), "go")
+		proxy, ok := obj.(*object.Proxy)
+		require.True(t, ok, "parse failed: %s", obj.Inspect())
+		return proxy.Interface().(*sitter.Tree)
+	}
+
+	cached := newSourceStore()
+	cached.trees = NewTreeCache(4)
+	v1 := "package main\n\nfunc A() {}\n\nfunc B() {}\n"
+	v2 := "package main\n\nfunc A(x int) int { return x }\n\nfunc B() {}\n"
+	tree(cached, v1)
+	incremental := tree(cached, v2)
+	fresh := tree(newSourceStore(), v2)
+
+	assert.Equal(t, fresh.RootNode().String(), incremental.RootNode().String())
+	stats := cached.trees.Stats()
+	assert.Equal(t, int64(1), stats.Hits)
+	assert.Equal(t, int64(1), stats.Misses)
+	assert.Equal(t, 1, stats.Entries)
+}
+
+func TestCScopesAndRefs_StopsWhenContextIsDone(t *testing.T) {
+	s, err := store.NewStore(filepath.Join(t.TempDir(), "test.db"))
+	require.NoError(t, err)
+	defer s.Close()
+	require.NoError(t, s.Migrate())
+	fileID, err := s.InsertFile(&store.File{Path: "/big.c", Language: "c"})
+	require.NoError(t, err)
+
+	// Enough calls that the passes check the context more than once.
+	var src strings.Builder
+	for i := range 2 * cCheckEvery {
+		fmt.Fprintf(&src, "int f%d(void) { return g(%d); }\n", i, i)
+	}
+	ss := newSourceStore()
+	parsed, ok := parseSource(context.Background(), ss, "/big.c", []byte(src.String()), "c").(*object.Proxy)
+	require.True(t, ok)
+	root, err := object.NewProxy(parsed.Interface().(*sitter.Tree).RootNode())
+	require.NoError(t, err)
+	fn := makeCScopesAndRefsFn(ss, s)
+	args := []object.Object{object.NewString("c"), root, object.NewInt(fileID), object.NewMap(map[string]object.Object{})}
+
+	ctx, cancel := context.WithCancel(context.Background())
+	cancel()
+	res := fn.Call(ctx, args...)
+	require.Equal(t, object.ERROR, res.Type())
+	assert.Contains(t, res.Inspect(), context.Canceled.Error())
+
+	assert.Equal(t, object.Nil, fn.Call(context.Background(), args...))
+}
@@ -3,6 +3,7 @@ package runtime
 import (
 	"context"
 	"fmt"
+	"strconv"
 	"strings"
 
 	"github.com/risor-io/risor/object"
@@ -278,9 +279,16 @@ func makeUpdateAnnotationResolvedFn(s *store.Store) *object.Builtin {
 	})
 }
 
+// symbolReader is the symbol lookup subset shared by DataStore (extraction)
+// and ResolutionReader (resolution).
+type symbolReader interface {
+	SymbolsByName(name string) ([]*store.Symbol, error)
+	SymbolsByFile(fileID int64) ([]*store.Symbol, error)
+}
+
 // Helper to query symbols by name (needed by extraction scripts for
 // parent lookups, e.g., linking methods to receiver types).
-func makeSymbolsByNameFn(s store.DataStore) *object.Builtin {
+func makeSymbolsByNameFn(s symbolReader) *object.Builtin {
 	return object.NewBuiltin("symbols_by_name", func(ctx context.Context, args ...object.Object) object.Object {
 		if len(args) != 1 {
 			return object.NewArgsError("symbols_by_name", 1, len(args))
@@ -300,7 +308,7 @@ func makeSymbolsByNameFn(s store.DataStore) *object.Builtin {
 }
 
 // Helper to query symbols by file (needed for method-to-receiver linking).
-func makeSymbolsByFileFn(s store.DataStore) *object.Builtin {
+func makeSymbolsByFileFn(s symbolReader) *object.Builtin {
 	return object.NewBuiltin("symbols_by_file", func(ctx context.Context, args ...object.Object) object.Object {
 		if len(args) != 1 {
 			return object.NewArgsError("symbols_by_file", 1, len(args))
@@ -426,7 +434,7 @@ func toString(obj object.Object) (string, error) {
 
 // --- Resolution insert bridge functions ---
 
-func makeInsertResolvedReferenceFn(s *store.Store) *object.Builtin {
+func makeInsertResolvedReferenceFn(s store.ResolutionWriter) *object.Builtin {
 	return object.NewBuiltin("insert_resolved_reference", func(ctx context.Context, args ...object.Object) object.Object {
 		if len(args) != 1 {
 			return object.NewArgsError("insert_resolved_reference", 1, len(args))
@@ -454,7 +462,7 @@ func makeInsertResolvedReferenceFn(s *store.Store) *object.Builtin {
 	})
 }
 
-func makeInsertImplementationFn(s *store.Store) *object.Builtin {
+func makeInsertImplementationFn(s store.ResolutionWriter) *object.Builtin {
 	return object.NewBuiltin("insert_implementation", func(ctx context.Context, args ...object.Object) object.Object {
 		if len(args) != 1 {
 			return object.NewArgsError("insert_implementation", 1, len(args))
@@ -482,7 +490,7 @@ func makeInsertImplementationFn(s *store.Store) *object.Builtin {
 	})
 }
 
-func makeInsertCallEdgeFn(s *store.Store) *object.Builtin {
+func makeInsertCallEdgeFn(s store.ResolutionWriter) *object.Builtin {
 	return object.NewBuiltin("insert_call_edge", func(ctx context.Context, args ...object.Object) object.Object {
 		if len(args) != 1 {
 			return object.NewArgsError("insert_call_edge", 1, len(args))
@@ -510,7 +518,7 @@ func makeInsertCallEdgeFn(s *store.Store) *object.Builtin {
 	})
 }
 
-func makeInsertExtensionBindingFn(s *store.Store) *object.Builtin {
+func makeInsertExtensionBindingFn(s store.ResolutionWriter) *object.Builtin {
 	return object.NewBuiltin("insert_extension_binding", func(ctx context.Context, args ...object.Object) object.Object {
 		if len(args) != 1 {
 			return object.NewArgsError("insert_extension_binding", 1, len(args))
@@ -541,7 +549,7 @@ func makeInsertExtensionBindingFn(s *store.Store) *object.Builtin {
 
 // --- Resolution query bridge functions ---
 
-func makeReferencesByFileFn(s *store.Store) *object.Builtin {
+func makeReferencesByFileFn(s store.ResolutionReader) *object.Builtin {
 	return object.NewBuiltin("references_by_file", func(ctx context.Context, args ...object.Object) object.Object {
 		if len(args) != 1 {
 			return object.NewArgsError("references_by_file", 1, len(args))
@@ -556,30 +564,16 @@ func makeReferencesByFileFn(s *store.Store) *object.Builtin {
 			return object.Errorf("references_by_file: %v", queryErr)
 		}
 
-		var results []object.Object
+		conv := newRowConverter()
+		results := make([]object.Object, 0, len(refs))
 		for _, r := range refs {
-			m := map[string]object.Object{
-				"id":         object.NewInt(r.ID),
-				"name":       object.NewString(r.Name),
-				"context":    object.NewString(r.Context),
-				"start_line": object.NewInt(int64(r.StartLine)),
-				"start_col":  object.NewInt(int64(r.StartCol)),
-				"end_line":   object.NewInt(int64(r.EndLine)),
-				"end_col":    object.NewInt(int64(r.EndCol)),
-			}
-			if r.ScopeID != nil {
-				m["scope_id"] = object.NewInt(*r.ScopeID)
-			}
-			results = append(results, object.NewMap(m))
-		}
-		if results == nil {
-			results = []object.Object{}
+			results = append(results, conv.reference(r))
 		}
 		return object.NewList(results)
 	})
 }
 
-func makeScopesByFileFn(s *store.Store) *object.Builtin {
+func makeScopesByFileFn(s store.ResolutionReader) *object.Builtin {
 	return object.NewBuiltin("scopes_by_file", func(ctx context.Context, args ...object.Object) object.Object {
 		if len(args) != 1 {
 			return object.NewArgsError("scopes_by_file", 1, len(args))
@@ -594,32 +588,16 @@ func makeScopesByFileFn(s *store.Store) *object.Builtin {
 			return object.Errorf("scopes_by_file: %v", queryErr)
 		}
 
-		var results []object.Object
+		conv := newRowConverter()
+		results := make([]object.Object, 0, len(scopes))
 		for _, sc := range scopes {
-			m := map[string]object.Object{
-				"id":         object.NewInt(sc.ID),
-				"kind":       object.NewString(sc.Kind),
-				"start_line": object.NewInt(int64(sc.StartLine)),
-				"start_col":  object.NewInt(int64(sc.StartCol)),
-				"end_line":   object.NewInt(int64(sc.EndLine)),
-				"end_col":    object.NewInt(int64(sc.EndCol)),
-			}
-			if sc.SymbolID != nil {
-				m["symbol_id"] = object.NewInt(*sc.SymbolID)
-			}
-			if sc.ParentScopeID != nil {
-				m["parent_scope_id"] = object.NewInt(*sc.ParentScopeID)
-			}
-			results = append(results, object.NewMap(m))
-		}
-		if results == nil {
-			results = []object.Object{}
+			results = append(results, conv.scope(sc))
 		}
 		return object.NewList(results)
 	})
 }
 
-func makeImportsByFileFn(s *store.Store) *object.Builtin {
+func makeImportsByFileFn(s store.ResolutionReader) *object.Builtin {
 	return object.NewBuiltin("imports_by_file", func(ctx context.Context, args ...object.Object) object.Object {
 		if len(args) != 1 {
 			return object.NewArgsError("imports_by_file", 1, len(args))
@@ -634,29 +612,16 @@ func makeImportsByFileFn(s *store.Store) *object.Builtin {
 			return object.Errorf("imports_by_file: %v", queryErr)
 		}
 
-		var results []object.Object
+		conv := newRowConverter()
+		results := make([]object.Object, 0, len(imports))
 		for _, imp := range imports {
-			m := map[string]object.Object{
-				"id":     object.NewInt(imp.ID),
-				"source": object.NewString(imp.Source),
-				"kind":   object.NewString(imp.Kind),
-			}
-			if imp.ImportedName != nil {
-				m["imported_name"] = object.NewString(*imp.ImportedName)
-			}
-			if imp.LocalAlias != nil {
-				m["local_alias"] = object.NewString(*imp.LocalAlias)
-			}
-			results = append(results, object.NewMap(m))
-		}
-		if results == nil {
-			results = []object.Object{}
+			results = append(results, conv.importRow(imp))
 		}
 		return object.NewList(results)
 	})
 }
 
-func makeTypeMembersFn(s *store.Store) *object.Builtin {
+func makeTypeMembersFn(s store.ResolutionReader) *object.Builtin {
 	return object.NewBuiltin("type_members", func(ctx context.Context, args ...object.Object) object.Object {
 		if len(args) != 1 {
 			return object.NewArgsError("type_members", 1, len(args))
@@ -688,7 +653,7 @@ func makeTypeMembersFn(s *store.Store) *object.Builtin {
 	})
 }
 
-func makeFilesByLanguageFn(s *store.Store) *object.Builtin {
+func makeFilesByLanguageFn(s store.ResolutionReader) *object.Builtin {
 	return object.NewBuiltin("files_by_language", func(ctx context.Context, args ...object.Object) object.Object {
 		if len(args) != 1 {
 			return object.NewArgsError("files_by_language", 1, len(args))
@@ -703,18 +668,7 @@ func makeFilesByLanguageFn(s *store.Store) *object.Builtin {
 			return object.Errorf("files_by_language: %v", queryErr)
 		}
 
-		var results []object.Object
-		for _, f := range files {
-			results = append(results, object.NewMap(map[string]object.Object{
-				"id":       object.NewInt(f.ID),
-				"path":     object.NewString(f.Path),
-				"language": object.NewString(f.Language),
-			}))
-		}
-		if results == nil {
-			results = []object.Object{}
-		}
-		return object.NewList(results)
+		return filesToList(files)
 	})
 }
 
@@ -737,25 +691,46 @@ func MakeFilesToResolveFn(s *store.Store, blastFileIDs map[int64]bool) any {
 			return object.Errorf("files_to_resolve: %v", queryErr)
 		}
 
-		var results []object.Object
+		var selected []*store.File
 		for _, f := range files {
 			if blastFileIDs != nil && !blastFileIDs[f.ID] {
 				continue
 			}
-			results = append(results, object.NewMap(map[string]object.Object{
-				"id":       object.NewInt(f.ID),
-				"path":     object.NewString(f.Path),
-				"language": object.NewString(f.Language),
-			}))
+			selected = append(selected, f)
 		}
-		if results == nil {
-			results = []object.Object{}
+		return filesToList(selected)
+	})
+}
+
+// MakeFileListFn creates a files_to_resolve function that returns a fixed
+// file list, ignoring the language argument. The engine uses it to hand each
+// resolution shard its own slice of a language's files.
+func MakeFileListFn(files []*store.File) any {
+	return object.NewBuiltin("files_to_resolve", func(ctx context.Context, args ...object.Object) object.Object {
+		if len(args) != 1 {
+			return object.NewArgsError("files_to_resolve", 1, len(args))
 		}
-		return object.NewList(results)
+		if _, err := toString(args[0]); err != nil {
+			return object.Errorf("files_to_resolve: %v", err)
+		}
+		return filesToList(files)
 	})
 }
 
-func makeSymbolsByKindFn(s *store.Store) *object.Builtin {
+// filesToList converts files to a Risor list of {id, path, language} maps.
+func filesToList(files []*store.File) object.Object {
+	results := make([]object.Object, 0, len(files))
+	for _, f := range files {
+		results = append(results, object.NewMap(map[string]object.Object{
+			"id":       object.NewInt(f.ID),
+			"path":     object.NewString(f.Path),
+			"language": object.NewString(f.Language),
+		}))
+	}
+	return object.NewList(results)
+}
+
+func makeSymbolsByKindFn(s store.ResolutionReader) *object.Builtin {
 	return object.NewBuiltin("symbols_by_kind", func(ctx context.Context, args ...object.Object) object.Object {
 		if len(args) != 1 {
 			return object.NewArgsError("symbols_by_kind", 1, len(args))
@@ -774,7 +749,7 @@ func makeSymbolsByKindFn(s *store.Store) *object.Builtin {
 	})
 }
 
-func makeScopeChainFn(s *store.Store) *object.Builtin {
+func makeScopeChainFn(s store.ResolutionReader) *object.Builtin {
 	return object.NewBuiltin("scope_chain", func(ctx context.Context, args ...object.Object) object.Object {
 		if len(args) != 1 {
 			return object.NewArgsError("scope_chain", 1, len(args))
@@ -789,32 +764,16 @@ func makeScopeChainFn(s *store.Store) *object.Builtin {
 			return object.Errorf("scope_chain: %v", queryErr)
 		}
 
-		var results []object.Object
+		conv := newRowConverter()
+		results := make([]object.Object, 0, len(chain))
 		for _, sc := range chain {
-			m := map[string]object.Object{
-				"id":         object.NewInt(sc.ID),
-				"kind":       object.NewString(sc.Kind),
-				"start_line": object.NewInt(int64(sc.StartLine)),
-				"start_col":  object.NewInt(int64(sc.StartCol)),
-				"end_line":   object.NewInt(int64(sc.EndLine)),
-				"end_col":    object.NewInt(int64(sc.EndCol)),
-			}
-			if sc.SymbolID != nil {
-				m["symbol_id"] = object.NewInt(*sc.SymbolID)
-			}
-			if sc.ParentScopeID != nil {
-				m["parent_scope_id"] = object.NewInt(*sc.ParentScopeID)
-			}
-			results = append(results, object.NewMap(m))
-		}
-		if results == nil {
-			results = []object.Object{}
+			results = append(results, conv.scope(sc))
 		}
 		return object.NewList(results)
 	})
 }
 
-func makeBatchScopeChainsFn(s *store.Store) *object.Builtin {
+func makeBatchScopeChainsFn(s store.ResolutionReader) *object.Builtin {
 	return object.NewBuiltin("batch_scope_chains", func(ctx context.Context, args ...object.Object) object.Object {
 		if len(args) != 1 {
 			return object.NewArgsError("batch_scope_chains", 1, len(args))
@@ -829,56 +788,88 @@ func makeBatchScopeChainsFn(s *store.Store) *object.Builtin {
 			return object.Errorf("batch_scope_chains: %v", queryErr)
 		}
 
-		// Build lookup map: scope ID → *Scope
-		byID := make(map[int64]*store.Scope, len(scopes))
-		for _, sc := range scopes {
-			byID[sc.ID] = sc
-		}
-
-		// Convert each scope to a Risor map (same format as makeScopeChainFn).
-		toRisorMap := func(sc *store.Scope) object.Object {
-			m := map[string]object.Object{
-				"id":         object.NewInt(sc.ID),
-				"kind":       object.NewString(sc.Kind),
-				"start_line": object.NewInt(int64(sc.StartLine)),
-				"start_col":  object.NewInt(int64(sc.StartCol)),
-				"end_line":   object.NewInt(int64(sc.EndLine)),
-				"end_col":    object.NewInt(int64(sc.EndCol)),
+		return newRowConverter().scopeChains(scopes)
+	})
+}
+
+// makeLoadLanguageSnapshotFn exposes load_language_snapshot(lang): every
+// file of lang with its rows, loaded with one query per table (see
+// store.LanguageSnapshot) instead of a call per table and file. The result
+// is a map of
+//
+//	files:        the files, as files_by_language returns them
+//	symbols:      file ID string → symbols_by_file list
+//	scopes:       file ID string → scopes_by_file list
+//	references:   file ID string → references_by_file list
+//	imports:      file ID string → imports_by_file list
+//	scope_chains: file ID string → batch_scope_chains map
+//
+// Rows are converted with one converter for the whole snapshot, so strings
+// and scopes are shared across files, tables and chains.
+func makeLoadLanguageSnapshotFn(s store.ResolutionReader) *object.Builtin {
+	return object.NewBuiltin("load_language_snapshot", func(ctx context.Context, args ...object.Object) object.Object {
+		if len(args) != 1 {
+			return object.NewArgsError("load_language_snapshot", 1, len(args))
+		}
+		lang, err := toString(args[0])
+		if err != nil {
+			return object.Errorf("load_language_snapshot: %v", err)
+		}
+
+		sn, queryErr := s.LanguageSnapshot(lang)
+		if queryErr != nil {
+			return object.Errorf("load_language_snapshot: %v", queryErr)
+		}
+
+		conv := newRowConverter()
+		n := len(sn.Files)
+		symbols := make(map[string]object.Object, n)
+		scopes := make(map[string]object.Object, n)
+		references := make(map[string]object.Object, n)
+		imports := make(map[string]object.Object, n)
+		chains := make(map[string]object.Object, n)
+		for _, f := range sn.Files {
+			fs := sn.File(f.ID)
+			key := strconv.FormatInt(f.ID, 10)
+
+			list := make([]object.Object, len(fs.Symbols))
+			for i, sym := range fs.Symbols {
+				list[i] = conv.symbol(sym)
 			}
-			if sc.SymbolID != nil {
-				m["symbol_id"] = object.NewInt(*sc.SymbolID)
+			symbols[key] = object.NewList(list)
+
+			list = make([]object.Object, len(fs.Scopes))
+			for i, sc := range fs.Scopes {
+				list[i] = conv.scope(sc)
 			}
-			if sc.ParentScopeID != nil {
-				m["parent_scope_id"] = object.NewInt(*sc.ParentScopeID)
+			scopes[key] = object.NewList(list)
+
+			list = make([]object.Object, len(fs.References))
+			for i, r := range fs.References {
+				list[i] = conv.reference(r)
 			}
-			return object.NewMap(m)
-		}
+			references[key] = object.NewList(list)
 
-		// For each scope, walk parent chain in-memory and build the chain list.
-		result := make(map[string]object.Object, len(scopes))
-		for _, sc := range scopes {
-			var chain []object.Object
-			cur := sc
-			seen := make(map[int64]bool)
-			for cur != nil {
-				if seen[cur.ID] {
-					break // prevent infinite loop on cycles
-				}
-				seen[cur.ID] = true
-				chain = append(chain, toRisorMap(cur))
-				if cur.ParentScopeID == nil {
-					break
-				}
-				cur = byID[*cur.ParentScopeID]
+			list = make([]object.Object, len(fs.Imports))
+			for i, imp := range fs.Imports {
+				list[i] = conv.importRow(imp)
 			}
-			key := fmt.Sprintf("%d", sc.ID)
-			result[key] = object.NewList(chain)
-		}
-		return object.NewMap(result)
+			imports[key] = object.NewList(list)
+
+			chains[key] = conv.scopeChains(fs.Scopes)
+		}
+		return object.NewMap(map[string]object.Object{
+			"files":        filesToList(sn.Files),
+			"symbols":      object.NewMap(symbols),
+			"scopes":       object.NewMap(scopes),
+			"references":   object.NewMap(references),
+			"imports":      object.NewMap(imports),
+			"scope_chains": object.NewMap(chains),
+		})
 	})
 }
 
-func makeFunctionParamsFn(s *store.Store) *object.Builtin {
+func makeFunctionParamsFn(s store.ResolutionReader) *object.Builtin {
 	return object.NewBuiltin("function_params", func(ctx context.Context, args ...object.Object) object.Object {
 		if len(args) != 1 {
 			return object.NewArgsError("function_params", 1, len(args))
@@ -913,8 +904,10 @@ func makeFunctionParamsFn(s *store.Store) *object.Builtin {
 }
 
 // makeDBQueryFn creates a db_query bridge that executes arbitrary read-only SQL.
-// Returns a list of maps (column name → value).
-func makeDBQueryFn(s *store.Store) *object.Builtin {
+// Returns a list of maps (column name → value). When batch is non-nil, rows
+// it has buffered for a table the query mentions are flushed first so the
+// script reads its own writes.
+func makeDBQueryFn(s *store.Store, batch *store.ResolutionBatch) *object.Builtin {
 	return object.NewBuiltin("db_query", func(ctx context.Context, args ...object.Object) object.Object {
 		if len(args) < 1 {
 			return object.Errorf("db_query: expected at least 1 argument (sql), got %d", len(args))
@@ -949,7 +942,13 @@ func makeDBQueryFn(s *store.Store) *object.Builtin {
 			}
 		}
 
-		rows, queryErr := s.DB().QueryContext(ctx, sqlStr, queryArgs...)
+		if batch != nil {
+			if err := batch.FlushIfReads(sqlStr); err != nil {
+				return object.Errorf("db_query: %v", err)
+			}
+		}
+
+		rows, queryErr := s.ReadDB().QueryContext(ctx, sqlStr, queryArgs...)
 		if queryErr != nil {
 			return object.Errorf("db_query: %v", queryErr)
 		}
@@ -1009,28 +1008,10 @@ func sqlValueToObject(v any) object.Object {
 
 // symbolsToList converts a slice of store.Symbol to a Risor list of maps.
 func symbolsToList(syms []*store.Symbol) object.Object {
-	var results []object.Object
+	conv := newRowConverter()
+	results := make([]object.Object, 0, len(syms))
 	for _, sym := range syms {
-		m := map[string]object.Object{
-			"id":         object.NewInt(sym.ID),
-			"name":       object.NewString(sym.Name),
-			"kind":       object.NewString(sym.Kind),
-			"visibility": object.NewString(sym.Visibility),
-			"start_line": object.NewInt(int64(sym.StartLine)),
-			"start_col":  object.NewInt(int64(sym.StartCol)),
-			"end_line":   object.NewInt(int64(sym.EndLine)),
-			"end_col":    object.NewInt(int64(sym.EndCol)),
-		}
-		if sym.FileID != nil {
-			m["file_id"] = object.NewInt(*sym.FileID)
-		}
-		if sym.ParentSymbolID != nil {
-			m["parent_symbol_id"] = object.NewInt(*sym.ParentSymbolID)
-		}
-		results = append(results, object.NewMap(m))
-	}
-	if results == nil {
-		results = []object.Object{}
+		results = append(results, conv.symbol(sym))
 	}
 	return object.NewList(results)
 }
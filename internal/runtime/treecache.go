@@ -0,0 +1,138 @@
+package runtime
+
+import (
+	"container/list"
+	"sync"
+	"sync/atomic"
+
+	sitter "github.com/smacker/go-tree-sitter"
+)
+
+// TreeCache keeps the most recent parse tree of recently parsed files so a
+// re-parse of the same file (watch mode, a daemon re-indexing hot files)
+// can be incremental: the edit between the cached and the new content is
+// applied to a copy of the cached tree, which tree-sitter then uses to
+// reuse every subtree outside the edited range.
+//
+// A TreeCache may be shared by many Runtimes and is safe for concurrent
+// use. Cached trees are never handed to scripts; each parse works on its
+// own copy.
+type TreeCache struct {
+	mu      sync.Mutex
+	max     int
+	entries map[string]*list.Element // path → element holding *treeEntry
+	lru     *list.List               // front = most recently used
+
+	hits   atomic.Int64
+	misses atomic.Int64
+}
+
+type treeEntry struct {
+	path string
+	lang *sitter.Language
+	src  []byte
+	tree *sitter.Tree
+}
+
+// DefaultTreeCacheEntries is the number of trees kept by a TreeCache
+// created with a non-positive size.
+const DefaultTreeCacheEntries = 256
+
+// NewTreeCache creates a TreeCache holding at most entries trees.
+func NewTreeCache(entries int) *TreeCache {
+	if entries <= 0 {
+		entries = DefaultTreeCacheEntries
+	}
+	return &TreeCache{max: entries, entries: make(map[string]*list.Element), lru: list.New()}
+}
+
+// Stats returns hit/miss counters; a hit is a parse that started from a
+// cached tree.
+func (c *TreeCache) Stats() CacheStats {
+	c.mu.Lock()
+	n := c.lru.Len()
+	c.mu.Unlock()
+	return CacheStats{Hits: c.hits.Load(), Misses: c.misses.Load(), Entries: n}
+}
+
+// previous returns an edited copy of the cached tree for path, ready to be
+// passed to ParseCtx for src, or nil if there is no usable cached tree.
+func (c *TreeCache) previous(path string, lang *sitter.Language, src []byte) *sitter.Tree {
+	c.mu.Lock()
+	el, ok := c.entries[path]
+	var e *treeEntry
+	var old *sitter.Tree
+	if ok {
+		e = el.Value.(*treeEntry)
+		if e.lang == lang {
+			c.lru.MoveToFront(el)
+			old = e.tree.Copy()
+		}
+	}
+	c.mu.Unlock()
+	if old == nil {
+		c.misses.Add(1)
+		return nil
+	}
+	c.hits.Add(1)
+	old.Edit(editBetween(e.src, src))
+	return old
+}
+
+// put records tree as the latest parse of path. tree must not be used by
+// the caller afterwards except through copies; put keeps its own copy.
+func (c *TreeCache) put(path string, lang *sitter.Language, src []byte, tree *sitter.Tree) {
+	e := &treeEntry{path: path, lang: lang, src: src, tree: tree.Copy()}
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if el, ok := c.entries[path]; ok {
+		el.Value = e
+		c.lru.MoveToFront(el)
+		return
+	}
+	c.entries[path] = c.lru.PushFront(e)
+	for c.lru.Len() > c.max {
+		oldest := c.lru.Back()
+		c.lru.Remove(oldest)
+		delete(c.entries, oldest.Value.(*treeEntry).path)
+	}
+}
+
+// editBetween describes the change from old to new as a single edit
+// spanning everything between their common prefix and common suffix.
+func editBetween(old, new []byte) sitter.EditInput {
+	n := min(len(old), len(new))
+	start := 0
+	for start < n && old[start] == new[start] {
+		start++
+	}
+	suffix := 0
+	for suffix < n-start && old[len(old)-1-suffix] == new[len(new)-1-suffix] {
+		suffix++
+	}
+	oldEnd, newEnd := len(old)-suffix, len(new)-suffix
+
+	startPoint := pointAt(old, 0, start, sitter.Point{})
+	return sitter.EditInput{
+		StartIndex:  uint32(start),
+		OldEndIndex: uint32(oldEnd),
+		NewEndIndex: uint32(newEnd),
+		StartPoint:  startPoint,
+		OldEndPoint: pointAt(old, start, oldEnd, startPoint),
+		NewEndPoint: pointAt(new, start, newEnd, startPoint),
+	}
+}
+
+// pointAt advances p (the point at byte offset from) to byte offset to.
+// Columns are byte offsets, as tree-sitter expects.
+func pointAt(src []byte, from, to int, p sitter.Point) sitter.Point {
+	for i := from; i < to; i++ {
+		if src[i] == '\n' {
+			p.Row++
+			p.Column = 0
+		} else {
+			p.Column++
+		}
+	}
+	return p
+}
@@ -1,30 +1,42 @@
 package store
 
-import "sync"
+import "unsafe"
 
 // BatchedStore buffers extraction inserts in memory using fake (negative)
 // IDs. It implements DataStore so extraction scripts can write to it
 // without knowing whether they're hitting SQLite or an in-memory buffer.
 //
-// Thread safety: the mutex protects fake ID allocation and slice appends.
-// Read queries (SymbolsByName, SymbolsByFile) are passed through to the
-// underlying Store, which is safe for concurrent reads.
+// Symbols, scopes and references, the bulk of every file's rows, are held
+// column-wise with interned strings (see columns.go); the low-volume child
+// tables are plain row slices.
+//
+// A BatchedStore is owned by the one worker extracting into it and is not
+// safe for concurrent use. Read queries (SymbolsByName, SymbolsByFile) go
+// to the SymbolTable shared by the run's workers if one is set (see
+// UseSymbolTable), and are passed through to the underlying Store, which
+// is safe for concurrent reads, otherwise.
 type BatchedStore struct {
-	store *Store // for read passthrough
-	mu    sync.Mutex
+	store  *Store       // for read passthrough
+	symtab *SymbolTable // for cross-file reads; nil passes them through
 
 	// Buffered extraction data.
-	Symbols         []Symbol
-	Scopes          []Scope
-	References      []Reference
-	Imports         []Import
-	TypeMembers     []TypeMember
-	FunctionParams  []FunctionParam
-	TypeParams      []TypeParam
-	Annotations     []Annotation
-	SymbolFragments []SymbolFragment
+	strs       strtab
+	symbols    symbolColumns
+	scopes     scopeColumns
+	references referenceColumns
+
+	imports         []Import
+	typeMembers     []TypeMember
+	functionParams  []FunctionParam
+	typeParams      []TypeParam
+	annotations     []Annotation
+	symbolFragments []SymbolFragment
 
 	nextFakeID int64 // starts at -1, decrements
+
+	// replacing is the file being re-extracted in place, whose stored
+	// symbols are hidden from SymbolsByFile; 0 when none (see ReplaceFile).
+	replacing int64
 }
 
 // Compile-time check: *BatchedStore satisfies DataStore.
@@ -38,6 +50,38 @@ func NewBatchedStore(s *Store) *BatchedStore {
 	}
 }
 
+// Typical rows per source line, measured across the bundled languages and
+// rounded up; used to presize the columns.
+const (
+	symbolsPerLine    = 0.15
+	scopesPerLine     = 0.1
+	referencesPerLine = 1.0
+)
+
+// Reserve preallocates the columns for a file of the given line count, so
+// a typical extraction appends without regrowing them.
+func (b *BatchedStore) Reserve(lines int) {
+	b.symbols.grow(int(float64(lines) * symbolsPerLine))
+	b.scopes.grow(int(float64(lines) * scopesPerLine))
+	b.references.grow(int(float64(lines) * referencesPerLine))
+}
+
+// ReplaceFile marks fileID as being re-extracted in place for
+// Store.PatchFile: SymbolsByFile then returns only the buffered symbols for
+// it, not the stored rows the new extraction is replacing. Call before the
+// extraction script runs. For a newly inserted file, which has no stored
+// rows, it saves the lookup.
+func (b *BatchedStore) ReplaceFile(fileID int64) {
+	b.replacing = fileID
+}
+
+// UseSymbolTable answers the batch's cross-file reads from t, which also
+// holds the symbols other workers of the run have extracted but not yet
+// committed. Call before the extraction script runs.
+func (b *BatchedStore) UseSymbolTable(t *SymbolTable) {
+	b.symtab = t
+}
+
 func (b *BatchedStore) allocFakeID() int64 {
 	id := b.nextFakeID
 	b.nextFakeID--
@@ -45,104 +89,270 @@ func (b *BatchedStore) allocFakeID() int64 {
 }
 
 func (b *BatchedStore) InsertSymbol(sym *Symbol) (int64, error) {
-	b.mu.Lock()
-	defer b.mu.Unlock()
-	fakeID := b.allocFakeID()
-	sym.ID = fakeID
-	b.Symbols = append(b.Symbols, *sym)
-	return fakeID, nil
+	sym.ID = b.allocFakeID()
+	b.symbols.add(&b.strs, sym)
+	return sym.ID, nil
 }
 
 func (b *BatchedStore) InsertScope(scope *Scope) (int64, error) {
-	b.mu.Lock()
-	defer b.mu.Unlock()
-	fakeID := b.allocFakeID()
-	scope.ID = fakeID
-	b.Scopes = append(b.Scopes, *scope)
-	return fakeID, nil
+	scope.ID = b.allocFakeID()
+	b.scopes.add(&b.strs, scope)
+	return scope.ID, nil
 }
 
 func (b *BatchedStore) InsertReference(ref *Reference) (int64, error) {
-	b.mu.Lock()
-	defer b.mu.Unlock()
-	fakeID := b.allocFakeID()
-	ref.ID = fakeID
-	b.References = append(b.References, *ref)
-	return fakeID, nil
+	ref.ID = b.allocFakeID()
+	b.references.add(&b.strs, ref)
+	return ref.ID, nil
 }
 
 func (b *BatchedStore) InsertImport(imp *Import) (int64, error) {
-	b.mu.Lock()
-	defer b.mu.Unlock()
-	fakeID := b.allocFakeID()
-	imp.ID = fakeID
-	b.Imports = append(b.Imports, *imp)
-	return fakeID, nil
+	imp.ID = b.allocFakeID()
+	b.imports = append(b.imports, *imp)
+	return imp.ID, nil
 }
 
 func (b *BatchedStore) InsertTypeMember(tm *TypeMember) (int64, error) {
-	b.mu.Lock()
-	defer b.mu.Unlock()
-	fakeID := b.allocFakeID()
-	tm.ID = fakeID
-	b.TypeMembers = append(b.TypeMembers, *tm)
-	return fakeID, nil
+	tm.ID = b.allocFakeID()
+	b.typeMembers = append(b.typeMembers, *tm)
+	return tm.ID, nil
 }
 
 func (b *BatchedStore) InsertFunctionParam(fp *FunctionParam) (int64, error) {
-	b.mu.Lock()
-	defer b.mu.Unlock()
-	fakeID := b.allocFakeID()
-	fp.ID = fakeID
-	b.FunctionParams = append(b.FunctionParams, *fp)
-	return fakeID, nil
+	fp.ID = b.allocFakeID()
+	b.functionParams = append(b.functionParams, *fp)
+	return fp.ID, nil
 }
 
 func (b *BatchedStore) InsertTypeParam(tp *TypeParam) (int64, error) {
-	b.mu.Lock()
-	defer b.mu.Unlock()
-	fakeID := b.allocFakeID()
-	tp.ID = fakeID
-	b.TypeParams = append(b.TypeParams, *tp)
-	return fakeID, nil
+	tp.ID = b.allocFakeID()
+	b.typeParams = append(b.typeParams, *tp)
+	return tp.ID, nil
 }
 
 func (b *BatchedStore) InsertAnnotation(ann *Annotation) (int64, error) {
-	b.mu.Lock()
-	defer b.mu.Unlock()
-	fakeID := b.allocFakeID()
-	ann.ID = fakeID
-	b.Annotations = append(b.Annotations, *ann)
-	return fakeID, nil
+	ann.ID = b.allocFakeID()
+	b.annotations = append(b.annotations, *ann)
+	return ann.ID, nil
 }
 
 func (b *BatchedStore) InsertSymbolFragment(frag *SymbolFragment) (int64, error) {
-	b.mu.Lock()
-	defer b.mu.Unlock()
-	fakeID := b.allocFakeID()
-	frag.ID = fakeID
-	b.SymbolFragments = append(b.SymbolFragments, *frag)
-	return fakeID, nil
+	frag.ID = b.allocFakeID()
+	b.symbolFragments = append(b.symbolFragments, *frag)
+	return frag.ID, nil
+}
+
+// Rows materializes the buffered rows, e.g. for Store.PatchFile.
+func (b *BatchedStore) Rows() *FileRows {
+	r := &FileRows{
+		Symbols:         make([]Symbol, b.symbols.len()),
+		Scopes:          make([]Scope, b.scopes.len()),
+		References:      make([]Reference, b.references.len()),
+		Imports:         b.imports,
+		TypeMembers:     b.typeMembers,
+		FunctionParams:  b.functionParams,
+		TypeParams:      b.typeParams,
+		Annotations:     b.annotations,
+		SymbolFragments: b.symbolFragments,
+	}
+	for i := range r.Symbols {
+		r.Symbols[i] = b.symbols.row(&b.strs, i)
+	}
+	for i := range r.Scopes {
+		r.Scopes[i] = b.scopes.row(&b.strs, i)
+	}
+	for i := range r.References {
+		r.References[i] = b.references.row(&b.strs, i)
+	}
+	return r
+}
+
+// CopyRows buffers a copy of r, the rows extracted for file from, as the
+// rows of file to: for files with identical content, whose extraction is
+// the same apart from the file. Rows get fresh fake IDs, and IDs pointing
+// at rows of r, or at from, are redirected to the copies.
+func (b *BatchedStore) CopyRows(r *FileRows, from, to int64) {
+	// Stored symbols and scopes can share IDs, so each table has its own map.
+	symIDs := make(map[int64]int64, len(r.Symbols))
+	for i := range r.Symbols {
+		symIDs[r.Symbols[i].ID] = b.allocFakeID()
+	}
+	scopeIDs := make(map[int64]int64, len(r.Scopes))
+	for i := range r.Scopes {
+		scopeIDs[r.Scopes[i].ID] = b.allocFakeID()
+	}
+	remap := func(ids map[int64]int64, id int64) int64 {
+		if n, ok := ids[id]; ok {
+			return n
+		}
+		return id
+	}
+	remapPtr := func(ids map[int64]int64, id *int64) *int64 {
+		if id == nil {
+			return nil
+		}
+		n := remap(ids, *id)
+		return &n
+	}
+	file := func(id int64) int64 {
+		if id == from {
+			return to
+		}
+		return id
+	}
+
+	b.symbols.grow(len(r.Symbols))
+	for _, sym := range r.Symbols {
+		sym.ID = symIDs[sym.ID]
+		if sym.FileID != nil {
+			fid := file(*sym.FileID)
+			sym.FileID = &fid
+		}
+		sym.ParentSymbolID = remapPtr(symIDs, sym.ParentSymbolID)
+		b.symbols.add(&b.strs, &sym)
+	}
+	b.scopes.grow(len(r.Scopes))
+	for _, sc := range r.Scopes {
+		sc.ID = scopeIDs[sc.ID]
+		sc.FileID = file(sc.FileID)
+		sc.SymbolID = remapPtr(symIDs, sc.SymbolID)
+		sc.ParentScopeID = remapPtr(scopeIDs, sc.ParentScopeID)
+		b.scopes.add(&b.strs, &sc)
+	}
+	b.references.grow(len(r.References))
+	for _, ref := range r.References {
+		ref.ID = b.allocFakeID()
+		ref.FileID = file(ref.FileID)
+		ref.ScopeID = remapPtr(scopeIDs, ref.ScopeID)
+		b.references.add(&b.strs, &ref)
+	}
+	for _, imp := range r.Imports {
+		imp.ID = b.allocFakeID()
+		imp.FileID = file(imp.FileID)
+		b.imports = append(b.imports, imp)
+	}
+	for _, tm := range r.TypeMembers {
+		tm.ID = b.allocFakeID()
+		tm.SymbolID = remap(symIDs, tm.SymbolID)
+		b.typeMembers = append(b.typeMembers, tm)
+	}
+	for _, fp := range r.FunctionParams {
+		fp.ID = b.allocFakeID()
+		fp.SymbolID = remap(symIDs, fp.SymbolID)
+		b.functionParams = append(b.functionParams, fp)
+	}
+	for _, tp := range r.TypeParams {
+		tp.ID = b.allocFakeID()
+		tp.SymbolID = remap(symIDs, tp.SymbolID)
+		b.typeParams = append(b.typeParams, tp)
+	}
+	for _, ann := range r.Annotations {
+		ann.ID = b.allocFakeID()
+		ann.TargetSymbolID = remap(symIDs, ann.TargetSymbolID)
+		ann.ResolvedSymbolID = remapPtr(symIDs, ann.ResolvedSymbolID)
+		if ann.FileID != nil {
+			fid := file(*ann.FileID)
+			ann.FileID = &fid
+		}
+		b.annotations = append(b.annotations, ann)
+	}
+	for _, sf := range r.SymbolFragments {
+		sf.ID = b.allocFakeID()
+		sf.SymbolID = remap(symIDs, sf.SymbolID)
+		sf.FileID = file(sf.FileID)
+		b.symbolFragments = append(b.symbolFragments, sf)
+	}
+}
+
+// batchFromRows buffers rows as they are, IDs included: fake IDs are
+// remapped on commit, real ones written through.
+func batchFromRows(s *Store, r *FileRows) *BatchedStore {
+	b := NewBatchedStore(s)
+	b.symbols.grow(len(r.Symbols))
+	for i := range r.Symbols {
+		b.symbols.add(&b.strs, &r.Symbols[i])
+	}
+	b.scopes.grow(len(r.Scopes))
+	for i := range r.Scopes {
+		b.scopes.add(&b.strs, &r.Scopes[i])
+	}
+	b.references.grow(len(r.References))
+	for i := range r.References {
+		b.references.add(&b.strs, &r.References[i])
+	}
+	b.imports = r.Imports
+	b.typeMembers = r.TypeMembers
+	b.functionParams = r.FunctionParams
+	b.typeParams = r.TypeParams
+	b.annotations = r.Annotations
+	b.symbolFragments = r.SymbolFragments
+	return b
 }
 
-// SymbolsByName passes through to the underlying Store for cross-file lookups.
+// SymbolsByName returns the symbols named name across files. Without a
+// SymbolTable it passes through to the underlying Store; with one, the
+// batch's own buffered symbols of that name are included too.
 func (b *BatchedStore) SymbolsByName(name string) ([]*Symbol, error) {
-	return b.store.SymbolsByName(name)
+	if b.symtab == nil {
+		return b.store.SymbolsByName(name)
+	}
+	syms, err := b.symtab.SymbolsByName(name)
+	if err != nil {
+		return nil, err
+	}
+	if id, ok := b.strs.ids[name]; ok {
+		for i, n := range b.symbols.name {
+			if n == id {
+				sym := b.symbols.row(&b.strs, i)
+				syms = append(syms, &sym)
+			}
+		}
+	}
+	return syms, nil
 }
 
 // SymbolsByFile returns symbols for a file, merging any buffered (not yet
-// committed) symbols with those already in the database.
+// committed) symbols with those already in the database, or in the
+// SymbolTable if one is set.
 func (b *BatchedStore) SymbolsByFile(fileID int64) ([]*Symbol, error) {
-	dbSyms, err := b.store.SymbolsByFile(fileID)
-	if err != nil {
-		return nil, err
+	var dbSyms []*Symbol
+	if fileID != b.replacing {
+		read := b.store.SymbolsByFile
+		if b.symtab != nil {
+			read = b.symtab.SymbolsByFile
+		}
+		var err error
+		if dbSyms, err = read(fileID); err != nil {
+			return nil, err
+		}
 	}
-	b.mu.Lock()
-	defer b.mu.Unlock()
-	for i := range b.Symbols {
-		if b.Symbols[i].FileID != nil && *b.Symbols[i].FileID == fileID {
-			dbSyms = append(dbSyms, &b.Symbols[i])
+	for i, fid := range b.symbols.fileID {
+		if fid == fileID {
+			sym := b.symbols.row(&b.strs, i)
+			dbSyms = append(dbSyms, &sym)
 		}
 	}
 	return dbSyms, nil
 }
+
+// Bytes per buffered row of each columnar table, for size estimates.
+const (
+	symbolRow    = 3*8 + 5*4 + 4*4
+	scopeRow     = 4*8 + 4 + 4*4
+	referenceRow = 3*8 + 2*4 + 4*4
+)
+
+// SizeEstimate returns a rough count of the bytes held by the buffered
+// rows: the columns and row structs plus the interned strings.
+func (b *BatchedStore) SizeEstimate() int64 {
+	return int64(b.symbols.len())*symbolRow +
+		int64(b.scopes.len())*scopeRow +
+		int64(b.references.len())*referenceRow +
+		int64(len(b.imports))*int64(unsafe.Sizeof(Import{})) +
+		int64(len(b.typeMembers))*int64(unsafe.Sizeof(TypeMember{})) +
+		int64(len(b.functionParams))*int64(unsafe.Sizeof(FunctionParam{})) +
+		int64(len(b.typeParams))*int64(unsafe.Sizeof(TypeParam{})) +
+		int64(len(b.annotations))*int64(unsafe.Sizeof(Annotation{})) +
+		int64(len(b.symbolFragments))*int64(unsafe.Sizeof(SymbolFragment{})) +
+		b.strs.size + int64(len(b.strs.strs))*int64(unsafe.Sizeof(""))
+}
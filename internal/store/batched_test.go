@@ -83,3 +83,201 @@ func TestBatchedStore_SymbolsByFile_DoesNotReturnOtherFiles(t *testing.T) {
 	require.Len(t, syms, 1)
 	assert.Equal(t, "InFileA", syms[0].Name)
 }
+
+func TestCommitBatches_CommitsEachBatchWithOwnFakeIDs(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	f1 := insertTestFile(t, s, "/a.go", "go")
+	f2 := insertTestFile(t, s, "/b.go", "go")
+
+	// Both batches start their fake IDs at -1, so remapping must be per batch.
+	b1 := NewBatchedStore(s)
+	sym1, err := b1.InsertSymbol(&Symbol{FileID: &f1.ID, Name: "A", Kind: "function"})
+	require.NoError(t, err)
+	_, err = b1.InsertScope(&Scope{FileID: f1.ID, SymbolID: &sym1, Kind: "function"})
+	require.NoError(t, err)
+
+	b2 := NewBatchedStore(s)
+	sym2, err := b2.InsertSymbol(&Symbol{FileID: &f2.ID, Name: "B", Kind: "function"})
+	require.NoError(t, err)
+	_, err = b2.InsertScope(&Scope{FileID: f2.ID, SymbolID: &sym2, Kind: "function"})
+	require.NoError(t, err)
+	assert.Equal(t, sym1, sym2)
+
+	require.NoError(t, s.CommitBatches([]*BatchedStore{b1, b2}))
+
+	for _, tc := range []struct {
+		fileID int64
+		name   string
+	}{{f1.ID, "A"}, {f2.ID, "B"}} {
+		syms, err := s.SymbolsByFile(tc.fileID)
+		require.NoError(t, err)
+		require.Len(t, syms, 1)
+		assert.Equal(t, tc.name, syms[0].Name)
+
+		scopes, err := s.ScopesByFile(tc.fileID)
+		require.NoError(t, err)
+		require.Len(t, scopes, 1)
+		require.NotNil(t, scopes[0].SymbolID)
+		assert.Equal(t, syms[0].ID, *scopes[0].SymbolID)
+	}
+}
+
+func TestCommitBatches_RollsBackAllOnError(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	f1 := insertTestFile(t, s, "/a.go", "go")
+	f2 := insertTestFile(t, s, "/b.go", "go")
+
+	good := NewBatchedStore(s)
+	_, err := good.InsertSymbol(&Symbol{FileID: &f1.ID, Name: "Good", Kind: "function"})
+	require.NoError(t, err)
+
+	// A type member pointing at a fake symbol that was never buffered.
+	bad := NewBatchedStore(s)
+	_, err = bad.InsertSymbol(&Symbol{FileID: &f2.ID, Name: "Bad", Kind: "struct"})
+	require.NoError(t, err)
+	_, err = bad.InsertTypeMember(&TypeMember{SymbolID: -99, Name: "X", Kind: "field"})
+	require.NoError(t, err)
+
+	require.Error(t, s.CommitBatches([]*BatchedStore{good, bad}))
+
+	syms, err := s.SymbolsByFile(f1.ID)
+	require.NoError(t, err)
+	assert.Empty(t, syms)
+
+	// The untouched batch can still be committed on its own.
+	require.NoError(t, s.CommitBatch(good))
+	syms, err = s.SymbolsByFile(f1.ID)
+	require.NoError(t, err)
+	assert.Len(t, syms, 1)
+}
+
+func TestCommitBatch_MultiRowChunksAndRemainder(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	f := insertTestFile(t, s, "/big.cpp", "cpp")
+
+	batch := NewBatchedStore(s)
+	scopeID, err := batch.InsertScope(&Scope{FileID: f.ID, Kind: "file"})
+	require.NoError(t, err)
+
+	// Two full multi-row chunks plus a single-row remainder.
+	n := 2*bulkRowsPerStmt + 7
+	for i := range n {
+		_, err := batch.InsertReference(&Reference{FileID: f.ID, ScopeID: &scopeID, Name: "r", StartLine: i})
+		require.NoError(t, err)
+	}
+	require.NoError(t, s.CommitBatch(batch))
+
+	refs, err := s.ReferencesByFile(f.ID)
+	require.NoError(t, err)
+	require.Len(t, refs, n)
+
+	scopes, err := s.ScopesByFile(f.ID)
+	require.NoError(t, err)
+	require.Len(t, scopes, 1)
+	lines := make(map[int]bool, n)
+	for _, ref := range refs {
+		require.NotNil(t, ref.ScopeID)
+		assert.Equal(t, scopes[0].ID, *ref.ScopeID)
+		lines[ref.StartLine] = true
+	}
+	assert.Len(t, lines, n)
+}
+
+func TestBatchedStore_RowsRoundTripColumns(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	f := insertTestFile(t, s, "/main.go", "go")
+
+	batch := NewBatchedStore(s)
+	batch.Reserve(100)
+	parent, err := batch.InsertSymbol(&Symbol{FileID: &f.ID, Name: "T", Kind: "struct",
+		Modifiers: []string{"exported"}, StartLine: 1, EndLine: 9, EndCol: 1})
+	require.NoError(t, err)
+	_, err = batch.InsertSymbol(&Symbol{FileID: &f.ID, Name: "M", Kind: "method", ParentSymbolID: &parent})
+	require.NoError(t, err)
+	scope, err := batch.InsertScope(&Scope{FileID: f.ID, Kind: "file"})
+	require.NoError(t, err)
+	_, err = batch.InsertReference(&Reference{FileID: f.ID, ScopeID: &scope, Name: "T", StartLine: 3, Context: "type"})
+	require.NoError(t, err)
+	_, err = batch.InsertReference(&Reference{FileID: f.ID, Name: "T", Context: "type"})
+	require.NoError(t, err)
+
+	rows := batch.Rows()
+	require.Len(t, rows.Symbols, 2)
+	assert.Equal(t, []string{"exported"}, rows.Symbols[0].Modifiers)
+	assert.Equal(t, 9, rows.Symbols[0].EndLine)
+	assert.Nil(t, rows.Symbols[0].ParentSymbolID)
+	require.NotNil(t, rows.Symbols[1].ParentSymbolID)
+	assert.Equal(t, parent, *rows.Symbols[1].ParentSymbolID)
+	require.Len(t, rows.Scopes, 1)
+	assert.Nil(t, rows.Scopes[0].SymbolID)
+	require.Len(t, rows.References, 2)
+	require.NotNil(t, rows.References[0].ScopeID)
+	assert.Equal(t, scope, *rows.References[0].ScopeID)
+	assert.Nil(t, rows.References[1].ScopeID)
+
+	// Nil columns are committed as NULL, fake IDs as the real ones.
+	require.NoError(t, s.CommitBatch(batch))
+	syms, err := s.SymbolsByFile(f.ID)
+	require.NoError(t, err)
+	require.Len(t, syms, 2)
+	byName := map[string]*Symbol{syms[0].Name: syms[0], syms[1].Name: syms[1]}
+	assert.Nil(t, byName["T"].ParentSymbolID)
+	require.NotNil(t, byName["M"].ParentSymbolID)
+	assert.Equal(t, byName["T"].ID, *byName["M"].ParentSymbolID)
+	refs, err := s.ReferencesByFile(f.ID)
+	require.NoError(t, err)
+	require.Len(t, refs, 2)
+	var nullScopes int
+	for _, r := range refs {
+		if r.ScopeID == nil {
+			nullScopes++
+		}
+	}
+	assert.Equal(t, 1, nullScopes)
+}
+
+func TestBatchedStore_CopyRowsRemapsIDs(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	src := insertTestFile(t, s, "/a/point.h", "c")
+	dst := insertTestFile(t, s, "/b/point.h", "c")
+
+	batch := NewBatchedStore(s)
+	parent, err := batch.InsertSymbol(&Symbol{FileID: &src.ID, Name: "point", Kind: "struct"})
+	require.NoError(t, err)
+	_, err = batch.InsertSymbol(&Symbol{FileID: &src.ID, Name: "x", Kind: "field", ParentSymbolID: &parent})
+	require.NoError(t, err)
+	scope, err := batch.InsertScope(&Scope{FileID: src.ID, Kind: "file"})
+	require.NoError(t, err)
+	_, err = batch.InsertReference(&Reference{FileID: src.ID, ScopeID: &scope, Name: "point", Context: "type"})
+	require.NoError(t, err)
+	require.NoError(t, s.CommitBatch(batch))
+
+	// Copy the committed rows, as a file with the same content would.
+	rows, err := s.Rows(src.ID)
+	require.NoError(t, err)
+	cp := NewBatchedStore(s)
+	cp.ReplaceFile(dst.ID)
+	cp.CopyRows(rows, src.ID, dst.ID)
+	require.NoError(t, s.CommitBatch(cp))
+
+	got, err := s.Rows(dst.ID)
+	require.NoError(t, err)
+	require.Len(t, got.Symbols, 2)
+	require.NotNil(t, got.Symbols[1].ParentSymbolID)
+	assert.Equal(t, got.Symbols[0].ID, *got.Symbols[1].ParentSymbolID)
+	require.Len(t, got.Scopes, 1)
+	require.Len(t, got.References, 1)
+	assert.Equal(t, dst.ID, got.References[0].FileID)
+	require.NotNil(t, got.References[0].ScopeID)
+	assert.Equal(t, got.Scopes[0].ID, *got.References[0].ScopeID)
+
+	// The source rows are untouched.
+	again, err := s.Rows(src.ID)
+	require.NoError(t, err)
+	assert.Equal(t, rows, again)
+}
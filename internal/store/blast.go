@@ -1,36 +1,63 @@
 package store
 
-import "fmt"
+import (
+	"database/sql"
+	"fmt"
+	"strings"
+)
 
-// FilesReferencingSymbols returns file IDs that have resolved_references targeting any of the given symbols.
+// blastChunk is how many IDs or names the blast radius lookups bind per
+// query, to stay under SQLite's bound-variable limit.
+const blastChunk = 500
+
+// FilesReferencingSymbols returns the IDs of files whose resolution data
+// points at any of the given symbols: files with resolved_references
+// targeting them, and files re-exporting them. Any number of symbols may be
+// passed; they are looked up in chunks and the result is deduplicated.
 func (s *Store) FilesReferencingSymbols(symbolIDs []int64) ([]int64, error) {
-	if len(symbolIDs) == 0 {
-		return nil, nil
-	}
-	placeholders := placeholderList(len(symbolIDs))
-	query := `SELECT DISTINCT r.file_id
-		FROM resolved_references rr
-		JOIN references_ r ON r.id = rr.reference_id
-		WHERE rr.target_symbol_id IN (` + placeholders + `)`
-	rows, err := s.db.Query(query, int64sToArgs(symbolIDs)...)
+	seen := make(map[int64]bool)
+	var fileIDs []int64
+	for start := 0; start < len(symbolIDs); start += blastChunk {
+		part := symbolIDs[start:min(start+blastChunk, len(symbolIDs))]
+		placeholders := placeholderList(len(part))
+		args := int64sToArgs(part)
+		query := `SELECT r.file_id
+			FROM resolved_references rr
+			JOIN references_ r ON r.id = rr.reference_id
+			WHERE rr.target_symbol_id IN (` + placeholders + `)
+			UNION
+			SELECT file_id FROM reexports WHERE original_symbol_id IN (` + placeholders + `)`
+		if err := collectFileIDs(s.rdb, seen, &fileIDs, query, repeatArgs(args, 2)...); err != nil {
+			return nil, fmt.Errorf("files referencing symbols: %w", err)
+		}
+	}
+	return fileIDs, nil
+}
+
+// collectFileIDs appends the file IDs returned by query that are not yet in
+// seen to out.
+func collectFileIDs(db *sql.DB, seen map[int64]bool, out *[]int64, query string, args ...any) error {
+	rows, err := db.Query(query, args...)
 	if err != nil {
-		return nil, fmt.Errorf("files referencing symbols: %w", err)
+		return err
 	}
 	defer rows.Close()
-	var fileIDs []int64
 	for rows.Next() {
 		var id int64
 		if err := rows.Scan(&id); err != nil {
-			return nil, fmt.Errorf("scan file id: %w", err)
+			return fmt.Errorf("scan file id: %w", err)
+		}
+		if !seen[id] {
+			seen[id] = true
+			*out = append(*out, id)
 		}
-		fileIDs = append(fileIDs, id)
 	}
-	return fileIDs, rows.Err()
+	return rows.Err()
 }
 
 // FilesImportingSource returns file IDs that import the given module/package source.
 func (s *Store) FilesImportingSource(source string) ([]int64, error) {
-	rows, err := s.db.Query("SELECT DISTINCT file_id FROM imports WHERE source = ?", source)
+	rows, err := s.rdb.Query("SELECT DISTINCT file_id FROM imports WHERE source = ?", source)
 	if err != nil {
 		return nil, fmt.Errorf("files importing source: %w", err)
 	}
@@ -46,6 +73,89 @@ func (s *Store) FilesImportingSource(source string) ([]int64, error) {
 	return fileIDs, rows.Err()
 }
 
+// FilesImportingPackages returns the IDs of files that import any of the
+// given packages, either by bare name or by a path ending in it
+// ("example.com/x/pkg"). Both forms are index lookups: imports carry the
+// last segment of their source in source_segment.
+func (s *Store) FilesImportingPackages(names []string) ([]int64, error) {
+	seen := make(map[int64]bool)
+	var fileIDs []int64
+	for start := 0; start < len(names); start += blastChunk {
+		part := names[start:min(start+blastChunk, len(names))]
+		placeholders := placeholderList(len(part))
+		args := make([]any, 0, 2*len(part))
+		for _, n := range part {
+			args = append(args, n)
+		}
+		args = append(args, args...)
+		query := "SELECT DISTINCT file_id FROM imports WHERE source IN (" + placeholders + ") OR source_segment IN (" + placeholders + ")"
+		if err := collectFileIDs(s.rdb, seen, &fileIDs, query, args...); err != nil {
+			return nil, fmt.Errorf("files importing packages: %w", err)
+		}
+	}
+	return fileIDs, nil
+}
+
+// lastSegment returns the part of an import source after its last '/', the
+// value stored in imports.source_segment.
+func lastSegment(source string) string {
+	if i := strings.LastIndex(source, "/"); i >= 0 {
+		return source[i+1:]
+	}
+	return source
+}
+
+// importSegmentsKey is the metadata entry recording that source_segment has
+// been filled in for imports written before the column existed.
+const importSegmentsKey = "import_source_segments"
+
+func (s *Store) backfillImportSegments() error {
+	tx, err := s.db.Begin()
+	if err != nil {
+		return fmt.Errorf("import segments: begin: %w", err)
+	}
+	defer tx.Rollback()
+
+	rows, err := tx.Query("SELECT id, source FROM imports WHERE source_segment IS NULL")
+	if err != nil {
+		return fmt.Errorf("import segments: %w", err)
+	}
+	type pending struct {
+		id      int64
+		segment string
+	}
+	var todo []pending
+	for rows.Next() {
+		var p pending
+		var source string
+		if err := rows.Scan(&p.id, &source); err != nil {
+			rows.Close()
+			return fmt.Errorf("import segments: scan: %w", err)
+		}
+		p.segment = lastSegment(source)
+		todo = append(todo, p)
+	}
+	rows.Close()
+	if err := rows.Err(); err != nil {
+		return fmt.Errorf("import segments: rows: %w", err)
+	}
+
+	stmt, err := tx.Prepare("UPDATE imports SET source_segment = ? WHERE id = ?")
+	if err != nil {
+		return fmt.Errorf("import segments: prepare: %w", err)
+	}
+	defer stmt.Close()
+	for _, p := range todo {
+		if _, err := stmt.Exec(p.segment, p.id); err != nil {
+			return fmt.Errorf("import segments: update: %w", err)
+		}
+	}
+	if _, err := tx.Exec("INSERT OR REPLACE INTO metadata (key, value) VALUES (?, '1')", importSegmentsKey); err != nil {
+		return fmt.Errorf("import segments: mark built: %w", err)
+	}
+	return tx.Commit()
+}
+
 // DeleteResolutionDataForSymbols removes all resolution data targeting the given symbols:
 // resolved_references, call_graph, implementations, extension_bindings, reexports, type_compositions.
 func (s *Store) DeleteResolutionDataForSymbols(symbolIDs []int64) error {
@@ -58,34 +168,40 @@ func (s *Store) DeleteResolutionDataForSymbols(symbolIDs []int64) error {
 	}
 	defer tx.Rollback()
 
-	placeholders := placeholderList(len(symbolIDs))
-	args := int64sToArgs(symbolIDs)
-
-	queries := []struct {
-		sql  string
-		args []any
-	}{
-		{"DELETE FROM resolved_references WHERE target_symbol_id IN (" + placeholders + ")", args},
-		{"DELETE FROM call_graph WHERE caller_symbol_id IN (" + placeholders + ") OR callee_symbol_id IN (" + placeholders + ")", repeatArgs(args, 2)},
-		{"DELETE FROM implementations WHERE type_symbol_id IN (" + placeholders + ") OR interface_symbol_id IN (" + placeholders + ")", repeatArgs(args, 2)},
-		{"DELETE FROM extension_bindings WHERE member_symbol_id IN (" + placeholders + ") OR extended_type_symbol_id IN (" + placeholders + ")", repeatArgs(args, 2)},
-		{"DELETE FROM reexports WHERE original_symbol_id IN (" + placeholders + ")", args},
-		{"DELETE FROM type_compositions WHERE composite_symbol_id IN (" + placeholders + ") OR component_symbol_id IN (" + placeholders + ")", repeatArgs(args, 2)},
-	}
+	for start := 0; start < len(symbolIDs); start += blastChunk {
+		part := symbolIDs[start:min(start+blastChunk, len(symbolIDs))]
+		placeholders := placeholderList(len(part))
+		args := int64sToArgs(part)
 
-	for _, q := range queries {
-		if _, err := tx.Exec(q.sql, q.args...); err != nil {
-			return fmt.Errorf("delete resolution data for symbols: %w", err)
+		queries := []struct {
+			sql  string
+			args []any
+		}{
+			{invalidateFingerprintsSQL("(" + placeholders + ")"), repeatArgs(args, invalidateFingerprintsRefs)},
+			{"DELETE FROM resolved_references WHERE target_symbol_id IN (" + placeholders + ")", args},
+			{"DELETE FROM call_graph WHERE caller_symbol_id IN (" + placeholders + ") OR callee_symbol_id IN (" + placeholders + ")", repeatArgs(args, 2)},
+			{"DELETE FROM implementations WHERE type_symbol_id IN (" + placeholders + ") OR interface_symbol_id IN (" + placeholders + ")", repeatArgs(args, 2)},
+			{"DELETE FROM extension_bindings WHERE member_symbol_id IN (" + placeholders + ") OR extended_type_symbol_id IN (" + placeholders + ")", repeatArgs(args, 2)},
+			{"DELETE FROM reexports WHERE original_symbol_id IN (" + placeholders + ")", args},
+			{"DELETE FROM type_compositions WHERE composite_symbol_id IN (" + placeholders + ") OR component_symbol_id IN (" + placeholders + ")", repeatArgs(args, 2)},
+		}
+		for _, q := range queries {
+			if _, err := tx.Exec(q.sql, q.args...); err != nil {
+				return fmt.Errorf("delete resolution data for symbols: %w", err)
+			}
 		}
 	}
+	if _, err := tx.Exec(invalidateCallGraphIndexSQL); err != nil {
+		return fmt.Errorf("delete resolution data for symbols: %w", err)
+	}
 
 	return tx.Commit()
 }
 
 // DeleteResolutionDataForFiles removes all resolution data originating from the given files.
 // This means: resolved_references whose reference comes from those files, call_graph/implementations
-// with file_id in the set, reexports with file_id in the set, and any extension_bindings/type_compositions
-// whose member/composite symbol belongs to those files.
+// with file_id in the set, reexports with file_id in the set, any extension_bindings/type_compositions
+// whose member/composite symbol belongs to those files, and the files' resolution fingerprints.
 func (s *Store) DeleteResolutionDataForFiles(fileIDs []int64) error {
 	if len(fileIDs) == 0 {
 		return nil
@@ -111,6 +227,9 @@ func (s *Store) DeleteResolutionDataForFiles(fileIDs []int64) error {
 	if _, err := tx.Exec("DELETE FROM call_graph WHERE file_id IN ("+placeholders+")", args...); err != nil {
 		return fmt.Errorf("delete call graph for files: %w", err)
 	}
+	if _, err := tx.Exec(invalidateCallGraphIndexSQL); err != nil {
+		return fmt.Errorf("invalidate call graph index: %w", err)
+	}
 
 	// Delete implementations originating from these files.
 	if _, err := tx.Exec("DELETE FROM implementations WHERE file_id IN ("+placeholders+")", args...); err != nil {
@@ -138,5 +257,10 @@ func (s *Store) DeleteResolutionDataForFiles(fileIDs []int64) error {
 		return fmt.Errorf("delete type compositions for files: %w", err)
 	}
 
+	// And the fingerprints recording what these files were resolved from.
+	if _, err := tx.Exec("DELETE FROM resolution_fingerprints WHERE file_id IN ("+placeholders+")", args...); err != nil {
+		return fmt.Errorf("delete resolution fingerprints for files: %w", err)
+	}
+
 	return tx.Commit()
 }
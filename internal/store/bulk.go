@@ -0,0 +1,321 @@
+package store
+
+import (
+	"context"
+	"database/sql"
+	"errors"
+	"fmt"
+	"io/fs"
+	"os"
+	"path/filepath"
+	"time"
+
+	"github.com/mattn/go-sqlite3"
+)
+
+// buildSuffix names the database a bulk load writes into, next to the one
+// it replaces.
+const buildSuffix = ".build"
+
+// lockSuffix names the lock file beside a database. Every Store with the
+// database open holds it shared; replacing the database takes it
+// exclusively (see installDatabase).
+const lockSuffix = ".lock"
+
+// errLocked reports a lock held by another process.
+var errLocked = errors.New("locked by another process")
+
+// busyTimeout is how long a write waits out other writers, as the
+// connections' _busy_timeout does.
+const busyTimeout = 30 * time.Second
+
+// WithBulkLoad opens the Store for a cold build that replaces whatever
+// database exists at dbPath. The Store writes to a fresh build database
+// beside it instead, with the write connection running synchronous=OFF and
+// no foreign key checks, and Migrate creates the tables without their
+// secondary indexes, so loading the extraction tables maintains none.
+//
+// BuildIndexes creates the indexes in one pass once extraction is done.
+// Publish then syncs the build database and renames it over dbPath, so a
+// crash at any point before leaves the previous database as it was, and
+// one after leaves the complete new one. If another process has dbPath
+// open, as `canopy serve` does, the build is copied into it instead (see
+// installDatabase). Closing the Store without
+// publishing discards the build; a build left behind by a crash is
+// discarded by the next bulk load.
+//
+// For in-memory databases only the deferred indexes and relaxed pragmas
+// apply; Publish just builds the indexes.
+func WithBulkLoad() StoreOption {
+	return func(c *storeConfig) {
+		c.bulk = true
+	}
+}
+
+// Bulk reports whether the Store is loading a cold build (see WithBulkLoad).
+func (s *Store) Bulk() bool {
+	return s.bulk
+}
+
+// BuildIndexes creates the secondary indexes a bulk load deferred, in one
+// transaction. It is a no-op once they exist.
+func (s *Store) BuildIndexes() error {
+	if !s.indexesDeferred {
+		return nil
+	}
+	tx, err := s.db.Begin()
+	if err != nil {
+		return fmt.Errorf("build indexes: begin: %w", err)
+	}
+	defer tx.Rollback()
+	if _, err := tx.Exec(schemaIndexDDL); err != nil {
+		return fmt.Errorf("build indexes: %w", err)
+	}
+	if err := tx.Commit(); err != nil {
+		return fmt.Errorf("build indexes: commit: %w", err)
+	}
+	s.indexesDeferred = false
+	return nil
+}
+
+// Publish completes a bulk load: it builds the deferred indexes, makes the
+// build database durable and renames it, with its call graph index, over
+// the database it replaces. The Store then reopens there with the regular
+// connection pools. It is a no-op for a Store that is not bulk loading.
+//
+// If Publish fails after the pools are closed, the Store is unusable and
+// the previous database remains in place unless the rename happened.
+func (s *Store) Publish() error {
+	if !s.bulk {
+		return nil
+	}
+	if err := s.BuildIndexes(); err != nil {
+		return fmt.Errorf("publish: %w", err)
+	}
+	if s.publishPath == "" {
+		s.bulk = false
+		return nil
+	}
+
+	// Fold the WAL into the build database with no readers left to hold
+	// it back, so the single file renamed into place is complete.
+	s.closeCallGraphIndex()
+	if s.rdb != s.db {
+		if err := s.rdb.Close(); err != nil {
+			return fmt.Errorf("publish: close read pool: %w", err)
+		}
+		s.rdb = s.db
+	}
+	var busy, walPages, checkpointed int
+	if err := s.db.QueryRow("PRAGMA wal_checkpoint(TRUNCATE)").Scan(&busy, &walPages, &checkpointed); err != nil {
+		return fmt.Errorf("publish: checkpoint: %w", err)
+	}
+	if busy != 0 {
+		return errors.New("publish: checkpoint: database busy")
+	}
+	if err := s.db.Close(); err != nil {
+		return fmt.Errorf("publish: close database: %w", err)
+	}
+	if err := syncFile(s.path); err != nil {
+		return fmt.Errorf("publish: %w", err)
+	}
+	lock, err := installDatabase(s.path, s.publishPath)
+	if err != nil {
+		return fmt.Errorf("publish: %w", err)
+	}
+
+	s.path, s.publishPath, s.bulk, s.lock = s.publishPath, "", false, lock
+	if err := s.open(); err != nil {
+		return fmt.Errorf("publish: reopen: %w", err)
+	}
+	return nil
+}
+
+// installDatabase moves the closed database src, with its call graph
+// index, over dst, and returns dst's lock held shared for the caller.
+//
+// If no other Store has dst open, src is renamed over it under the
+// exclusive lock, after checkpointing dst's WAL into dst and removing the
+// WAL and shared memory, which would otherwise be replayed into src. A WAL
+// left by a crash can hold committed transactions, so it is folded in
+// first: until the rename, dst is a complete database. Another process with dst open is using
+// that WAL and shared memory, and would go on reading the unlinked file,
+// so then src is copied into dst through SQLite's backup API instead: the
+// other process sees the new contents at its next transaction.
+func installDatabase(src, dst string) (*os.File, error) {
+	lock, err := lockFile(dst+lockSuffix, true, false)
+	switch {
+	case errors.Is(err, errLocked):
+		if lock, err = lockFile(dst+lockSuffix, false, true); err != nil {
+			return nil, err
+		}
+		if err := copyDatabase(src, dst); err != nil {
+			lock.Close()
+			return nil, err
+		}
+	case err != nil:
+		return nil, err
+	default:
+		if err := checkpointDatabase(dst); err != nil {
+			lock.Close()
+			return nil, err
+		}
+		for _, suffix := range []string{"-wal", "-shm"} {
+			if err := removeIfExists(dst + suffix); err != nil {
+				lock.Close()
+				return nil, err
+			}
+		}
+		if err := os.Rename(src, dst); err != nil {
+			lock.Close()
+			return nil, err
+		}
+		if err := shareLock(lock); err != nil {
+			lock.Close()
+			return nil, err
+		}
+	}
+
+	// The call graph index is checked against the database's stamp, so a
+	// missing or stale one only costs a rebuild. Processes that map the
+	// old one keep their mapping until they next load it.
+	if err := os.Rename(src+".callgraph", dst+".callgraph"); err != nil {
+		if !errors.Is(err, fs.ErrNotExist) {
+			lock.Close()
+			return nil, err
+		}
+		if err := removeIfExists(dst + ".callgraph"); err != nil {
+			lock.Close()
+			return nil, err
+		}
+	}
+	syncDir(filepath.Dir(dst))
+	if err := removeDatabaseFiles(src); err != nil {
+		lock.Close()
+		return nil, err
+	}
+	return lock, nil
+}
+
+// checkpointDatabase folds the WAL of the database at path, if it has one,
+// into the database file. The caller holds the exclusive lock, so no other
+// connection can hold the checkpoint back.
+func checkpointDatabase(path string) error {
+	for _, p := range []string{path, path + "-wal"} {
+		if _, err := os.Stat(p); errors.Is(err, fs.ErrNotExist) {
+			return nil
+		}
+	}
+	db, err := sql.Open(writerDriver, path+"?_busy_timeout=30000")
+	if err != nil {
+		return fmt.Errorf("checkpoint %s: %w", path, err)
+	}
+	defer db.Close()
+	var busy, walPages, checkpointed int
+	if err := db.QueryRow("PRAGMA wal_checkpoint(TRUNCATE)").Scan(&busy, &walPages, &checkpointed); err != nil {
+		return fmt.Errorf("checkpoint %s: %w", path, err)
+	}
+	if busy != 0 {
+		return fmt.Errorf("checkpoint %s: database busy", path)
+	}
+	if err := db.Close(); err != nil {
+		return fmt.Errorf("checkpoint %s: %w", path, err)
+	}
+	return nil
+}
+
+// copyDatabase overwrites the database dst, which other processes have
+// open, with the contents of src, in one write transaction on dst.
+func copyDatabase(src, dst string) error {
+	srcDB, err := sql.Open(readerDriver, src)
+	if err != nil {
+		return fmt.Errorf("copy database: %w", err)
+	}
+	defer srcDB.Close()
+	dstDB, err := sql.Open(writerDriver, dst+"?_busy_timeout=30000")
+	if err != nil {
+		return fmt.Errorf("copy database: %w", err)
+	}
+	defer dstDB.Close()
+
+	ctx := context.Background()
+	srcConn, err := srcDB.Conn(ctx)
+	if err != nil {
+		return fmt.Errorf("copy database: %w", err)
+	}
+	defer srcConn.Close()
+	dstConn, err := dstDB.Conn(ctx)
+	if err != nil {
+		return fmt.Errorf("copy database: %w", err)
+	}
+	defer dstConn.Close()
+
+	err = dstConn.Raw(func(d any) error {
+		return srcConn.Raw(func(s any) error {
+			bk, err := d.(*sqlite3.SQLiteConn).Backup("main", s.(*sqlite3.SQLiteConn), "main")
+			if err != nil {
+				return err
+			}
+			// Step reports a busy destination as not done; wait it out
+			// like any other writer would.
+			deadline := time.Now().Add(busyTimeout)
+			for {
+				done, err := bk.Step(-1)
+				if err != nil || done {
+					if ferr := bk.Finish(); err == nil {
+						err = ferr
+					}
+					return err
+				}
+				if time.Now().After(deadline) {
+					bk.Finish()
+					return errors.New("database busy")
+				}
+				time.Sleep(50 * time.Millisecond)
+			}
+		})
+	})
+	if err != nil {
+		return fmt.Errorf("copy database: %w", err)
+	}
+	return nil
+}
+
+// removeDatabaseFiles removes the database at path along with its WAL,
+// shared-memory and call graph index files.
+func removeDatabaseFiles(path string) error {
+	for _, suffix := range []string{"", "-wal", "-shm", ".callgraph"} {
+		if err := removeIfExists(path + suffix); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+func removeIfExists(path string) error {
+	if err := os.Remove(path); err != nil && !errors.Is(err, fs.ErrNotExist) {
+		return err
+	}
+	return nil
+}
+
+func syncFile(path string) error {
+	f, err := os.OpenFile(path, os.O_RDWR, 0)
+	if err != nil {
+		return err
+	}
+	if err := f.Sync(); err != nil {
+		f.Close()
+		return err
+	}
+	return f.Close()
+}
+
+// syncDir makes a rename in dir durable. It is best effort: not every
+// platform can sync a directory.
+func syncDir(dir string) {
+	if d, err := os.Open(dir); err == nil {
+		d.Sync()
+		d.Close()
+	}
+}
@@ -0,0 +1,196 @@
+package store
+
+import (
+	"database/sql"
+	"os"
+	"path/filepath"
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func indexExists(t *testing.T, s *Store, name string) bool {
+	t.Helper()
+	var n int
+	require.NoError(t, s.DB().QueryRow("SELECT COUNT(*) FROM sqlite_master WHERE type = 'index' AND name = ?", name).Scan(&n))
+	return n > 0
+}
+
+// openWithFile creates a database at dbPath holding a single file.
+func openWithFile(t *testing.T, dbPath, filePath string) {
+	t.Helper()
+	s, err := NewStore(dbPath)
+	require.NoError(t, err)
+	require.NoError(t, s.Migrate())
+	insertTestFile(t, s, filePath, "go")
+	require.NoError(t, s.Close())
+}
+
+func filePaths(t *testing.T, dbPath string) []string {
+	t.Helper()
+	s, err := NewStore(dbPath)
+	require.NoError(t, err)
+	defer s.Close()
+	files, err := s.AllFiles()
+	require.NoError(t, err)
+	return mapValues(files)
+}
+
+func mapValues(files map[int64]string) []string {
+	var paths []string
+	for _, path := range files {
+		paths = append(paths, path)
+	}
+	return paths
+}
+
+func TestBulkLoad_PublishReplacesDatabase(t *testing.T) {
+	t.Parallel()
+	dbPath := filepath.Join(t.TempDir(), "test.db")
+	openWithFile(t, dbPath, "/old.go")
+
+	s, err := NewStore(dbPath, WithBulkLoad())
+	require.NoError(t, err)
+	defer s.Close()
+	require.NoError(t, s.Migrate())
+	assert.Equal(t, dbPath+buildSuffix, s.Path())
+	assert.False(t, indexExists(t, s, "idx_symbols_name"), "indexes are deferred")
+	var sync, fk int
+	require.NoError(t, s.DB().QueryRow("PRAGMA synchronous").Scan(&sync))
+	require.NoError(t, s.DB().QueryRow("PRAGMA foreign_keys").Scan(&fk))
+	assert.Equal(t, 0, sync, "OFF")
+	assert.Equal(t, 0, fk)
+
+	f := insertTestFile(t, s, "/new.go", "go")
+	insertTestSymbol(t, s, &f.ID, "Run", "function")
+	require.NoError(t, s.BuildIndexes())
+	assert.True(t, indexExists(t, s, "idx_symbols_name"))
+	assert.True(t, indexExists(t, s, "idx_imports_segment"))
+	assert.Equal(t, []string{"/old.go"}, filePaths(t, dbPath), "the old database serves until published")
+
+	require.NoError(t, s.Publish())
+	assert.False(t, s.Bulk())
+	assert.Equal(t, dbPath, s.Path())
+	_, err = os.Stat(dbPath + buildSuffix)
+	assert.ErrorIs(t, err, os.ErrNotExist)
+	require.NoError(t, s.DB().QueryRow("PRAGMA foreign_keys").Scan(&fk))
+	assert.Equal(t, 1, fk)
+
+	// The reopened Store reads and writes the published database.
+	syms, err := s.SymbolsByFile(f.ID)
+	require.NoError(t, err)
+	require.Len(t, syms, 1)
+	insertTestFile(t, s, "/later.go", "go")
+	assert.ElementsMatch(t, []string{"/new.go", "/later.go"}, filePaths(t, dbPath))
+}
+
+func TestBulkLoad_CloseWithoutPublishDiscardsBuild(t *testing.T) {
+	t.Parallel()
+	dbPath := filepath.Join(t.TempDir(), "test.db")
+	openWithFile(t, dbPath, "/old.go")
+
+	// A build left by an interrupted run is cleared, not resumed.
+	require.NoError(t, os.WriteFile(dbPath+buildSuffix, []byte("partial"), 0o644))
+	s, err := NewStore(dbPath, WithBulkLoad())
+	require.NoError(t, err)
+	require.NoError(t, s.Migrate())
+	insertTestFile(t, s, "/new.go", "go")
+	require.NoError(t, s.Close())
+
+	_, err = os.Stat(dbPath + buildSuffix)
+	assert.ErrorIs(t, err, os.ErrNotExist)
+	assert.Equal(t, []string{"/old.go"}, filePaths(t, dbPath))
+}
+
+func TestBulkLoad_PublishIntoDatabaseInUse(t *testing.T) {
+	t.Parallel()
+	dbPath := filepath.Join(t.TempDir(), "test.db")
+	openWithFile(t, dbPath, "/old.go")
+
+	// A long-lived reader, such as canopy serve, holds the database open.
+	reader, err := NewStore(dbPath)
+	require.NoError(t, err)
+	defer reader.Close()
+	ident := reader.ident
+
+	s, err := NewStore(dbPath, WithBulkLoad())
+	require.NoError(t, err)
+	defer s.Close()
+	require.NoError(t, s.Migrate())
+	insertTestFile(t, s, "/new.go", "go")
+	require.NoError(t, s.Publish())
+	assert.Equal(t, dbPath, s.Path())
+	_, err = os.Stat(dbPath + buildSuffix)
+	assert.ErrorIs(t, err, os.ErrNotExist)
+
+	// The build was copied into the file the reader has open, which sees
+	// it at its next read without reopening.
+	now, err := fileIdent(dbPath)
+	require.NoError(t, err)
+	assert.Equal(t, ident, now)
+	files, err := reader.AllFiles()
+	require.NoError(t, err)
+	assert.Equal(t, []string{"/new.go"}, mapValues(files))
+	reopened, err := reader.ReopenIfReplaced()
+	require.NoError(t, err)
+	assert.False(t, reopened)
+}
+
+func TestCheckpointDatabase_KeepsWALLeftByCrash(t *testing.T) {
+	t.Parallel()
+	dir := t.TempDir()
+	live := filepath.Join(dir, "live.db")
+	db, err := sql.Open(writerDriver, live+"?_journal_mode=WAL")
+	require.NoError(t, err)
+	defer db.Close()
+	db.SetMaxOpenConns(1)
+	for _, q := range []string{"PRAGMA wal_autocheckpoint = 0", "CREATE TABLE t (v INTEGER)", "INSERT INTO t VALUES (1)"} {
+		_, err := db.Exec(q)
+		require.NoError(t, err)
+	}
+
+	// Copying the files with the connection still open leaves what a
+	// crash would: committed rows that only the WAL holds.
+	crashed := filepath.Join(dir, "crashed.db")
+	for _, suffix := range []string{"", "-wal"} {
+		data, err := os.ReadFile(live + suffix)
+		require.NoError(t, err)
+		require.NoError(t, os.WriteFile(crashed+suffix, data, 0o644))
+	}
+	require.NoError(t, checkpointDatabase(crashed))
+	require.NoError(t, removeIfExists(crashed+"-wal"))
+	require.NoError(t, removeIfExists(crashed+"-shm"))
+
+	check, err := sql.Open(readerDriver, crashed)
+	require.NoError(t, err)
+	defer check.Close()
+	var n int
+	require.NoError(t, check.QueryRow("SELECT COUNT(*) FROM t").Scan(&n))
+	assert.Equal(t, 1, n)
+}
+
+func TestStore_ReopenIfReplaced(t *testing.T) {
+	t.Parallel()
+	dir := t.TempDir()
+	dbPath := filepath.Join(dir, "test.db")
+	openWithFile(t, dbPath, "/old.go")
+	other := filepath.Join(dir, "other.db")
+	openWithFile(t, other, "/other.go")
+
+	s, err := NewStore(dbPath)
+	require.NoError(t, err)
+	defer s.Close()
+
+	// A process that ignores the lock file renames another database over it.
+	require.NoError(t, os.Rename(other, dbPath))
+	reopened, err := s.ReopenIfReplaced()
+	require.NoError(t, err)
+	assert.True(t, reopened)
+	files, err := s.AllFiles()
+	require.NoError(t, err)
+	assert.Equal(t, []string{"/other.go"}, mapValues(files))
+	reopened, err = s.ReopenIfReplaced()
+	require.NoError(t, err)
+	assert.False(t, reopened)
+}
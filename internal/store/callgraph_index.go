@@ -0,0 +1,346 @@
+package store
+
+import (
+	"bufio"
+	"errors"
+	"fmt"
+	"os"
+	"slices"
+	"strconv"
+	"time"
+	"unsafe"
+)
+
+// CallGraphIndex is a compressed sparse row (CSR) view of the call_graph
+// table. Symbols are numbered by their position in a sorted node array;
+// edges are stored caller-major in flat column arrays, so a symbol's outgoing
+// edges are a contiguous range and its incoming edges are a contiguous range
+// of a permutation array. A persisted index is memory-mapped, so opening it
+// costs no parsing and almost no heap regardless of edge count.
+//
+// An index is immutable and safe for concurrent use.
+type CallGraphIndex struct {
+	nodes    []int64 // sorted symbol IDs
+	fwdOff   []int32 // len(nodes)+1; edges [fwdOff[n], fwdOff[n+1]) have caller n
+	revOff   []int32 // len(nodes)+1; revEdges[revOff[n]:revOff[n+1]] have callee n
+	revEdges []int32
+
+	edgeID []int64
+	caller []int32 // node index
+	callee []int32 // node index
+	fileID []int64 // 0 when the edge has no file
+	line   []int32
+	col    []int32
+}
+
+// Callees calls fn with the index of every edge whose caller is symbolID.
+func (g *CallGraphIndex) Callees(symbolID int64, fn func(edge int)) {
+	n, ok := g.node(symbolID)
+	if !ok {
+		return
+	}
+	for e := g.fwdOff[n]; e < g.fwdOff[n+1]; e++ {
+		fn(int(e))
+	}
+}
+
+// Callers calls fn with the index of every edge whose callee is symbolID.
+func (g *CallGraphIndex) Callers(symbolID int64, fn func(edge int)) {
+	n, ok := g.node(symbolID)
+	if !ok {
+		return
+	}
+	for _, e := range g.revEdges[g.revOff[n]:g.revOff[n+1]] {
+		fn(int(e))
+	}
+}
+
+// CallerID returns the caller symbol ID of edge e.
+func (g *CallGraphIndex) CallerID(e int) int64 { return g.nodes[g.caller[e]] }
+
+// CalleeID returns the callee symbol ID of edge e.
+func (g *CallGraphIndex) CalleeID(e int) int64 { return g.nodes[g.callee[e]] }
+
+// Edge materializes edge e as a CallEdge.
+func (g *CallGraphIndex) Edge(e int) *CallEdge {
+	edge := &CallEdge{
+		ID:             g.edgeID[e],
+		CallerSymbolID: g.CallerID(e),
+		CalleeSymbolID: g.CalleeID(e),
+		Line:           int(g.line[e]),
+		Col:            int(g.col[e]),
+	}
+	if fid := g.fileID[e]; fid != 0 {
+		edge.FileID = &fid
+	}
+	return edge
+}
+
+// NumEdges returns the number of edges in the index.
+func (g *CallGraphIndex) NumEdges() int { return len(g.edgeID) }
+
+func (g *CallGraphIndex) node(symbolID int64) (int, bool) {
+	return slices.BinarySearch(g.nodes, symbolID)
+}
+
+// callGraphIndexKey is the metadata key holding the stamp of the persisted
+// index that matches the current call_graph table. Every statement that
+// writes call_graph deletes it (invalidateCallGraphIndexSQL), so a stale
+// file on disk is never used.
+const callGraphIndexKey = "call_graph_index"
+
+const invalidateCallGraphIndexSQL = "DELETE FROM metadata WHERE key = '" + callGraphIndexKey + "'"
+
+// CallGraphIndexPath returns where the persisted index for this database
+// lives, or "" for in-memory databases.
+func (s *Store) CallGraphIndexPath() string {
+	if inMemoryPath(s.path) {
+		return ""
+	}
+	return s.path + ".callgraph"
+}
+
+// BuildCallGraphIndex builds a CallGraphIndex from the call_graph table
+// without persisting it.
+func (s *Store) BuildCallGraphIndex() (*CallGraphIndex, error) {
+	rows, err := s.rdb.Query(`SELECT id, caller_symbol_id, callee_symbol_id, COALESCE(file_id, 0), COALESCE(line, 0), COALESCE(col, 0)
+		FROM call_graph ORDER BY caller_symbol_id, id`)
+	if err != nil {
+		return nil, fmt.Errorf("build call graph index: %w", err)
+	}
+	defer rows.Close()
+
+	g := &CallGraphIndex{}
+	var callerIDs, calleeIDs []int64
+	for rows.Next() {
+		var id, caller, callee, fileID int64
+		var line, col int32
+		if err := rows.Scan(&id, &caller, &callee, &fileID, &line, &col); err != nil {
+			return nil, fmt.Errorf("build call graph index: scan: %w", err)
+		}
+		g.edgeID = append(g.edgeID, id)
+		callerIDs = append(callerIDs, caller)
+		calleeIDs = append(calleeIDs, callee)
+		g.fileID = append(g.fileID, fileID)
+		g.line = append(g.line, line)
+		g.col = append(g.col, col)
+	}
+	if err := rows.Err(); err != nil {
+		return nil, fmt.Errorf("build call graph index: %w", err)
+	}
+
+	nodes := make([]int64, 0, len(callerIDs)+len(calleeIDs))
+	nodes = append(append(nodes, callerIDs...), calleeIDs...)
+	slices.Sort(nodes)
+	g.nodes = slices.Clip(slices.Compact(nodes))
+
+	n := len(g.nodes)
+	g.caller = make([]int32, len(callerIDs))
+	g.callee = make([]int32, len(calleeIDs))
+	g.fwdOff = make([]int32, n+1)
+	g.revOff = make([]int32, n+1)
+	for e := range callerIDs {
+		c, _ := g.node(callerIDs[e])
+		d, _ := g.node(calleeIDs[e])
+		g.caller[e], g.callee[e] = int32(c), int32(d)
+		g.fwdOff[c+1]++
+		g.revOff[d+1]++
+	}
+	for i := 0; i < n; i++ {
+		g.fwdOff[i+1] += g.fwdOff[i]
+		g.revOff[i+1] += g.revOff[i]
+	}
+
+	// Counting sort of edge indices by callee.
+	g.revEdges = make([]int32, len(g.callee))
+	next := slices.Clone(g.revOff[:n])
+	for e, d := range g.callee {
+		g.revEdges[next[d]] = int32(e)
+		next[d]++
+	}
+	return g, nil
+}
+
+// RebuildCallGraphIndex rebuilds the index from call_graph, writes it next
+// to the database and records its stamp, so later CallGraphIndex calls (in
+// this or any other process) can map it instead of reloading every edge.
+func (s *Store) RebuildCallGraphIndex() error {
+	path := s.CallGraphIndexPath()
+	if path == "" {
+		return nil
+	}
+	g, err := s.BuildCallGraphIndex()
+	if err != nil {
+		return err
+	}
+	stamp := time.Now().UnixNano()
+	if err := writeCallGraphIndex(path, g, stamp); err != nil {
+		return fmt.Errorf("write call graph index: %w", err)
+	}
+	return s.SetMetadata(callGraphIndexKey, strconv.FormatInt(stamp, 10))
+}
+
+// RefreshCallGraphIndex rebuilds the persisted index if call_graph has been
+// written since it was last built, and does nothing otherwise.
+func (s *Store) RefreshCallGraphIndex() error {
+	stamp, err := s.GetMetadata(callGraphIndexKey)
+	if err != nil || stamp != "" {
+		return err
+	}
+	return s.RebuildCallGraphIndex()
+}
+
+// CallGraphIndex returns an index matching the current call_graph table.
+// The persisted index is mapped on first use and reused until call_graph
+// changes; when no valid persisted index exists the index is built in
+// memory from SQLite.
+func (s *Store) CallGraphIndex() (*CallGraphIndex, error) {
+	stampStr, err := s.GetMetadata(callGraphIndexKey)
+	if err != nil {
+		return nil, err
+	}
+	stamp, _ := strconv.ParseInt(stampStr, 10, 64)
+	path := s.CallGraphIndexPath()
+	if stamp == 0 || path == "" {
+		return s.BuildCallGraphIndex()
+	}
+
+	s.cgMu.Lock()
+	defer s.cgMu.Unlock()
+	if s.cg != nil && s.cgStamp == stamp {
+		return s.cg, nil
+	}
+	data, err := mapFile(path)
+	if err != nil {
+		return s.BuildCallGraphIndex()
+	}
+	g, fileStamp, err := decodeCallGraphIndex(data)
+	if err != nil || fileStamp != stamp {
+		unmapFile(data)
+		return s.BuildCallGraphIndex()
+	}
+	// Earlier mappings may still be in use by in-flight queries; they are
+	// released by Close.
+	s.cgMaps = append(s.cgMaps, data)
+	s.cg, s.cgStamp = g, stamp
+	return g, nil
+}
+
+// closeCallGraphIndex releases every mapping made by CallGraphIndex.
+func (s *Store) closeCallGraphIndex() {
+	s.cgMu.Lock()
+	defer s.cgMu.Unlock()
+	for _, data := range s.cgMaps {
+		unmapFile(data)
+	}
+	s.cgMaps, s.cg = nil, nil
+}
+
+// On-disk layout: a fixed header of int64 words followed by the column
+// arrays in native byte order, each padded to 8 bytes so every section can
+// be viewed in place from the mapping.
+const (
+	callGraphIndexMagic   = 0x3130474359504e43 // "CNPYCG01" in little-endian byte order
+	callGraphIndexVersion = 1
+	callGraphByteOrder    = 0x0102030405060708
+	callGraphHeaderWords  = 6 // magic, version, byte order, stamp, nodes, edges
+)
+
+func writeCallGraphIndex(path string, g *CallGraphIndex, stamp int64) error {
+	tmp := path + ".tmp"
+	f, err := os.Create(tmp)
+	if err != nil {
+		return err
+	}
+	defer os.Remove(tmp)
+
+	w := bufio.NewWriterSize(f, 1<<20)
+	header := []int64{callGraphIndexMagic, callGraphIndexVersion, callGraphByteOrder,
+		stamp, int64(len(g.nodes)), int64(len(g.edgeID))}
+	writeSection(w, header)
+	writeSection(w, g.nodes)
+	writeSection(w, g.fwdOff)
+	writeSection(w, g.revOff)
+	writeSection(w, g.revEdges)
+	writeSection(w, g.edgeID)
+	writeSection(w, g.caller)
+	writeSection(w, g.callee)
+	writeSection(w, g.fileID)
+	writeSection(w, g.line)
+	writeSection(w, g.col)
+	if err := w.Flush(); err != nil {
+		f.Close()
+		return err
+	}
+	if err := f.Close(); err != nil {
+		return err
+	}
+	return os.Rename(tmp, path)
+}
+
+// writeSection writes s's raw bytes plus zero padding to an 8-byte
+// boundary. Errors are sticky in bufio.Writer and surface at Flush.
+func writeSection[T int32 | int64](w *bufio.Writer, s []T) {
+	if len(s) == 0 {
+		return
+	}
+	size := len(s) * int(unsafe.Sizeof(s[0]))
+	w.Write(unsafe.Slice((*byte)(unsafe.Pointer(&s[0])), size))
+	if pad := (8 - size%8) % 8; pad > 0 {
+		w.Write(make([]byte, pad))
+	}
+}
+
+var errBadCallGraphIndex = errors.New("call graph index: bad or incompatible file")
+
+func decodeCallGraphIndex(data []byte) (*CallGraphIndex, int64, error) {
+	r := sectionReader{data: data}
+	header := readSection[int64](&r, callGraphHeaderWords)
+	if header == nil || header[0] != callGraphIndexMagic || header[1] != callGraphIndexVersion ||
+		header[2] != callGraphByteOrder {
+		return nil, 0, errBadCallGraphIndex
+	}
+	stamp, n, m := header[3], int(header[4]), int(header[5])
+	if n < 0 || m < 0 {
+		return nil, 0, errBadCallGraphIndex
+	}
+	g := &CallGraphIndex{
+		nodes:    readSection[int64](&r, n),
+		fwdOff:   readSection[int32](&r, n+1),
+		revOff:   readSection[int32](&r, n+1),
+		revEdges: readSection[int32](&r, m),
+		edgeID:   readSection[int64](&r, m),
+		caller:   readSection[int32](&r, m),
+		callee:   readSection[int32](&r, m),
+		fileID:   readSection[int64](&r, m),
+		line:     readSection[int32](&r, m),
+		col:      readSection[int32](&r, m),
+	}
+	if r.short || r.off != len(data) {
+		return nil, 0, errBadCallGraphIndex
+	}
+	return g, stamp, nil
+}
+
+type sectionReader struct {
+	data  []byte
+	off   int
+	short bool
+}
+
+// readSection views the next n elements of r in place.
+func readSection[T int32 | int64](r *sectionReader, n int) []T {
+	var zero T
+	size := n * int(unsafe.Sizeof(zero))
+	padded := size + (8-size%8)%8
+	if r.short || r.off+padded > len(r.data) {
+		r.short = true
+		return nil
+	}
+	if n == 0 {
+		return []T{}
+	}
+	s := unsafe.Slice((*T)(unsafe.Pointer(&r.data[r.off])), n)
+	r.off += padded
+	return s
+}
@@ -0,0 +1,95 @@
+package store
+
+import (
+	"os"
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func callerIDs(g *CallGraphIndex, callee int64) []int64 {
+	var ids []int64
+	g.Callers(callee, func(e int) { ids = append(ids, g.CallerID(e)) })
+	return ids
+}
+
+func TestCallGraphIndex_PersistMapAndInvalidate(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	f := insertTestFile(t, s, "/main.go", "go")
+	a := insertTestSymbol(t, s, &f.ID, "A", "function")
+	b := insertTestSymbol(t, s, &f.ID, "B", "function")
+	c := insertTestSymbol(t, s, &f.ID, "C", "function")
+	for _, e := range []*CallEdge{
+		{CallerSymbolID: a.ID, CalleeSymbolID: c.ID, FileID: &f.ID, Line: 1},
+		{CallerSymbolID: b.ID, CalleeSymbolID: c.ID, Line: 2},
+		{CallerSymbolID: a.ID, CalleeSymbolID: b.ID, FileID: &f.ID, Line: 3, Col: 4},
+	} {
+		_, err := s.InsertCallEdge(e)
+		require.NoError(t, err)
+	}
+
+	require.NoError(t, s.RebuildCallGraphIndex())
+	_, err := os.Stat(s.CallGraphIndexPath())
+	require.NoError(t, err)
+
+	g, err := s.CallGraphIndex()
+	require.NoError(t, err)
+	assert.Equal(t, 3, g.NumEdges())
+	assert.ElementsMatch(t, []int64{a.ID, b.ID}, callerIDs(g, c.ID))
+
+	var callees []*CallEdge
+	g.Callees(a.ID, func(e int) { callees = append(callees, g.Edge(e)) })
+	require.Len(t, callees, 2)
+	for _, e := range callees {
+		if e.CalleeSymbolID == b.ID {
+			assert.Equal(t, 3, e.Line)
+			assert.Equal(t, 4, e.Col)
+			require.NotNil(t, e.FileID)
+			assert.Equal(t, f.ID, *e.FileID)
+		}
+	}
+
+	// The mapped index is reused while call_graph is unchanged.
+	again, err := s.CallGraphIndex()
+	require.NoError(t, err)
+	assert.Same(t, g, again)
+
+	// Refreshing an index that is still current leaves it in place.
+	stamp, err := s.GetMetadata(callGraphIndexKey)
+	require.NoError(t, err)
+	require.NoError(t, s.RefreshCallGraphIndex())
+	unchanged, err := s.GetMetadata(callGraphIndexKey)
+	require.NoError(t, err)
+	assert.Equal(t, stamp, unchanged)
+
+	// Writing call_graph invalidates the persisted index.
+	_, err = s.InsertCallEdge(&CallEdge{CallerSymbolID: c.ID, CalleeSymbolID: c.ID})
+	require.NoError(t, err)
+	fresh, err := s.CallGraphIndex()
+	require.NoError(t, err)
+	assert.Equal(t, 4, fresh.NumEdges())
+	assert.ElementsMatch(t, []int64{a.ID, b.ID, c.ID}, callerIDs(fresh, c.ID))
+
+	// And the next refresh rebuilds it.
+	require.NoError(t, s.RefreshCallGraphIndex())
+	rebuilt, err := s.GetMetadata(callGraphIndexKey)
+	require.NoError(t, err)
+	assert.NotEmpty(t, rebuilt)
+	assert.NotEqual(t, stamp, rebuilt)
+	mapped, err := s.CallGraphIndex()
+	require.NoError(t, err)
+	assert.Equal(t, 4, mapped.NumEdges())
+}
+
+func TestCallGraphIndex_EmptyGraph(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+
+	require.NoError(t, s.RebuildCallGraphIndex())
+	g, err := s.CallGraphIndex()
+	require.NoError(t, err)
+	assert.Zero(t, g.NumEdges())
+	assert.Empty(t, callerIDs(g, 1))
+}
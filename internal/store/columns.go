@@ -0,0 +1,200 @@
+package store
+
+import "slices"
+
+// Columnar buffers for the high-volume extraction tables. A file yields
+// thousands of symbols, scopes and references; buffering them as parallel
+// slices of plain integers keeps them out of the GC's pointer scan and
+// avoids one heap object per nullable ID, and interning names and kinds
+// stores each distinct string once per batch.
+
+// noID stands in for a nil *int64 in the columns. Real IDs are positive
+// and fake ones negative, so zero is never a valid ID.
+const noID int64 = 0
+
+func idOrNone(id *int64) int64 {
+	if id == nil {
+		return noID
+	}
+	return *id
+}
+
+// idPtr undoes idOrNone.
+func idPtr(id int64) *int64 {
+	if id == noID {
+		return nil
+	}
+	return &id
+}
+
+// strtab interns the strings of one batch; columns hold indexes into strs.
+type strtab struct {
+	ids  map[string]int32
+	strs []string
+	size int64 // total bytes of strs, for SizeEstimate
+}
+
+func (t *strtab) intern(s string) int32 {
+	if id, ok := t.ids[s]; ok {
+		return id
+	}
+	if t.ids == nil {
+		t.ids = make(map[string]int32)
+	}
+	id := int32(len(t.strs))
+	t.ids[s] = id
+	t.strs = append(t.strs, s)
+	t.size += int64(len(s))
+	return id
+}
+
+func (t *strtab) str(id int32) string { return t.strs[id] }
+
+// span holds the 0-based start/end positions shared by the columnar tables.
+type span struct {
+	startLine, startCol, endLine, endCol []int32
+}
+
+func (s *span) grow(n int) {
+	s.startLine = slices.Grow(s.startLine, n)
+	s.startCol = slices.Grow(s.startCol, n)
+	s.endLine = slices.Grow(s.endLine, n)
+	s.endCol = slices.Grow(s.endCol, n)
+}
+
+func (s *span) add(startLine, startCol, endLine, endCol int) {
+	s.startLine = append(s.startLine, int32(startLine))
+	s.startCol = append(s.startCol, int32(startCol))
+	s.endLine = append(s.endLine, int32(endLine))
+	s.endCol = append(s.endCol, int32(endCol))
+}
+
+func (s *span) at(i int) (startLine, startCol, endLine, endCol int) {
+	return int(s.startLine[i]), int(s.startCol[i]), int(s.endLine[i]), int(s.endCol[i])
+}
+
+type symbolColumns struct {
+	id, fileID, parent []int64
+	// String columns, as strtab indexes. modifiers holds the marshaled
+	// JSON written to the symbols table.
+	name, kind, visibility, modifiers, sigHash []int32
+	span
+}
+
+func (c *symbolColumns) len() int { return len(c.id) }
+
+func (c *symbolColumns) grow(n int) {
+	c.id = slices.Grow(c.id, n)
+	c.fileID = slices.Grow(c.fileID, n)
+	c.parent = slices.Grow(c.parent, n)
+	c.name = slices.Grow(c.name, n)
+	c.kind = slices.Grow(c.kind, n)
+	c.visibility = slices.Grow(c.visibility, n)
+	c.modifiers = slices.Grow(c.modifiers, n)
+	c.sigHash = slices.Grow(c.sigHash, n)
+	c.span.grow(n)
+}
+
+func (c *symbolColumns) add(t *strtab, sym *Symbol) {
+	c.id = append(c.id, sym.ID)
+	c.fileID = append(c.fileID, idOrNone(sym.FileID))
+	c.parent = append(c.parent, idOrNone(sym.ParentSymbolID))
+	c.name = append(c.name, t.intern(sym.Name))
+	c.kind = append(c.kind, t.intern(sym.Kind))
+	c.visibility = append(c.visibility, t.intern(sym.Visibility))
+	c.modifiers = append(c.modifiers, t.intern(marshalModifiers(sym.Modifiers)))
+	c.sigHash = append(c.sigHash, t.intern(sym.SignatureHash))
+	c.span.add(sym.StartLine, sym.StartCol, sym.EndLine, sym.EndCol)
+}
+
+// row materializes symbol i, the way the symbols table would return it.
+func (c *symbolColumns) row(t *strtab, i int) Symbol {
+	sym := Symbol{
+		ID:             c.id[i],
+		FileID:         idPtr(c.fileID[i]),
+		Name:           t.str(c.name[i]),
+		Kind:           t.str(c.kind[i]),
+		Visibility:     t.str(c.visibility[i]),
+		Modifiers:      unmarshalModifiers(t.str(c.modifiers[i])),
+		SignatureHash:  t.str(c.sigHash[i]),
+		ParentSymbolID: idPtr(c.parent[i]),
+	}
+	sym.StartLine, sym.StartCol, sym.EndLine, sym.EndCol = c.at(i)
+	return sym
+}
+
+type scopeColumns struct {
+	id, fileID, symbolID, parent []int64
+	kind                         []int32
+	span
+}
+
+func (c *scopeColumns) len() int { return len(c.id) }
+
+func (c *scopeColumns) grow(n int) {
+	c.id = slices.Grow(c.id, n)
+	c.fileID = slices.Grow(c.fileID, n)
+	c.symbolID = slices.Grow(c.symbolID, n)
+	c.parent = slices.Grow(c.parent, n)
+	c.kind = slices.Grow(c.kind, n)
+	c.span.grow(n)
+}
+
+func (c *scopeColumns) add(t *strtab, sc *Scope) {
+	c.id = append(c.id, sc.ID)
+	c.fileID = append(c.fileID, sc.FileID)
+	c.symbolID = append(c.symbolID, idOrNone(sc.SymbolID))
+	c.parent = append(c.parent, idOrNone(sc.ParentScopeID))
+	c.kind = append(c.kind, t.intern(sc.Kind))
+	c.span.add(sc.StartLine, sc.StartCol, sc.EndLine, sc.EndCol)
+}
+
+func (c *scopeColumns) row(t *strtab, i int) Scope {
+	sc := Scope{
+		ID:            c.id[i],
+		FileID:        c.fileID[i],
+		SymbolID:      idPtr(c.symbolID[i]),
+		Kind:          t.str(c.kind[i]),
+		ParentScopeID: idPtr(c.parent[i]),
+	}
+	sc.StartLine, sc.StartCol, sc.EndLine, sc.EndCol = c.at(i)
+	return sc
+}
+
+type referenceColumns struct {
+	id, fileID, scopeID []int64
+	name, context       []int32
+	span
+}
+
+func (c *referenceColumns) len() int { return len(c.id) }
+
+func (c *referenceColumns) grow(n int) {
+	c.id = slices.Grow(c.id, n)
+	c.fileID = slices.Grow(c.fileID, n)
+	c.scopeID = slices.Grow(c.scopeID, n)
+	c.name = slices.Grow(c.name, n)
+	c.context = slices.Grow(c.context, n)
+	c.span.grow(n)
+}
+
+func (c *referenceColumns) add(t *strtab, ref *Reference) {
+	c.id = append(c.id, ref.ID)
+	c.fileID = append(c.fileID, ref.FileID)
+	c.scopeID = append(c.scopeID, idOrNone(ref.ScopeID))
+	c.name = append(c.name, t.intern(ref.Name))
+	c.context = append(c.context, t.intern(ref.Context))
+	c.span.add(ref.StartLine, ref.StartCol, ref.EndLine, ref.EndCol)
+}
+
+func (c *referenceColumns) row(t *strtab, i int) Reference {
+	ref := Reference{
+		ID:      c.id[i],
+		FileID:  c.fileID[i],
+		ScopeID: idPtr(c.scopeID[i]),
+		Name:    t.str(c.name[i]),
+		Context: t.str(c.context[i]),
+	}
+	ref.StartLine, ref.StartCol, ref.EndLine, ref.EndCol = c.at(i)
+	return ref
+}
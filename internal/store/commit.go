@@ -3,6 +3,7 @@ package store
 import (
 	"database/sql"
 	"fmt"
+	"strings"
 )
 
 // CommitBatch inserts all buffered data from a BatchedStore into SQLite
@@ -11,7 +12,8 @@ import (
 // are rewritten using the fakeToReal mapping.
 //
 // Insert order respects FK dependencies:
-//  1. Symbols (depend on file_id only, which is already real)
+//  1. Symbols (depend on file_id only, which is already real), and the
+//     symbol_trigrams rows indexing their names
 //  2. Scopes (depend on file_id, symbol_id, parent_scope_id)
 //  3. References (depend on file_id, scope_id)
 //  4. Imports (depend on file_id only)
@@ -21,260 +23,350 @@ import (
 //  8. Annotations (depend on symbol_id, file_id)
 //  9. SymbolFragments (depend on symbol_id, file_id)
 func (s *Store) CommitBatch(batch *BatchedStore) error {
+	return s.CommitBatches([]*BatchedStore{batch})
+}
+
+// CommitBatches inserts several BatchedStores in one transaction, amortizing
+// the per-transaction fsync and lock acquisition across many files. Each
+// batch keeps its own fake ID namespace. On error nothing is committed; the
+// batches are left untouched and may be retried individually with
+// CommitBatch.
+func (s *Store) CommitBatches(batches []*BatchedStore) error {
 	tx, err := s.db.Begin()
 	if err != nil {
 		return fmt.Errorf("commit batch: begin: %w", err)
 	}
 	defer tx.Rollback()
 
-	fakeToReal := make(map[int64]int64)
-
-	// 1. Symbols
-	for _, sym := range batch.Symbols {
-		// parent_symbol_id may be fake (intra-file) or real (cross-file)
-		if sym.ParentSymbolID != nil && *sym.ParentSymbolID < 0 {
-			realID := fakeToReal[*sym.ParentSymbolID]
-			sym.ParentSymbolID = &realID
-		}
-		realID, err := insertSymbolTx(tx, &sym)
-		if err != nil {
-			return fmt.Errorf("commit batch: symbol %q: %w", sym.Name, err)
+	w := newBatchWriter(tx)
+	w.compactRefs = s.compactRefs
+	defer w.close()
+	for _, batch := range batches {
+		if err := w.commit(batch); err != nil {
+			return err
 		}
-		fakeToReal[sym.ID] = realID
 	}
+	return tx.Commit()
+}
 
-	// 2. Scopes
-	for _, scope := range batch.Scopes {
-		if scope.ParentScopeID != nil && *scope.ParentScopeID < 0 {
-			realID := fakeToReal[*scope.ParentScopeID]
-			scope.ParentScopeID = &realID
-		}
-		if scope.SymbolID != nil && *scope.SymbolID < 0 {
-			realID := fakeToReal[*scope.SymbolID]
-			scope.SymbolID = &realID
-		}
-		realID, err := insertScopeTx(tx, &scope)
-		if err != nil {
-			return fmt.Errorf("commit batch: scope: %w", err)
-		}
-		fakeToReal[scope.ID] = realID
+// bulkTable describes an insert target whose rows have no in-batch
+// dependents, so they can be written with multi-row VALUES statements
+// without needing each row's LastInsertId.
+type bulkTable struct {
+	name string
+	cols []string
+}
+
+var (
+	refsTable = bulkTable{"references_", []string{
+		"file_id", "scope_id", "name", "start_line", "start_col", "end_line", "end_col", "context"}}
+	// slimRefsTable holds the rows of references written to a block.
+	slimRefsTable = bulkTable{"references_", []string{"id", "file_id", "name"}}
+	importsTable  = bulkTable{"imports", []string{
+		"file_id", "source", "imported_name", "local_alias", "kind", "scope", "source_segment"}}
+	typeMembersTable = bulkTable{"type_members", []string{
+		"symbol_id", "name", "kind", "type_expr", "visibility"}}
+	functionParamsTable = bulkTable{"function_parameters", []string{
+		"symbol_id", "name", "ordinal", "type_expr", "is_receiver", "is_return", "has_default", "default_expr"}}
+	typeParamsTable = bulkTable{"type_parameters", []string{
+		"symbol_id", "name", "ordinal", "variance", "param_kind", "constraints"}}
+	annotationsTable = bulkTable{"annotations", []string{
+		"target_symbol_id", "name", "resolved_symbol_id", "arguments", "file_id", "line", "col"}}
+	symbolFragmentsTable = bulkTable{"symbol_fragments", []string{
+		"symbol_id", "file_id", "start_line", "start_col", "end_line", "end_col", "is_primary"}}
+)
+
+// bulkRowsPerStmt caps the rows in one multi-row INSERT. At 8 columns this
+// binds 2048 parameters, well under SQLite's variable limit.
+const bulkRowsPerStmt = 256
+
+const (
+	insertSymbolSQL = `INSERT INTO symbols (file_id, name, kind, visibility, modifiers, signature_hash,
+			start_line, start_col, end_line, end_col, parent_symbol_id)
+		 VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)`
+	insertScopeSQL = `INSERT INTO scopes (file_id, symbol_id, kind, start_line, start_col, end_line, end_col, parent_scope_id)
+		 VALUES (?, ?, ?, ?, ?, ?, ?, ?)`
+)
+
+// batchWriter commits batches within one transaction. Statements are
+// prepared once per transaction and reused for every row and every batch,
+// so SQLite parses each INSERT once instead of once per row.
+type batchWriter struct {
+	tx    *sql.Tx
+	stmts map[string]*sql.Stmt
+
+	// compactRefs writes references into per-file blocks (see
+	// WithCompactReferences); nextRefID is the ID the next one gets.
+	compactRefs bool
+	nextRefID   int64
+}
+
+func newBatchWriter(tx *sql.Tx) *batchWriter {
+	return &batchWriter{tx: tx, stmts: make(map[string]*sql.Stmt)}
+}
+
+func (w *batchWriter) close() {
+	for _, stmt := range w.stmts {
+		stmt.Close()
 	}
+}
 
-	// 3. References
-	for _, ref := range batch.References {
-		if ref.ScopeID != nil && *ref.ScopeID < 0 {
-			realID := fakeToReal[*ref.ScopeID]
-			ref.ScopeID = &realID
-		}
-		realID, err := insertReferenceTx(tx, &ref)
-		if err != nil {
-			return fmt.Errorf("commit batch: reference %q: %w", ref.Name, err)
-		}
-		fakeToReal[ref.ID] = realID
+// stmt returns the prepared statement for query, preparing it on first use.
+func (w *batchWriter) stmt(query string) (*sql.Stmt, error) {
+	if stmt, ok := w.stmts[query]; ok {
+		return stmt, nil
+	}
+	stmt, err := w.tx.Prepare(query)
+	if err != nil {
+		return nil, err
 	}
+	w.stmts[query] = stmt
+	return stmt, nil
+}
 
-	// 4. Imports
-	for _, imp := range batch.Imports {
-		realID, err := insertImportTx(tx, &imp)
-		if err != nil {
-			return fmt.Errorf("commit batch: import %q: %w", imp.Source, err)
-		}
-		fakeToReal[imp.ID] = realID
+// insertOne executes a single-row prepared INSERT and returns the new row ID.
+func (w *batchWriter) insertOne(query string, args ...any) (int64, error) {
+	stmt, err := w.stmt(query)
+	if err != nil {
+		return 0, err
 	}
+	res, err := stmt.Exec(args...)
+	if err != nil {
+		return 0, err
+	}
+	return res.LastInsertId()
+}
 
-	// 5. TypeMembers
-	for _, tm := range batch.TypeMembers {
-		if tm.SymbolID < 0 {
-			realID, ok := fakeToReal[tm.SymbolID]
-			if !ok {
-				return fmt.Errorf("commit batch: type member %q has symbol_id=%d not in fakeToReal map (have %d symbols)", tm.Name, tm.SymbolID, len(batch.Symbols))
-			}
-			tm.SymbolID = realID
-		}
-		realID, err := insertTypeMemberTx(tx, &tm)
-		if err != nil {
-			return fmt.Errorf("commit batch: type member %q: %w", tm.Name, err)
-		}
-		fakeToReal[tm.ID] = realID
+// insertRows writes the flattened row values in args to t. Full chunks of
+// bulkRowsPerStmt rows share one prepared multi-row statement; the
+// remainder goes through the prepared single-row statement.
+func (w *batchWriter) insertRows(t bulkTable, args []any) error {
+	n := len(t.cols)
+	rows := len(args) / n
+	if rows == 0 {
+		return nil
 	}
 
-	// 6. FunctionParams
-	for _, fp := range batch.FunctionParams {
-		if fp.SymbolID < 0 {
-			fp.SymbolID = fakeToReal[fp.SymbolID]
-		}
-		realID, err := insertFunctionParamTx(tx, &fp)
+	if rows >= bulkRowsPerStmt {
+		stmt, err := w.stmt(t.insertSQL(bulkRowsPerStmt))
 		if err != nil {
-			return fmt.Errorf("commit batch: function param %q: %w", fp.Name, err)
+			return err
 		}
-		fakeToReal[fp.ID] = realID
+		chunk := bulkRowsPerStmt * n
+		for len(args) >= chunk {
+			if _, err := stmt.Exec(args[:chunk]...); err != nil {
+				return err
+			}
+			args = args[chunk:]
+		}
+	}
+	if len(args) == 0 {
+		return nil
 	}
 
-	// 7. TypeParams
-	for _, tp := range batch.TypeParams {
-		if tp.SymbolID < 0 {
-			tp.SymbolID = fakeToReal[tp.SymbolID]
-		}
-		realID, err := insertTypeParamTx(tx, &tp)
-		if err != nil {
-			return fmt.Errorf("commit batch: type param %q: %w", tp.Name, err)
+	stmt, err := w.stmt(t.insertSQL(1))
+	if err != nil {
+		return err
+	}
+	for len(args) > 0 {
+		if _, err := stmt.Exec(args[:n]...); err != nil {
+			return err
 		}
-		fakeToReal[tp.ID] = realID
+		args = args[n:]
 	}
+	return nil
+}
 
-	// 8. Annotations
-	for _, ann := range batch.Annotations {
-		if ann.TargetSymbolID < 0 {
-			ann.TargetSymbolID = fakeToReal[ann.TargetSymbolID]
+// insertSQL builds "INSERT INTO t (cols) VALUES (?,...), ..." for rows rows.
+func (t bulkTable) insertSQL(rows int) string {
+	row := "(" + placeholderList(len(t.cols)) + ")"
+	var b strings.Builder
+	b.WriteString("INSERT INTO ")
+	b.WriteString(t.name)
+	b.WriteString(" (")
+	b.WriteString(strings.Join(t.cols, ", "))
+	b.WriteString(") VALUES ")
+	b.WriteString(row)
+	for i := 1; i < rows; i++ {
+		b.WriteString(", ")
+		b.WriteString(row)
+	}
+	return b.String()
+}
+
+// commit writes one batch. Fake IDs are remapped into the statement
+// arguments, so the batch itself is never mutated.
+func (w *batchWriter) commit(batch *BatchedStore) error {
+	syms, scopes, refs, strs := &batch.symbols, &batch.scopes, &batch.references, &batch.strs
+	fakeToReal := make(map[int64]int64, syms.len()+scopes.len())
+	remap := func(id int64) int64 {
+		if id < 0 {
+			return fakeToReal[id]
 		}
-		if ann.ResolvedSymbolID != nil && *ann.ResolvedSymbolID < 0 {
-			realID := fakeToReal[*ann.ResolvedSymbolID]
-			ann.ResolvedSymbolID = &realID
+		return id
+	}
+	remapPtr := func(id *int64) *int64 {
+		if id != nil && *id < 0 {
+			realID := fakeToReal[*id]
+			return &realID
 		}
-		if ann.FileID != nil && *ann.FileID < 0 {
-			realID := fakeToReal[*ann.FileID]
-			ann.FileID = &realID
+		return id
+	}
+	// remapCol is remapPtr for a column value, with noID bound as NULL.
+	remapCol := func(id int64) any {
+		if id == noID {
+			return nil
 		}
-		realID, err := insertAnnotationTx(tx, &ann)
+		return remap(id)
+	}
+
+	// 1. Symbols — row-at-a-time: parent_symbol_id may point at an earlier
+	// symbol in the same batch, so each real ID is needed immediately.
+	// Signature hashes are computed here, from the buffered child rows.
+	hashes := batchSignatureHashes(batch)
+	for i, fakeID := range syms.id {
+		realID, err := w.insertOne(insertSymbolSQL,
+			remapCol(syms.fileID[i]), strs.str(syms.name[i]), strs.str(syms.kind[i]), strs.str(syms.visibility[i]),
+			strs.str(syms.modifiers[i]), hashes[i],
+			syms.startLine[i], syms.startCol[i], syms.endLine[i], syms.endCol[i], remapCol(syms.parent[i]),
+		)
 		if err != nil {
-			return fmt.Errorf("commit batch: annotation %q: %w", ann.Name, err)
+			return fmt.Errorf("commit batch: symbol %q: %w", strs.str(syms.name[i]), err)
 		}
-		fakeToReal[ann.ID] = realID
+		fakeToReal[fakeID] = realID
+	}
+	var tris []any
+	for i, fakeID := range syms.id {
+		tris = appendTrigramRows(tris, fakeToReal[fakeID], strs.str(syms.name[i]))
+	}
+	if err := w.insertRows(symbolTrigramsTable, tris); err != nil {
+		return fmt.Errorf("commit batch: symbol trigrams: %w", err)
 	}
 
-	// 9. SymbolFragments
-	for _, sf := range batch.SymbolFragments {
-		if sf.SymbolID < 0 {
-			sf.SymbolID = fakeToReal[sf.SymbolID]
-		}
-		if sf.FileID < 0 {
-			sf.FileID = fakeToReal[sf.FileID]
-		}
-		realID, err := insertSymbolFragmentTx(tx, &sf)
+	// 2. Scopes — row-at-a-time for the same reason (parent_scope_id).
+	for i, fakeID := range scopes.id {
+		realID, err := w.insertOne(insertScopeSQL,
+			scopes.fileID[i], remapCol(scopes.symbolID[i]), strs.str(scopes.kind[i]),
+			scopes.startLine[i], scopes.startCol[i], scopes.endLine[i], scopes.endCol[i], remapCol(scopes.parent[i]),
+		)
 		if err != nil {
-			return fmt.Errorf("commit batch: symbol fragment: %w", err)
+			return fmt.Errorf("commit batch: scope: %w", err)
 		}
-		fakeToReal[sf.ID] = realID
+		fakeToReal[fakeID] = realID
 	}
 
-	return tx.Commit()
-}
+	// 3–9. Leaf tables: nothing in the batch refers to these rows, so they
+	// are written with multi-row VALUES statements.
 
-// --- Transaction-scoped insert helpers ---
-// These mirror the Store insert methods but accept *sql.Tx instead of using s.db.
-
-func insertSymbolTx(tx *sql.Tx, sym *Symbol) (int64, error) {
-	mods := marshalModifiers(sym.Modifiers)
-	res, err := tx.Exec(
-		`INSERT INTO symbols (file_id, name, kind, visibility, modifiers, signature_hash,
-			start_line, start_col, end_line, end_col, parent_symbol_id)
-		 VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)`,
-		sym.FileID, sym.Name, sym.Kind, sym.Visibility, mods, sym.SignatureHash,
-		sym.StartLine, sym.StartCol, sym.EndLine, sym.EndCol, sym.ParentSymbolID,
-	)
-	if err != nil {
-		return 0, err
+	args := make([]any, 0, refs.len()*len(refsTable.cols))
+	if w.compactRefs {
+		if err := w.packRefs(refs, strs, remap); err != nil {
+			return fmt.Errorf("commit batch: references: %w", err)
+		}
+	} else {
+		for i := range refs.id {
+			args = append(args, refs.fileID[i], remapCol(refs.scopeID[i]), strs.str(refs.name[i]),
+				refs.startLine[i], refs.startCol[i], refs.endLine[i], refs.endCol[i], strs.str(refs.context[i]))
+		}
+		if err := w.insertRows(refsTable, args); err != nil {
+			return fmt.Errorf("commit batch: references: %w", err)
+		}
 	}
-	return res.LastInsertId()
-}
 
-func insertScopeTx(tx *sql.Tx, scope *Scope) (int64, error) {
-	res, err := tx.Exec(
-		`INSERT INTO scopes (file_id, symbol_id, kind, start_line, start_col, end_line, end_col, parent_scope_id)
-		 VALUES (?, ?, ?, ?, ?, ?, ?, ?)`,
-		scope.FileID, scope.SymbolID, scope.Kind,
-		scope.StartLine, scope.StartCol, scope.EndLine, scope.EndCol, scope.ParentScopeID,
-	)
-	if err != nil {
-		return 0, err
+	args = args[:0]
+	for _, imp := range batch.imports {
+		args = append(args, imp.FileID, imp.Source, imp.ImportedName, imp.LocalAlias, imp.Kind, imp.Scope, lastSegment(imp.Source))
 	}
-	return res.LastInsertId()
-}
-
-func insertReferenceTx(tx *sql.Tx, ref *Reference) (int64, error) {
-	res, err := tx.Exec(
-		`INSERT INTO references_ (file_id, scope_id, name, start_line, start_col, end_line, end_col, context)
-		 VALUES (?, ?, ?, ?, ?, ?, ?, ?)`,
-		ref.FileID, ref.ScopeID, ref.Name,
-		ref.StartLine, ref.StartCol, ref.EndLine, ref.EndCol, ref.Context,
-	)
-	if err != nil {
-		return 0, err
+	if err := w.insertRows(importsTable, args); err != nil {
+		return fmt.Errorf("commit batch: imports: %w", err)
 	}
-	return res.LastInsertId()
-}
 
-func insertImportTx(tx *sql.Tx, imp *Import) (int64, error) {
-	res, err := tx.Exec(
-		`INSERT INTO imports (file_id, source, imported_name, local_alias, kind, scope)
-		 VALUES (?, ?, ?, ?, ?, ?)`,
-		imp.FileID, imp.Source, imp.ImportedName, imp.LocalAlias, imp.Kind, imp.Scope,
-	)
-	if err != nil {
-		return 0, err
+	args = args[:0]
+	for _, tm := range batch.typeMembers {
+		if tm.SymbolID < 0 {
+			if _, ok := fakeToReal[tm.SymbolID]; !ok {
+				return fmt.Errorf("commit batch: type member %q has symbol_id=%d not in fakeToReal map (have %d symbols)", tm.Name, tm.SymbolID, syms.len())
+			}
+		}
+		args = append(args, remap(tm.SymbolID), tm.Name, tm.Kind, tm.TypeExpr, tm.Visibility)
+	}
+	if err := w.insertRows(typeMembersTable, args); err != nil {
+		return fmt.Errorf("commit batch: type members: %w", err)
 	}
-	return res.LastInsertId()
-}
 
-func insertTypeMemberTx(tx *sql.Tx, tm *TypeMember) (int64, error) {
-	res, err := tx.Exec(
-		`INSERT INTO type_members (symbol_id, name, kind, type_expr, visibility)
-		 VALUES (?, ?, ?, ?, ?)`,
-		tm.SymbolID, tm.Name, tm.Kind, tm.TypeExpr, tm.Visibility,
-	)
-	if err != nil {
-		return 0, err
+	args = args[:0]
+	for _, fp := range batch.functionParams {
+		args = append(args, remap(fp.SymbolID), fp.Name, fp.Ordinal, fp.TypeExpr,
+			fp.IsReceiver, fp.IsReturn, fp.HasDefault, fp.DefaultExpr)
+	}
+	if err := w.insertRows(functionParamsTable, args); err != nil {
+		return fmt.Errorf("commit batch: function params: %w", err)
 	}
-	return res.LastInsertId()
-}
 
-func insertFunctionParamTx(tx *sql.Tx, fp *FunctionParam) (int64, error) {
-	res, err := tx.Exec(
-		`INSERT INTO function_parameters (symbol_id, name, ordinal, type_expr, is_receiver, is_return, has_default, default_expr)
-		 VALUES (?, ?, ?, ?, ?, ?, ?, ?)`,
-		fp.SymbolID, fp.Name, fp.Ordinal, fp.TypeExpr,
-		fp.IsReceiver, fp.IsReturn, fp.HasDefault, fp.DefaultExpr,
-	)
-	if err != nil {
-		return 0, err
+	args = args[:0]
+	for _, tp := range batch.typeParams {
+		args = append(args, remap(tp.SymbolID), tp.Name, tp.Ordinal, tp.Variance, tp.ParamKind, tp.Constraints)
+	}
+	if err := w.insertRows(typeParamsTable, args); err != nil {
+		return fmt.Errorf("commit batch: type params: %w", err)
 	}
-	return res.LastInsertId()
-}
 
-func insertTypeParamTx(tx *sql.Tx, tp *TypeParam) (int64, error) {
-	res, err := tx.Exec(
-		`INSERT INTO type_parameters (symbol_id, name, ordinal, variance, param_kind, constraints)
-		 VALUES (?, ?, ?, ?, ?, ?)`,
-		tp.SymbolID, tp.Name, tp.Ordinal, tp.Variance, tp.ParamKind, tp.Constraints,
-	)
-	if err != nil {
-		return 0, err
+	args = args[:0]
+	for _, ann := range batch.annotations {
+		args = append(args, remap(ann.TargetSymbolID), ann.Name, remapPtr(ann.ResolvedSymbolID), ann.Arguments,
+			remapPtr(ann.FileID), ann.Line, ann.Col)
+	}
+	if err := w.insertRows(annotationsTable, args); err != nil {
+		return fmt.Errorf("commit batch: annotations: %w", err)
 	}
-	return res.LastInsertId()
-}
 
-func insertAnnotationTx(tx *sql.Tx, ann *Annotation) (int64, error) {
-	res, err := tx.Exec(
-		`INSERT INTO annotations (target_symbol_id, name, resolved_symbol_id, arguments, file_id, line, col)
-		 VALUES (?, ?, ?, ?, ?, ?, ?)`,
-		ann.TargetSymbolID, ann.Name, ann.ResolvedSymbolID, ann.Arguments,
-		ann.FileID, ann.Line, ann.Col,
-	)
-	if err != nil {
-		return 0, err
+	args = args[:0]
+	for _, sf := range batch.symbolFragments {
+		args = append(args, remap(sf.SymbolID), remap(sf.FileID), sf.StartLine, sf.StartCol,
+			sf.EndLine, sf.EndCol, sf.IsPrimary)
 	}
-	return res.LastInsertId()
+	if err := w.insertRows(symbolFragmentsTable, args); err != nil {
+		return fmt.Errorf("commit batch: symbol fragments: %w", err)
+	}
+
+	return nil
 }
 
-func insertSymbolFragmentTx(tx *sql.Tx, frag *SymbolFragment) (int64, error) {
-	res, err := tx.Exec(
-		`INSERT INTO symbol_fragments (symbol_id, file_id, start_line, start_col, end_line, end_col, is_primary)
-		 VALUES (?, ?, ?, ?, ?, ?, ?)`,
-		frag.SymbolID, frag.FileID, frag.StartLine, frag.StartCol,
-		frag.EndLine, frag.EndCol, frag.IsPrimary,
-	)
-	if err != nil {
-		return 0, err
+// packRefs writes a batch's references in compact form: slim references_
+// rows with IDs assigned here, so the blocks can carry them, and the
+// references themselves into their files' blocks.
+func (w *batchWriter) packRefs(refs *referenceColumns, strs *strtab, remap func(int64) int64) error {
+	if refs.len() == 0 {
+		return nil
 	}
-	return res.LastInsertId()
+	if w.nextRefID == 0 {
+		if err := w.tx.QueryRow("SELECT COALESCE(MAX(id), 0) + 1 FROM references_").Scan(&w.nextRefID); err != nil {
+			return err
+		}
+	}
+	byFile := make(map[int64][]Reference)
+	var files []int64
+	args := make([]any, 0, refs.len()*len(slimRefsTable.cols))
+	for i := range refs.id {
+		r := refs.row(strs, i)
+		r.ID = w.nextRefID
+		w.nextRefID++
+		if r.ScopeID != nil {
+			r.ScopeID = idPtr(remap(*r.ScopeID))
+		}
+		if _, ok := byFile[r.FileID]; !ok {
+			files = append(files, r.FileID)
+		}
+		byFile[r.FileID] = append(byFile[r.FileID], r)
+		args = append(args, r.ID, r.FileID, "")
+	}
+	if err := w.insertRows(slimRefsTable, args); err != nil {
+		return err
+	}
+	for _, fid := range files {
+		if err := packReferences(w.tx, fid, byFile[fid]); err != nil {
+			return err
+		}
+	}
+	return nil
 }
@@ -22,3 +22,37 @@ type DataStore interface {
 
 // Compile-time check: *Store satisfies DataStore.
 var _ DataStore = (*Store)(nil)
+
+// ResolutionReader is the read side used by resolution scripts. Store reads
+// straight from SQLite; ReadCache memoizes the same queries so concurrent
+// resolution shards of one language share a single copy of the results.
+type ResolutionReader interface {
+	SymbolsByName(name string) ([]*Symbol, error)
+	SymbolsByFile(fileID int64) ([]*Symbol, error)
+	SymbolsByKind(kind string) ([]*Symbol, error)
+	ReferencesByFile(fileID int64) ([]*Reference, error)
+	ScopesByFile(fileID int64) ([]*Scope, error)
+	ScopeChain(scopeID int64) ([]*Scope, error)
+	ImportsByFile(fileID int64) ([]*Import, error)
+	TypeMembers(symbolID int64) ([]*TypeMember, error)
+	FunctionParams(symbolID int64) ([]*FunctionParam, error)
+	FilesByLanguage(language string) ([]*File, error)
+	LanguageSnapshot(language string) (*LanguageSnapshot, error)
+}
+
+// ResolutionWriter is the write side used by resolution scripts. Store
+// writes each row immediately; ResolutionBatch buffers rows and flushes them
+// in bulk transactions.
+type ResolutionWriter interface {
+	InsertResolvedReference(rr *ResolvedReference) (int64, error)
+	InsertImplementation(impl *Implementation) (int64, error)
+	InsertCallEdge(edge *CallEdge) (int64, error)
+	InsertExtensionBinding(eb *ExtensionBinding) (int64, error)
+}
+
+var (
+	_ ResolutionReader = (*Store)(nil)
+	_ ResolutionReader = (*ReadCache)(nil)
+	_ ResolutionWriter = (*Store)(nil)
+	_ ResolutionWriter = (*ResolutionBatch)(nil)
+)
@@ -0,0 +1,117 @@
+package store
+
+import (
+	"fmt"
+	"path/filepath"
+	"strings"
+)
+
+// Snapshot writes a compacted, self-contained copy of the database (no
+// WAL, no free pages) to path, which must not exist. It runs as a single
+// read transaction, so the copy is consistent even while s is written to.
+func (s *Store) Snapshot(path string) error {
+	if _, err := s.db.Exec("VACUUM INTO ?", path); err != nil {
+		return fmt.Errorf("snapshot: %w", err)
+	}
+	return nil
+}
+
+// ReplaceDatabase moves the database file src over dst, as Publish moves a
+// bulk load into place: renamed, or copied into dst if another process has
+// it open. dst's call graph index goes with it, since src has none.
+func ReplaceDatabase(src, dst string) error {
+	lock, err := installDatabase(src, dst)
+	if err != nil {
+		return fmt.Errorf("replace database: %w", err)
+	}
+	return lock.Close()
+}
+
+// relocateStagingDDL creates the per-connection temp table RelocatePaths
+// stages the new paths of the files it moves in.
+const relocateStagingDDL = `
+CREATE TEMP TABLE IF NOT EXISTS relocated (id INTEGER PRIMARY KEY, path TEXT NOT NULL);
+DELETE FROM relocated;
+`
+
+// RelocatePaths moves the files indexed under the directory from to the
+// same relative paths under to, as when a database built in one checkout
+// is used in another, and rebuilds the derived tables that depend on
+// paths: the package graph and the include graph. It returns the number
+// of files moved.
+func (s *Store) RelocatePaths(from, to string) (int, error) {
+	from, to = filepath.Clean(from), filepath.Clean(to)
+	if from == to {
+		return 0, nil
+	}
+	prefix := from + string(filepath.Separator)
+	if strings.HasSuffix(from, string(filepath.Separator)) {
+		prefix = from // the filesystem root
+	}
+
+	rows, err := s.db.Query("SELECT id, path FROM files")
+	if err != nil {
+		return 0, fmt.Errorf("relocate paths: %w", err)
+	}
+	moved := make(map[int64]string)
+	for rows.Next() {
+		var id int64
+		var path string
+		if err := rows.Scan(&id, &path); err != nil {
+			rows.Close()
+			return 0, fmt.Errorf("relocate paths: %w", err)
+		}
+		if rel, ok := strings.CutPrefix(path, prefix); ok {
+			moved[id] = filepath.Join(to, rel)
+		}
+	}
+	rows.Close()
+	if err := rows.Err(); err != nil {
+		return 0, fmt.Errorf("relocate paths: %w", err)
+	}
+	if len(moved) == 0 {
+		return 0, nil
+	}
+
+	tx, err := s.db.Begin()
+	if err != nil {
+		return 0, fmt.Errorf("relocate paths: begin: %w", err)
+	}
+	defer tx.Rollback()
+	if _, err := tx.Exec(relocateStagingDDL); err != nil {
+		return 0, fmt.Errorf("relocate paths: stage: %w", err)
+	}
+	stmt, err := tx.Prepare("INSERT INTO relocated (id, path) VALUES (?, ?)")
+	if err != nil {
+		return 0, fmt.Errorf("relocate paths: stage: %w", err)
+	}
+	defer stmt.Close()
+	for id, path := range moved {
+		if _, err := stmt.Exec(id, path); err != nil {
+			return 0, fmt.Errorf("relocate paths: stage %s: %w", path, err)
+		}
+	}
+	// SQLite checks uniqueness row by row, so when to is under from, or
+	// the trees overlap, a file can land on a path another moved file
+	// still holds. The moved files first take placeholder paths, which no
+	// (absolute) indexed path equals, and then their new ones.
+	for _, q := range []string{
+		"UPDATE files SET path = 'relocating:' || id WHERE id IN (SELECT id FROM relocated)",
+		"UPDATE files SET path = (SELECT path FROM relocated WHERE relocated.id = files.id) WHERE id IN (SELECT id FROM relocated)",
+	} {
+		if _, err := tx.Exec(q); err != nil {
+			return 0, fmt.Errorf("relocate paths: %w", err)
+		}
+	}
+	if err := tx.Commit(); err != nil {
+		return 0, fmt.Errorf("relocate paths: commit: %w", err)
+	}
+
+	if err := s.rebuildPackageGraph(); err != nil {
+		return 0, fmt.Errorf("relocate paths: %w", err)
+	}
+	if err := s.rebuildIncludeGraph(); err != nil {
+		return 0, fmt.Errorf("relocate paths: %w", err)
+	}
+	return len(moved), nil
+}
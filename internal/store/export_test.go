@@ -0,0 +1,85 @@
+package store
+
+import (
+	"path/filepath"
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func TestSnapshot_CopiesDatabase(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	f := insertTestFile(t, s, "/repo/main.go", "go")
+	insertTestSymbol(t, s, &f.ID, "main", "function")
+	require.NoError(t, s.SetMetadata("scripts_hash", "abc"))
+
+	path := filepath.Join(t.TempDir(), "snap.db")
+	require.NoError(t, s.Snapshot(path))
+
+	c, err := NewStore(path)
+	require.NoError(t, err)
+	defer c.Close()
+	got, err := c.FileByPath("/repo/main.go")
+	require.NoError(t, err)
+	require.NotNil(t, got)
+	rows, err := c.Rows(got.ID)
+	require.NoError(t, err)
+	require.Len(t, rows.Symbols, 1)
+	hash, err := c.GetMetadata("scripts_hash")
+	require.NoError(t, err)
+	assert.Equal(t, "abc", hash)
+}
+
+func TestRelocatePaths(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	main := insertTestFile(t, s, "/ci/work/repo/cmd/main.go", "go")
+	util := insertTestFile(t, s, "/ci/work/repo/util.go", "go")
+	sibling := insertTestFile(t, s, "/ci/work/repo2/other.go", "go")
+
+	n, err := s.RelocatePaths("/ci/work/repo/", "/home/dev/src/repo")
+	require.NoError(t, err)
+	assert.Equal(t, 2, n)
+
+	paths, err := s.AllFiles()
+	require.NoError(t, err)
+	assert.Equal(t, map[int64]string{
+		main.ID:    "/home/dev/src/repo/cmd/main.go",
+		util.ID:    "/home/dev/src/repo/util.go",
+		sibling.ID: "/ci/work/repo2/other.go",
+	}, paths, "only files under the directory move")
+
+	n, err = s.RelocatePaths("/home/dev/src/repo", "/home/dev/src/repo")
+	require.NoError(t, err)
+	assert.Zero(t, n)
+}
+
+func TestRelocatePaths_IntoItself(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	// Moving /repo to /repo/sub puts a.go where sub/a.go is now.
+	top := insertTestFile(t, s, "/repo/a.go", "go")
+	nested := insertTestFile(t, s, "/repo/sub/a.go", "go")
+	deeper := insertTestFile(t, s, "/repo/sub/sub/a.go", "go")
+
+	n, err := s.RelocatePaths("/repo", "/repo/sub")
+	require.NoError(t, err)
+	assert.Equal(t, 3, n)
+	paths, err := s.AllFiles()
+	require.NoError(t, err)
+	assert.Equal(t, map[int64]string{
+		top.ID:    "/repo/sub/a.go",
+		nested.ID: "/repo/sub/sub/a.go",
+		deeper.ID: "/repo/sub/sub/sub/a.go",
+	}, paths)
+
+	// And back out again.
+	n, err = s.RelocatePaths("/repo/sub", "/repo")
+	require.NoError(t, err)
+	assert.Equal(t, 3, n)
+	paths, err = s.AllFiles()
+	require.NoError(t, err)
+	assert.Equal(t, "/repo/a.go", paths[top.ID])
+}
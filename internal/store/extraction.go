@@ -2,15 +2,25 @@ package store
 
 import (
 	"database/sql"
+	"encoding/binary"
 	"fmt"
+	"time"
 )
 
 // --- File operations ---
 
+// fileCols is the column list scanned by scanFile. The stat columns are
+// NULL for rows written before they were added.
+const fileCols = "id, path, language, hash, line_count, last_indexed, COALESCE(size, 0), COALESCE(mtime, 0), COALESCE(inode, 0)"
+
+func scanFile(scanner interface{ Scan(...any) error }, f *File) error {
+	return scanner.Scan(&f.ID, &f.Path, &f.Language, &f.Hash, &f.LineCount, &f.LastIndexed, &f.Size, &f.ModTime, &f.Inode)
+}
+
 func (s *Store) InsertFile(f *File) (int64, error) {
 	res, err := s.db.Exec(
-		"INSERT INTO files (path, language, hash, line_count, last_indexed) VALUES (?, ?, ?, ?, ?)",
-		f.Path, f.Language, f.Hash, f.LineCount, f.LastIndexed,
+		"INSERT INTO files (path, language, hash, line_count, last_indexed, size, mtime, inode, line_lengths) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)",
+		f.Path, f.Language, f.Hash, f.LineCount, f.LastIndexed, f.Size, f.ModTime, f.Inode, encodeLineLengths(f.LineLengths),
 	)
 	if err != nil {
 		return 0, fmt.Errorf("insert file: %w", err)
@@ -23,11 +33,80 @@ func (s *Store) InsertFile(f *File) (int64, error) {
 	return id, nil
 }
 
+// encodeLineLengths packs lengths as fixed-width little-endian uint32s, so a
+// single line's length can be read with substr() without decoding the
+// rest. Returns nil (stored as NULL) when lengths is nil.
+func encodeLineLengths(lengths []uint32) []byte {
+	if lengths == nil {
+		return nil
+	}
+	buf := make([]byte, 4*len(lengths))
+	for i, n := range lengths {
+		binary.LittleEndian.PutUint32(buf[4*i:], n)
+	}
+	return buf
+}
+
+// LineLength returns the byte length of 0-based line in the file, as
+// recorded at index time, or -1 if the file has no such line. known is
+// false when the file row predates line length tracking.
+func (s *Store) LineLength(fileID int64, line int) (length int, known bool, err error) {
+	var total sql.NullInt64
+	var entry []byte
+	err = s.rdb.QueryRow(
+		"SELECT length(line_lengths), substr(line_lengths, ?, 4) FROM files WHERE id = ?",
+		4*line+1, fileID,
+	).Scan(&total, &entry)
+	if err == sql.ErrNoRows || (err == nil && !total.Valid) {
+		return 0, false, nil
+	}
+	if err != nil {
+		return 0, false, fmt.Errorf("line length: %w", err)
+	}
+	if line < 0 || len(entry) != 4 {
+		return -1, true, nil
+	}
+	return int(binary.LittleEndian.Uint32(entry)), true, nil
+}
+
+// UpdateFileStat records a new stat tuple for a file whose content hash is
+// unchanged (e.g. after a touch), so the next run can take the stat fast path.
+// last_indexed is bumped to checkedAt since the content was just verified.
+func (s *Store) UpdateFileStat(fileID, size, modTime, inode int64, checkedAt time.Time) error {
+	return s.UpdateFileStats([]FileStat{{FileID: fileID, Size: size, ModTime: modTime, Inode: inode}}, checkedAt)
+}
+
+// UpdateFileStats is UpdateFileStat for many files in one transaction, as
+// after a checkout or touch that moved the stat tuples of many unchanged
+// files.
+func (s *Store) UpdateFileStats(stats []FileStat, checkedAt time.Time) error {
+	if len(stats) == 0 {
+		return nil
+	}
+	tx, err := s.db.Begin()
+	if err != nil {
+		return fmt.Errorf("update file stats: begin: %w", err)
+	}
+	defer tx.Rollback()
+	stmt, err := tx.Prepare("UPDATE files SET size = ?, mtime = ?, inode = ?, last_indexed = ? WHERE id = ?")
+	if err != nil {
+		return fmt.Errorf("update file stats: %w", err)
+	}
+	defer stmt.Close()
+	for _, st := range stats {
+		if _, err := stmt.Exec(st.Size, st.ModTime, st.Inode, checkedAt, st.FileID); err != nil {
+			return fmt.Errorf("update file stats: %w", err)
+		}
+	}
+	if err := tx.Commit(); err != nil {
+		return fmt.Errorf("update file stats: commit: %w", err)
+	}
+	return nil
+}
+
 func (s *Store) FileByPath(path string) (*File, error) {
 	f := &File{}
-	err := s.db.QueryRow(
-		"SELECT id, path, language, hash, line_count, last_indexed FROM files WHERE path = ?", path,
-	).Scan(&f.ID, &f.Path, &f.Language, &f.Hash, &f.LineCount, &f.LastIndexed)
+	err := scanFile(s.rdb.QueryRow("SELECT "+fileCols+" FROM files WHERE path = ?", path), f)
 	if err == sql.ErrNoRows {
 		return nil, nil
 	}
@@ -38,9 +117,7 @@ func (s *Store) FileByPath(path string) (*File, error) {
 }
 
 func (s *Store) FilesByLanguage(language string) ([]*File, error) {
-	rows, err := s.db.Query(
-		"SELECT id, path, language, hash, line_count, last_indexed FROM files WHERE language = ?", language,
-	)
+	rows, err := s.rdb.Query("SELECT "+fileCols+" FROM files WHERE language = ?", language)
 	if err != nil {
 		return nil, fmt.Errorf("files by language: %w", err)
 	}
@@ -48,7 +125,7 @@ func (s *Store) FilesByLanguage(language string) ([]*File, error) {
 	var files []*File
 	for rows.Next() {
 		f := &File{}
-		if err := rows.Scan(&f.ID, &f.Path, &f.Language, &f.Hash, &f.LineCount, &f.LastIndexed); err != nil {
+		if err := scanFile(rows, f); err != nil {
 			return nil, fmt.Errorf("scan file: %w", err)
 		}
 		files = append(files, f)
@@ -56,9 +133,31 @@ func (s *Store) FilesByLanguage(language string) ([]*File, error) {
 	return files, rows.Err()
 }
 
+// FilesByHash returns the IDs of the files of language whose content has
+// the given hash, in ID order.
+func (s *Store) FilesByHash(language, hash string) ([]int64, error) {
+	rows, err := s.rdb.Query("SELECT id FROM files WHERE hash = ? AND language = ? ORDER BY id", hash, language)
+	if err != nil {
+		return nil, fmt.Errorf("files by hash: %w", err)
+	}
+	defer rows.Close()
+	var ids []int64
+	for rows.Next() {
+		var id int64
+		if err := rows.Scan(&id); err != nil {
+			return nil, fmt.Errorf("files by hash: %w", err)
+		}
+		ids = append(ids, id)
+	}
+	if err := rows.Err(); err != nil {
+		return nil, fmt.Errorf("files by hash: %w", err)
+	}
+	return ids, nil
+}
+
 // AllFiles returns a map of file ID to file path for bulk resolution.
 func (s *Store) AllFiles() (map[int64]string, error) {
-	rows, err := s.db.Query("SELECT id, path FROM files")
+	rows, err := s.rdb.Query("SELECT id, path FROM files")
 	if err != nil {
 		return nil, fmt.Errorf("all files: %w", err)
 	}
@@ -75,6 +174,34 @@ func (s *Store) AllFiles() (map[int64]string, error) {
 	return result, rows.Err()
 }
 
+// FilePathsByIDs returns a map of file ID to path for the given IDs.
+// Missing IDs are absent from the map.
+func (s *Store) FilePathsByIDs(ids []int64) (map[int64]string, error) {
+	result := make(map[int64]string, len(ids))
+	for start := 0; start < len(ids); start += 500 {
+		chunk := ids[start:min(start+500, len(ids))]
+		rows, err := s.rdb.Query("SELECT id, path FROM files WHERE id IN ("+placeholderList(len(chunk))+")", int64sToArgs(chunk)...)
+		if err != nil {
+			return nil, fmt.Errorf("file paths by ids: %w", err)
+		}
+		for rows.Next() {
+			var id int64
+			var path string
+			if err := rows.Scan(&id, &path); err != nil {
+				rows.Close()
+				return nil, fmt.Errorf("file paths by ids: scan: %w", err)
+			}
+			result[id] = path
+		}
+		err = rows.Err()
+		rows.Close()
+		if err != nil {
+			return nil, fmt.Errorf("file paths by ids: %w", err)
+		}
+	}
+	return result, nil
+}
+
 // --- Symbol operations ---
 
 func (s *Store) InsertSymbol(sym *Symbol) (int64, error) {
@@ -93,6 +220,9 @@ func (s *Store) InsertSymbol(sym *Symbol) (int64, error) {
 	if err != nil {
 		return 0, fmt.Errorf("last insert id: %w", err)
 	}
+	if err := s.insertSymbolTrigrams(id, sym.Name); err != nil {
+		return 0, fmt.Errorf("insert symbol trigrams: %w", err)
+	}
 	sym.ID = id
 	return id, nil
 }
@@ -122,7 +252,7 @@ const SymbolCols = `id, file_id, name, kind, visibility, modifiers, signature_ha
 	start_line, start_col, end_line, end_col, parent_symbol_id`
 
 func (s *Store) querySymbols(query string, args ...any) ([]*Symbol, error) {
-	rows, err := s.db.Query(query, args...)
+	rows, err := s.rdb.Query(query, args...)
 	if err != nil {
 		return nil, err
 	}
@@ -140,7 +270,7 @@ func (s *Store) querySymbols(query string, args ...any) ([]*Symbol, error) {
 
 // SymbolByID returns a single symbol by ID. Returns nil, nil for sql.ErrNoRows.
 func (s *Store) SymbolByID(id int64) (*Symbol, error) {
-	row := s.db.QueryRow("SELECT "+SymbolCols+" FROM symbols WHERE id = ?", id)
+	row := s.rdb.QueryRow("SELECT "+SymbolCols+" FROM symbols WHERE id = ?", id)
 	sym, err := s.scanSymbol(row)
 	if err == sql.ErrNoRows {
 		return nil, nil
@@ -198,7 +328,7 @@ func (s *Store) scanScope(scanner interface{ Scan(...any) error }) (*Scope, erro
 const scopeCols = `id, file_id, symbol_id, kind, start_line, start_col, end_line, end_col, parent_scope_id`
 
 func (s *Store) ScopesByFile(fileID int64) ([]*Scope, error) {
-	rows, err := s.db.Query("SELECT "+scopeCols+" FROM scopes WHERE file_id = ?", fileID)
+	rows, err := s.rdb.Query("SELECT "+scopeCols+" FROM scopes WHERE file_id = ?", fileID)
 	if err != nil {
 		return nil, fmt.Errorf("scopes by file: %w", err)
 	}
@@ -220,7 +350,7 @@ func (s *Store) ScopeChain(scopeID int64) ([]*Scope, error) {
 	currentID := &scopeID
 	for currentID != nil {
 		sc := &Scope{}
-		err := s.db.QueryRow("SELECT "+scopeCols+" FROM scopes WHERE id = ?", *currentID).Scan(
+		err := s.rdb.QueryRow("SELECT "+scopeCols+" FROM scopes WHERE id = ?", *currentID).Scan(
 			&sc.ID, &sc.FileID, &sc.SymbolID, &sc.Kind,
 			&sc.StartLine, &sc.StartCol, &sc.EndLine, &sc.EndCol, &sc.ParentScopeID,
 		)
@@ -240,14 +370,14 @@ func (s *Store) ScopeChain(scopeID int64) ([]*Scope, error) {
 // Uses span-size ordering (smallest first) to pick the most specific scope.
 // Returns nil with no error if no scope contains the position.
 func (s *Store) ScopeAt(fileID int64, line, col int) (*Scope, error) {
-	row := s.db.QueryRow(
+	row := s.rdb.QueryRow(
 		`SELECT `+scopeCols+` FROM scopes
-		 WHERE file_id = ?
+		 WHERE file_id = ? AND start_line <= ? AND end_line >= ?
 		   AND (start_line < ? OR (start_line = ? AND start_col <= ?))
 		   AND (end_line > ? OR (end_line = ? AND end_col >= ?))
 		 ORDER BY (end_line - start_line) ASC, (end_col - start_col) ASC
 		 LIMIT 1`,
-		fileID,
+		fileID, line, line,
 		line, line, col,
 		line, line, col,
 	)
@@ -283,50 +413,158 @@ func (s *Store) InsertReference(ref *Reference) (int64, error) {
 
 func (s *Store) scanReference(scanner interface{ Scan(...any) error }) (*Reference, error) {
 	r := &Reference{}
-	return r, scanner.Scan(
+	var startLine, startCol, endLine, endCol sql.NullInt64
+	var context sql.NullString
+	if err := scanner.Scan(
 		&r.ID, &r.FileID, &r.ScopeID, &r.Name,
-		&r.StartLine, &r.StartCol, &r.EndLine, &r.EndCol, &r.Context,
-	)
+		&startLine, &startCol, &endLine, &endCol, &context,
+	); err != nil {
+		return r, err
+	}
+	// A slim row of a compacted file has no position; queryReferences
+	// fills it in from the file's reference block.
+	r.packed = !startLine.Valid
+	r.StartLine, r.StartCol = int(startLine.Int64), int(startCol.Int64)
+	r.EndLine, r.EndCol = int(endLine.Int64), int(endCol.Int64)
+	r.Context = context.String
+	return r, nil
 }
 
 const refCols = `id, file_id, scope_id, name, start_line, start_col, end_line, end_col, context`
 
+// queryReferences runs query, which selects refCols, and unpacks the
+// compacted references it returns. Rows and blocks are read in one
+// transaction, so a concurrent re-index can't re-pack a file in between.
 func (s *Store) queryReferences(query string, args ...any) ([]*Reference, error) {
-	rows, err := s.db.Query(query, args...)
+	tx, err := s.rdb.Begin()
+	if err != nil {
+		return nil, err
+	}
+	defer tx.Rollback()
+	rows, err := tx.Query(query, args...)
 	if err != nil {
 		return nil, err
 	}
-	defer rows.Close()
 	var refs []*Reference
 	for rows.Next() {
 		r, err := s.scanReference(rows)
 		if err != nil {
+			rows.Close()
 			return nil, fmt.Errorf("scan reference: %w", err)
 		}
 		refs = append(refs, r)
 	}
-	return refs, rows.Err()
+	rows.Close()
+	if err := rows.Err(); err != nil {
+		return nil, err
+	}
+	if err := unpackReferences(tx, refs); err != nil {
+		return nil, err
+	}
+	return refs, nil
 }
 
 func (s *Store) ReferencesByFile(fileID int64) ([]*Reference, error) {
 	return s.queryReferences("SELECT "+refCols+" FROM references_ WHERE file_id = ?", fileID)
 }
 
+// ReferencesByName returns the references named name. Names in reference
+// blocks are not indexed, so with compacted files this decodes every block.
 func (s *Store) ReferencesByName(name string) ([]*Reference, error) {
-	return s.queryReferences("SELECT "+refCols+" FROM references_ WHERE name = ?", name)
+	refs, err := s.queryReferences("SELECT "+refCols+" FROM references_ WHERE name = ? AND start_line IS NOT NULL", name)
+	if err != nil {
+		return nil, err
+	}
+	return s.blockReferences(refs, "SELECT file_id FROM reference_blocks", nil, func(r *Reference) bool {
+		return r.Name == name
+	})
 }
 
 func (s *Store) ReferencesInScope(scopeID int64) ([]*Reference, error) {
-	return s.queryReferences("SELECT "+refCols+" FROM references_ WHERE scope_id = ?", scopeID)
+	refs, err := s.queryReferences("SELECT "+refCols+" FROM references_ WHERE scope_id = ?", scopeID)
+	if err != nil {
+		return nil, err
+	}
+	return s.blockReferences(refs,
+		"SELECT b.file_id FROM reference_blocks b JOIN scopes sc ON sc.file_id = b.file_id WHERE sc.id = ?",
+		[]any{scopeID}, func(r *Reference) bool {
+			return r.ScopeID != nil && *r.ScopeID == scopeID
+		})
+}
+
+// blockReferences appends to refs the references matching keep in the
+// blocks of the files fileQuery selects.
+func (s *Store) blockReferences(refs []*Reference, fileQuery string, args []any, keep func(*Reference) bool) ([]*Reference, error) {
+	var fileIDs []int64
+	err := s.scanRows(fileQuery, args, func(rows *sql.Rows) error {
+		var fid int64
+		if err := rows.Scan(&fid); err != nil {
+			return err
+		}
+		fileIDs = append(fileIDs, fid)
+		return nil
+	})
+	if err != nil {
+		return nil, fmt.Errorf("reference blocks: %w", err)
+	}
+	for _, fid := range fileIDs {
+		b, err := LoadReferenceBlock(s.rdb, fid)
+		if err != nil {
+			return nil, err
+		}
+		if b == nil {
+			continue
+		}
+		for i := range b.refs {
+			if keep(&b.refs[i]) {
+				r := b.refs[i]
+				refs = append(refs, &r)
+			}
+		}
+	}
+	return refs, nil
+}
+
+// ReferenceCountsByFile returns the number of references extracted from
+// each of fileIDs that has any, counted off the file span index blastChunk
+// files at a time.
+func (s *Store) ReferenceCountsByFile(fileIDs []int64) (map[int64]int, error) {
+	counts := make(map[int64]int)
+	for start := 0; start < len(fileIDs); start += blastChunk {
+		part := fileIDs[start:min(start+blastChunk, len(fileIDs))]
+		if err := s.countReferences(counts, part); err != nil {
+			return nil, fmt.Errorf("reference counts: %w", err)
+		}
+	}
+	return counts, nil
+}
+
+// countReferences adds the reference counts of fileIDs to counts.
+func (s *Store) countReferences(counts map[int64]int, fileIDs []int64) error {
+	rows, err := s.rdb.Query("SELECT file_id, COUNT(*) FROM references_ WHERE file_id IN ("+
+		placeholderList(len(fileIDs))+") GROUP BY file_id", int64sToArgs(fileIDs)...)
+	if err != nil {
+		return err
+	}
+	defer rows.Close()
+	for rows.Next() {
+		var fileID int64
+		var n int
+		if err := rows.Scan(&fileID, &n); err != nil {
+			return err
+		}
+		counts[fileID] = n
+	}
+	return rows.Err()
 }
 
 // --- Import operations ---
 
 func (s *Store) InsertImport(imp *Import) (int64, error) {
 	res, err := s.db.Exec(
-		`INSERT INTO imports (file_id, source, imported_name, local_alias, kind, scope)
-		 VALUES (?, ?, ?, ?, ?, ?)`,
-		imp.FileID, imp.Source, imp.ImportedName, imp.LocalAlias, imp.Kind, imp.Scope,
+		`INSERT INTO imports (file_id, source, imported_name, local_alias, kind, scope, source_segment)
+		 VALUES (?, ?, ?, ?, ?, ?, ?)`,
+		imp.FileID, imp.Source, imp.ImportedName, imp.LocalAlias, imp.Kind, imp.Scope, lastSegment(imp.Source),
 	)
 	if err != nil {
 		return 0, fmt.Errorf("insert import: %w", err)
@@ -339,20 +577,24 @@ func (s *Store) InsertImport(imp *Import) (int64, error) {
 	return id, nil
 }
 
+const importCols = "id, file_id, source, imported_name, local_alias, kind, scope"
+
+func scanImport(scanner interface{ Scan(...any) error }) (*Import, error) {
+	imp := &Import{}
+	return imp, scanner.Scan(&imp.ID, &imp.FileID, &imp.Source, &imp.ImportedName,
+		&imp.LocalAlias, &imp.Kind, &imp.Scope)
+}
+
 func (s *Store) ImportsByFile(fileID int64) ([]*Import, error) {
-	rows, err := s.db.Query(
-		"SELECT id, file_id, source, imported_name, local_alias, kind, scope FROM imports WHERE file_id = ?",
-		fileID,
-	)
+	rows, err := s.rdb.Query("SELECT "+importCols+" FROM imports WHERE file_id = ?", fileID)
 	if err != nil {
 		return nil, fmt.Errorf("imports by file: %w", err)
 	}
 	defer rows.Close()
 	var imports []*Import
 	for rows.Next() {
-		imp := &Import{}
-		if err := rows.Scan(&imp.ID, &imp.FileID, &imp.Source, &imp.ImportedName,
-			&imp.LocalAlias, &imp.Kind, &imp.Scope); err != nil {
+		imp, err := scanImport(rows)
+		if err != nil {
 			return nil, fmt.Errorf("scan import: %w", err)
 		}
 		imports = append(imports, imp)
@@ -362,7 +604,7 @@ func (s *Store) ImportsByFile(fileID int64) ([]*Import, error) {
 
 // AllImports returns all imports across all files.
 func (s *Store) AllImports() ([]*Import, error) {
-	rows, err := s.db.Query(
+	rows, err := s.rdb.Query(
 		"SELECT id, file_id, source, imported_name, local_alias, kind, scope FROM imports",
 	)
 	if err != nil {
@@ -401,7 +643,7 @@ func (s *Store) InsertTypeMember(tm *TypeMember) (int64, error) {
 }
 
 func (s *Store) TypeMembers(symbolID int64) ([]*TypeMember, error) {
-	rows, err := s.db.Query(
+	rows, err := s.rdb.Query(
 		"SELECT id, symbol_id, name, kind, type_expr, visibility FROM type_members WHERE symbol_id = ?",
 		symbolID,
 	)
@@ -441,7 +683,7 @@ func (s *Store) InsertFunctionParam(fp *FunctionParam) (int64, error) {
 }
 
 func (s *Store) FunctionParams(symbolID int64) ([]*FunctionParam, error) {
-	rows, err := s.db.Query(
+	rows, err := s.rdb.Query(
 		`SELECT id, symbol_id, name, ordinal, type_expr, is_receiver, is_return, has_default, default_expr
 		 FROM function_parameters WHERE symbol_id = ? ORDER BY ordinal`,
 		symbolID,
@@ -482,7 +724,7 @@ func (s *Store) InsertTypeParam(tp *TypeParam) (int64, error) {
 }
 
 func (s *Store) TypeParams(symbolID int64) ([]*TypeParam, error) {
-	rows, err := s.db.Query(
+	rows, err := s.rdb.Query(
 		`SELECT id, symbol_id, name, ordinal, variance, param_kind, constraints
 		 FROM type_parameters WHERE symbol_id = ? ORDER BY ordinal`,
 		symbolID,
@@ -524,7 +766,7 @@ func (s *Store) InsertAnnotation(ann *Annotation) (int64, error) {
 }
 
 func (s *Store) AnnotationsByTarget(symbolID int64) ([]*Annotation, error) {
-	rows, err := s.db.Query(
+	rows, err := s.rdb.Query(
 		`SELECT id, target_symbol_id, name, resolved_symbol_id, arguments, file_id, line, col
 		 FROM annotations WHERE target_symbol_id = ?`,
 		symbolID,
@@ -577,7 +819,7 @@ func (s *Store) InsertSymbolFragment(frag *SymbolFragment) (int64, error) {
 }
 
 func (s *Store) SymbolFragments(symbolID int64) ([]*SymbolFragment, error) {
-	rows, err := s.db.Query(
+	rows, err := s.rdb.Query(
 		`SELECT id, symbol_id, file_id, start_line, start_col, end_line, end_col, is_primary
 		 FROM symbol_fragments WHERE symbol_id = ?`,
 		symbolID,
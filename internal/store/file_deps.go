@@ -0,0 +1,203 @@
+package store
+
+import (
+	"database/sql"
+	"fmt"
+	"slices"
+	"strconv"
+	"time"
+)
+
+// file_dependencies records, for every file, the files its resolution
+// depends on: the files declaring a symbol it has a resolved reference to
+// or re-exports, and the files of each package it imports. Resolve
+// rewrites the edges of the files it re-resolved (RefreshFileDependencies),
+// and the whole table is read into a FileGraph so the blast radius of a
+// change batch is one in-memory traversal.
+//
+// Deleting a file drops its outgoing edges but keeps the edges into it:
+// those are what finds the dependents of a file that is deleted and
+// re-inserted under a new ID, after its resolution data is gone. They are
+// dropped once the dependents are re-resolved and refreshed.
+const fileDependenciesDDL = `
+CREATE TABLE IF NOT EXISTS file_dependencies (
+  file_id     INTEGER NOT NULL,
+  dep_file_id INTEGER NOT NULL,
+  PRIMARY KEY (file_id, dep_file_id)
+) WITHOUT ROWID;
+
+CREATE INDEX IF NOT EXISTS idx_file_dependencies_dep ON file_dependencies(dep_file_id, file_id);
+`
+
+// fileDependenciesKey is the metadata entry holding the stamp of the last
+// file_dependencies write; it is empty until the table has been built.
+const fileDependenciesKey = "file_dependencies"
+
+const (
+	depStagingDDL = `
+CREATE TEMP TABLE IF NOT EXISTS dep_files (id INTEGER PRIMARY KEY);
+DELETE FROM dep_files;
+`
+	depFiles = "(SELECT id FROM dep_files)"
+)
+
+// fileDependencySources insert the edges of the staged files, one query per
+// kind of dependency. Imports go through the package graph, so
+// RefreshPackageGraph must run first.
+var fileDependencySources = []string{
+	`INSERT OR IGNORE INTO file_dependencies (file_id, dep_file_id)
+	 SELECT r.file_id, s.file_id FROM references_ r
+	 JOIN resolved_references rr ON rr.reference_id = r.id
+	 JOIN symbols s ON s.id = rr.target_symbol_id
+	 WHERE r.file_id IN ` + depFiles + ` AND s.file_id IS NOT NULL AND s.file_id != r.file_id`,
+	`INSERT OR IGNORE INTO file_dependencies (file_id, dep_file_id)
+	 SELECT x.file_id, s.file_id FROM reexports x
+	 JOIN symbols s ON s.id = x.original_symbol_id
+	 WHERE x.file_id IN ` + depFiles + ` AND s.file_id IS NOT NULL AND s.file_id != x.file_id`,
+	`INSERT OR IGNORE INTO file_dependencies (file_id, dep_file_id)
+	 SELECT e.file_id, fp.file_id FROM file_package_edges e
+	 JOIN file_packages fp ON fp.package = e.to_package
+	 WHERE e.file_id IN ` + depFiles + ` AND fp.file_id != e.file_id`,
+}
+
+// RefreshFileDependencies recomputes the outgoing edges of the given files
+// from their current resolution data and imports. A nil slice recomputes
+// every file's edges; an empty one is a no-op.
+func (s *Store) RefreshFileDependencies(fileIDs []int64) error {
+	if fileIDs != nil && len(fileIDs) == 0 {
+		return nil
+	}
+	return s.writeFileDependencies(fileIDs, fileIDs == nil)
+}
+
+// rebuildFileDependencies recomputes file_dependencies from scratch and
+// marks it built.
+func (s *Store) rebuildFileDependencies() error {
+	return s.writeFileDependencies(nil, true)
+}
+
+func (s *Store) writeFileDependencies(fileIDs []int64, full bool) error {
+	tx, err := s.db.Begin()
+	if err != nil {
+		return fmt.Errorf("file dependencies: begin: %w", err)
+	}
+	defer tx.Rollback()
+
+	if _, err := tx.Exec(depStagingDDL); err != nil {
+		return fmt.Errorf("file dependencies: stage: %w", err)
+	}
+	reset := []string{"INSERT INTO dep_files (id) SELECT id FROM files", "DELETE FROM file_dependencies"}
+	if !full {
+		if err := execChunked(tx, "INSERT OR IGNORE INTO dep_files (id) VALUES %s", "(?)", fileIDs); err != nil {
+			return fmt.Errorf("file dependencies: stage: %w", err)
+		}
+		reset = []string{"DELETE FROM file_dependencies WHERE file_id IN " + depFiles}
+	}
+	for _, q := range append(reset, fileDependencySources...) {
+		if _, err := tx.Exec(q); err != nil {
+			return fmt.Errorf("file dependencies: %w", err)
+		}
+	}
+	stamp := strconv.FormatInt(time.Now().UnixNano(), 10)
+	for _, q := range []struct {
+		sql  string
+		args []any
+	}{
+		{"DELETE FROM dep_files", nil},
+		{"INSERT OR REPLACE INTO metadata (key, value) VALUES (?, ?)", []any{fileDependenciesKey, stamp}},
+	} {
+		if _, err := tx.Exec(q.sql, q.args...); err != nil {
+			return fmt.Errorf("file dependencies: finish: %w", err)
+		}
+	}
+	return tx.Commit()
+}
+
+// FileGraph is an in-memory snapshot of file_dependencies, indexed by
+// dependency so it walks from changed files to the files depending on
+// them. The dependents of deps[i] are dependents[offsets[i]:offsets[i+1]].
+type FileGraph struct {
+	deps       []int64
+	offsets    []int32
+	dependents []int64
+}
+
+// FileGraph returns a snapshot of the current file dependency graph. The
+// snapshot is loaded on first use and reused until file_dependencies is
+// next refreshed; deletions in between leave it unchanged, so it may still
+// list files deleted since.
+func (s *Store) FileGraph() (*FileGraph, error) {
+	stamp, err := s.GetMetadata(fileDependenciesKey)
+	if err != nil {
+		return nil, fmt.Errorf("file graph: %w", err)
+	}
+	s.fgMu.Lock()
+	defer s.fgMu.Unlock()
+	if s.fg != nil && stamp != "" && s.fgStamp == stamp {
+		return s.fg, nil
+	}
+	g, err := loadFileGraph(s.rdb, "SELECT dep_file_id, file_id FROM file_dependencies ORDER BY dep_file_id, file_id")
+	if err != nil {
+		return nil, fmt.Errorf("file graph: %w", err)
+	}
+	s.fg, s.fgStamp = g, stamp
+	return g, nil
+}
+
+// loadFileGraph builds a FileGraph from query's (dependency, dependent)
+// rows, which must be ordered by dependency.
+func loadFileGraph(db *sql.DB, query string) (*FileGraph, error) {
+	rows, err := db.Query(query)
+	if err != nil {
+		return nil, err
+	}
+	defer rows.Close()
+	g := &FileGraph{}
+	for rows.Next() {
+		var dep, file int64
+		if err := rows.Scan(&dep, &file); err != nil {
+			return nil, fmt.Errorf("scan file dependency: %w", err)
+		}
+		if n := len(g.deps); n == 0 || g.deps[n-1] != dep {
+			g.deps = append(g.deps, dep)
+			g.offsets = append(g.offsets, int32(len(g.dependents)))
+		}
+		g.dependents = append(g.dependents, file)
+	}
+	if err := rows.Err(); err != nil {
+		return nil, err
+	}
+	g.offsets = append(g.offsets, int32(len(g.dependents)))
+	return g, nil
+}
+
+// Dependents returns the files that depend on any of seeds within depth
+// hops, sorted by ID. Seeds are only included when another seed reaches
+// them. depth <= 0 returns nil.
+func (g *FileGraph) Dependents(seeds []int64, depth int) []int64 {
+	if depth <= 0 || len(g.deps) == 0 {
+		return nil
+	}
+	visited := make(map[int64]bool, len(seeds))
+	var out []int64
+	frontier := seeds
+	for hop := 0; hop < depth && len(frontier) > 0; hop++ {
+		var next []int64
+		for _, fid := range frontier {
+			i, ok := slices.BinarySearch(g.deps, fid)
+			if !ok {
+				continue
+			}
+			for _, dependent := range g.dependents[g.offsets[i]:g.offsets[i+1]] {
+				if !visited[dependent] {
+					visited[dependent] = true
+					out = append(out, dependent)
+					next = append(next, dependent)
+				}
+			}
+		}
+		frontier = next
+	}
+	slices.Sort(out)
+	return out
+}
@@ -0,0 +1,123 @@
+package store
+
+import (
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func fileDependencyPairs(t *testing.T, s *Store) [][2]int64 {
+	t.Helper()
+	rows, err := s.db.Query("SELECT file_id, dep_file_id FROM file_dependencies ORDER BY file_id, dep_file_id")
+	require.NoError(t, err)
+	defer rows.Close()
+	var out [][2]int64
+	for rows.Next() {
+		var e [2]int64
+		require.NoError(t, rows.Scan(&e[0], &e[1]))
+		out = append(out, e)
+	}
+	require.NoError(t, rows.Err())
+	return out
+}
+
+func insertResolvedRef(t *testing.T, s *Store, fileID, targetID int64) {
+	t.Helper()
+	ref := &Reference{FileID: fileID, Name: "ref", StartLine: 1, EndLine: 1, Context: "call"}
+	_, err := s.InsertReference(ref)
+	require.NoError(t, err)
+	_, err = s.InsertResolvedReference(&ResolvedReference{ReferenceID: ref.ID, TargetSymbolID: targetID, Confidence: 1, ResolutionKind: "direct"})
+	require.NoError(t, err)
+}
+
+func TestRefreshFileDependencies_Sources(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	lib := insertPackageFile(t, s, "/src/lib/lib.go", "lib")
+	helper := insertTestSymbol(t, s, &lib.ID, "Helper", "function")
+	user := insertPackageFile(t, s, "/src/app/user.go", "app")
+	insertResolvedRef(t, s, user.ID, helper.ID)
+	insertResolvedRef(t, s, user.ID, helper.ID)
+	index := insertPackageFile(t, s, "/src/app/index.go", "app")
+	_, err := s.InsertReexport(&Reexport{FileID: index.ID, OriginalSymbolID: helper.ID, ExportedName: "Helper"})
+	require.NoError(t, err)
+	importer := insertPackageFile(t, s, "/src/cmd/main.go", "main", "example.com/lib")
+
+	require.NoError(t, s.RefreshPackageGraph())
+	require.NoError(t, s.RefreshFileDependencies(nil))
+	assert.Equal(t, [][2]int64{
+		{user.ID, lib.ID},
+		{index.ID, lib.ID},
+		{importer.ID, lib.ID},
+	}, fileDependencyPairs(t, s))
+
+	// Refreshing a file rewrites only its edges.
+	_, err = s.db.Exec("DELETE FROM reexports")
+	require.NoError(t, err)
+	require.NoError(t, s.RefreshFileDependencies([]int64{index.ID}))
+	assert.Equal(t, [][2]int64{
+		{user.ID, lib.ID},
+		{importer.ID, lib.ID},
+	}, fileDependencyPairs(t, s))
+}
+
+func TestFileDependencies_DeleteKeepsIncomingEdges(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	lib := insertTestFile(t, s, "/lib.go", "go")
+	helper := insertTestSymbol(t, s, &lib.ID, "Helper", "function")
+	user := insertTestFile(t, s, "/user.go", "go")
+	insertResolvedRef(t, s, user.ID, helper.ID)
+	other := insertTestFile(t, s, "/other.go", "go")
+	userSym := insertTestSymbol(t, s, &user.ID, "Run", "function")
+	insertResolvedRef(t, s, other.ID, userSym.ID)
+	require.NoError(t, s.RefreshFileDependencies(nil))
+
+	// lib is deleted as if re-indexed: its dependents are still found.
+	require.NoError(t, s.DeleteFiles([]int64{lib.ID}))
+	g, err := s.FileGraph()
+	require.NoError(t, err)
+	assert.Equal(t, []int64{user.ID}, g.Dependents([]int64{lib.ID}, 1))
+
+	// Deleting user drops its outgoing edge; re-resolving other drops the
+	// edge into user.
+	require.NoError(t, s.DeleteFiles([]int64{user.ID}))
+	assert.Equal(t, [][2]int64{{other.ID, user.ID}}, fileDependencyPairs(t, s))
+	require.NoError(t, s.RefreshFileDependencies([]int64{other.ID}))
+	assert.Empty(t, fileDependencyPairs(t, s))
+}
+
+func TestFileGraph_Dependents(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	// d -> c -> b -> a, and e -> a.
+	var files []*File
+	for _, p := range []string{"/a.go", "/b.go", "/c.go", "/d.go", "/e.go"} {
+		files = append(files, insertTestFile(t, s, p, "go"))
+	}
+	a, b, c, d, e := files[0].ID, files[1].ID, files[2].ID, files[3].ID, files[4].ID
+	for _, edge := range [][2]int64{{b, a}, {c, b}, {d, c}, {e, a}} {
+		sym := insertTestSymbol(t, s, &edge[1], "S", "function")
+		insertResolvedRef(t, s, edge[0], sym.ID)
+	}
+	require.NoError(t, s.RefreshFileDependencies(nil))
+
+	g, err := s.FileGraph()
+	require.NoError(t, err)
+	assert.Equal(t, []int64{b, e}, g.Dependents([]int64{a}, 1))
+	assert.Equal(t, []int64{b, c, e}, g.Dependents([]int64{a}, 2))
+	assert.Equal(t, []int64{b, c, d, e}, g.Dependents([]int64{a}, 10))
+	assert.Equal(t, []int64{b, c, e}, g.Dependents([]int64{a, b}, 1), "seeds reached from other seeds count")
+	assert.Nil(t, g.Dependents([]int64{a}, 0))
+	assert.Empty(t, g.Dependents([]int64{d}, 3))
+
+	// The snapshot is reused until the table is refreshed.
+	again, err := s.FileGraph()
+	require.NoError(t, err)
+	assert.Same(t, g, again)
+	require.NoError(t, s.RefreshFileDependencies([]int64{e}))
+	again, err = s.FileGraph()
+	require.NoError(t, err)
+	assert.NotSame(t, g, again)
+}
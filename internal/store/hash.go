@@ -2,6 +2,7 @@ package store
 
 import (
 	"crypto/sha256"
+	"database/sql"
 	"fmt"
 	"sort"
 	"strings"
@@ -86,3 +87,125 @@ func ComputeSignatureHash(
 
 	return fmt.Sprintf("%x", h.Sum(nil))
 }
+
+// batchSignatureHashes returns the signature hash of each symbol buffered
+// in b, in buffer order, computed from the child rows buffered with it.
+// CommitBatch stores them with the symbols, so readers comparing
+// signatures load one column instead of three child tables per symbol.
+func batchSignatureHashes(b *BatchedStore) []string {
+	members := make(map[int64][]*TypeMember)
+	for i := range b.typeMembers {
+		tm := &b.typeMembers[i]
+		members[tm.SymbolID] = append(members[tm.SymbolID], tm)
+	}
+	params := make(map[int64][]*FunctionParam)
+	for i := range b.functionParams {
+		fp := &b.functionParams[i]
+		params[fp.SymbolID] = append(params[fp.SymbolID], fp)
+	}
+	typeParams := make(map[int64][]*TypeParam)
+	for i := range b.typeParams {
+		tp := &b.typeParams[i]
+		typeParams[tp.SymbolID] = append(typeParams[tp.SymbolID], tp)
+	}
+
+	syms, strs := &b.symbols, &b.strs
+	hashes := make([]string, syms.len())
+	for i, id := range syms.id {
+		hashes[i] = ComputeSignatureHash(
+			strs.str(syms.name[i]), strs.str(syms.kind[i]), strs.str(syms.visibility[i]),
+			unmarshalModifiers(strs.str(syms.modifiers[i])),
+			members[id], params[id], typeParams[id],
+		)
+	}
+	return hashes
+}
+
+// SignatureHashes computes the signature hash of every symbol of a file
+// from its stored rows: one query per table, whatever the symbol count.
+func (s *Store) SignatureHashes(fileID int64) (map[int64]string, error) {
+	syms, err := s.SymbolsByFile(fileID)
+	if err != nil {
+		return nil, fmt.Errorf("signature hashes: %w", err)
+	}
+	if len(syms) == 0 {
+		return map[int64]string{}, nil
+	}
+
+	const ofFile = " WHERE symbol_id IN (SELECT id FROM symbols WHERE file_id = ?) ORDER BY id"
+	members := make(map[int64][]*TypeMember)
+	err = s.scanRows("SELECT symbol_id, name, kind, type_expr, visibility FROM type_members"+ofFile,
+		[]any{fileID}, func(rows *sql.Rows) error {
+			tm := &TypeMember{}
+			if err := rows.Scan(&tm.SymbolID, &tm.Name, &tm.Kind, &tm.TypeExpr, &tm.Visibility); err != nil {
+				return err
+			}
+			members[tm.SymbolID] = append(members[tm.SymbolID], tm)
+			return nil
+		})
+	if err != nil {
+		return nil, fmt.Errorf("signature hashes: type members: %w", err)
+	}
+	params := make(map[int64][]*FunctionParam)
+	err = s.scanRows("SELECT symbol_id, name, ordinal, type_expr, is_receiver, is_return FROM function_parameters"+ofFile,
+		[]any{fileID}, func(rows *sql.Rows) error {
+			fp := &FunctionParam{}
+			if err := rows.Scan(&fp.SymbolID, &fp.Name, &fp.Ordinal, &fp.TypeExpr, &fp.IsReceiver, &fp.IsReturn); err != nil {
+				return err
+			}
+			params[fp.SymbolID] = append(params[fp.SymbolID], fp)
+			return nil
+		})
+	if err != nil {
+		return nil, fmt.Errorf("signature hashes: function params: %w", err)
+	}
+	typeParams := make(map[int64][]*TypeParam)
+	err = s.scanRows("SELECT symbol_id, name, ordinal, variance, param_kind, constraints FROM type_parameters"+ofFile,
+		[]any{fileID}, func(rows *sql.Rows) error {
+			tp := &TypeParam{}
+			if err := rows.Scan(&tp.SymbolID, &tp.Name, &tp.Ordinal, &tp.Variance, &tp.ParamKind, &tp.Constraints); err != nil {
+				return err
+			}
+			typeParams[tp.SymbolID] = append(typeParams[tp.SymbolID], tp)
+			return nil
+		})
+	if err != nil {
+		return nil, fmt.Errorf("signature hashes: type params: %w", err)
+	}
+
+	hashes := make(map[int64]string, len(syms))
+	for _, sym := range syms {
+		hashes[sym.ID] = ComputeSignatureHash(sym.Name, sym.Kind, sym.Visibility, sym.Modifiers,
+			members[sym.ID], params[sym.ID], typeParams[sym.ID])
+	}
+	return hashes, nil
+}
+
+// UpdateSignatureHashes stores the signature hashes of a file's symbols,
+// for rows written straight to SQLite rather than through CommitBatch,
+// which stores them as it inserts.
+func (s *Store) UpdateSignatureHashes(fileID int64) error {
+	hashes, err := s.SignatureHashes(fileID)
+	if err != nil {
+		return err
+	}
+	if len(hashes) == 0 {
+		return nil
+	}
+	tx, err := s.db.Begin()
+	if err != nil {
+		return fmt.Errorf("update signature hashes: begin: %w", err)
+	}
+	defer tx.Rollback()
+	stmt, err := tx.Prepare("UPDATE symbols SET signature_hash = ? WHERE id = ?")
+	if err != nil {
+		return fmt.Errorf("update signature hashes: %w", err)
+	}
+	defer stmt.Close()
+	for id, hash := range hashes {
+		if _, err := stmt.Exec(hash, id); err != nil {
+			return fmt.Errorf("update signature hashes: %w", err)
+		}
+	}
+	return tx.Commit()
+}
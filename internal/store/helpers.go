@@ -31,11 +31,6 @@ func repeatArgs(args []any, n int) []any {
 	return result
 }
 
-// countSubstring counts non-overlapping occurrences of substr in s.
-func countSubstring(s, substr string) int {
-	return strings.Count(s, substr)
-}
-
 // marshalModifiers converts []string to JSON text for storage.
 func marshalModifiers(mods []string) string {
 	if len(mods) == 0 {
@@ -0,0 +1,343 @@
+package store
+
+import (
+	"database/sql"
+	"fmt"
+	"path/filepath"
+	"strconv"
+	"strings"
+	"time"
+)
+
+// include_edges records the #include graph of C and C++ files: one edge
+// per included header the search resolved to an indexed file. An include
+// is looked up next to the including file, then in each include search
+// directory in order (see RefreshIncludeGraph), and finally by path suffix
+// among the indexed files, preferring the one sharing the longest
+// directory prefix with the includer. Includes of system or unindexed
+// headers have no edge.
+//
+// Triggers record the files whose includes changed and the C/C++ file
+// paths that appeared or disappeared; RefreshIncludeGraph redoes those
+// files and every file including a header by the basename of such a path.
+// As with file_dependencies, deleting a file drops only its outgoing
+// edges, so a header deleted and re-inserted under a new ID is still found
+// by its previous ID until its includers are refreshed.
+const includeGraphDDL = `
+CREATE TABLE IF NOT EXISTS include_edges (
+  file_id          INTEGER NOT NULL,
+  included_file_id INTEGER NOT NULL,
+  PRIMARY KEY (file_id, included_file_id)
+) WITHOUT ROWID;
+
+CREATE INDEX IF NOT EXISTS idx_include_edges_included ON include_edges(included_file_id, file_id);
+
+CREATE TABLE IF NOT EXISTS include_graph_dirty_files (
+  file_id INTEGER PRIMARY KEY
+);
+
+CREATE TABLE IF NOT EXISTS include_graph_dirty_paths (
+  path TEXT PRIMARY KEY
+) WITHOUT ROWID;
+
+CREATE TRIGGER IF NOT EXISTS trg_imports_insert_include_graph AFTER INSERT ON imports
+WHEN NEW.kind = 'header' BEGIN
+  INSERT OR IGNORE INTO include_graph_dirty_files (file_id) VALUES (NEW.file_id);
+END;
+CREATE TRIGGER IF NOT EXISTS trg_imports_delete_include_graph AFTER DELETE ON imports
+WHEN OLD.kind = 'header' BEGIN
+  INSERT OR IGNORE INTO include_graph_dirty_files (file_id) VALUES (OLD.file_id);
+END;
+CREATE TRIGGER IF NOT EXISTS trg_files_insert_include_graph AFTER INSERT ON files
+WHEN NEW.language IN ` + includeLanguages + ` BEGIN
+  INSERT OR IGNORE INTO include_graph_dirty_paths (path) VALUES (NEW.path);
+END;
+CREATE TRIGGER IF NOT EXISTS trg_files_delete_include_graph AFTER DELETE ON files
+WHEN OLD.language IN ` + includeLanguages + ` BEGIN
+  INSERT OR IGNORE INTO include_graph_dirty_paths (path) VALUES (OLD.path);
+END;
+`
+
+// includeLanguages are the languages whose "header" imports are #include
+// directives.
+const includeLanguages = "('c', 'cpp')"
+
+// includeGraphKey is the metadata entry holding the include search path the
+// edges were resolved with; it is empty until the table has been built.
+// includeEdgesKey holds the stamp of the last include_edges write.
+const (
+	includeGraphKey = "include_graph"
+	includeEdgesKey = "include_edges"
+)
+
+var (
+	includeEdgesTable = bulkTable{"include_edges", []string{"file_id", "included_file_id"}}
+	includeNamesTable = bulkTable{"include_names", []string{"name"}}
+)
+
+// includeNamesDDL stages the basenames of the dirty paths.
+const includeNamesDDL = `
+CREATE TEMP TABLE IF NOT EXISTS include_names (name TEXT PRIMARY KEY) WITHOUT ROWID;
+DELETE FROM include_names;
+`
+
+// includeGraphConfig is the includeGraphKey value for a search path.
+func includeGraphConfig(searchPath []string) string {
+	return "1\n" + strings.Join(searchPath, "\n")
+}
+
+// RefreshIncludeGraph brings include_edges up to date with the includes and
+// C/C++ files changed since the last refresh, resolving includes against
+// searchPath: the include directories in search order, as given by -I flags
+// (see canopy.WithIncludePaths). A search path different from the one the
+// edges were resolved with re-resolves every include. It is a no-op when
+// nothing changed.
+func (s *Store) RefreshIncludeGraph(searchPath []string) error {
+	config, err := s.GetMetadata(includeGraphKey)
+	if err != nil {
+		return fmt.Errorf("refresh include graph: %w", err)
+	}
+	if config != includeGraphConfig(searchPath) {
+		return s.writeIncludeGraph(searchPath, true)
+	}
+	var pending bool
+	err = s.rdb.QueryRow(`SELECT EXISTS (SELECT 1 FROM include_graph_dirty_files)
+		OR EXISTS (SELECT 1 FROM include_graph_dirty_paths)`).Scan(&pending)
+	if err != nil {
+		return fmt.Errorf("refresh include graph: %w", err)
+	}
+	if !pending {
+		return nil
+	}
+	return s.writeIncludeGraph(searchPath, false)
+}
+
+// rebuildIncludeGraph resolves every include from scratch, without search
+// directories, and marks the graph built.
+func (s *Store) rebuildIncludeGraph() error {
+	return s.writeIncludeGraph(nil, true)
+}
+
+func (s *Store) writeIncludeGraph(searchPath []string, full bool) error {
+	tx, err := s.db.Begin()
+	if err != nil {
+		return fmt.Errorf("include graph: begin: %w", err)
+	}
+	defer tx.Rollback()
+	w := newBatchWriter(tx)
+	defer w.close()
+
+	r, err := loadIncludeResolver(tx, searchPath)
+	if err != nil {
+		return fmt.Errorf("include graph: files: %w", err)
+	}
+
+	const dirty = "(SELECT file_id FROM include_graph_dirty_files)"
+	if full {
+		for _, q := range []string{
+			"DELETE FROM include_edges",
+			"INSERT OR IGNORE INTO include_graph_dirty_files (file_id) SELECT id FROM files WHERE language IN " + includeLanguages,
+		} {
+			if _, err := tx.Exec(q); err != nil {
+				return fmt.Errorf("include graph: reset: %w", err)
+			}
+		}
+	} else {
+		// Includes naming a header that appeared or disappeared may resolve
+		// differently now.
+		paths := make(map[string]bool)
+		if err := collectStrings(tx, paths, "SELECT path FROM include_graph_dirty_paths"); err != nil {
+			return fmt.Errorf("include graph: %w", err)
+		}
+		bases := make(map[string]bool, len(paths))
+		var names []any
+		for path := range paths {
+			if base := filepath.Base(path); !bases[base] {
+				bases[base] = true
+				names = append(names, base)
+			}
+		}
+		if _, err := tx.Exec(includeNamesDDL); err != nil {
+			return fmt.Errorf("include graph: stage: %w", err)
+		}
+		if err := w.insertRows(includeNamesTable, names); err != nil {
+			return fmt.Errorf("include graph: stage: %w", err)
+		}
+		_, err := tx.Exec(`INSERT OR IGNORE INTO include_graph_dirty_files (file_id)
+			SELECT DISTINCT file_id FROM imports
+			 WHERE kind = 'header' AND source_segment IN (SELECT name FROM include_names)`)
+		if err != nil {
+			return fmt.Errorf("include graph: %w", err)
+		}
+	}
+
+	if _, err := tx.Exec("DELETE FROM include_edges WHERE file_id IN " + dirty); err != nil {
+		return fmt.Errorf("include graph: %w", err)
+	}
+	rows, err := tx.Query(`SELECT i.file_id, f.path, i.source FROM imports i JOIN files f ON f.id = i.file_id
+		WHERE i.kind = 'header' AND i.file_id IN ` + dirty + ` ORDER BY i.file_id, i.id`)
+	if err != nil {
+		return fmt.Errorf("include graph: includes: %w", err)
+	}
+	var args []any
+	seen := make(map[[2]int64]bool)
+	for rows.Next() {
+		var fileID int64
+		var path, source string
+		if err := rows.Scan(&fileID, &path, &source); err != nil {
+			rows.Close()
+			return fmt.Errorf("include graph: scan include: %w", err)
+		}
+		target, ok := r.resolve(path, source)
+		if !ok || target == fileID || seen[[2]int64{fileID, target}] {
+			continue
+		}
+		seen[[2]int64{fileID, target}] = true
+		args = append(args, fileID, target)
+	}
+	rows.Close()
+	if err := rows.Err(); err != nil {
+		return fmt.Errorf("include graph: includes: %w", err)
+	}
+	if err := w.insertRows(includeEdgesTable, args); err != nil {
+		return fmt.Errorf("include graph: edges: %w", err)
+	}
+
+	stamp := strconv.FormatInt(time.Now().UnixNano(), 10)
+	for _, q := range []struct {
+		sql  string
+		args []any
+	}{
+		{"DELETE FROM include_graph_dirty_files", nil},
+		{"DELETE FROM include_graph_dirty_paths", nil},
+		{"INSERT OR REPLACE INTO metadata (key, value) VALUES (?, ?)", []any{includeGraphKey, includeGraphConfig(searchPath)}},
+		{"INSERT OR REPLACE INTO metadata (key, value) VALUES (?, ?)", []any{includeEdgesKey, stamp}},
+	} {
+		if _, err := tx.Exec(q.sql, q.args...); err != nil {
+			return fmt.Errorf("include graph: finish: %w", err)
+		}
+	}
+	return tx.Commit()
+}
+
+// includeResolver resolves include directives to the indexed C/C++ files.
+type includeResolver struct {
+	byPath     map[string]int64
+	byBase     map[string][]includeFile
+	searchPath []string
+}
+
+type includeFile struct {
+	id   int64
+	path string
+}
+
+func loadIncludeResolver(tx *sql.Tx, searchPath []string) (*includeResolver, error) {
+	rows, err := tx.Query("SELECT id, path FROM files WHERE language IN " + includeLanguages + " ORDER BY id")
+	if err != nil {
+		return nil, err
+	}
+	defer rows.Close()
+	r := &includeResolver{
+		byPath:     make(map[string]int64),
+		byBase:     make(map[string][]includeFile),
+		searchPath: searchPath,
+	}
+	for rows.Next() {
+		var f includeFile
+		if err := rows.Scan(&f.id, &f.path); err != nil {
+			return nil, err
+		}
+		r.byPath[f.path] = f.id
+		base := filepath.Base(f.path)
+		r.byBase[base] = append(r.byBase[base], f)
+	}
+	return r, rows.Err()
+}
+
+// resolve returns the file that an include of spec from the file at from
+// names: the first indexed file at spec relative to from's directory or to
+// a search directory, else the indexed file whose path ends in spec and
+// shares the longest directory prefix with from.
+func (r *includeResolver) resolve(from, spec string) (int64, bool) {
+	spec = filepath.Clean(spec)
+	if filepath.IsAbs(spec) {
+		id, ok := r.byPath[spec]
+		return id, ok
+	}
+	if id, ok := r.byPath[filepath.Join(filepath.Dir(from), spec)]; ok {
+		return id, true
+	}
+	for _, dir := range r.searchPath {
+		if id, ok := r.byPath[filepath.Join(dir, spec)]; ok {
+			return id, true
+		}
+	}
+
+	suffix := string(filepath.Separator) + spec
+	best, bestLen := int64(0), -1
+	for _, f := range r.byBase[filepath.Base(spec)] {
+		if f.path == from || !strings.HasSuffix(f.path, suffix) {
+			continue
+		}
+		// Candidates are in ID order, so ties go to the oldest file.
+		if n := commonDirPrefix(from, f.path); n > bestLen {
+			best, bestLen = f.id, n
+		}
+	}
+	return best, bestLen >= 0
+}
+
+// commonDirPrefix returns the number of leading directories a and b share.
+func commonDirPrefix(a, b string) int {
+	as := strings.Split(filepath.Dir(a), string(filepath.Separator))
+	bs := strings.Split(filepath.Dir(b), string(filepath.Separator))
+	n := 0
+	for n < len(as) && n < len(bs) && as[n] == bs[n] {
+		n++
+	}
+	return n
+}
+
+// IncludeGraph returns a snapshot of include_edges as a FileGraph whose
+// dependents are includers: IncludeGraph().Dependents(headers, depth)
+// walks from headers to the files including them. Like FileGraph, it is
+// reused until include_edges is next refreshed.
+func (s *Store) IncludeGraph() (*FileGraph, error) {
+	stamp, err := s.GetMetadata(includeEdgesKey)
+	if err != nil {
+		return nil, fmt.Errorf("include graph: %w", err)
+	}
+	s.fgMu.Lock()
+	defer s.fgMu.Unlock()
+	if s.ig != nil && stamp != "" && s.igStamp == stamp {
+		return s.ig, nil
+	}
+	g, err := loadFileGraph(s.rdb, "SELECT included_file_id, file_id FROM include_edges ORDER BY included_file_id, file_id")
+	if err != nil {
+		return nil, fmt.Errorf("include graph: %w", err)
+	}
+	s.ig, s.igStamp = g, stamp
+	return g, nil
+}
+
+// IncludedFiles returns the files fileID includes directly, sorted by ID.
+func (s *Store) IncludedFiles(fileID int64) ([]int64, error) {
+	rows, err := s.rdb.Query("SELECT included_file_id FROM include_edges WHERE file_id = ? ORDER BY included_file_id", fileID)
+	if err != nil {
+		return nil, fmt.Errorf("included files: %w", err)
+	}
+	defer rows.Close()
+	var ids []int64
+	for rows.Next() {
+		var id int64
+		if err := rows.Scan(&id); err != nil {
+			return nil, fmt.Errorf("included files: %w", err)
+		}
+		ids = append(ids, id)
+	}
+	if err := rows.Err(); err != nil {
+		return nil, fmt.Errorf("included files: %w", err)
+	}
+	return ids, nil
+}
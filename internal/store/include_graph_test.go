@@ -0,0 +1,84 @@
+package store
+
+import (
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func insertIncludingFile(t *testing.T, s *Store, path string, includes ...string) *File {
+	t.Helper()
+	f := insertTestFile(t, s, path, "c")
+	for _, inc := range includes {
+		_, err := s.InsertImport(&Import{FileID: f.ID, Source: inc, Kind: "header", Scope: "file"})
+		require.NoError(t, err)
+	}
+	return f
+}
+
+func includedFiles(t *testing.T, s *Store, fileID int64) []int64 {
+	t.Helper()
+	ids, err := s.IncludedFiles(fileID)
+	require.NoError(t, err)
+	return ids
+}
+
+func TestRefreshIncludeGraph_SearchOrder(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	local := insertIncludingFile(t, s, "/src/app/util.h")
+	inc := insertIncludingFile(t, s, "/src/include/util.h")
+	other := insertIncludingFile(t, s, "/src/include/other.h")
+	near := insertIncludingFile(t, s, "/src/lib/sub/deep.h")
+	insertIncludingFile(t, s, "/vendor/lib/sub/deep.h")
+	main := insertIncludingFile(t, s, "/src/app/main.c", "util.h", "other.h", "sub/deep.h", "stdio.h")
+
+	require.NoError(t, s.RefreshIncludeGraph([]string{"/src/include"}))
+	// util.h is found next to main.c before the search path; other.h only
+	// in it; sub/deep.h by suffix, nearest first; stdio.h is not indexed.
+	assert.Equal(t, []int64{local.ID, other.ID, near.ID}, includedFiles(t, s, main.ID))
+
+	// Without the search directory other.h is still found by suffix.
+	require.NoError(t, s.RefreshIncludeGraph(nil))
+	assert.Equal(t, []int64{local.ID, other.ID, near.ID}, includedFiles(t, s, main.ID))
+	assert.NotContains(t, includedFiles(t, s, main.ID), inc.ID)
+}
+
+func TestRefreshIncludeGraph_TracksChanges(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	types := insertIncludingFile(t, s, "/src/types.h")
+	api := insertIncludingFile(t, s, "/src/api.h", "types.h")
+	main := insertIncludingFile(t, s, "/src/main.c", "api.h", "config.h")
+	require.NoError(t, s.RefreshIncludeGraph(nil))
+	assert.Equal(t, []int64{api.ID}, includedFiles(t, s, main.ID))
+
+	g, err := s.IncludeGraph()
+	require.NoError(t, err)
+	assert.Equal(t, []int64{api.ID, main.ID}, g.Dependents([]int64{types.ID}, 1<<30),
+		"includers are found transitively")
+
+	// A header that appears resolves the includes already naming it.
+	config := insertIncludingFile(t, s, "/src/config.h")
+	require.NoError(t, s.RefreshIncludeGraph(nil))
+	assert.Equal(t, []int64{api.ID, config.ID}, includedFiles(t, s, main.ID))
+
+	// A header deleted and re-inserted keeps its includers' edges to the
+	// old ID until the refresh moves them to the new one.
+	require.NoError(t, s.DeleteFiles([]int64{types.ID}))
+	g, err = s.IncludeGraph()
+	require.NoError(t, err)
+	assert.Equal(t, []int64{api.ID, main.ID}, g.Dependents([]int64{types.ID}, 1<<30))
+	types2 := insertIncludingFile(t, s, "/src/types.h")
+	require.NoError(t, s.RefreshIncludeGraph(nil))
+	assert.Equal(t, []int64{types2.ID}, includedFiles(t, s, api.ID))
+
+	// Deleting an includer drops its edges.
+	require.NoError(t, s.DeleteFiles([]int64{main.ID}))
+	require.NoError(t, s.RefreshIncludeGraph(nil))
+	assert.Empty(t, includedFiles(t, s, main.ID))
+	g, err = s.IncludeGraph()
+	require.NoError(t, err)
+	assert.Equal(t, []int64{api.ID}, g.Dependents([]int64{types2.ID}, 1<<30))
+}
@@ -0,0 +1,133 @@
+package store
+
+import (
+	"encoding/binary"
+	"fmt"
+)
+
+// MergeResult summarizes a Merge.
+type MergeResult struct {
+	Files    int // files copied
+	Replaced int // of which replaced a file already indexed at the same path
+}
+
+// mergeGroupFiles is how many files Merge commits per transaction.
+const mergeGroupFiles = 64
+
+// Merge copies every file of src, another database such as one shard of a
+// sharded index, into s along with its extraction rows. Rows get new IDs
+// the way an extraction's fake IDs do on commit (see CopyRows), so the two
+// databases' ID ranges may overlap. A file of s at the same path as one of
+// src is deleted first.
+//
+// Resolution data is not copied: a shard's references into other shards
+// are unresolved, and the IDs of resolved targets in other files would
+// have to be remapped across databases. For the same reason an
+// annotation's resolved symbol is kept only when it is in the same file.
+// The merged files therefore need resolving.
+func (s *Store) Merge(src *Store) (*MergeResult, error) {
+	files, err := src.mergeFiles()
+	if err != nil {
+		return nil, fmt.Errorf("merge: %w", err)
+	}
+	res := &MergeResult{Files: len(files)}
+
+	var stale []int64
+	for _, f := range files {
+		old, err := s.FileByPath(f.Path)
+		if err != nil {
+			return nil, fmt.Errorf("merge: %w", err)
+		}
+		if old != nil {
+			stale = append(stale, old.ID)
+		}
+	}
+	if err := s.DeleteFiles(stale); err != nil {
+		return nil, fmt.Errorf("merge: %w", err)
+	}
+	res.Replaced = len(stale)
+
+	group := make([]*BatchedStore, 0, mergeGroupFiles)
+	flush := func() error {
+		if len(group) == 0 {
+			return nil
+		}
+		err := s.CommitBatches(group)
+		group = group[:0]
+		return err
+	}
+	for _, f := range files {
+		rows, err := src.Rows(f.ID)
+		if err != nil {
+			return nil, fmt.Errorf("merge: %s: %w", f.Path, err)
+		}
+		dropForeignAnnotationTargets(rows)
+		from := f.ID
+		if _, err := s.InsertFile(f); err != nil {
+			return nil, fmt.Errorf("merge: %s: %w", f.Path, err)
+		}
+		b := NewBatchedStore(s)
+		b.CopyRows(rows, from, f.ID)
+		group = append(group, b)
+		if len(group) == mergeGroupFiles {
+			if err := flush(); err != nil {
+				return nil, fmt.Errorf("merge: %w", err)
+			}
+		}
+	}
+	if err := flush(); err != nil {
+		return nil, fmt.Errorf("merge: %w", err)
+	}
+	return res, nil
+}
+
+// mergeFiles returns every file of s, line lengths included, in ID order.
+func (s *Store) mergeFiles() ([]*File, error) {
+	rows, err := s.rdb.Query("SELECT " + fileCols + ", line_lengths FROM files ORDER BY id")
+	if err != nil {
+		return nil, fmt.Errorf("files: %w", err)
+	}
+	defer rows.Close()
+	var files []*File
+	for rows.Next() {
+		f := &File{}
+		var lengths []byte
+		err := rows.Scan(&f.ID, &f.Path, &f.Language, &f.Hash, &f.LineCount, &f.LastIndexed,
+			&f.Size, &f.ModTime, &f.Inode, &lengths)
+		if err != nil {
+			return nil, fmt.Errorf("files: %w", err)
+		}
+		f.LineLengths = decodeLineLengths(lengths)
+		files = append(files, f)
+	}
+	if err := rows.Err(); err != nil {
+		return nil, fmt.Errorf("files: %w", err)
+	}
+	return files, nil
+}
+
+// decodeLineLengths reverses encodeLineLengths.
+func decodeLineLengths(buf []byte) []uint32 {
+	if buf == nil {
+		return nil
+	}
+	lengths := make([]uint32, len(buf)/4)
+	for i := range lengths {
+		lengths[i] = binary.LittleEndian.Uint32(buf[4*i:])
+	}
+	return lengths
+}
+
+// dropForeignAnnotationTargets clears the resolved symbols of r's
+// annotations that are not among r's own symbols.
+func dropForeignAnnotationTargets(r *FileRows) {
+	own := make(map[int64]bool, len(r.Symbols))
+	for i := range r.Symbols {
+		own[r.Symbols[i].ID] = true
+	}
+	for i := range r.Annotations {
+		if id := r.Annotations[i].ResolvedSymbolID; id != nil && !own[*id] {
+			r.Annotations[i].ResolvedSymbolID = nil
+		}
+	}
+}
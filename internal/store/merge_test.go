@@ -0,0 +1,84 @@
+package store
+
+import (
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func TestMerge_RemapsIDsAndReplacesFiles(t *testing.T) {
+	t.Parallel()
+	src := newTestStore(t)
+	other := insertTestFile(t, src, "/repo/b/other.go", "go")
+	foreign := insertTestSymbol(t, src, &other.ID, "Foreign", "function")
+	f := &File{Path: "/repo/a/main.go", Language: "go", Hash: "h1", LineLengths: []uint32{12, 0, 7}}
+	_, err := src.InsertFile(f)
+	require.NoError(t, err)
+	typ := insertTestSymbol(t, src, &f.ID, "Server", "struct")
+	method := &Symbol{FileID: &f.ID, Name: "Run", Kind: "method", ParentSymbolID: &typ.ID, StartLine: 2, EndLine: 2}
+	_, err = src.InsertSymbol(method)
+	require.NoError(t, err)
+	scopeID, err := src.InsertScope(&Scope{FileID: f.ID, Kind: "function", SymbolID: &method.ID, StartLine: 2, EndLine: 2})
+	require.NoError(t, err)
+	_, err = src.InsertReference(&Reference{FileID: f.ID, ScopeID: &scopeID, Name: "Foreign", StartLine: 2, StartCol: 4, Context: "call"})
+	require.NoError(t, err)
+	_, err = src.InsertAnnotation(&Annotation{TargetSymbolID: method.ID, Name: "own", ResolvedSymbolID: &typ.ID, FileID: &f.ID})
+	require.NoError(t, err)
+	_, err = src.InsertAnnotation(&Annotation{TargetSymbolID: method.ID, Name: "foreign", ResolvedSymbolID: &foreign.ID, FileID: &f.ID})
+	require.NoError(t, err)
+
+	// The destination's IDs overlap the source's, and it already has an
+	// older copy of main.go.
+	dst := newTestStore(t)
+	keep := insertTestFile(t, dst, "/repo/c/keep.go", "go")
+	insertTestSymbol(t, dst, &keep.ID, "Keep", "function")
+	oldMain := insertTestFile(t, dst, "/repo/a/main.go", "go")
+	insertTestSymbol(t, dst, &oldMain.ID, "Stale", "function")
+
+	res, err := dst.Merge(src)
+	require.NoError(t, err)
+	assert.Equal(t, &MergeResult{Files: 2, Replaced: 1}, res)
+
+	merged, err := dst.FileByPath("/repo/a/main.go")
+	require.NoError(t, err)
+	require.NotNil(t, merged)
+	assert.NotEqual(t, oldMain.ID, merged.ID)
+	assert.Equal(t, "h1", merged.Hash)
+	n, known, err := dst.LineLength(merged.ID, 2)
+	require.NoError(t, err)
+	assert.True(t, known)
+	assert.Equal(t, 7, n)
+
+	rows, err := dst.Rows(merged.ID)
+	require.NoError(t, err)
+	require.Len(t, rows.Symbols, 2)
+	byName := map[string]Symbol{}
+	for _, sym := range rows.Symbols {
+		byName[sym.Name] = sym
+	}
+	require.NotNil(t, byName["Run"].ParentSymbolID)
+	assert.Equal(t, byName["Server"].ID, *byName["Run"].ParentSymbolID, "parent remapped")
+	require.Len(t, rows.Scopes, 1)
+	assert.Equal(t, byName["Run"].ID, *rows.Scopes[0].SymbolID)
+	require.Len(t, rows.References, 1)
+	assert.Equal(t, rows.Scopes[0].ID, *rows.References[0].ScopeID)
+	require.Len(t, rows.Annotations, 2)
+	for _, ann := range rows.Annotations {
+		assert.Equal(t, byName["Run"].ID, ann.TargetSymbolID)
+		if ann.Name == "own" {
+			assert.Equal(t, byName["Server"].ID, *ann.ResolvedSymbolID)
+		} else {
+			assert.Nil(t, ann.ResolvedSymbolID, "targets in other files are not carried over")
+		}
+	}
+
+	// Untouched files stay; the replaced file's rows are gone.
+	kept, err := dst.Rows(keep.ID)
+	require.NoError(t, err)
+	require.Len(t, kept.Symbols, 1)
+	assert.Equal(t, "Keep", kept.Symbols[0].Name)
+	stale, err := dst.Rows(oldMain.ID)
+	require.NoError(t, err)
+	assert.Empty(t, stale.Symbols)
+}
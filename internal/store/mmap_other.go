@@ -0,0 +1,12 @@
+//go:build !unix
+
+package store
+
+import "os"
+
+// mapFile reads path into memory where mmap is unavailable.
+func mapFile(path string) ([]byte, error) {
+	return os.ReadFile(path)
+}
+
+func unmapFile([]byte) {}
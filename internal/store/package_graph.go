@@ -0,0 +1,691 @@
+package store
+
+import (
+	"database/sql"
+	"fmt"
+	"slices"
+	"strings"
+)
+
+// The package dependency graph is materialized in package_edges, so
+// PackageDependencyGraph and CircularDependencies read it instead of loading
+// every file, package symbol and import per call. Each layer is kept per
+// file or per import source so it can be patched:
+//
+//   - file_packages maps a file to its package (its last package, module or
+//     namespace symbol), and package_path_suffixes lists the '/'-suffixes of
+//     those files' paths for path-based import resolution.
+//   - import_targets caches the package each distinct import source
+//     resolves to (NULL for external imports).
+//   - file_package_edges holds each file's contribution to package_edges.
+//   - package_cycles records the members of every import cycle.
+//
+// Triggers on imports and package symbols record the files (and package
+// names) whose contribution may have changed; RefreshPackageGraph redoes
+// only those files, plus the files importing a source whose target moved.
+const packageGraphDDL = `
+CREATE TABLE IF NOT EXISTS file_packages (
+  file_id INTEGER PRIMARY KEY,
+  package TEXT NOT NULL
+);
+
+CREATE TABLE IF NOT EXISTS package_path_suffixes (
+  suffix  TEXT NOT NULL,
+  file_id INTEGER NOT NULL,
+  PRIMARY KEY (suffix, file_id)
+) WITHOUT ROWID;
+
+CREATE TABLE IF NOT EXISTS import_targets (
+  source       TEXT PRIMARY KEY,
+  last_segment TEXT NOT NULL,
+  package      TEXT
+) WITHOUT ROWID;
+
+CREATE TABLE IF NOT EXISTS file_package_edges (
+  file_id      INTEGER NOT NULL,
+  from_package TEXT NOT NULL,
+  to_package   TEXT NOT NULL,
+  import_count INTEGER NOT NULL,
+  PRIMARY KEY (file_id, to_package)
+) WITHOUT ROWID;
+
+CREATE TABLE IF NOT EXISTS package_edges (
+  from_package TEXT NOT NULL,
+  to_package   TEXT NOT NULL,
+  import_count INTEGER NOT NULL,
+  PRIMARY KEY (from_package, to_package)
+) WITHOUT ROWID;
+
+CREATE TABLE IF NOT EXISTS package_cycles (
+  package   TEXT PRIMARY KEY,
+  component TEXT NOT NULL,
+  position  INTEGER NOT NULL
+) WITHOUT ROWID;
+
+CREATE TABLE IF NOT EXISTS package_graph_dirty_files (
+  file_id INTEGER PRIMARY KEY
+);
+
+CREATE TABLE IF NOT EXISTS package_graph_dirty_names (
+  name TEXT PRIMARY KEY
+) WITHOUT ROWID;
+
+CREATE INDEX IF NOT EXISTS idx_file_packages_package ON file_packages(package);
+CREATE INDEX IF NOT EXISTS idx_package_path_suffixes_file ON package_path_suffixes(file_id);
+CREATE INDEX IF NOT EXISTS idx_import_targets_segment ON import_targets(last_segment);
+
+CREATE TRIGGER IF NOT EXISTS trg_imports_insert_pkg_graph AFTER INSERT ON imports BEGIN
+  INSERT OR IGNORE INTO package_graph_dirty_files (file_id) VALUES (NEW.file_id);
+END;
+CREATE TRIGGER IF NOT EXISTS trg_imports_delete_pkg_graph AFTER DELETE ON imports BEGIN
+  INSERT OR IGNORE INTO package_graph_dirty_files (file_id) VALUES (OLD.file_id);
+END;
+CREATE TRIGGER IF NOT EXISTS trg_symbols_insert_pkg_graph AFTER INSERT ON symbols
+WHEN NEW.kind IN ('package', 'module', 'namespace') AND NEW.file_id IS NOT NULL BEGIN
+  INSERT OR IGNORE INTO package_graph_dirty_files (file_id) VALUES (NEW.file_id);
+  INSERT OR IGNORE INTO package_graph_dirty_names (name) VALUES (NEW.name);
+END;
+CREATE TRIGGER IF NOT EXISTS trg_symbols_delete_pkg_graph AFTER DELETE ON symbols
+WHEN OLD.kind IN ('package', 'module', 'namespace') AND OLD.file_id IS NOT NULL BEGIN
+  INSERT OR IGNORE INTO package_graph_dirty_files (file_id) VALUES (OLD.file_id);
+  INSERT OR IGNORE INTO package_graph_dirty_names (name) VALUES (OLD.name);
+END;
+`
+
+// packageGraphKey is the metadata entry recording that the package graph
+// tables have been built for this database.
+const packageGraphKey = "package_graph"
+
+const (
+	packageKinds      = "('package', 'module', 'namespace')"
+	dirtyPackageFiles = "(SELECT file_id FROM package_graph_dirty_files)"
+)
+
+var (
+	pathSuffixesTable  = bulkTable{"package_path_suffixes", []string{"suffix", "file_id"}}
+	importTargetsTable = bulkTable{"import_targets", []string{"source", "last_segment", "package"}}
+	packageCyclesTable = bulkTable{"package_cycles", []string{"package", "component", "position"}}
+)
+
+// maxIncrementalCycleEdges bounds the changed edges for which cycles are
+// patched; each one may cost a pass over the graph, so past this a full
+// recomputation is cheaper.
+const maxIncrementalCycleEdges = 64
+
+// RefreshPackageGraph brings the package graph tables up to date with the
+// imports and package symbols changed since the last refresh. It is a
+// no-op when nothing changed.
+func (s *Store) RefreshPackageGraph() error {
+	var pending bool
+	err := s.rdb.QueryRow(`SELECT EXISTS (SELECT 1 FROM package_graph_dirty_files)
+		OR EXISTS (SELECT 1 FROM package_graph_dirty_names)`).Scan(&pending)
+	if err != nil {
+		return fmt.Errorf("refresh package graph: %w", err)
+	}
+	if !pending {
+		return nil
+	}
+	return s.writePackageGraph(false)
+}
+
+// rebuildPackageGraph recomputes the package graph tables from scratch and
+// marks them built.
+func (s *Store) rebuildPackageGraph() error {
+	return s.writePackageGraph(true)
+}
+
+func (s *Store) writePackageGraph(full bool) error {
+	tx, err := s.db.Begin()
+	if err != nil {
+		return fmt.Errorf("package graph: begin: %w", err)
+	}
+	defer tx.Rollback()
+	w := newBatchWriter(tx)
+	defer w.close()
+
+	if full {
+		for _, q := range []string{
+			"DELETE FROM file_packages", "DELETE FROM package_path_suffixes", "DELETE FROM import_targets",
+			"DELETE FROM file_package_edges", "DELETE FROM package_edges", "DELETE FROM package_cycles",
+			"INSERT OR IGNORE INTO package_graph_dirty_files (file_id) SELECT id FROM files",
+		} {
+			if _, err := tx.Exec(q); err != nil {
+				return fmt.Errorf("package graph: reset: %w", err)
+			}
+		}
+	}
+
+	suffixes, err := refreshFilePackages(tx, w)
+	if err != nil {
+		return fmt.Errorf("package graph: file packages: %w", err)
+	}
+	if err := refreshImportTargets(tx, w, suffixes); err != nil {
+		return fmt.Errorf("package graph: import targets: %w", err)
+	}
+
+	before, err := loadPackageEdges(tx)
+	if err != nil {
+		return fmt.Errorf("package graph: %w", err)
+	}
+	if err := refreshPackageEdges(tx); err != nil {
+		return fmt.Errorf("package graph: edges: %w", err)
+	}
+	after, err := loadPackageEdges(tx)
+	if err != nil {
+		return fmt.Errorf("package graph: %w", err)
+	}
+	if err := refreshPackageCycles(tx, w, before, after, full); err != nil {
+		return fmt.Errorf("package graph: cycles: %w", err)
+	}
+
+	done := []string{"DELETE FROM package_graph_dirty_files", "DELETE FROM package_graph_dirty_names"}
+	if full {
+		done = append(done, "INSERT OR REPLACE INTO metadata (key, value) VALUES ('"+packageGraphKey+"', '1')")
+	}
+	for _, q := range done {
+		if _, err := tx.Exec(q); err != nil {
+			return fmt.Errorf("package graph: finish: %w", err)
+		}
+	}
+	return tx.Commit()
+}
+
+// refreshFilePackages recomputes file_packages and package_path_suffixes
+// for the dirty files and returns the path suffixes they had before or have
+// now: the import sources whose path-based resolution may have changed.
+func refreshFilePackages(tx *sql.Tx, w *batchWriter) (map[string]bool, error) {
+	suffixes := make(map[string]bool)
+	if err := collectStrings(tx, suffixes,
+		"SELECT suffix FROM package_path_suffixes WHERE file_id IN "+dirtyPackageFiles); err != nil {
+		return nil, err
+	}
+	for _, q := range []string{
+		"DELETE FROM package_path_suffixes WHERE file_id IN " + dirtyPackageFiles,
+		"DELETE FROM file_packages WHERE file_id IN " + dirtyPackageFiles,
+		// A file with several package symbols belongs to the last one.
+		`INSERT INTO file_packages (file_id, package)
+		 SELECT s.file_id, s.name FROM symbols s
+		  WHERE s.file_id IN ` + dirtyPackageFiles + `
+		    AND s.id = (SELECT MAX(id) FROM symbols WHERE file_id = s.file_id AND kind IN ` + packageKinds + `)`,
+	} {
+		if _, err := tx.Exec(q); err != nil {
+			return nil, err
+		}
+	}
+
+	rows, err := tx.Query(`SELECT fp.file_id, f.path FROM file_packages fp JOIN files f ON f.id = fp.file_id
+		WHERE fp.file_id IN ` + dirtyPackageFiles)
+	if err != nil {
+		return nil, err
+	}
+	defer rows.Close()
+	var args []any
+	for rows.Next() {
+		var fileID int64
+		var path string
+		if err := rows.Scan(&fileID, &path); err != nil {
+			return nil, err
+		}
+		for _, suffix := range pathSuffixes(path) {
+			suffixes[suffix] = true
+			args = append(args, suffix, fileID)
+		}
+	}
+	if err := rows.Err(); err != nil {
+		return nil, err
+	}
+	return suffixes, w.insertRows(pathSuffixesTable, args)
+}
+
+// pathSuffixes returns the parts of path after each '/', without a trailing
+// '/': the import sources s for which path ends in "/"+s or "/"+s+"/".
+func pathSuffixes(path string) []string {
+	var out []string
+	for i := 0; i < len(path); i++ {
+		if path[i] != '/' {
+			continue
+		}
+		if suffix := strings.TrimSuffix(path[i+1:], "/"); suffix != "" {
+			out = append(out, suffix)
+		}
+	}
+	return out
+}
+
+// refreshImportTargets registers the import sources new to the dirty files
+// and re-resolves every source whose target may have changed: new ones,
+// those naming a package that appeared or disappeared, and those matching a
+// changed file path. Files importing a source whose target moved are added
+// to the dirty set so their edges are redone.
+func refreshImportTargets(tx *sql.Tx, w *batchWriter, suffixes map[string]bool) error {
+	stale := make(map[string]bool)
+	if err := collectStrings(tx, stale, `SELECT DISTINCT i.source FROM imports i
+		WHERE i.file_id IN `+dirtyPackageFiles+`
+		  AND NOT EXISTS (SELECT 1 FROM import_targets t WHERE t.source = i.source)`); err != nil {
+		return err
+	}
+	var args []any
+	for source := range stale {
+		args = append(args, source, lastSegment(source), nil)
+	}
+	if err := w.insertRows(importTargetsTable, args); err != nil {
+		return err
+	}
+
+	if err := collectStrings(tx, stale, `SELECT t.source FROM package_graph_dirty_names n
+		JOIN import_targets t ON t.source = n.name OR t.last_segment = n.name`); err != nil {
+		return err
+	}
+	known, err := w.stmt("SELECT EXISTS (SELECT 1 FROM import_targets WHERE source = ?)")
+	if err != nil {
+		return err
+	}
+	for suffix := range suffixes {
+		var ok bool
+		if err := known.QueryRow(suffix).Scan(&ok); err != nil {
+			return err
+		}
+		if ok {
+			stale[suffix] = true
+		}
+	}
+
+	sources := make([]string, 0, len(stale))
+	for source := range stale {
+		sources = append(sources, source)
+	}
+	slices.Sort(sources)
+	for _, source := range sources {
+		var current sql.NullString
+		if err := tx.QueryRow("SELECT package FROM import_targets WHERE source = ?", source).Scan(&current); err != nil {
+			return err
+		}
+		target, err := resolveImportSource(w, source)
+		if err != nil {
+			return err
+		}
+		if target == current {
+			continue
+		}
+		if _, err := tx.Exec("UPDATE import_targets SET package = ? WHERE source = ?", target, source); err != nil {
+			return err
+		}
+		if _, err := tx.Exec(`INSERT OR IGNORE INTO package_graph_dirty_files (file_id)
+			SELECT file_id FROM imports WHERE source = ?`, source); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// resolveImportSource returns the package an import source refers to, or
+// NULL for an external import. In order of preference: the package named
+// exactly source, the package named after its last path segment, or the
+// package of the first file whose path ends in source.
+func resolveImportSource(w *batchWriter, source string) (sql.NullString, error) {
+	named, err := w.stmt("SELECT EXISTS (SELECT 1 FROM symbols WHERE name = ? AND kind IN " + packageKinds + " AND file_id IS NOT NULL)")
+	if err != nil {
+		return sql.NullString{}, err
+	}
+	candidates := []string{source}
+	if seg := lastSegment(source); seg != source {
+		candidates = append(candidates, seg)
+	}
+	for _, name := range candidates {
+		var ok bool
+		if err := named.QueryRow(name).Scan(&ok); err != nil {
+			return sql.NullString{}, err
+		}
+		if ok {
+			return sql.NullString{String: name, Valid: true}, nil
+		}
+	}
+
+	byPath, err := w.stmt(`SELECT fp.package FROM package_path_suffixes ps
+		JOIN file_packages fp ON fp.file_id = ps.file_id
+		WHERE ps.suffix = ? ORDER BY ps.file_id LIMIT 1`)
+	if err != nil {
+		return sql.NullString{}, err
+	}
+	var pkg sql.NullString
+	if err := byPath.QueryRow(source).Scan(&pkg); err != nil && err != sql.ErrNoRows {
+		return sql.NullString{}, err
+	}
+	return pkg, nil
+}
+
+// packageEdgeDelta adds (or, with sign -1, removes) the dirty files'
+// file_package_edges rows to the package_edges counts.
+const packageEdgeDelta = `
+INSERT INTO package_edges (from_package, to_package, import_count)
+SELECT from_package, to_package, %d * SUM(import_count) FROM file_package_edges
+ WHERE file_id IN ` + dirtyPackageFiles + `
+ GROUP BY from_package, to_package
+ON CONFLICT (from_package, to_package) DO UPDATE SET import_count = import_count + excluded.import_count`
+
+// refreshPackageEdges replaces the dirty files' contributions to
+// package_edges with their current imports.
+func refreshPackageEdges(tx *sql.Tx) error {
+	for _, q := range []string{
+		fmt.Sprintf(packageEdgeDelta, -1),
+		"DELETE FROM file_package_edges WHERE file_id IN " + dirtyPackageFiles,
+		`INSERT INTO file_package_edges (file_id, from_package, to_package, import_count)
+		 SELECT i.file_id, fp.package, t.package, COUNT(*) FROM imports i
+		   JOIN file_packages fp ON fp.file_id = i.file_id
+		   JOIN import_targets t ON t.source = i.source
+		  WHERE i.file_id IN ` + dirtyPackageFiles + ` AND t.package IS NOT NULL
+		  GROUP BY i.file_id, t.package`,
+		fmt.Sprintf(packageEdgeDelta, 1),
+		"DELETE FROM package_edges WHERE import_count <= 0",
+	} {
+		if _, err := tx.Exec(q); err != nil {
+			return fmt.Errorf("%s: %w", strings.Fields(q)[0], err)
+		}
+	}
+	return nil
+}
+
+type packageEdge struct{ from, to string }
+
+func loadPackageEdges(tx *sql.Tx) (map[packageEdge]bool, error) {
+	rows, err := tx.Query("SELECT from_package, to_package FROM package_edges")
+	if err != nil {
+		return nil, fmt.Errorf("load edges: %w", err)
+	}
+	defer rows.Close()
+	edges := make(map[packageEdge]bool)
+	for rows.Next() {
+		var e packageEdge
+		if err := rows.Scan(&e.from, &e.to); err != nil {
+			return nil, fmt.Errorf("load edges: %w", err)
+		}
+		edges[e] = true
+	}
+	return edges, rows.Err()
+}
+
+// refreshPackageCycles updates package_cycles for the edge changes from
+// before to after, recomputing only the packages whose component may have
+// changed (see cycleRegion), or every package when full is set.
+func refreshPackageCycles(tx *sql.Tx, w *batchWriter, before, after map[packageEdge]bool, full bool) error {
+	adj := make(map[string][]string)
+	for e := range after {
+		adj[e.from] = append(adj[e.from], e.to)
+	}
+	for _, succ := range adj {
+		slices.Sort(succ)
+	}
+
+	var changed []packageEdge
+	for e := range before {
+		if !after[e] {
+			changed = append(changed, e)
+		}
+	}
+	for e := range after {
+		if !before[e] {
+			changed = append(changed, e)
+		}
+	}
+	if !full && len(changed) == 0 {
+		return nil
+	}
+
+	var region map[string]bool
+	if !full && len(changed) <= maxIncrementalCycleEdges {
+		comp := make(map[string]string)
+		rows, err := tx.Query("SELECT package, component FROM package_cycles")
+		if err != nil {
+			return err
+		}
+		for rows.Next() {
+			var pkg, c string
+			if err := rows.Scan(&pkg, &c); err != nil {
+				rows.Close()
+				return err
+			}
+			comp[pkg] = c
+		}
+		rows.Close()
+		if err := rows.Err(); err != nil {
+			return err
+		}
+		region = cycleRegion(before, after, comp, adj)
+	}
+
+	var nodes []string
+	if region == nil {
+		if _, err := tx.Exec("DELETE FROM package_cycles"); err != nil {
+			return err
+		}
+		seen := make(map[string]bool)
+		for e := range after {
+			for _, p := range []string{e.from, e.to} {
+				if !seen[p] {
+					seen[p] = true
+					nodes = append(nodes, p)
+				}
+			}
+		}
+	} else {
+		del, err := w.stmt("DELETE FROM package_cycles WHERE package = ?")
+		if err != nil {
+			return err
+		}
+		for p := range region {
+			if _, err := del.Exec(p); err != nil {
+				return err
+			}
+			nodes = append(nodes, p)
+		}
+	}
+	slices.Sort(nodes)
+
+	var args []any
+	for _, cycle := range packageCycles(nodes, adj) {
+		for i, p := range cycle {
+			args = append(args, p, cycle[0], i)
+		}
+	}
+	return w.insertRows(packageCyclesTable, args)
+}
+
+// cycleRegion returns the packages whose strongly connected component may
+// differ between before and after, closed under the old components (comp
+// maps cycle members to their component; other packages are their own)
+// and the new ones. Removing an edge inside a component can only split
+// that component; adding an edge u->v merges exactly the packages
+// reachable from v that also reach u.
+func cycleRegion(before, after map[packageEdge]bool, comp map[string]string, adj map[string][]string) map[string]bool {
+	members := make(map[string][]string)
+	for p, c := range comp {
+		members[c] = append(members[c], p)
+	}
+	compOf := func(p string) string {
+		if c, ok := comp[p]; ok {
+			return c
+		}
+		return p
+	}
+	region := make(map[string]bool)
+	addComp := func(p string) {
+		region[p] = true
+		for _, m := range members[compOf(p)] {
+			region[m] = true
+		}
+	}
+
+	var radj map[string][]string
+	for e := range before {
+		if !after[e] && compOf(e.from) == compOf(e.to) {
+			addComp(e.from)
+		}
+	}
+	for e := range after {
+		if before[e] {
+			continue
+		}
+		if compOf(e.from) == compOf(e.to) {
+			if e.from == e.to {
+				addComp(e.from)
+			}
+			continue
+		}
+		if radj == nil {
+			radj = make(map[string][]string)
+			for from, succ := range adj {
+				for _, to := range succ {
+					radj[to] = append(radj[to], from)
+				}
+			}
+		}
+		back := reachable(radj, e.from)
+		for p := range reachable(adj, e.to) {
+			if back[p] {
+				addComp(p)
+			}
+		}
+	}
+	return region
+}
+
+// reachable returns the packages reachable from start, start included.
+func reachable(adj map[string][]string, start string) map[string]bool {
+	seen := map[string]bool{start: true}
+	queue := []string{start}
+	for len(queue) > 0 {
+		p := queue[0]
+		queue = queue[1:]
+		for _, q := range adj[p] {
+			if !seen[q] {
+				seen[q] = true
+				queue = append(queue, q)
+			}
+		}
+	}
+	return seen
+}
+
+// packageCycles returns the import cycles among nodes: the strongly
+// connected components of the subgraph of adj they induce that have more
+// than one package, or one package importing itself. It runs Tarjan's
+// algorithm with an explicit stack, so deep graphs cannot overflow the
+// goroutine stack. Each cycle lists its packages in depth-first order from
+// the smallest, following sorted edges, so the result depends only on the
+// graph and not on which part of it was recomputed.
+func packageCycles(nodes []string, adj map[string][]string) [][]string {
+	in := make(map[string]bool, len(nodes))
+	for _, p := range nodes {
+		in[p] = true
+	}
+	index := make(map[string]int, len(nodes))
+	low := make(map[string]int, len(nodes))
+	onStack := make(map[string]bool)
+	var stack []string
+	var cycles [][]string
+
+	type frame struct {
+		pkg  string
+		next int // index into adj[pkg] of the next edge to follow
+	}
+	visit := func(p string) frame {
+		index[p] = len(index)
+		low[p] = index[p]
+		stack = append(stack, p)
+		onStack[p] = true
+		return frame{pkg: p}
+	}
+
+	for _, root := range nodes {
+		if _, seen := index[root]; seen {
+			continue
+		}
+		calls := []frame{visit(root)}
+		for len(calls) > 0 {
+			f := &calls[len(calls)-1]
+			if f.next < len(adj[f.pkg]) {
+				w := adj[f.pkg][f.next]
+				f.next++
+				if !in[w] {
+					continue
+				}
+				if _, seen := index[w]; !seen {
+					calls = append(calls, visit(w))
+				} else if onStack[w] {
+					low[f.pkg] = min(low[f.pkg], index[w])
+				}
+				continue
+			}
+
+			v := f.pkg
+			calls = calls[:len(calls)-1]
+			if len(calls) > 0 {
+				parent := calls[len(calls)-1].pkg
+				low[parent] = min(low[parent], low[v])
+			}
+			if low[v] != index[v] {
+				continue
+			}
+			var scc []string
+			for {
+				w := stack[len(stack)-1]
+				stack = stack[:len(stack)-1]
+				onStack[w] = false
+				scc = append(scc, w)
+				if w == v {
+					break
+				}
+			}
+			if len(scc) > 1 || slices.Contains(adj[v], v) {
+				cycles = append(cycles, cycleOrder(scc, adj))
+			}
+		}
+	}
+	slices.SortFunc(cycles, func(a, b []string) int { return strings.Compare(a[0], b[0]) })
+	return cycles
+}
+
+// cycleOrder lists the members of one component in depth-first preorder
+// from its smallest package.
+func cycleOrder(scc []string, adj map[string][]string) []string {
+	member := make(map[string]bool, len(scc))
+	for _, p := range scc {
+		member[p] = true
+	}
+	seen := make(map[string]bool, len(scc))
+	order := make([]string, 0, len(scc))
+	stack := []string{slices.Min(scc)}
+	for len(stack) > 0 {
+		p := stack[len(stack)-1]
+		stack = stack[:len(stack)-1]
+		if seen[p] {
+			continue
+		}
+		seen[p] = true
+		order = append(order, p)
+		succ := adj[p]
+		for i := len(succ) - 1; i >= 0; i-- {
+			if member[succ[i]] && !seen[succ[i]] {
+				stack = append(stack, succ[i])
+			}
+		}
+	}
+	return order
+}
+
+// collectStrings adds the first column of every row of query to set.
+func collectStrings(tx *sql.Tx, set map[string]bool, query string) error {
+	rows, err := tx.Query(query)
+	if err != nil {
+		return err
+	}
+	defer rows.Close()
+	for rows.Next() {
+		var v string
+		if err := rows.Scan(&v); err != nil {
+			return err
+		}
+		set[v] = true
+	}
+	return rows.Err()
+}
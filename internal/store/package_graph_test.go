@@ -0,0 +1,171 @@
+package store
+
+import (
+	"fmt"
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func packageEdgeCounts(t *testing.T, s *Store) map[string]int {
+	t.Helper()
+	rows, err := s.db.Query("SELECT from_package, to_package, import_count FROM package_edges")
+	require.NoError(t, err)
+	defer rows.Close()
+	out := make(map[string]int)
+	for rows.Next() {
+		var from, to string
+		var n int
+		require.NoError(t, rows.Scan(&from, &to, &n))
+		out[from+"->"+to] = n
+	}
+	require.NoError(t, rows.Err())
+	return out
+}
+
+func storedCycles(t *testing.T, s *Store) [][]string {
+	t.Helper()
+	rows, err := s.db.Query("SELECT package, component FROM package_cycles ORDER BY component, position")
+	require.NoError(t, err)
+	defer rows.Close()
+	var out [][]string
+	last := ""
+	for rows.Next() {
+		var pkg, comp string
+		require.NoError(t, rows.Scan(&pkg, &comp))
+		if comp != last || out == nil {
+			out = append(out, nil)
+			last = comp
+		}
+		out[len(out)-1] = append(out[len(out)-1], pkg)
+	}
+	require.NoError(t, rows.Err())
+	return out
+}
+
+func insertPackageFile(t *testing.T, s *Store, path, pkg string, imports ...string) *File {
+	t.Helper()
+	f := insertTestFile(t, s, path, "go")
+	insertTestSymbol(t, s, &f.ID, pkg, "package")
+	for _, src := range imports {
+		_, err := s.InsertImport(&Import{FileID: f.ID, Source: src, Kind: "import"})
+		require.NoError(t, err)
+	}
+	return f
+}
+
+func TestRefreshPackageGraph_TracksImportChanges(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	a1 := insertPackageFile(t, s, "/src/a/one.go", "a", "b", "fmt")
+	insertPackageFile(t, s, "/src/a/two.go", "a", "example.com/b")
+	insertPackageFile(t, s, "/src/b/main.go", "b", "c")
+
+	require.NoError(t, s.RefreshPackageGraph())
+	assert.Equal(t, map[string]int{"a->b": 2}, packageEdgeCounts(t, s))
+
+	// A new package c resolves b's existing import of it.
+	c := insertPackageFile(t, s, "/src/c/main.go", "c", "a")
+	require.NoError(t, s.RefreshPackageGraph())
+	assert.Equal(t, map[string]int{"a->b": 2, "b->c": 1, "c->a": 1}, packageEdgeCounts(t, s))
+	assert.Equal(t, [][]string{{"a", "b", "c"}}, storedCycles(t, s))
+
+	// Re-indexing a.go without its import of b drops one edge count.
+	require.NoError(t, s.DeleteFiles([]int64{a1.ID}))
+	require.NoError(t, s.RefreshPackageGraph())
+	assert.Equal(t, map[string]int{"a->b": 1, "b->c": 1, "c->a": 1}, packageEdgeCounts(t, s))
+
+	// Removing c breaks the cycle.
+	require.NoError(t, s.DeleteFiles([]int64{c.ID}))
+	require.NoError(t, s.RefreshPackageGraph())
+	assert.Equal(t, map[string]int{"a->b": 1}, packageEdgeCounts(t, s))
+	assert.Empty(t, storedCycles(t, s))
+}
+
+func TestRefreshPackageGraph_MatchesRebuild(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	var files []*File
+	for i := range 12 {
+		pkg := fmt.Sprintf("p%d", i%6)
+		files = append(files, insertPackageFile(t, s, fmt.Sprintf("/src/%s/f%d.go", pkg, i), pkg,
+			fmt.Sprintf("p%d", (i+1)%6), fmt.Sprintf("mod/p%d", (i*5)%6)))
+		require.NoError(t, s.RefreshPackageGraph())
+	}
+	for _, f := range files[:5] {
+		require.NoError(t, s.DeleteFiles([]int64{f.ID}))
+		require.NoError(t, s.RefreshPackageGraph())
+	}
+	edges, cycles := packageEdgeCounts(t, s), storedCycles(t, s)
+
+	require.NoError(t, s.rebuildPackageGraph())
+	assert.Equal(t, packageEdgeCounts(t, s), edges)
+	assert.Equal(t, storedCycles(t, s), cycles)
+}
+
+func TestPackageCycles_DeepChainIsIterative(t *testing.T) {
+	t.Parallel()
+	// A 100k-package ring is one component found by a single 100k-deep
+	// traversal.
+	const n = 100_000
+	adj := make(map[string][]string, n)
+	nodes := make([]string, n)
+	for i := range n {
+		nodes[i] = fmt.Sprintf("p%06d", i)
+	}
+	for i := range n {
+		adj[nodes[i]] = []string{nodes[(i+1)%n]}
+	}
+	cycles := packageCycles(nodes, adj)
+	require.Len(t, cycles, 1)
+	assert.Len(t, cycles[0], n)
+	assert.Equal(t, "p000000", cycles[0][0])
+}
+
+func TestPackageCycles_SelfLoopsAndOrder(t *testing.T) {
+	t.Parallel()
+	adj := map[string][]string{
+		"a": {"a"},
+		"b": {"c"},
+		"c": {"d"},
+		"d": {"b"},
+		"e": {"b"},
+	}
+	cycles := packageCycles([]string{"a", "b", "c", "d", "e"}, adj)
+	assert.Equal(t, [][]string{{"a"}, {"b", "c", "d"}}, cycles)
+}
+
+func TestCycleRegion(t *testing.T) {
+	t.Parallel()
+	edges := func(pairs ...string) map[packageEdge]bool {
+		out := make(map[packageEdge]bool)
+		for i := 0; i < len(pairs); i += 2 {
+			out[packageEdge{pairs[i], pairs[i+1]}] = true
+		}
+		return out
+	}
+	adjOf := func(e map[packageEdge]bool) map[string][]string {
+		adj := make(map[string][]string)
+		for k := range e {
+			adj[k.from] = append(adj[k.from], k.to)
+		}
+		return adj
+	}
+
+	// Closing a->b->c into a cycle touches exactly its packages.
+	before := edges("a", "b", "b", "c", "x", "y")
+	after := edges("a", "b", "b", "c", "c", "a", "x", "y")
+	region := cycleRegion(before, after, nil, adjOf(after))
+	assert.Equal(t, map[string]bool{"a": true, "b": true, "c": true}, region)
+
+	// Breaking it touches the old component.
+	comp := map[string]string{"a": "a", "b": "a", "c": "a"}
+	region = cycleRegion(after, before, comp, adjOf(before))
+	assert.Equal(t, map[string]bool{"a": true, "b": true, "c": true}, region)
+
+	// An edge that closes no cycle touches nothing.
+	after = edges("a", "b", "b", "c", "x", "y", "y", "a")
+	region = cycleRegion(before, after, nil, adjOf(after))
+	assert.Empty(t, region)
+}
@@ -0,0 +1,881 @@
+package store
+
+import (
+	"crypto/sha256"
+	"database/sql"
+	"fmt"
+	"strconv"
+	"strings"
+)
+
+// FileRows holds the extraction rows of one file: everything an extraction
+// script writes for it. BatchedStore.Rows returns new rows in this shape,
+// and PatchFile diffs them against the rows already stored.
+type FileRows struct {
+	Symbols         []Symbol
+	Scopes          []Scope
+	References      []Reference
+	Imports         []Import
+	TypeMembers     []TypeMember
+	FunctionParams  []FunctionParam
+	TypeParams      []TypeParam
+	Annotations     []Annotation
+	SymbolFragments []SymbolFragment
+}
+
+// PatchResult summarizes a PatchFile call.
+type PatchResult struct {
+	Kept     int // top-level declarations left in place (IDs unchanged)
+	Replaced int // top-level declarations inserted with new IDs
+	Removed  int // stored top-level declarations deleted
+
+	// ReferencingFiles are the files with resolved references to deleted
+	// symbols, collected before those references were dropped.
+	ReferencingFiles []int64
+}
+
+// PatchFile replaces the extraction rows of an already indexed file with
+// rows, a fresh extraction of its new content, without touching the rows
+// that did not change.
+//
+// Rows are grouped by the top-level declaration (root symbol) they belong
+// to: its nested symbols, the scopes they own, the references in those
+// scopes and their child rows. A stored group whose content is identical
+// to a new one, apart from its IDs and a uniform line offset, is kept: its
+// rows keep their IDs and are only shifted to the new lines. Every other
+// group is deleted and its replacement inserted, along with the file-level
+// rows (imports, top-level scopes' contents, annotations) that are always
+// rewritten. A one-line edit to a large file therefore deletes and inserts
+// a single declaration, and symbols elsewhere in the file keep the IDs that
+// other files' resolved references point at.
+//
+// f is the new files row; f.ID must be the existing file's ID. rows use
+// fake (negative) IDs pointing at each other, as buffered by a
+// BatchedStore created with ReplaceFile(f.ID).
+func (s *Store) PatchFile(f *File, rows *FileRows) (*PatchResult, error) {
+	old, err := s.Rows(f.ID)
+	if err != nil {
+		return nil, fmt.Errorf("patch file: load rows: %w", err)
+	}
+	p := planPatch(f.ID, old, rows)
+
+	res := &PatchResult{Kept: p.kept, Replaced: p.replaced, Removed: p.removed}
+	res.ReferencingFiles, err = s.FilesReferencingSymbols(p.delSymbols)
+	if err != nil {
+		return nil, fmt.Errorf("patch file: %w", err)
+	}
+
+	tx, err := s.db.Begin()
+	if err != nil {
+		return nil, fmt.Errorf("patch file: begin: %w", err)
+	}
+	defer tx.Rollback()
+
+	// The patch shifts and replaces reference rows in place, so a compacted
+	// file is expanded for it and compacted again after.
+	if err := expandReferences(tx, f.ID); err != nil {
+		return nil, fmt.Errorf("patch file: %w", err)
+	}
+	if err := p.apply(tx, f); err != nil {
+		return nil, fmt.Errorf("patch file: %w", err)
+	}
+	if s.compactRefs {
+		if err := s.compactFileReferences(tx, []int64{f.ID}); err != nil {
+			return nil, fmt.Errorf("patch file: %w", err)
+		}
+	}
+	if err := tx.Commit(); err != nil {
+		return nil, fmt.Errorf("patch file: commit: %w", err)
+	}
+	return res, nil
+}
+
+// ownSymbols selects the IDs of one file's symbols; bind the file ID.
+const ownSymbols = "(SELECT id FROM symbols WHERE file_id = ?)"
+
+// Rows loads every stored extraction row of a file, in insertion order.
+func (s *Store) Rows(fileID int64) (*FileRows, error) {
+	r := &FileRows{}
+
+	syms, err := s.querySymbols("SELECT "+SymbolCols+" FROM symbols WHERE file_id = ? ORDER BY id", fileID)
+	if err != nil {
+		return nil, fmt.Errorf("symbols: %w", err)
+	}
+	for _, sym := range syms {
+		r.Symbols = append(r.Symbols, *sym)
+	}
+
+	refs, err := s.queryReferences("SELECT "+refCols+" FROM references_ WHERE file_id = ? ORDER BY id", fileID)
+	if err != nil {
+		return nil, fmt.Errorf("references: %w", err)
+	}
+	for _, ref := range refs {
+		r.References = append(r.References, *ref)
+	}
+
+	queries := []struct {
+		label string
+		query string
+		args  []any
+		scan  func(*sql.Rows) error
+	}{
+		{"scopes", "SELECT " + scopeCols + " FROM scopes WHERE file_id = ? ORDER BY id", []any{fileID},
+			func(rows *sql.Rows) error {
+				sc, err := s.scanScope(rows)
+				if err == nil {
+					r.Scopes = append(r.Scopes, *sc)
+				}
+				return err
+			}},
+		{"imports", "SELECT id, file_id, source, imported_name, local_alias, kind, scope FROM imports WHERE file_id = ? ORDER BY id", []any{fileID},
+			func(rows *sql.Rows) error {
+				var imp Import
+				err := rows.Scan(&imp.ID, &imp.FileID, &imp.Source, &imp.ImportedName, &imp.LocalAlias, &imp.Kind, &imp.Scope)
+				r.Imports = append(r.Imports, imp)
+				return err
+			}},
+		{"type members", "SELECT id, symbol_id, name, kind, type_expr, visibility FROM type_members WHERE symbol_id IN " + ownSymbols + " ORDER BY id", []any{fileID},
+			func(rows *sql.Rows) error {
+				var tm TypeMember
+				err := rows.Scan(&tm.ID, &tm.SymbolID, &tm.Name, &tm.Kind, &tm.TypeExpr, &tm.Visibility)
+				r.TypeMembers = append(r.TypeMembers, tm)
+				return err
+			}},
+		{"function params", `SELECT id, symbol_id, name, ordinal, type_expr, is_receiver, is_return, has_default, default_expr
+			 FROM function_parameters WHERE symbol_id IN ` + ownSymbols + " ORDER BY id", []any{fileID},
+			func(rows *sql.Rows) error {
+				var fp FunctionParam
+				err := rows.Scan(&fp.ID, &fp.SymbolID, &fp.Name, &fp.Ordinal, &fp.TypeExpr,
+					&fp.IsReceiver, &fp.IsReturn, &fp.HasDefault, &fp.DefaultExpr)
+				r.FunctionParams = append(r.FunctionParams, fp)
+				return err
+			}},
+		{"type params", `SELECT id, symbol_id, name, ordinal, variance, param_kind, constraints
+			 FROM type_parameters WHERE symbol_id IN ` + ownSymbols + " ORDER BY id", []any{fileID},
+			func(rows *sql.Rows) error {
+				var tp TypeParam
+				err := rows.Scan(&tp.ID, &tp.SymbolID, &tp.Name, &tp.Ordinal, &tp.Variance, &tp.ParamKind, &tp.Constraints)
+				r.TypeParams = append(r.TypeParams, tp)
+				return err
+			}},
+		{"annotations", `SELECT id, target_symbol_id, name, resolved_symbol_id, arguments, file_id, line, col
+			 FROM annotations WHERE target_symbol_id IN ` + ownSymbols + " OR file_id = ? ORDER BY id", []any{fileID, fileID},
+			func(rows *sql.Rows) error {
+				var a Annotation
+				err := rows.Scan(&a.ID, &a.TargetSymbolID, &a.Name, &a.ResolvedSymbolID, &a.Arguments, &a.FileID, &a.Line, &a.Col)
+				r.Annotations = append(r.Annotations, a)
+				return err
+			}},
+		{"symbol fragments", `SELECT id, symbol_id, file_id, start_line, start_col, end_line, end_col, is_primary
+			 FROM symbol_fragments WHERE symbol_id IN ` + ownSymbols + " OR file_id = ? ORDER BY id", []any{fileID, fileID},
+			func(rows *sql.Rows) error {
+				var sf SymbolFragment
+				err := rows.Scan(&sf.ID, &sf.SymbolID, &sf.FileID, &sf.StartLine, &sf.StartCol, &sf.EndLine, &sf.EndCol, &sf.IsPrimary)
+				r.SymbolFragments = append(r.SymbolFragments, sf)
+				return err
+			}},
+	}
+	for _, q := range queries {
+		if err := s.scanRows(q.query, q.args, q.scan); err != nil {
+			return nil, fmt.Errorf("%s: %w", q.label, err)
+		}
+	}
+	return r, nil
+}
+
+func (s *Store) scanRows(query string, args []any, scan func(*sql.Rows) error) error {
+	return scanRowsIn(s.rdb, query, args, scan)
+}
+
+// rowsQueryer is a *sql.DB or *sql.Tx.
+type rowsQueryer interface {
+	Query(query string, args ...any) (*sql.Rows, error)
+}
+
+// scanRowsIn runs query through db and calls scan for each row.
+func scanRowsIn(db rowsQueryer, query string, args []any, scan func(*sql.Rows) error) error {
+	rows, err := db.Query(query, args...)
+	if err != nil {
+		return err
+	}
+	defer rows.Close()
+	for rows.Next() {
+		if err := scan(rows); err != nil {
+			return err
+		}
+	}
+	return rows.Err()
+}
+
+// rowGroups assigns every row of a FileRows to the top-level declaration
+// it belongs to, or to the file level (group -1).
+type rowGroups struct {
+	roots []int // index into Symbols of each group's root symbol
+
+	// Group of each row, by table.
+	symbols, scopes, refs                  []int
+	members, params, typeParams, fragments []int
+
+	// Position of each symbol/scope among its group's rows of that table,
+	// used to pair stored and new rows of matching groups.
+	symOrd, scopeOrd []int
+	groupSyms        [][]int // symbol indices of each group, in order
+	groupScopes      [][]int // scope indices of each group, in order
+
+	// rootScopes are the file-level scopes without a parent (the file or
+	// module scope). Groups may point at them; they are kept and updated in
+	// place when both sides have the same ones.
+	rootScopes []int
+	rootOrd    map[int]int // scope index → position in rootScopes
+
+	symIdx, scopeIdx map[int64]int
+}
+
+func groupRows(r *FileRows) *rowGroups {
+	g := &rowGroups{
+		symIdx:   make(map[int64]int, len(r.Symbols)),
+		scopeIdx: make(map[int64]int, len(r.Scopes)),
+		rootOrd:  make(map[int]int),
+	}
+	for i := range r.Symbols {
+		g.symIdx[r.Symbols[i].ID] = i
+	}
+	for i := range r.Scopes {
+		g.scopeIdx[r.Scopes[i].ID] = i
+	}
+
+	// Symbols belong to their outermost in-file ancestor. depth guards
+	// against parent cycles.
+	g.symbols = unassigned(len(r.Symbols))
+	var symGroup func(i, depth int) int
+	symGroup = func(i, depth int) int {
+		if g.symbols[i] != -2 {
+			return g.symbols[i]
+		}
+		grp := -1
+		if p := r.Symbols[i].ParentSymbolID; p != nil && depth < len(r.Symbols) {
+			if j, ok := g.symIdx[*p]; ok && j != i {
+				grp = symGroup(j, depth+1)
+			}
+		}
+		if grp < 0 {
+			grp = len(g.roots)
+			g.roots = append(g.roots, i)
+		}
+		g.symbols[i] = grp
+		return grp
+	}
+	for i := range r.Symbols {
+		symGroup(i, 0)
+	}
+
+	// Scopes belong to their symbol's group, else to their parent's.
+	g.scopes = unassigned(len(r.Scopes))
+	var scopeGroup func(i, depth int) int
+	scopeGroup = func(i, depth int) int {
+		if g.scopes[i] != -2 {
+			return g.scopes[i]
+		}
+		grp := -1
+		sc := &r.Scopes[i]
+		if sc.SymbolID != nil {
+			if j, ok := g.symIdx[*sc.SymbolID]; ok {
+				grp = g.symbols[j]
+			}
+		}
+		if grp < 0 && sc.ParentScopeID != nil && depth < len(r.Scopes) {
+			if j, ok := g.scopeIdx[*sc.ParentScopeID]; ok && j != i {
+				grp = scopeGroup(j, depth+1)
+			}
+		}
+		g.scopes[i] = grp
+		return grp
+	}
+	for i := range r.Scopes {
+		if scopeGroup(i, 0) < 0 && !g.hasLocalScope(r.Scopes[i].ParentScopeID) {
+			g.rootOrd[i] = len(g.rootScopes)
+			g.rootScopes = append(g.rootScopes, i)
+		}
+	}
+
+	g.refs = make([]int, len(r.References))
+	for i := range r.References {
+		g.refs[i] = g.scopeGroupOf(r.References[i].ScopeID)
+	}
+	g.members = make([]int, len(r.TypeMembers))
+	for i := range r.TypeMembers {
+		g.members[i] = g.symGroupOf(r.TypeMembers[i].SymbolID)
+	}
+	g.params = make([]int, len(r.FunctionParams))
+	for i := range r.FunctionParams {
+		g.params[i] = g.symGroupOf(r.FunctionParams[i].SymbolID)
+	}
+	g.typeParams = make([]int, len(r.TypeParams))
+	for i := range r.TypeParams {
+		g.typeParams[i] = g.symGroupOf(r.TypeParams[i].SymbolID)
+	}
+	g.fragments = make([]int, len(r.SymbolFragments))
+	for i := range r.SymbolFragments {
+		g.fragments[i] = g.symGroupOf(r.SymbolFragments[i].SymbolID)
+	}
+
+	g.symOrd = make([]int, len(r.Symbols))
+	g.groupSyms = make([][]int, len(g.roots))
+	for i, grp := range g.symbols {
+		g.symOrd[i] = len(g.groupSyms[grp])
+		g.groupSyms[grp] = append(g.groupSyms[grp], i)
+	}
+	g.scopeOrd = make([]int, len(r.Scopes))
+	g.groupScopes = make([][]int, len(g.roots))
+	for i, grp := range g.scopes {
+		if grp >= 0 {
+			g.scopeOrd[i] = len(g.groupScopes[grp])
+			g.groupScopes[grp] = append(g.groupScopes[grp], i)
+		}
+	}
+	return g
+}
+
+func unassigned(n int) []int {
+	s := make([]int, n)
+	for i := range s {
+		s[i] = -2
+	}
+	return s
+}
+
+func (g *rowGroups) hasLocalScope(id *int64) bool {
+	if id == nil {
+		return false
+	}
+	_, ok := g.scopeIdx[*id]
+	return ok
+}
+
+func (g *rowGroups) symGroupOf(id int64) int {
+	if j, ok := g.symIdx[id]; ok {
+		return g.symbols[j]
+	}
+	return -1
+}
+
+func (g *rowGroups) scopeGroupOf(id *int64) int {
+	if id == nil {
+		return -1
+	}
+	if j, ok := g.scopeIdx[*id]; ok {
+		return g.scopes[j]
+	}
+	return -1
+}
+
+// fingerprints hashes each group's rows with IDs replaced by in-group
+// positions and lines made relative to the root symbol's start line, so a
+// declaration that only moved hashes the same. sealed reports, per group,
+// whether its rows only point inside the group, at root scopes or at other
+// files; only sealed groups can be kept as they are.
+func (g *rowGroups) fingerprints(r *FileRows, fileID int64) (hashes [][sha256.Size]byte, sealed []bool) {
+	bufs := make([][]byte, len(g.roots))
+	sealed = make([]bool, len(g.roots))
+	base := make([]int, len(g.roots))
+	for grp, root := range g.roots {
+		sealed[grp] = true
+		base[grp] = r.Symbols[root].StartLine
+	}
+
+	num := func(grp int, v int64) {
+		bufs[grp] = append(strconv.AppendInt(bufs[grp], v, 10), '|')
+	}
+	str := func(grp int, s string) {
+		bufs[grp] = append(strconv.AppendQuote(bufs[grp], s), '|')
+	}
+	flag := func(grp int, b bool) {
+		bufs[grp] = append(strconv.AppendBool(bufs[grp], b), '|')
+	}
+	tag := func(grp int, t byte) {
+		bufs[grp] = append(bufs[grp], '\n', t, '|')
+	}
+	line := func(grp, l int) { num(grp, int64(l-base[grp])) }
+	sym := func(grp int, id *int64) {
+		switch j, ok := g.symIdx[ptrOr(id, 0)]; {
+		case id == nil:
+			str(grp, "-")
+		case !ok:
+			str(grp, "e"+strconv.FormatInt(*id, 10))
+		case g.symbols[j] == grp:
+			str(grp, "s"+strconv.Itoa(g.symOrd[j]))
+		default:
+			sealed[grp] = false
+		}
+	}
+	scope := func(grp int, id *int64) {
+		switch j, ok := g.scopeIdx[ptrOr(id, 0)]; {
+		case id == nil:
+			str(grp, "-")
+		case !ok:
+			str(grp, "e"+strconv.FormatInt(*id, 10))
+		case g.scopes[j] == grp:
+			str(grp, "c"+strconv.Itoa(g.scopeOrd[j]))
+		default:
+			if k, isRoot := g.rootOrd[j]; isRoot {
+				str(grp, "r"+strconv.Itoa(k))
+			} else {
+				sealed[grp] = false
+			}
+		}
+	}
+	// span encodes a line range, relative only when it lies in this file.
+	span := func(grp int, inFile bool, startLine, startCol, endLine, endCol int) {
+		if inFile {
+			line(grp, startLine)
+			num(grp, int64(startCol))
+			line(grp, endLine)
+		} else {
+			num(grp, int64(startLine))
+			num(grp, int64(startCol))
+			num(grp, int64(endLine))
+		}
+		num(grp, int64(endCol))
+	}
+
+	for i := range r.Symbols {
+		sy, grp := &r.Symbols[i], g.symbols[i]
+		tag(grp, 'S')
+		str(grp, sy.Name)
+		str(grp, sy.Kind)
+		str(grp, sy.Visibility)
+		str(grp, marshalModifiers(sy.Modifiers))
+		// Not the signature hash: it is derived from rows fingerprinted
+		// here, and new rows only get it when they are committed.
+		span(grp, true, sy.StartLine, sy.StartCol, sy.EndLine, sy.EndCol)
+		sym(grp, sy.ParentSymbolID)
+	}
+	for i := range r.Scopes {
+		sc, grp := &r.Scopes[i], g.scopes[i]
+		if grp < 0 {
+			continue
+		}
+		tag(grp, 'C')
+		sym(grp, sc.SymbolID)
+		str(grp, sc.Kind)
+		span(grp, true, sc.StartLine, sc.StartCol, sc.EndLine, sc.EndCol)
+		scope(grp, sc.ParentScopeID)
+	}
+	for i := range r.References {
+		ref, grp := &r.References[i], g.refs[i]
+		if grp < 0 {
+			continue
+		}
+		tag(grp, 'R')
+		scope(grp, ref.ScopeID)
+		str(grp, ref.Name)
+		str(grp, ref.Context)
+		span(grp, true, ref.StartLine, ref.StartCol, ref.EndLine, ref.EndCol)
+	}
+	for i := range r.TypeMembers {
+		tm, grp := &r.TypeMembers[i], g.members[i]
+		tag(grp, 'M')
+		sym(grp, &tm.SymbolID)
+		str(grp, tm.Name)
+		str(grp, tm.Kind)
+		str(grp, tm.TypeExpr)
+		str(grp, tm.Visibility)
+	}
+	for i := range r.FunctionParams {
+		fp, grp := &r.FunctionParams[i], g.params[i]
+		tag(grp, 'P')
+		sym(grp, &fp.SymbolID)
+		str(grp, fp.Name)
+		num(grp, int64(fp.Ordinal))
+		str(grp, fp.TypeExpr)
+		flag(grp, fp.IsReceiver)
+		flag(grp, fp.IsReturn)
+		flag(grp, fp.HasDefault)
+		str(grp, fp.DefaultExpr)
+	}
+	for i := range r.TypeParams {
+		tp, grp := &r.TypeParams[i], g.typeParams[i]
+		tag(grp, 'T')
+		sym(grp, &tp.SymbolID)
+		str(grp, tp.Name)
+		num(grp, int64(tp.Ordinal))
+		str(grp, tp.Variance)
+		str(grp, tp.ParamKind)
+		str(grp, tp.Constraints)
+	}
+	// Annotations are always rewritten (their resolved_symbol_id is filled
+	// in by resolution), but a changed annotation still changes its target.
+	for i := range r.Annotations {
+		ann := &r.Annotations[i]
+		grp := g.symGroupOf(ann.TargetSymbolID)
+		if grp < 0 {
+			continue
+		}
+		inFile := ann.FileID != nil && *ann.FileID == fileID
+		tag(grp, 'A')
+		sym(grp, &ann.TargetSymbolID)
+		str(grp, ann.Name)
+		str(grp, ann.Arguments)
+		flag(grp, inFile)
+		if inFile {
+			line(grp, ann.Line)
+		} else {
+			num(grp, int64(ann.Line))
+		}
+		num(grp, int64(ann.Col))
+	}
+	for i := range r.SymbolFragments {
+		sf, grp := &r.SymbolFragments[i], g.fragments[i]
+		if grp < 0 {
+			continue
+		}
+		inFile := sf.FileID == fileID
+		tag(grp, 'F')
+		sym(grp, &sf.SymbolID)
+		num(grp, fileKey(inFile, sf.FileID))
+		span(grp, inFile, sf.StartLine, sf.StartCol, sf.EndLine, sf.EndCol)
+		flag(grp, sf.IsPrimary)
+	}
+
+	hashes = make([][sha256.Size]byte, len(g.roots))
+	for grp, buf := range bufs {
+		hashes[grp] = sha256.Sum256(buf)
+	}
+	return hashes, sealed
+}
+
+func ptrOr(p *int64, def int64) int64 {
+	if p == nil {
+		return def
+	}
+	return *p
+}
+
+// fileKey returns 0 for in-file rows and the file ID otherwise, so
+// fragments in other files fingerprint by their (stable) file ID.
+func fileKey(inFile bool, id int64) int64 {
+	if inFile {
+		return 0
+	}
+	return id
+}
+
+// patchPlan is the row-level diff computed by PatchFile.
+type patchPlan struct {
+	fileID int64
+
+	kept, replaced, removed int
+
+	// Stored rows to delete.
+	delSymbols, delScopes, delRefs, delFragments []int64
+
+	// Line shifts for kept rows, keyed by offset.
+	shiftSymbols, shiftScopes, shiftRefs, shiftFragments map[int][]int64
+
+	// Root scopes updated in place: stored ID → new span.
+	rootSpans map[int64]Scope
+
+	// New rows to insert, with pointers at kept rows rewritten to their
+	// stored IDs.
+	insert *FileRows
+}
+
+func planPatch(fileID int64, old, rows *FileRows) *patchPlan {
+	og, ng := groupRows(old), groupRows(rows)
+	oldHash, oldSealed := og.fingerprints(old, fileID)
+	newHash, newSealed := ng.fingerprints(rows, fileID)
+
+	p := &patchPlan{
+		fileID:         fileID,
+		shiftSymbols:   make(map[int][]int64),
+		shiftScopes:    make(map[int][]int64),
+		shiftRefs:      make(map[int][]int64),
+		shiftFragments: make(map[int][]int64),
+		rootSpans:      make(map[int64]Scope),
+		insert:         &FileRows{},
+	}
+
+	// Groups can only be kept if the root scopes they point at carry over.
+	rootsMatch := len(og.rootScopes) == len(ng.rootScopes)
+	for k := 0; rootsMatch && k < len(og.rootScopes); k++ {
+		rootsMatch = old.Scopes[og.rootScopes[k]].Kind == rows.Scopes[ng.rootScopes[k]].Kind
+	}
+
+	// Pair new groups with identical stored ones, first come first served.
+	pair := make([]int, len(ng.roots))
+	oldKept := make([]bool, len(og.roots))
+	candidates := make(map[[sha256.Size]byte][]int)
+	if rootsMatch {
+		for grp := range og.roots {
+			if oldSealed[grp] {
+				candidates[oldHash[grp]] = append(candidates[oldHash[grp]], grp)
+			}
+		}
+	}
+	for grp := range ng.roots {
+		pair[grp] = -1
+		if !newSealed[grp] {
+			continue
+		}
+		if c := candidates[newHash[grp]]; len(c) > 0 {
+			pair[grp] = c[0]
+			candidates[newHash[grp]] = c[1:]
+			oldKept[c[0]] = true
+		}
+	}
+
+	// new ID → stored ID for every row that is kept.
+	idMap := make(map[int64]int64)
+	for grp, o := range pair {
+		if o < 0 {
+			p.replaced++
+			continue
+		}
+		p.kept++
+		delta := rows.Symbols[ng.roots[grp]].StartLine - old.Symbols[og.roots[o]].StartLine
+		for k, i := range ng.groupSyms[grp] {
+			oldID := old.Symbols[og.groupSyms[o][k]].ID
+			idMap[rows.Symbols[i].ID] = oldID
+			if delta != 0 {
+				p.shiftSymbols[delta] = append(p.shiftSymbols[delta], oldID)
+			}
+		}
+		for k, i := range ng.groupScopes[grp] {
+			oldID := old.Scopes[og.groupScopes[o][k]].ID
+			idMap[rows.Scopes[i].ID] = oldID
+			if delta != 0 {
+				p.shiftScopes[delta] = append(p.shiftScopes[delta], oldID)
+			}
+		}
+		if delta != 0 {
+			for i := range old.References {
+				if og.refs[i] == o {
+					p.shiftRefs[delta] = append(p.shiftRefs[delta], old.References[i].ID)
+				}
+			}
+			for i := range old.SymbolFragments {
+				if og.fragments[i] == o && old.SymbolFragments[i].FileID == fileID {
+					p.shiftFragments[delta] = append(p.shiftFragments[delta], old.SymbolFragments[i].ID)
+				}
+			}
+		}
+	}
+	for grp := range og.roots {
+		if !oldKept[grp] {
+			p.removed++
+		}
+	}
+	keepRoot := make(map[int]bool)
+	if rootsMatch {
+		for k, i := range ng.rootScopes {
+			stored := old.Scopes[og.rootScopes[k]]
+			idMap[rows.Scopes[i].ID] = stored.ID
+			keepRoot[og.rootScopes[k]] = true
+			if sc := rows.Scopes[i]; sc.StartLine != stored.StartLine || sc.StartCol != stored.StartCol ||
+				sc.EndLine != stored.EndLine || sc.EndCol != stored.EndCol {
+				p.rootSpans[stored.ID] = sc
+			}
+		}
+	}
+
+	// Stored rows outside kept groups go.
+	keptGroup := func(grp int) bool { return grp >= 0 && oldKept[grp] }
+	for i := range old.Symbols {
+		if !keptGroup(og.symbols[i]) {
+			p.delSymbols = append(p.delSymbols, old.Symbols[i].ID)
+		}
+	}
+	for i := range old.Scopes {
+		if !keptGroup(og.scopes[i]) && !keepRoot[i] {
+			p.delScopes = append(p.delScopes, old.Scopes[i].ID)
+		}
+	}
+	for i := range old.References {
+		if !keptGroup(og.refs[i]) {
+			p.delRefs = append(p.delRefs, old.References[i].ID)
+		}
+	}
+	for i := range old.SymbolFragments {
+		if og.fragments[i] < 0 && old.SymbolFragments[i].FileID == fileID {
+			p.delFragments = append(p.delFragments, old.SymbolFragments[i].ID)
+		}
+	}
+
+	// New rows outside kept groups come in.
+	newGroup := func(grp int) bool { return grp < 0 || pair[grp] < 0 }
+	mapPtr := func(id *int64) *int64 {
+		if id != nil {
+			if stored, ok := idMap[*id]; ok {
+				return &stored
+			}
+		}
+		return id
+	}
+	mapID := func(id int64) int64 { return *mapPtr(&id) }
+	ins := p.insert
+	for i, sy := range rows.Symbols {
+		if newGroup(ng.symbols[i]) {
+			sy.ParentSymbolID = mapPtr(sy.ParentSymbolID)
+			ins.Symbols = append(ins.Symbols, sy)
+		}
+	}
+	for i, sc := range rows.Scopes {
+		if _, root := ng.rootOrd[i]; root && rootsMatch {
+			continue
+		}
+		if newGroup(ng.scopes[i]) {
+			sc.SymbolID = mapPtr(sc.SymbolID)
+			sc.ParentScopeID = mapPtr(sc.ParentScopeID)
+			ins.Scopes = append(ins.Scopes, sc)
+		}
+	}
+	for i, ref := range rows.References {
+		if newGroup(ng.refs[i]) {
+			ref.ScopeID = mapPtr(ref.ScopeID)
+			ins.References = append(ins.References, ref)
+		}
+	}
+	ins.Imports = rows.Imports
+	for i, tm := range rows.TypeMembers {
+		if newGroup(ng.members[i]) {
+			ins.TypeMembers = append(ins.TypeMembers, tm)
+		}
+	}
+	for i, fp := range rows.FunctionParams {
+		if newGroup(ng.params[i]) {
+			ins.FunctionParams = append(ins.FunctionParams, fp)
+		}
+	}
+	for i, tp := range rows.TypeParams {
+		if newGroup(ng.typeParams[i]) {
+			ins.TypeParams = append(ins.TypeParams, tp)
+		}
+	}
+	for _, ann := range rows.Annotations {
+		ann.TargetSymbolID = mapID(ann.TargetSymbolID)
+		ann.ResolvedSymbolID = mapPtr(ann.ResolvedSymbolID)
+		ins.Annotations = append(ins.Annotations, ann)
+	}
+	for i, sf := range rows.SymbolFragments {
+		if newGroup(ng.fragments[i]) {
+			sf.SymbolID = mapID(sf.SymbolID)
+			ins.SymbolFragments = append(ins.SymbolFragments, sf)
+		}
+	}
+	return p
+}
+
+// apply executes the plan inside tx and rewrites the files row.
+func (p *patchPlan) apply(tx *sql.Tx, f *File) error {
+	if _, err := tx.Exec(deleteStagingDDL); err != nil {
+		return fmt.Errorf("stage deletion: %w", err)
+	}
+	for _, stage := range []struct {
+		table string
+		ids   []int64
+	}{
+		{"del_symbols", p.delSymbols},
+		{"del_scopes", p.delScopes},
+		{"del_refs", p.delRefs},
+	} {
+		err := execChunked(tx, "INSERT INTO "+stage.table+" (id) VALUES %s", "(?)", stage.ids)
+		if err != nil {
+			return fmt.Errorf("stage %s: %w", stage.table, err)
+		}
+	}
+
+	const (
+		syms   = "(SELECT id FROM del_symbols)"
+		scopes = "(SELECT id FROM del_scopes)"
+		refs   = "(SELECT id FROM del_refs)"
+	)
+	steps := append(resolutionDeleteSteps(syms, refs),
+		deleteStep{"clear annotation targets", "UPDATE annotations SET resolved_symbol_id = NULL WHERE resolved_symbol_id IN " + syms},
+		deleteStep{"delete resolution data for file", "DELETE FROM reexports WHERE file_id = ?"},
+		deleteStep{"delete resolution data for file", "DELETE FROM call_graph WHERE file_id = ?"},
+		deleteStep{"delete resolution data for file", "DELETE FROM implementations WHERE file_id = ?"},
+		deleteStep{"invalidate call graph index", invalidateCallGraphIndexSQL},
+
+		// Annotations are rewritten wholesale; the other child tables only
+		// for deleted symbols.
+		deleteStep{"delete annotations", "DELETE FROM annotations WHERE target_symbol_id IN " + ownSymbols + " OR file_id = ?"},
+		deleteStep{"delete extraction child data", "DELETE FROM type_parameters WHERE symbol_id IN " + syms},
+		deleteStep{"delete extraction child data", "DELETE FROM function_parameters WHERE symbol_id IN " + syms},
+		deleteStep{"delete extraction child data", "DELETE FROM type_members WHERE symbol_id IN " + syms},
+		deleteStep{"delete extraction child data", "DELETE FROM symbol_fragments WHERE symbol_id IN " + syms},
+		deleteStep{"delete extraction child data", "DELETE FROM symbol_trigrams WHERE symbol_id IN " + syms},
+
+		deleteStep{"delete extraction data", "DELETE FROM references_ WHERE id IN " + refs},
+		deleteStep{"delete extraction data", "DELETE FROM scopes WHERE id IN " + scopes},
+		deleteStep{"delete extraction data", "DELETE FROM imports WHERE file_id = ?"},
+		deleteStep{"delete extraction data", "DELETE FROM symbols WHERE id IN " + syms},
+	)
+	for _, step := range steps {
+		args := make([]any, strings.Count(step.query, "?"))
+		for i := range args {
+			args[i] = p.fileID
+		}
+		if _, err := tx.Exec(step.query, args...); err != nil {
+			return fmt.Errorf("%s: %w", step.label, err)
+		}
+	}
+	if err := execChunked(tx, "DELETE FROM symbol_fragments WHERE id IN (%s)", "?", p.delFragments); err != nil {
+		return fmt.Errorf("delete symbol fragments by file: %w", err)
+	}
+
+	for _, shift := range []struct {
+		table   string
+		byDelta map[int][]int64
+	}{
+		{"symbols", p.shiftSymbols},
+		{"scopes", p.shiftScopes},
+		{"references_", p.shiftRefs},
+		{"symbol_fragments", p.shiftFragments},
+	} {
+		for delta, ids := range shift.byDelta {
+			q := "UPDATE " + shift.table + " SET start_line = start_line + ?, end_line = end_line + ? WHERE id IN (%s)"
+			if err := execChunked(tx, q, "?", ids, delta, delta); err != nil {
+				return fmt.Errorf("shift %s: %w", shift.table, err)
+			}
+		}
+	}
+	for id, sc := range p.rootSpans {
+		if _, err := tx.Exec("UPDATE scopes SET start_line = ?, start_col = ?, end_line = ?, end_col = ? WHERE id = ?",
+			sc.StartLine, sc.StartCol, sc.EndLine, sc.EndCol, id); err != nil {
+			return fmt.Errorf("update root scope: %w", err)
+		}
+	}
+
+	w := newBatchWriter(tx)
+	defer w.close()
+	if err := w.commit(batchFromRows(nil, p.insert)); err != nil {
+		return err
+	}
+
+	if _, err := tx.Exec(
+		"UPDATE files SET hash = ?, line_count = ?, last_indexed = ?, size = ?, mtime = ?, inode = ?, line_lengths = ? WHERE id = ?",
+		f.Hash, f.LineCount, f.LastIndexed, f.Size, f.ModTime, f.Inode, encodeLineLengths(f.LineLengths), p.fileID,
+	); err != nil {
+		return fmt.Errorf("update file: %w", err)
+	}
+
+	if _, err := tx.Exec("DELETE FROM del_files; DELETE FROM del_symbols; DELETE FROM del_scopes; DELETE FROM del_refs"); err != nil {
+		return fmt.Errorf("clear deletion staging: %w", err)
+	}
+	return nil
+}
+
+// execChunked runs query once per chunk of ids, substituting %s with one
+// copy of item per ID (joined by commas). prefix args are bound before the
+// IDs.
+func execChunked(tx *sql.Tx, query, item string, ids []int64, prefix ...any) error {
+	const chunk = 500
+	for start := 0; start < len(ids); start += chunk {
+		part := ids[start:min(start+chunk, len(ids))]
+		q := fmt.Sprintf(query, strings.TrimSuffix(strings.Repeat(item+",", len(part)), ","))
+		if _, err := tx.Exec(q, append(append([]any{}, prefix...), int64sToArgs(part)...)...); err != nil {
+			return err
+		}
+	}
+	return nil
+}
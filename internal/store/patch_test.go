@@ -0,0 +1,109 @@
+package store
+
+import (
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+// extractFuncs buffers a file scope plus, for each function, a symbol, its
+// scope and one call reference, the way an extraction script would.
+func extractFuncs(t *testing.T, s *Store, fileID int64, funcs []testFunc) *BatchedStore {
+	t.Helper()
+	b := NewBatchedStore(s)
+	b.ReplaceFile(fileID)
+	fileScope, err := b.InsertScope(&Scope{FileID: fileID, Kind: "file", EndLine: 100})
+	require.NoError(t, err)
+	for _, fn := range funcs {
+		symID, err := b.InsertSymbol(&Symbol{FileID: &fileID, Name: fn.name, Kind: "function",
+			StartLine: fn.line, EndLine: fn.line + 2})
+		require.NoError(t, err)
+		scopeID, err := b.InsertScope(&Scope{FileID: fileID, SymbolID: &symID, Kind: "function",
+			StartLine: fn.line, EndLine: fn.line + 2, ParentScopeID: &fileScope})
+		require.NoError(t, err)
+		_, err = b.InsertReference(&Reference{FileID: fileID, ScopeID: &scopeID, Name: fn.calls,
+			StartLine: fn.line + 1, StartCol: 1, EndLine: fn.line + 1, EndCol: 5, Context: "call"})
+		require.NoError(t, err)
+		_, err = b.InsertFunctionParam(&FunctionParam{SymbolID: symID, Name: "x", TypeExpr: "int"})
+		require.NoError(t, err)
+	}
+	return b
+}
+
+type testFunc struct {
+	name  string
+	line  int
+	calls string
+}
+
+func symbolIDsByName(t *testing.T, s *Store, fileID int64) map[string]*Symbol {
+	t.Helper()
+	syms, err := s.SymbolsByFile(fileID)
+	require.NoError(t, err)
+	out := make(map[string]*Symbol, len(syms))
+	for _, sym := range syms {
+		out[sym.Name] = sym
+	}
+	return out
+}
+
+func TestPatchFile_KeepsUnchangedDeclarations(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	f := insertTestFile(t, s, "/big.go", "go")
+	other := insertTestFile(t, s, "/other.go", "go")
+
+	require.NoError(t, s.CommitBatch(extractFuncs(t, s, f.ID, []testFunc{
+		{"A", 0, "foo"}, {"B", 4, "bar"}, {"C", 8, "baz"},
+	})))
+	before := symbolIDsByName(t, s, f.ID)
+
+	// other.go calls B, so deleting B must put other.go in the blast radius.
+	otherRef, err := s.InsertReference(&Reference{FileID: other.ID, Name: "B", Context: "call"})
+	require.NoError(t, err)
+	_, err = s.InsertResolvedReference(&ResolvedReference{ReferenceID: otherRef, TargetSymbolID: before["B"].ID, Confidence: 1})
+	require.NoError(t, err)
+
+	// B's body changes and grows by a line, which pushes C down.
+	f.Hash = "v2"
+	rows := extractFuncs(t, s, f.ID, []testFunc{
+		{"A", 0, "foo"}, {"B", 4, "qux"}, {"C", 9, "baz"},
+	})
+	res, err := s.PatchFile(f, rows.Rows())
+	require.NoError(t, err)
+	assert.Equal(t, 2, res.Kept)
+	assert.Equal(t, 1, res.Replaced)
+	assert.Equal(t, 1, res.Removed)
+	assert.Equal(t, []int64{other.ID}, res.ReferencingFiles)
+
+	after := symbolIDsByName(t, s, f.ID)
+	require.Len(t, after, 3)
+	assert.Equal(t, before["A"].ID, after["A"].ID)
+	assert.Equal(t, before["C"].ID, after["C"].ID)
+	assert.NotEqual(t, before["B"].ID, after["B"].ID)
+	assert.Equal(t, 9, after["C"].StartLine)
+	assert.Equal(t, 11, after["C"].EndLine)
+
+	refs, err := s.ReferencesByFile(f.ID)
+	require.NoError(t, err)
+	byName := make(map[string]*Reference)
+	for _, r := range refs {
+		byName[r.Name] = r
+	}
+	require.Len(t, byName, 3)
+	assert.Contains(t, byName, "qux")
+	assert.Equal(t, 10, byName["baz"].StartLine)
+
+	// The new B hangs off the kept file scope and has its params.
+	scopes, err := s.ScopesByFile(f.ID)
+	require.NoError(t, err)
+	assert.Len(t, scopes, 4)
+	params, err := s.FunctionParams(after["B"].ID)
+	require.NoError(t, err)
+	assert.Len(t, params, 1)
+
+	got, err := s.FileByPath("/big.go")
+	require.NoError(t, err)
+	assert.Equal(t, "v2", got.Hash)
+}
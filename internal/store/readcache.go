@@ -0,0 +1,145 @@
+package store
+
+import "sync"
+
+// ReadCache memoizes the extraction-table queries that resolution scripts
+// issue. Resolution never writes symbols, scopes, references, imports, type
+// members, parameters or files, so results stay valid for the duration of a
+// Resolve pass. Create one ReadCache per pass and discard it afterwards.
+//
+// Cached slices are shared between callers and must be treated as
+// read-only. Thread safety: safe for concurrent use; concurrent misses on
+// the same key wait for a single query instead of issuing duplicates.
+type ReadCache struct {
+	s *Store
+
+	symbolsByName    memo[string, []*Symbol]
+	symbolsByFile    memo[int64, []*Symbol]
+	symbolsByKind    memo[string, []*Symbol]
+	referencesByFile memo[int64, []*Reference]
+	scopesByFile     memo[int64, []*Scope]
+	scopeChain       memo[int64, []*Scope]
+	importsByFile    memo[int64, []*Import]
+	typeMembers      memo[int64, []*TypeMember]
+	functionParams   memo[int64, []*FunctionParam]
+	filesByLanguage  memo[string, []*File]
+	snapshots        memo[string, *LanguageSnapshot]
+}
+
+// NewReadCache creates an empty ReadCache over s.
+func NewReadCache(s *Store) *ReadCache {
+	return &ReadCache{s: s}
+}
+
+func (c *ReadCache) SymbolsByName(name string) ([]*Symbol, error) {
+	return c.symbolsByName.get(name, c.s.SymbolsByName)
+}
+
+func (c *ReadCache) SymbolsByFile(fileID int64) ([]*Symbol, error) {
+	return c.symbolsByFile.get(fileID, c.s.SymbolsByFile)
+}
+
+func (c *ReadCache) SymbolsByKind(kind string) ([]*Symbol, error) {
+	return c.symbolsByKind.get(kind, c.s.SymbolsByKind)
+}
+
+func (c *ReadCache) ReferencesByFile(fileID int64) ([]*Reference, error) {
+	return c.referencesByFile.get(fileID, c.s.ReferencesByFile)
+}
+
+func (c *ReadCache) ScopesByFile(fileID int64) ([]*Scope, error) {
+	return c.scopesByFile.get(fileID, c.s.ScopesByFile)
+}
+
+func (c *ReadCache) ScopeChain(scopeID int64) ([]*Scope, error) {
+	return c.scopeChain.get(scopeID, c.s.ScopeChain)
+}
+
+func (c *ReadCache) ImportsByFile(fileID int64) ([]*Import, error) {
+	return c.importsByFile.get(fileID, c.s.ImportsByFile)
+}
+
+func (c *ReadCache) TypeMembers(symbolID int64) ([]*TypeMember, error) {
+	return c.typeMembers.get(symbolID, c.s.TypeMembers)
+}
+
+func (c *ReadCache) FunctionParams(symbolID int64) ([]*FunctionParam, error) {
+	return c.functionParams.get(symbolID, c.s.FunctionParams)
+}
+
+func (c *ReadCache) FilesByLanguage(language string) ([]*File, error) {
+	return c.filesByLanguage.get(language, c.s.FilesByLanguage)
+}
+
+// LanguageSnapshot loads a language's snapshot once per pass, shared by
+// every shard and every script that asks for it, such as the C and C++
+// resolvers both reading the C headers. Loading it also seeds the per-file
+// memos, so per-file queries on its files are served from it too.
+func (c *ReadCache) LanguageSnapshot(language string) (*LanguageSnapshot, error) {
+	return c.snapshots.get(language, func(language string) (*LanguageSnapshot, error) {
+		sn, err := c.s.LanguageSnapshot(language)
+		if err != nil {
+			return nil, err
+		}
+		c.filesByLanguage.put(language, sn.Files)
+		for _, f := range sn.Files {
+			fs := sn.File(f.ID)
+			c.symbolsByFile.put(f.ID, fs.Symbols)
+			c.scopesByFile.put(f.ID, fs.Scopes)
+			c.referencesByFile.put(f.ID, fs.References)
+			c.importsByFile.put(f.ID, fs.Imports)
+		}
+		return sn, nil
+	})
+}
+
+// memo is a concurrent single-flight memo table. Errors are not cached, so
+// a failed query is retried on the next call.
+type memo[K comparable, V any] struct {
+	mu      sync.Mutex
+	entries map[K]*memoEntry[V]
+}
+
+type memoEntry[V any] struct {
+	once sync.Once
+	val  V
+	err  error
+}
+
+// put records val for key unless the key is already loaded or loading.
+func (m *memo[K, V]) put(key K, val V) {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	if m.entries == nil {
+		m.entries = make(map[K]*memoEntry[V])
+	}
+	if _, ok := m.entries[key]; ok {
+		return
+	}
+	e := &memoEntry[V]{val: val}
+	e.once.Do(func() {})
+	m.entries[key] = e
+}
+
+func (m *memo[K, V]) get(key K, load func(K) (V, error)) (V, error) {
+	m.mu.Lock()
+	if m.entries == nil {
+		m.entries = make(map[K]*memoEntry[V])
+	}
+	e, ok := m.entries[key]
+	if !ok {
+		e = &memoEntry[V]{}
+		m.entries[key] = e
+	}
+	m.mu.Unlock()
+
+	e.once.Do(func() { e.val, e.err = load(key) })
+	if e.err != nil {
+		m.mu.Lock()
+		if m.entries[key] == e {
+			delete(m.entries, key)
+		}
+		m.mu.Unlock()
+	}
+	return e.val, e.err
+}
@@ -0,0 +1,453 @@
+package store
+
+import (
+	"database/sql"
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"os"
+	"slices"
+)
+
+// reference_blocks holds the references of files written in compact
+// reference storage (see WithCompactReferences), one blob per file. Such a
+// file's references_ rows keep only their ID and file ID, for the joins
+// from resolved_references; scope, name, context and position are NULL or
+// empty there and read from the block instead. A trigger drops a file's
+// block with its files row; deleteFiles drops it with the file's rows.
+const referenceBlocksDDL = `
+CREATE TABLE IF NOT EXISTS reference_blocks (
+  file_id INTEGER PRIMARY KEY,
+  data    BLOB NOT NULL
+);
+
+CREATE TRIGGER IF NOT EXISTS trg_files_delete_reference_blocks AFTER DELETE ON files BEGIN
+  DELETE FROM reference_blocks WHERE file_id = OLD.id;
+END;
+`
+
+// WithCompactReferences stores the references of every file committed
+// through a batch, patched, or passed to CompactReferences as one block per
+// file: names and contexts interned into a per-file string table, and IDs,
+// scopes and positions delta-encoded as varints, in ID order. The
+// references_ rows shrink to their ID and file ID, so the table and its
+// indexes take a fraction of the space, and a file's references load with
+// a single read.
+//
+// Readers need no option: every read decodes the blocks it meets, so a
+// database written this way opens normally, and one written without it
+// keeps working as files are compacted. A block is not searchable by SQL;
+// ReferencesByName decodes every block to search them.
+//
+// Migrate records the mode in the database, and a Store opened on it
+// later, or a bulk load replacing it, keeps writing blocks without the
+// option.
+func WithCompactReferences() StoreOption {
+	return func(c *storeConfig) {
+		c.compactRefs = true
+	}
+}
+
+// compactReferencesKey is the metadata entry recording that the database
+// stores references as blocks (see WithCompactReferences).
+const compactReferencesKey = "compact_references"
+
+// syncCompactReferences records the compact mode in the database when the
+// Store was opened with it, and adopts it when the database has it.
+func (s *Store) syncCompactReferences() error {
+	if s.compactRefs {
+		return s.SetMetadata(compactReferencesKey, "1")
+	}
+	v, err := s.GetMetadata(compactReferencesKey)
+	s.compactRefs = v != ""
+	return err
+}
+
+// storedCompactReferences reports whether the database at path, if there
+// is one, stores references as blocks. Errors read as false: a bulk load
+// asks before replacing the database, which may be unreadable or not a
+// canopy database at all.
+func storedCompactReferences(path string) bool {
+	if _, err := os.Stat(path); err != nil {
+		return false
+	}
+	db, err := sql.Open(readerDriver, path+"?_busy_timeout=30000")
+	if err != nil {
+		return false
+	}
+	defer db.Close()
+	var v string
+	db.QueryRow("SELECT value FROM metadata WHERE key = ?", compactReferencesKey).Scan(&v)
+	return v != ""
+}
+
+// packedRefSQL empties the columns a reference block holds.
+const packedRefSQL = `UPDATE references_ SET scope_id = NULL, name = '', start_line = NULL, start_col = NULL,
+	end_line = NULL, end_col = NULL, context = NULL`
+
+// errCorruptBlock reports a reference block that does not decode.
+var errCorruptBlock = errors.New("corrupt reference block")
+
+// encodeReferenceBlock packs refs, which must be sorted by ID. Each
+// reference is its ID, scope ID and start line as deltas from the previous
+// reference's, its name and context as string table indexes, its start
+// column, its end line as a delta from its start line, and its end column.
+func encodeReferenceBlock(refs []Reference) []byte {
+	var t strtab
+	names := make([]int32, len(refs))
+	contexts := make([]int32, len(refs))
+	for i := range refs {
+		names[i] = t.intern(refs[i].Name)
+		contexts[i] = t.intern(refs[i].Context)
+	}
+
+	buf := make([]byte, 0, t.size+int64(len(t.strs))+int64(8*len(refs))+8)
+	buf = binary.AppendUvarint(buf, uint64(len(t.strs)))
+	for _, s := range t.strs {
+		buf = binary.AppendUvarint(buf, uint64(len(s)))
+		buf = append(buf, s...)
+	}
+	buf = binary.AppendUvarint(buf, uint64(len(refs)))
+	var prevID, prevScope int64
+	prevLine := 0
+	for i := range refs {
+		r := &refs[i]
+		scope := idOrNone(r.ScopeID)
+		buf = binary.AppendVarint(buf, r.ID-prevID)
+		buf = binary.AppendVarint(buf, scope-prevScope)
+		buf = binary.AppendUvarint(buf, uint64(names[i]))
+		buf = binary.AppendUvarint(buf, uint64(contexts[i]))
+		buf = binary.AppendVarint(buf, int64(r.StartLine-prevLine))
+		buf = binary.AppendVarint(buf, int64(r.StartCol))
+		buf = binary.AppendVarint(buf, int64(r.EndLine-r.StartLine))
+		buf = binary.AppendVarint(buf, int64(r.EndCol))
+		prevID, prevScope, prevLine = r.ID, scope, r.StartLine
+	}
+	return buf
+}
+
+// blockReader walks an encoded reference block.
+type blockReader struct {
+	buf []byte
+	err error
+}
+
+func (r *blockReader) uvarint() uint64 {
+	v, n := binary.Uvarint(r.buf)
+	if n <= 0 {
+		r.err, r.buf = errCorruptBlock, nil
+		return 0
+	}
+	r.buf = r.buf[n:]
+	return v
+}
+
+func (r *blockReader) varint() int64 {
+	v, n := binary.Varint(r.buf)
+	if n <= 0 {
+		r.err, r.buf = errCorruptBlock, nil
+		return 0
+	}
+	r.buf = r.buf[n:]
+	return v
+}
+
+// decodeReferenceBlock unpacks the block of fileID.
+func decodeReferenceBlock(fileID int64, data []byte) ([]Reference, error) {
+	r := &blockReader{buf: data}
+	strs := make([]string, 0, min(r.uvarint(), uint64(len(data))))
+	for n := cap(strs); r.err == nil && len(strs) < n; {
+		size := r.uvarint()
+		if size > uint64(len(r.buf)) {
+			return nil, errCorruptBlock
+		}
+		strs = append(strs, string(r.buf[:size]))
+		r.buf = r.buf[size:]
+	}
+	str := func(i uint64) string {
+		if i >= uint64(len(strs)) {
+			r.err = errCorruptBlock
+			return ""
+		}
+		return strs[i]
+	}
+
+	refs := make([]Reference, 0, min(r.uvarint(), uint64(len(data))))
+	var id, scope int64
+	line := 0
+	for n := cap(refs); r.err == nil && len(refs) < n; {
+		id += r.varint()
+		scope += r.varint()
+		ref := Reference{ID: id, FileID: fileID, ScopeID: idPtr(scope)}
+		ref.Name = str(r.uvarint())
+		ref.Context = str(r.uvarint())
+		line += int(r.varint())
+		ref.StartLine = line
+		ref.StartCol = int(r.varint())
+		ref.EndLine = line + int(r.varint())
+		ref.EndCol = int(r.varint())
+		refs = append(refs, ref)
+	}
+	if r.err != nil {
+		return nil, r.err
+	}
+	return refs, nil
+}
+
+// ReferenceBlock is the decoded reference block of one file.
+type ReferenceBlock struct {
+	refs []Reference // by ID
+}
+
+// References returns the block's references in ID order.
+func (b *ReferenceBlock) References() []Reference {
+	return b.refs
+}
+
+// Reference returns the reference with ID id, if the block holds it.
+func (b *ReferenceBlock) Reference(id int64) (Reference, bool) {
+	i, ok := slices.BinarySearchFunc(b.refs, id, func(r Reference, id int64) int {
+		return cmpInt64(r.ID, id)
+	})
+	if !ok {
+		return Reference{}, false
+	}
+	return b.refs[i], true
+}
+
+// IDsAt returns the IDs of the references whose span contains the 0-based
+// position (line, col), the way DefinitionAt matches references.
+func (b *ReferenceBlock) IDsAt(line, col int) []int64 {
+	var ids []int64
+	for i := range b.refs {
+		r := &b.refs[i]
+		if (r.StartLine < line || (r.StartLine == line && r.StartCol <= col)) &&
+			(r.EndLine > line || (r.EndLine == line && r.EndCol >= col)) {
+			ids = append(ids, r.ID)
+		}
+	}
+	return ids
+}
+
+func cmpInt64(a, b int64) int {
+	switch {
+	case a < b:
+		return -1
+	case a > b:
+		return 1
+	}
+	return 0
+}
+
+// rowQueryer is the single-row read interface of *sql.DB and *sql.Tx.
+type rowQueryer interface {
+	QueryRow(query string, args ...any) *sql.Row
+}
+
+// LoadReferenceBlock reads and decodes the reference block of fileID
+// through db. It returns nil if the file has none.
+func LoadReferenceBlock(db rowQueryer, fileID int64) (*ReferenceBlock, error) {
+	var data []byte
+	err := db.QueryRow("SELECT data FROM reference_blocks WHERE file_id = ?", fileID).Scan(&data)
+	if err == sql.ErrNoRows {
+		return nil, nil
+	}
+	if err != nil {
+		return nil, fmt.Errorf("load reference block: %w", err)
+	}
+	refs, err := decodeReferenceBlock(fileID, data)
+	if err != nil {
+		return nil, fmt.Errorf("load reference block of file %d: %w", fileID, err)
+	}
+	return &ReferenceBlock{refs: refs}, nil
+}
+
+// ReferenceBlocks loads reference blocks on first use and keeps them for
+// the rest of one read, so each file's block is read and decoded once.
+type ReferenceBlocks struct {
+	db     rowQueryer
+	byFile map[int64]*ReferenceBlock
+}
+
+// NewReferenceBlocks returns an empty cache reading through db.
+func NewReferenceBlocks(db rowQueryer) *ReferenceBlocks {
+	return &ReferenceBlocks{db: db, byFile: make(map[int64]*ReferenceBlock)}
+}
+
+// Block returns the block of fileID, nil if it has none.
+func (c *ReferenceBlocks) Block(fileID int64) (*ReferenceBlock, error) {
+	if b, ok := c.byFile[fileID]; ok {
+		return b, nil
+	}
+	b, err := LoadReferenceBlock(c.db, fileID)
+	if err != nil {
+		return nil, err
+	}
+	c.byFile[fileID] = b
+	return b, nil
+}
+
+// Reference returns reference refID from the block of fileID.
+func (c *ReferenceBlocks) Reference(fileID, refID int64) (Reference, error) {
+	b, err := c.Block(fileID)
+	if err != nil {
+		return Reference{}, err
+	}
+	if b != nil {
+		if r, ok := b.Reference(refID); ok {
+			return r, nil
+		}
+	}
+	return Reference{}, fmt.Errorf("reference %d is missing from the reference block of file %d", refID, fileID)
+}
+
+// unpackReferences fills in the packed references among refs from their
+// files' blocks, read through db.
+func unpackReferences(db rowQueryer, refs []*Reference) error {
+	var blocks *ReferenceBlocks
+	for _, r := range refs {
+		if !r.packed {
+			continue
+		}
+		if blocks == nil {
+			blocks = NewReferenceBlocks(db)
+		}
+		full, err := blocks.Reference(r.FileID, r.ID)
+		if err != nil {
+			return err
+		}
+		*r = full
+	}
+	return nil
+}
+
+// packReferences writes refs, all of fileID, into the file's block along
+// with the references it already holds.
+func packReferences(tx *sql.Tx, fileID int64, refs []Reference) error {
+	existing, err := LoadReferenceBlock(tx, fileID)
+	if err != nil {
+		return err
+	}
+	all := slices.Clone(refs)
+	if existing != nil {
+		added := make(map[int64]bool, len(refs))
+		for _, r := range refs {
+			added[r.ID] = true
+		}
+		for _, r := range existing.refs {
+			if !added[r.ID] {
+				all = append(all, r)
+			}
+		}
+	}
+	slices.SortFunc(all, func(a, b Reference) int { return cmpInt64(a.ID, b.ID) })
+	if _, err := tx.Exec("INSERT OR REPLACE INTO reference_blocks (file_id, data) VALUES (?, ?)",
+		fileID, encodeReferenceBlock(all)); err != nil {
+		return fmt.Errorf("write reference block: %w", err)
+	}
+	return nil
+}
+
+// compactFileReferences moves the references of fileIDs still stored in
+// full rows into the files' blocks.
+func (s *Store) compactFileReferences(tx *sql.Tx, fileIDs []int64) error {
+	for _, fid := range fileIDs {
+		rows, err := tx.Query("SELECT "+refCols+" FROM references_ WHERE file_id = ? AND start_line IS NOT NULL", fid)
+		if err != nil {
+			return fmt.Errorf("compact references: %w", err)
+		}
+		var refs []Reference
+		for rows.Next() {
+			r, err := s.scanReference(rows)
+			if err != nil {
+				rows.Close()
+				return fmt.Errorf("compact references: %w", err)
+			}
+			refs = append(refs, *r)
+		}
+		rows.Close()
+		if err := rows.Err(); err != nil {
+			return fmt.Errorf("compact references: %w", err)
+		}
+		if len(refs) == 0 {
+			continue
+		}
+		if err := packReferences(tx, fid, refs); err != nil {
+			return fmt.Errorf("compact references: %w", err)
+		}
+		if _, err := tx.Exec(packedRefSQL+" WHERE file_id = ? AND start_line IS NOT NULL", fid); err != nil {
+			return fmt.Errorf("compact references: %w", err)
+		}
+	}
+	return nil
+}
+
+// CompactReferences moves the references of fileIDs written row by row
+// into the files' blocks. It is a no-op unless the Store was opened
+// WithCompactReferences.
+func (s *Store) CompactReferences(fileIDs []int64) error {
+	if !s.compactRefs || len(fileIDs) == 0 {
+		return nil
+	}
+	tx, err := s.db.Begin()
+	if err != nil {
+		return fmt.Errorf("compact references: begin: %w", err)
+	}
+	defer tx.Rollback()
+	if err := s.compactFileReferences(tx, fileIDs); err != nil {
+		return err
+	}
+	return tx.Commit()
+}
+
+// CompactRowReferences moves every reference still stored row by row into
+// its file's block, as when a bulk load that wrote them straight to SQLite
+// finishes. It is a no-op unless the Store was opened
+// WithCompactReferences.
+func (s *Store) CompactRowReferences() error {
+	if !s.compactRefs {
+		return nil
+	}
+	rows, err := s.db.Query("SELECT DISTINCT file_id FROM references_ WHERE start_line IS NOT NULL")
+	if err != nil {
+		return fmt.Errorf("compact references: %w", err)
+	}
+	var fileIDs []int64
+	for rows.Next() {
+		var fid int64
+		if err := rows.Scan(&fid); err != nil {
+			rows.Close()
+			return fmt.Errorf("compact references: %w", err)
+		}
+		fileIDs = append(fileIDs, fid)
+	}
+	rows.Close()
+	if err := rows.Err(); err != nil {
+		return fmt.Errorf("compact references: %w", err)
+	}
+	return s.CompactReferences(fileIDs)
+}
+
+// expandReferences writes the block of fileID back into its references_
+// rows and drops it, for changes that rewrite rows in place.
+func expandReferences(tx *sql.Tx, fileID int64) error {
+	b, err := LoadReferenceBlock(tx, fileID)
+	if err != nil || b == nil {
+		return err
+	}
+	stmt, err := tx.Prepare(`UPDATE references_ SET scope_id = ?, name = ?, start_line = ?, start_col = ?,
+		end_line = ?, end_col = ?, context = ? WHERE id = ?`)
+	if err != nil {
+		return fmt.Errorf("expand references: %w", err)
+	}
+	defer stmt.Close()
+	for _, r := range b.refs {
+		if _, err := stmt.Exec(r.ScopeID, r.Name, r.StartLine, r.StartCol, r.EndLine, r.EndCol, r.Context, r.ID); err != nil {
+			return fmt.Errorf("expand references: %w", err)
+		}
+	}
+	if _, err := tx.Exec("DELETE FROM reference_blocks WHERE file_id = ?", fileID); err != nil {
+		return fmt.Errorf("expand references: %w", err)
+	}
+	return nil
+}
@@ -0,0 +1,155 @@
+package store
+
+import (
+	"path/filepath"
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func TestReferenceBlock_RoundTrip(t *testing.T) {
+	t.Parallel()
+	refs := []Reference{
+		{ID: 3, FileID: 7, ScopeID: ptr(int64(40)), Name: "foo", StartLine: 10, StartCol: 4, EndLine: 10, EndCol: 7, Context: "call"},
+		{ID: 4, FileID: 7, Name: "bar", StartLine: 2, StartCol: 0, EndLine: 5, EndCol: 1, Context: "type_ref"},
+		{ID: 9, FileID: 7, ScopeID: ptr(int64(12)), Name: "foo", StartLine: 11, EndLine: 11, EndCol: 3, Context: "call"},
+	}
+	data := encodeReferenceBlock(refs)
+	got, err := decodeReferenceBlock(7, data)
+	require.NoError(t, err)
+	assert.Equal(t, refs, got)
+
+	b := &ReferenceBlock{refs: got}
+	r, ok := b.Reference(4)
+	require.True(t, ok)
+	assert.Equal(t, "bar", r.Name)
+	_, ok = b.Reference(5)
+	assert.False(t, ok)
+	assert.Equal(t, []int64{4}, b.IDsAt(3, 100))
+	assert.Equal(t, []int64{3}, b.IDsAt(10, 7))
+	assert.Empty(t, b.IDsAt(10, 8))
+
+	_, err = decodeReferenceBlock(7, data[:len(data)-1])
+	assert.ErrorIs(t, err, errCorruptBlock)
+}
+
+func TestCompactReferences_CommitPatchDelete(t *testing.T) {
+	t.Parallel()
+	s, err := NewStore(filepath.Join(t.TempDir(), "test.db"), WithCompactReferences())
+	require.NoError(t, err)
+	require.NoError(t, s.Migrate())
+	t.Cleanup(func() { s.Close() })
+	plain := newTestStore(t)
+
+	funcs := []testFunc{{"A", 0, "foo"}, {"B", 4, "bar"}, {"C", 8, "foo"}}
+	var files []*File
+	for _, st := range []*Store{s, plain} {
+		f := insertTestFile(t, st, "/big.go", "go")
+		require.NoError(t, st.CommitBatch(extractFuncs(t, st, f.ID, funcs)))
+		files = append(files, f)
+	}
+	f := files[0]
+
+	// Only IDs and file IDs stay in the rows; reads see the same references.
+	var full int
+	require.NoError(t, s.db.QueryRow("SELECT COUNT(*) FROM references_ WHERE start_line IS NOT NULL").Scan(&full))
+	assert.Zero(t, full)
+	want, err := plain.ReferencesByFile(files[1].ID)
+	require.NoError(t, err)
+	got, err := s.ReferencesByFile(f.ID)
+	require.NoError(t, err)
+	assert.Equal(t, want, got)
+
+	byName, err := s.ReferencesByName("foo")
+	require.NoError(t, err)
+	assert.Len(t, byName, 2)
+	inScope, err := s.ReferencesInScope(*got[1].ScopeID)
+	require.NoError(t, err)
+	assert.Equal(t, []*Reference{got[1]}, inScope)
+
+	// A patch shifting C down leaves the file compacted, at the new lines.
+	f.Hash = "v2"
+	_, err = s.PatchFile(f, extractFuncs(t, s, f.ID, []testFunc{{"A", 0, "foo"}, {"B", 4, "qux"}, {"C", 9, "foo"}}).Rows())
+	require.NoError(t, err)
+	require.NoError(t, s.db.QueryRow("SELECT COUNT(*) FROM references_ WHERE start_line IS NOT NULL").Scan(&full))
+	assert.Zero(t, full)
+	got, err = s.ReferencesByFile(f.ID)
+	require.NoError(t, err)
+	lines := map[string][]int{}
+	for _, r := range got {
+		lines[r.Name] = append(lines[r.Name], r.StartLine)
+	}
+	assert.ElementsMatch(t, []int{1, 10}, lines["foo"])
+	assert.Equal(t, []int{5}, lines["qux"])
+	assert.NotContains(t, lines, "bar")
+
+	require.NoError(t, s.DeleteFiles([]int64{f.ID}))
+	var blocks int
+	require.NoError(t, s.db.QueryRow("SELECT COUNT(*) FROM reference_blocks").Scan(&blocks))
+	assert.Zero(t, blocks)
+}
+
+func TestCompactReferences_ModePersists(t *testing.T) {
+	t.Parallel()
+	path := filepath.Join(t.TempDir(), "test.db")
+	s, err := NewStore(path, WithCompactReferences())
+	require.NoError(t, err)
+	require.NoError(t, s.Migrate())
+	require.NoError(t, s.Close())
+
+	// Reopened without the option, the database keeps writing blocks.
+	s, err = NewStore(path)
+	require.NoError(t, err)
+	require.NoError(t, s.Migrate())
+	assert.True(t, s.compactRefs)
+	f := insertTestFile(t, s, "/a.go", "go")
+	require.NoError(t, s.CommitBatch(extractFuncs(t, s, f.ID, []testFunc{{"A", 0, "foo"}})))
+	var blocks int
+	require.NoError(t, s.db.QueryRow("SELECT COUNT(*) FROM reference_blocks").Scan(&blocks))
+	assert.Equal(t, 1, blocks)
+	require.NoError(t, s.Close())
+
+	// So does a bulk load replacing it.
+	s, err = NewStore(path, WithBulkLoad())
+	require.NoError(t, err)
+	require.NoError(t, s.Migrate())
+	assert.True(t, s.compactRefs)
+	require.NoError(t, s.Publish())
+	require.NoError(t, s.Close())
+	s, err = NewStore(path)
+	require.NoError(t, err)
+	t.Cleanup(func() { s.Close() })
+	require.NoError(t, s.Migrate())
+	assert.True(t, s.compactRefs)
+
+	// A plain database stays plain.
+	assert.False(t, newTestStore(t).compactRefs)
+}
+
+func TestCompactRowReferences(t *testing.T) {
+	t.Parallel()
+	s, err := NewStore(filepath.Join(t.TempDir(), "test.db"), WithCompactReferences())
+	require.NoError(t, err)
+	require.NoError(t, s.Migrate())
+	t.Cleanup(func() { s.Close() })
+
+	// References written straight to SQLite, as a sequential bulk load does.
+	f := insertTestFile(t, s, "/a.go", "go")
+	for _, name := range []string{"foo", "bar"} {
+		_, err := s.InsertReference(&Reference{FileID: f.ID, Name: name, StartLine: 1, EndLine: 1, Context: "call"})
+		require.NoError(t, err)
+	}
+	want, err := s.ReferencesByFile(f.ID)
+	require.NoError(t, err)
+
+	require.NoError(t, s.CompactRowReferences())
+	var rows, blocks int
+	require.NoError(t, s.db.QueryRow("SELECT COUNT(*) FROM references_ WHERE start_line IS NOT NULL").Scan(&rows))
+	require.NoError(t, s.db.QueryRow("SELECT COUNT(*) FROM reference_blocks").Scan(&blocks))
+	assert.Zero(t, rows)
+	assert.Equal(t, 1, blocks)
+	got, err := s.ReferencesByFile(f.ID)
+	require.NoError(t, err)
+	assert.Equal(t, want, got)
+}
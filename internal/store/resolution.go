@@ -22,7 +22,7 @@ func (s *Store) InsertResolvedReference(rr *ResolvedReference) (int64, error) {
 }
 
 func (s *Store) queryResolvedRefs(query string, args ...any) ([]*ResolvedReference, error) {
-	rows, err := s.db.Query(query, args...)
+	rows, err := s.rdb.Query(query, args...)
 	if err != nil {
 		return nil, err
 	}
@@ -72,7 +72,7 @@ func (s *Store) InsertImplementation(impl *Implementation) (int64, error) {
 }
 
 func (s *Store) queryImplementations(query string, args ...any) ([]*Implementation, error) {
-	rows, err := s.db.Query(query, args...)
+	rows, err := s.rdb.Query(query, args...)
 	if err != nil {
 		return nil, err
 	}
@@ -119,11 +119,14 @@ func (s *Store) InsertCallEdge(edge *CallEdge) (int64, error) {
 		return 0, fmt.Errorf("last insert id: %w", err)
 	}
 	edge.ID = id
+	if _, err := s.db.Exec(invalidateCallGraphIndexSQL); err != nil {
+		return 0, fmt.Errorf("invalidate call graph index: %w", err)
+	}
 	return id, nil
 }
 
 func (s *Store) queryCallEdges(query string, args ...any) ([]*CallEdge, error) {
-	rows, err := s.db.Query(query, args...)
+	rows, err := s.rdb.Query(query, args...)
 	if err != nil {
 		return nil, err
 	}
@@ -179,7 +182,7 @@ func (s *Store) InsertReexport(re *Reexport) (int64, error) {
 }
 
 func (s *Store) ReexportsByFile(fileID int64) ([]*Reexport, error) {
-	rows, err := s.db.Query(
+	rows, err := s.rdb.Query(
 		"SELECT id, file_id, original_symbol_id, exported_name FROM reexports WHERE file_id = ?",
 		fileID,
 	)
@@ -219,7 +222,7 @@ func (s *Store) InsertExtensionBinding(eb *ExtensionBinding) (int64, error) {
 }
 
 func (s *Store) ExtensionBindingsByType(typeSymbolID int64) ([]*ExtensionBinding, error) {
-	rows, err := s.db.Query(
+	rows, err := s.rdb.Query(
 		`SELECT id, member_symbol_id, extended_type_expr, extended_type_symbol_id, kind, constraints, is_default_impl
 		 FROM extension_bindings WHERE extended_type_symbol_id = ?`,
 		typeSymbolID,
@@ -260,7 +263,7 @@ func (s *Store) InsertTypeComposition(tc *TypeComposition) (int64, error) {
 }
 
 func (s *Store) queryTypeCompositions(query string, args ...any) ([]*TypeComposition, error) {
-	rows, err := s.db.Query(query, args...)
+	rows, err := s.rdb.Query(query, args...)
 	if err != nil {
 		return nil, err
 	}
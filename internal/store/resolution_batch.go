@@ -0,0 +1,204 @@
+package store
+
+import (
+	"fmt"
+	"strings"
+	"sync"
+)
+
+// ResolutionBatch buffers resolution inserts (resolved references,
+// implementations, call edges, extension bindings) in memory and writes them
+// in large transactions. It is the resolution-side counterpart of
+// BatchedStore: resolution scripts never use the IDs of the rows they
+// insert, so rows can be deferred without remapping.
+//
+// Buffered rows are invisible to SQL until flushed. Callers that read the
+// resolution tables back (db_query) must call FlushIfReads first.
+//
+// Thread safety: all methods are safe for concurrent use. Flushes from every
+// ResolutionBatch on the same Store are serialized, so concurrent
+// resolution shards share a single writer instead of contending for
+// SQLite's write lock.
+type ResolutionBatch struct {
+	store *Store
+	limit int
+
+	mu       sync.Mutex
+	resolved []ResolvedReference
+	impls    []Implementation
+	edges    []CallEdge
+	bindings []ExtensionBinding
+}
+
+// DefaultResolutionBatchLimit is the number of buffered rows that triggers
+// an automatic flush.
+const DefaultResolutionBatchLimit = 20000
+
+// NewResolutionBatch creates a ResolutionBatch that writes to s, flushing
+// automatically once limit rows are buffered (limit <= 0 uses
+// DefaultResolutionBatchLimit).
+func NewResolutionBatch(s *Store, limit int) *ResolutionBatch {
+	if limit <= 0 {
+		limit = DefaultResolutionBatchLimit
+	}
+	return &ResolutionBatch{store: s, limit: limit}
+}
+
+var (
+	resolvedRefsTable = bulkTable{"resolved_references", []string{
+		"reference_id", "target_symbol_id", "confidence", "resolution_kind"}}
+	implementationsTable = bulkTable{"implementations", []string{
+		"type_symbol_id", "interface_symbol_id", "kind", "file_id", "declaring_module"}}
+	callGraphTable = bulkTable{"call_graph", []string{
+		"caller_symbol_id", "callee_symbol_id", "file_id", "line", "col"}}
+	extensionBindingsTable = bulkTable{"extension_bindings", []string{
+		"member_symbol_id", "extended_type_expr", "extended_type_symbol_id", "kind", "constraints", "is_default_impl"}}
+)
+
+// InsertResolvedReference buffers rr. The returned ID is always 0.
+func (b *ResolutionBatch) InsertResolvedReference(rr *ResolvedReference) (int64, error) {
+	b.mu.Lock()
+	defer b.mu.Unlock()
+	b.resolved = append(b.resolved, *rr)
+	return 0, b.maybeFlushLocked()
+}
+
+// InsertImplementation buffers impl. The returned ID is always 0.
+func (b *ResolutionBatch) InsertImplementation(impl *Implementation) (int64, error) {
+	b.mu.Lock()
+	defer b.mu.Unlock()
+	b.impls = append(b.impls, *impl)
+	return 0, b.maybeFlushLocked()
+}
+
+// InsertCallEdge buffers edge. The returned ID is always 0.
+func (b *ResolutionBatch) InsertCallEdge(edge *CallEdge) (int64, error) {
+	b.mu.Lock()
+	defer b.mu.Unlock()
+	b.edges = append(b.edges, *edge)
+	return 0, b.maybeFlushLocked()
+}
+
+// InsertExtensionBinding buffers eb. The returned ID is always 0.
+func (b *ResolutionBatch) InsertExtensionBinding(eb *ExtensionBinding) (int64, error) {
+	b.mu.Lock()
+	defer b.mu.Unlock()
+	b.bindings = append(b.bindings, *eb)
+	return 0, b.maybeFlushLocked()
+}
+
+// Pending returns the number of buffered rows.
+func (b *ResolutionBatch) Pending() int {
+	b.mu.Lock()
+	defer b.mu.Unlock()
+	return b.pendingLocked()
+}
+
+func (b *ResolutionBatch) pendingLocked() int {
+	return len(b.resolved) + len(b.impls) + len(b.edges) + len(b.bindings)
+}
+
+func (b *ResolutionBatch) maybeFlushLocked() error {
+	if b.pendingLocked() < b.limit {
+		return nil
+	}
+	return b.flushLocked()
+}
+
+// Flush writes all buffered rows in one transaction.
+func (b *ResolutionBatch) Flush() error {
+	b.mu.Lock()
+	defer b.mu.Unlock()
+	return b.flushLocked()
+}
+
+// FlushIfReads flushes the batch when query mentions a table that has
+// buffered rows, giving read-your-writes semantics for ad-hoc SQL without
+// flushing on every read.
+func (b *ResolutionBatch) FlushIfReads(query string) error {
+	b.mu.Lock()
+	defer b.mu.Unlock()
+	if b.pendingLocked() == 0 {
+		return nil
+	}
+	q := strings.ToLower(query)
+	for _, t := range []struct {
+		name    string
+		pending int
+	}{
+		{resolvedRefsTable.name, len(b.resolved)},
+		{implementationsTable.name, len(b.impls)},
+		{callGraphTable.name, len(b.edges)},
+		{extensionBindingsTable.name, len(b.bindings)},
+	} {
+		if t.pending > 0 && strings.Contains(q, t.name) {
+			return b.flushLocked()
+		}
+	}
+	return nil
+}
+
+func (b *ResolutionBatch) flushLocked() error {
+	if b.pendingLocked() == 0 {
+		return nil
+	}
+
+	b.store.resolutionWriteMu.Lock()
+	defer b.store.resolutionWriteMu.Unlock()
+
+	tx, err := b.store.db.Begin()
+	if err != nil {
+		return fmt.Errorf("flush resolution batch: begin: %w", err)
+	}
+	defer tx.Rollback()
+
+	w := newBatchWriter(tx)
+	defer w.close()
+
+	args := make([]any, 0, len(b.resolved)*len(resolvedRefsTable.cols))
+	for _, rr := range b.resolved {
+		args = append(args, rr.ReferenceID, rr.TargetSymbolID, rr.Confidence, rr.ResolutionKind)
+	}
+	if err := w.insertRows(resolvedRefsTable, args); err != nil {
+		return fmt.Errorf("flush resolution batch: resolved references: %w", err)
+	}
+
+	args = args[:0]
+	for _, impl := range b.impls {
+		args = append(args, impl.TypeSymbolID, impl.InterfaceSymbolID, impl.Kind, impl.FileID, impl.DeclaringModule)
+	}
+	if err := w.insertRows(implementationsTable, args); err != nil {
+		return fmt.Errorf("flush resolution batch: implementations: %w", err)
+	}
+
+	args = args[:0]
+	for _, edge := range b.edges {
+		args = append(args, edge.CallerSymbolID, edge.CalleeSymbolID, edge.FileID, edge.Line, edge.Col)
+	}
+	if err := w.insertRows(callGraphTable, args); err != nil {
+		return fmt.Errorf("flush resolution batch: call edges: %w", err)
+	}
+	if len(b.edges) > 0 {
+		if _, err := tx.Exec(invalidateCallGraphIndexSQL); err != nil {
+			return fmt.Errorf("flush resolution batch: %w", err)
+		}
+	}
+
+	args = args[:0]
+	for _, eb := range b.bindings {
+		args = append(args, eb.MemberSymbolID, eb.ExtendedTypeExpr, eb.ExtendedTypeSymbolID,
+			eb.Kind, eb.Constraints, eb.IsDefaultImpl)
+	}
+	if err := w.insertRows(extensionBindingsTable, args); err != nil {
+		return fmt.Errorf("flush resolution batch: extension bindings: %w", err)
+	}
+
+	if err := tx.Commit(); err != nil {
+		return fmt.Errorf("flush resolution batch: commit: %w", err)
+	}
+	b.resolved = b.resolved[:0]
+	b.impls = b.impls[:0]
+	b.edges = b.edges[:0]
+	b.bindings = b.bindings[:0]
+	return nil
+}
@@ -0,0 +1,69 @@
+package store
+
+import (
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func TestResolutionBatch_BuffersUntilFlush(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	f := insertTestFile(t, s, "/main.go", "go")
+	caller := insertTestSymbol(t, s, &f.ID, "Caller", "function")
+	callee := insertTestSymbol(t, s, &f.ID, "Callee", "function")
+	ref := &Reference{FileID: f.ID, Name: "Callee", Context: "call"}
+	_, err := s.InsertReference(ref)
+	require.NoError(t, err)
+
+	batch := NewResolutionBatch(s, 0)
+	_, err = batch.InsertResolvedReference(&ResolvedReference{
+		ReferenceID: ref.ID, TargetSymbolID: callee.ID, Confidence: 1, ResolutionKind: "direct",
+	})
+	require.NoError(t, err)
+	_, err = batch.InsertCallEdge(&CallEdge{CallerSymbolID: caller.ID, CalleeSymbolID: callee.ID, FileID: &f.ID, Line: 3})
+	require.NoError(t, err)
+	assert.Equal(t, 2, batch.Pending())
+
+	rrs, err := s.ResolvedReferencesByRef(ref.ID)
+	require.NoError(t, err)
+	assert.Empty(t, rrs, "buffered rows are not visible before a flush")
+
+	// A query that doesn't touch a buffered table leaves the batch alone.
+	require.NoError(t, batch.FlushIfReads("SELECT name FROM symbols WHERE id = ?"))
+	assert.Equal(t, 2, batch.Pending())
+
+	// Reading a buffered table flushes everything.
+	require.NoError(t, batch.FlushIfReads("SELECT target_symbol_id FROM resolved_references WHERE reference_id = ?"))
+	assert.Zero(t, batch.Pending())
+
+	rrs, err = s.ResolvedReferencesByRef(ref.ID)
+	require.NoError(t, err)
+	require.Len(t, rrs, 1)
+	assert.Equal(t, callee.ID, rrs[0].TargetSymbolID)
+
+	edges, err := s.CalleesByCaller(caller.ID)
+	require.NoError(t, err)
+	require.Len(t, edges, 1)
+	assert.Equal(t, 3, edges[0].Line)
+}
+
+func TestResolutionBatch_AutoFlushesAtLimit(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	f := insertTestFile(t, s, "/main.go", "go")
+	a := insertTestSymbol(t, s, &f.ID, "A", "function")
+	b := insertTestSymbol(t, s, &f.ID, "B", "function")
+
+	batch := NewResolutionBatch(s, 3)
+	for i := range 3 {
+		_, err := batch.InsertCallEdge(&CallEdge{CallerSymbolID: a.ID, CalleeSymbolID: b.ID, Line: i})
+		require.NoError(t, err)
+	}
+	assert.Zero(t, batch.Pending(), "reaching the limit should flush")
+
+	edges, err := s.CallersByCallee(b.ID)
+	require.NoError(t, err)
+	assert.Len(t, edges, 3)
+}
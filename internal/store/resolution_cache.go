@@ -0,0 +1,327 @@
+package store
+
+import (
+	"crypto/sha256"
+	"database/sql"
+	"encoding/hex"
+	"fmt"
+	"hash"
+	"sort"
+)
+
+// resolution_fingerprints holds, per file, a digest of the inputs its last
+// resolution read (see ResolutionFingerprints), so an incremental Resolve
+// can leave out a blast-radius file whose inputs have not changed. Rows go
+// with the file's resolution data: DeleteResolutionDataForFiles drops them,
+// deleting resolution rows that point at removed symbols drops the entries
+// of the files those rows came from, and triggers drop a file's entry when
+// its files row is deleted or its content hash changes.
+const resolutionFingerprintsDDL = `
+CREATE TABLE IF NOT EXISTS resolution_fingerprints (
+  file_id     INTEGER PRIMARY KEY,
+  fingerprint TEXT NOT NULL
+);
+
+CREATE TRIGGER IF NOT EXISTS trg_files_delete_fingerprints AFTER DELETE ON files BEGIN
+  DELETE FROM resolution_fingerprints WHERE file_id = OLD.id;
+END;
+CREATE TRIGGER IF NOT EXISTS trg_files_update_fingerprints AFTER UPDATE OF hash ON files
+WHEN NEW.hash IS NOT OLD.hash BEGIN
+  DELETE FROM resolution_fingerprints WHERE file_id = OLD.id;
+END;
+`
+
+// invalidateFingerprintsSQL drops the fingerprints of the files owning
+// resolution rows that point at the symbols in syms, a parenthesized ID
+// list or subquery. It runs before those rows are deleted: the files keep
+// their inputs but lose part of their resolution, so must be resolved again.
+func invalidateFingerprintsSQL(syms string) string {
+	return `DELETE FROM resolution_fingerprints WHERE file_id IN (
+		SELECT r.file_id FROM resolved_references rr JOIN references_ r ON r.id = rr.reference_id WHERE rr.target_symbol_id IN ` + syms + `
+		UNION SELECT file_id FROM call_graph WHERE callee_symbol_id IN ` + syms + `
+		UNION SELECT file_id FROM implementations WHERE type_symbol_id IN ` + syms + ` OR interface_symbol_id IN ` + syms + `
+		UNION SELECT file_id FROM reexports WHERE original_symbol_id IN ` + syms + `
+		UNION SELECT s.file_id FROM extension_bindings eb JOIN symbols s ON s.id = eb.member_symbol_id WHERE eb.extended_type_symbol_id IN ` + syms + `
+		UNION SELECT s.file_id FROM type_compositions tc JOIN symbols s ON s.id = tc.composite_symbol_id WHERE tc.component_symbol_id IN ` + syms + `
+	)`
+}
+
+// invalidateFingerprintsRefs is the number of times invalidateFingerprintsSQL
+// names its symbol list.
+const invalidateFingerprintsRefs = 7
+
+// ResolutionFingerprints computes the resolution fingerprint of each of
+// fileIDs that is indexed: a digest of what resolution scripts read to
+// resolve the file, beyond the file's own extraction (which its content
+// hash covers). That is its references (name, context, scope) and imports;
+// for every name it references or names as a type member, the ID, file,
+// kind, parent, visibility and signature hash of each symbol by that name;
+// the symbols of other files whose parent is one of its symbols; and the
+// interface symbols of its language, which structural interface matching
+// compares every type against. A file whose fingerprint is unchanged since
+// it was last resolved would resolve to the same rows.
+//
+// Files are fingerprinted blastChunk at a time, so only one chunk's rows
+// are held at once; the candidate digests of the names seen so far are
+// kept across chunks.
+func (s *Store) ResolutionFingerprints(fileIDs []int64) (map[int64]string, error) {
+	out := make(map[int64]string, len(fileIDs))
+	candidates := map[string]string{}
+	interfaces := map[string]string{}
+	for start := 0; start < len(fileIDs); start += blastChunk {
+		part := fileIDs[start:min(start+blastChunk, len(fileIDs))]
+		if err := s.fingerprintChunk(part, candidates, interfaces, out); err != nil {
+			return nil, err
+		}
+	}
+	return out, nil
+}
+
+// fingerprintChunk adds the fingerprints of fileIDs, at most blastChunk
+// files, to out. candidates and interfaces cache the digests by name and
+// by language.
+func (s *Store) fingerprintChunk(fileIDs []int64, candidates, interfaces map[string]string, out map[int64]string) error {
+	hashes := make(map[int64]hash.Hash, len(fileIDs))
+	langs := make(map[int64]string, len(fileIDs))
+	names := make(map[int64]map[string]bool, len(fileIDs))
+	addName := func(fid int64, name string) {
+		if names[fid] == nil {
+			names[fid] = map[string]bool{}
+		}
+		names[fid][name] = true
+	}
+
+	// The steps read one snapshot, so references match the blocks they are
+	// unpacked from. References are scanned whole and hashed once the
+	// compacted ones are filled in from their blocks.
+	tx, err := s.rdb.Begin()
+	if err != nil {
+		return fmt.Errorf("resolution fingerprints: %w", err)
+	}
+	defer tx.Rollback()
+	var refs []*Reference
+	steps := []struct {
+		query string
+		scan  func(*sql.Rows) error
+		after func() error
+	}{
+		{"SELECT id, language FROM files WHERE id IN (%s)", func(rows *sql.Rows) error {
+			var fid int64
+			var lang string
+			if err := rows.Scan(&fid, &lang); err != nil {
+				return err
+			}
+			langs[fid], hashes[fid] = lang, sha256.New()
+			fmt.Fprintf(hashes[fid], "language:%s\n", lang)
+			return nil
+		}, nil},
+		{"SELECT " + refCols + " FROM references_ WHERE file_id IN (%s) ORDER BY file_id, id", func(rows *sql.Rows) error {
+			r, err := s.scanReference(rows)
+			if err != nil {
+				return err
+			}
+			refs = append(refs, r)
+			return nil
+		}, func() error {
+			if err := unpackReferences(tx, refs); err != nil {
+				return err
+			}
+			for _, r := range refs {
+				fmt.Fprintf(hashes[r.FileID], "ref:%d:%s:%s:%d\n", r.ID, r.Name, r.Context, idOrNone(r.ScopeID))
+				addName(r.FileID, r.Name)
+			}
+			return nil
+		}},
+		{`SELECT file_id, source, COALESCE(imported_name, ''), COALESCE(local_alias, ''), COALESCE(kind, ''), COALESCE(scope, '')
+		  FROM imports WHERE file_id IN (%s) ORDER BY file_id, id`, func(rows *sql.Rows) error {
+			var fid int64
+			var source, imported, alias, kind, scope string
+			if err := rows.Scan(&fid, &source, &imported, &alias, &kind, &scope); err != nil {
+				return err
+			}
+			fmt.Fprintf(hashes[fid], "import:%s:%s:%s:%s:%s\n", source, imported, alias, kind, scope)
+			return nil
+		}, nil},
+		{`SELECT s.file_id, tm.name FROM type_members tm JOIN symbols s ON s.id = tm.symbol_id
+		  WHERE s.file_id IN (%s)`, func(rows *sql.Rows) error {
+			var fid int64
+			var name string
+			if err := rows.Scan(&fid, &name); err != nil {
+				return err
+			}
+			addName(fid, name)
+			return nil
+		}, nil},
+		{`SELECT p.file_id, c.id, c.name, c.kind FROM symbols c JOIN symbols p ON p.id = c.parent_symbol_id
+		  WHERE p.file_id IN (%s) AND c.file_id IS NOT p.file_id ORDER BY p.file_id, c.id`, func(rows *sql.Rows) error {
+			var fid, id int64
+			var name, kind string
+			if err := rows.Scan(&fid, &id, &name, &kind); err != nil {
+				return err
+			}
+			fmt.Fprintf(hashes[fid], "child:%d:%s:%s\n", id, name, kind)
+			return nil
+		}, nil},
+	}
+	q := placeholderList(len(fileIDs))
+	args := int64sToArgs(fileIDs)
+	for _, step := range steps {
+		if err := scanRowsIn(tx, fmt.Sprintf(step.query, q), args, step.scan); err != nil {
+			return fmt.Errorf("resolution fingerprints: %w", err)
+		}
+		if step.after != nil {
+			if err := step.after(); err != nil {
+				return fmt.Errorf("resolution fingerprints: %w", err)
+			}
+		}
+	}
+	// The digests below read through s.rdb, which may be the single
+	// connection the transaction holds.
+	tx.Rollback()
+
+	// Names without symbols are cached as "", the digest they hash with.
+	var missing []string
+	for _, set := range names {
+		for name := range set {
+			if _, ok := candidates[name]; !ok {
+				candidates[name] = ""
+				missing = append(missing, name)
+			}
+		}
+	}
+	found, err := s.candidateDigests(missing)
+	if err != nil {
+		return err
+	}
+	for name, digest := range found {
+		candidates[name] = digest
+	}
+	for _, lang := range langs {
+		if _, ok := interfaces[lang]; ok {
+			continue
+		}
+		if interfaces[lang], err = s.interfaceDigest(lang); err != nil {
+			return err
+		}
+	}
+
+	for fid, h := range hashes {
+		sorted := make([]string, 0, len(names[fid]))
+		for name := range names[fid] {
+			sorted = append(sorted, name)
+		}
+		sort.Strings(sorted)
+		for _, name := range sorted {
+			fmt.Fprintf(h, "name:%s:%s\n", name, candidates[name])
+		}
+		fmt.Fprintf(h, "interfaces:%s\n", interfaces[langs[fid]])
+		out[fid] = hex.EncodeToString(h.Sum(nil))
+	}
+	return nil
+}
+
+// candidateDigests returns, for each of names that any symbol has, a digest
+// of the symbols by that name.
+func (s *Store) candidateDigests(names []string) (map[string]string, error) {
+	hashes := make(map[string]hash.Hash, len(names))
+	for start := 0; start < len(names); start += blastChunk {
+		part := names[start:min(start+blastChunk, len(names))]
+		args := make([]any, len(part))
+		for i, n := range part {
+			args[i] = n
+		}
+		q := `SELECT name, id, COALESCE(file_id, 0), kind, COALESCE(parent_symbol_id, 0),
+		             COALESCE(visibility, ''), COALESCE(signature_hash, '')
+		      FROM symbols WHERE name IN (` + placeholderList(len(part)) + `) ORDER BY name, id`
+		err := s.scanRows(q, args, func(rows *sql.Rows) error {
+			var name, kind, vis, sig string
+			var id, fid, parent int64
+			if err := rows.Scan(&name, &id, &fid, &kind, &parent, &vis, &sig); err != nil {
+				return err
+			}
+			h := hashes[name]
+			if h == nil {
+				h = sha256.New()
+				hashes[name] = h
+			}
+			fmt.Fprintf(h, "%d:%d:%s:%d:%s:%s\n", id, fid, kind, parent, vis, sig)
+			return nil
+		})
+		if err != nil {
+			return nil, fmt.Errorf("resolution fingerprints: candidates: %w", err)
+		}
+	}
+	out := make(map[string]string, len(hashes))
+	for name, h := range hashes {
+		out[name] = hex.EncodeToString(h.Sum(nil))
+	}
+	return out, nil
+}
+
+// interfaceDigest returns a digest of the interface symbols of lang's files.
+func (s *Store) interfaceDigest(lang string) (string, error) {
+	h := sha256.New()
+	err := s.scanRows(
+		`SELECT s.id, COALESCE(s.signature_hash, '') FROM symbols s JOIN files f ON f.id = s.file_id
+		 WHERE s.kind = 'interface' AND f.language = ? ORDER BY s.id`,
+		[]any{lang}, func(rows *sql.Rows) error {
+			var id int64
+			var sig string
+			if err := rows.Scan(&id, &sig); err != nil {
+				return err
+			}
+			fmt.Fprintf(h, "%d:%s\n", id, sig)
+			return nil
+		})
+	if err != nil {
+		return "", fmt.Errorf("resolution fingerprints: interfaces: %w", err)
+	}
+	return hex.EncodeToString(h.Sum(nil)), nil
+}
+
+// StoredResolutionFingerprints returns the fingerprints recorded for those
+// of fileIDs that have one (see SetResolutionFingerprints).
+func (s *Store) StoredResolutionFingerprints(fileIDs []int64) (map[int64]string, error) {
+	out := make(map[int64]string, len(fileIDs))
+	for start := 0; start < len(fileIDs); start += blastChunk {
+		part := fileIDs[start:min(start+blastChunk, len(fileIDs))]
+		q := "SELECT file_id, fingerprint FROM resolution_fingerprints WHERE file_id IN (" + placeholderList(len(part)) + ")"
+		err := s.scanRows(q, int64sToArgs(part), func(rows *sql.Rows) error {
+			var fid int64
+			var fp string
+			if err := rows.Scan(&fid, &fp); err != nil {
+				return err
+			}
+			out[fid] = fp
+			return nil
+		})
+		if err != nil {
+			return nil, fmt.Errorf("stored resolution fingerprints: %w", err)
+		}
+	}
+	return out, nil
+}
+
+// SetResolutionFingerprints records fingerprints, by file ID, for files
+// that have just been resolved.
+func (s *Store) SetResolutionFingerprints(fingerprints map[int64]string) error {
+	if len(fingerprints) == 0 {
+		return nil
+	}
+	tx, err := s.db.Begin()
+	if err != nil {
+		return fmt.Errorf("set resolution fingerprints: %w", err)
+	}
+	defer tx.Rollback()
+	stmt, err := tx.Prepare("INSERT OR REPLACE INTO resolution_fingerprints (file_id, fingerprint) VALUES (?, ?)")
+	if err != nil {
+		return fmt.Errorf("set resolution fingerprints: %w", err)
+	}
+	defer stmt.Close()
+	for fid, fp := range fingerprints {
+		if _, err := stmt.Exec(fid, fp); err != nil {
+			return fmt.Errorf("set resolution fingerprints: %w", err)
+		}
+	}
+	return tx.Commit()
+}
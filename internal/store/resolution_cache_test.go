@@ -0,0 +1,69 @@
+package store
+
+import (
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func TestResolutionFingerprints_FollowCandidates(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	lib := insertTestFile(t, s, "/src/lib.go", "go")
+	helper := insertTestSymbol(t, s, &lib.ID, "ref", "function")
+	user := insertTestFile(t, s, "/src/user.go", "go")
+	insertResolvedRef(t, s, user.ID, helper.ID)
+	other := insertTestFile(t, s, "/src/other.go", "go")
+
+	fingerprint := func(fid int64) string {
+		fps, err := s.ResolutionFingerprints([]int64{fid})
+		require.NoError(t, err)
+		require.Contains(t, fps, fid)
+		return fps[fid]
+	}
+	before := fingerprint(user.ID)
+	assert.Equal(t, before, fingerprint(user.ID))
+	// A file's fingerprint does not depend on the files computed with it.
+	both, err := s.ResolutionFingerprints([]int64{lib.ID, user.ID, other.ID})
+	require.NoError(t, err)
+	assert.Equal(t, before, both[user.ID])
+
+	// A symbol named like one of user.go's references is a new candidate;
+	// one with another name is not.
+	insertTestSymbol(t, s, &other.ID, "unrelated", "function")
+	assert.Equal(t, before, fingerprint(user.ID))
+	insertTestSymbol(t, s, &other.ID, "ref", "method")
+	assert.NotEqual(t, before, fingerprint(user.ID))
+}
+
+func TestResolutionFingerprints_Invalidated(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	lib := insertTestFile(t, s, "/src/lib.go", "go")
+	helper := insertTestSymbol(t, s, &lib.ID, "Helper", "function")
+	user := insertTestFile(t, s, "/src/user.go", "go")
+	insertResolvedRef(t, s, user.ID, helper.ID)
+	edited := insertTestFile(t, s, "/src/edited.go", "go")
+	kept := insertTestFile(t, s, "/src/kept.go", "go")
+
+	require.NoError(t, s.SetResolutionFingerprints(map[int64]string{
+		lib.ID: "a", user.ID: "b", edited.ID: "c", kept.ID: "d",
+	}))
+	all := []int64{lib.ID, user.ID, edited.ID, kept.ID}
+
+	// Deleting the resolution pointing at Helper drops user.go's entry;
+	// a content change drops edited.go's.
+	require.NoError(t, s.DeleteResolutionDataForSymbols([]int64{helper.ID}))
+	_, err := s.db.Exec("UPDATE files SET hash = 'new' WHERE id = ?", edited.ID)
+	require.NoError(t, err)
+	stored, err := s.StoredResolutionFingerprints(all)
+	require.NoError(t, err)
+	assert.Equal(t, map[int64]string{lib.ID: "a", kept.ID: "d"}, stored)
+
+	require.NoError(t, s.DeleteResolutionDataForFiles([]int64{lib.ID}))
+	require.NoError(t, s.DeleteFiles([]int64{kept.ID}))
+	stored, err = s.StoredResolutionFingerprints(all)
+	require.NoError(t, err)
+	assert.Empty(t, stored)
+}
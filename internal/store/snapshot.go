@@ -0,0 +1,120 @@
+package store
+
+import (
+	"database/sql"
+	"fmt"
+)
+
+// LanguageSnapshot holds the extraction rows resolution scripts read for
+// every file of one language: its files, and their symbols, scopes,
+// references and imports grouped by file. It is loaded with one query per
+// table instead of one per table and file.
+type LanguageSnapshot struct {
+	Language string
+	Files    []*File
+
+	byFile map[int64]*FileSnapshot
+}
+
+// FileSnapshot is one file's rows in a LanguageSnapshot, each table in the
+// order its per-file query (SymbolsByFile, ScopesByFile, ...) returns them.
+type FileSnapshot struct {
+	Symbols    []*Symbol
+	Scopes     []*Scope
+	References []*Reference
+	Imports    []*Import
+}
+
+// emptyFileSnapshot stands in for files without rows.
+var emptyFileSnapshot = &FileSnapshot{}
+
+// File returns the rows of fileID; empty if it has none or is not in the
+// snapshot.
+func (sn *LanguageSnapshot) File(fileID int64) *FileSnapshot {
+	if fs, ok := sn.byFile[fileID]; ok {
+		return fs
+	}
+	return emptyFileSnapshot
+}
+
+// languageFiles selects the IDs of the snapshot's files. Each table is
+// read through its file_id index, so rows stream out grouped by file.
+const languageFiles = "(SELECT id FROM files WHERE language = ?)"
+
+// LanguageSnapshot loads the snapshot of language in one pass over each
+// table.
+func (s *Store) LanguageSnapshot(language string) (*LanguageSnapshot, error) {
+	files, err := s.FilesByLanguage(language)
+	if err != nil {
+		return nil, fmt.Errorf("language snapshot: %w", err)
+	}
+	sn := &LanguageSnapshot{Language: language, Files: files, byFile: make(map[int64]*FileSnapshot, len(files))}
+	for _, f := range files {
+		sn.byFile[f.ID] = &FileSnapshot{}
+	}
+
+	// One read transaction, so references match the blocks they are
+	// unpacked from even while another process re-indexes.
+	tx, err := s.rdb.Begin()
+	if err != nil {
+		return nil, fmt.Errorf("language snapshot: %w", err)
+	}
+	defer tx.Rollback()
+	err = streamByFile(tx, "SELECT "+SymbolCols+" FROM symbols WHERE file_id IN "+languageFiles+" ORDER BY file_id", language,
+		s.scanSymbol, func(sym *Symbol) int64 { return *sym.FileID },
+		func(fs *FileSnapshot, sym *Symbol) { fs.Symbols = append(fs.Symbols, sym) }, sn.byFile)
+	if err != nil {
+		return nil, fmt.Errorf("language snapshot: symbols: %w", err)
+	}
+	err = streamByFile(tx, "SELECT "+scopeCols+" FROM scopes WHERE file_id IN "+languageFiles+" ORDER BY file_id", language,
+		s.scanScope, func(sc *Scope) int64 { return sc.FileID },
+		func(fs *FileSnapshot, sc *Scope) { fs.Scopes = append(fs.Scopes, sc) }, sn.byFile)
+	if err != nil {
+		return nil, fmt.Errorf("language snapshot: scopes: %w", err)
+	}
+	err = streamByFile(tx, "SELECT "+refCols+" FROM references_ WHERE file_id IN "+languageFiles+" ORDER BY file_id", language,
+		s.scanReference, func(r *Reference) int64 { return r.FileID },
+		func(fs *FileSnapshot, r *Reference) { fs.References = append(fs.References, r) }, sn.byFile)
+	if err != nil {
+		return nil, fmt.Errorf("language snapshot: references: %w", err)
+	}
+	for _, fs := range sn.byFile {
+		if err := unpackReferences(tx, fs.References); err != nil {
+			return nil, fmt.Errorf("language snapshot: references: %w", err)
+		}
+	}
+	err = streamByFile(tx, "SELECT "+importCols+" FROM imports WHERE file_id IN "+languageFiles+" ORDER BY file_id", language,
+		scanImport, func(imp *Import) int64 { return imp.FileID },
+		func(fs *FileSnapshot, imp *Import) { fs.Imports = append(fs.Imports, imp) }, sn.byFile)
+	if err != nil {
+		return nil, fmt.Errorf("language snapshot: imports: %w", err)
+	}
+	return sn, nil
+}
+
+// streamByFile runs query for language and adds each scanned row to the
+// snapshot of the file it belongs to.
+func streamByFile[T any](tx *sql.Tx, query, language string,
+	scan func(interface{ Scan(...any) error }) (*T, error), fileOf func(*T) int64,
+	add func(*FileSnapshot, *T), byFile map[int64]*FileSnapshot) error {
+	rows, err := tx.Query(query, language)
+	if err != nil {
+		return err
+	}
+	defer rows.Close()
+	var cur *FileSnapshot
+	curID := int64(-1)
+	for rows.Next() {
+		row, err := scan(rows)
+		if err != nil {
+			return err
+		}
+		if fid := fileOf(row); fid != curID {
+			cur, curID = byFile[fid], fid
+		}
+		if cur != nil {
+			add(cur, row)
+		}
+	}
+	return rows.Err()
+}
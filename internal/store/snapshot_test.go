@@ -0,0 +1,76 @@
+package store
+
+import (
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func TestLanguageSnapshot_MatchesPerFileQueries(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	a := insertTestFile(t, s, "/a.c", "c")
+	other := insertTestFile(t, s, "/main.cpp", "cpp")
+	b := insertTestFile(t, s, "/b.c", "c")
+	empty := insertTestFile(t, s, "/empty.c", "c")
+
+	// Interleave the files' rows so each table has to be grouped.
+	for _, f := range []*File{b, a, other, b, a} {
+		insertTestSymbol(t, s, &f.ID, "sym", "function")
+		scopeID, err := s.InsertScope(&Scope{FileID: f.ID, Kind: "file", EndLine: 9})
+		require.NoError(t, err)
+		_, err = s.InsertReference(&Reference{FileID: f.ID, ScopeID: &scopeID, Name: "ref", Context: "call"})
+		require.NoError(t, err)
+		_, err = s.InsertImport(&Import{FileID: f.ID, Source: "stdio.h", Kind: "include"})
+		require.NoError(t, err)
+	}
+
+	sn, err := s.LanguageSnapshot("c")
+	require.NoError(t, err)
+	files, err := s.FilesByLanguage("c")
+	require.NoError(t, err)
+	assert.Equal(t, files, sn.Files)
+	for _, f := range files {
+		fs := sn.File(f.ID)
+		syms, err := s.SymbolsByFile(f.ID)
+		require.NoError(t, err)
+		assert.Equal(t, syms, fs.Symbols, f.Path)
+		scopes, err := s.ScopesByFile(f.ID)
+		require.NoError(t, err)
+		assert.Equal(t, scopes, fs.Scopes, f.Path)
+		refs, err := s.ReferencesByFile(f.ID)
+		require.NoError(t, err)
+		assert.Equal(t, refs, fs.References, f.Path)
+		imports, err := s.ImportsByFile(f.ID)
+		require.NoError(t, err)
+		assert.Equal(t, imports, fs.Imports, f.Path)
+	}
+	assert.Len(t, sn.File(a.ID).Symbols, 2)
+	assert.Empty(t, sn.File(empty.ID).Symbols)
+	assert.Empty(t, sn.File(other.ID).Symbols, "other languages are not loaded")
+}
+
+func TestReadCache_LanguageSnapshotSeedsPerFileReads(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	f := insertTestFile(t, s, "/a.c", "c")
+	insertTestSymbol(t, s, &f.ID, "main", "function")
+
+	c := NewReadCache(s)
+	sn, err := c.LanguageSnapshot("c")
+	require.NoError(t, err)
+	again, err := c.LanguageSnapshot("c")
+	require.NoError(t, err)
+	assert.Same(t, sn, again)
+
+	// Rows written after the snapshot are not seen: the per-file reads of
+	// the pass are served from it.
+	insertTestSymbol(t, s, &f.ID, "helper", "function")
+	syms, err := c.SymbolsByFile(f.ID)
+	require.NoError(t, err)
+	assert.Equal(t, sn.File(f.ID).Symbols, syms)
+	files, err := c.FilesByLanguage("c")
+	require.NoError(t, err)
+	assert.Equal(t, sn.Files, files)
+}
@@ -3,38 +3,291 @@ package store
 import (
 	"database/sql"
 	"fmt"
-
-	_ "github.com/mattn/go-sqlite3"
+	"os"
+	"runtime"
+	"strconv"
+	"strings"
+	"sync"
+	"time"
+
+	"github.com/mattn/go-sqlite3"
 )
 
-// Store is the SQLite data access layer for canopy's 17 tables.
+// Store is the SQLite data access layer for canopy's 17 tables, plus the
+// derived symbol_stats, symbol_trigrams, package graph and file dependency
+// tables.
+//
+// Writes go through db, a single connection whose transactions take the
+// write lock up front (BEGIN IMMEDIATE), so writers queue in-process
+// instead of failing with SQLITE_BUSY on lock upgrade. Reads go through
+// rdb, a pool of query-only connections that WAL lets run alongside the
+// writer. In-memory databases are per connection, so there both are the
+// same single connection.
 type Store struct {
-	db *sql.DB
+	db   *sql.DB
+	rdb  *sql.DB
+	path string
+
+	// resolutionWriteMu serializes ResolutionBatch flushes so concurrent
+	// resolution shards funnel through a single writer.
+	resolutionWriteMu sync.Mutex
+
+	// cg is the mapped call graph index for stamp cgStamp; cgMaps holds
+	// every mapping made so far (see CallGraphIndex).
+	cgMu    sync.Mutex
+	cg      *CallGraphIndex
+	cgStamp int64
+	cgMaps  [][]byte
+
+	// fg is the file dependency graph loaded for stamp fgStamp (see
+	// FileGraph), and ig the include graph for igStamp (see IncludeGraph).
+	fgMu    sync.Mutex
+	fg      *FileGraph
+	fgStamp string
+	ig      *FileGraph
+	igStamp string
+
+	// readConns sizes the read pool (see WithReadConns).
+	readConns int
+
+	// bulk is set while the Store loads a cold build (see WithBulkLoad):
+	// the writer runs without fsyncs or foreign key checks, and Migrate
+	// leaves the secondary indexes to BuildIndexes. publishPath is where
+	// Publish moves the build database; empty for in-memory databases.
+	bulk            bool
+	indexesDeferred bool
+	publishPath     string
+
+	// compactRefs writes references as per-file blocks (see
+	// WithCompactReferences).
+	compactRefs bool
+
+	// lock holds the database's lock file shared while it is open, so no
+	// other process renames a new database over it (see installDatabase);
+	// ident is the inode of the file open (see ReopenIfReplaced).
+	lock  *os.File
+	ident uint64
+}
+
+// Driver names for the connection roles; each runs its own pragmas on
+// every new connection.
+const (
+	writerDriver = "sqlite3_canopy_writer"
+	readerDriver = "sqlite3_canopy_reader"
+	bulkDriver   = "sqlite3_canopy_bulk"
+)
+
+// writerPragmas tune the write connection: NORMAL sync is durable across
+// application crashes in WAL mode and skips the fsync per commit, and the
+// larger page cache and memory-mapped I/O cut read syscalls while
+// extraction and resolution rewrite large tables.
+var writerPragmas = []string{
+	"PRAGMA synchronous = NORMAL",
+	"PRAGMA cache_size = -65536", // 64 MiB
+	"PRAGMA mmap_size = 268435456",
+	"PRAGMA temp_store = MEMORY",
+}
+
+// readerPragmas tune each read connection. query_only makes any write
+// through the read pool fail instead of contending for the write lock.
+var readerPragmas = []string{
+	"PRAGMA query_only = ON",
+	"PRAGMA cache_size = -16384", // 16 MiB
+	"PRAGMA mmap_size = 268435456",
 }
 
-// NewStore opens a SQLite database at dbPath with WAL mode enabled.
-func NewStore(dbPath string) (*Store, error) {
-	db, err := sql.Open("sqlite3", dbPath+"?_journal_mode=WAL&_foreign_keys=ON&_busy_timeout=30000")
+// bulkPragmas tune the write connection of a bulk load. Nothing is synced
+// until Publish, which is safe because the build database is discarded
+// rather than recovered after a crash.
+var bulkPragmas = []string{
+	"PRAGMA synchronous = OFF",
+	"PRAGMA cache_size = -262144", // 256 MiB
+	"PRAGMA mmap_size = 268435456",
+	"PRAGMA temp_store = MEMORY",
+}
+
+func init() {
+	for name, pragmas := range map[string][]string{writerDriver: writerPragmas, readerDriver: readerPragmas, bulkDriver: bulkPragmas} {
+		sql.Register(name, &sqlite3.SQLiteDriver{
+			ConnectHook: func(conn *sqlite3.SQLiteConn) error {
+				for _, p := range pragmas {
+					if _, err := conn.Exec(p, nil); err != nil {
+						return fmt.Errorf("%s: %w", p, err)
+					}
+				}
+				return nil
+			},
+		})
+	}
+}
+
+// StoreOption configures a Store.
+type StoreOption func(*storeConfig)
+
+type storeConfig struct {
+	readConns   int
+	bulk        bool
+	compactRefs bool
+}
+
+// WithReadConns sets the size of the read-only connection pool. n <= 0
+// keeps the default, one connection per CPU (at least 4).
+func WithReadConns(n int) StoreOption {
+	return func(c *storeConfig) {
+		if n > 0 {
+			c.readConns = n
+		}
+	}
+}
+
+// NewStore opens a SQLite database at dbPath with WAL mode enabled: one
+// write connection and a pool of read-only connections.
+func NewStore(dbPath string, opts ...StoreOption) (*Store, error) {
+	cfg := storeConfig{readConns: max(4, runtime.NumCPU())}
+	for _, opt := range opts {
+		opt(&cfg)
+	}
+
+	s := &Store{path: dbPath, readConns: cfg.readConns, bulk: cfg.bulk, compactRefs: cfg.compactRefs}
+	if cfg.bulk && !inMemoryPath(dbPath) {
+		// Leftovers of an interrupted build are never resumed.
+		s.path, s.publishPath = dbPath+buildSuffix, dbPath
+		// The rebuild keeps the reference storage of the database it replaces.
+		s.compactRefs = s.compactRefs || storedCompactReferences(dbPath)
+		if err := removeDatabaseFiles(s.path); err != nil {
+			return nil, fmt.Errorf("clear build database: %w", err)
+		}
+	}
+	if err := s.open(); err != nil {
+		return nil, err
+	}
+	return s, nil
+}
+
+// open opens the connection pools on s.path.
+func (s *Store) open() error {
+	if !s.bulk && !inMemoryPath(s.path) && s.lock == nil {
+		lock, err := lockFile(s.path+lockSuffix, false, true)
+		if err != nil {
+			return fmt.Errorf("lock database: %w", err)
+		}
+		s.lock = lock
+	}
+	driver, foreignKeys := writerDriver, "ON"
+	if s.bulk {
+		driver, foreignKeys = bulkDriver, "OFF"
+	}
+	db, err := sql.Open(driver, s.path+"?_journal_mode=WAL&_foreign_keys="+foreignKeys+"&_busy_timeout=30000&_txlock=immediate")
 	if err != nil {
-		return nil, fmt.Errorf("open database: %w", err)
+		return fmt.Errorf("open database: %w", err)
 	}
+	db.SetMaxOpenConns(1)
 	if err := db.Ping(); err != nil {
 		db.Close()
-		return nil, fmt.Errorf("ping database: %w", err)
+		return fmt.Errorf("ping database: %w", err)
+	}
+	s.db, s.rdb = db, db
+	if inMemoryPath(s.path) {
+		return nil
+	}
+
+	// The writer has created the file and switched it to WAL, which
+	// persists; readers only need foreign keys and the busy timeout.
+	rdb, err := sql.Open(readerDriver, s.path+"?_foreign_keys=ON&_busy_timeout=30000")
+	if err != nil {
+		db.Close()
+		return fmt.Errorf("open read pool: %w", err)
+	}
+	rdb.SetMaxOpenConns(s.readConns)
+	rdb.SetMaxIdleConns(s.readConns)
+	if err := rdb.Ping(); err != nil {
+		rdb.Close()
+		db.Close()
+		return fmt.Errorf("ping read pool: %w", err)
+	}
+	s.rdb = rdb
+	s.ident, _ = fileIdent(s.path)
+	return nil
+}
+
+// ReopenIfReplaced reopens the Store if the file at its path is no longer
+// the one it has open, as when a database was moved over it by a process
+// that does not take its lock file. It reports whether it reopened, and
+// must not run concurrently with other calls on s.
+func (s *Store) ReopenIfReplaced() (bool, error) {
+	if s.bulk || inMemoryPath(s.path) {
+		return false, nil
 	}
-	return &Store{db: db}, nil
+	ident, err := fileIdent(s.path)
+	if err != nil {
+		return false, fmt.Errorf("reopen: %w", err)
+	}
+	if ident == s.ident {
+		return false, nil
+	}
+	s.closeCallGraphIndex()
+	if err := s.closePools(); err != nil {
+		return false, fmt.Errorf("reopen: %w", err)
+	}
+	s.fgMu.Lock()
+	s.fg, s.fgStamp, s.ig, s.igStamp = nil, "", nil, ""
+	s.fgMu.Unlock()
+	if err := s.open(); err != nil {
+		return false, fmt.Errorf("reopen: %w", err)
+	}
+	return true, nil
+}
+
+// inMemoryPath reports whether dbPath names an in-memory database.
+func inMemoryPath(dbPath string) bool {
+	return dbPath == "" || dbPath == ":memory:" || strings.Contains(dbPath, "mode=memory")
 }
 
-// Close closes the underlying database connection.
+// Close closes the underlying database connections. A bulk load that was
+// never published is discarded.
 func (s *Store) Close() error {
-	return s.db.Close()
+	s.closeCallGraphIndex()
+	err := s.closePools()
+	if s.publishPath != "" {
+		if rerr := removeDatabaseFiles(s.path); err == nil {
+			err = rerr
+		}
+	}
+	if s.lock != nil {
+		s.lock.Close()
+		s.lock = nil
+	}
+	return err
+}
+
+func (s *Store) closePools() error {
+	var rerr error
+	if s.rdb != s.db {
+		rerr = s.rdb.Close()
+	}
+	if err := s.db.Close(); err != nil {
+		return err
+	}
+	return rerr
+}
+
+// Path returns the path of the database in use: the build database during
+// a bulk load, until Publish moves it to the path the Store was opened with.
+func (s *Store) Path() string {
+	return s.path
 }
 
-// DB returns the underlying *sql.DB for use in transactions.
+// DB returns the write connection, for use in transactions.
 func (s *Store) DB() *sql.DB {
 	return s.db
 }
 
+// ReadDB returns the read-only connection pool. Queries on it see every
+// committed write and never wait on the writer.
+func (s *Store) ReadDB() *sql.DB {
+	return s.rdb
+}
+
 // Migrate creates all 17 tables and indexes. Idempotent.
 func (s *Store) Migrate() error {
 	_, err := s.db.Exec(schemaDDL)
@@ -43,6 +296,49 @@ func (s *Store) Migrate() error {
 	}
 	// Idempotent column additions for existing databases.
 	s.db.Exec("ALTER TABLE files ADD COLUMN line_count INTEGER")
+	s.db.Exec("ALTER TABLE files ADD COLUMN size INTEGER")
+	s.db.Exec("ALTER TABLE files ADD COLUMN mtime INTEGER")
+	s.db.Exec("ALTER TABLE files ADD COLUMN inode INTEGER")
+	s.db.Exec("ALTER TABLE files ADD COLUMN line_lengths BLOB")
+	s.db.Exec("ALTER TABLE imports ADD COLUMN source_segment TEXT")
+	// Indexes on added columns can only be created once the column exists.
+	// A bulk load builds them after extraction instead (see BuildIndexes).
+	if s.bulk {
+		s.indexesDeferred = true
+	} else if _, err := s.db.Exec(schemaIndexDDL); err != nil {
+		return fmt.Errorf("migrate: %w", err)
+	}
+	// The (file_id, start_line, end_line) span indexes supersede the
+	// file_id-only indexes of older databases.
+	s.db.Exec("DROP INDEX IF EXISTS idx_symbols_file")
+	s.db.Exec("DROP INDEX IF EXISTS idx_scopes_file")
+	s.db.Exec("DROP INDEX IF EXISTS idx_references_file")
+	// Derived tables are built once for databases that predate them; from
+	// then on they are maintained incrementally.
+	for _, derived := range []struct {
+		key     string
+		rebuild func() error
+	}{
+		{symbolStatsKey, s.rebuildSymbolStats},
+		{symbolTrigramsKey, s.rebuildSymbolTrigrams},
+		{packageGraphKey, s.rebuildPackageGraph},
+		{importSegmentsKey, s.backfillImportSegments},
+		{fileDependenciesKey, s.rebuildFileDependencies},
+		{includeGraphKey, s.rebuildIncludeGraph},
+	} {
+		built, err := s.GetMetadata(derived.key)
+		if err != nil {
+			return fmt.Errorf("migrate: %w", err)
+		}
+		if built == "" {
+			if err := derived.rebuild(); err != nil {
+				return fmt.Errorf("migrate: %w", err)
+			}
+		}
+	}
+	if err := s.syncCompactReferences(); err != nil {
+		return fmt.Errorf("migrate: %w", err)
+	}
 	return nil
 }
 
@@ -55,7 +351,11 @@ CREATE TABLE IF NOT EXISTS files (
   language        TEXT NOT NULL,
   hash            TEXT,
   line_count      INTEGER,
-  last_indexed    TIMESTAMP
+  last_indexed    TIMESTAMP,
+  size            INTEGER,
+  mtime           INTEGER,
+  inode           INTEGER,
+  line_lengths    BLOB
 );
 
 CREATE TABLE IF NOT EXISTS symbols (
@@ -115,7 +415,8 @@ CREATE TABLE IF NOT EXISTS imports (
   imported_name   TEXT,
   local_alias     TEXT,
   kind            TEXT DEFAULT 'module',
-  scope           TEXT DEFAULT 'file'
+  scope           TEXT DEFAULT 'file',
+  source_segment  TEXT
 );
 
 CREATE TABLE IF NOT EXISTS type_members (
@@ -218,18 +519,24 @@ CREATE TABLE IF NOT EXISTS metadata (
   key   TEXT PRIMARY KEY,
   value TEXT NOT NULL
 );
+` + symbolStatsDDL + symbolTrigramsDDL + packageGraphDDL + fileDependenciesDDL + includeGraphDDL + fileTimeoutsDDL + resolutionFingerprintsDDL + referenceBlocksDDL
 
--- Indexes
-
+// schemaIndexDDL holds the secondary indexes on the extraction and
+// resolution tables. Migrate creates them after the column additions, since
+// idx_imports_segment covers an added column; a bulk load defers them to
+// BuildIndexes.
+const schemaIndexDDL = `
 CREATE INDEX IF NOT EXISTS idx_files_language ON files(language);
-CREATE INDEX IF NOT EXISTS idx_symbols_file ON symbols(file_id);
+CREATE INDEX IF NOT EXISTS idx_files_hash ON files(hash);
+CREATE INDEX IF NOT EXISTS idx_files_path_nocase ON files(path COLLATE NOCASE);
+CREATE INDEX IF NOT EXISTS idx_symbols_file_span ON symbols(file_id, start_line, end_line);
 CREATE INDEX IF NOT EXISTS idx_symbols_name ON symbols(name);
 CREATE INDEX IF NOT EXISTS idx_symbols_kind ON symbols(kind);
 CREATE INDEX IF NOT EXISTS idx_symbols_parent ON symbols(parent_symbol_id);
 CREATE INDEX IF NOT EXISTS idx_symbols_hash ON symbols(signature_hash);
-CREATE INDEX IF NOT EXISTS idx_scopes_file ON scopes(file_id);
+CREATE INDEX IF NOT EXISTS idx_scopes_file_span ON scopes(file_id, start_line, end_line);
 CREATE INDEX IF NOT EXISTS idx_scopes_parent ON scopes(parent_scope_id);
-CREATE INDEX IF NOT EXISTS idx_references_file ON references_(file_id);
+CREATE INDEX IF NOT EXISTS idx_references_file_span ON references_(file_id, start_line, end_line);
 CREATE INDEX IF NOT EXISTS idx_references_name ON references_(name);
 CREATE INDEX IF NOT EXISTS idx_references_scope ON references_(scope_id);
 CREATE INDEX IF NOT EXISTS idx_imports_file ON imports(file_id);
@@ -251,12 +558,13 @@ CREATE INDEX IF NOT EXISTS idx_extension_bindings_member ON extension_bindings(m
 CREATE INDEX IF NOT EXISTS idx_extension_bindings_type ON extension_bindings(extended_type_symbol_id);
 CREATE INDEX IF NOT EXISTS idx_type_compositions_composite ON type_compositions(composite_symbol_id);
 CREATE INDEX IF NOT EXISTS idx_type_compositions_component ON type_compositions(component_symbol_id);
+CREATE INDEX IF NOT EXISTS idx_imports_segment ON imports(source_segment);
 `
 
 // GetMetadata returns the value for a metadata key, or empty string if not found.
 func (s *Store) GetMetadata(key string) (string, error) {
 	var value string
-	err := s.db.QueryRow("SELECT value FROM metadata WHERE key = ?", key).Scan(&value)
+	err := s.rdb.QueryRow("SELECT value FROM metadata WHERE key = ?", key).Scan(&value)
 	if err == sql.ErrNoRows {
 		return "", nil
 	}
@@ -275,126 +583,159 @@ func (s *Store) SetMetadata(key, value string) error {
 	return nil
 }
 
+// indexGenerationKey names the metadata entry that changes whenever an
+// index/resolve cycle modifies the database.
+const indexGenerationKey = "index_generation"
+
+// IndexGeneration returns an opaque token that changes after every
+// index/resolve cycle that modified the database. Long-lived readers compare
+// it to decide when derived caches are stale.
+func (s *Store) IndexGeneration() (string, error) {
+	return s.GetMetadata(indexGenerationKey)
+}
+
+// BumpIndexGeneration records that the database contents have changed.
+func (s *Store) BumpIndexGeneration() error {
+	return s.SetMetadata(indexGenerationKey, strconv.FormatInt(time.Now().UnixNano(), 10))
+}
+
 // DeleteFileData transactionally removes all data for a file across all 16 tables.
 // Deletes in reverse-dependency order to respect FK constraints.
 func (s *Store) DeleteFileData(fileID int64) error {
+	return s.DeleteFilesData([]int64{fileID})
+}
+
+// DeleteFilesData removes all data for a set of files in one transaction.
+// The file IDs are staged in a temp table, along with the IDs of their
+// symbols and references, and each table is then cleared with a single
+// set-based DELETE, so the statement count is independent of how many
+// files change. File records themselves are kept; see DeleteFiles.
+func (s *Store) DeleteFilesData(fileIDs []int64) error {
+	return s.deleteFiles(fileIDs, false)
+}
+
+// DeleteFiles removes all data for a set of files and their files rows in
+// one transaction.
+func (s *Store) DeleteFiles(fileIDs []int64) error {
+	return s.deleteFiles(fileIDs, true)
+}
+
+// deleteStagingDDL creates the per-connection temp tables used to stage IDs
+// for set-based deletion. Temp tables are private to the connection running
+// the transaction, so concurrent deletions never see each other's rows.
+const deleteStagingDDL = `
+CREATE TEMP TABLE IF NOT EXISTS del_files (id INTEGER PRIMARY KEY);
+CREATE TEMP TABLE IF NOT EXISTS del_symbols (id INTEGER PRIMARY KEY);
+CREATE TEMP TABLE IF NOT EXISTS del_scopes (id INTEGER PRIMARY KEY);
+CREATE TEMP TABLE IF NOT EXISTS del_refs (id INTEGER PRIMARY KEY);
+DELETE FROM del_files;
+DELETE FROM del_symbols;
+DELETE FROM del_scopes;
+DELETE FROM del_refs;
+`
+
+// deleteStep is one set-based DELETE, with the label used to wrap its error.
+type deleteStep struct {
+	label string
+	query string
+}
+
+// resolutionDeleteSteps clears the resolution rows that point at the
+// staged symbols (syms) or references (refs).
+func resolutionDeleteSteps(syms, refs string) []deleteStep {
+	return []deleteStep{
+		// Files whose resolution points at these symbols must be resolved again.
+		{"invalidate resolution fingerprints", invalidateFingerprintsSQL(syms)},
+
+		// Resolution tables referencing these files' symbols.
+		{"delete resolution data for symbols", "DELETE FROM type_compositions WHERE composite_symbol_id IN " + syms + " OR component_symbol_id IN " + syms},
+		{"delete resolution data for symbols", "DELETE FROM extension_bindings WHERE member_symbol_id IN " + syms + " OR extended_type_symbol_id IN " + syms},
+		{"delete resolution data for symbols", "DELETE FROM reexports WHERE original_symbol_id IN " + syms},
+		{"delete resolution data for symbols", "DELETE FROM call_graph WHERE caller_symbol_id IN " + syms + " OR callee_symbol_id IN " + syms},
+		{"delete resolution data for symbols", "DELETE FROM implementations WHERE type_symbol_id IN " + syms + " OR interface_symbol_id IN " + syms},
+		{"delete resolution data for symbols", "DELETE FROM resolved_references WHERE target_symbol_id IN " + syms},
+
+		// resolved_references for these files' references.
+		{"delete resolved references by ref", "DELETE FROM resolved_references WHERE reference_id IN " + refs},
+	}
+}
+
+func (s *Store) deleteFiles(fileIDs []int64, removeRecords bool) error {
+	if len(fileIDs) == 0 {
+		return nil
+	}
 	tx, err := s.db.Begin()
 	if err != nil {
 		return fmt.Errorf("begin transaction: %w", err)
 	}
 	defer tx.Rollback()
 
-	// Get symbol IDs for this file (needed for child table cleanup).
-	rows, err := tx.Query("SELECT id FROM symbols WHERE file_id = ?", fileID)
-	if err != nil {
-		return fmt.Errorf("query symbols: %w", err)
-	}
-	var symbolIDs []int64
-	for rows.Next() {
-		var id int64
-		if err := rows.Scan(&id); err != nil {
-			rows.Close()
-			return fmt.Errorf("scan symbol id: %w", err)
-		}
-		symbolIDs = append(symbolIDs, id)
-	}
-	rows.Close()
-
-	// Get reference IDs for this file (needed for resolved_references cleanup).
-	rows, err = tx.Query("SELECT id FROM references_ WHERE file_id = ?", fileID)
-	if err != nil {
-		return fmt.Errorf("query references: %w", err)
-	}
-	var refIDs []int64
-	for rows.Next() {
-		var id int64
-		if err := rows.Scan(&id); err != nil {
-			rows.Close()
-			return fmt.Errorf("scan reference id: %w", err)
-		}
-		refIDs = append(refIDs, id)
-	}
-	rows.Close()
-
-	// Delete resolution tables referencing this file's symbols.
-	if len(symbolIDs) > 0 {
-		placeholders := placeholderList(len(symbolIDs))
-		args := int64sToArgs(symbolIDs)
-
-		for _, q := range []string{
-			"DELETE FROM type_compositions WHERE composite_symbol_id IN (" + placeholders + ") OR component_symbol_id IN (" + placeholders + ")",
-			"DELETE FROM extension_bindings WHERE member_symbol_id IN (" + placeholders + ") OR extended_type_symbol_id IN (" + placeholders + ")",
-			"DELETE FROM reexports WHERE original_symbol_id IN (" + placeholders + ")",
-			"DELETE FROM call_graph WHERE caller_symbol_id IN (" + placeholders + ") OR callee_symbol_id IN (" + placeholders + ")",
-			"DELETE FROM implementations WHERE type_symbol_id IN (" + placeholders + ") OR interface_symbol_id IN (" + placeholders + ")",
-			"DELETE FROM resolved_references WHERE target_symbol_id IN (" + placeholders + ")",
-		} {
-			// Count how many placeholder groups the query needs.
-			expandedArgs := args
-			count := countSubstring(q, "("+placeholders+")")
-			if count > 1 {
-				expandedArgs = repeatArgs(args, count)
-			}
-			if _, err := tx.Exec(q, expandedArgs...); err != nil {
-				return fmt.Errorf("delete resolution data for symbols: %w", err)
-			}
-		}
+	if _, err := tx.Exec(deleteStagingDDL); err != nil {
+		return fmt.Errorf("stage deletion: %w", err)
 	}
-
-	// Delete resolved_references referencing this file's references.
-	if len(refIDs) > 0 {
-		placeholders := placeholderList(len(refIDs))
-		args := int64sToArgs(refIDs)
-		if _, err := tx.Exec("DELETE FROM resolved_references WHERE reference_id IN ("+placeholders+")", args...); err != nil {
-			return fmt.Errorf("delete resolved references by ref: %w", err)
+	// Stage file IDs in chunks to stay under SQLite's bound-variable limit.
+	const chunk = 500
+	for start := 0; start < len(fileIDs); start += chunk {
+		ids := fileIDs[start:min(start+chunk, len(fileIDs))]
+		q := "INSERT OR IGNORE INTO del_files (id) VALUES " + strings.TrimSuffix(strings.Repeat("(?),", len(ids)), ",")
+		if _, err := tx.Exec(q, int64sToArgs(ids)...); err != nil {
+			return fmt.Errorf("stage file ids: %w", err)
 		}
 	}
-
-	// Delete resolution tables referencing this file directly.
+	// Symbol and reference IDs are needed for child and resolution cleanup.
 	for _, q := range []string{
-		"DELETE FROM reexports WHERE file_id = ?",
-		"DELETE FROM call_graph WHERE file_id = ?",
-		"DELETE FROM implementations WHERE file_id = ?",
+		"INSERT INTO del_symbols (id) SELECT id FROM symbols WHERE file_id IN (SELECT id FROM del_files)",
+		"INSERT INTO del_refs (id) SELECT id FROM references_ WHERE file_id IN (SELECT id FROM del_files)",
 	} {
-		if _, err := tx.Exec(q, fileID); err != nil {
-			return fmt.Errorf("delete resolution data for file: %w", err)
+		if _, err := tx.Exec(q); err != nil {
+			return fmt.Errorf("stage symbol/reference ids: %w", err)
 		}
 	}
 
-	// Delete extraction child tables for this file's symbols.
-	if len(symbolIDs) > 0 {
-		placeholders := placeholderList(len(symbolIDs))
-		args := int64sToArgs(symbolIDs)
-		for _, q := range []string{
-			"DELETE FROM annotations WHERE target_symbol_id IN (" + placeholders + ")",
-			"DELETE FROM type_parameters WHERE symbol_id IN (" + placeholders + ")",
-			"DELETE FROM function_parameters WHERE symbol_id IN (" + placeholders + ")",
-			"DELETE FROM type_members WHERE symbol_id IN (" + placeholders + ")",
-			"DELETE FROM symbol_fragments WHERE symbol_id IN (" + placeholders + ")",
-		} {
-			if _, err := tx.Exec(q, args...); err != nil {
-				return fmt.Errorf("delete extraction child data: %w", err)
-			}
-		}
+	const (
+		syms  = "(SELECT id FROM del_symbols)"
+		refs  = "(SELECT id FROM del_refs)"
+		files = "(SELECT id FROM del_files)"
+	)
+	steps := append(resolutionDeleteSteps(syms, refs),
+		// Resolution tables referencing these files directly.
+		deleteStep{"delete resolution data for file", "DELETE FROM reexports WHERE file_id IN " + files},
+		deleteStep{"delete resolution data for file", "DELETE FROM call_graph WHERE file_id IN " + files},
+		deleteStep{"delete resolution data for file", "DELETE FROM implementations WHERE file_id IN " + files},
+		deleteStep{"invalidate call graph index", invalidateCallGraphIndexSQL},
+		deleteStep{"delete file dependencies", "DELETE FROM file_dependencies WHERE file_id IN " + files},
+		deleteStep{"delete include edges", "DELETE FROM include_edges WHERE file_id IN " + files},
+
+		// Extraction child tables for these files' symbols.
+		deleteStep{"delete extraction child data", "DELETE FROM annotations WHERE target_symbol_id IN " + syms},
+		deleteStep{"delete extraction child data", "DELETE FROM type_parameters WHERE symbol_id IN " + syms},
+		deleteStep{"delete extraction child data", "DELETE FROM function_parameters WHERE symbol_id IN " + syms},
+		deleteStep{"delete extraction child data", "DELETE FROM type_members WHERE symbol_id IN " + syms},
+		deleteStep{"delete extraction child data", "DELETE FROM symbol_fragments WHERE symbol_id IN " + syms},
+		deleteStep{"delete extraction child data", "DELETE FROM symbol_trigrams WHERE symbol_id IN " + syms},
+
+		// symbol_fragments located in these files (from other symbols).
+		deleteStep{"delete symbol fragments by file", "DELETE FROM symbol_fragments WHERE file_id IN " + files},
+
+		// Extraction tables for these files.
+		deleteStep{"delete extraction data", "DELETE FROM references_ WHERE file_id IN " + files},
+		deleteStep{"delete extraction data", "DELETE FROM reference_blocks WHERE file_id IN " + files},
+		deleteStep{"delete extraction data", "DELETE FROM scopes WHERE file_id IN " + files},
+		deleteStep{"delete extraction data", "DELETE FROM imports WHERE file_id IN " + files},
+		deleteStep{"delete extraction data", "DELETE FROM symbols WHERE file_id IN " + files},
+		deleteStep{"delete extraction data", "DELETE FROM annotations WHERE file_id IN " + files},
+	)
+	if removeRecords {
+		steps = append(steps, deleteStep{"delete file records", "DELETE FROM files WHERE id IN " + files})
 	}
-
-	// Delete symbol_fragments by file_id (for fragments from other symbols located in this file).
-	if _, err := tx.Exec("DELETE FROM symbol_fragments WHERE file_id = ?", fileID); err != nil {
-		return fmt.Errorf("delete symbol fragments by file: %w", err)
-	}
-
-	// Delete extraction tables for this file.
-	for _, q := range []string{
-		"DELETE FROM references_ WHERE file_id = ?",
-		"DELETE FROM scopes WHERE file_id = ?",
-		"DELETE FROM imports WHERE file_id = ?",
-		"DELETE FROM symbols WHERE file_id = ?",
-		"DELETE FROM annotations WHERE file_id = ?",
-	} {
-		if _, err := tx.Exec(q, fileID); err != nil {
-			return fmt.Errorf("delete extraction data: %w", err)
+	for _, step := range steps {
+		if _, err := tx.Exec(step.query); err != nil {
+			return fmt.Errorf("%s: %w", step.label, err)
 		}
 	}
 
+	if _, err := tx.Exec("DELETE FROM del_files; DELETE FROM del_symbols; DELETE FROM del_refs"); err != nil {
+		return fmt.Errorf("clear deletion staging: %w", err)
+	}
 	return tx.Commit()
 }
@@ -60,7 +60,7 @@ func TestMigrate_AllTablesExist(t *testing.T) {
 		"files", "symbols", "symbol_fragments", "scopes", "references_",
 		"imports", "type_members", "function_parameters", "type_parameters", "annotations",
 		"resolved_references", "implementations", "call_graph", "reexports",
-		"extension_bindings", "type_compositions",
+		"extension_bindings", "type_compositions", "symbol_stats", "package_edges",
 	}
 
 	for _, table := range expectedTables {
@@ -89,6 +89,41 @@ func TestMigrate_WALMode(t *testing.T) {
 	assert.Equal(t, "wal", mode)
 }
 
+func TestNewStore_ConnectionRoles(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+
+	// Writes through the writer are visible to the read pool at once.
+	f := insertTestFile(t, s, "/a.go", "go")
+	got, err := s.FileByPath("/a.go")
+	require.NoError(t, err)
+	require.NotNil(t, got)
+	assert.Equal(t, f.ID, got.ID)
+
+	// The read pool is query-only, and each role runs its pragmas.
+	_, err = s.ReadDB().Exec("DELETE FROM files")
+	require.Error(t, err)
+	var sync int
+	require.NoError(t, s.DB().QueryRow("PRAGMA synchronous").Scan(&sync))
+	assert.Equal(t, 1, sync, "NORMAL")
+	var cache int
+	require.NoError(t, s.ReadDB().QueryRow("PRAGMA cache_size").Scan(&cache))
+	assert.Equal(t, -16384, cache)
+}
+
+func TestNewStore_InMemorySharesOneConnection(t *testing.T) {
+	t.Parallel()
+	s, err := NewStore(":memory:")
+	require.NoError(t, err)
+	defer s.Close()
+	require.NoError(t, s.Migrate())
+	assert.Same(t, s.DB(), s.ReadDB())
+	insertTestFile(t, s, "/a.go", "go")
+	files, err := s.AllFiles()
+	require.NoError(t, err)
+	assert.Len(t, files, 1)
+}
+
 // =============================================================================
 // File operations
 // =============================================================================
@@ -120,6 +155,27 @@ func TestFile_ByPathNotFound(t *testing.T) {
 	assert.Nil(t, got)
 }
 
+func TestFile_LineLength(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+
+	id, err := s.InsertFile(&File{Path: "/a.go", Language: "go", LineLengths: []uint32{12, 0, 70000}})
+	require.NoError(t, err)
+	for line, want := range map[int]int{0: 12, 1: 0, 2: 70000, 3: -1, -1: -1} {
+		n, known, err := s.LineLength(id, line)
+		require.NoError(t, err)
+		assert.True(t, known)
+		assert.Equal(t, want, n, "line %d", line)
+	}
+
+	// Rows written without line lengths report them as unknown.
+	legacy, err := s.InsertFile(&File{Path: "/b.go", Language: "go"})
+	require.NoError(t, err)
+	_, known, err := s.LineLength(legacy, 0)
+	require.NoError(t, err)
+	assert.False(t, known)
+}
+
 func TestFile_ByLanguage(t *testing.T) {
 	t.Parallel()
 	s := newTestStore(t)
@@ -333,6 +389,26 @@ func TestReference_InScope(t *testing.T) {
 	assert.Equal(t, "x", refs[0].Name)
 }
 
+func TestReferenceCountsByFile_OnlyListedFiles(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	a := insertTestFile(t, s, "/a.go", "go")
+	b := insertTestFile(t, s, "/b.go", "go")
+	empty := insertTestFile(t, s, "/empty.go", "go")
+	for range 3 {
+		s.InsertReference(&Reference{FileID: a.ID, Name: "x"})
+	}
+	s.InsertReference(&Reference{FileID: b.ID, Name: "y"})
+
+	counts, err := s.ReferenceCountsByFile([]int64{a.ID, empty.ID})
+	require.NoError(t, err)
+	assert.Equal(t, map[int64]int{a.ID: 3}, counts)
+
+	counts, err = s.ReferenceCountsByFile(nil)
+	require.NoError(t, err)
+	assert.Empty(t, counts)
+}
+
 // =============================================================================
 // Import operations
 // =============================================================================
@@ -736,6 +812,58 @@ func TestDeleteFileData_ReindexWithNewData(t *testing.T) {
 	assert.Equal(t, "NewFunc", syms[0].Name)
 }
 
+func TestDeleteFiles_RemovesOnlyTargetFiles(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	a := insertTestFile(t, s, "/a.go", "go")
+	b := insertTestFile(t, s, "/b.go", "go")
+	keep := insertTestFile(t, s, "/keep.go", "go")
+
+	symA := insertTestSymbol(t, s, &a.ID, "A", "function")
+	insertTestSymbol(t, s, &b.ID, "B", "function")
+	symKeep := insertTestSymbol(t, s, &keep.ID, "Keep", "function")
+	s.InsertTypeMember(&TypeMember{SymbolID: symA.ID, Name: "X", Kind: "field"})
+
+	// A reference in the surviving file resolved to a symbol being deleted.
+	ref := &Reference{FileID: keep.ID, Name: "A"}
+	s.InsertReference(ref)
+	s.InsertResolvedReference(&ResolvedReference{ReferenceID: ref.ID, TargetSymbolID: symA.ID, Confidence: 1.0, ResolutionKind: "direct"})
+	s.InsertCallEdge(&CallEdge{CallerSymbolID: symKeep.ID, CalleeSymbolID: symA.ID, FileID: &keep.ID})
+
+	require.NoError(t, s.DeleteFiles([]int64{a.ID, b.ID}))
+
+	for _, p := range []string{"/a.go", "/b.go"} {
+		f, err := s.FileByPath(p)
+		require.NoError(t, err)
+		assert.Nil(t, f, "file record %s should be removed", p)
+	}
+	members, err := s.TypeMembers(symA.ID)
+	require.NoError(t, err)
+	assert.Empty(t, members)
+
+	syms, err := s.SymbolsByFile(keep.ID)
+	require.NoError(t, err)
+	assert.Len(t, syms, 1)
+	refs, err := s.ReferencesByFile(keep.ID)
+	require.NoError(t, err)
+	assert.Len(t, refs, 1)
+
+	var n int
+	require.NoError(t, s.DB().QueryRow("SELECT COUNT(*) FROM resolved_references").Scan(&n))
+	assert.Zero(t, n)
+	require.NoError(t, s.DB().QueryRow("SELECT COUNT(*) FROM call_graph").Scan(&n))
+	assert.Zero(t, n)
+
+	// Staging tables are cleared, so a second call is unaffected by the first.
+	require.NoError(t, s.DeleteFilesData([]int64{keep.ID}))
+	syms, err = s.SymbolsByFile(keep.ID)
+	require.NoError(t, err)
+	assert.Empty(t, syms)
+	f, err := s.FileByPath("/keep.go")
+	require.NoError(t, err)
+	assert.NotNil(t, f, "DeleteFilesData keeps file records")
+}
+
 // =============================================================================
 // Signature Hash
 // =============================================================================
@@ -799,6 +927,54 @@ func TestSignatureHash_UnchangedSymbol(t *testing.T) {
 	assert.Equal(t, h1, h2)
 }
 
+func TestSignatureHash_StoredOnCommitAndUpdate(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+
+	// The same declaration written through a batch and straight to SQLite.
+	write := func(ds DataStore, fileID int64) {
+		symID, err := ds.InsertSymbol(&Symbol{FileID: &fileID, Name: "Run", Kind: "method", Visibility: "public", Modifiers: []string{"async"}})
+		require.NoError(t, err)
+		_, err = ds.InsertFunctionParam(&FunctionParam{SymbolID: symID, Name: "ctx", Ordinal: 0, TypeExpr: "Context"})
+		require.NoError(t, err)
+		_, err = ds.InsertTypeParam(&TypeParam{SymbolID: symID, Name: "T", Ordinal: 0})
+		require.NoError(t, err)
+		_, err = ds.InsertSymbol(&Symbol{FileID: &fileID, Name: "Server", Kind: "struct", Visibility: "public"})
+		require.NoError(t, err)
+	}
+	batched := insertTestFile(t, s, "/batched.go", "go")
+	batch := NewBatchedStore(s)
+	write(batch, batched.ID)
+	require.NoError(t, s.CommitBatch(batch))
+	direct := insertTestFile(t, s, "/direct.go", "go")
+	write(s, direct.ID)
+	require.NoError(t, s.UpdateSignatureHashes(direct.ID))
+
+	want := ComputeSignatureHash("Run", "method", "public", []string{"async"}, nil,
+		[]*FunctionParam{{Name: "ctx", Ordinal: 0, TypeExpr: "Context"}}, []*TypeParam{{Name: "T", Ordinal: 0}})
+	stored := func(fileID int64) []string {
+		syms, err := s.SymbolsByFile(fileID)
+		require.NoError(t, err)
+		hashes := make([]string, len(syms))
+		for i, sym := range syms {
+			hashes[i] = sym.SignatureHash
+		}
+		return hashes
+	}
+	hashes := stored(batched.ID)
+	require.Len(t, hashes, 2)
+	assert.Equal(t, want, hashes[0])
+	assert.Equal(t, ComputeSignatureHash("Server", "struct", "public", nil, nil, nil, nil), hashes[1])
+	assert.Equal(t, hashes, stored(direct.ID))
+
+	computed, err := s.SignatureHashes(direct.ID)
+	require.NoError(t, err)
+	assert.Len(t, computed, 2)
+	for _, h := range computed {
+		assert.Contains(t, hashes, h)
+	}
+}
+
 // =============================================================================
 // Blast radius methods
 // =============================================================================
@@ -825,6 +1001,20 @@ func TestFilesReferencingSymbols(t *testing.T) {
 	assert.ElementsMatch(t, []int64{fA.ID, fB.ID}, fileIDs)
 }
 
+func TestFilesReferencingSymbols_IncludesReexports(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	fC := insertTestFile(t, s, "/c.ts", "typescript")
+	symC := insertTestSymbol(t, s, &fC.ID, "Helper", "function")
+	fIndex := insertTestFile(t, s, "/index.ts", "typescript")
+	_, err := s.InsertReexport(&Reexport{FileID: fIndex.ID, OriginalSymbolID: symC.ID, ExportedName: "Helper"})
+	require.NoError(t, err)
+
+	fileIDs, err := s.FilesReferencingSymbols([]int64{symC.ID})
+	require.NoError(t, err)
+	assert.Equal(t, []int64{fIndex.ID}, fileIDs)
+}
+
 func TestFilesReferencingSymbols_NoReferences(t *testing.T) {
 	t.Parallel()
 	s := newTestStore(t)
@@ -851,6 +1041,48 @@ func TestFilesImportingSource(t *testing.T) {
 	assert.ElementsMatch(t, []int64{fA.ID, fB.ID}, fileIDs)
 }
 
+func TestFilesImportingPackages(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	fA := insertTestFile(t, s, "/a.go", "go")
+	fB := insertTestFile(t, s, "/b.go", "go")
+	fC := insertTestFile(t, s, "/c.go", "go")
+	fD := insertTestFile(t, s, "/d.go", "go")
+
+	s.InsertImport(&Import{FileID: fA.ID, Source: "foo", Kind: "module", Scope: "file"})
+	s.InsertImport(&Import{FileID: fB.ID, Source: "example.com/pkg/foo", Kind: "module", Scope: "file"})
+	s.InsertImport(&Import{FileID: fC.ID, Source: "example.com/foo/bar", Kind: "module", Scope: "file"})
+	batch := NewBatchedStore(s)
+	batch.InsertImport(&Import{FileID: fD.ID, Source: "other/foo", Kind: "module", Scope: "file"})
+	require.NoError(t, s.CommitBatch(batch))
+
+	fileIDs, err := s.FilesImportingPackages([]string{"foo"})
+	require.NoError(t, err)
+	assert.ElementsMatch(t, []int64{fA.ID, fB.ID, fD.ID}, fileIDs)
+
+	fileIDs, err = s.FilesImportingPackages([]string{"bar", "missing"})
+	require.NoError(t, err)
+	assert.Equal(t, []int64{fC.ID}, fileIDs)
+}
+
+func TestBackfillImportSegments(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	f := insertTestFile(t, s, "/a.go", "go")
+	// An import written before source_segment existed.
+	_, err := s.db.Exec("INSERT INTO imports (file_id, source) VALUES (?, 'example.com/foo')", f.ID)
+	require.NoError(t, err)
+
+	fileIDs, err := s.FilesImportingPackages([]string{"foo"})
+	require.NoError(t, err)
+	assert.Empty(t, fileIDs)
+
+	require.NoError(t, s.backfillImportSegments())
+	fileIDs, err = s.FilesImportingPackages([]string{"foo"})
+	require.NoError(t, err)
+	assert.Equal(t, []int64{f.ID}, fileIDs)
+}
+
 func TestDeleteResolutionDataForSymbols(t *testing.T) {
 	t.Parallel()
 	s := newTestStore(t)
@@ -0,0 +1,112 @@
+package store
+
+import (
+	"fmt"
+	"strings"
+)
+
+// symbol_stats holds per-symbol reference and call counts, so listing
+// queries can filter and sort on them through an index instead of running
+// correlated COUNT(*) subqueries per symbol. Rows exist only for symbols
+// with at least one resolved reference or call edge; a missing row means
+// all counts are zero.
+//
+// Triggers on resolved_references and call_graph record every symbol whose
+// counts may have changed in symbol_stats_dirty; RefreshSymbolStats
+// recomputes just those rows. Resolve refreshes at the end of every pass,
+// so the work is proportional to the blast radius.
+const symbolStatsDDL = `
+CREATE TABLE IF NOT EXISTS symbol_stats (
+  symbol_id          INTEGER PRIMARY KEY,
+  ref_count          INTEGER NOT NULL DEFAULT 0,
+  external_ref_count INTEGER NOT NULL DEFAULT 0,
+  caller_count       INTEGER NOT NULL DEFAULT 0,
+  callee_count       INTEGER NOT NULL DEFAULT 0
+);
+
+CREATE TABLE IF NOT EXISTS symbol_stats_dirty (
+  symbol_id INTEGER PRIMARY KEY
+);
+
+CREATE INDEX IF NOT EXISTS idx_symbol_stats_refs ON symbol_stats(ref_count);
+CREATE INDEX IF NOT EXISTS idx_symbol_stats_external_refs ON symbol_stats(external_ref_count);
+
+CREATE TRIGGER IF NOT EXISTS trg_resolved_refs_insert_stats AFTER INSERT ON resolved_references BEGIN
+  INSERT OR IGNORE INTO symbol_stats_dirty (symbol_id) VALUES (NEW.target_symbol_id);
+END;
+CREATE TRIGGER IF NOT EXISTS trg_resolved_refs_delete_stats AFTER DELETE ON resolved_references BEGIN
+  INSERT OR IGNORE INTO symbol_stats_dirty (symbol_id) VALUES (OLD.target_symbol_id);
+END;
+CREATE TRIGGER IF NOT EXISTS trg_call_graph_insert_stats AFTER INSERT ON call_graph BEGIN
+  INSERT OR IGNORE INTO symbol_stats_dirty (symbol_id) VALUES (NEW.caller_symbol_id), (NEW.callee_symbol_id);
+END;
+CREATE TRIGGER IF NOT EXISTS trg_call_graph_delete_stats AFTER DELETE ON call_graph BEGIN
+  INSERT OR IGNORE INTO symbol_stats_dirty (symbol_id) VALUES (OLD.caller_symbol_id), (OLD.callee_symbol_id);
+END;
+`
+
+// symbolStatsKey is the metadata entry recording that symbol_stats has been
+// built for this database.
+const symbolStatsKey = "symbol_stats"
+
+// symbolStatsSQL computes the stats rows of the symbols matched by %s, a
+// condition on s.id (or "1" for all symbols). The counts match the
+// correlated subqueries they replace: ref_count counts every resolved
+// reference to the symbol, external_ref_count those from other files, and
+// caller/callee_count the call_graph edges into and out of it.
+const symbolStatsSQL = `
+INSERT INTO symbol_stats (symbol_id, ref_count, external_ref_count, caller_count, callee_count)
+SELECT id, SUM(ref), SUM(ext), SUM(caller), SUM(callee) FROM (
+  SELECT s.id AS id, 1 AS ref, CASE WHEN r.file_id != s.file_id THEN 1 ELSE 0 END AS ext, 0 AS caller, 0 AS callee
+    FROM resolved_references rr
+    JOIN symbols s ON s.id = rr.target_symbol_id
+    LEFT JOIN references_ r ON r.id = rr.reference_id
+   WHERE %[1]s
+  UNION ALL
+  SELECT s.id, 0, 0, 1, 0 FROM call_graph cg JOIN symbols s ON s.id = cg.callee_symbol_id WHERE %[1]s
+  UNION ALL
+  SELECT s.id, 0, 0, 0, 1 FROM call_graph cg JOIN symbols s ON s.id = cg.caller_symbol_id WHERE %[1]s
+) GROUP BY id`
+
+const dirtySymbols = "(SELECT symbol_id FROM symbol_stats_dirty)"
+
+// RefreshSymbolStats recomputes the symbol_stats rows of every symbol whose
+// resolved references or call edges changed since the last refresh. Rows of
+// deleted symbols are dropped. It is a no-op when nothing changed.
+func (s *Store) RefreshSymbolStats() error {
+	var pending bool
+	if err := s.rdb.QueryRow("SELECT EXISTS (SELECT 1 FROM symbol_stats_dirty)").Scan(&pending); err != nil {
+		return fmt.Errorf("refresh symbol stats: %w", err)
+	}
+	if !pending {
+		return nil
+	}
+	return s.writeSymbolStats(
+		"DELETE FROM symbol_stats WHERE symbol_id IN "+dirtySymbols,
+		fmt.Sprintf(symbolStatsSQL, "s.id IN "+dirtySymbols),
+	)
+}
+
+// rebuildSymbolStats recomputes symbol_stats from scratch and marks it
+// built.
+func (s *Store) rebuildSymbolStats() error {
+	return s.writeSymbolStats(
+		"DELETE FROM symbol_stats",
+		fmt.Sprintf(symbolStatsSQL, "1"),
+		"INSERT OR REPLACE INTO metadata (key, value) VALUES ('"+symbolStatsKey+"', '1')",
+	)
+}
+
+func (s *Store) writeSymbolStats(stmts ...string) error {
+	tx, err := s.db.Begin()
+	if err != nil {
+		return fmt.Errorf("symbol stats: begin: %w", err)
+	}
+	defer tx.Rollback()
+	for _, q := range append(stmts, "DELETE FROM symbol_stats_dirty") {
+		if _, err := tx.Exec(q); err != nil {
+			return fmt.Errorf("symbol stats: %s: %w", strings.Fields(q)[0], err)
+		}
+	}
+	return tx.Commit()
+}
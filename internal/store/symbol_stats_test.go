@@ -0,0 +1,88 @@
+package store
+
+import (
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+type testStats struct{ refs, external, callers, callees int }
+
+func symbolStats(t *testing.T, s *Store, symbolID int64) (testStats, bool) {
+	t.Helper()
+	var st testStats
+	err := s.db.QueryRow(
+		"SELECT ref_count, external_ref_count, caller_count, callee_count FROM symbol_stats WHERE symbol_id = ?",
+		symbolID,
+	).Scan(&st.refs, &st.external, &st.callers, &st.callees)
+	if err != nil {
+		return testStats{}, false
+	}
+	return st, true
+}
+
+func TestRefreshSymbolStats_TracksResolutionChanges(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	a := insertTestFile(t, s, "/a.go", "go")
+	b := insertTestFile(t, s, "/b.go", "go")
+	target := insertTestSymbol(t, s, &a.ID, "Target", "function")
+	caller := insertTestSymbol(t, s, &b.ID, "Caller", "function")
+
+	for _, fileID := range []int64{a.ID, b.ID, b.ID} {
+		refID, err := s.InsertReference(&Reference{FileID: fileID, Name: "Target", Context: "call"})
+		require.NoError(t, err)
+		_, err = s.InsertResolvedReference(&ResolvedReference{ReferenceID: refID, TargetSymbolID: target.ID, Confidence: 1})
+		require.NoError(t, err)
+	}
+	_, err := s.InsertCallEdge(&CallEdge{CallerSymbolID: caller.ID, CalleeSymbolID: target.ID, FileID: &b.ID})
+	require.NoError(t, err)
+
+	require.NoError(t, s.RefreshSymbolStats())
+	st, ok := symbolStats(t, s, target.ID)
+	require.True(t, ok)
+	assert.Equal(t, testStats{refs: 3, external: 2, callers: 1}, st)
+	st, ok = symbolStats(t, s, caller.ID)
+	require.True(t, ok)
+	assert.Equal(t, testStats{callees: 1}, st)
+
+	// Dropping b.go's resolution data leaves only a.go's own reference.
+	require.NoError(t, s.DeleteResolutionDataForFiles([]int64{b.ID}))
+	require.NoError(t, s.RefreshSymbolStats())
+	st, ok = symbolStats(t, s, target.ID)
+	require.True(t, ok)
+	assert.Equal(t, testStats{refs: 1}, st)
+
+	// Deleting the target's file drops its row.
+	require.NoError(t, s.DeleteFiles([]int64{a.ID}))
+	require.NoError(t, s.RefreshSymbolStats())
+	_, ok = symbolStats(t, s, target.ID)
+	assert.False(t, ok)
+	_, ok = symbolStats(t, s, caller.ID)
+	assert.False(t, ok)
+}
+
+func TestRebuildSymbolStats_MatchesRefresh(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	a := insertTestFile(t, s, "/a.go", "go")
+	b := insertTestFile(t, s, "/b.go", "go")
+	target := insertTestSymbol(t, s, &a.ID, "Target", "function")
+	refID, err := s.InsertReference(&Reference{FileID: b.ID, Name: "Target", Context: "call"})
+	require.NoError(t, err)
+	_, err = s.InsertResolvedReference(&ResolvedReference{ReferenceID: refID, TargetSymbolID: target.ID, Confidence: 1})
+	require.NoError(t, err)
+
+	require.NoError(t, s.rebuildSymbolStats())
+	st, ok := symbolStats(t, s, target.ID)
+	require.True(t, ok)
+	assert.Equal(t, testStats{refs: 1, external: 1}, st)
+
+	built, err := s.GetMetadata(symbolStatsKey)
+	require.NoError(t, err)
+	assert.NotEmpty(t, built)
+	var dirty int
+	require.NoError(t, s.db.QueryRow("SELECT COUNT(*) FROM symbol_stats_dirty").Scan(&dirty))
+	assert.Zero(t, dirty)
+}
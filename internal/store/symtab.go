@@ -0,0 +1,207 @@
+package store
+
+import (
+	"hash/maphash"
+	"slices"
+	"sync"
+	"unsafe"
+)
+
+// symtabShards is the number of lock stripes in a SymbolTable's name
+// index; a power of two so a hash picks one with a mask.
+const symtabShards = 64
+
+// SymbolTable is the symbol index shared by the workers of one parallel
+// extraction run, so their cross-file lookups (SymbolsByName, SymbolsByFile)
+// see each other's files before they are committed, without going through
+// SQLite.
+//
+// Each worker publishes a file's symbols as soon as its extraction
+// finishes. Files of the run are hidden from the stored rows from the time
+// they are scheduled (Hide), so a lookup never returns both the stored and
+// the new version of a file. Rows stored before the run are queried once
+// per name or file and memoized; when the store held no symbols at all, as
+// in a cold build, they are not queried.
+//
+// Published symbols have ID 0 and no parent: their IDs are only assigned
+// when their batch is committed. Stored symbols are shared between callers
+// and must be treated as read-only.
+//
+// Thread safety: safe for concurrent use. The name index is striped
+// across symtabShards locks keyed by a hash of the name; each distinct
+// name is held once, as the key of its entry.
+type SymbolTable struct {
+	s      *Store
+	seed   maphash.Seed
+	shards [symtabShards]symtabShard
+
+	// stored is false when the store held no symbols as the run began.
+	stored      bool
+	storedNames memo[string, []*Symbol]
+	storedFiles memo[int64, []*Symbol]
+
+	mu     sync.RWMutex
+	files  map[int64]*publishedFile
+	hidden map[int64]bool
+}
+
+type symtabShard struct {
+	mu    sync.RWMutex
+	names map[string][]symbolRef
+}
+
+// publishedFile holds the symbol columns of one extracted file, with a
+// string table of its own holding only the strings they use: the batch's
+// table also holds those of its scopes and references, and is dropped with
+// the batch once committed.
+type publishedFile struct {
+	cols symbolColumns
+	strs strtab
+}
+
+type symbolRef struct {
+	file *publishedFile
+	i    int32
+}
+
+// NewSymbolTable creates an empty SymbolTable over s, for one extraction
+// run.
+func NewSymbolTable(s *Store) *SymbolTable {
+	var stored bool
+	if err := s.rdb.QueryRow("SELECT EXISTS (SELECT 1 FROM symbols)").Scan(&stored); err != nil {
+		stored = true // fall back to querying
+	}
+	t := &SymbolTable{
+		s:      s,
+		seed:   maphash.MakeSeed(),
+		stored: stored,
+		files:  make(map[int64]*publishedFile),
+		hidden: make(map[int64]bool),
+	}
+	for i := range t.shards {
+		t.shards[i].names = make(map[string][]symbolRef)
+	}
+	return t
+}
+
+// Hide drops the stored rows of files being extracted in this run from
+// lookups: their new symbols replace them once published.
+func (t *SymbolTable) Hide(fileIDs ...int64) {
+	t.mu.Lock()
+	defer t.mu.Unlock()
+	for _, fid := range fileIDs {
+		if fid != 0 {
+			t.hidden[fid] = true
+		}
+	}
+}
+
+// Publish adds the symbols buffered for fileID in b to the table. Call
+// once per file, after its extraction has finished. It returns a rough
+// count of the bytes the table holds for the file until the run ends.
+func (t *SymbolTable) Publish(fileID int64, b *BatchedStore) int64 {
+	pf := &publishedFile{}
+	src := &b.symbols
+	pf.cols.grow(countOf(src.fileID, fileID))
+	var byShard [symtabShards][]int32
+	for i, fid := range src.fileID {
+		if fid != fileID {
+			continue
+		}
+		j := int32(pf.cols.len())
+		pf.cols.id = append(pf.cols.id, noID)
+		pf.cols.fileID = append(pf.cols.fileID, fid)
+		pf.cols.parent = append(pf.cols.parent, noID)
+		pf.cols.name = append(pf.cols.name, pf.strs.intern(b.strs.str(src.name[i])))
+		pf.cols.kind = append(pf.cols.kind, pf.strs.intern(b.strs.str(src.kind[i])))
+		pf.cols.visibility = append(pf.cols.visibility, pf.strs.intern(b.strs.str(src.visibility[i])))
+		pf.cols.modifiers = append(pf.cols.modifiers, pf.strs.intern(b.strs.str(src.modifiers[i])))
+		pf.cols.sigHash = append(pf.cols.sigHash, pf.strs.intern(b.strs.str(src.sigHash[i])))
+		pf.cols.span.add(src.at(i))
+		shard := t.shardOf(pf.strs.str(pf.cols.name[j]))
+		byShard[shard] = append(byShard[shard], j)
+	}
+	pf.strs.ids = nil // only read from here on
+
+	for shard, refs := range byShard {
+		if len(refs) == 0 {
+			continue
+		}
+		sh := &t.shards[shard]
+		sh.mu.Lock()
+		for _, j := range refs {
+			name := pf.strs.str(pf.cols.name[j])
+			sh.names[name] = append(sh.names[name], symbolRef{pf, j})
+		}
+		sh.mu.Unlock()
+	}
+
+	t.mu.Lock()
+	t.files[fileID] = pf
+	t.mu.Unlock()
+	return int64(pf.cols.len())*(symbolRow+int64(unsafe.Sizeof(symbolRef{}))) +
+		pf.strs.size + int64(len(pf.strs.strs))*int64(unsafe.Sizeof(""))
+}
+
+// countOf returns the number of elements of ids equal to id.
+func countOf(ids []int64, id int64) int {
+	n := 0
+	for _, v := range ids {
+		if v == id {
+			n++
+		}
+	}
+	return n
+}
+
+func (t *SymbolTable) shardOf(name string) int {
+	return int(maphash.String(t.seed, name) & (symtabShards - 1))
+}
+
+// SymbolsByName returns the symbols named name: stored rows of files not
+// extracted in this run, then the published symbols.
+func (t *SymbolTable) SymbolsByName(name string) ([]*Symbol, error) {
+	var out []*Symbol
+	if t.stored {
+		rows, err := t.storedNames.get(name, t.s.SymbolsByName)
+		if err != nil {
+			return nil, err
+		}
+		t.mu.RLock()
+		out = slices.DeleteFunc(slices.Clone(rows), func(sym *Symbol) bool {
+			return sym.FileID != nil && t.hidden[*sym.FileID]
+		})
+		t.mu.RUnlock()
+	}
+	sh := &t.shards[t.shardOf(name)]
+	sh.mu.RLock()
+	refs := sh.names[name]
+	sh.mu.RUnlock()
+	for _, ref := range refs {
+		sym := ref.file.cols.row(&ref.file.strs, int(ref.i))
+		out = append(out, &sym)
+	}
+	return out, nil
+}
+
+// SymbolsByFile returns the symbols of fileID: its published symbols if
+// it was extracted in this run, none while it is still being extracted,
+// and its stored rows otherwise.
+func (t *SymbolTable) SymbolsByFile(fileID int64) ([]*Symbol, error) {
+	t.mu.RLock()
+	pf, hidden := t.files[fileID], t.hidden[fileID]
+	t.mu.RUnlock()
+	if pf == nil {
+		if hidden || !t.stored {
+			return nil, nil
+		}
+		rows, err := t.storedFiles.get(fileID, t.s.SymbolsByFile)
+		return slices.Clone(rows), err
+	}
+	out := make([]*Symbol, pf.cols.len())
+	for i := range out {
+		sym := pf.cols.row(&pf.strs, i)
+		out[i] = &sym
+	}
+	return out, nil
+}
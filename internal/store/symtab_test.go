@@ -0,0 +1,103 @@
+package store
+
+import (
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func symbolFiles(syms []*Symbol) []int64 {
+	var out []int64
+	for _, sym := range syms {
+		out = append(out, *sym.FileID)
+	}
+	return out
+}
+
+// extractInto buffers symbols named names for file f in a batch reading
+// through table, as a worker would.
+func extractInto(t *testing.T, s *Store, table *SymbolTable, f *File, names ...string) *BatchedStore {
+	t.Helper()
+	b := NewBatchedStore(s)
+	b.ReplaceFile(f.ID)
+	b.UseSymbolTable(table)
+	for _, name := range names {
+		_, err := b.InsertSymbol(&Symbol{FileID: &f.ID, Name: name, Kind: "function"})
+		require.NoError(t, err)
+	}
+	return b
+}
+
+func TestSymbolTable_SeesUncommittedFiles(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	kept := insertTestFile(t, s, "/kept.go", "go")
+	insertTestSymbol(t, s, &kept.ID, "Run", "function")
+	old := insertTestFile(t, s, "/old.go", "go")
+	insertTestSymbol(t, s, &old.ID, "Run", "function")
+
+	table := NewSymbolTable(s)
+	// old.go is re-extracted as a.go; b.go is new.
+	a := insertTestFile(t, s, "/a.go", "go")
+	b := insertTestFile(t, s, "/b.go", "go")
+	table.Hide(a.ID, old.ID, b.ID)
+
+	batchA := extractInto(t, s, table, a, "Run", "Helper")
+	table.Publish(a.ID, batchA)
+	batchB := extractInto(t, s, table, b, "Run")
+
+	syms, err := batchB.SymbolsByName("Run")
+	require.NoError(t, err)
+	assert.Equal(t, []int64{kept.ID, a.ID, b.ID}, symbolFiles(syms), "stored, published, then own")
+	assert.Zero(t, syms[1].ID, "published symbols have no ID yet")
+	assert.Negative(t, syms[2].ID)
+
+	syms, err = batchB.SymbolsByFile(a.ID)
+	require.NoError(t, err)
+	require.Len(t, syms, 2)
+	assert.Equal(t, "Helper", syms[1].Name)
+	syms, err = batchB.SymbolsByFile(old.ID)
+	require.NoError(t, err)
+	assert.Empty(t, syms, "replaced files are hidden")
+	syms, err = batchB.SymbolsByFile(kept.ID)
+	require.NoError(t, err)
+	assert.Len(t, syms, 1)
+}
+
+func TestSymbolTable_ColdStoreSkipsQueries(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	table := NewSymbolTable(s)
+
+	// Rows written after the table saw an empty store are never read.
+	f := insertTestFile(t, s, "/a.go", "go")
+	insertTestSymbol(t, s, &f.ID, "Run", "function")
+	syms, err := table.SymbolsByName("Run")
+	require.NoError(t, err)
+	assert.Empty(t, syms)
+
+	table.Hide(f.ID)
+	table.Publish(f.ID, extractInto(t, s, table, f, "Run"))
+	syms, err = table.SymbolsByName("Run")
+	require.NoError(t, err)
+	assert.Len(t, syms, 1)
+}
+
+func TestSymbolTable_PublishCopiesOnlySymbolStrings(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	table := NewSymbolTable(s)
+	f := insertTestFile(t, s, "/a.go", "go")
+	table.Hide(f.ID)
+	b := extractInto(t, s, table, f, "Run")
+	_, err := b.InsertReference(&Reference{FileID: f.ID, Name: "someLongReferencedName", Context: "call"})
+	require.NoError(t, err)
+
+	size := table.Publish(f.ID, b)
+	pf := table.files[f.ID]
+	assert.NotContains(t, pf.strs.strs, "someLongReferencedName")
+	assert.Contains(t, pf.strs.strs, "Run")
+	assert.Positive(t, size)
+	assert.Less(t, size, b.SizeEstimate())
+}
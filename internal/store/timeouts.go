@@ -0,0 +1,88 @@
+package store
+
+import (
+	"database/sql"
+	"fmt"
+	"time"
+)
+
+// file_timeouts lists the files whose extraction or resolution ran past the
+// Engine's per-file deadline, with the content hash they timed out at.
+// Indexing skips such a file until its content changes, and resolution
+// leaves it out. Triggers drop a file's entry when its files row is deleted
+// or its path or hash changes, so a file re-extracted with new content (or
+// removed from the tree) is no longer listed.
+const fileTimeoutsDDL = `
+CREATE TABLE IF NOT EXISTS file_timeouts (
+  path        TEXT PRIMARY KEY,
+  hash        TEXT NOT NULL,
+  phase       TEXT NOT NULL,
+  recorded_at TIMESTAMP
+) WITHOUT ROWID;
+
+CREATE TRIGGER IF NOT EXISTS trg_files_delete_timeouts AFTER DELETE ON files BEGIN
+  DELETE FROM file_timeouts WHERE path = OLD.path;
+END;
+CREATE TRIGGER IF NOT EXISTS trg_files_update_timeouts AFTER UPDATE OF path, hash ON files
+WHEN NEW.path IS NOT OLD.path OR NEW.hash IS NOT OLD.hash BEGIN
+  DELETE FROM file_timeouts WHERE path = OLD.path;
+END;
+`
+
+// FileTimeout is a file whose extraction or resolution exceeded the per-file
+// deadline. Phase is "extract" or "resolve".
+type FileTimeout struct {
+	Path       string
+	Hash       string
+	Phase      string
+	RecordedAt time.Time
+}
+
+// RecordFileTimeout records t, replacing any earlier entry for its path.
+func (s *Store) RecordFileTimeout(t FileTimeout) error {
+	_, err := s.db.Exec(
+		"INSERT OR REPLACE INTO file_timeouts (path, hash, phase, recorded_at) VALUES (?, ?, ?, ?)",
+		t.Path, t.Hash, t.Phase, t.RecordedAt,
+	)
+	if err != nil {
+		return fmt.Errorf("record file timeout: %w", err)
+	}
+	return nil
+}
+
+// FileTimeoutHash returns the content hash path timed out at, or "" if it
+// has no recorded timeout.
+func (s *Store) FileTimeoutHash(path string) (string, error) {
+	var hash string
+	err := s.rdb.QueryRow("SELECT hash FROM file_timeouts WHERE path = ?", path).Scan(&hash)
+	if err == sql.ErrNoRows {
+		return "", nil
+	}
+	if err != nil {
+		return "", fmt.Errorf("file timeout hash: %w", err)
+	}
+	return hash, nil
+}
+
+// FileTimeouts returns every recorded timeout, ordered by path.
+func (s *Store) FileTimeouts() ([]FileTimeout, error) {
+	rows, err := s.rdb.Query("SELECT path, hash, phase, recorded_at FROM file_timeouts ORDER BY path")
+	if err != nil {
+		return nil, fmt.Errorf("file timeouts: %w", err)
+	}
+	defer rows.Close()
+	var out []FileTimeout
+	for rows.Next() {
+		var t FileTimeout
+		var recorded sql.NullTime
+		if err := rows.Scan(&t.Path, &t.Hash, &t.Phase, &recorded); err != nil {
+			return nil, fmt.Errorf("file timeouts: %w", err)
+		}
+		t.RecordedAt = recorded.Time
+		out = append(out, t)
+	}
+	if err := rows.Err(); err != nil {
+		return nil, fmt.Errorf("file timeouts: %w", err)
+	}
+	return out, nil
+}
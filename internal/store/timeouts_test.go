@@ -0,0 +1,40 @@
+package store
+
+import (
+	"testing"
+	"time"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func TestFileTimeouts_DroppedWhenFileChanges(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	kept := insertTestFile(t, s, "/src/kept.js", "javascript")
+	deleted := insertTestFile(t, s, "/src/deleted.js", "javascript")
+	edited := insertTestFile(t, s, "/src/edited.js", "javascript")
+	for _, f := range []*File{kept, deleted, edited} {
+		require.NoError(t, s.RecordFileTimeout(FileTimeout{Path: f.Path, Hash: f.Hash, Phase: "extract", RecordedAt: time.Now()}))
+	}
+	require.NoError(t, s.RecordFileTimeout(FileTimeout{Path: kept.Path, Hash: kept.Hash, Phase: "resolve", RecordedAt: time.Now()}))
+
+	hash, err := s.FileTimeoutHash(kept.Path)
+	require.NoError(t, err)
+	assert.Equal(t, kept.Hash, hash)
+	hash, err = s.FileTimeoutHash("/src/never.js")
+	require.NoError(t, err)
+	assert.Empty(t, hash)
+
+	require.NoError(t, s.DeleteFiles([]int64{deleted.ID}))
+	_, err = s.db.Exec("UPDATE files SET hash = 'new' WHERE id = ?", edited.ID)
+	require.NoError(t, err)
+	// Stat-only updates leave the entry.
+	require.NoError(t, s.UpdateFileStat(kept.ID, 1, 2, 3, time.Now()))
+
+	timeouts, err := s.FileTimeouts()
+	require.NoError(t, err)
+	require.Len(t, timeouts, 1)
+	assert.Equal(t, kept.Path, timeouts[0].Path)
+	assert.Equal(t, "resolve", timeouts[0].Phase, "a later timeout replaces the entry")
+}
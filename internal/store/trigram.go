@@ -0,0 +1,120 @@
+package store
+
+import (
+	"database/sql"
+	"fmt"
+	"strings"
+)
+
+// symbol_trigrams indexes every symbol name by its three-byte substrings,
+// so a name search with a leading or inner wildcard can narrow candidates
+// to the symbols containing all of the pattern's trigrams instead of
+// scanning symbols with LIKE. Trigrams are ASCII-lowercased to match LIKE's
+// case folding; searches still apply LIKE to the candidates, so the index
+// only has to be a superset.
+//
+// The index is written alongside symbols by InsertSymbol and CommitBatch
+// and cleared with them by DeleteFiles and PatchFile.
+const symbolTrigramsDDL = `
+CREATE TABLE IF NOT EXISTS symbol_trigrams (
+  trigram   INTEGER NOT NULL,
+  symbol_id INTEGER NOT NULL,
+  PRIMARY KEY (trigram, symbol_id)
+) WITHOUT ROWID;
+`
+
+// symbolTrigramsKey is the metadata entry recording that symbol_trigrams
+// has been built for this database.
+const symbolTrigramsKey = "symbol_trigrams"
+
+var symbolTrigramsTable = bulkTable{"symbol_trigrams", []string{"trigram", "symbol_id"}}
+
+// Trigrams returns the distinct trigram keys of s, in order of first
+// occurrence. Strings shorter than three bytes have none.
+func Trigrams(s string) []int64 {
+	if len(s) < 3 {
+		return nil
+	}
+	out := make([]int64, 0, len(s)-2)
+	seen := make(map[int64]bool, len(s)-2)
+	for i := 0; i+3 <= len(s); i++ {
+		t := int64(lowerASCII(s[i]))<<16 | int64(lowerASCII(s[i+1]))<<8 | int64(lowerASCII(s[i+2]))
+		if !seen[t] {
+			seen[t] = true
+			out = append(out, t)
+		}
+	}
+	return out
+}
+
+func lowerASCII(c byte) byte {
+	if 'A' <= c && c <= 'Z' {
+		return c + 'a' - 'A'
+	}
+	return c
+}
+
+// appendTrigramRows appends the symbol_trigrams rows of one symbol to args.
+func appendTrigramRows(args []any, symbolID int64, name string) []any {
+	for _, t := range Trigrams(name) {
+		args = append(args, t, symbolID)
+	}
+	return args
+}
+
+// insertSymbolTrigrams indexes one symbol's name outside a batch.
+func (s *Store) insertSymbolTrigrams(symbolID int64, name string) error {
+	tris := Trigrams(name)
+	if len(tris) == 0 {
+		return nil
+	}
+	q := "INSERT OR IGNORE INTO symbol_trigrams (trigram, symbol_id) VALUES " +
+		strings.TrimSuffix(strings.Repeat("(?, ?),", len(tris)), ",")
+	_, err := s.db.Exec(q, appendTrigramRows(nil, symbolID, name)...)
+	return err
+}
+
+// rebuildSymbolTrigrams indexes every stored symbol from scratch and marks
+// the index built.
+func (s *Store) rebuildSymbolTrigrams() error {
+	tx, err := s.db.Begin()
+	if err != nil {
+		return fmt.Errorf("symbol trigrams: begin: %w", err)
+	}
+	defer tx.Rollback()
+	if _, err := tx.Exec("DELETE FROM symbol_trigrams"); err != nil {
+		return fmt.Errorf("symbol trigrams: clear: %w", err)
+	}
+
+	args, err := symbolTrigramRows(tx)
+	if err != nil {
+		return fmt.Errorf("symbol trigrams: %w", err)
+	}
+	w := newBatchWriter(tx)
+	defer w.close()
+	if err := w.insertRows(symbolTrigramsTable, args); err != nil {
+		return fmt.Errorf("symbol trigrams: insert: %w", err)
+	}
+	if _, err := tx.Exec("INSERT OR REPLACE INTO metadata (key, value) VALUES (?, '1')", symbolTrigramsKey); err != nil {
+		return fmt.Errorf("symbol trigrams: mark built: %w", err)
+	}
+	return tx.Commit()
+}
+
+func symbolTrigramRows(tx *sql.Tx) ([]any, error) {
+	rows, err := tx.Query("SELECT id, name FROM symbols")
+	if err != nil {
+		return nil, err
+	}
+	defer rows.Close()
+	var args []any
+	for rows.Next() {
+		var id int64
+		var name string
+		if err := rows.Scan(&id, &name); err != nil {
+			return nil, err
+		}
+		args = appendTrigramRows(args, id, name)
+	}
+	return args, rows.Err()
+}
@@ -0,0 +1,70 @@
+package store
+
+import (
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func TestTrigrams(t *testing.T) {
+	t.Parallel()
+	assert.Nil(t, Trigrams("ab"))
+	assert.Equal(t, Trigrams("abc"), Trigrams("ABC"), "ASCII is folded like LIKE does")
+	assert.Len(t, Trigrams("aaaa"), 1, "repeats are dropped")
+	assert.Len(t, Trigrams("Handler"), 5)
+}
+
+func trigramSymbols(t *testing.T, s *Store, sub string) []int64 {
+	t.Helper()
+	var ids []int64
+	for i, tri := range Trigrams(sub) {
+		rows, err := s.db.Query("SELECT symbol_id FROM symbol_trigrams WHERE trigram = ? ORDER BY symbol_id", tri)
+		require.NoError(t, err)
+		var got []int64
+		for rows.Next() {
+			var id int64
+			require.NoError(t, rows.Scan(&id))
+			got = append(got, id)
+		}
+		require.NoError(t, rows.Close())
+		if i == 0 {
+			ids = got
+			continue
+		}
+		var both []int64
+		for _, id := range ids {
+			for _, g := range got {
+				if id == g {
+					both = append(both, id)
+				}
+			}
+		}
+		ids = both
+	}
+	return ids
+}
+
+func TestSymbolTrigrams_MaintainedWithSymbols(t *testing.T) {
+	t.Parallel()
+	s := newTestStore(t)
+	a := insertTestFile(t, s, "/a.go", "go")
+	b := insertTestFile(t, s, "/b.go", "go")
+
+	direct := insertTestSymbol(t, s, &a.ID, "HTTPHandler", "struct")
+
+	batch := NewBatchedStore(s)
+	_, err := batch.InsertSymbol(&Symbol{FileID: &b.ID, Name: "eventHandler", Kind: "function"})
+	require.NoError(t, err)
+	require.NoError(t, s.CommitBatch(batch))
+	syms, err := s.SymbolsByFile(b.ID)
+	require.NoError(t, err)
+	require.Len(t, syms, 1)
+	batched := syms[0]
+
+	assert.ElementsMatch(t, []int64{direct.ID, batched.ID}, trigramSymbols(t, s, "handler"))
+	assert.Equal(t, []int64{direct.ID}, trigramSymbols(t, s, "http"))
+
+	require.NoError(t, s.DeleteFiles([]int64{a.ID}))
+	assert.Equal(t, []int64{batched.ID}, trigramSymbols(t, s, "handler"))
+}
@@ -11,6 +11,26 @@ type File struct {
 	Hash        string
 	LineCount   int
 	LastIndexed time.Time
+
+	// Stat tuple captured before the file was read, used to skip unchanged
+	// files without hashing. Zero when unknown (e.g. rows from older DBs).
+	Size    int64
+	ModTime int64 // Unix nanoseconds
+	Inode   int64
+
+	// LineLengths holds the byte length of every line (split on '\n',
+	// trailing '\r' excluded). Written by InsertFile and looked up with
+	// LineLength; not loaded by file queries.
+	LineLengths []uint32
+}
+
+// FileStat is a new stat tuple for an indexed file whose content is
+// unchanged (see UpdateFileStats).
+type FileStat struct {
+	FileID  int64
+	Size    int64
+	ModTime int64 // Unix nanoseconds
+	Inode   int64
 }
 
 type Symbol struct {
@@ -61,6 +81,10 @@ type Reference struct {
 	EndLine   int
 	EndCol    int
 	Context   string
+
+	// packed is set on a reference read from a slim row, whose columns
+	// live in its file's reference block (see WithCompactReferences).
+	packed bool
 }
 
 type Import struct {
@@ -0,0 +1,83 @@
+package canopy
+
+import "sync"
+
+// footprintPerSourceByte estimates the peak memory a file costs while it is
+// being extracted, per byte of source: the source itself, its tree-sitter
+// tree (typically around ten times the source size) and the rows buffered
+// for it. Deliberately generous; the budget only needs to be a bound.
+const footprintPerSourceByte = 16
+
+// memBudget caps the estimated bytes held by files in flight through the
+// parallel pipeline, from the moment they are read until their batch is
+// committed. A nil *memBudget imposes no limit.
+type memBudget struct {
+	mu    sync.Mutex
+	cond  *sync.Cond
+	limit int64
+	used  int64
+	// pinned is the part of used held until the run ends, such as the
+	// symbols published to the run's SymbolTable.
+	pinned int64
+}
+
+// newMemBudget returns a budget of limit bytes, or nil for limit <= 0.
+func newMemBudget(limit int64) *memBudget {
+	if limit <= 0 {
+		return nil
+	}
+	b := &memBudget{limit: limit}
+	b.cond = sync.NewCond(&b.mu)
+	return b
+}
+
+// acquire blocks until n bytes fit in the budget and returns the amount
+// actually reserved, which is what must later be released. Requests larger
+// than the whole budget are clamped to it, so a huge file still runs, just
+// alone; so does any file once pinned bytes leave no room for it.
+func (b *memBudget) acquire(n int64) int64 {
+	if b == nil {
+		return 0
+	}
+	n = min(max(n, 1), b.limit)
+	b.mu.Lock()
+	for b.used+n > b.limit && b.used > b.pinned {
+		b.cond.Wait()
+	}
+	b.used += n
+	b.mu.Unlock()
+	return n
+}
+
+// release returns n reserved bytes to the budget.
+func (b *memBudget) release(n int64) {
+	if b == nil || n <= 0 {
+		return
+	}
+	b.mu.Lock()
+	b.used -= n
+	b.mu.Unlock()
+	b.cond.Broadcast()
+}
+
+// pin charges n bytes to the budget for the rest of its life, without
+// waiting for room: they are already held.
+func (b *memBudget) pin(n int64) {
+	if b == nil || n <= 0 {
+		return
+	}
+	b.mu.Lock()
+	b.used += n
+	b.pinned += n
+	b.mu.Unlock()
+}
+
+// shrink lowers a reservation of *held bytes to n, releasing the rest; used
+// once a file's tree and source are dropped and only its rows remain.
+func (b *memBudget) shrink(held *int64, n int64) {
+	n = max(n, 0)
+	if n < *held {
+		b.release(*held - n)
+		*held = n
+	}
+}
@@ -12,12 +12,33 @@ import (
 // QueryBuilder provides a query API over the Store.
 type QueryBuilder struct {
 	store *store.Store
+
+	// derived caches whole-index structures between calls; nil disables
+	// caching (see WithDerivedCache).
+	derived *derivedCache
+}
+
+// QueryOption configures a QueryBuilder.
+type QueryOption func(*QueryBuilder)
+
+// WithDerivedCache keeps structures derived from the whole index (the
+// package dependency graph and the FuzzySearch name table) resident between
+// calls. Cached values are dropped whenever the index generation changes,
+// i.e. after every Resolve that did work. Intended for long-lived processes such as `canopy serve`.
+func WithDerivedCache() QueryOption {
+	return func(q *QueryBuilder) {
+		q.derived = &derivedCache{}
+	}
 }
 
 // NewQueryBuilder creates a QueryBuilder from a Store.
 // Used by the CLI for query commands that don't need the Engine.
-func NewQueryBuilder(s *store.Store) *QueryBuilder {
-	return &QueryBuilder{store: s}
+func NewQueryBuilder(s *store.Store, opts ...QueryOption) *QueryBuilder {
+	q := &QueryBuilder{store: s}
+	for _, opt := range opts {
+		opt(q)
+	}
+	return q
 }
 
 // Location represents a source code position range.
@@ -42,29 +63,32 @@ func (q *QueryBuilder) SymbolAt(file string, line, col int) (*Symbol, error) {
 		return nil, nil
 	}
 
-	// Validate line/col against actual file content if available.
+	// Validate line/col against the line lengths recorded at index time.
 	// Without this, multi-line symbols match any column on their start line
 	// because the SQL only checks start_col <= col (with no upper bound).
-	if content, err := os.ReadFile(file); err == nil {
-		fileLines := bytes.Split(content, []byte{'\n'})
-		if line >= len(fileLines) {
-			return nil, nil
-		}
-		lineContent := bytes.TrimRight(fileLines[line], "\r")
-		if col >= len(lineContent) {
-			return nil, nil
-		}
+	lineLen, known, err := q.store.LineLength(f.ID, line)
+	if err != nil {
+		return nil, fmt.Errorf("symbol at: %w", err)
+	}
+	if !known {
+		// Indexed before line lengths were recorded; fall back to the file.
+		lineLen, known = lineLengthOnDisk(file, line)
+	}
+	if known && col >= lineLen {
+		return nil, nil
 	}
 
-	// Find all symbols containing this position, ordered by span size (narrowest first).
-	row := q.store.DB().QueryRow(
+	// Find all symbols containing this position, ordered by span size
+	// (narrowest first). The redundant start_line/end_line bounds let
+	// SQLite range-scan the (file_id, start_line, end_line) index.
+	row := q.store.ReadDB().QueryRow(
 		`SELECT `+store.SymbolCols+` FROM symbols
-		 WHERE file_id = ?
+		 WHERE file_id = ? AND start_line <= ? AND end_line >= ?
 		   AND (start_line < ? OR (start_line = ? AND start_col <= ?))
 		   AND (end_line > ? OR (end_line = ? AND end_col >= ?))
 		 ORDER BY (end_line - start_line) ASC, (end_col - start_col) ASC
 		 LIMIT 1`,
-		f.ID,
+		f.ID, line, line,
 		line, line, col,
 		line, line, col,
 	)
@@ -79,6 +103,20 @@ func (q *QueryBuilder) SymbolAt(file string, line, col int) (*Symbol, error) {
 	return sym, nil
 }
 
+// lineLengthOnDisk reads line's length from the file itself (-1 if the file
+// has no such line). known is false if the file cannot be read.
+func lineLengthOnDisk(file string, line int) (length int, known bool) {
+	content, err := os.ReadFile(file)
+	if err != nil {
+		return 0, false
+	}
+	fileLines := bytes.Split(content, []byte{'\n'})
+	if line < 0 || line >= len(fileLines) {
+		return -1, true
+	}
+	return len(bytes.TrimRight(fileLines[line], "\r")), true
+}
+
 // DefinitionAt finds the definition(s) of the symbol referenced at the given position.
 // Line and col are 0-based (tree-sitter convention). It looks up references at
 // (file, line, col), resolves them, and returns the target symbol locations.
@@ -91,8 +129,10 @@ func (q *QueryBuilder) DefinitionAt(file string, line, col int) ([]Location, err
 		return nil, nil
 	}
 
-	// Find references at this position: the position must fall within the reference span.
-	rows, err := q.store.DB().Query(
+	// Find references at this position: the position must fall within the
+	// reference span. start_line/end_line bound the (file_id, start_line,
+	// end_line) index range.
+	rows, err := q.store.ReadDB().Query(
 		`SELECT id FROM references_
 		 WHERE file_id = ? AND start_line <= ? AND end_line >= ?
 		   AND (start_line < ? OR (start_line = ? AND start_col <= ?))
@@ -117,6 +157,16 @@ func (q *QueryBuilder) DefinitionAt(file string, line, col int) ([]Location, err
 	if err := rows.Err(); err != nil {
 		return nil, fmt.Errorf("definition at: rows: %w", err)
 	}
+	rows.Close()
+
+	// References of a compacted file are matched in its block.
+	block, err := store.LoadReferenceBlock(q.store.ReadDB(), f.ID)
+	if err != nil {
+		return nil, fmt.Errorf("definition at: %w", err)
+	}
+	if block != nil {
+		refIDs = append(refIDs, block.IDsAt(line, col)...)
+	}
 
 	var locations []Location
 	for _, refID := range refIDs {
@@ -144,9 +194,17 @@ func (q *QueryBuilder) ReferencesTo(symbolID int64) ([]Location, error) {
 		return nil, fmt.Errorf("references to: %w", err)
 	}
 
+	// Rows and the blocks they point into are read in one transaction, so a
+	// concurrent re-index can't re-pack a file in between.
+	tx, err := q.store.ReadDB().Begin()
+	if err != nil {
+		return nil, fmt.Errorf("references to: %w", err)
+	}
+	defer tx.Rollback()
 	var locations []Location
+	blocks := store.NewReferenceBlocks(tx)
 	for _, rr := range resolved {
-		loc, err := q.referenceLocation(rr.ReferenceID)
+		loc, err := referenceLocation(tx, rr.ReferenceID, blocks)
 		if err != nil {
 			return nil, fmt.Errorf("references to: ref location: %w", err)
 		}
@@ -157,6 +215,83 @@ func (q *QueryBuilder) ReferencesTo(symbolID int64) ([]Location, error) {
 	return locations, nil
 }
 
+// ReferencesToPage is ReferencesTo one page at a time, in resolution
+// order, for symbols with more references than fit in memory at once.
+// Pages are joined and counted in SQL, and a cursor page seeks through
+// the target index from the last reference of the one before. Each page
+// is read in one transaction, with the reference blocks it needs.
+func (q *QueryBuilder) ReferencesToPage(symbolID int64, page Pagination) (*PagedResult[Location], error) {
+	page = page.normalize()
+	const order = "rr.id ASC"
+	cur, err := decodeCursor(page.Cursor, order)
+	if err != nil {
+		return nil, fmt.Errorf("references to: %w", err)
+	}
+	tx, err := q.store.ReadDB().Begin()
+	if err != nil {
+		return nil, fmt.Errorf("references to: %w", err)
+	}
+	defer tx.Rollback()
+
+	const from = `FROM resolved_references rr
+		 JOIN references_ r ON r.id = rr.reference_id
+		 JOIN files f ON f.id = r.file_id
+		 WHERE rr.target_symbol_id = ?`
+	var totalCount int
+	if cur != nil {
+		totalCount = cur.Total
+	} else if err := tx.QueryRow("SELECT COUNT(*) "+from, symbolID).Scan(&totalCount); err != nil {
+		return nil, fmt.Errorf("references to: count: %w", err)
+	}
+
+	orderBy, cond, condArgs := keyset("rr.id", "rr.id", "ASC", cur)
+	where := ""
+	if cond != "" {
+		where = " AND " + cond
+	}
+	limit, offset := pageWindow(page, cur)
+	args := append(append([]any{symbolID}, condArgs...), limit, offset)
+	rows, err := tx.Query(
+		`SELECT rr.id, f.path, r.id, r.file_id, r.start_line, r.start_col, r.end_line, r.end_col `+from+where+` `+orderBy+` LIMIT ? OFFSET ?`,
+		args...,
+	)
+	if err != nil {
+		return nil, fmt.Errorf("references to: query: %w", err)
+	}
+	defer rows.Close()
+
+	type ref struct {
+		id   int64
+		loc  Location
+		span refSpan
+	}
+	var refs []ref
+	for rows.Next() {
+		var r ref
+		if err := rows.Scan(append([]any{&r.id, &r.loc.File}, r.span.dest()...)...); err != nil {
+			return nil, fmt.Errorf("references to: scan: %w", err)
+		}
+		refs = append(refs, r)
+	}
+	if err := rows.Err(); err != nil {
+		return nil, fmt.Errorf("references to: rows: %w", err)
+	}
+	rows.Close()
+	blocks := store.NewReferenceBlocks(tx)
+	for i := range refs {
+		if err := refs[i].span.fill(&refs[i].loc, blocks); err != nil {
+			return nil, fmt.Errorf("references to: %w", err)
+		}
+	}
+
+	paged := finishPage(refs, page, order, totalCount, func(r ref) (any, int64) { return r.id, r.id })
+	items := make([]Location, len(paged.Items))
+	for i, r := range paged.Items {
+		items[i] = r.loc
+	}
+	return &PagedResult[Location]{Items: items, TotalCount: paged.TotalCount, NextCursor: paged.NextCursor}, nil
+}
+
 // Implementations finds all types implementing the given interface/trait symbol.
 func (q *QueryBuilder) Implementations(symbolID int64) ([]Location, error) {
 	impls, err := q.store.ImplementationsByInterface(symbolID)
@@ -196,7 +331,7 @@ func (q *QueryBuilder) Dependencies(fileID int64) ([]*Import, error) {
 // Matches both exact source strings and suffix matches (e.g. "util" matches
 // "github.com/example/util").
 func (q *QueryBuilder) Dependents(source string) ([]*Import, error) {
-	rows, err := q.store.DB().Query(
+	rows, err := q.store.ReadDB().Query(
 		"SELECT id, file_id, source, imported_name, local_alias, kind, scope FROM imports WHERE source = ? OR source LIKE ?",
 		source, "%/"+source,
 	)
@@ -228,7 +363,7 @@ func (q *QueryBuilder) symbolLocation(symbolID int64) (*Location, error) {
 	}
 
 	var path string
-	err = q.store.DB().QueryRow("SELECT path FROM files WHERE id = ?", *sym.FileID).Scan(&path)
+	err = q.store.ReadDB().QueryRow("SELECT path FROM files WHERE id = ?", *sym.FileID).Scan(&path)
 	if err != nil {
 		return nil, err
 	}
@@ -242,14 +377,15 @@ func (q *QueryBuilder) symbolLocation(symbolID int64) (*Location, error) {
 	}, nil
 }
 
-// referenceLocation resolves a reference ID to its file path and position.
-func (q *QueryBuilder) referenceLocation(referenceID int64) (*Location, error) {
-	var fileID int64
-	var startLine, startCol, endLine, endCol int
-	err := q.store.DB().QueryRow(
-		`SELECT file_id, start_line, start_col, end_line, end_col
+// referenceLocation resolves a reference ID to its file path and position
+// through tx, reading compacted references from blocks, which must read
+// through tx too.
+func referenceLocation(tx *sql.Tx, referenceID int64, blocks *store.ReferenceBlocks) (*Location, error) {
+	var span refSpan
+	err := tx.QueryRow(
+		`SELECT id, file_id, start_line, start_col, end_line, end_col
 		 FROM references_ WHERE id = ?`, referenceID,
-	).Scan(&fileID, &startLine, &startCol, &endLine, &endCol)
+	).Scan(span.dest()...)
 	if err == sql.ErrNoRows {
 		return nil, nil
 	}
@@ -257,17 +393,42 @@ func (q *QueryBuilder) referenceLocation(referenceID int64) (*Location, error) {
 		return nil, err
 	}
 
-	var path string
-	err = q.store.DB().QueryRow("SELECT path FROM files WHERE id = ?", fileID).Scan(&path)
+	loc := &Location{}
+	err = tx.QueryRow("SELECT path FROM files WHERE id = ?", span.fileID).Scan(&loc.File)
 	if err != nil {
 		return nil, err
 	}
+	if err := span.fill(loc, blocks); err != nil {
+		return nil, err
+	}
+	return loc, nil
+}
 
-	return &Location{
-		File:      path,
-		StartLine: startLine,
-		StartCol:  startCol,
-		EndLine:   endLine,
-		EndCol:    endCol,
-	}, nil
+// refSpan is a reference's ID, file and position as scanned from its row.
+// The position is NULL for a reference stored in its file's block (see
+// WithCompactReferences), and fill reads it from there instead.
+type refSpan struct {
+	refID, fileID                        int64
+	startLine, startCol, endLine, endCol sql.NullInt64
+}
+
+// dest returns the scan destinations for r.id, r.file_id, r.start_line,
+// r.start_col, r.end_line and r.end_col, in that order.
+func (s *refSpan) dest() []any {
+	return []any{&s.refID, &s.fileID, &s.startLine, &s.startCol, &s.endLine, &s.endCol}
+}
+
+// fill sets the position of loc.
+func (s *refSpan) fill(loc *Location, blocks *store.ReferenceBlocks) error {
+	if !s.startLine.Valid {
+		r, err := blocks.Reference(s.fileID, s.refID)
+		if err != nil {
+			return err
+		}
+		loc.StartLine, loc.StartCol, loc.EndLine, loc.EndCol = r.StartLine, r.StartCol, r.EndLine, r.EndCol
+		return nil
+	}
+	loc.StartLine, loc.StartCol = int(s.startLine.Int64), int(s.startCol.Int64)
+	loc.EndLine, loc.EndCol = int(s.endLine.Int64), int(s.endCol.Int64)
+	return nil
 }
@@ -0,0 +1,447 @@
+package canopy
+
+import (
+	"database/sql"
+	"fmt"
+	"sort"
+	"strings"
+
+	"github.com/jward/canopy/internal/store"
+)
+
+// Position is a 0-based (line, col) position in a file, as taken by
+// DefinitionAt.
+type Position struct {
+	File string
+	Line int
+	Col  int
+}
+
+// queryer is the read interface shared by *sql.DB and *sql.Tx.
+type queryer interface {
+	Query(query string, args ...any) (*sql.Rows, error)
+}
+
+// batchChunk bounds the positions or IDs bound into one statement of a
+// batch query, well under SQLite's host parameter limit.
+const batchChunk = 250
+
+// inChunks calls fn for consecutive slices of at most batchChunk items,
+// with the offset of each slice in items.
+func inChunks[T any](items []T, fn func(offset int, part []T) error) error {
+	for off := 0; off < len(items); off += batchChunk {
+		if err := fn(off, items[off:min(off+batchChunk, len(items))]); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// distinctIDs returns ids without duplicates, in first-seen order.
+func distinctIDs(ids []int64) []int64 {
+	seen := make(map[int64]bool, len(ids))
+	out := make([]int64, 0, len(ids))
+	for _, id := range ids {
+		if !seen[id] {
+			seen[id] = true
+			out = append(out, id)
+		}
+	}
+	return out
+}
+
+// idArgs returns the placeholder list and arguments for an IN (...) over ids.
+func idArgs(ids []int64) (string, []any) {
+	args := make([]any, len(ids))
+	for i, id := range ids {
+		args[i] = id
+	}
+	return strings.Repeat("?,", len(ids)-1) + "?", args
+}
+
+// DefinitionsAt is DefinitionAt for many positions: result[i] holds the
+// definitions found at positions[i], nil if there are none or its file is
+// not indexed. Positions are matched against their files' references in
+// set-based statements of a few hundred positions each, all in one read
+// transaction, so the results come from a single snapshot of the index.
+// Positions in compacted files are matched against their reference blocks.
+func (q *QueryBuilder) DefinitionsAt(positions []Position) ([][]Location, error) {
+	tx, err := q.store.ReadDB().Begin()
+	if err != nil {
+		return nil, fmt.Errorf("definitions at: %w", err)
+	}
+	defer tx.Rollback()
+
+	var hits []definitionHit
+	blocks := store.NewReferenceBlocks(tx)
+	err = inChunks(positions, func(off int, part []Position) error {
+		values := strings.Repeat("(?, ?, ?, ?),", len(part)-1) + "(?, ?, ?, ?)"
+		args := make([]any, 0, 4*len(part))
+		for i, p := range part {
+			args = append(args, off+i, p.File, p.Line, p.Col)
+		}
+		// The reference span bounds match DefinitionAt's, so each
+		// position range-scans the (file_id, start_line, end_line) index.
+		rows, err := tx.Query(
+			`WITH pos(i, path, line, col) AS (VALUES `+values+`)
+			 SELECT pos.i, r.id, rr.id, tf.path, s.start_line, s.start_col, s.end_line, s.end_col
+			 FROM pos
+			 JOIN files f ON f.path = pos.path
+			 JOIN references_ r ON r.file_id = f.id AND r.start_line <= pos.line AND r.end_line >= pos.line
+			   AND (r.start_line < pos.line OR (r.start_line = pos.line AND r.start_col <= pos.col))
+			   AND (r.end_line > pos.line OR (r.end_line = pos.line AND r.end_col >= pos.col))
+			 JOIN resolved_references rr ON rr.reference_id = r.id
+			 JOIN symbols s ON s.id = rr.target_symbol_id
+			 JOIN files tf ON tf.id = s.file_id`,
+			args...,
+		)
+		if err != nil {
+			return err
+		}
+		for rows.Next() {
+			var h definitionHit
+			if err := rows.Scan(&h.i, &h.refID, &h.rrID, &h.loc.File, &h.loc.StartLine, &h.loc.StartCol, &h.loc.EndLine, &h.loc.EndCol); err != nil {
+				rows.Close()
+				return err
+			}
+			hits = append(hits, h)
+		}
+		rows.Close()
+		if err := rows.Err(); err != nil {
+			return err
+		}
+
+		refs, err := blockReferencesAt(tx, blocks, off, part)
+		if err != nil {
+			return err
+		}
+		hits, err = appendBlockTargets(tx, hits, refs)
+		return err
+	})
+	if err != nil {
+		return nil, fmt.Errorf("definitions at: %w", err)
+	}
+
+	sort.Slice(hits, func(a, b int) bool {
+		ha, hb := &hits[a], &hits[b]
+		if ha.i != hb.i {
+			return ha.i < hb.i
+		}
+		if ha.refID != hb.refID {
+			return ha.refID < hb.refID
+		}
+		return ha.rrID < hb.rrID
+	})
+	result := make([][]Location, len(positions))
+	for _, h := range hits {
+		result[h.i] = append(result[h.i], h.loc)
+	}
+	return result, nil
+}
+
+// definitionHit is a definition found at positions[i] through resolution
+// rrID of reference refID; DefinitionsAt orders them by all three.
+type definitionHit struct {
+	i           int
+	refID, rrID int64
+	loc         Location
+}
+
+// positionRef is reference refID, found at positions[i].
+type positionRef struct {
+	i     int
+	refID int64
+}
+
+// blockReferencesAt matches part, the positions from offset off, against
+// the reference blocks of their files.
+func blockReferencesAt(tx *sql.Tx, blocks *store.ReferenceBlocks, off int, part []Position) ([]positionRef, error) {
+	seen := make(map[string]bool, len(part))
+	var paths []any
+	for _, p := range part {
+		if !seen[p.File] {
+			seen[p.File] = true
+			paths = append(paths, p.File)
+		}
+	}
+	rows, err := tx.Query(
+		`SELECT f.path, f.id FROM files f JOIN reference_blocks b ON b.file_id = f.id
+		 WHERE f.path IN (`+strings.Repeat("?,", len(paths)-1)+`?)`,
+		paths...,
+	)
+	if err != nil {
+		return nil, err
+	}
+	fileIDs := make(map[string]int64)
+	for rows.Next() {
+		var path string
+		var id int64
+		if err := rows.Scan(&path, &id); err != nil {
+			rows.Close()
+			return nil, err
+		}
+		fileIDs[path] = id
+	}
+	rows.Close()
+	if err := rows.Err(); err != nil {
+		return nil, err
+	}
+
+	var refs []positionRef
+	for j, p := range part {
+		fid, ok := fileIDs[p.File]
+		if !ok {
+			continue
+		}
+		b, err := blocks.Block(fid)
+		if err != nil {
+			return nil, err
+		}
+		if b == nil {
+			continue
+		}
+		for _, id := range b.IDsAt(p.Line, p.Col) {
+			refs = append(refs, positionRef{i: off + j, refID: id})
+		}
+	}
+	return refs, nil
+}
+
+// appendBlockTargets appends to hits the definitions the references in
+// refs resolve to.
+func appendBlockTargets(tx *sql.Tx, hits []definitionHit, refs []positionRef) ([]definitionHit, error) {
+	if len(refs) == 0 {
+		return hits, nil
+	}
+	ids := make([]int64, len(refs))
+	for k, r := range refs {
+		ids[k] = r.refID
+	}
+	byRef := make(map[int64][]definitionHit)
+	err := inChunks(distinctIDs(ids), func(_ int, part []int64) error {
+		placeholders, args := idArgs(part)
+		rows, err := tx.Query(
+			`SELECT rr.reference_id, rr.id, tf.path, s.start_line, s.start_col, s.end_line, s.end_col
+			 FROM resolved_references rr
+			 JOIN symbols s ON s.id = rr.target_symbol_id
+			 JOIN files tf ON tf.id = s.file_id
+			 WHERE rr.reference_id IN (`+placeholders+`)`,
+			args...,
+		)
+		if err != nil {
+			return err
+		}
+		defer rows.Close()
+		for rows.Next() {
+			var h definitionHit
+			if err := rows.Scan(&h.refID, &h.rrID, &h.loc.File, &h.loc.StartLine, &h.loc.StartCol, &h.loc.EndLine, &h.loc.EndCol); err != nil {
+				return err
+			}
+			byRef[h.refID] = append(byRef[h.refID], h)
+		}
+		return rows.Err()
+	})
+	if err != nil {
+		return nil, err
+	}
+	for _, r := range refs {
+		for _, h := range byRef[r.refID] {
+			h.i = r.i
+			hits = append(hits, h)
+		}
+	}
+	return hits, nil
+}
+
+// ReferencesToMany is ReferencesTo for many symbols: result[i] holds the
+// references to symbolIDs[i]. The references are loaded with their
+// locations in set-based statements, all in one read transaction.
+func (q *QueryBuilder) ReferencesToMany(symbolIDs []int64) ([][]Location, error) {
+	tx, err := q.store.ReadDB().Begin()
+	if err != nil {
+		return nil, fmt.Errorf("references to many: %w", err)
+	}
+	defer tx.Rollback()
+
+	byID := make(map[int64][]Location, len(symbolIDs))
+	blocks := store.NewReferenceBlocks(tx)
+	err = inChunks(distinctIDs(symbolIDs), func(_ int, part []int64) error {
+		placeholders, args := idArgs(part)
+		rows, err := tx.Query(
+			`SELECT rr.target_symbol_id, f.path, r.id, r.file_id, r.start_line, r.start_col, r.end_line, r.end_col
+			 FROM resolved_references rr
+			 JOIN references_ r ON r.id = rr.reference_id
+			 JOIN files f ON f.id = r.file_id
+			 WHERE rr.target_symbol_id IN (`+placeholders+`)
+			 ORDER BY rr.target_symbol_id, rr.id`,
+			args...,
+		)
+		if err != nil {
+			return err
+		}
+		type ref struct {
+			id   int64
+			loc  Location
+			span refSpan
+		}
+		var refs []ref
+		for rows.Next() {
+			var r ref
+			if err := rows.Scan(append([]any{&r.id, &r.loc.File}, r.span.dest()...)...); err != nil {
+				rows.Close()
+				return err
+			}
+			refs = append(refs, r)
+		}
+		rows.Close()
+		if err := rows.Err(); err != nil {
+			return err
+		}
+		for _, r := range refs {
+			if err := r.span.fill(&r.loc, blocks); err != nil {
+				return err
+			}
+			byID[r.id] = append(byID[r.id], r.loc)
+		}
+		return nil
+	})
+	if err != nil {
+		return nil, fmt.Errorf("references to many: %w", err)
+	}
+
+	result := make([][]Location, len(symbolIDs))
+	for i, id := range symbolIDs {
+		result[i] = byID[id]
+	}
+	return result, nil
+}
+
+// SymbolDetails is SymbolDetail for many symbols: result[i] is the detail
+// of symbolIDs[i], nil if it does not exist. Each kind of metadata is
+// loaded for all the symbols at once, in one read transaction.
+func (q *QueryBuilder) SymbolDetails(symbolIDs []int64) ([]*SymbolDetail, error) {
+	tx, err := q.store.ReadDB().Begin()
+	if err != nil {
+		return nil, fmt.Errorf("symbol details: %w", err)
+	}
+	defer tx.Rollback()
+
+	details := make(map[int64]*SymbolDetail, len(symbolIDs))
+	err = inChunks(distinctIDs(symbolIDs), func(_ int, part []int64) error {
+		syms, err := symbolResultsIn(tx, part)
+		if err != nil {
+			return err
+		}
+		for id, sr := range syms {
+			details[id] = &SymbolDetail{
+				Symbol:      *sr,
+				Parameters:  []*FunctionParam{},
+				Members:     []*TypeMember{},
+				TypeParams:  []*TypeParam{},
+				Annotations: []*Annotation{},
+			}
+		}
+		return loadSymbolMetadata(tx, part, details)
+	})
+	if err != nil {
+		return nil, fmt.Errorf("symbol details: %w", err)
+	}
+
+	result := make([]*SymbolDetail, len(symbolIDs))
+	for i, id := range symbolIDs {
+		result[i] = details[id]
+	}
+	return result, nil
+}
+
+// loadSymbolMetadata appends the parameters, members, type parameters and
+// annotations of the symbols ids to their entries in details, ordered as
+// the single-symbol Store lookups order them.
+func loadSymbolMetadata(db queryer, ids []int64, details map[int64]*SymbolDetail) error {
+	placeholders, args := idArgs(ids)
+	each := func(query string, scan func(*sql.Rows) error) error {
+		rows, err := db.Query(query, args...)
+		if err != nil {
+			return err
+		}
+		defer rows.Close()
+		for rows.Next() {
+			if err := scan(rows); err != nil {
+				return err
+			}
+		}
+		return rows.Err()
+	}
+
+	if err := each(
+		`SELECT id, symbol_id, name, ordinal, type_expr, is_receiver, is_return, has_default, default_expr
+		 FROM function_parameters WHERE symbol_id IN (`+placeholders+`) ORDER BY symbol_id, ordinal`,
+		func(rows *sql.Rows) error {
+			fp := &FunctionParam{}
+			if err := rows.Scan(&fp.ID, &fp.SymbolID, &fp.Name, &fp.Ordinal, &fp.TypeExpr,
+				&fp.IsReceiver, &fp.IsReturn, &fp.HasDefault, &fp.DefaultExpr); err != nil {
+				return err
+			}
+			if d := details[fp.SymbolID]; d != nil {
+				d.Parameters = append(d.Parameters, fp)
+			}
+			return nil
+		},
+	); err != nil {
+		return fmt.Errorf("function params: %w", err)
+	}
+
+	if err := each(
+		`SELECT id, symbol_id, name, kind, type_expr, visibility
+		 FROM type_members WHERE symbol_id IN (`+placeholders+`) ORDER BY symbol_id, id`,
+		func(rows *sql.Rows) error {
+			tm := &TypeMember{}
+			if err := rows.Scan(&tm.ID, &tm.SymbolID, &tm.Name, &tm.Kind, &tm.TypeExpr, &tm.Visibility); err != nil {
+				return err
+			}
+			if d := details[tm.SymbolID]; d != nil {
+				d.Members = append(d.Members, tm)
+			}
+			return nil
+		},
+	); err != nil {
+		return fmt.Errorf("type members: %w", err)
+	}
+
+	if err := each(
+		`SELECT id, symbol_id, name, ordinal, variance, param_kind, constraints
+		 FROM type_parameters WHERE symbol_id IN (`+placeholders+`) ORDER BY symbol_id, ordinal`,
+		func(rows *sql.Rows) error {
+			tp := &TypeParam{}
+			if err := rows.Scan(&tp.ID, &tp.SymbolID, &tp.Name, &tp.Ordinal,
+				&tp.Variance, &tp.ParamKind, &tp.Constraints); err != nil {
+				return err
+			}
+			if d := details[tp.SymbolID]; d != nil {
+				d.TypeParams = append(d.TypeParams, tp)
+			}
+			return nil
+		},
+	); err != nil {
+		return fmt.Errorf("type params: %w", err)
+	}
+
+	if err := each(
+		`SELECT id, target_symbol_id, name, resolved_symbol_id, arguments, file_id, line, col
+		 FROM annotations WHERE target_symbol_id IN (`+placeholders+`) ORDER BY target_symbol_id, id`,
+		func(rows *sql.Rows) error {
+			a := &Annotation{}
+			if err := rows.Scan(&a.ID, &a.TargetSymbolID, &a.Name, &a.ResolvedSymbolID,
+				&a.Arguments, &a.FileID, &a.Line, &a.Col); err != nil {
+				return err
+			}
+			if d := details[a.TargetSymbolID]; d != nil {
+				d.Annotations = append(d.Annotations, a)
+			}
+			return nil
+		},
+	); err != nil {
+		return fmt.Errorf("annotations: %w", err)
+	}
+	return nil
+}
@@ -0,0 +1,127 @@
+package canopy
+
+import (
+	"context"
+	"path/filepath"
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+// TestBatchQueries_MatchSingleQueries checks every batch query against the
+// single-item query it batches, over more items than fit in one statement.
+func TestBatchQueries_MatchSingleQueries(t *testing.T) {
+	t.Parallel()
+	r, err := newSynthRepo(t.TempDir(), "go", 2*batchChunk)
+	require.NoError(t, err)
+	e := newIntegrationEngine(t, WithLanguages("go"))
+	ctx := context.Background()
+	require.NoError(t, e.IndexDirectory(ctx, r.dir))
+	require.NoError(t, e.Resolve(ctx))
+	q := e.Query()
+
+	var positions []Position
+	for u := 1; u < r.units; u++ {
+		path, line, col, _ := r.callSite(u)
+		positions = append(positions, Position{File: path, Line: line, Col: col})
+	}
+	path, _, _, _ := r.callSite(1)
+	positions = append(positions,
+		Position{File: path, Line: 0, Col: 0},                       // no reference
+		Position{File: filepath.Join(r.dir, "missing.go"), Line: 1}, // not indexed
+		positions[0],
+	)
+
+	defs, err := q.DefinitionsAt(positions)
+	require.NoError(t, err)
+	require.Len(t, defs, len(positions))
+	var symbolIDs []int64
+	for i, p := range positions {
+		want, err := q.DefinitionAt(p.File, p.Line, p.Col)
+		require.NoError(t, err)
+		assert.ElementsMatch(t, want, defs[i], "definitions at %v", p)
+		for _, loc := range defs[i] {
+			sym, err := q.SymbolAt(loc.File, loc.StartLine, loc.StartCol)
+			require.NoError(t, err)
+			require.NotNil(t, sym)
+			symbolIDs = append(symbolIDs, sym.ID)
+		}
+	}
+	require.Greater(t, len(symbolIDs), batchChunk)
+	symbolIDs = append(symbolIDs, symbolIDs[0], 1<<40)
+
+	refs, err := q.ReferencesToMany(symbolIDs)
+	require.NoError(t, err)
+	require.Len(t, refs, len(symbolIDs))
+	for i, id := range symbolIDs {
+		want, err := q.ReferencesTo(id)
+		require.NoError(t, err)
+		assert.ElementsMatch(t, want, refs[i], "references to %d", id)
+	}
+
+	details, err := q.SymbolDetails(symbolIDs)
+	require.NoError(t, err)
+	require.Len(t, details, len(symbolIDs))
+	for i, id := range symbolIDs {
+		want, err := q.SymbolDetail(id)
+		require.NoError(t, err)
+		assert.Equal(t, want, details[i], "detail of %d", id)
+	}
+	assert.Nil(t, details[len(details)-1])
+}
+
+// TestCompactReferences_MatchRowStorage checks that queries over compact
+// reference storage answer as they do over reference rows.
+func TestCompactReferences_MatchRowStorage(t *testing.T) {
+	t.Parallel()
+	r, err := newSynthRepo(t.TempDir(), "go", 40)
+	require.NoError(t, err)
+	ctx := context.Background()
+	var qs []*QueryBuilder
+	for _, opts := range [][]Option{{WithLanguages("go")}, {WithLanguages("go"), WithCompactReferences()}} {
+		e := newIntegrationEngine(t, opts...)
+		require.NoError(t, e.IndexDirectory(ctx, r.dir))
+		require.NoError(t, e.Resolve(ctx))
+		qs = append(qs, e.Query())
+	}
+	plain, compact := qs[0], qs[1]
+	var blocks int
+	require.NoError(t, compact.store.ReadDB().QueryRow("SELECT COUNT(*) FROM reference_blocks").Scan(&blocks))
+	require.Positive(t, blocks)
+
+	var positions []Position
+	for u := 1; u < r.units; u++ {
+		path, line, col, _ := r.callSite(u)
+		positions = append(positions, Position{File: path, Line: line, Col: col})
+	}
+	want, err := plain.DefinitionsAt(positions)
+	require.NoError(t, err)
+	got, err := compact.DefinitionsAt(positions)
+	require.NoError(t, err)
+	assert.Equal(t, want, got)
+
+	for i, p := range positions {
+		defs, err := compact.DefinitionAt(p.File, p.Line, p.Col)
+		require.NoError(t, err)
+		assert.ElementsMatch(t, want[i], defs, "definition at %v", p)
+		for _, loc := range defs {
+			refsByEngine := make([][]Location, 0, 2)
+			for _, q := range qs {
+				sym, err := q.SymbolAt(loc.File, loc.StartLine, loc.StartCol)
+				require.NoError(t, err)
+				require.NotNil(t, sym)
+				refs, err := q.ReferencesTo(sym.ID)
+				require.NoError(t, err)
+				many, err := q.ReferencesToMany([]int64{sym.ID})
+				require.NoError(t, err)
+				assert.ElementsMatch(t, refs, many[0])
+				page, err := q.ReferencesToPage(sym.ID, Pagination{})
+				require.NoError(t, err)
+				assert.ElementsMatch(t, refs, page.Items)
+				refsByEngine = append(refsByEngine, refs)
+			}
+			assert.ElementsMatch(t, refsByEngine[0], refsByEngine[1], "references to %v", loc)
+		}
+	}
+}
@@ -0,0 +1,63 @@
+package canopy
+
+import (
+	"fmt"
+	"sync"
+)
+
+// derivedCache holds structures a QueryBuilder derives from the whole index.
+// Entries are valid for one index generation (store.IndexGeneration); the
+// first call after a generation change rebuilds them.
+type derivedCache struct {
+	mu         sync.Mutex
+	generation string
+	pkgGraph   *DependencyGraph
+	names      *nameTable
+}
+
+// sync drops every cached entry if the index generation has moved.
+// Callers must hold c.mu.
+func (c *derivedCache) sync(q *QueryBuilder) error {
+	gen, err := q.store.IndexGeneration()
+	if err != nil {
+		return err
+	}
+	if gen != c.generation {
+		c.generation = gen
+		c.pkgGraph = nil
+		c.names = nil
+	}
+	return nil
+}
+
+func (c *derivedCache) packageGraph(q *QueryBuilder) (*DependencyGraph, error) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if err := c.sync(q); err != nil {
+		return nil, fmt.Errorf("package dependency graph: %w", err)
+	}
+	if c.pkgGraph == nil {
+		g, err := q.buildPackageDependencyGraph()
+		if err != nil {
+			return nil, err
+		}
+		c.pkgGraph = g
+	}
+	return c.pkgGraph, nil
+}
+
+func (c *derivedCache) nameTable(q *QueryBuilder) (*nameTable, error) {
+	c.mu.Lock()
+	defer c.mu.Unlock()
+	if err := c.sync(q); err != nil {
+		return nil, fmt.Errorf("name table: %w", err)
+	}
+	if c.names == nil {
+		t, err := q.buildNameTable()
+		if err != nil {
+			return nil, err
+		}
+		c.names = t
+	}
+	return c.names, nil
+}
@@ -0,0 +1,127 @@
+package canopy
+
+import (
+	"bytes"
+	"encoding/base64"
+	"encoding/json"
+	"fmt"
+	"iter"
+)
+
+// pageCursor is the decoded form of a Pagination.Cursor: the sort key and
+// ID of the last row of the previous page, the ordering they were taken
+// from, and the total count reported by the first page.
+type pageCursor struct {
+	Order string `json:"o"`
+	Key   any    `json:"k"`
+	ID    int64  `json:"id"`
+	Total int    `json:"n"`
+}
+
+// encodeCursor returns the opaque token for c.
+func encodeCursor(c pageCursor) string {
+	b, _ := json.Marshal(c)
+	return base64.RawURLEncoding.EncodeToString(b)
+}
+
+// decodeCursor parses token, which must have been taken from a page in
+// order. It returns nil for an empty token.
+func decodeCursor(token, order string) (*pageCursor, error) {
+	if token == "" {
+		return nil, nil
+	}
+	b, err := base64.RawURLEncoding.DecodeString(token)
+	if err != nil {
+		return nil, fmt.Errorf("invalid cursor: %w", err)
+	}
+	dec := json.NewDecoder(bytes.NewReader(b))
+	dec.UseNumber()
+	var c pageCursor
+	if err := dec.Decode(&c); err != nil {
+		return nil, fmt.Errorf("invalid cursor: %w", err)
+	}
+	if c.Order != order {
+		return nil, fmt.Errorf("cursor is for order %q, not %q", c.Order, order)
+	}
+	if n, ok := c.Key.(json.Number); ok {
+		if c.Key, err = n.Int64(); err != nil {
+			return nil, fmt.Errorf("invalid cursor: %w", err)
+		}
+	}
+	return &c, nil
+}
+
+// keyset returns the ORDER BY clause for rows ordered by (keyExpr, idExpr)
+// in dir and, given a cursor, the condition selecting the rows after it.
+// The row-value comparison lets SQLite seek through an index on keyExpr
+// instead of stepping over an OFFSET of rows.
+func keyset(keyExpr, idExpr, dir string, cur *pageCursor) (orderBy, cond string, args []any) {
+	orderBy = fmt.Sprintf("ORDER BY %s %s, %s %s", keyExpr, dir, idExpr, dir)
+	if cur == nil {
+		return orderBy, "", nil
+	}
+	op := ">"
+	if dir == "DESC" {
+		op = "<"
+	}
+	return orderBy, fmt.Sprintf("(%s, %s) %s (?, ?)", keyExpr, idExpr, op), []any{cur.Key, cur.ID}
+}
+
+// pageWindow returns the LIMIT and OFFSET to query for page: one row more
+// than the page holds, to learn whether another page follows, and no
+// offset when resuming from a cursor.
+func pageWindow(page Pagination, cur *pageCursor) (limit, offset int) {
+	limit = *page.Limit
+	if limit > 0 {
+		limit++
+	}
+	if cur != nil {
+		return limit, 0
+	}
+	return limit, page.Offset
+}
+
+// finishPage trims the look-ahead row fetched by pageWindow and, if there
+// was one, sets the cursor resuming after the last item kept. key returns
+// an item's sort key and ID.
+func finishPage[T any](items []T, page Pagination, order string, total int, key func(T) (any, int64)) *PagedResult[T] {
+	result := &PagedResult[T]{Items: items, TotalCount: total}
+	if limit := *page.Limit; limit > 0 && len(items) > limit {
+		result.Items = items[:limit]
+		k, id := key(items[limit-1])
+		result.NextCursor = encodeCursor(pageCursor{Order: order, Key: k, ID: id, Total: total})
+	}
+	return result
+}
+
+// Iterate yields every item of a paginated listing, calling fetch with
+// successive cursors for pages of the maximum size, so walking a whole
+// index holds one page in memory at a time:
+//
+//	for sym, err := range canopy.Iterate(func(p canopy.Pagination) (*canopy.PagedResult[canopy.SymbolResult], error) {
+//		return q.Symbols(filter, sort, p)
+//	}) { ... }
+//
+// A fetch error is yielded once and ends the sequence.
+func Iterate[T any](fetch func(Pagination) (*PagedResult[T], error)) iter.Seq2[T, error] {
+	return func(yield func(T, error) bool) {
+		page := Pagination{Limit: intP(maxLimit)}
+		for {
+			result, err := fetch(page)
+			if err != nil {
+				var zero T
+				yield(zero, err)
+				return
+			}
+			for _, item := range result.Items {
+				if !yield(item, nil) {
+					return
+				}
+			}
+			if result.NextCursor == "" {
+				return
+			}
+			page.Cursor = result.NextCursor
+		}
+	}
+}
@@ -0,0 +1,132 @@
+package canopy
+
+import (
+	"fmt"
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+// walkCursor collects every page of fetch, two items at a time, checking
+// each page reports the first page's total.
+func walkCursor[T any](t *testing.T, fetch func(Pagination) (*PagedResult[T], error)) []T {
+	t.Helper()
+	page := Pagination{Limit: intP(2)}
+	var all []T
+	total := -1
+	for {
+		result, err := fetch(page)
+		require.NoError(t, err)
+		if total < 0 {
+			total = result.TotalCount
+		}
+		assert.Equal(t, total, result.TotalCount)
+		all = append(all, result.Items...)
+		if result.NextCursor == "" {
+			break
+		}
+		page.Cursor = result.NextCursor
+	}
+	assert.Len(t, all, total)
+	return all
+}
+
+func TestSymbols_CursorWalkMatchesOffsetListing(t *testing.T) {
+	t.Parallel()
+	q, s := newTestQueryBuilder(t)
+	fID := insertFile(t, s, "main.go", "go")
+	otherID := insertFile(t, s, "other.go", "go")
+	var ids []int64
+	for i := range 7 {
+		// Repeated names and counts make the ID tie-breaker matter.
+		ids = append(ids, insertSymbol(t, s, &fID, fmt.Sprintf("Sym%d", i%3), "function", "public", nil))
+	}
+	for i, id := range ids {
+		for range i % 3 {
+			insertResolvedRef(t, s, otherID, id)
+		}
+	}
+
+	for _, sort := range []Sort{
+		{Field: SortByName, Order: Asc},
+		{Field: SortByName, Order: Desc},
+		{Field: SortByFile, Order: Asc},
+		{Field: SortByRefCount, Order: Desc},
+	} {
+		t.Run(fmt.Sprintf("%s %s", sort.Field, sort.Order), func(t *testing.T) {
+			want, err := q.Symbols(SymbolFilter{}, sort, Pagination{})
+			require.NoError(t, err)
+			got := walkCursor(t, func(p Pagination) (*PagedResult[SymbolResult], error) {
+				return q.Symbols(SymbolFilter{}, sort, p)
+			})
+			assert.Equal(t, want.Items, got)
+		})
+	}
+
+	search := walkCursor(t, func(p Pagination) (*PagedResult[SymbolResult], error) {
+		return q.SearchSymbols("Sym1*", SymbolFilter{}, Sort{}, p)
+	})
+	assert.Len(t, search, 2)
+
+	unused := walkCursor(t, func(p Pagination) (*PagedResult[SymbolResult], error) {
+		return q.UnusedSymbols(SymbolFilter{}, Sort{Field: SortByRefCount}, p)
+	})
+	assert.Len(t, unused, 3)
+}
+
+func TestFiles_IterateVisitsEveryFile(t *testing.T) {
+	t.Parallel()
+	q, s := newTestQueryBuilder(t)
+	for i := range 2*maxLimit + 1 {
+		insertFile(t, s, fmt.Sprintf("src/f%04d.go", i), "go")
+	}
+
+	var paths []string
+	for f, err := range Iterate(func(p Pagination) (*PagedResult[File], error) {
+		return q.Files("src", "", Sort{Field: SortByFile, Order: Desc}, p)
+	}) {
+		require.NoError(t, err)
+		paths = append(paths, f.Path)
+	}
+	require.Len(t, paths, 2*maxLimit+1)
+	assert.Equal(t, "src/f1000.go", paths[0])
+	assert.Equal(t, "src/f0000.go", paths[len(paths)-1])
+}
+
+func TestReferencesToPage_CursorWalkMatchesReferencesTo(t *testing.T) {
+	t.Parallel()
+	q, s := newTestQueryBuilder(t)
+	fID := insertFile(t, s, "main.go", "go")
+	target := insertSymbol(t, s, &fID, "Target", "function", "public", nil)
+	other := insertSymbol(t, s, &fID, "Other", "function", "public", nil)
+	for range 5 {
+		insertResolvedRef(t, s, fID, target)
+		insertResolvedRef(t, s, fID, other)
+	}
+
+	want, err := q.ReferencesTo(target)
+	require.NoError(t, err)
+	got := walkCursor(t, func(p Pagination) (*PagedResult[Location], error) {
+		return q.ReferencesToPage(target, p)
+	})
+	assert.Equal(t, want, got)
+}
+
+func TestCursor_RejectsOtherOrder(t *testing.T) {
+	t.Parallel()
+	q, s := newTestQueryBuilder(t)
+	fID := insertFile(t, s, "main.go", "go")
+	for i := range 3 {
+		insertSymbol(t, s, &fID, fmt.Sprintf("Sym%d", i), "function", "public", nil)
+	}
+
+	first, err := q.Symbols(SymbolFilter{}, Sort{Field: SortByName}, Pagination{Limit: intP(1)})
+	require.NoError(t, err)
+	require.NotEmpty(t, first.NextCursor)
+
+	_, err = q.Symbols(SymbolFilter{}, Sort{Field: SortByKind}, Pagination{Limit: intP(1), Cursor: first.NextCursor})
+	assert.ErrorContains(t, err, "cursor")
+	_, err = q.Symbols(SymbolFilter{}, Sort{}, Pagination{Cursor: "not a cursor"})
+	assert.ErrorContains(t, err, "invalid cursor")
+}
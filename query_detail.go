@@ -117,6 +117,11 @@ func (q *QueryBuilder) ScopeAt(file string, line, col int) ([]*Scope, error) {
 // in a single query. Returns a map from symbol ID to *SymbolResult. Missing
 // IDs are simply absent from the map.
 func (q *QueryBuilder) symbolResultsByIDs(ids []int64) (map[int64]*SymbolResult, error) {
+	return symbolResultsIn(q.store.ReadDB(), ids)
+}
+
+// symbolResultsIn is symbolResultsByIDs on db, which may be a transaction.
+func symbolResultsIn(db queryer, ids []int64) (map[int64]*SymbolResult, error) {
 	if len(ids) == 0 {
 		return map[int64]*SymbolResult{}, nil
 	}
@@ -125,15 +130,14 @@ func (q *QueryBuilder) symbolResultsByIDs(ids []int64) (map[int64]*SymbolResult,
 	for i, id := range ids {
 		args[i] = id
 	}
-	rows, err := q.store.DB().Query(
+	rows, err := db.Query(
 		fmt.Sprintf(
-			`SELECT %s, COALESCE(f.path, '') AS file_path,
-				(SELECT COUNT(*) FROM resolved_references rr WHERE rr.target_symbol_id = s.id) AS ref_count,
-				(SELECT COUNT(*) FROM resolved_references rr JOIN references_ r ON r.id = rr.reference_id WHERE rr.target_symbol_id = s.id AND r.file_id != s.file_id) AS external_ref_count
+			`SELECT %s, COALESCE(f.path, '') AS file_path, %s
 			 FROM symbols s
 			 LEFT JOIN files f ON s.file_id = f.id
+			 %s
 			 WHERE s.id IN (%s)`,
-			prefixSymbolCols("s"),
+			prefixSymbolCols("s"), statsCountCols, symbolStatsJoin,
 			placeholders,
 		),
 		args...,
@@ -156,15 +160,14 @@ func (q *QueryBuilder) symbolResultsByIDs(ids []int64) (map[int64]*SymbolResult,
 // symbolResultByID loads a single symbol as a SymbolResult (with ref counts)
 // by its ID. Returns nil with no error if not found.
 func (q *QueryBuilder) symbolResultByID(symbolID int64) (*SymbolResult, error) {
-	row := q.store.DB().QueryRow(
+	row := q.store.ReadDB().QueryRow(
 		fmt.Sprintf(
-			`SELECT %s, COALESCE(f.path, '') AS file_path,
-				(SELECT COUNT(*) FROM resolved_references rr WHERE rr.target_symbol_id = s.id) AS ref_count,
-				(SELECT COUNT(*) FROM resolved_references rr JOIN references_ r ON r.id = rr.reference_id WHERE rr.target_symbol_id = s.id AND r.file_id != s.file_id) AS external_ref_count
+			`SELECT %s, COALESCE(f.path, '') AS file_path, %s
 			 FROM symbols s
 			 LEFT JOIN files f ON s.file_id = f.id
+			 %s
 			 WHERE s.id = ?`,
-			prefixSymbolCols("s"),
+			prefixSymbolCols("s"), statsCountCols, symbolStatsJoin,
 		),
 		symbolID,
 	)
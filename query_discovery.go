@@ -10,10 +10,14 @@ import (
 
 // --- Common Types ---
 
-// Pagination controls offset+limit paging on list/search results.
+// Pagination controls paging on list/search results: by offset+limit, or
+// by a keyset cursor taken from the previous page's NextCursor. A cursor
+// page seeks straight to its first row and skips the COUNT, so walking a
+// whole listing costs O(n) instead of O(n²).
 type Pagination struct {
-	Offset int  // skip this many results (default 0)
-	Limit  *int // max results to return; nil = default (50), 0 = return nothing, max 500
+	Offset int    // skip this many results (default 0); ignored with Cursor
+	Limit  *int   // max results to return; nil = default (50), 0 = return nothing, max 500
+	Cursor string // resume after the page that returned it, under the same filter and sort
 }
 
 const (
@@ -78,7 +82,8 @@ type SymbolResult struct {
 // PagedResult wraps a page of results with total count for pagination.
 type PagedResult[T any] struct {
 	Items      []T
-	TotalCount int // total matching results (before pagination)
+	TotalCount int    // total matching results (before pagination), as of the first page
+	NextCursor string // cursor for the following page; empty on the last page
 }
 
 // SymbolFilter specifies which symbols to include.
@@ -95,7 +100,7 @@ type SymbolFilter struct {
 
 // --- Internal Helpers ---
 
-// normalizePathPrefix ensures a path prefix ends with "/" for correct LIKE matching.
+// normalizePathPrefix ensures a path prefix ends with "/" for correct prefix matching.
 // "internal/store" -> "internal/store/" to prevent matching "internal/store_utils/".
 func normalizePathPrefix(prefix string) string {
 	if prefix == "" {
@@ -107,36 +112,60 @@ func normalizePathPrefix(prefix string) string {
 	return prefix
 }
 
-// symbolSortColumn returns the SQL ORDER BY expression for symbol queries.
-// Falls back to "s.name" for unknown fields.
-func symbolSortColumn(field SortField) string {
+// pathPrefixBounds returns the range [lo, hi) of the paths under a
+// normalized prefix: hi bumps its trailing "/" to the next byte, "0".
+// Filters compare "path COLLATE NOCASE" against the bounds, which ignores
+// ASCII case as LIKE 'prefix%' did and is a range scan of the
+// idx_files_path_nocase index, where LIKE tests every row.
+func pathPrefixBounds(prefix string) (lo, hi string) {
+	if prefix == "" {
+		return "", ""
+	}
+	return prefix, prefix[:len(prefix)-1] + "0"
+}
+
+// symbolSortKey returns the SQL expression symbol queries order by, with
+// s.id breaking ties, and the same key read from a result for cursors.
+// Without the symbol_stats join (stats false) the reference counts are the
+// constant 0, which leaves the tie-breaking ID; SQLite would read a literal
+// "ORDER BY 0" as a column number. Falls back to the name for unknown fields.
+func symbolSortKey(field SortField, stats bool) (string, func(SymbolResult) any) {
 	switch field {
-	case SortByName:
-		return "s.name"
 	case SortByKind:
-		return "s.kind"
+		return "s.kind", func(sr SymbolResult) any { return sr.Kind }
 	case SortByFile:
-		return "f.path"
-	case SortByRefCount:
-		return "ref_count"
-	case SortByExternalRefCount:
-		return "external_ref_count"
+		return "COALESCE(f.path, '')", func(sr SymbolResult) any { return sr.FilePath }
+	case SortByRefCount, SortByExternalRefCount:
+		if !stats {
+			return "s.id", func(sr SymbolResult) any { return sr.ID }
+		}
+		if field == SortByRefCount {
+			return "COALESCE(st.ref_count, 0)", func(sr SymbolResult) any { return int64(sr.RefCount) }
+		}
+		return "COALESCE(st.external_ref_count, 0)", func(sr SymbolResult) any { return int64(sr.ExternalRefCount) }
 	default:
-		return "s.name"
+		return "s.name", func(sr SymbolResult) any { return sr.Name }
 	}
 }
 
-// fileSortColumn returns the SQL ORDER BY expression for file queries.
-// Falls back to "path" for inapplicable fields.
-func fileSortColumn(field SortField) string {
-	switch field {
-	case SortByFile, SortByName:
-		return "path"
-	case SortByLineCount:
-		return "line_count"
-	default:
-		return "path"
+// symbolStatsJoin attaches the precomputed counts of a symbol s (see
+// store.RefreshSymbolStats) as st; symbols without a row have no references
+// or call edges. Resolve refreshes symbol_stats at the end of every pass,
+// so queries read it as is and never write. statsCountCols selects the
+// ref_count and external_ref_count columns scanSymbolResult expects from it.
+const (
+	symbolStatsJoin = "LEFT JOIN symbol_stats st ON st.symbol_id = s.id"
+	statsCountCols  = "COALESCE(st.ref_count, 0) AS ref_count, COALESCE(st.external_ref_count, 0) AS external_ref_count"
+)
+
+// fileSortKey returns the SQL expression file queries order by, with id
+// breaking ties, and the same key read from a file for cursors. Falls back
+// to "path" for inapplicable fields.
+func fileSortKey(field SortField) (string, func(File) any) {
+	if field == SortByLineCount {
+		return "line_count", func(f File) any { return int64(f.LineCount) }
 	}
+	return "path", func(f File) any { return f.Path }
 }
 
 // sortDirection returns "ASC" or "DESC".
@@ -147,12 +176,9 @@ func sortDirection(order SortOrder) string {
 	return "ASC"
 }
 
-// --- Enumeration Endpoints ---
-
-// Symbols is the primary listing/filtering endpoint. All filter fields are optional.
-func (q *QueryBuilder) Symbols(filter SymbolFilter, sort Sort, page Pagination) (*PagedResult[SymbolResult], error) {
-	page = page.normalize()
-
+// symbolFilterConditions translates filter into WHERE conditions over
+// symbols s, files f and symbol_stats st (see symbolStatsJoin).
+func symbolFilterConditions(filter SymbolFilter) ([]string, []any) {
 	var where []string
 	var args []any
 
@@ -178,8 +204,9 @@ func (q *QueryBuilder) Symbols(filter SymbolFilter, sort Sort, page Pagination)
 	if filter.PathPrefix != nil {
 		prefix := normalizePathPrefix(*filter.PathPrefix)
 		if prefix != "" {
-			where = append(where, "f.path LIKE ? ESCAPE '\\'")
-			args = append(args, escapeLike(prefix)+"%")
+			lo, hi := pathPrefixBounds(prefix)
+			where = append(where, "f.path COLLATE NOCASE >= ? AND f.path COLLATE NOCASE < ?")
+			args = append(args, lo, hi)
 		}
 	}
 	// Modifier filtering using json_each
@@ -187,68 +214,71 @@ func (q *QueryBuilder) Symbols(filter SymbolFilter, sort Sort, page Pagination)
 		where = append(where, "EXISTS (SELECT 1 FROM json_each(s.modifiers) WHERE json_each.value = ?)")
 		args = append(args, mod)
 	}
+	// Ref count filters read the precomputed symbol_stats counts.
+	if filter.RefCountMin != nil {
+		where = append(where, "COALESCE(st.ref_count, 0) >= ?")
+		args = append(args, *filter.RefCountMin)
+	}
+	if filter.RefCountMax != nil {
+		where = append(where, "COALESCE(st.ref_count, 0) <= ?")
+		args = append(args, *filter.RefCountMax)
+	}
+	return where, args
+}
+
+// --- Enumeration Endpoints ---
+
+// Symbols is the primary listing/filtering endpoint. All filter fields are optional.
+func (q *QueryBuilder) Symbols(filter SymbolFilter, sort Sort, page Pagination) (*PagedResult[SymbolResult], error) {
+	page = page.normalize()
+
+	where, args := symbolFilterConditions(filter)
 
 	whereClause := ""
 	if len(where) > 0 {
 		whereClause = "WHERE " + strings.Join(where, " AND ")
 	}
 
-	// Build HAVING clause for ref count filters
-	var having []string
-	var havingArgs []any
-	refCountSubquery := `(SELECT COUNT(*) FROM resolved_references rr WHERE rr.target_symbol_id = s.id)`
-	if filter.RefCountMin != nil {
-		having = append(having, refCountSubquery+" >= ?")
-		havingArgs = append(havingArgs, *filter.RefCountMin)
-	}
-	if filter.RefCountMax != nil {
-		having = append(having, refCountSubquery+" <= ?")
-		havingArgs = append(havingArgs, *filter.RefCountMax)
-	}
-
-	groupByClause := ""
-	havingClause := ""
-	if len(having) > 0 {
-		groupByClause = " GROUP BY s.id"
-		havingClause = " HAVING " + strings.Join(having, " AND ")
+	keyExpr, keyOf := symbolSortKey(sort.Field, true)
+	orderDir := sortDirection(sort.Order)
+	order := keyExpr + " " + orderDir
+	cur, err := decodeCursor(page.Cursor, order)
+	if err != nil {
+		return nil, fmt.Errorf("symbols: %w", err)
 	}
 
-	// Count query
 	var totalCount int
-	if len(having) > 0 {
-		// When HAVING is needed, count the rows from a subquery
-		countSQL := fmt.Sprintf(`SELECT COUNT(*) FROM (SELECT s.id FROM symbols s LEFT JOIN files f ON s.file_id = f.id %s%s%s)`,
-			whereClause, groupByClause, havingClause)
-		countArgs := append(append([]any{}, args...), havingArgs...)
-		if err := q.store.DB().QueryRow(countSQL, countArgs...).Scan(&totalCount); err != nil {
-			return nil, fmt.Errorf("symbols: count: %w", err)
-		}
+	if cur != nil {
+		totalCount = cur.Total
 	} else {
-		countSQL := `SELECT COUNT(*) FROM symbols s LEFT JOIN files f ON s.file_id = f.id ` + whereClause
-		if err := q.store.DB().QueryRow(countSQL, args...).Scan(&totalCount); err != nil {
+		countSQL := `SELECT COUNT(*) FROM symbols s LEFT JOIN files f ON s.file_id = f.id ` + symbolStatsJoin + " " + whereClause
+		if err := q.store.ReadDB().QueryRow(countSQL, args...).Scan(&totalCount); err != nil {
 			return nil, fmt.Errorf("symbols: count: %w", err)
 		}
 	}
 
-	// Data query with ref count subquery
-	orderCol := symbolSortColumn(sort.Field)
-	orderDir := sortDirection(sort.Order)
+	// Data query
+	orderBy, cond, condArgs := keyset(keyExpr, "s.id", orderDir, cur)
+	if cond != "" {
+		whereClause = "WHERE " + strings.Join(append(where, cond), " AND ")
+		args = append(args, condArgs...)
+	}
 
 	dataSQL := fmt.Sprintf(
 		`SELECT %s, COALESCE(f.path, '') AS file_path,
-			(SELECT COUNT(*) FROM resolved_references rr WHERE rr.target_symbol_id = s.id) AS ref_count,
-			(SELECT COUNT(*) FROM resolved_references rr JOIN references_ r ON r.id = rr.reference_id WHERE rr.target_symbol_id = s.id AND r.file_id != s.file_id) AS external_ref_count
+			%s
 		 FROM symbols s
 		 LEFT JOIN files f ON s.file_id = f.id
-		 %s%s%s
-		 ORDER BY %s %s
+		 %s
+		 %s
+		 %s
 		 LIMIT ? OFFSET ?`,
-		prefixSymbolCols("s"), whereClause, groupByClause, havingClause, orderCol, orderDir,
+		prefixSymbolCols("s"), statsCountCols, symbolStatsJoin, whereClause, orderBy,
 	)
-	dataArgs := append(append([]any{}, args...), havingArgs...)
-	dataArgs = append(dataArgs, *page.Limit, page.Offset)
+	limit, offset := pageWindow(page, cur)
+	dataArgs := append(append([]any{}, args...), limit, offset)
 
-	rows, err := q.store.DB().Query(dataSQL, dataArgs...)
+	rows, err := q.store.ReadDB().Query(dataSQL, dataArgs...)
 	if err != nil {
 		return nil, fmt.Errorf("symbols: query: %w", err)
 	}
@@ -269,7 +299,9 @@ func (q *QueryBuilder) Symbols(filter SymbolFilter, sort Sort, page Pagination)
 		items = []SymbolResult{}
 	}
 
-	return &PagedResult[SymbolResult]{Items: items, TotalCount: totalCount}, nil
+	return finishPage(items, page, order, totalCount, func(sr SymbolResult) (any, int64) {
+		return keyOf(sr), sr.ID
+	}), nil
 }
 
 // Files is a convenience method for listing files.
@@ -281,8 +313,9 @@ func (q *QueryBuilder) Files(pathPrefix string, language string, sort Sort, page
 
 	if pathPrefix != "" {
 		prefix := normalizePathPrefix(pathPrefix)
-		where = append(where, "path LIKE ? ESCAPE '\\'")
-		args = append(args, escapeLike(prefix)+"%")
+		lo, hi := pathPrefixBounds(prefix)
+		where = append(where, "path COLLATE NOCASE >= ? AND path COLLATE NOCASE < ?")
+		args = append(args, lo, hi)
 	}
 	if language != "" {
 		where = append(where, "language = ?")
@@ -294,24 +327,40 @@ func (q *QueryBuilder) Files(pathPrefix string, language string, sort Sort, page
 		whereClause = "WHERE " + strings.Join(where, " AND ")
 	}
 
+	keyExpr, keyOf := fileSortKey(sort.Field)
+	orderDir := sortDirection(sort.Order)
+	order := keyExpr + " " + orderDir
+	cur, err := decodeCursor(page.Cursor, order)
+	if err != nil {
+		return nil, fmt.Errorf("files: %w", err)
+	}
+
 	// Count
-	countSQL := "SELECT COUNT(*) FROM files " + whereClause
 	var totalCount int
-	if err := q.store.DB().QueryRow(countSQL, args...).Scan(&totalCount); err != nil {
-		return nil, fmt.Errorf("files: count: %w", err)
+	if cur != nil {
+		totalCount = cur.Total
+	} else {
+		countSQL := "SELECT COUNT(*) FROM files " + whereClause
+		if err := q.store.ReadDB().QueryRow(countSQL, args...).Scan(&totalCount); err != nil {
+			return nil, fmt.Errorf("files: count: %w", err)
+		}
 	}
 
 	// Data
-	orderCol := fileSortColumn(sort.Field)
-	orderDir := sortDirection(sort.Order)
+	orderBy, cond, condArgs := keyset(keyExpr, "id", orderDir, cur)
+	if cond != "" {
+		whereClause = "WHERE " + strings.Join(append(where, cond), " AND ")
+		args = append(args, condArgs...)
+	}
 
 	dataSQL := fmt.Sprintf(
-		`SELECT id, path, language, hash, line_count, last_indexed FROM files %s ORDER BY %s %s LIMIT ? OFFSET ?`,
-		whereClause, orderCol, orderDir,
+		`SELECT id, path, language, hash, line_count, last_indexed FROM files %s %s LIMIT ? OFFSET ?`,
+		whereClause, orderBy,
 	)
-	dataArgs := append(append([]any{}, args...), *page.Limit, page.Offset)
+	limit, offset := pageWindow(page, cur)
+	dataArgs := append(append([]any{}, args...), limit, offset)
 
-	rows, err := q.store.DB().Query(dataSQL, dataArgs...)
+	rows, err := q.store.ReadDB().Query(dataSQL, dataArgs...)
 	if err != nil {
 		return nil, fmt.Errorf("files: query: %w", err)
 	}
@@ -332,7 +381,9 @@ func (q *QueryBuilder) Files(pathPrefix string, language string, sort Sort, page
 		items = []File{}
 	}
 
-	return &PagedResult[File]{Items: items, TotalCount: totalCount}, nil
+	return finishPage(items, page, order, totalCount, func(f File) (any, int64) {
+		return keyOf(f), f.ID
+	}), nil
 }
 
 // Packages is a convenience method for listing packages, modules, and namespaces.
@@ -360,102 +411,64 @@ func (q *QueryBuilder) SearchSymbols(pattern string, filter SymbolFilter, sort S
 	if pattern != "" && pattern != "*" {
 		likePattern := escapeLike(pattern)
 		likePattern = strings.ReplaceAll(likePattern, "*", "%")
+		if cond, condArgs := trigramCondition(pattern); cond != "" {
+			where = append(where, cond)
+			args = append(args, condArgs...)
+		}
 		where = append(where, "s.name LIKE ? ESCAPE '\\'")
 		args = append(args, likePattern)
 	}
 
 	// Apply the same structured filters as Symbols
-	if len(filter.Kinds) > 0 {
-		placeholders := strings.Repeat("?,", len(filter.Kinds)-1) + "?"
-		where = append(where, "s.kind IN ("+placeholders+")")
-		for _, k := range filter.Kinds {
-			args = append(args, k)
-		}
-	}
-	if filter.Visibility != nil {
-		where = append(where, "s.visibility = ?")
-		args = append(args, *filter.Visibility)
-	}
-	if filter.FileID != nil {
-		where = append(where, "s.file_id = ?")
-		args = append(args, *filter.FileID)
-	}
-	if filter.ParentID != nil {
-		where = append(where, "s.parent_symbol_id = ?")
-		args = append(args, *filter.ParentID)
-	}
-	if filter.PathPrefix != nil {
-		prefix := normalizePathPrefix(*filter.PathPrefix)
-		if prefix != "" {
-			where = append(where, "f.path LIKE ? ESCAPE '\\'")
-			args = append(args, escapeLike(prefix)+"%")
-		}
-	}
-	for _, mod := range filter.Modifiers {
-		where = append(where, "EXISTS (SELECT 1 FROM json_each(s.modifiers) WHERE json_each.value = ?)")
-		args = append(args, mod)
-	}
+	fw, fargs := symbolFilterConditions(filter)
+	where = append(where, fw...)
+	args = append(args, fargs...)
 
 	whereClause := ""
 	if len(where) > 0 {
 		whereClause = "WHERE " + strings.Join(where, " AND ")
 	}
 
-	// Build HAVING clause for ref count filters
-	var having []string
-	var havingArgs []any
-	refCountSubquery := `(SELECT COUNT(*) FROM resolved_references rr WHERE rr.target_symbol_id = s.id)`
-	if filter.RefCountMin != nil {
-		having = append(having, refCountSubquery+" >= ?")
-		havingArgs = append(havingArgs, *filter.RefCountMin)
-	}
-	if filter.RefCountMax != nil {
-		having = append(having, refCountSubquery+" <= ?")
-		havingArgs = append(havingArgs, *filter.RefCountMax)
-	}
-
-	groupByClause := ""
-	havingClause := ""
-	if len(having) > 0 {
-		groupByClause = " GROUP BY s.id"
-		havingClause = " HAVING " + strings.Join(having, " AND ")
+	keyExpr, keyOf := symbolSortKey(sort.Field, true)
+	orderDir := sortDirection(sort.Order)
+	order := keyExpr + " " + orderDir
+	cur, err := decodeCursor(page.Cursor, order)
+	if err != nil {
+		return nil, fmt.Errorf("search symbols: %w", err)
 	}
 
-	// Count
 	var totalCount int
-	if len(having) > 0 {
-		countSQL := fmt.Sprintf(`SELECT COUNT(*) FROM (SELECT s.id FROM symbols s LEFT JOIN files f ON s.file_id = f.id %s%s%s)`,
-			whereClause, groupByClause, havingClause)
-		countArgs := append(append([]any{}, args...), havingArgs...)
-		if err := q.store.DB().QueryRow(countSQL, countArgs...).Scan(&totalCount); err != nil {
-			return nil, fmt.Errorf("search symbols: count: %w", err)
-		}
+	if cur != nil {
+		totalCount = cur.Total
 	} else {
-		countSQL := `SELECT COUNT(*) FROM symbols s LEFT JOIN files f ON s.file_id = f.id ` + whereClause
-		if err := q.store.DB().QueryRow(countSQL, args...).Scan(&totalCount); err != nil {
+		countSQL := `SELECT COUNT(*) FROM symbols s LEFT JOIN files f ON s.file_id = f.id ` + symbolStatsJoin + " " + whereClause
+		if err := q.store.ReadDB().QueryRow(countSQL, args...).Scan(&totalCount); err != nil {
 			return nil, fmt.Errorf("search symbols: count: %w", err)
 		}
 	}
 
 	// Data
-	orderCol := symbolSortColumn(sort.Field)
-	orderDir := sortDirection(sort.Order)
+	orderBy, cond, condArgs := keyset(keyExpr, "s.id", orderDir, cur)
+	if cond != "" {
+		whereClause = "WHERE " + strings.Join(append(where, cond), " AND ")
+		args = append(args, condArgs...)
+	}
 
 	dataSQL := fmt.Sprintf(
 		`SELECT %s, COALESCE(f.path, '') AS file_path,
-			(SELECT COUNT(*) FROM resolved_references rr WHERE rr.target_symbol_id = s.id) AS ref_count,
-			(SELECT COUNT(*) FROM resolved_references rr JOIN references_ r ON r.id = rr.reference_id WHERE rr.target_symbol_id = s.id AND r.file_id != s.file_id) AS external_ref_count
+			%s
 		 FROM symbols s
 		 LEFT JOIN files f ON s.file_id = f.id
-		 %s%s%s
-		 ORDER BY %s %s
+		 %s
+		 %s
+		 %s
 		 LIMIT ? OFFSET ?`,
-		prefixSymbolCols("s"), whereClause, groupByClause, havingClause, orderCol, orderDir,
+		prefixSymbolCols("s"), statsCountCols, symbolStatsJoin, whereClause, orderBy,
 	)
-	dataArgs := append(append([]any{}, args...), havingArgs...)
-	dataArgs = append(dataArgs, *page.Limit, page.Offset)
+	limit, offset := pageWindow(page, cur)
+	dataArgs := append(append([]any{}, args...), limit, offset)
 
-	rows, err := q.store.DB().Query(dataSQL, dataArgs...)
+	rows, err := q.store.ReadDB().Query(dataSQL, dataArgs...)
 	if err != nil {
 		return nil, fmt.Errorf("search symbols: query: %w", err)
 	}
@@ -476,7 +489,9 @@ func (q *QueryBuilder) SearchSymbols(pattern string, filter SymbolFilter, sort S
 		items = []SymbolResult{}
 	}
 
-	return &PagedResult[SymbolResult]{Items: items, TotalCount: totalCount}, nil
+	return finishPage(items, page, order, totalCount, func(sr SymbolResult) (any, int64) {
+		return keyOf(sr), sr.ID
+	}), nil
 }
 
 // --- Digest Endpoints ---
@@ -502,7 +517,7 @@ func (q *QueryBuilder) ProjectSummary(topN int) (*ProjectSummary, error) {
 	summary := &ProjectSummary{}
 
 	// Language stats: file count and line count per language
-	langRows, err := q.store.DB().Query(
+	langRows, err := q.store.ReadDB().Query(
 		`SELECT language, COUNT(*), COALESCE(SUM(line_count), 0) FROM files GROUP BY language ORDER BY language`,
 	)
 	if err != nil {
@@ -527,7 +542,7 @@ func (q *QueryBuilder) ProjectSummary(topN int) (*ProjectSummary, error) {
 		lang := &languages[i]
 
 		// Symbol count and kind counts
-		kindRows, err := q.store.DB().Query(
+		kindRows, err := q.store.ReadDB().Query(
 			`SELECT s.kind, COUNT(*) FROM symbols s
 			 JOIN files f ON s.file_id = f.id
 			 WHERE f.language = ?
@@ -561,7 +576,7 @@ func (q *QueryBuilder) ProjectSummary(topN int) (*ProjectSummary, error) {
 	}
 
 	// Package count
-	err = q.store.DB().QueryRow(
+	err = q.store.ReadDB().QueryRow(
 		`SELECT COUNT(*) FROM symbols WHERE kind IN ('package', 'module', 'namespace')`,
 	).Scan(&summary.PackageCount)
 	if err != nil {
@@ -571,17 +586,16 @@ func (q *QueryBuilder) ProjectSummary(topN int) (*ProjectSummary, error) {
 	// Top-N symbols by ref count
 	if topN > 0 {
 		topSQL := fmt.Sprintf(
-			`SELECT %s, COALESCE(f.path, '') AS file_path,
-				(SELECT COUNT(*) FROM resolved_references rr WHERE rr.target_symbol_id = s.id) AS ref_count,
-				(SELECT COUNT(*) FROM resolved_references rr JOIN references_ r ON r.id = rr.reference_id WHERE rr.target_symbol_id = s.id AND r.file_id != s.file_id) AS external_ref_count
-			 FROM symbols s
+			`SELECT %s, COALESCE(f.path, '') AS file_path, %s
+			 FROM symbol_stats st
+			 JOIN symbols s ON s.id = st.symbol_id
 			 LEFT JOIN files f ON s.file_id = f.id
-			 WHERE (SELECT COUNT(*) FROM resolved_references rr2 WHERE rr2.target_symbol_id = s.id) > 0
-			 ORDER BY external_ref_count DESC
+			 WHERE st.ref_count > 0
+			 ORDER BY st.external_ref_count DESC, st.symbol_id
 			 LIMIT ?`,
-			prefixSymbolCols("s"),
+			prefixSymbolCols("s"), statsCountCols,
 		)
-		topRows, err := q.store.DB().Query(topSQL, topN)
+		topRows, err := q.store.ReadDB().Query(topSQL, topN)
 		if err != nil {
 			return nil, fmt.Errorf("project summary: top symbols: %w", err)
 		}
@@ -626,14 +640,14 @@ func (q *QueryBuilder) PackageSummary(packagePath string, packageID *int64) (*Pa
 	} else if packagePath != "" {
 		// Resolve path to package symbol ID:
 		// Find files under this path, then locate the package/module/namespace symbol in those files.
-		prefix := normalizePathPrefix(packagePath)
-		row := q.store.DB().QueryRow(
+		lo, hi := pathPrefixBounds(normalizePathPrefix(packagePath))
+		row := q.store.ReadDB().QueryRow(
 			`SELECT s.id FROM symbols s
 			 JOIN files f ON s.file_id = f.id
-			 WHERE f.path LIKE ? ESCAPE '\'
+			 WHERE f.path COLLATE NOCASE >= ? AND f.path COLLATE NOCASE < ?
 			   AND s.kind IN ('package', 'module', 'namespace')
 			 LIMIT 1`,
-			escapeLike(prefix)+"%",
+			lo, hi,
 		)
 		if err := row.Scan(&symID); err == sql.ErrNoRows {
 			return nil, fmt.Errorf("package summary: no package found at path %q", packagePath)
@@ -645,15 +659,14 @@ func (q *QueryBuilder) PackageSummary(packagePath string, packageID *int64) (*Pa
 	}
 
 	// Load the package symbol itself
-	symRow := q.store.DB().QueryRow(
+	symRow := q.store.ReadDB().QueryRow(
 		fmt.Sprintf(
-			`SELECT %s, COALESCE(f.path, '') AS file_path,
-				(SELECT COUNT(*) FROM resolved_references rr WHERE rr.target_symbol_id = s.id) AS ref_count,
-				(SELECT COUNT(*) FROM resolved_references rr JOIN references_ r ON r.id = rr.reference_id WHERE rr.target_symbol_id = s.id AND r.file_id != s.file_id) AS external_ref_count
+			`SELECT %s, COALESCE(f.path, '') AS file_path, %s
 			 FROM symbols s
 			 LEFT JOIN files f ON s.file_id = f.id
+			 %s
 			 WHERE s.id = ?`,
-			prefixSymbolCols("s"),
+			prefixSymbolCols("s"), statsCountCols, symbolStatsJoin,
 		),
 		symID,
 	)
@@ -681,11 +694,13 @@ func (q *QueryBuilder) PackageSummary(packagePath string, packageID *int64) (*Pa
 		pathPrefix = normalizePathPrefix(packagePath)
 	}
 
+	lo, hi := pathPrefixBounds(pathPrefix)
+
 	// File count
 	if pathPrefix != "" {
-		err = q.store.DB().QueryRow(
-			`SELECT COUNT(*) FROM files WHERE path LIKE ? ESCAPE '\'`,
-			escapeLike(pathPrefix)+"%",
+		err = q.store.ReadDB().QueryRow(
+			`SELECT COUNT(*) FROM files WHERE path COLLATE NOCASE >= ? AND path COLLATE NOCASE < ?`,
+			lo, hi,
 		).Scan(&summary.FileCount)
 		if err != nil {
 			return nil, fmt.Errorf("package summary: file count: %w", err)
@@ -695,18 +710,17 @@ func (q *QueryBuilder) PackageSummary(packagePath string, packageID *int64) (*Pa
 	// Exported symbols (public visibility) within this package's files, sorted by ref count desc
 	if pathPrefix != "" {
 		expSQL := fmt.Sprintf(
-			`SELECT %s, COALESCE(f.path, '') AS file_path,
-				(SELECT COUNT(*) FROM resolved_references rr WHERE rr.target_symbol_id = s.id) AS ref_count,
-				(SELECT COUNT(*) FROM resolved_references rr JOIN references_ r ON r.id = rr.reference_id WHERE rr.target_symbol_id = s.id AND r.file_id != s.file_id) AS external_ref_count
+			`SELECT %s, COALESCE(f.path, '') AS file_path, %s
 			 FROM symbols s
 			 JOIN files f ON s.file_id = f.id
-			 WHERE f.path LIKE ? ESCAPE '\'
+			 %s
+			 WHERE f.path COLLATE NOCASE >= ? AND f.path COLLATE NOCASE < ?
 			   AND s.visibility = 'public'
 			   AND s.kind NOT IN ('package', 'module', 'namespace')
 			 ORDER BY external_ref_count DESC`,
-			prefixSymbolCols("s"),
+			prefixSymbolCols("s"), statsCountCols, symbolStatsJoin,
 		)
-		expRows, err := q.store.DB().Query(expSQL, escapeLike(pathPrefix)+"%")
+		expRows, err := q.store.ReadDB().Query(expSQL, lo, hi)
 		if err != nil {
 			return nil, fmt.Errorf("package summary: exported symbols: %w", err)
 		}
@@ -730,12 +744,12 @@ func (q *QueryBuilder) PackageSummary(packagePath string, packageID *int64) (*Pa
 	// Kind counts for symbols in this package
 	summary.KindCounts = make(map[string]int)
 	if pathPrefix != "" {
-		kindRows, err := q.store.DB().Query(
+		kindRows, err := q.store.ReadDB().Query(
 			`SELECT s.kind, COUNT(*) FROM symbols s
 			 JOIN files f ON s.file_id = f.id
-			 WHERE f.path LIKE ? ESCAPE '\'
+			 WHERE f.path COLLATE NOCASE >= ? AND f.path COLLATE NOCASE < ?
 			 GROUP BY s.kind`,
-			escapeLike(pathPrefix)+"%",
+			lo, hi,
 		)
 		if err != nil {
 			return nil, fmt.Errorf("package summary: kind counts: %w", err)
@@ -758,12 +772,12 @@ func (q *QueryBuilder) PackageSummary(packagePath string, packageID *int64) (*Pa
 	// Dependencies: import sources from files in this package
 	summary.Dependencies = []string{}
 	if pathPrefix != "" {
-		depRows, err := q.store.DB().Query(
+		depRows, err := q.store.ReadDB().Query(
 			`SELECT DISTINCT i.source FROM imports i
 			 JOIN files f ON i.file_id = f.id
-			 WHERE f.path LIKE ? ESCAPE '\'
+			 WHERE f.path COLLATE NOCASE >= ? AND f.path COLLATE NOCASE < ?
 			 ORDER BY i.source`,
-			escapeLike(pathPrefix)+"%",
+			lo, hi,
 		)
 		if err != nil {
 			return nil, fmt.Errorf("package summary: dependencies: %w", err)
@@ -788,7 +802,7 @@ func (q *QueryBuilder) PackageSummary(packagePath string, packageID *int64) (*Pa
 	pkgName := pkgSymbol.Name
 	if pkgName != "" {
 		// Find files that import this package name (direct or as suffix)
-		dentRows, err := q.store.DB().Query(
+		dentRows, err := q.store.ReadDB().Query(
 			`SELECT DISTINCT f.path FROM imports i
 			 JOIN files f ON i.file_id = f.id
 			 WHERE i.source = ? OR i.source LIKE ?
@@ -857,6 +871,47 @@ func scanSymbolResult(row scanner) (SymbolResult, error) {
 	return sr, nil
 }
 
+// maxSearchTrigrams caps the trigrams a search intersects. A few are
+// selective enough; past that each extra lookup costs more than it prunes.
+const maxSearchTrigrams = 6
+
+// trigramCondition returns a condition narrowing s to symbols whose names
+// contain every trigram of the literal parts of a glob pattern, looked up
+// in the symbol_trigrams index. The LIKE filter still decides the match;
+// this only lets SQLite skip the scan of symbols. Patterns with no literal
+// part of three or more bytes yield no condition. Pure prefixes use it too:
+// LIKE is case-insensitive, so it cannot use the BINARY name index either.
+func trigramCondition(pattern string) (string, []any) {
+	var tris []int64
+	seen := make(map[int64]bool)
+	for _, part := range strings.Split(pattern, "*") {
+		for _, t := range store.Trigrams(part) {
+			if !seen[t] {
+				seen[t] = true
+				tris = append(tris, t)
+			}
+		}
+	}
+	if len(tris) == 0 {
+		return "", nil
+	}
+	// Spread the picks across the pattern rather than taking its start.
+	if len(tris) > maxSearchTrigrams {
+		picked := make([]int64, maxSearchTrigrams)
+		for i := range picked {
+			picked[i] = tris[i*(len(tris)-1)/(maxSearchTrigrams-1)]
+		}
+		tris = picked
+	}
+	selects := make([]string, len(tris))
+	args := make([]any, len(tris))
+	for i, t := range tris {
+		selects[i] = "SELECT symbol_id FROM symbol_trigrams WHERE trigram = ?"
+		args[i] = t
+	}
+	return "s.id IN (" + strings.Join(selects, " INTERSECT ") + ")", args
+}
+
 // escapeLike escapes SQL LIKE special characters (% and _) with backslash.
 func escapeLike(s string) string {
 	s = strings.ReplaceAll(s, `\`, `\\`)
@@ -51,6 +51,8 @@ func insertSymbolWithParent(t *testing.T, s *store.Store, fileID *int64, name, k
 	return id
 }
 
+// insertResolvedRef adds a reference from fileID resolved to
+// targetSymbolID and recounts symbol_stats, as Resolve would.
 func insertResolvedRef(t *testing.T, s *store.Store, fileID, targetSymbolID int64) {
 	t.Helper()
 	refID, err := s.InsertReference(&store.Reference{
@@ -61,6 +63,7 @@ func insertResolvedRef(t *testing.T, s *store.Store, fileID, targetSymbolID int6
 		ReferenceID: refID, TargetSymbolID: targetSymbolID, Confidence: 1.0, ResolutionKind: "direct",
 	})
 	require.NoError(t, err)
+	require.NoError(t, s.RefreshSymbolStats())
 }
 
 func strPtr(s string) *string { return &s }
@@ -573,6 +576,24 @@ func TestFiles_FilterByPathPrefix(t *testing.T) {
 	assert.Equal(t, 2, result.TotalCount) // store.go and helpers.go, NOT store_utils
 }
 
+func TestFiles_FilterByPathPrefix_RangeBounds(t *testing.T) {
+	t.Parallel()
+	q, s := newTestQueryBuilder(t)
+	insertFile(t, s, "pkg/a_b/x.go", "go")
+	insertFile(t, s, "pkg/a_b/sub/y.go", "go")
+	insertFile(t, s, "pkg/axb/z.go", "go")  // "_" is not a wildcard
+	insertFile(t, s, "pkg/a_b0/w.go", "go") // just past the range
+	insertFile(t, s, "pkg/A_B/v.go", "go")  // prefixes ignore ASCII case, as LIKE did
+	insertFile(t, s, "pkg/a_b.go", "go")
+
+	result, err := q.Files("pkg/a_b", "", Sort{Field: SortByFile, Order: Asc}, Pagination{})
+	require.NoError(t, err)
+	require.Equal(t, 3, result.TotalCount)
+	assert.Equal(t, "pkg/A_B/v.go", result.Items[0].Path)
+	assert.Equal(t, "pkg/a_b/sub/y.go", result.Items[1].Path)
+	assert.Equal(t, "pkg/a_b/x.go", result.Items[2].Path)
+}
+
 func TestFiles_CombinedFilter(t *testing.T) {
 	t.Parallel()
 	q, s := newTestQueryBuilder(t)
@@ -809,6 +830,23 @@ func TestSearchSymbols_ExactMatch(t *testing.T) {
 	assert.Equal(t, "Foo", result.Items[0].Name)
 }
 
+func TestTrigramCondition(t *testing.T) {
+	t.Parallel()
+
+	cond, args := trigramCondition("*Handler")
+	assert.Contains(t, cond, "symbol_trigrams")
+	assert.Len(t, args, 5)
+
+	// Only literal runs of three or more bytes contribute.
+	cond, _ = trigramCondition("*a*bc*")
+	assert.Empty(t, cond)
+	_, args = trigramCondition("ab*cde")
+	assert.Len(t, args, 1)
+
+	_, args = trigramCondition("*VeryLongSymbolNameHandler*")
+	assert.Len(t, args, maxSearchTrigrams)
+}
+
 func TestSearchSymbols_CaseInsensitive(t *testing.T) {
 	// SQLite LIKE is case-insensitive for ASCII by default, which is useful for symbol search.
 	t.Parallel()
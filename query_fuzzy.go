@@ -0,0 +1,395 @@
+package canopy
+
+import (
+	"container/heap"
+	"database/sql"
+	"fmt"
+	"slices"
+	"strings"
+)
+
+// --- Fuzzy Search ---
+
+// nameTable is a snapshot of every symbol name laid out for scanning:
+// names are concatenated into one byte slice and the per-symbol columns are
+// parallel arrays indexed by row, so a search walks contiguous memory
+// instead of the symbols table.
+type nameTable struct {
+	ids     []int64
+	offsets []uint32 // row i's name is names[offsets[i]:offsets[i+1]]
+	names   []byte
+	masks   []uint64 // charMask of each name
+	kinds   []uint8  // index into kindNames
+	// kindNames lists the distinct kinds. Past 256 of them the extra kinds
+	// share the last index and kindOverflow is set; Kinds filters are then
+	// left to SQL.
+	kindNames    []string
+	kindOverflow bool
+}
+
+func (t *nameTable) name(i int) []byte {
+	return t.names[t.offsets[i]:t.offsets[i+1]]
+}
+
+func (q *QueryBuilder) buildNameTable() (*nameTable, error) {
+	rows, err := q.store.ReadDB().Query("SELECT id, name, kind FROM symbols ORDER BY id")
+	if err != nil {
+		return nil, fmt.Errorf("name table: %w", err)
+	}
+	defer rows.Close()
+
+	t := &nameTable{offsets: []uint32{0}}
+	kindIdx := make(map[string]uint8)
+	for rows.Next() {
+		var id int64
+		var name sql.RawBytes
+		var kind string
+		if err := rows.Scan(&id, &name, &kind); err != nil {
+			return nil, fmt.Errorf("name table: scan: %w", err)
+		}
+		k, ok := kindIdx[kind]
+		if !ok {
+			if len(t.kindNames) < 256 {
+				k = uint8(len(t.kindNames))
+				kindIdx[kind] = k
+				t.kindNames = append(t.kindNames, kind)
+			} else {
+				k, t.kindOverflow = 255, true
+			}
+		}
+		t.ids = append(t.ids, id)
+		t.names = append(t.names, name...)
+		t.offsets = append(t.offsets, uint32(len(t.names)))
+		t.masks = append(t.masks, charMask(name))
+		t.kinds = append(t.kinds, k)
+	}
+	if err := rows.Err(); err != nil {
+		return nil, fmt.Errorf("name table: rows: %w", err)
+	}
+	return t, nil
+}
+
+// symbolNameTable returns the name table, shared between calls when the
+// derived cache is enabled.
+func (q *QueryBuilder) symbolNameTable() (*nameTable, error) {
+	if q.derived == nil {
+		return q.buildNameTable()
+	}
+	return q.derived.nameTable(q)
+}
+
+// charMask sets one bit per distinct character class in s: a letter
+// (case-folded), a digit, '_', or a bucket shared by other bytes. A name can
+// only contain a query as a subsequence if the query's mask is a subset of
+// the name's, which rejects most rows with one AND before any matching.
+func charMask(s []byte) uint64 {
+	var m uint64
+	for _, c := range s {
+		m |= 1 << charBit(c)
+	}
+	return m
+}
+
+func charBit(c byte) uint {
+	switch {
+	case 'a' <= c && c <= 'z':
+		return uint(c - 'a')
+	case 'A' <= c && c <= 'Z':
+		return uint(c - 'A')
+	case '0' <= c && c <= '9':
+		return 26 + uint(c-'0')
+	case c == '_':
+		return 36
+	default:
+		return 37 + uint(c)%27
+	}
+}
+
+// Fuzzy scoring follows fzf's v1 matcher: each query character earns a
+// base score, more at word boundaries and camelCase humps, more still when
+// it directly follows the previous match, and gaps between matches cost.
+const (
+	fuzzyMatchScore      = 16
+	fuzzyBoundaryBonus   = 8
+	fuzzyCamelBonus      = 7
+	fuzzyConsecutive     = 4
+	fuzzyGapStart        = -3
+	fuzzyGapExtension    = -1
+	fuzzyExactCaseBonus  = 1
+	fuzzyFirstCharFactor = 2
+)
+
+func foldByte(c byte) byte {
+	if 'A' <= c && c <= 'Z' {
+		return c + 'a' - 'A'
+	}
+	return c
+}
+
+func isSeparator(c byte) bool {
+	switch c {
+	case '_', '.', '-', '/', ':', ' ', '$', '#', '<', '(':
+		return true
+	}
+	return false
+}
+
+func isLowerOrDigit(c byte) bool {
+	return ('a' <= c && c <= 'z') || ('0' <= c && c <= '9')
+}
+
+// fuzzyScore matches query (already case-folded to folded) against name as
+// a case-insensitive subsequence and scores the match. The match is the
+// shortest window ending at the first complete forward match, found by
+// scanning back from its end.
+func fuzzyScore(name, query, folded []byte) (int, bool) {
+	if len(folded) == 0 {
+		return 0, true
+	}
+	// Forward pass: the earliest end of a subsequence match.
+	pi := 0
+	end := -1
+	for i := 0; i < len(name); i++ {
+		if foldByte(name[i]) == folded[pi] {
+			pi++
+			if pi == len(folded) {
+				end = i + 1
+				break
+			}
+		}
+	}
+	if end < 0 {
+		return 0, false
+	}
+	// Backward pass: the latest start that still matches before end.
+	pi = len(folded) - 1
+	start := 0
+	for i := end - 1; i >= 0; i-- {
+		if foldByte(name[i]) == folded[pi] {
+			pi--
+			if pi < 0 {
+				start = i
+				break
+			}
+		}
+	}
+
+	score := 0
+	pi = 0
+	lastMatch := -1
+	for i := start; i < end && pi < len(folded); i++ {
+		c := name[i]
+		if foldByte(c) != folded[pi] {
+			continue
+		}
+		bonus := 0
+		switch {
+		case i == 0 || isSeparator(name[i-1]):
+			bonus = fuzzyBoundaryBonus
+		case 'A' <= c && c <= 'Z' && isLowerOrDigit(name[i-1]):
+			bonus = fuzzyCamelBonus
+		}
+		if pi == 0 {
+			bonus *= fuzzyFirstCharFactor
+		}
+		score += fuzzyMatchScore + bonus
+		if c == query[pi] {
+			score += fuzzyExactCaseBonus
+		}
+		if lastMatch >= 0 {
+			if gap := i - lastMatch - 1; gap == 0 {
+				score += fuzzyConsecutive
+			} else {
+				score += fuzzyGapStart + fuzzyGapExtension*(gap-1)
+			}
+		}
+		lastMatch = i
+		pi++
+	}
+	return score, true
+}
+
+type fuzzyMatch struct {
+	row   int32
+	score int32
+	size  int32 // name length, the first tie-breaker
+}
+
+// better orders matches by score, then shorter names, then table order.
+func (a fuzzyMatch) better(b fuzzyMatch) bool {
+	if a.score != b.score {
+		return a.score > b.score
+	}
+	if a.size != b.size {
+		return a.size < b.size
+	}
+	return a.row < b.row
+}
+
+// worstFirst is a heap whose root is the weakest of the matches kept.
+type worstFirst []fuzzyMatch
+
+func (h worstFirst) Len() int           { return len(h) }
+func (h worstFirst) Less(i, j int) bool { return h[j].better(h[i]) }
+func (h worstFirst) Swap(i, j int)      { h[i], h[j] = h[j], h[i] }
+func (h *worstFirst) Push(x any)        { *h = append(*h, x.(fuzzyMatch)) }
+func (h *worstFirst) Pop() any {
+	old := *h
+	x := old[len(old)-1]
+	*h = old[:len(old)-1]
+	return x
+}
+
+// scan returns the rows matching query whose kind is allowed (nil allows
+// every kind), best first. With k > 0 only the best k are kept.
+func (t *nameTable) scan(query string, allowed *[256]bool, k int) []fuzzyMatch {
+	q := []byte(query)
+	folded := make([]byte, len(q))
+	for i, c := range q {
+		folded[i] = foldByte(c)
+	}
+	qmask := charMask(q)
+
+	var out []fuzzyMatch
+	h := &worstFirst{}
+	for i, m := range t.masks {
+		if m&qmask != qmask || (allowed != nil && !allowed[t.kinds[i]]) {
+			continue
+		}
+		name := t.name(i)
+		score, ok := fuzzyScore(name, q, folded)
+		if !ok {
+			continue
+		}
+		fm := fuzzyMatch{row: int32(i), score: int32(score), size: int32(len(name))}
+		switch {
+		case k <= 0:
+			out = append(out, fm)
+		case h.Len() < k:
+			heap.Push(h, fm)
+		case fm.better((*h)[0]):
+			(*h)[0] = fm
+			heap.Fix(h, 0)
+		}
+	}
+	if k > 0 {
+		out = *h
+	}
+	slices.SortFunc(out, func(a, b fuzzyMatch) int {
+		if a.better(b) {
+			return -1
+		}
+		if b.better(a) {
+			return 1
+		}
+		return 0
+	})
+	return out
+}
+
+// kindSet maps kinds to the table's kind indexes. Kinds absent from the
+// table match nothing.
+func (t *nameTable) kindSet(kinds []string) *[256]bool {
+	var set [256]bool
+	for _, k := range kinds {
+		if i := slices.Index(t.kindNames, k); i >= 0 {
+			set[i] = true
+		}
+	}
+	return &set
+}
+
+// fuzzyFetchChunk is how many ranked candidates are looked up per query
+// when filters other than Kinds have to be checked in SQL.
+const fuzzyFetchChunk = 500
+
+// FuzzySearch ranks symbols whose names contain query as a case-insensitive
+// subsequence ("hdlreq" finds "HandleRequest"), fzf-style: matches at word
+// boundaries, camelCase humps and in runs score higher, gaps score lower,
+// and ties go to shorter names. Returns at most limit results, best first
+// (limit defaults to 50, max 500). An empty query ranks every symbol by
+// name length.
+//
+// Matching runs over an in-memory table of all symbol names, kept between
+// calls with WithDerivedCache; filter is applied on top, with Kinds checked
+// in the table and the remaining fields in SQL.
+func (q *QueryBuilder) FuzzySearch(query string, filter SymbolFilter, limit int) ([]SymbolResult, error) {
+	if limit <= 0 {
+		limit = defaultLimit
+	}
+	limit = min(limit, maxLimit)
+
+	t, err := q.symbolNameTable()
+	if err != nil {
+		return nil, fmt.Errorf("fuzzy search: %w", err)
+	}
+
+	var allowed *[256]bool
+	sqlFilter := filter
+	if len(filter.Kinds) > 0 && !t.kindOverflow {
+		allowed = t.kindSet(filter.Kinds)
+		sqlFilter.Kinds = nil
+	}
+	where, args := symbolFilterConditions(sqlFilter)
+
+	// Without SQL filters every candidate survives, so only the best limit
+	// need ranking; otherwise rank them all and fetch until limit pass.
+	k := 0
+	if len(where) == 0 {
+		k = limit
+	}
+	matches := t.scan(query, allowed, k)
+
+	results := make([]SymbolResult, 0, min(limit, len(matches)))
+	for len(matches) > 0 && len(results) < limit {
+		chunk := matches[:min(len(matches), max(fuzzyFetchChunk, limit))]
+		matches = matches[len(chunk):]
+		found, err := q.fuzzyFetch(t, chunk, where, args)
+		if err != nil {
+			return nil, err
+		}
+		for _, m := range chunk {
+			if sr, ok := found[t.ids[m.row]]; ok && len(results) < limit {
+				results = append(results, sr)
+			}
+		}
+	}
+	return results, nil
+}
+
+// fuzzyFetch loads the candidates in chunk that satisfy where, keyed by ID.
+// Rows deleted since the table was built are simply absent.
+func (q *QueryBuilder) fuzzyFetch(t *nameTable, chunk []fuzzyMatch, where []string, args []any) (map[int64]SymbolResult, error) {
+	ids := make([]any, len(chunk))
+	for i, m := range chunk {
+		ids[i] = t.ids[m.row]
+	}
+	conds := append([]string{"s.id IN (" + strings.TrimSuffix(strings.Repeat("?,", len(ids)), ",") + ")"}, where...)
+	dataSQL := fmt.Sprintf(
+		`SELECT %s, COALESCE(f.path, '') AS file_path,
+			%s
+		 FROM symbols s
+		 LEFT JOIN files f ON s.file_id = f.id
+		 %s
+		 WHERE %s`,
+		prefixSymbolCols("s"), statsCountCols, symbolStatsJoin, strings.Join(conds, " AND "),
+	)
+	rows, err := q.store.ReadDB().Query(dataSQL, append(ids, args...)...)
+	if err != nil {
+		return nil, fmt.Errorf("fuzzy search: query: %w", err)
+	}
+	defer rows.Close()
+
+	found := make(map[int64]SymbolResult, len(chunk))
+	for rows.Next() {
+		sr, err := scanSymbolResult(rows)
+		if err != nil {
+			return nil, fmt.Errorf("fuzzy search: scan: %w", err)
+		}
+		found[sr.ID] = sr
+	}
+	if err := rows.Err(); err != nil {
+		return nil, fmt.Errorf("fuzzy search: rows: %w", err)
+	}
+	return found, nil
+}
@@ -0,0 +1,143 @@
+package canopy
+
+import (
+	"testing"
+
+	"github.com/jward/canopy/internal/store"
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func fuzzyNames(items []SymbolResult) []string {
+	names := make([]string, len(items))
+	for i, sr := range items {
+		names[i] = sr.Name
+	}
+	return names
+}
+
+func TestFuzzySearch_RanksBoundaryMatchesFirst(t *testing.T) {
+	t.Parallel()
+	q, s := newTestQueryBuilder(t)
+	fID := insertFile(t, s, "main.go", "go")
+	insertSymbol(t, s, &fID, "threadLocal", "variable", "private", nil)
+	insertSymbol(t, s, &fID, "Handler", "type", "public", nil)
+	insertSymbol(t, s, &fID, "Shadow", "type", "public", nil)
+
+	items, err := q.FuzzySearch("hdl", SymbolFilter{}, 0)
+	require.NoError(t, err)
+	assert.Equal(t, []string{"Handler", "threadLocal"}, fuzzyNames(items))
+	assert.Equal(t, "main.go", items[0].FilePath)
+}
+
+func TestFuzzySearch_TiesPreferShorterNames(t *testing.T) {
+	t.Parallel()
+	q, s := newTestQueryBuilder(t)
+	fID := insertFile(t, s, "main.go", "go")
+	insertSymbol(t, s, &fID, "Foobar", "function", "public", nil)
+	insertSymbol(t, s, &fID, "Foo", "function", "public", nil)
+
+	items, err := q.FuzzySearch("foo", SymbolFilter{}, 0)
+	require.NoError(t, err)
+	assert.Equal(t, []string{"Foo", "Foobar"}, fuzzyNames(items))
+}
+
+func TestFuzzySearch_Filters(t *testing.T) {
+	t.Parallel()
+	q, s := newTestQueryBuilder(t)
+	fID := insertFile(t, s, "main.go", "go")
+	insertSymbol(t, s, &fID, "Run", "function", "public", nil)
+	insertSymbol(t, s, &fID, "Runner", "class", "public", nil)
+	insertSymbol(t, s, &fID, "run", "function", "private", nil)
+
+	items, err := q.FuzzySearch("run", SymbolFilter{Kinds: []string{"function"}}, 0)
+	require.NoError(t, err)
+	assert.ElementsMatch(t, []string{"Run", "run"}, fuzzyNames(items))
+
+	items, err = q.FuzzySearch("run", SymbolFilter{Kinds: []string{"function"}, Visibility: strPtr("public")}, 0)
+	require.NoError(t, err)
+	assert.Equal(t, []string{"Run"}, fuzzyNames(items))
+
+	items, err = q.FuzzySearch("run", SymbolFilter{Kinds: []string{"method"}}, 0)
+	require.NoError(t, err)
+	assert.Empty(t, items)
+}
+
+func TestFuzzySearch_Limit(t *testing.T) {
+	t.Parallel()
+	q, s := newTestQueryBuilder(t)
+	fID := insertFile(t, s, "main.go", "go")
+	for _, name := range []string{"alpha", "alphabet", "alphanumeric", "beta"} {
+		insertSymbol(t, s, &fID, name, "function", "public", nil)
+	}
+
+	items, err := q.FuzzySearch("alp", SymbolFilter{}, 2)
+	require.NoError(t, err)
+	assert.Equal(t, []string{"alpha", "alphabet"}, fuzzyNames(items))
+
+	// An empty query matches everything, shortest names first.
+	items, err = q.FuzzySearch("", SymbolFilter{}, 2)
+	require.NoError(t, err)
+	assert.Equal(t, []string{"beta", "alpha"}, fuzzyNames(items))
+}
+
+func TestFuzzySearch_DerivedCacheRefreshesOnNewGeneration(t *testing.T) {
+	t.Parallel()
+	_, s := newTestQueryBuilder(t)
+	q := NewQueryBuilder(s, WithDerivedCache())
+	fID := insertFile(t, s, "main.go", "go")
+	insertSymbol(t, s, &fID, "ParseFile", "function", "public", nil)
+
+	items, err := q.FuzzySearch("pars", SymbolFilter{}, 0)
+	require.NoError(t, err)
+	require.Len(t, items, 1)
+
+	_, err = s.InsertSymbol(&store.Symbol{FileID: &fID, Name: "Parser", Kind: "type"})
+	require.NoError(t, err)
+	items, err = q.FuzzySearch("pars", SymbolFilter{}, 0)
+	require.NoError(t, err)
+	assert.Len(t, items, 1, "same generation serves the cached table")
+
+	require.NoError(t, s.BumpIndexGeneration())
+	items, err = q.FuzzySearch("pars", SymbolFilter{}, 0)
+	require.NoError(t, err)
+	assert.Equal(t, []string{"Parser", "ParseFile"}, fuzzyNames(items))
+}
+
+func TestFuzzyScore(t *testing.T) {
+	t.Parallel()
+	score := func(name, query string) (int, bool) {
+		folded := make([]byte, len(query))
+		for i := range query {
+			folded[i] = foldByte(query[i])
+		}
+		return fuzzyScore([]byte(name), []byte(query), folded)
+	}
+
+	_, ok := score("Handler", "hdx")
+	assert.False(t, ok)
+	_, ok = score("Handler", "ldh")
+	assert.False(t, ok, "characters must match in order")
+
+	camel, ok := score("getUserName", "un")
+	require.True(t, ok)
+	inner, ok := score("gauntlet", "un")
+	require.True(t, ok)
+	assert.Greater(t, camel, inner, "camelCase humps outrank inner letters")
+
+	// The match window is the tightest one, so a stray early 'r' costs nothing.
+	tight, _ := score("r_x_readFile", "rf")
+	direct, _ := score("readFile", "rf")
+	assert.Equal(t, direct, tight)
+}
+
+func TestCharMask(t *testing.T) {
+	t.Parallel()
+	name := charMask([]byte("HandleRequest_2"))
+	for _, query := range []string{"hr", "HR", "req_2", ""} {
+		m := charMask([]byte(query))
+		assert.Equal(t, m, name&m, query)
+	}
+	m := charMask([]byte("hz"))
+	assert.NotEqual(t, m, name&m)
+}
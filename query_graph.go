@@ -8,8 +8,8 @@ import (
 )
 
 // CallGraph represents a transitive call graph rooted at a symbol.
-// Nodes and edges are bulk-loaded then traversed with BFS -- no recursive
-// SQL or N+1 queries.
+// Edges come from a CSR adjacency index and are traversed with BFS -- no
+// recursive SQL or N+1 queries.
 type CallGraph struct {
 	Root  int64           // starting symbol ID
 	Nodes []CallGraphNode // all symbols reachable within depth
@@ -32,44 +32,28 @@ type CallGraphEdge struct {
 	Col      int
 }
 
-// callGraphData holds the bulk-loaded call graph adjacency maps and file path index.
-type callGraphData struct {
-	forward   map[int64][]int64            // caller -> callees
-	reverse   map[int64][]int64            // callee -> callers
-	edgesByCaller map[int64][]*CallEdge // edges keyed by caller
-	edgesByCallee map[int64][]*CallEdge // edges keyed by callee
-	filePaths map[int64]string              // file ID -> path
-}
-
-// buildCallGraph bulk-loads all call edges and files into memory and builds
-// forward/reverse adjacency maps. This avoids N+1 queries during BFS traversal.
-func (q *QueryBuilder) buildCallGraph() (*callGraphData, error) {
-	edges, err := q.store.AllCallEdges()
-	if err != nil {
-		return nil, fmt.Errorf("build call graph: load edges: %w", err)
+// callGraphEdges converts the index edges in edgeIdx to CallGraphEdges,
+// resolving file IDs to paths with one query for the files involved.
+func (q *QueryBuilder) callGraphEdges(g *store.CallGraphIndex, edgeIdx []int) ([]CallGraphEdge, error) {
+	edges := make([]*CallEdge, len(edgeIdx))
+	var fileIDs []int64
+	seen := make(map[int64]bool)
+	for i, e := range edgeIdx {
+		edges[i] = g.Edge(e)
+		if fid := edges[i].FileID; fid != nil && !seen[*fid] {
+			seen[*fid] = true
+			fileIDs = append(fileIDs, *fid)
+		}
 	}
-
-	filePaths, err := q.store.AllFiles()
+	filePaths, err := q.store.FilePathsByIDs(fileIDs)
 	if err != nil {
-		return nil, fmt.Errorf("build call graph: load files: %w", err)
-	}
-
-	data := &callGraphData{
-		forward:       make(map[int64][]int64),
-		reverse:       make(map[int64][]int64),
-		edgesByCaller: make(map[int64][]*CallEdge),
-		edgesByCallee: make(map[int64][]*CallEdge),
-		filePaths:     filePaths,
+		return nil, err
 	}
-
-	for _, e := range edges {
-		data.forward[e.CallerSymbolID] = append(data.forward[e.CallerSymbolID], e.CalleeSymbolID)
-		data.reverse[e.CalleeSymbolID] = append(data.reverse[e.CalleeSymbolID], e.CallerSymbolID)
-		data.edgesByCaller[e.CallerSymbolID] = append(data.edgesByCaller[e.CallerSymbolID], e)
-		data.edgesByCallee[e.CalleeSymbolID] = append(data.edgesByCallee[e.CalleeSymbolID], e)
+	result := make([]CallGraphEdge, len(edges))
+	for i, edge := range edges {
+		result[i] = resolveCallGraphEdge(edge, filePaths)
 	}
-
-	return data, nil
+	return result, nil
 }
 
 // resolveCallGraphEdge converts a CallEdge to a CallGraphEdge,
@@ -89,7 +73,9 @@ func resolveCallGraphEdge(edge *CallEdge, filePaths map[int64]string) CallGraphE
 }
 
 // TransitiveCallers returns all transitive callers of a symbol up to maxDepth.
-// Bulk-loads all call_graph edges into memory, then walks callers with BFS.
+// Walks callers with BFS over the CSR call graph index (see
+// store.CallGraphIndex), which is memory-mapped when a persisted index
+// matches the database.
 // maxDepth of 0 returns only the root node (no traversal). Negative returns error.
 // Capped at 100. Returns nil, nil if symbolID does not exist.
 func (q *QueryBuilder) TransitiveCallers(symbolID int64, maxDepth int) (*CallGraph, error) {
@@ -119,12 +105,12 @@ func (q *QueryBuilder) TransitiveCallers(symbolID int64, maxDepth int) (*CallGra
 		return result, nil
 	}
 
-	data, err := q.buildCallGraph()
+	g, err := q.store.CallGraphIndex()
 	if err != nil {
 		return nil, fmt.Errorf("transitive callers: %w", err)
 	}
 
-	// BFS on reverse adjacency map
+	// BFS on reverse adjacency
 	visited := map[int64]int{symbolID: 0} // symbol ID -> depth
 	type bfsEntry struct {
 		id    int64
@@ -141,7 +127,8 @@ func (q *QueryBuilder) TransitiveCallers(symbolID int64, maxDepth int) (*CallGra
 			continue
 		}
 
-		for _, callerID := range data.reverse[current.id] {
+		g.Callers(current.id, func(e int) {
+			callerID := g.CallerID(e)
 			if _, seen := visited[callerID]; !seen {
 				newDepth := current.depth + 1
 				visited[callerID] = newDepth
@@ -150,7 +137,7 @@ func (q *QueryBuilder) TransitiveCallers(symbolID int64, maxDepth int) (*CallGra
 				}
 				queue = append(queue, bfsEntry{id: callerID, depth: newDepth})
 			}
-		}
+		})
 	}
 
 	// Collect all visited node IDs (except root, already added)
@@ -176,23 +163,24 @@ func (q *QueryBuilder) TransitiveCallers(symbolID int64, maxDepth int) (*CallGra
 	// Collect edges that connect visited nodes.
 	// For reverse traversal (callers), an edge is relevant if both caller and callee
 	// are in the visited set.
-	edgeSeen := make(map[int64]bool)
+	// Each edge is listed once under its callee, so no dedup is needed.
+	var edgeIdx []int
 	for id := range visited {
-		for _, edge := range data.edgesByCallee[id] {
-			if _, callerVisited := visited[edge.CallerSymbolID]; callerVisited {
-				if !edgeSeen[edge.ID] {
-					edgeSeen[edge.ID] = true
-					result.Edges = append(result.Edges, resolveCallGraphEdge(edge, data.filePaths))
-				}
+		g.Callers(id, func(e int) {
+			if _, callerVisited := visited[g.CallerID(e)]; callerVisited {
+				edgeIdx = append(edgeIdx, e)
 			}
-		}
+		})
+	}
+	if result.Edges, err = q.callGraphEdges(g, edgeIdx); err != nil {
+		return nil, fmt.Errorf("transitive callers: load files: %w", err)
 	}
 
 	return result, nil
 }
 
 // TransitiveCallees returns all transitive callees of a symbol up to maxDepth.
-// Bulk-loads all call_graph edges into memory, then walks callees with BFS.
+// Walks callees with BFS over the CSR call graph index.
 // maxDepth of 0 returns only the root node (no traversal). Negative returns error.
 // Capped at 100. Returns nil, nil if symbolID does not exist.
 func (q *QueryBuilder) TransitiveCallees(symbolID int64, maxDepth int) (*CallGraph, error) {
@@ -222,12 +210,12 @@ func (q *QueryBuilder) TransitiveCallees(symbolID int64, maxDepth int) (*CallGra
 		return result, nil
 	}
 
-	data, err := q.buildCallGraph()
+	g, err := q.store.CallGraphIndex()
 	if err != nil {
 		return nil, fmt.Errorf("transitive callees: %w", err)
 	}
 
-	// BFS on forward adjacency map
+	// BFS on forward adjacency
 	visited := map[int64]int{symbolID: 0}
 	type bfsEntry struct {
 		id    int64
@@ -243,7 +231,8 @@ func (q *QueryBuilder) TransitiveCallees(symbolID int64, maxDepth int) (*CallGra
 			continue
 		}
 
-		for _, calleeID := range data.forward[current.id] {
+		g.Callees(current.id, func(e int) {
+			calleeID := g.CalleeID(e)
 			if _, seen := visited[calleeID]; !seen {
 				newDepth := current.depth + 1
 				visited[calleeID] = newDepth
@@ -252,7 +241,7 @@ func (q *QueryBuilder) TransitiveCallees(symbolID int64, maxDepth int) (*CallGra
 				}
 				queue = append(queue, bfsEntry{id: calleeID, depth: newDepth})
 			}
-		}
+		})
 	}
 
 	// Collect visited node IDs (except root)
@@ -275,16 +264,16 @@ func (q *QueryBuilder) TransitiveCallees(symbolID int64, maxDepth int) (*CallGra
 	}
 
 	// Collect edges that connect visited nodes.
-	edgeSeen := make(map[int64]bool)
+	var edgeIdx []int
 	for id := range visited {
-		for _, edge := range data.edgesByCaller[id] {
-			if _, calleeVisited := visited[edge.CalleeSymbolID]; calleeVisited {
-				if !edgeSeen[edge.ID] {
-					edgeSeen[edge.ID] = true
-					result.Edges = append(result.Edges, resolveCallGraphEdge(edge, data.filePaths))
-				}
+		g.Callees(id, func(e int) {
+			if _, calleeVisited := visited[g.CalleeID(e)]; calleeVisited {
+				edgeIdx = append(edgeIdx, e)
 			}
-		}
+		})
+	}
+	if result.Edges, err = q.callGraphEdges(g, edgeIdx); err != nil {
+		return nil, fmt.Errorf("transitive callees: load files: %w", err)
 	}
 
 	return result, nil
@@ -337,8 +326,9 @@ func (q *QueryBuilder) UnusedSymbols(filter SymbolFilter, sort Sort, page Pagina
 	if filter.PathPrefix != nil {
 		prefix := normalizePathPrefix(*filter.PathPrefix)
 		if prefix != "" {
-			where = append(where, "f.path LIKE ? ESCAPE '\\'")
-			args = append(args, escapeLike(prefix)+"%")
+			lo, hi := pathPrefixBounds(prefix)
+			where = append(where, "f.path COLLATE NOCASE >= ? AND f.path COLLATE NOCASE < ?")
+			args = append(args, lo, hi)
 		}
 	}
 	for _, mod := range filter.Modifiers {
@@ -348,17 +338,32 @@ func (q *QueryBuilder) UnusedSymbols(filter SymbolFilter, sort Sort, page Pagina
 
 	whereClause := "WHERE " + strings.Join(where, " AND ")
 
+	keyExpr, keyOf := symbolSortKey(sort.Field, false)
+	orderDir := sortDirection(sort.Order)
+	order := keyExpr + " " + orderDir
+	cur, err := decodeCursor(page.Cursor, order)
+	if err != nil {
+		return nil, fmt.Errorf("unused symbols: %w", err)
+	}
+
 	// Count query
 	var totalCount int
-	countSQL := `SELECT COUNT(*) FROM symbols s LEFT JOIN files f ON s.file_id = f.id ` + whereClause
-	if err := q.store.DB().QueryRow(countSQL, args...).Scan(&totalCount); err != nil {
-		return nil, fmt.Errorf("unused symbols: count: %w", err)
+	if cur != nil {
+		totalCount = cur.Total
+	} else {
+		countSQL := `SELECT COUNT(*) FROM symbols s LEFT JOIN files f ON s.file_id = f.id ` + whereClause
+		if err := q.store.ReadDB().QueryRow(countSQL, args...).Scan(&totalCount); err != nil {
+			return nil, fmt.Errorf("unused symbols: count: %w", err)
+		}
 	}
 
 	// Data query -- ref_count and external_ref_count are always 0 for unused symbols,
 	// but we use the standard scan to keep SymbolResult consistent.
-	orderCol := symbolSortColumn(sort.Field)
-	orderDir := sortDirection(sort.Order)
+	orderBy, cond, condArgs := keyset(keyExpr, "s.id", orderDir, cur)
+	if cond != "" {
+		whereClause = "WHERE " + strings.Join(append(where, cond), " AND ")
+		args = append(args, condArgs...)
+	}
 
 	dataSQL := fmt.Sprintf(
 		`SELECT %s, COALESCE(f.path, '') AS file_path,
@@ -367,13 +372,14 @@ func (q *QueryBuilder) UnusedSymbols(filter SymbolFilter, sort Sort, page Pagina
 		 FROM symbols s
 		 LEFT JOIN files f ON s.file_id = f.id
 		 %s
-		 ORDER BY %s %s
+		 %s
 		 LIMIT ? OFFSET ?`,
-		prefixSymbolCols("s"), whereClause, orderCol, orderDir,
+		prefixSymbolCols("s"), whereClause, orderBy,
 	)
-	dataArgs := append(append([]any{}, args...), *page.Limit, page.Offset)
+	limit, offset := pageWindow(page, cur)
+	dataArgs := append(append([]any{}, args...), limit, offset)
 
-	rows, err := q.store.DB().Query(dataSQL, dataArgs...)
+	rows, err := q.store.ReadDB().Query(dataSQL, dataArgs...)
 	if err != nil {
 		return nil, fmt.Errorf("unused symbols: query: %w", err)
 	}
@@ -394,7 +400,9 @@ func (q *QueryBuilder) UnusedSymbols(filter SymbolFilter, sort Sort, page Pagina
 		items = []SymbolResult{}
 	}
 
-	return &PagedResult[SymbolResult]{Items: items, TotalCount: totalCount}, nil
+	return finishPage(items, page, order, totalCount, func(sr SymbolResult) (any, int64) {
+		return keyOf(sr), sr.ID
+	}), nil
 }
 
 // Hotspots returns the top-N most-referenced symbols with fan-in and fan-out
@@ -408,21 +416,21 @@ func (q *QueryBuilder) Hotspots(topN int) ([]*HotspotResult, error) {
 		return []*HotspotResult{}, nil
 	}
 
+	// Counts come from symbol_stats, walked in external_ref_count order
+	// through its index.
 	dataSQL := fmt.Sprintf(
 		`SELECT %s, COALESCE(f.path, '') AS file_path,
-			(SELECT COUNT(*) FROM resolved_references rr WHERE rr.target_symbol_id = s.id) AS ref_count,
-			(SELECT COUNT(*) FROM resolved_references rr JOIN references_ r ON r.id = rr.reference_id WHERE rr.target_symbol_id = s.id AND r.file_id != s.file_id) AS external_ref_count,
-			(SELECT COUNT(*) FROM call_graph cg WHERE cg.callee_symbol_id = s.id) AS caller_count,
-			(SELECT COUNT(*) FROM call_graph cg WHERE cg.caller_symbol_id = s.id) AS callee_count
-		 FROM symbols s
+			st.ref_count, st.external_ref_count, st.caller_count, st.callee_count
+		 FROM symbol_stats st
+		 JOIN symbols s ON s.id = st.symbol_id
 		 LEFT JOIN files f ON s.file_id = f.id
-		 WHERE EXISTS (SELECT 1 FROM resolved_references rr2 WHERE rr2.target_symbol_id = s.id)
-		 ORDER BY external_ref_count DESC
+		 WHERE st.ref_count > 0
+		 ORDER BY st.external_ref_count DESC, st.symbol_id
 		 LIMIT ?`,
 		prefixSymbolCols("s"),
 	)
 
-	rows, err := q.store.DB().Query(dataSQL, topN)
+	rows, err := q.store.ReadDB().Query(dataSQL, topN)
 	if err != nil {
 		return nil, fmt.Errorf("hotspots: query: %w", err)
 	}
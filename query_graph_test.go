@@ -587,6 +587,7 @@ func TestHotspots_IncludesCallerCount(t *testing.T) {
 	require.NoError(t, err)
 	_, err = s.InsertCallEdge(&store.CallEdge{CallerSymbolID: caller2, CalleeSymbolID: target, FileID: &fID, Line: 2, Col: 0})
 	require.NoError(t, err)
+	require.NoError(t, s.RefreshSymbolStats())
 
 	result, err := q.Hotspots(10)
 	require.NoError(t, err)
@@ -620,6 +621,7 @@ func TestHotspots_IncludesCalleeCount(t *testing.T) {
 	require.NoError(t, err)
 	_, err = s.InsertCallEdge(&store.CallEdge{CallerSymbolID: caller, CalleeSymbolID: callee2, FileID: &fID, Line: 2, Col: 0})
 	require.NoError(t, err)
+	require.NoError(t, s.RefreshSymbolStats())
 
 	result, err := q.Hotspots(10)
 	require.NoError(t, err)
@@ -35,6 +35,7 @@ func TestPackageDependencyGraph_AggregatesImportsToPackageEdges(t *testing.T) {
 	_, err = s.InsertImport(&store.Import{FileID: fileA2, Source: "pkg_b", Kind: "import"})
 	require.NoError(t, err)
 
+	require.NoError(t, s.RefreshPackageGraph())
 	graph, err := q.PackageDependencyGraph()
 	require.NoError(t, err)
 	require.NotNil(t, graph)
@@ -74,6 +75,7 @@ func TestPackageDependencyGraph_ImportCountReflectsDistinctFileImports(t *testin
 	_, err = s.InsertImport(&store.Import{FileID: fileA3, Source: "b", Kind: "import"})
 	require.NoError(t, err)
 
+	require.NoError(t, s.RefreshPackageGraph())
 	graph, err := q.PackageDependencyGraph()
 	require.NoError(t, err)
 
@@ -92,6 +94,41 @@ func TestPackageDependencyGraph_EmptyDatabase(t *testing.T) {
 	assert.Empty(t, graph.Edges)
 }
 
+func TestPackageDependencyGraph_DerivedCacheRefreshesOnNewGeneration(t *testing.T) {
+	t.Parallel()
+	_, s := newTestQueryBuilder(t)
+	q := NewQueryBuilder(s, WithDerivedCache())
+
+	fileA := insertFile(t, s, "/src/a/main.go", "go")
+	fileB := insertFile(t, s, "/src/b/main.go", "go")
+	_, err := s.InsertSymbol(&store.Symbol{FileID: &fileA, Name: "a", Kind: "package"})
+	require.NoError(t, err)
+	_, err = s.InsertSymbol(&store.Symbol{FileID: &fileB, Name: "b", Kind: "package"})
+	require.NoError(t, err)
+
+	require.NoError(t, s.RefreshPackageGraph())
+	graph, err := q.PackageDependencyGraph()
+	require.NoError(t, err)
+	assert.Empty(t, graph.Edges)
+
+	_, err = s.InsertImport(&store.Import{FileID: fileA, Source: "b", Kind: "import"})
+	require.NoError(t, err)
+	require.NoError(t, s.RefreshPackageGraph())
+
+	// Same generation: the cached graph is served.
+	graph, err = q.PackageDependencyGraph()
+	require.NoError(t, err)
+	assert.Empty(t, graph.Edges)
+
+	// A new index generation invalidates it.
+	require.NoError(t, s.BumpIndexGeneration())
+	graph, err = q.PackageDependencyGraph()
+	require.NoError(t, err)
+	require.Len(t, graph.Edges, 1)
+	assert.Equal(t, "a", graph.Edges[0].FromPackage)
+	assert.Equal(t, "b", graph.Edges[0].ToPackage)
+}
+
 func TestPackageDependencyGraph_ExcludesExternalImports(t *testing.T) {
 	t.Parallel()
 	q, s := newTestQueryBuilder(t)
@@ -105,6 +142,7 @@ func TestPackageDependencyGraph_ExcludesExternalImports(t *testing.T) {
 	_, err = s.InsertImport(&store.Import{FileID: fileA, Source: "github.com/external/lib", Kind: "import"})
 	require.NoError(t, err)
 
+	require.NoError(t, s.RefreshPackageGraph())
 	graph, err := q.PackageDependencyGraph()
 	require.NoError(t, err)
 
@@ -129,6 +167,7 @@ func TestPackageDependencyGraph_FileCountAndLineCount(t *testing.T) {
 	_, err = s.InsertSymbol(&store.Symbol{FileID: &fileB, Name: "pkg_b", Kind: "package"})
 	require.NoError(t, err)
 
+	require.NoError(t, s.RefreshPackageGraph())
 	graph, err := q.PackageDependencyGraph()
 	require.NoError(t, err)
 
@@ -169,6 +208,7 @@ func TestCircularDependencies_AcyclicReturnsEmpty(t *testing.T) {
 	_, err = s.InsertImport(&store.Import{FileID: fileB, Source: "c", Kind: "import"})
 	require.NoError(t, err)
 
+	require.NoError(t, s.RefreshPackageGraph())
 	cycles, err := q.CircularDependencies()
 	require.NoError(t, err)
 	assert.Empty(t, cycles)
@@ -192,6 +232,7 @@ func TestCircularDependencies_SimpleABCycle(t *testing.T) {
 	_, err = s.InsertImport(&store.Import{FileID: fileB, Source: "a", Kind: "import"})
 	require.NoError(t, err)
 
+	require.NoError(t, s.RefreshPackageGraph())
 	cycles, err := q.CircularDependencies()
 	require.NoError(t, err)
 	require.Len(t, cycles, 1)
@@ -228,6 +269,7 @@ func TestCircularDependencies_LongerABCACycle(t *testing.T) {
 	_, err = s.InsertImport(&store.Import{FileID: fileC, Source: "a", Kind: "import"})
 	require.NoError(t, err)
 
+	require.NoError(t, s.RefreshPackageGraph())
 	cycles, err := q.CircularDependencies()
 	require.NoError(t, err)
 	require.Len(t, cycles, 1)
@@ -253,6 +295,7 @@ func TestCircularDependencies_SelfLoop(t *testing.T) {
 	_, err = s.InsertImport(&store.Import{FileID: fileA, Source: "a", Kind: "import"})
 	require.NoError(t, err)
 
+	require.NoError(t, s.RefreshPackageGraph())
 	cycles, err := q.CircularDependencies()
 	require.NoError(t, err)
 	require.Len(t, cycles, 1)
@@ -74,6 +74,35 @@ func TestSymbolAt_NoSymbol(t *testing.T) {
 	assert.Nil(t, sym)
 }
 
+func TestSymbolAt_UsesRecordedLineLengths(t *testing.T) {
+	q, s := newTestQueryBuilder(t)
+
+	// The file does not exist on disk; only the recorded lengths are used.
+	fID, err := s.InsertFile(&store.File{
+		Path: "/indexed.go", Language: "go", Hash: "h", LastIndexed: time.Now(),
+		LineLengths: []uint32{14, 1},
+	})
+	require.NoError(t, err)
+	_, err = s.InsertSymbol(&store.Symbol{
+		FileID: &fID, Name: "F", Kind: "function", Visibility: "public",
+		StartLine: 0, StartCol: 0, EndLine: 1, EndCol: 1,
+	})
+	require.NoError(t, err)
+
+	sym, err := q.SymbolAt("/indexed.go", 0, 13)
+	require.NoError(t, err)
+	require.NotNil(t, sym)
+	assert.Equal(t, "F", sym.Name)
+
+	// Past the end of line 0, and past the last line.
+	sym, err = q.SymbolAt("/indexed.go", 0, 14)
+	require.NoError(t, err)
+	assert.Nil(t, sym)
+	sym, err = q.SymbolAt("/indexed.go", 2, 0)
+	require.NoError(t, err)
+	assert.Nil(t, sym)
+}
+
 func TestSymbolAt_NoFile(t *testing.T) {
 	q, _ := newTestQueryBuilder(t)
 
@@ -0,0 +1,73 @@
+package canopy
+
+import (
+	"time"
+
+	"github.com/jward/canopy/internal/store"
+)
+
+// WithResolutionCache controls the resolution cache, on by default. Each
+// resolved file records a fingerprint of its resolution inputs: its
+// references, imports and the symbols they could resolve to, down to their
+// signature hashes (see store.Store.ResolutionFingerprints). An incremental
+// Resolve leaves a blast-radius file alone, keeping its resolution data,
+// when its fingerprint is the one recorded when it was last resolved, as
+// for the importers of a package that gained a symbol none of them names.
+// A full Resolve always resolves every file, and the one completing a bulk
+// load records no fingerprints: its files are fingerprinted the first time
+// an incremental Resolve takes them in.
+func WithResolutionCache(enabled bool) Option {
+	return func(e *Engine) {
+		e.resolutionCache = enabled
+	}
+}
+
+// fingerprintResolveSet computes the resolution fingerprints of fileIDs,
+// the files this Resolve pass is about to resolve, for resolveBounded to
+// record once each shard succeeds. With skipUnchanged set it takes the
+// files whose fingerprint matches the recorded one out of the blast radius
+// and returns the remaining IDs; otherwise, or if the scripts changed since
+// the fingerprints were recorded, it returns fileIDs. During a bulk load it
+// computes nothing, which would read every reference of the new index.
+func (e *Engine) fingerprintResolveSet(fileIDs []int64, skipUnchanged bool) ([]int64, error) {
+	if !e.resolutionCache || e.store.Bulk() {
+		return fileIDs, nil
+	}
+	defer e.stats.phase("fingerprint", time.Now())
+	fps, err := e.store.ResolutionFingerprints(fileIDs)
+	if err != nil {
+		return nil, err
+	}
+	e.fingerprints = fps
+	if !skipUnchanged || e.ScriptsChanged() {
+		return fileIDs, nil
+	}
+	stored, err := e.store.StoredResolutionFingerprints(fileIDs)
+	if err != nil {
+		return nil, err
+	}
+	remaining := make([]int64, 0, len(fileIDs))
+	for _, fid := range fileIDs {
+		if fp, ok := stored[fid]; ok && fp == fps[fid] {
+			delete(e.blastRadius, fid)
+			continue
+		}
+		remaining = append(remaining, fid)
+	}
+	return remaining, nil
+}
+
+// recordFingerprints records the fingerprints computed for files, which
+// have just been resolved.
+func (e *Engine) recordFingerprints(files []*store.File) error {
+	if e.fingerprints == nil {
+		return nil
+	}
+	fps := make(map[int64]string, len(files))
+	for _, f := range files {
+		if fp, ok := e.fingerprints[f.ID]; ok {
+			fps[f.ID] = fp
+		}
+	}
+	return e.store.SetResolutionFingerprints(fps)
+}
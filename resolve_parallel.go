@@ -0,0 +1,228 @@
+package canopy
+
+import (
+	"cmp"
+	"context"
+	"fmt"
+	"runtime"
+	"slices"
+	"sync"
+	"time"
+
+	canopyrt "github.com/jward/canopy/internal/runtime"
+	"github.com/jward/canopy/internal/store"
+)
+
+// defaultResolveShardMin is the smallest number of files worth giving a
+// resolution shard of its own. Every shard re-runs the script's cache-building
+// prologue, so tiny shards cost more than they save.
+const defaultResolveShardMin = 64
+
+// resolveShard is one unit of resolution work: a subset of one language's
+// files, resolved by a dedicated Runtime. cost estimates its run time from
+// the references its files hold (see fileResolveCost).
+type resolveShard struct {
+	lang  string
+	files []*store.File
+	cost  int
+}
+
+// fileResolveCost estimates the resolution work for a file with refs
+// references: scripts spend their time resolving references, and every
+// file costs a little to load and walk besides.
+func fileResolveCost(refs int) int {
+	return 1 + refs
+}
+
+// runResolution executes the resolution scripts for langs. Each language's
+// files_to_resolve set is split into shards of balanced estimated cost,
+// and the shards of every language go into one queue, costliest first,
+// drained by resolveWorkers workers. Starting the largest units first and
+// letting small languages fill in behind them keeps the pass from waiting
+// on one big language that started late. All shards of a Resolve pass
+// share one read-only ReadCache, and each buffers its writes in a
+// ResolutionBatch; batch flushes are serialized by the Store, so SQLite
+// sees a single writer.
+func (e *Engine) runResolution(ctx context.Context, langs []string) []error {
+	timedOut, err := e.store.FileTimeouts()
+	if err != nil {
+		return []error{err}
+	}
+	skip := make(map[string]string, len(timedOut))
+	for _, t := range timedOut {
+		skip[t.Path] = t.Hash
+	}
+	selected := make([][]*store.File, len(langs))
+	var ids []int64
+	for i, lang := range langs {
+		files, err := e.store.FilesByLanguage(lang)
+		if err != nil {
+			return []error{fmt.Errorf("list files for %s: %w", lang, err)}
+		}
+		selected[i] = e.filesToResolve(files, skip)
+		for _, f := range selected[i] {
+			ids = append(ids, f.ID)
+		}
+	}
+	// Costs only balance shards and order the queue, so a pass too small to
+	// split, like most incremental ones, goes without counting references.
+	var refCounts map[int64]int
+	if len(ids) >= max(1, e.resolveShardMin) {
+		if refCounts, err = e.store.ReferenceCountsByFile(ids); err != nil {
+			return []error{err}
+		}
+	}
+	var shards []resolveShard
+	for i, lang := range langs {
+		shards = append(shards, e.shardFiles(lang, selected[i], refCounts)...)
+	}
+	slices.SortStableFunc(shards, func(a, b resolveShard) int { return cmp.Compare(b.cost, a.cost) })
+
+	workers := min(max(1, e.resolveWorkers), len(shards))
+	reads := store.NewReadCache(e.store)
+
+	var (
+		mu   sync.Mutex
+		wg   sync.WaitGroup
+		errs []error
+	)
+	queue := make(chan resolveShard, len(shards))
+	for _, sh := range shards {
+		queue <- sh
+	}
+	close(queue)
+	for range workers {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for sh := range queue {
+				if err := e.resolveBounded(ctx, sh, reads); err != nil {
+					mu.Lock()
+					errs = append(errs, fmt.Errorf("resolution script for %s: %w", sh.lang, err))
+					mu.Unlock()
+				}
+			}
+		}()
+	}
+	wg.Wait()
+	return errs
+}
+
+// filesToResolve selects the files that need resolution: those in the
+// blast radius, if there is one, except files that timed out at their
+// current content (skip maps their paths to that hash).
+func (e *Engine) filesToResolve(files []*store.File, skip map[string]string) []*store.File {
+	var selected []*store.File
+	for _, f := range files {
+		if e.blastRadius != nil && !e.blastRadius[f.ID] {
+			continue
+		}
+		if h, ok := skip[f.Path]; ok && h == f.Hash {
+			continue
+		}
+		selected = append(selected, f)
+	}
+	return selected
+}
+
+// shardFiles splits files, the files of lang to resolve, into at most
+// resolveWorkers shards of roughly resolveShardMin files or more. Files are
+// dealt costliest first to the cheapest shard so far, so a few
+// reference-heavy files don't all land in one shard; refCounts holds each
+// file's reference count, and nil costs every file alike. Languages with
+// nothing to resolve yield no shards.
+func (e *Engine) shardFiles(lang string, files []*store.File, refCounts map[int64]int) []resolveShard {
+	type costed struct {
+		f    *store.File
+		cost int
+	}
+	selected := make([]costed, 0, len(files))
+	for _, f := range files {
+		selected = append(selected, costed{f, fileResolveCost(refCounts[f.ID])})
+	}
+	if len(selected) == 0 {
+		return nil
+	}
+	slices.SortStableFunc(selected, func(a, b costed) int { return cmp.Compare(b.cost, a.cost) })
+
+	minFiles := max(1, e.resolveShardMin)
+	n := min(max(1, e.resolveWorkers), (len(selected)+minFiles-1)/minFiles)
+	shards := make([]resolveShard, n)
+	for i := range shards {
+		shards[i] = resolveShard{lang: lang, files: make([]*store.File, 0, len(selected)/n+1)}
+	}
+	for _, c := range selected {
+		cheapest := 0
+		for i := range shards {
+			if shards[i].cost < shards[cheapest].cost {
+				cheapest = i
+			}
+		}
+		shards[cheapest].files = append(shards[cheapest].files, c.f)
+		shards[cheapest].cost += c.cost
+	}
+	return shards
+}
+
+// resolveBounded resolves sh within the Engine's file timeout (see
+// WithFileTimeout). A shard that runs past it has its partial resolution
+// data deleted and is retried in halves; a single file that times out is
+// recorded and left unresolved. Each shard that resolves records its files'
+// resolution fingerprints (see WithResolutionCache).
+func (e *Engine) resolveBounded(ctx context.Context, sh resolveShard, reads *store.ReadCache) error {
+	timedOut, err := e.withDeadline(ctx, len(sh.files), func(ctx context.Context) error {
+		return e.resolveShard(ctx, sh, reads)
+	})
+	if !timedOut {
+		if err != nil {
+			return err
+		}
+		return e.recordFingerprints(sh.files)
+	}
+	ids := make([]int64, len(sh.files))
+	for i, f := range sh.files {
+		ids[i] = f.ID
+	}
+	if err := e.store.DeleteResolutionDataForFiles(ids); err != nil {
+		return fmt.Errorf("delete timed out resolution data: %w", err)
+	}
+	if len(sh.files) == 1 {
+		return e.recordTimeout(sh.files[0].Path, sh.files[0].Hash, "resolve")
+	}
+	mid := len(sh.files) / 2
+	for _, half := range [][]*store.File{sh.files[:mid], sh.files[mid:]} {
+		if err := e.resolveBounded(ctx, resolveShard{lang: sh.lang, files: half}, reads); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// resolveShard runs lang's resolution script with files_to_resolve bound to
+// the shard's files. The Runtime buffers the shard's writes and flushes them
+// when the script finishes.
+func (e *Engine) resolveShard(ctx context.Context, sh resolveShard, reads *store.ReadCache) error {
+	rtOpts := []canopyrt.RuntimeOption{canopyrt.WithReadCache(reads)}
+	if e.scriptsFS != nil {
+		rtOpts = append(rtOpts, canopyrt.WithRuntimeFS(e.scriptsFS))
+	}
+	if e.stats != nil {
+		rtOpts = append(rtOpts, canopyrt.WithCallStats(e.stats.calls))
+	}
+	rt := canopyrt.NewRuntime(e.store, e.scriptsDir, rtOpts...)
+
+	extras := map[string]any{
+		"files_to_resolve": canopyrt.MakeFileListFn(sh.files),
+	}
+	defer e.stats.resolve(sh.lang, time.Now())
+	var err error
+	e.labeled(ctx, "resolve", sh.lang, func(ctx context.Context) {
+		err = rt.RunScript(ctx, canopyrt.ResolutionScriptPath(sh.lang), extras)
+	})
+	return err
+}
+
+// defaultResolveWorkers is the default bound on concurrent resolution shards.
+func defaultResolveWorkers() int {
+	return runtime.NumCPU()
+}
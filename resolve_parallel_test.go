@@ -0,0 +1,44 @@
+package canopy
+
+import (
+	"fmt"
+	"testing"
+
+	"github.com/jward/canopy/internal/store"
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func TestShardFiles_BalancesReferenceCost(t *testing.T) {
+	t.Parallel()
+	e := &Engine{resolveWorkers: 3, resolveShardMin: 1}
+	var files []*store.File
+	refCounts := map[int64]int{}
+	for i := range 12 {
+		f := &store.File{ID: int64(i + 1), Path: fmt.Sprintf("f%d.go", i), Hash: "h"}
+		files = append(files, f)
+		refCounts[f.ID] = 1
+	}
+	// Two reference-heavy files, which round-robin would put together.
+	refCounts[1], refCounts[4] = 200, 200
+	skip := map[string]string{"f11.go": "h", "f10.go": "stale"}
+
+	shards := e.shardFiles("go", e.filesToResolve(files, skip), refCounts)
+	require.Len(t, shards, 3)
+	seen := map[int64]bool{}
+	for _, sh := range shards {
+		cost := 0
+		for _, f := range sh.files {
+			assert.False(t, seen[f.ID], "file %d in two shards", f.ID)
+			seen[f.ID] = true
+			cost += fileResolveCost(refCounts[f.ID])
+		}
+		assert.Equal(t, cost, sh.cost)
+	}
+	assert.Len(t, seen, 11, "only the file timed out at its current hash is skipped")
+	assert.NotContains(t, seen, int64(12))
+
+	// Each heavy file gets a shard of its own; the light ones share the third.
+	costs := []int{shards[0].cost, shards[1].cost, shards[2].cost}
+	assert.ElementsMatch(t, []int{201, 201, 9 * 2}, costs)
+}
@@ -0,0 +1,61 @@
+package go_extract_test
+
+import (
+	"context"
+	"os"
+	"path/filepath"
+	"testing"
+
+	"github.com/jward/canopy/internal/runtime"
+	"github.com/jward/canopy/internal/store"
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+// extractWith extracts path as lang into a fresh store, with or without
+// the native passes, and returns the file's scopes and references.
+func extractWith(t *testing.T, path, lang string, native bool) ([]*store.Scope, []*store.Reference) {
+	t.Helper()
+	s, err := store.NewStore(filepath.Join(t.TempDir(), "test.db"))
+	require.NoError(t, err)
+	defer s.Close()
+	require.NoError(t, s.Migrate())
+
+	fileID, err := s.InsertFile(&store.File{Path: path, Language: lang})
+	require.NoError(t, err)
+	rt := runtime.NewRuntime(s, filepath.Join(findModuleRoot(t), "scripts"), runtime.WithNativeExtraction(native))
+	extras := map[string]any{"file_path": path, "file_id": fileID}
+	require.NoError(t, rt.RunScript(context.Background(), runtime.ExtractionScriptPath(lang), extras))
+
+	scopes, err := s.ScopesByFile(fileID)
+	require.NoError(t, err)
+	refs, err := s.ReferencesByFile(fileID)
+	require.NoError(t, err)
+	return scopes, refs
+}
+
+// TestNativeExtraction_MatchesScript checks that the native scope and
+// reference passes of the C and C++ scripts write exactly the rows their
+// Risor fallback does, over every golden test source.
+func TestNativeExtraction_MatchesScript(t *testing.T) {
+	root := findModuleRoot(t)
+	for _, lang := range []string{"c", "cpp"} {
+		paths, err := filepath.Glob(filepath.Join(root, "testdata", lang, "*", "src", "*"))
+		require.NoError(t, err)
+		require.NotEmpty(t, paths)
+		for _, path := range paths {
+			if info, err := os.Stat(path); err != nil || info.IsDir() {
+				continue
+			}
+			rel, _ := filepath.Rel(root, path)
+			t.Run(rel, func(t *testing.T) {
+				t.Parallel()
+				wantScopes, wantRefs := extractWith(t, path, lang, false)
+				gotScopes, gotRefs := extractWith(t, path, lang, true)
+				assert.Equal(t, wantScopes, gotScopes)
+				assert.Equal(t, wantRefs, gotRefs)
+				assert.NotEmpty(t, gotScopes)
+			})
+		}
+	}
+}
@@ -0,0 +1,144 @@
+package canopy
+
+import (
+	"context"
+	"fmt"
+	"hash/fnv"
+	"os"
+	"path/filepath"
+	"strconv"
+	"strings"
+
+	"github.com/jward/canopy/internal/store"
+)
+
+// ShardBy selects how a Shard assigns files to shards.
+type ShardBy string
+
+const (
+	// ShardByDir assigns each top-level directory under the indexed root,
+	// with everything below it, to one shard, so most references stay
+	// within a shard. Files directly under the root share a shard.
+	ShardByDir ShardBy = "dir"
+
+	// ShardByHash assigns each file by the hash of its path relative to
+	// the indexed root, which balances shards regardless of layout.
+	ShardByHash ShardBy = "hash"
+)
+
+// Shard is one of Count disjoint parts of a repository. Shards are indexed
+// independently, each into its own database and possibly on separate
+// machines, and then combined with Merge; the assignment depends only on
+// paths relative to the indexed root, so no coordination is needed.
+type Shard struct {
+	Index int // 0-based, below Count
+	Count int
+	By    ShardBy
+}
+
+// ParseShard parses a shard spec "i/n" (0-based i) with the given mode.
+func ParseShard(spec string, by ShardBy) (Shard, error) {
+	i, n, ok := strings.Cut(spec, "/")
+	index, err1 := strconv.Atoi(i)
+	count, err2 := strconv.Atoi(n)
+	if !ok || err1 != nil || err2 != nil {
+		return Shard{}, fmt.Errorf("invalid shard %q: want index/count", spec)
+	}
+	s := Shard{Index: index, Count: count, By: by}
+	return s, s.validate()
+}
+
+func (s Shard) validate() error {
+	if s.Count < 1 || s.Index < 0 || s.Index >= s.Count {
+		return fmt.Errorf("invalid shard %d/%d", s.Index, s.Count)
+	}
+	if s.By != ShardByDir && s.By != ShardByHash {
+		return fmt.Errorf("invalid shard mode %q: must be %s or %s", s.By, ShardByDir, ShardByHash)
+	}
+	return nil
+}
+
+// Contains reports whether path, a file under root, belongs to s.
+func (s Shard) Contains(root, path string) bool {
+	rel, err := filepath.Rel(root, path)
+	if err != nil {
+		rel = path
+	}
+	key := filepath.ToSlash(rel)
+	if s.By == ShardByDir {
+		dir, _, nested := strings.Cut(key, "/")
+		if !nested {
+			dir = ""
+		}
+		key = dir
+	}
+	h := fnv.New32a()
+	h.Write([]byte(key))
+	return int(h.Sum32()%uint32(s.Count)) == s.Index
+}
+
+// WithShard makes IndexDirectory index only the files of shard s, and
+// treat the rest of the tree as absent. Resolution of a shard's database
+// is incomplete, since references into other shards cannot be found; the
+// shards are meant to be merged (see Merge) and resolved together.
+func WithShard(s Shard) Option {
+	return func(e *Engine) {
+		e.shard = &s
+	}
+}
+
+// shardFilter returns the paths under root that belong to the Engine's
+// shard, or paths unchanged when it has none.
+func (e *Engine) shardFilter(root string, paths []string) []string {
+	if e.shard == nil {
+		return paths
+	}
+	kept := paths[:0:0]
+	for _, p := range paths {
+		if e.shard.Contains(root, p) {
+			kept = append(kept, p)
+		}
+	}
+	return kept
+}
+
+// Merge copies the files and extraction data of the shard databases at
+// paths (each built by an Engine created WithShard, or any other index)
+// into the Engine's database, remapping every row ID; a file already
+// indexed at the same path is replaced. Resolution data is not copied,
+// so the next Resolve resolves every file, across shards. The shards
+// must have been indexed with the same scripts as the Engine's.
+func (e *Engine) Merge(ctx context.Context, paths ...string) (*MergeResult, error) {
+	total := &MergeResult{}
+	hash := e.scriptsHash()
+	e.resolveAll = true
+	for _, path := range paths {
+		if err := ctx.Err(); err != nil {
+			return total, err
+		}
+		if _, err := os.Stat(path); err != nil {
+			return total, fmt.Errorf("merge: %w", err)
+		}
+		src, err := store.NewStore(path)
+		if err != nil {
+			return total, fmt.Errorf("merge %s: %w", path, err)
+		}
+		res, err := e.mergeShard(src, hash)
+		src.Close()
+		if err != nil {
+			return total, fmt.Errorf("merge %s: %w", path, err)
+		}
+		total.Files += res.Files
+		total.Replaced += res.Replaced
+	}
+	return total, nil
+}
+
+func (e *Engine) mergeShard(src *store.Store, hash string) (*MergeResult, error) {
+	if stored, err := src.GetMetadata("scripts_hash"); err != nil {
+		return nil, err
+	} else if stored != "" && stored != hash {
+		return nil, fmt.Errorf("indexed with different scripts")
+	}
+	return e.store.Merge(src)
+}
@@ -0,0 +1,104 @@
+package canopy
+
+import (
+	"context"
+	"fmt"
+	"path/filepath"
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func TestShard_PartitionsFiles(t *testing.T) {
+	t.Parallel()
+	root := "/repo"
+	var paths []string
+	for d := 0; d < 5; d++ {
+		for f := 0; f < 20; f++ {
+			paths = append(paths, fmt.Sprintf("/repo/dir%d/sub/f%d.go", d, f))
+		}
+	}
+	paths = append(paths, "/repo/main.go", "/repo/util.go")
+
+	for _, by := range []ShardBy{ShardByDir, ShardByHash} {
+		owner := map[string]int{}
+		for i := 0; i < 3; i++ {
+			s := Shard{Index: i, Count: 3, By: by}
+			for _, p := range paths {
+				if s.Contains(root, p) {
+					_, dup := owner[p]
+					assert.False(t, dup, "%s in two %s shards", p, by)
+					owner[p] = i
+				}
+			}
+		}
+		assert.Len(t, owner, len(paths), "every file in a %s shard", by)
+		if by == ShardByDir {
+			for d := 0; d < 5; d++ {
+				first := fmt.Sprintf("/repo/dir%d/sub/f0.go", d)
+				for f := 1; f < 20; f++ {
+					assert.Equal(t, owner[first], owner[fmt.Sprintf("/repo/dir%d/sub/f%d.go", d, f)])
+				}
+			}
+			assert.Equal(t, owner["/repo/main.go"], owner["/repo/util.go"])
+		}
+	}
+
+	_, err := ParseShard("3/3", ShardByDir)
+	assert.Error(t, err)
+	_, err = ParseShard("1/3", "size")
+	assert.Error(t, err)
+	s, err := ParseShard("1/3", ShardByHash)
+	require.NoError(t, err)
+	assert.Equal(t, Shard{Index: 1, Count: 3, By: ShardByHash}, s)
+}
+
+func TestMerge_ShardsMatchUnshardedIndex(t *testing.T) {
+	t.Parallel()
+	ctx := context.Background()
+	r, err := newSynthRepo(t.TempDir(), "go", 240)
+	require.NoError(t, err)
+	scriptsDir := filepath.Join(findModuleRoot(t), "scripts")
+
+	whole := newIntegrationEngine(t, WithLanguages("go"))
+	require.NoError(t, whole.IndexDirectory(ctx, r.dir))
+	require.NoError(t, whole.Resolve(ctx))
+
+	var shards []string
+	for i := 0; i < 3; i++ {
+		path := filepath.Join(t.TempDir(), fmt.Sprintf("shard%d.db", i))
+		e, err := New(path, scriptsDir, WithLanguages("go"), WithShard(Shard{Index: i, Count: 3, By: ShardByHash}))
+		require.NoError(t, err)
+		require.NoError(t, e.IndexDirectory(ctx, r.dir))
+		require.NoError(t, e.Close())
+		shards = append(shards, path)
+	}
+
+	merged := newIntegrationEngine(t, WithLanguages("go"))
+	res, err := merged.Merge(ctx, shards...)
+	require.NoError(t, err)
+	assert.Equal(t, r.files(), res.Files)
+	assert.Zero(t, res.Replaced)
+	require.NoError(t, merged.Resolve(ctx))
+
+	path, line, col, _ := r.callSite(1)
+	defs, err := merged.Query().DefinitionAt(path, line, col)
+	require.NoError(t, err)
+	assert.NotEmpty(t, defs, "calls resolve across shards")
+
+	// Every call into the previous unit resolves as in the unsharded index.
+	for u := 1; u < r.units; u++ {
+		path, line, col, _ := r.callSite(u)
+		want, err := whole.Query().DefinitionAt(path, line, col)
+		require.NoError(t, err)
+		got, err := merged.Query().DefinitionAt(path, line, col)
+		require.NoError(t, err)
+		assert.Equal(t, want, got, "unit %d", u)
+	}
+
+	// Merging a shard again replaces its files.
+	res, err = merged.Merge(ctx, shards[0])
+	require.NoError(t, err)
+	assert.Equal(t, res.Files, res.Replaced)
+}
@@ -0,0 +1,251 @@
+package canopy
+
+import (
+	"context"
+	"runtime/pprof"
+	"sort"
+	"sync"
+	"time"
+
+	canopyrt "github.com/jward/canopy/internal/runtime"
+)
+
+// IndexStats is the timing breakdown an Engine collects while indexing and
+// resolving when created WithStats. Durations are in milliseconds, so the
+// JSON form (canopy index --stats=json) reads directly.
+type IndexStats struct {
+	// Phases times each pipeline step: "check" per file (stat, read, hash),
+	// "prepare" per group of changed files (old data deletion and record
+	// insertion), "extract" per file, "commit" per transaction,
+	// "blast_radius" per expansion, "fingerprint" per Resolve pass (see
+	// WithResolutionCache), "resolve" per resolution shard and "refresh" for
+	// the derived tables Resolve rebuilds.
+	Phases map[string]Histogram `json:"phases"`
+
+	// Languages breaks the per-file work down by language.
+	Languages map[string]*LanguageStats `json:"languages"`
+
+	// HostCalls tallies the host functions scripts called, by descending
+	// total time.
+	HostCalls []HostCallStats `json:"host_calls"`
+
+	// Slowest lists the files that took longest to parse, run and commit.
+	Slowest []FileTiming `json:"slowest_files"`
+}
+
+// LanguageStats is the per-language part of IndexStats. A file's commit
+// time is its share of the transaction it was committed in.
+type LanguageStats struct {
+	Files   int       `json:"files"`
+	Parse   Histogram `json:"parse"`
+	Script  Histogram `json:"script"`
+	Commit  Histogram `json:"commit"`
+	Resolve Histogram `json:"resolve"`
+}
+
+// HostCallStats is the tally of one host function.
+type HostCallStats struct {
+	Name    string  `json:"name"`
+	Calls   int64   `json:"calls"`
+	TotalMS float64 `json:"total_ms"`
+	MeanMS  float64 `json:"mean_ms"`
+	MaxMS   float64 `json:"max_ms"`
+}
+
+// FileTiming is the time one file spent in each phase. Script time
+// excludes parsing.
+type FileTiming struct {
+	Path     string  `json:"path"`
+	Language string  `json:"language"`
+	ParseMS  float64 `json:"parse_ms"`
+	ScriptMS float64 `json:"script_ms"`
+	CommitMS float64 `json:"commit_ms"`
+	TotalMS  float64 `json:"total_ms"`
+}
+
+// Histogram summarizes a set of durations. Bucket i counts the durations
+// up to HistogramBounds[i] not counted by an earlier bucket; the last
+// bucket counts the rest.
+type Histogram struct {
+	Count   int64   `json:"count"`
+	TotalMS float64 `json:"total_ms"`
+	MaxMS   float64 `json:"max_ms"`
+	Buckets []int64 `json:"buckets"`
+}
+
+// HistogramBounds are the upper bounds of the Histogram buckets, in
+// milliseconds.
+var HistogramBounds = []float64{0.1, 1, 10, 100, 1000, 10000}
+
+func (h *Histogram) add(d time.Duration) {
+	if h.Buckets == nil {
+		h.Buckets = make([]int64, len(HistogramBounds)+1)
+	}
+	ms := millis(d)
+	h.Count++
+	h.TotalMS += ms
+	h.MaxMS = max(h.MaxMS, ms)
+	h.Buckets[sort.SearchFloat64s(HistogramBounds, ms)]++
+}
+
+func millis(d time.Duration) float64 {
+	return float64(d) / float64(time.Millisecond)
+}
+
+// slowestFiles is how many files IndexStats.Slowest keeps.
+const slowestFiles = 20
+
+// statsRecorder collects an Engine's IndexStats. A nil recorder records
+// nothing, so call sites need not check whether stats are enabled.
+type statsRecorder struct {
+	calls *canopyrt.CallStats
+
+	mu      sync.Mutex
+	phases  map[string]*Histogram
+	langs   map[string]*LanguageStats
+	slowest []FileTiming // by descending TotalMS
+}
+
+func newStatsRecorder() *statsRecorder {
+	return &statsRecorder{
+		calls:  canopyrt.NewCallStats(),
+		phases: make(map[string]*Histogram),
+		langs:  make(map[string]*LanguageStats),
+	}
+}
+
+// phase records one run of a pipeline phase that started at start.
+func (r *statsRecorder) phase(name string, start time.Time) {
+	if r == nil {
+		return
+	}
+	d := time.Since(start)
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	r.addPhase(name, d)
+}
+
+func (r *statsRecorder) addPhase(name string, d time.Duration) {
+	h := r.phases[name]
+	if h == nil {
+		h = &Histogram{}
+		r.phases[name] = h
+	}
+	h.add(d)
+}
+
+func (r *statsRecorder) lang(name string) *LanguageStats {
+	ls := r.langs[name]
+	if ls == nil {
+		ls = &LanguageStats{}
+		r.langs[name] = ls
+	}
+	return ls
+}
+
+// file records the timings of one indexed file.
+func (r *statsRecorder) file(path, lang string, parse, script, commit time.Duration) {
+	if r == nil {
+		return
+	}
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	ls := r.lang(lang)
+	ls.Files++
+	ls.Parse.add(parse)
+	ls.Script.add(script)
+	ls.Commit.add(commit)
+
+	ft := FileTiming{
+		Path:     path,
+		Language: lang,
+		ParseMS:  millis(parse),
+		ScriptMS: millis(script),
+		CommitMS: millis(commit),
+		TotalMS:  millis(parse + script + commit),
+	}
+	if len(r.slowest) == slowestFiles && ft.TotalMS <= r.slowest[len(r.slowest)-1].TotalMS {
+		return
+	}
+	i := sort.Search(len(r.slowest), func(i int) bool { return r.slowest[i].TotalMS < ft.TotalMS })
+	r.slowest = append(r.slowest, FileTiming{})
+	copy(r.slowest[i+1:], r.slowest[i:])
+	r.slowest[i] = ft
+	if len(r.slowest) > slowestFiles {
+		r.slowest = r.slowest[:slowestFiles]
+	}
+}
+
+// resolve records one resolution shard of lang that started at start.
+func (r *statsRecorder) resolve(lang string, start time.Time) {
+	if r == nil {
+		return
+	}
+	d := time.Since(start)
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	r.addPhase("resolve", d)
+	r.lang(lang).Resolve.add(d)
+}
+
+// snapshot returns a copy of the stats recorded so far.
+func (r *statsRecorder) snapshot() *IndexStats {
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	out := &IndexStats{
+		Phases:    make(map[string]Histogram, len(r.phases)),
+		Languages: make(map[string]*LanguageStats, len(r.langs)),
+		Slowest:   append([]FileTiming(nil), r.slowest...),
+	}
+	for name, h := range r.phases {
+		out.Phases[name] = h.clone()
+	}
+	for name, ls := range r.langs {
+		out.Languages[name] = &LanguageStats{
+			Files:   ls.Files,
+			Parse:   ls.Parse.clone(),
+			Script:  ls.Script.clone(),
+			Commit:  ls.Commit.clone(),
+			Resolve: ls.Resolve.clone(),
+		}
+	}
+	for _, c := range r.calls.Snapshot() {
+		out.HostCalls = append(out.HostCalls, HostCallStats{
+			Name:    c.Name,
+			Calls:   c.Calls,
+			TotalMS: millis(c.Total),
+			MeanMS:  millis(c.Total) / float64(c.Calls),
+			MaxMS:   millis(c.Max),
+		})
+	}
+	return out
+}
+
+func (h Histogram) clone() Histogram {
+	h.Buckets = append([]int64(nil), h.Buckets...)
+	return h
+}
+
+// Stats returns the timings collected since the Engine was created, or nil
+// unless it was created WithStats.
+func (e *Engine) Stats() *IndexStats {
+	if e.stats == nil {
+		return nil
+	}
+	return e.stats.snapshot()
+}
+
+// labeled runs fn with the pprof labels phase and language set, so CPU
+// profiles can be sliced by them, when the Engine was created
+// WithProfileLabels; otherwise it just runs fn. lang may be empty.
+func (e *Engine) labeled(ctx context.Context, phase, lang string, fn func(context.Context)) {
+	if !e.profileLabels {
+		fn(ctx)
+		return
+	}
+	labels := []string{"phase", phase}
+	if lang != "" {
+		labels = append(labels, "language", lang)
+	}
+	pprof.Do(ctx, pprof.Labels(labels...), fn)
+}
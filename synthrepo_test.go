@@ -0,0 +1,524 @@
+package canopy
+
+import (
+	"bytes"
+	"context"
+	"fmt"
+	"os"
+	"path/filepath"
+	"strings"
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+// synthLanguages are the languages the synthetic repo generator writes, in
+// the order the benchmarks run them.
+var synthLanguages = []string{"cpp", "c", "go", "typescript", "javascript", "python", "rust", "java", "php", "ruby"}
+
+const (
+	// synthUnitsPerDir is how many units share a directory (and a package,
+	// namespace or module where the language has one).
+	synthUnitsPerDir = 100
+
+	// synthFuncs is how many chained functions each unit defines.
+	synthFuncs = 8
+)
+
+// synthRepo is a deterministic synthetic repository of one language on
+// disk. It is made of numbered units: a class (or struct) with a method,
+// and a chain of synthFuncs functions, the first of which calls the first
+// function of the previous unit, so resolution has cross-file references,
+// imports and calls throughout, crossing a directory every
+// synthUnitsPerDir units. A C or C++ unit is a header and a source file;
+// every other language's is a single file.
+type synthRepo struct {
+	dir   string
+	lang  string
+	units int
+}
+
+// synthFile is one generated file, by path relative to the repo root.
+type synthFile struct {
+	path    string
+	content string
+}
+
+// synthUnit is the input of a language generator.
+type synthUnit struct {
+	n       int
+	dir     string // p<n/synthUnitsPerDir>
+	prev    int    // the unit whose function the first function calls, or -1
+	prevDir string
+
+	// extra appends a function to the unit's source file, leaving every
+	// line before it as it was. header also declares it in the C or C++
+	// header.
+	extra, header bool
+}
+
+// synthFilesPerUnit is how many files one unit of lang is made of.
+func synthFilesPerUnit(lang string) int {
+	if lang == "c" || lang == "cpp" {
+		return 2
+	}
+	return 1
+}
+
+// newSynthRepo writes a repository of about files files of lang under dir.
+func newSynthRepo(dir, lang string, files int) (*synthRepo, error) {
+	r := &synthRepo{dir: dir, lang: lang, units: max(files/synthFilesPerUnit(lang), 2)}
+	if lang == "go" {
+		if err := r.write(synthFile{"go.mod", "module synth\n\ngo 1.21\n"}); err != nil {
+			return nil, err
+		}
+	}
+	for u := 0; u < r.units; u++ {
+		if err := r.writeUnit(u, false, false); err != nil {
+			return nil, err
+		}
+	}
+	return r, nil
+}
+
+// files returns the number of source files of the base repository.
+func (r *synthRepo) files() int {
+	return r.units * synthFilesPerUnit(r.lang)
+}
+
+func (r *synthRepo) unit(u int) synthUnit {
+	su := synthUnit{n: u, dir: synthDir(u), prev: u - 1}
+	if u > 0 {
+		su.prevDir = synthDir(u - 1)
+	}
+	return su
+}
+
+func synthDir(u int) string {
+	return fmt.Sprintf("p%d", u/synthUnitsPerDir)
+}
+
+// unitFiles generates the files of unit u; the first is its source file.
+func (r *synthRepo) unitFiles(u int, extra, header bool) []synthFile {
+	su := r.unit(u)
+	su.extra, su.header = extra, header
+	switch r.lang {
+	case "go":
+		return synthGo(su)
+	case "c":
+		return synthC(su)
+	case "cpp":
+		return synthCpp(su)
+	case "python":
+		return synthPython(su)
+	case "javascript":
+		return synthJS(su, false)
+	case "typescript":
+		return synthJS(su, true)
+	case "rust":
+		return synthRust(su)
+	case "java":
+		return synthJava(su)
+	case "php":
+		return synthPHP(su)
+	case "ruby":
+		return synthRuby(su)
+	}
+	panic("synth: unsupported language " + r.lang)
+}
+
+// path returns the absolute path of a file of the repo.
+func (r *synthRepo) path(rel string) string {
+	return filepath.Join(r.dir, filepath.FromSlash(rel))
+}
+
+// write writes f unless it already has that content, so untouched files
+// keep their stat tuple.
+func (r *synthRepo) write(f synthFile) error {
+	path := r.path(f.path)
+	if old, err := os.ReadFile(path); err == nil && bytes.Equal(old, []byte(f.content)) {
+		return nil
+	}
+	if err := os.MkdirAll(filepath.Dir(path), 0o755); err != nil {
+		return err
+	}
+	return os.WriteFile(path, []byte(f.content), 0o644)
+}
+
+// writeUnit (re)writes the files of unit u.
+func (r *synthRepo) writeUnit(u int, extra, header bool) error {
+	for _, f := range r.unitFiles(u, extra, header) {
+		if err := r.write(f); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// removeUnit deletes the files of unit u.
+func (r *synthRepo) removeUnit(u int) error {
+	for _, f := range r.unitFiles(u, false, false) {
+		if err := os.Remove(r.path(f.path)); err != nil && !os.IsNotExist(err) {
+			return err
+		}
+	}
+	return nil
+}
+
+// touch rewrites the source files of k units spread evenly over the repo,
+// with or without their extra function, and returns their paths.
+func (r *synthRepo) touch(k int, extra bool) ([]string, error) {
+	var paths []string
+	for i := 0; i < k; i++ {
+		u := i * r.units / k
+		f := r.unitFiles(u, extra, false)[0]
+		if err := r.write(f); err != nil {
+			return nil, err
+		}
+		paths = append(paths, r.path(f.path))
+	}
+	return paths, nil
+}
+
+// checkout switches the repo between its base state and a "branch" that
+// changes one unit in ten (header included), deletes one in fifty and adds
+// one new unit for every fifty.
+func (r *synthRepo) checkout(branch bool) error {
+	for u := 0; u < r.units; u++ {
+		switch {
+		case u%50 == 7:
+			if branch {
+				if err := r.removeUnit(u); err != nil {
+					return err
+				}
+				continue
+			}
+			if err := r.writeUnit(u, false, false); err != nil {
+				return err
+			}
+		case u%10 == 5:
+			if err := r.writeUnit(u, branch, branch); err != nil {
+				return err
+			}
+		}
+	}
+	for u := r.units; u < r.units+max(r.units/50, 1); u++ {
+		if !branch {
+			if err := r.removeUnit(u); err != nil {
+				return err
+			}
+			continue
+		}
+		if err := r.writeUnit(u, false, false); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// callSite returns the position (0-based) in unit u's source file of its
+// call to the previous unit's first function, named target.
+func (r *synthRepo) callSite(u int) (path string, line, col int, target string) {
+	f := r.unitFiles(u, false, false)[0]
+	target = fmt.Sprintf("f%d_0", u-1)
+	if r.lang == "go" {
+		target = fmt.Sprintf("F%d_0", u-1)
+	}
+	i := strings.LastIndex(f.content, target)
+	before := f.content[:i]
+	line = strings.Count(before, "\n")
+	col = i - (strings.LastIndex(before, "\n") + 1)
+	return r.path(f.path), line, col, target
+}
+
+// synthBody returns the body expression of function k of u in a
+// C-family syntax, given how the language spells the previous unit's
+// first function (call), a call to its own function k-1 (own) and a new
+// unit object with a method call (method).
+func synthBody(u synthUnit, k int, call, own, method string) string {
+	switch {
+	case k > 0:
+		return method + " + " + own
+	case u.prev >= 0:
+		return call + " + 1"
+	default:
+		return "x"
+	}
+}
+
+// relImport returns the path of the previous unit's file named name,
+// relative to unit u's directory.
+func relImport(u synthUnit, name string) string {
+	if u.prevDir == u.dir {
+		return "./" + name
+	}
+	return "../" + u.prevDir + "/" + name
+}
+
+func synthGo(u synthUnit) []synthFile {
+	var s strings.Builder
+	fmt.Fprintf(&s, "package %s\n\n", u.dir)
+	call := fmt.Sprintf("F%d_0(x)", u.prev)
+	if u.prev >= 0 && u.prevDir != u.dir {
+		fmt.Fprintf(&s, "import \"synth/%s\"\n\n", u.prevDir)
+		call = u.prevDir + "." + call
+	}
+	fmt.Fprintf(&s, "// Unit%d is synthetic unit %d.\ntype Unit%d struct {\n\tID   int\n\tName string\n}\n\n", u.n, u.n, u.n)
+	fmt.Fprintf(&s, "// Value returns the unit's value at x.\nfunc (v *Unit%d) Value(x int) int {\n\treturn v.ID + x\n}\n", u.n)
+	for k := 0; k < synthFuncs; k++ {
+		fmt.Fprintf(&s, "\n// F%d_%d is link %d of the unit's call chain.\nfunc F%d_%d(x int) int {\n", u.n, k, k, u.n, k)
+		if k > 0 {
+			fmt.Fprintf(&s, "\tv := &Unit%d{ID: %d}\n", u.n, k)
+		}
+		fmt.Fprintf(&s, "\treturn %s\n}\n", synthBody(u, k, call,
+			fmt.Sprintf("F%d_%d(x)", u.n, k-1), "v.Value(x)"))
+	}
+	if u.extra {
+		fmt.Fprintf(&s, "\n// F%d_extra doubles the end of the chain.\nfunc F%d_extra(x int) int {\n\treturn F%d_%d(x) * 2\n}\n", u.n, u.n, u.n, synthFuncs-1)
+	}
+	return []synthFile{{fmt.Sprintf("%s/u%d.go", u.dir, u.n), s.String()}}
+}
+
+func synthC(u synthUnit) []synthFile {
+	var h strings.Builder
+	fmt.Fprintf(&h, "#ifndef SYNTH_U%d_H\n#define SYNTH_U%d_H\n\n", u.n, u.n)
+	fmt.Fprintf(&h, "/* unit%d is synthetic unit %d. */\nstruct unit%d {\n\tint id;\n\tconst char *name;\n};\n\n", u.n, u.n, u.n)
+	fmt.Fprintf(&h, "int unit%d_value(const struct unit%d *v, int x);\n", u.n, u.n)
+	for k := 0; k < synthFuncs; k++ {
+		fmt.Fprintf(&h, "int f%d_%d(int x);\n", u.n, k)
+	}
+	if u.header {
+		fmt.Fprintf(&h, "int f%d_extra(int x);\n", u.n)
+	}
+	h.WriteString("\n#endif\n")
+
+	var s strings.Builder
+	fmt.Fprintf(&s, "#include \"u%d.h\"\n", u.n)
+	if u.prev >= 0 {
+		fmt.Fprintf(&s, "#include \"%s\"\n", strings.TrimPrefix(relImport(u, fmt.Sprintf("u%d.h", u.prev)), "./"))
+	}
+	fmt.Fprintf(&s, "\nint unit%d_value(const struct unit%d *v, int x)\n{\n\treturn v->id + x;\n}\n", u.n, u.n)
+	for k := 0; k < synthFuncs; k++ {
+		fmt.Fprintf(&s, "\nint f%d_%d(int x)\n{\n", u.n, k)
+		if k > 0 {
+			fmt.Fprintf(&s, "\tstruct unit%d v = {%d, \"u%d\"};\n", u.n, k, u.n)
+		}
+		fmt.Fprintf(&s, "\treturn %s;\n}\n", synthBody(u, k, fmt.Sprintf("f%d_0(x)", u.prev),
+			fmt.Sprintf("f%d_%d(x)", u.n, k-1), fmt.Sprintf("unit%d_value(&v, x)", u.n)))
+	}
+	if u.extra {
+		fmt.Fprintf(&s, "\nint f%d_extra(int x)\n{\n\treturn f%d_%d(x) * 2;\n}\n", u.n, u.n, synthFuncs-1)
+	}
+	return []synthFile{
+		{fmt.Sprintf("%s/u%d.c", u.dir, u.n), s.String()},
+		{fmt.Sprintf("%s/u%d.h", u.dir, u.n), h.String()},
+	}
+}
+
+func synthCpp(u synthUnit) []synthFile {
+	var h strings.Builder
+	fmt.Fprintf(&h, "#pragma once\n\nnamespace %s {\n\n", u.dir)
+	fmt.Fprintf(&h, "// Unit%d is synthetic unit %d.\nclass Unit%d {\npublic:\n\texplicit Unit%d(int id) : id_(id) {}\n\tint value(int x) const;\n\nprivate:\n\tint id_;\n};\n\n", u.n, u.n, u.n, u.n)
+	fmt.Fprintf(&h, "template <typename T>\nT scale%d(T v) {\n\treturn v * 2;\n}\n\n", u.n)
+	for k := 0; k < synthFuncs; k++ {
+		fmt.Fprintf(&h, "int f%d_%d(int x);\n", u.n, k)
+	}
+	if u.header {
+		fmt.Fprintf(&h, "int f%d_extra(int x);\n", u.n)
+	}
+	fmt.Fprintf(&h, "\n}  // namespace %s\n", u.dir)
+
+	var s strings.Builder
+	fmt.Fprintf(&s, "#include \"u%d.hpp\"\n", u.n)
+	if u.prev >= 0 {
+		fmt.Fprintf(&s, "#include \"%s\"\n", strings.TrimPrefix(relImport(u, fmt.Sprintf("u%d.hpp", u.prev)), "./"))
+	}
+	fmt.Fprintf(&s, "\nnamespace %s {\n\nint Unit%d::value(int x) const {\n\treturn id_ + x;\n}\n", u.dir, u.n)
+	for k := 0; k < synthFuncs; k++ {
+		fmt.Fprintf(&s, "\nint f%d_%d(int x) {\n", u.n, k)
+		if k > 0 {
+			fmt.Fprintf(&s, "\tUnit%d v(%d);\n", u.n, k)
+		}
+		fmt.Fprintf(&s, "\treturn %s;\n}\n", synthBody(u, k, fmt.Sprintf("%s::f%d_0(x)", u.prevDir, u.prev),
+			fmt.Sprintf("scale%d(f%d_%d(x))", u.n, u.n, k-1), "v.value(x)"))
+	}
+	if u.extra {
+		fmt.Fprintf(&s, "\nint f%d_extra(int x) {\n\treturn f%d_%d(x) * 2;\n}\n", u.n, u.n, synthFuncs-1)
+	}
+	fmt.Fprintf(&s, "\n}  // namespace %s\n", u.dir)
+	return []synthFile{
+		{fmt.Sprintf("%s/u%d.cpp", u.dir, u.n), s.String()},
+		{fmt.Sprintf("%s/u%d.hpp", u.dir, u.n), h.String()},
+	}
+}
+
+func synthPython(u synthUnit) []synthFile {
+	var s strings.Builder
+	if u.prev >= 0 {
+		fmt.Fprintf(&s, "from %s.u%d import f%d_0\n\n", u.prevDir, u.prev, u.prev)
+	}
+	fmt.Fprintf(&s, "\nclass Unit%d:\n    \"\"\"Synthetic unit %d.\"\"\"\n\n    def __init__(self, id):\n        self.id = id\n\n    def value(self, x):\n        return self.id + x\n", u.n, u.n)
+	for k := 0; k < synthFuncs; k++ {
+		fmt.Fprintf(&s, "\n\ndef f%d_%d(x):\n", u.n, k)
+		if k > 0 {
+			fmt.Fprintf(&s, "    v = Unit%d(%d)\n", u.n, k)
+		}
+		fmt.Fprintf(&s, "    return %s\n", synthBody(u, k, fmt.Sprintf("f%d_0(x)", u.prev),
+			fmt.Sprintf("f%d_%d(x)", u.n, k-1), "v.value(x)"))
+	}
+	if u.extra {
+		fmt.Fprintf(&s, "\n\ndef f%d_extra(x):\n    return f%d_%d(x) * 2\n", u.n, u.n, synthFuncs-1)
+	}
+	return []synthFile{{fmt.Sprintf("%s/u%d.py", u.dir, u.n), s.String()}}
+}
+
+// synthJS generates JavaScript, or TypeScript when typed is set.
+func synthJS(u synthUnit, typed bool) []synthFile {
+	num, ret, ext := "", "", ".js"
+	if typed {
+		num, ret, ext = ": number", ": number", ".ts"
+	}
+	var s strings.Builder
+	if u.prev >= 0 {
+		from := relImport(u, fmt.Sprintf("u%d", u.prev))
+		if !typed {
+			from += ext
+		}
+		fmt.Fprintf(&s, "import { f%d_0 } from \"%s\";\n\n", u.prev, from)
+	}
+	fmt.Fprintf(&s, "// Unit%d is synthetic unit %d.\nexport class Unit%d {\n", u.n, u.n, u.n)
+	if typed {
+		s.WriteString("  id: number;\n\n")
+	}
+	fmt.Fprintf(&s, "  constructor(id%s) {\n    this.id = id;\n  }\n\n  value(x%s)%s {\n    return this.id + x;\n  }\n}\n", num, num, ret)
+	for k := 0; k < synthFuncs; k++ {
+		fmt.Fprintf(&s, "\nexport function f%d_%d(x%s)%s {\n", u.n, k, num, ret)
+		if k > 0 {
+			fmt.Fprintf(&s, "  const v = new Unit%d(%d);\n", u.n, k)
+		}
+		fmt.Fprintf(&s, "  return %s;\n}\n", synthBody(u, k, fmt.Sprintf("f%d_0(x)", u.prev),
+			fmt.Sprintf("f%d_%d(x)", u.n, k-1), "v.value(x)"))
+	}
+	if u.extra {
+		fmt.Fprintf(&s, "\nexport function f%d_extra(x%s)%s {\n  return f%d_%d(x) * 2;\n}\n", u.n, num, ret, u.n, synthFuncs-1)
+	}
+	return []synthFile{{fmt.Sprintf("%s/u%d%s", u.dir, u.n, ext), s.String()}}
+}
+
+func synthRust(u synthUnit) []synthFile {
+	var s strings.Builder
+	if u.prev >= 0 {
+		fmt.Fprintf(&s, "use crate::%s::u%d::f%d_0;\n\n", u.prevDir, u.prev, u.prev)
+	}
+	fmt.Fprintf(&s, "/// Synthetic unit %d.\npub struct Unit%d {\n    pub id: i64,\n}\n\nimpl Unit%d {\n    pub fn value(&self, x: i64) -> i64 {\n        self.id + x\n    }\n}\n", u.n, u.n, u.n)
+	for k := 0; k < synthFuncs; k++ {
+		fmt.Fprintf(&s, "\npub fn f%d_%d(x: i64) -> i64 {\n", u.n, k)
+		if k > 0 {
+			fmt.Fprintf(&s, "    let v = Unit%d { id: %d };\n", u.n, k)
+		}
+		fmt.Fprintf(&s, "    %s\n}\n", synthBody(u, k, fmt.Sprintf("f%d_0(x)", u.prev),
+			fmt.Sprintf("f%d_%d(x)", u.n, k-1), "v.value(x)"))
+	}
+	if u.extra {
+		fmt.Fprintf(&s, "\npub fn f%d_extra(x: i64) -> i64 {\n    f%d_%d(x) * 2\n}\n", u.n, u.n, synthFuncs-1)
+	}
+	return []synthFile{{fmt.Sprintf("%s/u%d.rs", u.dir, u.n), s.String()}}
+}
+
+func synthJava(u synthUnit) []synthFile {
+	var s strings.Builder
+	fmt.Fprintf(&s, "package %s;\n\n", u.dir)
+	if u.prev >= 0 && u.prevDir != u.dir {
+		fmt.Fprintf(&s, "import %s.Unit%d;\n\n", u.prevDir, u.prev)
+	}
+	fmt.Fprintf(&s, "/** Synthetic unit %d. */\npublic class Unit%d {\n    private final int id;\n\n    public Unit%d(int id) {\n        this.id = id;\n    }\n\n    public int value(int x) {\n        return id + x;\n    }\n", u.n, u.n, u.n)
+	for k := 0; k < synthFuncs; k++ {
+		fmt.Fprintf(&s, "\n    public static int f%d_%d(int x) {\n", u.n, k)
+		if k > 0 {
+			fmt.Fprintf(&s, "        Unit%d v = new Unit%d(%d);\n", u.n, u.n, k)
+		}
+		fmt.Fprintf(&s, "        return %s;\n    }\n", synthBody(u, k, fmt.Sprintf("Unit%d.f%d_0(x)", u.prev, u.prev),
+			fmt.Sprintf("f%d_%d(x)", u.n, k-1), "v.value(x)"))
+	}
+	if u.extra {
+		fmt.Fprintf(&s, "\n    public static int f%d_extra(int x) {\n        return f%d_%d(x) * 2;\n    }\n", u.n, u.n, synthFuncs-1)
+	}
+	s.WriteString("}\n")
+	return []synthFile{{fmt.Sprintf("%s/Unit%d.java", u.dir, u.n), s.String()}}
+}
+
+func synthPHP(u synthUnit) []synthFile {
+	var s strings.Builder
+	fmt.Fprintf(&s, "<?php\n\nnamespace %s;\n\n", strings.ToUpper(u.dir))
+	if u.prev >= 0 && u.prevDir != u.dir {
+		fmt.Fprintf(&s, "use %s\\Unit%d;\n\n", strings.ToUpper(u.prevDir), u.prev)
+	}
+	fmt.Fprintf(&s, "/** Synthetic unit %d. */\nclass Unit%d\n{\n    public function __construct(private int $id)\n    {\n    }\n\n    public function value(int $x): int\n    {\n        return $this->id + $x;\n    }\n", u.n, u.n)
+	for k := 0; k < synthFuncs; k++ {
+		fmt.Fprintf(&s, "\n    public static function f%d_%d(int $x): int\n    {\n", u.n, k)
+		if k > 0 {
+			fmt.Fprintf(&s, "        $v = new Unit%d(%d);\n", u.n, k)
+		}
+		fmt.Fprintf(&s, "        return %s;\n    }\n", synthBody(u, k, fmt.Sprintf("Unit%d::f%d_0($x)", u.prev, u.prev),
+			fmt.Sprintf("self::f%d_%d($x)", u.n, k-1), "$v->value($x)"))
+	}
+	if u.extra {
+		fmt.Fprintf(&s, "\n    public static function f%d_extra(int $x): int\n    {\n        return self::f%d_%d($x) * 2;\n    }\n", u.n, u.n, synthFuncs-1)
+	}
+	s.WriteString("}\n")
+	return []synthFile{{fmt.Sprintf("%s/Unit%d.php", u.dir, u.n), s.String()}}
+}
+
+func synthRuby(u synthUnit) []synthFile {
+	var s strings.Builder
+	if u.prev >= 0 {
+		fmt.Fprintf(&s, "require_relative \"%s\"\n\n", strings.TrimPrefix(relImport(u, fmt.Sprintf("u%d", u.prev)), "./"))
+	}
+	fmt.Fprintf(&s, "# Synthetic unit %d.\nclass Unit%d\n  attr_reader :id\n\n  def initialize(id)\n    @id = id\n  end\n\n  def value(x)\n    id + x\n  end\n", u.n, u.n)
+	for k := 0; k < synthFuncs; k++ {
+		fmt.Fprintf(&s, "\n  def self.f%d_%d(x)\n", u.n, k)
+		if k > 0 {
+			fmt.Fprintf(&s, "    v = Unit%d.new(%d)\n", u.n, k)
+		}
+		fmt.Fprintf(&s, "    %s\n  end\n", synthBody(u, k, fmt.Sprintf("Unit%d.f%d_0(x)", u.prev, u.prev),
+			fmt.Sprintf("f%d_%d(x)", u.n, k-1), "v.value(x)"))
+	}
+	if u.extra {
+		fmt.Fprintf(&s, "\n  def self.f%d_extra(x)\n    f%d_%d(x) * 2\n  end\n", u.n, u.n, synthFuncs-1)
+	}
+	s.WriteString("end\n")
+	return []synthFile{{fmt.Sprintf("%s/u%d.rb", u.dir, u.n), s.String()}}
+}
+
+func TestSynthRepo_IndexesEveryLanguage(t *testing.T) {
+	t.Parallel()
+	for _, lang := range synthLanguages {
+		t.Run(lang, func(t *testing.T) {
+			t.Parallel()
+			r, err := newSynthRepo(t.TempDir(), lang, 240)
+			require.NoError(t, err)
+			e := newIntegrationEngine(t, WithLanguages(lang))
+			ctx := context.Background()
+			require.NoError(t, e.IndexDirectory(ctx, r.dir))
+			require.NoError(t, e.Resolve(ctx))
+
+			files, err := e.store.AllFiles()
+			require.NoError(t, err)
+			assert.Len(t, files, r.files())
+
+			_, _, _, target := r.callSite(r.units/2 + 1)
+			found, err := e.Query().SearchSymbols(target, SymbolFilter{}, Sort{}, Pagination{})
+			require.NoError(t, err)
+			assert.NotEmpty(t, found.Items, "call target %s is defined", target)
+
+			// The branch deletes units 7, 57, ... and adds units past the end.
+			require.NoError(t, r.checkout(true))
+			require.NoError(t, e.IndexDirectory(ctx, r.dir))
+			files, err = e.store.AllFiles()
+			require.NoError(t, err)
+			per := synthFilesPerUnit(lang)
+			assert.Len(t, files, r.files()-(r.units+42)/50*per+max(r.units/50, 1)*per)
+		})
+	}
+}
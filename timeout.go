@@ -0,0 +1,63 @@
+package canopy
+
+import (
+	"context"
+	"errors"
+	"time"
+
+	"github.com/jward/canopy/internal/store"
+)
+
+// WithFileTimeout bounds the time spent on each file: its extraction
+// (tree-sitter parse and script) is cancelled once it runs past d, and a
+// resolution shard past d times its file count. A file that times out is
+// not an indexing error; it is recorded (see TimedOutFiles) and left out of
+// indexing and resolution until its content changes, so one pathological
+// file, such as minified or generated source, cannot stall a run. A shard
+// that times out is retried in halves, down to single files, to find the
+// files responsible. d <= 0 (the default) sets no deadline.
+func WithFileTimeout(d time.Duration) Option {
+	return func(e *Engine) {
+		e.fileTimeout = d
+	}
+}
+
+// withDeadline runs fn with ctx bounded by the Engine's file timeout scaled
+// by files, and returns its error; timedOut reports that fn failed because
+// that deadline passed rather than because ctx ended.
+func (e *Engine) withDeadline(ctx context.Context, files int, fn func(context.Context) error) (timedOut bool, err error) {
+	if e.fileTimeout <= 0 {
+		return false, fn(ctx)
+	}
+	fctx, cancel := context.WithTimeout(ctx, e.fileTimeout*time.Duration(files))
+	defer cancel()
+	err = fn(fctx)
+	return err != nil && ctx.Err() == nil && errors.Is(fctx.Err(), context.DeadlineExceeded), err
+}
+
+// recordTimeout records that path, at content hash, timed out in phase.
+func (e *Engine) recordTimeout(path, hash, phase string) error {
+	return e.store.RecordFileTimeout(store.FileTimeout{
+		Path:       path,
+		Hash:       hash,
+		Phase:      phase,
+		RecordedAt: time.Now(),
+	})
+}
+
+// timedOutUnchanged reports whether path timed out before at content hash,
+// and so is skipped (see WithFileTimeout).
+func (e *Engine) timedOutUnchanged(path, hash string) (bool, error) {
+	t, err := e.store.FileTimeoutHash(path)
+	if err != nil {
+		return false, err
+	}
+	return t != "" && t == hash, nil
+}
+
+// TimedOutFiles returns the files left out of the index because they ran
+// past the deadline set WithFileTimeout, by path. An entry lasts until the
+// file's content changes or it is removed.
+func (e *Engine) TimedOutFiles() ([]FileTimeout, error) {
+	return e.store.FileTimeouts()
+}
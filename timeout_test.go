@@ -0,0 +1,69 @@
+package canopy
+
+import (
+	"context"
+	"os"
+	"path/filepath"
+	"testing"
+	"testing/fstest"
+	"time"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+// spinScripts is an extraction script that never finishes for files whose
+// path contains "slow", and does nothing for the others.
+var spinScripts = fstest.MapFS{
+	"extract/go.risor": &fstest.MapFile{Data: []byte(`
+if strings.contains(file_path, "slow") {
+  n := 0
+  for {
+    n = n + 1
+  }
+}
+`)},
+}
+
+func TestFileTimeout_SkipsFileUntilItChanges(t *testing.T) {
+	for _, mode := range []string{"parallel", "serial"} {
+		t.Run(mode, func(t *testing.T) {
+			parallel := mode == "parallel"
+			dir := t.TempDir()
+			e, err := New(filepath.Join(dir, "test.db"), "", WithScriptsFS(spinScripts),
+				WithParallel(parallel), WithFileTimeout(100*time.Millisecond))
+			require.NoError(t, err)
+			defer e.Close()
+
+			fast := filepath.Join(dir, "fast.go")
+			slow := filepath.Join(dir, "slow.go")
+			require.NoError(t, os.WriteFile(fast, []byte("package p\n"), 0o644))
+			require.NoError(t, os.WriteFile(slow, []byte("package p\n"), 0o644))
+			ctx := context.Background()
+
+			// A timed-out file is not an indexing error.
+			require.NoError(t, e.IndexFiles(ctx, []string{fast, slow}))
+			timedOut, err := e.TimedOutFiles()
+			require.NoError(t, err)
+			require.Len(t, timedOut, 1)
+			assert.Equal(t, slow, timedOut[0].Path)
+			assert.Equal(t, "extract", timedOut[0].Phase)
+			assert.Equal(t, testFileHash([]byte("package p\n")), timedOut[0].Hash)
+
+			// Unchanged, it is not attempted again.
+			require.NoError(t, e.IndexFiles(ctx, []string{slow}))
+			again, err := e.TimedOutFiles()
+			require.NoError(t, err)
+			assert.Equal(t, timedOut, again)
+
+			// Changed, it is.
+			changed := []byte("package p\n\nvar x = 1\n")
+			require.NoError(t, os.WriteFile(slow, changed, 0o644))
+			require.NoError(t, e.IndexFiles(ctx, []string{slow}))
+			timedOut, err = e.TimedOutFiles()
+			require.NoError(t, err)
+			require.Len(t, timedOut, 1)
+			assert.Equal(t, testFileHash(changed), timedOut[0].Hash)
+		})
+	}
+}
@@ -8,6 +8,7 @@ import "github.com/jward/canopy/internal/store"
 
 type Symbol = store.Symbol
 type File = store.File
+type FileTimeout = store.FileTimeout
 type Scope = store.Scope
 type CallEdge = store.CallEdge
 type Import = store.Import
@@ -17,3 +18,4 @@ type TypeParam = store.TypeParam
 type Annotation = store.Annotation
 type ExtensionBinding = store.ExtensionBinding
 type Reexport = store.Reexport
+type MergeResult = store.MergeResult
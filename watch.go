@@ -0,0 +1,359 @@
+package canopy
+
+import (
+	"context"
+	"errors"
+	"fmt"
+	"iter"
+	"maps"
+	"os"
+	"path/filepath"
+	"slices"
+	"sort"
+	"strings"
+	"time"
+)
+
+// Watch defaults. Changes are picked up within one interval and applied
+// once the tree has been quiet for the debounce period, so a single save
+// is re-indexed well under a second after it lands.
+const (
+	defaultWatchInterval = 200 * time.Millisecond
+	defaultWatchDebounce = 100 * time.Millisecond
+	defaultWatchMaxDelay = 2 * time.Second
+)
+
+// WatchBatch describes one coalesced re-index pass performed by Watch.
+type WatchBatch struct {
+	Changed  []string      // added or modified files, re-extracted
+	Removed  []string      // deleted files, dropped from the index
+	Resolved int           // files in the blast radius handed to Resolve
+	Duration time.Duration // time spent indexing and resolving the batch
+	Err      error         // extraction or resolution errors; Watch keeps going
+}
+
+// WatchOption configures Watch.
+type WatchOption func(*watchConfig)
+
+type watchConfig struct {
+	interval time.Duration
+	debounce time.Duration
+	maxDelay time.Duration
+	onBatch  func(WatchBatch)
+}
+
+// WithWatchInterval sets how often pending change notifications are
+// collected, or the tree is polled where they are unavailable.
+func WithWatchInterval(d time.Duration) WatchOption {
+	return func(c *watchConfig) {
+		if d > 0 {
+			c.interval = d
+		}
+	}
+}
+
+// WithWatchDebounce sets how long the tree must be quiet before pending
+// changes are applied, and the longest a continuous burst of changes
+// (a branch switch, a formatter run) is held back before being applied
+// anyway.
+func WithWatchDebounce(quiet, maxDelay time.Duration) WatchOption {
+	return func(c *watchConfig) {
+		if quiet >= 0 {
+			c.debounce = quiet
+		}
+		if maxDelay > 0 {
+			c.maxDelay = maxDelay
+		}
+	}
+}
+
+// WithWatchCallback registers fn to be called after every applied batch.
+func WithWatchCallback(fn func(WatchBatch)) WatchOption {
+	return func(c *watchConfig) { c.onBatch = fn }
+}
+
+// Watch keeps the index for root up to date until ctx is cancelled. The
+// caller is expected to have run IndexDirectory and Resolve once already.
+//
+// On Linux, changes are reported by inotify on every tracked directory:
+// a file written to is re-stat'ed, and the file list is rediscovered (git
+// ls-files or walk) when a directory's entries changed, i.e. when files
+// were created, renamed or deleted. Elsewhere, or once inotify runs out
+// of watches, changes are detected by polling stat tuples: every tracked
+// file's (size, mtime, inode) and every directory's mtime are compared
+// against the previous poll, relisting when a directory changed. Bursts
+// are coalesced into one batch: only the changed paths go through
+// IndexFiles, deleted paths are removed, and Resolve re-resolves the
+// accumulated blast radius.
+//
+// Engines created with WithIncrementalParse reparse re-indexed files
+// incrementally from their previous trees.
+//
+// Watch returns nil when ctx is cancelled. Per-batch indexing errors are
+// reported through WithWatchCallback and do not stop the watch.
+func (e *Engine) Watch(ctx context.Context, root string, opts ...WatchOption) error {
+	cfg := watchConfig{
+		interval: defaultWatchInterval,
+		debounce: defaultWatchDebounce,
+		maxDelay: defaultWatchMaxDelay,
+	}
+	for _, opt := range opts {
+		opt(&cfg)
+	}
+
+	root = filepath.Clean(root)
+	snap, err := e.watchSnapshot(root)
+	if err != nil {
+		return fmt.Errorf("watch %s: %w", root, err)
+	}
+
+	// Without a notifier, every tick polls the whole tree.
+	notify, err := newDirNotifier()
+	if err == nil {
+		err = notify.sync(snap)
+	}
+	if err != nil {
+		notify.close()
+		notify = nil
+	}
+	defer func() { notify.close() }()
+
+	ticker := time.NewTicker(cfg.interval)
+	defer ticker.Stop()
+
+	changed := make(map[string]bool)
+	removed := make(map[string]bool)
+	var first, last time.Time
+	for {
+		var now time.Time
+		select {
+		case <-ctx.Done():
+			return nil
+		case now = <-ticker.C:
+		}
+
+		var c, r []string
+		if notify != nil {
+			c, r, err = e.notifiedWatch(root, snap, notify)
+			if err != nil {
+				// Polling needs no kernel resources; fall back to it
+				// rather than stop watching.
+				notify.close()
+				notify = nil
+				var pc, pr []string
+				pc, pr, err = e.pollWatch(root, snap)
+				c, r = append(c, pc...), append(r, pr...)
+			}
+		} else {
+			c, r, err = e.pollWatch(root, snap)
+		}
+		if err != nil {
+			return fmt.Errorf("watch %s: %w", root, err)
+		}
+		for _, p := range c {
+			changed[p] = true
+			delete(removed, p)
+		}
+		for _, p := range r {
+			removed[p] = true
+			delete(changed, p)
+		}
+		if len(c)+len(r) > 0 {
+			if first.IsZero() {
+				first = now
+			}
+			last = now
+		}
+		if first.IsZero() || (now.Sub(last) < cfg.debounce && now.Sub(first) < cfg.maxDelay) {
+			continue
+		}
+
+		batch := e.applyWatchBatch(ctx, sortedKeys(changed), sortedKeys(removed))
+		clear(changed)
+		clear(removed)
+		first, last = time.Time{}, time.Time{}
+		if cfg.onBatch != nil {
+			cfg.onBatch(batch)
+		}
+	}
+}
+
+// applyWatchBatch removes deleted files, re-extracts changed ones and
+// re-resolves their blast radius.
+func (e *Engine) applyWatchBatch(ctx context.Context, changed, removed []string) WatchBatch {
+	start := time.Now()
+	batch := WatchBatch{Changed: changed, Removed: removed}
+	if e.blastRadius == nil {
+		e.blastRadius = make(map[int64]bool)
+	}
+
+	var errs []error
+	if len(removed) > 0 {
+		var ids []int64
+		for _, p := range removed {
+			f, err := e.store.FileByPath(p)
+			if err != nil {
+				errs = append(errs, err)
+				continue
+			}
+			if f != nil {
+				ids = append(ids, f.ID)
+			}
+		}
+		if err := e.removeFiles(ids); err != nil {
+			errs = append(errs, err)
+		}
+	}
+	if len(changed) > 0 {
+		if err := e.IndexFiles(ctx, changed); err != nil {
+			errs = append(errs, err)
+		}
+	}
+	batch.Resolved = len(e.blastRadius)
+	if err := e.Resolve(ctx); err != nil {
+		errs = append(errs, fmt.Errorf("resolving: %w", err))
+	}
+
+	batch.Err = errors.Join(errs...)
+	batch.Duration = time.Since(start)
+	return batch
+}
+
+// watchState is the stat snapshot Watch compares each poll against.
+type watchState struct {
+	files map[string]fileStat
+	dirs  map[string]int64 // directory -> mtime (Unix nanoseconds)
+}
+
+// watchSnapshot lists the indexable files under root and records their
+// stat tuples, plus the mtime of every directory that could gain files.
+func (e *Engine) watchSnapshot(root string) (*watchState, error) {
+	snap := &watchState{dirs: make(map[string]int64)}
+
+	// Directory mtimes are recorded before the file list is taken, so a
+	// file created in between changes its directory's mtime and is picked
+	// up by the next poll. Every directory the walk fallback would visit is
+	// tracked, not only the parents of known files, so files created in new
+	// or empty directories are noticed too.
+	err := filepath.WalkDir(root, func(path string, d os.DirEntry, err error) error {
+		if err != nil {
+			return nil // vanished mid-walk; the next poll catches up
+		}
+		if !d.IsDir() {
+			return nil
+		}
+		if path != root && (strings.HasPrefix(d.Name(), ".") || skipDirs[d.Name()]) {
+			return filepath.SkipDir
+		}
+		snap.dirs[path] = dirModTime(path)
+		return nil
+	})
+	if err != nil {
+		return nil, fmt.Errorf("walk directory: %w", err)
+	}
+
+	paths, err := e.listFiles(root)
+	if err != nil {
+		return nil, err
+	}
+	snap.files = make(map[string]fileStat, len(paths))
+	for _, p := range paths {
+		if st, err := statFile(p); err == nil {
+			snap.files[p] = st
+		}
+	}
+	return snap, nil
+}
+
+// pollWatch compares the tree against snap, updates snap in place and
+// returns the paths that were added or modified and the paths that were
+// removed.
+func (e *Engine) pollWatch(root string, snap *watchState) (changed, removed []string, err error) {
+	for dir, mtime := range snap.dirs {
+		if dirModTime(dir) != mtime {
+			return e.relistWatch(root, snap)
+		}
+	}
+	changed, removed = restatWatch(snap, maps.Keys(snap.files))
+	return changed, removed, nil
+}
+
+// notifiedWatch is pollWatch driven by n: only the files n reports
+// written to are stat'ed, and the tree is relisted only when n reports
+// directory changes. An error from n leaves snap consistent with the
+// paths returned alongside it.
+func (e *Engine) notifiedWatch(root string, snap *watchState, n *dirNotifier) (changed, removed []string, err error) {
+	files, relist, err := n.drain()
+	if err != nil {
+		return nil, nil, err
+	}
+	if !relist {
+		changed, removed = restatWatch(snap, slices.Values(files))
+		return changed, removed, nil
+	}
+	if changed, removed, err = e.relistWatch(root, snap); err != nil {
+		return nil, nil, err
+	}
+	return changed, removed, n.sync(snap)
+}
+
+// relistWatch replaces snap with a fresh snapshot of root and returns the
+// paths added or modified and removed since snap was taken.
+func (e *Engine) relistWatch(root string, snap *watchState) (changed, removed []string, err error) {
+	next, err := e.watchSnapshot(root)
+	if err != nil {
+		return nil, nil, err
+	}
+	for p, st := range next.files {
+		if old, ok := snap.files[p]; !ok || old != st {
+			changed = append(changed, p)
+		}
+	}
+	for p := range snap.files {
+		if _, ok := next.files[p]; !ok {
+			removed = append(removed, p)
+		}
+	}
+	*snap = *next
+	return changed, removed, nil
+}
+
+// restatWatch re-stats the tracked files among paths, updating snap, and
+// returns those modified and those gone.
+func restatWatch(snap *watchState, paths iter.Seq[string]) (changed, removed []string) {
+	for p := range paths {
+		old, ok := snap.files[p]
+		if !ok {
+			continue
+		}
+		st, err := statFile(p)
+		if err != nil {
+			removed = append(removed, p)
+			delete(snap.files, p)
+			continue
+		}
+		if st != old {
+			changed = append(changed, p)
+			snap.files[p] = st
+		}
+	}
+	return changed, removed
+}
+
+// dirModTime returns dir's mtime, or -1 if it cannot be stat'ed.
+func dirModTime(dir string) int64 {
+	fi, err := os.Stat(dir)
+	if err != nil {
+		return -1
+	}
+	return fi.ModTime().UnixNano()
+}
+
+func sortedKeys(m map[string]bool) []string {
+	keys := make([]string, 0, len(m))
+	for k := range m {
+		keys = append(keys, k)
+	}
+	sort.Strings(keys)
+	return keys
+}
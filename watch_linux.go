@@ -0,0 +1,136 @@
+//go:build linux
+
+package canopy
+
+import (
+	"errors"
+	"path/filepath"
+	"syscall"
+	"unsafe"
+)
+
+// notifyMask selects the inotify events Watch acts on. Changes to a
+// directory's entries (and an overflowed queue) force a relist, as a
+// changed directory mtime does when polling; the rest only re-stat the
+// file they name.
+const (
+	notifyRelist = syscall.IN_CREATE | syscall.IN_DELETE | syscall.IN_MOVED_FROM |
+		syscall.IN_MOVED_TO | syscall.IN_DELETE_SELF | syscall.IN_MOVE_SELF
+	notifyMask = notifyRelist | syscall.IN_MODIFY | syscall.IN_ATTRIB | syscall.IN_CLOSE_WRITE
+)
+
+// dirNotifier reports what changed under the directories Watch tracks
+// through inotify, so an idle tree costs no stat calls at all.
+type dirNotifier struct {
+	fd      int
+	dirs    map[int32]string // watch descriptor -> directory
+	watched map[string]int32
+	pending bool // a relist is due regardless of events
+	buf     [64 << 10]byte
+}
+
+// newDirNotifier returns a notifier watching nothing yet.
+func newDirNotifier() (*dirNotifier, error) {
+	fd, err := syscall.InotifyInit1(syscall.IN_NONBLOCK | syscall.IN_CLOEXEC)
+	if err != nil {
+		return nil, err
+	}
+	return &dirNotifier{fd: fd, dirs: make(map[int32]string), watched: make(map[string]int32)}, nil
+}
+
+// sync watches every directory of snap, and the parent of every tracked
+// file, and stops watching the rest. A directory that changed between
+// snap being taken and its watch being added schedules a relist, since
+// its events were missed.
+func (n *dirNotifier) sync(snap *watchState) error {
+	want := make(map[string]bool, len(snap.dirs))
+	for dir := range snap.dirs {
+		want[dir] = true
+	}
+	for p := range snap.files {
+		want[filepath.Dir(p)] = true
+	}
+	for dir, wd := range n.watched {
+		if !want[dir] {
+			syscall.InotifyRmWatch(n.fd, uint32(wd)) // fails if already gone
+			delete(n.watched, dir)
+			delete(n.dirs, wd)
+		}
+	}
+	for dir := range want {
+		if _, ok := n.watched[dir]; ok {
+			continue
+		}
+		wd, err := syscall.InotifyAddWatch(n.fd, dir, notifyMask)
+		if err != nil {
+			return err
+		}
+		// A directory moved to a tracked path keeps its watch descriptor.
+		if old, ok := n.dirs[int32(wd)]; ok {
+			delete(n.watched, old)
+		}
+		n.dirs[int32(wd)], n.watched[dir] = dir, int32(wd)
+		if mtime, ok := snap.dirs[dir]; ok && dirModTime(dir) != mtime {
+			n.pending = true
+		}
+	}
+	return nil
+}
+
+// drain reads the events queued since the last call without blocking. It
+// returns the files that were written to, or relist true when the file
+// list itself may have changed.
+func (n *dirNotifier) drain() (files []string, relist bool, err error) {
+	relist, n.pending = n.pending, false
+	for {
+		k, err := syscall.Read(n.fd, n.buf[:])
+		if errors.Is(err, syscall.EAGAIN) {
+			return files, relist, nil
+		}
+		if errors.Is(err, syscall.EINTR) {
+			continue
+		}
+		if err != nil {
+			return nil, false, err
+		}
+		for off := 0; off+syscall.SizeofInotifyEvent <= k; {
+			ev := (*syscall.InotifyEvent)(unsafe.Pointer(&n.buf[off]))
+			name := n.buf[off+syscall.SizeofInotifyEvent : off+syscall.SizeofInotifyEvent+int(ev.Len)]
+			off += syscall.SizeofInotifyEvent + int(ev.Len)
+
+			switch {
+			case ev.Mask&syscall.IN_Q_OVERFLOW != 0:
+				relist = true
+			case ev.Mask&syscall.IN_IGNORED != 0:
+				// The directory is gone; its parent reported it.
+				if dir, ok := n.dirs[ev.Wd]; ok {
+					delete(n.dirs, ev.Wd)
+					delete(n.watched, dir)
+				}
+			case ev.Mask&(notifyRelist|syscall.IN_ISDIR) != 0:
+				relist = true
+			default:
+				if dir, ok := n.dirs[ev.Wd]; ok {
+					files = append(files, filepath.Join(dir, cString(name)))
+				}
+			}
+		}
+	}
+}
+
+// close releases the inotify instance. A nil notifier is a no-op.
+func (n *dirNotifier) close() {
+	if n != nil {
+		syscall.Close(n.fd)
+	}
+}
+
+// cString returns b up to its first NUL byte.
+func cString(b []byte) string {
+	for i, c := range b {
+		if c == 0 {
+			return string(b[:i])
+		}
+	}
+	return string(b)
+}
@@ -0,0 +1,54 @@
+//go:build linux
+
+package canopy
+
+import (
+	"os"
+	"path/filepath"
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func TestDirNotifier_ReportsWritesAndRelists(t *testing.T) {
+	dir := t.TempDir()
+	path := filepath.Join(dir, "a.go")
+	require.NoError(t, os.WriteFile(path, []byte("package a\n"), 0644))
+	st, err := statFile(path)
+	require.NoError(t, err)
+
+	n, err := newDirNotifier()
+	require.NoError(t, err)
+	defer n.close()
+	snap := &watchState{files: map[string]fileStat{path: st}, dirs: map[string]int64{dir: dirModTime(dir)}}
+	require.NoError(t, n.sync(snap))
+	files, relist, err := n.drain()
+	require.NoError(t, err)
+	assert.Empty(t, files)
+	assert.False(t, relist, "an idle tree reports nothing")
+
+	// Writing a tracked file names it without relisting.
+	require.NoError(t, os.WriteFile(path, []byte("package a\n\nfunc A() {}\n"), 0644))
+	files, relist, err = n.drain()
+	require.NoError(t, err)
+	assert.Contains(t, files, path)
+	assert.False(t, relist)
+
+	// Creating one changes the file list.
+	require.NoError(t, os.WriteFile(filepath.Join(dir, "b.go"), []byte("package a\n"), 0644))
+	_, relist, err = n.drain()
+	require.NoError(t, err)
+	assert.True(t, relist)
+
+	// A directory that changed before its watch was added is relisted.
+	sub := filepath.Join(dir, "sub")
+	require.NoError(t, os.Mkdir(sub, 0755))
+	_, _, err = n.drain()
+	require.NoError(t, err)
+	snap.dirs[sub] = dirModTime(sub) - 1
+	require.NoError(t, n.sync(snap))
+	_, relist, err = n.drain()
+	require.NoError(t, err)
+	assert.True(t, relist)
+}
@@ -0,0 +1,17 @@
+//go:build !linux
+
+package canopy
+
+import "errors"
+
+// dirNotifier is only implemented on Linux (inotify); elsewhere Watch
+// polls.
+type dirNotifier struct{}
+
+func newDirNotifier() (*dirNotifier, error) { return nil, errors.ErrUnsupported }
+
+func (n *dirNotifier) sync(*watchState) error { return errors.ErrUnsupported }
+
+func (n *dirNotifier) drain() ([]string, bool, error) { return nil, false, errors.ErrUnsupported }
+
+func (n *dirNotifier) close() {}
@@ -0,0 +1,83 @@
+package canopy
+
+import (
+	"context"
+	"os"
+	"path/filepath"
+	"testing"
+	"time"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+func TestWatch_ReindexesChangedAddedAndRemovedFiles(t *testing.T) {
+	root := t.TempDir()
+	mainPath := filepath.Join(root, "main.go")
+	require.NoError(t, os.WriteFile(mainPath, []byte("package main\n\nfunc A() {}\n"), 0644))
+
+	e, err := New(filepath.Join(t.TempDir(), "test.db"), "", WithScriptsFS(os.DirFS("scripts")))
+	require.NoError(t, err)
+	defer e.Close()
+	ctx := context.Background()
+	require.NoError(t, e.IndexDirectory(ctx, root))
+	require.NoError(t, e.Resolve(ctx))
+
+	batches := make(chan WatchBatch, 8)
+	watchCtx, cancel := context.WithCancel(ctx)
+	done := make(chan error, 1)
+	go func() {
+		done <- e.Watch(watchCtx, root,
+			WithWatchInterval(20*time.Millisecond),
+			WithWatchDebounce(20*time.Millisecond, time.Second),
+			WithWatchCallback(func(b WatchBatch) { batches <- b }))
+	}()
+	next := func() WatchBatch {
+		t.Helper()
+		select {
+		case b := <-batches:
+			require.NoError(t, b.Err)
+			return b
+		case <-time.After(5 * time.Second):
+			t.Fatal("no watch batch")
+			return WatchBatch{}
+		}
+	}
+	symbolNames := func() []string {
+		t.Helper()
+		rows, err := e.store.DB().Query("SELECT name FROM symbols WHERE kind = 'function' ORDER BY name")
+		require.NoError(t, err)
+		defer rows.Close()
+		var names []string
+		for rows.Next() {
+			var name string
+			require.NoError(t, rows.Scan(&name))
+			names = append(names, name)
+		}
+		return names
+	}
+
+	// Modify an existing file.
+	require.NoError(t, os.WriteFile(mainPath, []byte("package main\n\nfunc A() {}\n\nfunc B() {}\n"), 0644))
+	b := next()
+	assert.Equal(t, []string{mainPath}, b.Changed)
+	assert.Equal(t, []string{"A", "B"}, symbolNames())
+
+	// Add a file in a new directory.
+	sub := filepath.Join(root, "pkg")
+	require.NoError(t, os.MkdirAll(sub, 0755))
+	utilPath := filepath.Join(sub, "util.go")
+	require.NoError(t, os.WriteFile(utilPath, []byte("package pkg\n\nfunc C() {}\n"), 0644))
+	b = next()
+	assert.Equal(t, []string{utilPath}, b.Changed)
+	assert.Equal(t, []string{"A", "B", "C"}, symbolNames())
+
+	// Remove it again.
+	require.NoError(t, os.Remove(utilPath))
+	b = next()
+	assert.Equal(t, []string{utilPath}, b.Removed)
+	assert.Equal(t, []string{"A", "B"}, symbolNames())
+
+	cancel()
+	require.NoError(t, <-done)
+}